@@ -549,6 +549,45 @@ extern "C" {
 	#define traceTIMER_COMMAND_RECEIVED( pxTimer, xMessageID, xMessageValue )
 #endif
 
+#ifndef traceTASK_NOTIFY_TAKE_BLOCK
+	#define traceTASK_NOTIFY_TAKE_BLOCK()
+#endif
+
+#ifndef traceTASK_NOTIFY_TAKE
+	#define traceTASK_NOTIFY_TAKE()
+#endif
+
+#ifndef traceTASK_NOTIFY_WAIT_BLOCK
+	#define traceTASK_NOTIFY_WAIT_BLOCK()
+#endif
+
+#ifndef traceTASK_NOTIFY_WAIT
+	#define traceTASK_NOTIFY_WAIT()
+#endif
+
+#ifndef traceTASK_NOTIFY
+	#define traceTASK_NOTIFY()
+#endif
+
+#ifndef traceTASK_NOTIFY_FROM_ISR
+	#define traceTASK_NOTIFY_FROM_ISR()
+#endif
+
+#ifndef traceTASK_NOTIFY_GIVE_FROM_ISR
+	#define traceTASK_NOTIFY_GIVE_FROM_ISR()
+#endif
+
+#ifndef traceISR_ENTER
+	/* Called by the port on the way into an interrupt handler, with the
+	interrupt number. */
+	#define traceISR_ENTER( ulIrq )
+#endif
+
+#ifndef traceISR_EXIT
+	/* Called by the port on the way out of an interrupt handler. */
+	#define traceISR_EXIT( ulIrq )
+#endif
+
 #ifndef traceMALLOC
     #define traceMALLOC( pvAddress, uiSize )
 #endif
@@ -617,6 +656,37 @@ extern "C" {
 	#define configGENERATE_RUN_TIME_STATS 0
 #endif
 
+#ifndef configUSE_TRACE_RECORDER
+	#define configUSE_TRACE_RECORDER 0
+#endif
+
+#if ( configUSE_TRACE_RECORDER == 1 )
+
+	#if ( ( configUSE_TRACE_FACILITY != 1 ) || ( configGENERATE_RUN_TIME_STATS != 1 ) )
+		#error configUSE_TRACE_RECORDER needs configUSE_TRACE_FACILITY for task numbers and configGENERATE_RUN_TIME_STATS for timestamps.
+	#endif
+
+	#ifndef configTRACE_BUFFER_RECORDS
+		#define configTRACE_BUFFER_RECORDS 1024
+	#endif
+
+	#ifndef configTRACE_MAX_TASKS
+		#define configTRACE_MAX_TASKS 16
+	#endif
+
+	#ifndef portRUN_TIME_COUNTER_HZ
+		#error configUSE_TRACE_RECORDER needs portRUN_TIME_COUNTER_HZ, the rate of the run time counter, to be defined.
+	#endif
+
+#endif /* configUSE_TRACE_RECORDER */
+
+/* The type used to hold run time counter values.  A 32-bit counter clocked
+fast enough to be useful wraps quickly, so ports with a wider counter can set
+this to uint64_t. */
+#ifndef configRUN_TIME_COUNTER_TYPE
+	#define configRUN_TIME_COUNTER_TYPE uint32_t
+#endif
+
 #if ( configGENERATE_RUN_TIME_STATS == 1 )
 
 	#ifndef portCONFIGURE_TIMER_FOR_RUN_TIME_STATS
@@ -723,6 +793,146 @@ extern "C" {
 	#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
 #endif
 
+#ifndef configUSE_POOLS
+	#define configUSE_POOLS 0
+#endif
+
+#ifndef configUSE_TICK_TIMERS
+	#define configUSE_TICK_TIMERS 0
+#endif
+
+#ifndef configUSE_TIMER_WHEEL
+	#define configUSE_TIMER_WHEEL 0
+#endif
+
+#ifndef configUSE_QUEUE_SIZED_COPY
+	#define configUSE_QUEUE_SIZED_COPY 0
+#endif
+
+#ifndef configUSE_LOGGER
+	#define configUSE_LOGGER 0
+#endif
+
+#if ( configUSE_LOGGER == 1 )
+	#ifndef configLOG_BUFFER_RECORDS
+		#define configLOG_BUFFER_RECORDS 64
+	#endif
+#endif
+
+/* Everything compiled in: logLEVEL_DEBUG from every subsystem.  These apply
+whether or not configUSE_LOGGER is set. */
+#ifndef configLOG_LEVEL
+	#define configLOG_LEVEL 4
+#endif
+
+#ifndef configLOG_SUBSYSTEMS
+	#define configLOG_SUBSYSTEMS 0xFFFFFFFFUL
+#endif
+
+#ifndef configUSE_EVENT_LOG
+	#define configUSE_EVENT_LOG 0
+#endif
+
+#if ( configUSE_EVENT_LOG == 1 )
+
+	#if ( configGENERATE_RUN_TIME_STATS != 1 )
+		#error configUSE_EVENT_LOG needs configGENERATE_RUN_TIME_STATS for timestamps.
+	#endif
+
+	#ifndef configEVENT_LOG_RECORDS
+		#define configEVENT_LOG_RECORDS 128
+	#endif
+
+#endif /* configUSE_EVENT_LOG */
+
+#ifndef configUSE_TELEMETRY
+	#define configUSE_TELEMETRY 0
+#endif
+
+#if ( configUSE_TELEMETRY == 1 )
+
+	#if ( configGENERATE_RUN_TIME_STATS != 1 )
+		#error configUSE_TELEMETRY needs configGENERATE_RUN_TIME_STATS for timestamps.
+	#endif
+
+	#ifndef configTELEMETRY_BUFFER_BYTES
+		#define configTELEMETRY_BUFFER_BYTES 1024
+	#endif
+
+#endif /* configUSE_TELEMETRY */
+
+#ifndef configUSE_COMMAND_CHANNEL
+	#define configUSE_COMMAND_CHANNEL 0
+#endif
+
+#if ( ( configUSE_COMMAND_CHANNEL == 1 ) && ( configUSE_TELEMETRY != 1 ) )
+	#error configUSE_COMMAND_CHANNEL needs configUSE_TELEMETRY to send its responses.
+#endif
+
+#ifndef configUSE_STORE
+	#define configUSE_STORE 0
+#endif
+
+#if ( configUSE_STORE == 1 )
+
+	#ifndef configSTORE_KEYS
+		#define configSTORE_KEYS 8
+	#endif
+
+	#ifndef configSTORE_BATCH_BYTES
+		#define configSTORE_BATCH_BYTES 256
+	#endif
+
+#endif /* configUSE_STORE */
+
+#ifndef configUSE_PROFILER
+	#define configUSE_PROFILER 0
+#endif
+
+#if ( configUSE_PROFILER == 1 )
+
+	#if ( configUSE_TRACE_FACILITY != 1 )
+		#error configUSE_PROFILER needs configUSE_TRACE_FACILITY for task numbers.
+	#endif
+
+	#ifndef configPROFILER_BUCKETS
+		#define configPROFILER_BUCKETS 512
+	#endif
+
+	#ifndef configPROFILER_MAX_PROBES
+		#define configPROFILER_MAX_PROBES 8
+	#endif
+
+	#ifndef configPROFILER_MAX_TASKS
+		#define configPROFILER_MAX_TASKS 16
+	#endif
+
+#endif /* configUSE_PROFILER */
+
+#if ( configUSE_POOLS == 1 )
+	#ifndef configPOOL_REGION_SIZE
+		#error If configUSE_POOLS is set to 1 then configPOOL_REGION_SIZE must also be defined.
+	#endif
+#endif
+
+#ifndef configUSE_TLSF_HEAP
+	#define configUSE_TLSF_HEAP 0
+#endif
+
+#ifndef configSUPPORT_STATIC_ALLOCATION
+	/* Defaults to 0 for backward compatibility. */
+	#define configSUPPORT_STATIC_ALLOCATION 0
+#endif
+
+#ifndef configSUPPORT_DYNAMIC_ALLOCATION
+	/* Defaults to 1 for backward compatibility. */
+	#define configSUPPORT_DYNAMIC_ALLOCATION 1
+#endif
+
+#if( ( configSUPPORT_STATIC_ALLOCATION == 0 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 0 ) )
+	#error At least one of configSUPPORT_STATIC_ALLOCATION and configSUPPORT_DYNAMIC_ALLOCATION must be set to 1.
+#endif
+
 #ifndef configAPPLICATION_ALLOCATED_HEAP
 	#define configAPPLICATION_ALLOCATED_HEAP 0
 #endif
@@ -731,6 +941,10 @@ extern "C" {
 	#define configUSE_TASK_NOTIFICATIONS 1
 #endif
 
+#if ( ( configUSE_TICK_TIMERS == 1 ) && ( configUSE_TASK_NOTIFICATIONS != 1 ) )
+	#error configUSE_TICK_TIMERS needs configUSE_TASK_NOTIFICATIONS, which tick timers expire through.
+#endif
+
 #ifndef portTICK_TYPE_IS_ATOMIC
 	#define portTICK_TYPE_IS_ATOMIC 0
 #endif
@@ -752,6 +966,147 @@ extern "C" {
 	#define portTICK_TYPE_CLEAR_INTERRUPT_MASK_FROM_ISR( x ) ( void ) x
 #endif
 
+/*
+ * In line with software engineering best practice, FreeRTOS implements a strict
+ * data hiding policy, so the real task, queue, timer and event group structures
+ * are not accessible to the application.  The application can however supply
+ * the memory for those objects when configSUPPORT_STATIC_ALLOCATION is 1, so it
+ * needs types of the right size and alignment.  The structures below mirror the
+ * private structures member for member but with obfuscated names.  Each of the
+ * ...Static() creation functions fails to compile if its mirror no longer has
+ * the same size as the structure it stands in for.
+ */
+typedef struct xSTATIC_LIST_ITEM
+{
+	#if( configUSE_LIST_DATA_INTEGRITY_CHECK_BYTES == 1 )
+		TickType_t xDummy1;
+	#endif
+	TickType_t xDummy2;
+	void *pvDummy3[ 4 ];
+	#if( configUSE_LIST_DATA_INTEGRITY_CHECK_BYTES == 1 )
+		TickType_t xDummy4;
+	#endif
+} StaticListItem_t;
+
+typedef struct xSTATIC_MINI_LIST_ITEM
+{
+	#if( configUSE_LIST_DATA_INTEGRITY_CHECK_BYTES == 1 )
+		TickType_t xDummy1;
+	#endif
+	TickType_t xDummy2;
+	void *pvDummy3[ 2 ];
+} StaticMiniListItem_t;
+
+typedef struct xSTATIC_LIST
+{
+	#if( configUSE_LIST_DATA_INTEGRITY_CHECK_BYTES == 1 )
+		TickType_t xDummy1;
+	#endif
+	UBaseType_t uxDummy2;
+	void *pvDummy3;
+	StaticMiniListItem_t xDummy4;
+	#if( configUSE_LIST_DATA_INTEGRITY_CHECK_BYTES == 1 )
+		TickType_t xDummy5;
+	#endif
+} StaticList_t;
+
+/* Stands in for TCB_t in tasks.c. */
+typedef struct xSTATIC_TCB
+{
+	void *pxDummy1;
+	#if ( portUSING_MPU_WRAPPERS == 1 )
+		xMPU_SETTINGS xDummy2;
+		BaseType_t xDummy3;
+	#endif
+	StaticListItem_t xDummy4[ 2 ];
+	UBaseType_t uxDummy5;
+	void *pxDummy6;
+	uint8_t ucDummy7[ configMAX_TASK_NAME_LEN ];
+	#if ( portSTACK_GROWTH > 0 )
+		void *pxDummy8;
+	#endif
+	#if ( portCRITICAL_NESTING_IN_TCB == 1 )
+		UBaseType_t uxDummy9;
+	#endif
+	#if ( configUSE_TRACE_FACILITY == 1 )
+		UBaseType_t uxDummy10[ 2 ];
+	#endif
+	#if ( configUSE_MUTEXES == 1 )
+		UBaseType_t uxDummy12[ 2 ];
+	#endif
+	#if ( configUSE_APPLICATION_TASK_TAG == 1 )
+		void *pxDummy14;
+	#endif
+	#if ( configGENERATE_RUN_TIME_STATS == 1 )
+		configRUN_TIME_COUNTER_TYPE ulDummy16;
+	#endif
+	#if ( configUSE_NEWLIB_REENTRANT == 1 )
+		struct _reent xDummy17;
+	#endif
+	#if ( configUSE_TASK_NOTIFICATIONS == 1 )
+		uint32_t ulDummy18;
+		int iDummy19;
+	#endif
+	#if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+		uint8_t ucDummy20;
+	#endif
+} StaticTask_t;
+
+/* Stands in for Queue_t in queue.c.  Also used for semaphores and mutexes. */
+typedef struct xSTATIC_QUEUE
+{
+	void *pvDummy1[ 3 ];
+	union
+	{
+		void *pvDummy2;
+		UBaseType_t uxDummy2;
+	} u;
+	StaticList_t xDummy3[ 2 ];
+	UBaseType_t uxDummy4[ 3 ];
+	BaseType_t xDummy5[ 2 ];
+	#if ( configUSE_TRACE_FACILITY == 1 )
+		UBaseType_t uxDummy6;
+		uint8_t ucDummy7;
+	#endif
+	#if ( configUSE_QUEUE_SETS == 1 )
+		void *pvDummy8;
+	#endif
+	#if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+		uint8_t ucDummy9;
+	#endif
+} StaticQueue_t;
+typedef StaticQueue_t StaticSemaphore_t;
+
+/* Stands in for Timer_t in timers.c. */
+typedef struct xSTATIC_TIMER
+{
+	void *pvDummy1;
+	StaticListItem_t xDummy2;
+	TickType_t xDummy3;
+	UBaseType_t uxDummy4;
+	void *pvDummy5;
+	void ( *pvDummy6 )( void * );
+	#if( configUSE_TRACE_FACILITY == 1 )
+		UBaseType_t uxDummy7;
+	#endif
+	#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+		uint8_t ucDummy8;
+	#endif
+} StaticTimer_t;
+
+/* Stands in for EventGroup_t in event_groups.c. */
+typedef struct xSTATIC_EVENT_GROUP
+{
+	TickType_t xDummy1;
+	StaticList_t xDummy2;
+	#if( configUSE_TRACE_FACILITY == 1 )
+		UBaseType_t uxDummy3;
+	#endif
+	#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+		uint8_t ucDummy4;
+	#endif
+} StaticEventGroup_t;
+
 /* Definitions to allow backward compatibility with FreeRTOS versions prior to
 V8 if desired. */
 #ifndef configENABLE_BACKWARD_COMPATIBILITY
@@ -88,21 +88,138 @@
  *----------------------------------------------------------*/
 
 #define configUSE_PREEMPTION			1   
-#define configUSE_IDLE_HOOK				0
-#define configUSE_TICK_HOOK				0
-#define	configUSE_TIMERS				1
+#ifndef configUSE_IDLE_HOOK
+	#define configUSE_IDLE_HOOK			0
+#endif
+/* Relay.c reads the slide switches, which have no interrupt, in the tick
+hook. */
+#ifndef configUSE_TICK_HOOK
+	#define configUSE_TICK_HOOK			1
+#endif
+/* The relay's only software timer became a tick timer, so the timer service
+task is left out.  Tick timers (tick_timer.h) wake a task directly from the
+tick. */
+#ifndef configUSE_TIMERS
+	#define	configUSE_TIMERS			0
+#endif
+#ifndef configUSE_TICK_TIMERS
+	#define configUSE_TICK_TIMERS		1
+#endif
+/* Set to keep active software timers in a hierarchical timer wheel (timers.c)
+rather than a sorted list, so starting, stopping and expiring a timer does not
+depend on how many others are running.  It pays off from about 100 running
+timers: in timer_bench on the host the list was as fast or faster at 10, and
+expired a lone timer in 951ns against the wheel's 2355ns.  The wheel's list
+heads also take 7.5KB. */
+#ifndef configUSE_TIMER_WHEEL
+	#define configUSE_TIMER_WHEEL		0
+#endif
 #define configTIMER_TASK_PRIORITY		10
 #define configTIMER_QUEUE_LENGTH		10
-#define	configTIMER_TASK_STACK_DEPTH	2048
+#define	configTIMER_TASK_STACK_DEPTH	1024
 #define configTICK_RATE_HZ				( ( portTickType ) 1000 )
 #define configCPU_CLOCK_HZ				( ( unsigned long ) ALT_SYS_CLK ) 
-#define configMAX_PRIORITIES			( ( unsigned portBASE_TYPE ) 12 )
-#define configMINIMAL_STACK_SIZE		( 4096 )
-#define configISR_STACK_SIZE			configMINIMAL_STACK_SIZE
+#define configMAX_PRIORITIES			( 12 )
+/* Find the highest ready priority from a bitmap (portmacro.h) rather than by
+searching down the ready lists. */
+#ifndef configUSE_PORT_OPTIMISED_TASK_SELECTION
+	#define configUSE_PORT_OPTIMISED_TASK_SELECTION	1
+#endif
+/* Stack sizes are in words.  Interrupt handlers run on a stack of their own
+(port.c), so task stacks no longer have to leave room for them. */
+#define configMINIMAL_STACK_SIZE		( 512 )
+#define configISR_STACK_SIZE			( 1024 )
+/* Every kernel object is created with the ...Static() API from memory fixed at
+link time, so no FreeRTOS heap is built.  Set configSUPPORT_DYNAMIC_ALLOCATION
+to 1 to bring back the heap (sized by configTOTAL_HEAP_SIZE) and the
+dynamic creation functions. */
+#define configSUPPORT_STATIC_ALLOCATION	1
+#ifndef configSUPPORT_DYNAMIC_ALLOCATION
+	#define configSUPPORT_DYNAMIC_ALLOCATION	0
+#endif
 #define configTOTAL_HEAP_SIZE			( ( size_t ) 512000 )
+/* 1 selects the constant time TLSF allocator in heap_tlsf.c, 0 the first fit
+allocator in heap.c. */
+#ifndef configUSE_TLSF_HEAP
+	#define configUSE_TLSF_HEAP			1
+#endif
+/* Fixed size block pools (pool.h) are carved from a static region of this
+many bytes. */
+#define configUSE_POOLS					1
+#define configPOOL_REGION_SIZE			( ( size_t ) 4096 )
+/* Queue items of 4, 8, 12 and 16 bytes are copied a word at a time instead of
+through memcpy() (queue.c). */
+#ifndef configUSE_QUEUE_SIZED_COPY
+	#define configUSE_QUEUE_SIZED_COPY	1
+#endif
+/* Control path messages are recorded in a ring and printed later by a low
+priority task (logger.c) instead of by printf() where they happen. */
+#ifndef configUSE_LOGGER
+	#define configUSE_LOGGER			1
+#endif
+#define configLOG_BUFFER_RECORDS		64
+/* Messages below this level (logger.h), or from subsystems whose bit is clear
+in configLOG_SUBSYSTEMS, are left out of the build. */
+#ifndef configLOG_LEVEL
+	#define configLOG_LEVEL				logLEVEL_INFO
+#endif
+#ifndef configLOG_SUBSYSTEMS
+	#define configLOG_SUBSYSTEMS		0xFFFFFFFFUL
+#endif
+/* The load manager's decisions are also recorded as binary events (event_log.c)
+for host/tools/event_decode.  Timestamps come from the run time counter. */
+#ifndef configUSE_EVENT_LOG
+	#define configUSE_EVENT_LOG			configGENERATE_RUN_TIME_STATS
+#endif
+#define configEVENT_LOG_RECORDS			128
+/* Frequency samples and load manager state changes are streamed as framed
+binary telemetry on the serial UART (telemetry.c) for host/tools/telemetry_recv. */
+#ifndef configUSE_TELEMETRY
+	#define configUSE_TELEMETRY			configGENERATE_RUN_TIME_STATS
+#endif
+#define configTELEMETRY_BUFFER_BYTES	1024
+/* Requests from host/tools/command_client are read from the serial UART and
+answered in the telemetry stream (command.c). */
+#ifndef configUSE_COMMAND_CHANNEL
+	#define configUSE_COMMAND_CHANNEL	configUSE_TELEMETRY
+#endif
+/* Thresholds, reaction time statistics and the shed and reconnect history are
+kept in the CFI flash across resets (store.c).  Changes are batched in RAM and
+written by a low priority task. */
+#ifndef configUSE_STORE
+	#define configUSE_STORE				1
+#endif
+#define configSTORE_KEYS				8
+#define configSTORE_BATCH_BYTES			256
+/* Each tick samples the PC and the task and interrupt it belongs to into a
+table of fixed buckets (profiler.c) for host/tools/profile_fold.  Off unless
+profiling, as it costs a timer read in every interrupt. */
+#ifndef configUSE_PROFILER
+	#define configUSE_PROFILER			0
+#endif
+#define configPROFILER_BUCKETS			512
+#define configPROFILER_MAX_PROBES		8
+/* Every task, the idle task included, or the dump leaves out the names. */
+#define configPROFILER_MAX_TASKS		16
 #define configMAX_TASK_NAME_LEN			( 8 )
-#define configUSE_TRACE_FACILITY		0
+/* Per task run time statistics, clocked by TIMER1US (port_runtime.c).  The
+trace facility is needed for uxTaskGetSystemState(). */
+#ifndef configGENERATE_RUN_TIME_STATS
+	#define configGENERATE_RUN_TIME_STATS	1
+#endif
+#define configRUN_TIME_COUNTER_TYPE		uint64_t
+#define configUSE_TRACE_FACILITY		configGENERATE_RUN_TIME_STATS
+/* Binary kernel event recorder (trace.h), timestamped by the run time stats
+counter.  Each record is 12 bytes. */
+#ifndef configUSE_TRACE_RECORDER
+	#define configUSE_TRACE_RECORDER	configGENERATE_RUN_TIME_STATS
+#endif
+#define configTRACE_BUFFER_RECORDS		4096
 #define configUSE_16_BIT_TICKS			0
+/* Stop the tick while the idle task has nothing to do (port_tickless.c). */
+#ifndef configUSE_TICKLESS_IDLE
+	#define configUSE_TICKLESS_IDLE		1
+#endif
 #define configIDLE_SHOULD_YIELD			0
 #define configUSE_MUTEXES				1
 #define configUSE_RECURSIVE_MUTEXES		1
@@ -117,11 +234,13 @@
 /* Set the following definitions to 1 to include the API function, or zero
 to exclude the API function. */
 
-#define INCLUDE_vTaskPrioritySet			0
+#ifndef INCLUDE_vTaskPrioritySet
+	#define INCLUDE_vTaskPrioritySet		0
+#endif
 #define INCLUDE_uxTaskPriorityGet			0
 #define INCLUDE_vTaskDelete					1
 #define INCLUDE_vTaskCleanUpResources		1
-#define INCLUDE_vTaskSuspend				0
+#define INCLUDE_vTaskSuspend				1
 #define INCLUDE_vTaskDelayUntil				0
 #define INCLUDE_vTaskDelay					1
 #define INCLUDE_uxTaskGetStackHighWaterMark	1
@@ -135,4 +254,9 @@ be called.  Only API functions that end in ...FromISR() can be used within
 interrupts. */
 #define configMAX_SYSCALL_INTERRUPT_PRIORITY	0x03
 
+/* The recorder defines the kernel's trace macros. */
+#if( configUSE_TRACE_RECORDER == 1 )
+	#include "trace.h"
+#endif
+
 #endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,151 @@
+/*
+ * Relay command channel.  See command.h.
+ *
+ * The parser undoes the COBS encoding as the bytes arrive, so it only ever
+ * holds the decoded request and never looks back at a byte.  A code byte
+ * gives the length of the block that follows and whether a zero ends it; the
+ * zero is only added once the next block starts, because the last block of a
+ * frame has none.  The CRC is checked when the delimiter arrives.
+ */
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "telemetry.h"
+#include "command.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include <string.h>
+
+#if( configUSE_COMMAND_CHANNEL == 1 )
+
+/*
+ * Appends a decoded byte to the request, or starts discarding it if it is
+ * too long.
+ */
+static void prvAppend( CommandParser_t *pxParser, uint8_t ucByte );
+
+/*
+ * Checks the request ended by a delimiter and readies the parser for the
+ * next.
+ */
+static BaseType_t prvEndFrame( CommandParser_t *pxParser, Command_t *pxCommand );
+
+/*-----------------------------------------------------------*/
+
+void vCommandParserInit( CommandParser_t *pxParser )
+{
+	memset( pxParser, 0x00, sizeof( CommandParser_t ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvAppend( CommandParser_t *pxParser, uint8_t ucByte )
+{
+	if( pxParser->xLength < sizeof( pxParser->ucFrame ) )
+	{
+		pxParser->ucFrame[ pxParser->xLength++ ] = ucByte;
+	}
+	else
+	{
+		pxParser->ucDiscarding = pdTRUE;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvEndFrame( CommandParser_t *pxParser, Command_t *pxCommand )
+{
+BaseType_t xReturn = pdFALSE;
+size_t xLength = pxParser->xLength;
+uint16_t usCrc;
+
+	/* Back to back delimiters are not a frame. */
+	if( pxParser->ucStarted != pdFALSE )
+	{
+		if( ( pxParser->ucDiscarding == pdFALSE ) && ( pxParser->ucBlockLeft == 0U ) && ( xLength >= commandREQUEST_OVERHEAD ) )
+		{
+			usCrc = usTelemetryCrc( telemetryCRC_INITIAL, pxParser->ucFrame, xLength - 2 );
+			if( ( pxParser->ucFrame[ xLength - 2 ] == ( uint8_t ) usCrc ) && ( pxParser->ucFrame[ xLength - 1 ] == ( uint8_t ) ( usCrc >> 8 ) ) )
+			{
+				pxCommand->usId = ( uint16_t ) ( pxParser->ucFrame[ 0 ] | ( pxParser->ucFrame[ 1 ] << 8 ) );
+				pxCommand->ucCommand = pxParser->ucFrame[ 2 ];
+				pxCommand->pucArguments = &( pxParser->ucFrame[ 3 ] );
+				pxCommand->xLength = xLength - commandREQUEST_OVERHEAD;
+				pxParser->ulRequests++;
+				xReturn = pdTRUE;
+			}
+		}
+
+		if( xReturn == pdFALSE )
+		{
+			pxParser->ulRejected++;
+		}
+	}
+
+	pxParser->xLength = 0;
+	pxParser->ucBlockLeft = 0U;
+	pxParser->ucZeroPending = pdFALSE;
+	pxParser->ucStarted = pdFALSE;
+	pxParser->ucDiscarding = pdFALSE;
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xCommandParserFeed( CommandParser_t *pxParser, uint8_t ucByte, Command_t *pxCommand )
+{
+	if( ucByte == 0U )
+	{
+		return prvEndFrame( pxParser, pxCommand );
+	}
+
+	pxParser->ucStarted = pdTRUE;
+
+	if( pxParser->ucDiscarding != pdFALSE )
+	{
+		/* Wait for the delimiter. */
+	}
+	else if( pxParser->ucBlockLeft == 0U )
+	{
+		/* A code byte.  The previous block is now known not to be the last. */
+		if( pxParser->ucZeroPending != pdFALSE )
+		{
+			prvAppend( pxParser, 0U );
+		}
+		pxParser->ucBlockLeft = ( uint8_t ) ( ucByte - 1U );
+		pxParser->ucZeroPending = ( ucByte != 0xFFU ) ? pdTRUE : pdFALSE;
+	}
+	else
+	{
+		prvAppend( pxParser, ucByte );
+		pxParser->ucBlockLeft--;
+	}
+
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xCommandRespond( const Command_t *pxCommand, uint8_t ucStatus, const uint8_t *pucResult, size_t xLength )
+{
+uint8_t ucPayload[ telemetryMAX_PAYLOAD ];
+
+	configASSERT( xLength <= commandMAX_RESULT );
+
+	ucPayload[ 0 ] = ( uint8_t ) pxCommand->usId;
+	ucPayload[ 1 ] = ( uint8_t ) ( pxCommand->usId >> 8 );
+	ucPayload[ 2 ] = pxCommand->ucCommand;
+	ucPayload[ 3 ] = ucStatus;
+	if( xLength > 0 )
+	{
+		memcpy( &( ucPayload[ commandRESPONSE_HEADER ] ), pucResult, xLength );
+	}
+
+	return xTelemetrySendFrame( telemetryFRAME_RESPONSE, ucPayload, commandRESPONSE_HEADER + xLength );
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configUSE_COMMAND_CHANNEL */
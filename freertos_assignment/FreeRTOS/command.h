@@ -0,0 +1,185 @@
+/*
+ * Relay command channel.
+ *
+ * When configUSE_COMMAND_CHANNEL is 1 a host can send requests on the serial
+ * UART to read and change the relay's settings while it runs.  Requests are
+ * framed as telemetry frames are (telemetry.h): COBS encoded, ended by a zero
+ * byte and checked with the same CRC-16/CCITT-FALSE.  Before encoding a
+ * request is:
+ *
+ *     request id  2 bytes, chosen by the host and returned in the response
+ *     command     1 byte, commandCOMMAND_*
+ *     arguments   0 to commandMAX_ARGUMENTS bytes, by command, below
+ *     CRC         2 bytes, of the id, command and arguments
+ *
+ * xCommandParserFeed() takes the bytes one at a time, as they are read from
+ * the UART, and returns each request once its delimiter arrives and its CRC
+ * matches.  The parser is a fixed size structure owned by the caller, so
+ * nothing is allocated and a request may arrive in any number of reads.
+ * Bytes that do not make a valid request are counted and skipped up to the
+ * next delimiter.
+ *
+ * Each request is answered with a telemetryFRAME_RESPONSE frame in the
+ * telemetry stream, so the responses share its ring and drain task and
+ * sending one never blocks.  Its payload is:
+ *
+ *     request id  2 bytes, from the request
+ *     command     1 byte, from the request
+ *     status      1 byte, commandSTATUS_*
+ *     result      0 to commandMAX_RESULT bytes, by command, when the status
+ *                 is commandSTATUS_OK
+ *
+ * Multi-byte fields are little endian.  The application decides what each
+ * command does.  host/tools/command_client sends them.
+ */
+
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "telemetry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Commands.  Values are part of the protocol used by command_client, so only
+ever add to the end. */
+#define commandCOMMAND_PING				1	/* Arguments: any.  Result: the arguments. */
+#define commandCOMMAND_GET_THRESHOLDS	2	/* Arguments: none.  Result: frequency in 0.1 Hz (2), RoC in 0.1 Hz/s (2). */
+#define commandCOMMAND_SET_THRESHOLDS	3	/* Arguments: as the GET_THRESHOLDS result, both set together.  Result: the thresholds now in use. */
+#define commandCOMMAND_GET_STATS		4	/* Arguments: none.  Result: commandSTATS_*. */
+#define commandCOMMAND_GET_HISTORY		5	/* Arguments: samples to skip, newest first (1).  Result: commandHISTORY_*. */
+#define commandCOMMAND_SET_MAINTENANCE	6	/* Arguments: commandMAINTENANCE_* (1).  Result: maintenance mode requested (1), load manager state (1). */
+#define commandCOMMAND_SNAPSHOT			7	/* Arguments: none.  Result: none.  Dumps the kernel trace. */
+#define commandCOMMAND_PROFILE			8	/* Arguments: none.  Result: none.  Dumps the PC sampling profile. */
+
+/* Statuses. */
+#define commandSTATUS_OK				0
+#define commandSTATUS_UNKNOWN			1	/* No such command. */
+#define commandSTATUS_BAD_LENGTH		2	/* Wrong number of argument bytes. */
+#define commandSTATUS_BAD_VALUE			3	/* An argument is out of range. */
+#define commandSTATUS_UNSUPPORTED		4	/* Not built into this image. */
+#define commandSTATUS_BUSY				5	/* Try again later. */
+
+/* commandCOMMAND_SET_MAINTENANCE arguments. */
+#define commandMAINTENANCE_OFF			0
+#define commandMAINTENANCE_ON			1
+#define commandMAINTENANCE_TOGGLE		2
+
+/* commandCOMMAND_GET_STATS result, byte offsets. */
+#define commandSTATS_STATE				0	/* Load manager state (1). */
+#define commandSTATS_LOADS				1	/* Loads connected, a bit each (1). */
+#define commandSTATS_MAINTENANCE		2	/* Maintenance mode requested (1). */
+#define commandSTATS_REACTIONS_HELD		3	/* Entries of REACTIONS that are valid (1). */
+#define commandSTATS_REACTION_COUNT		4	/* Loads shed on a trip since boot (4). */
+#define commandSTATS_REACTION_MIN		8	/* Reaction times in ms (4 each). */
+#define commandSTATS_REACTION_MAX		12
+#define commandSTATS_REACTION_AVERAGE	16
+#define commandSTATS_REACTIONS			20	/* The reaction times held in ms, newest first (2 each). */
+#define commandSTATS_TELEMETRY_DROPPED	30	/* Telemetry frames dropped since boot (4). */
+#define commandSTATS_REJECTED			34	/* Requests rejected by the parser since boot (4). */
+#define commandSTATS_UPTIME				38	/* Ticks since the scheduler started (4). */
+#define commandSTATS_SIZE				42
+
+/* commandCOMMAND_GET_HISTORY result: samples held (1), samples skipped (1),
+samples returned (1), then each sample's frequency in 0.01 Hz (2) and RoC in
+0.01 Hz/s (2, signed), newest first. */
+#define commandHISTORY_HEADER			3
+#define commandHISTORY_SAMPLE_SIZE		4
+#define commandHISTORY_MAX_SAMPLES		( ( commandMAX_RESULT - commandHISTORY_HEADER ) / commandHISTORY_SAMPLE_SIZE )
+
+/* Id, command and status before the result in a response. */
+#define commandRESPONSE_HEADER			4
+#define commandMAX_RESULT				( telemetryMAX_PAYLOAD - commandRESPONSE_HEADER )
+
+/* A ping's arguments are returned as its result, so a request carries no more
+than a response. */
+#define commandMAX_ARGUMENTS			commandMAX_RESULT
+
+/* Id and command before the arguments, and the CRC after them. */
+#define commandREQUEST_OVERHEAD			5
+#define commandMAX_REQUEST				( commandREQUEST_OVERHEAD + commandMAX_ARGUMENTS )
+
+/* Largest request on the wire, delimiter included. */
+#define commandMAX_ENCODED				( commandMAX_REQUEST + 2 )
+
+/* Only the definitions above are needed to build requests, so the host client
+includes this header without FreeRTOS.h. */
+#ifdef INC_FREERTOS_H
+
+/**
+ * A request returned by xCommandParserFeed().  pucArguments points into the
+ * parser, so it is only valid until the next byte is fed.
+ */
+typedef struct xCOMMAND
+{
+	uint16_t usId;					/*<< Request id, to return in the response. */
+	uint8_t ucCommand;				/*<< commandCOMMAND_*. */
+	const uint8_t *pucArguments;	/*<< xLength bytes of arguments. */
+	size_t xLength;
+} Command_t;
+
+/**
+ * Incremental request parser.  Declared by the application and only accessed
+ * through the functions below.
+ */
+typedef struct xCOMMAND_PARSER
+{
+	uint8_t ucFrame[ commandMAX_REQUEST ];	/*<< The request decoded so far. */
+	size_t xLength;							/*<< Bytes in ucFrame. */
+	uint8_t ucBlockLeft;					/*<< Data bytes left in the current COBS block, 0 when the next byte is a code. */
+	uint8_t ucZeroPending;					/*<< The current block ends with a zero, unless it ends the frame. */
+	uint8_t ucStarted;						/*<< A byte has arrived since the last delimiter. */
+	uint8_t ucDiscarding;					/*<< The frame is too long, skip to the next delimiter. */
+	uint32_t ulRequests;					/*<< Requests returned since initialised. */
+	uint32_t ulRejected;					/*<< Frames rejected for their encoding, length or CRC. */
+} CommandParser_t;
+
+/**
+ * command. h
+ * <pre>
+ void vCommandParserInit( CommandParser_t *pxParser );
+ * </pre>
+ *
+ * Readies a parser for the first byte of a request and clears its counts.
+ */
+void vCommandParserInit( CommandParser_t *pxParser ) PRIVILEGED_FUNCTION;
+
+/**
+ * command. h
+ * <pre>
+ BaseType_t xCommandParserFeed( CommandParser_t *pxParser, uint8_t ucByte, Command_t *pxCommand );
+ * </pre>
+ *
+ * Adds a byte read from the link.  O(1) apart from the CRC check on a
+ * delimiter.  Never blocks.
+ *
+ * @return pdTRUE when ucByte completes a valid request, which is written to
+ * pxCommand.  pdFALSE otherwise.
+ */
+BaseType_t xCommandParserFeed( CommandParser_t *pxParser, uint8_t ucByte, Command_t *pxCommand ) PRIVILEGED_FUNCTION;
+
+/**
+ * command. h
+ * <pre>
+ BaseType_t xCommandRespond( const Command_t *pxCommand, uint8_t ucStatus, const uint8_t *pucResult, size_t xLength );
+ * </pre>
+ *
+ * Sends the response to pxCommand in the telemetry stream, with xLength
+ * bytes of result, at most commandMAX_RESULT.  Never blocks.  Tasks only.
+ *
+ * @return pdTRUE if the response was queued, pdFALSE if the telemetry ring
+ * was full and it was dropped.  The host retries when no response comes.
+ */
+BaseType_t xCommandRespond( const Command_t *pxCommand, uint8_t ucStatus, const uint8_t *pucResult, size_t xLength ) PRIVILEGED_FUNCTION;
+
+#endif /* INC_FREERTOS_H */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COMMAND_H */
@@ -72,6 +72,12 @@
 #include "croutine.h"
 
 #define NULL ((void *)0)
+
+/* Remove the whole file if co-routines are not being used.  Co-routine control
+blocks are always allocated from the heap, so this also keeps the file from
+pulling in pvPortMalloc() when the heap is not built. */
+#if( configUSE_CO_ROUTINES != 0 )
+
 /*
  * Some kernel aware debuggers require data to be viewed to be global, rather
  * than file scope.
@@ -389,3 +395,4 @@ BaseType_t xReturn;
 	return xReturn;
 }
 
+#endif /* configUSE_CO_ROUTINES != 0 */
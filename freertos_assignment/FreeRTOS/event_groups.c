@@ -119,8 +119,19 @@ typedef struct xEventGroupDefinition
 		UBaseType_t uxEventGroupNumber;
 	#endif
 
+	#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+		uint8_t ucStaticallyAllocated; /*< Set to pdTRUE if the event group was supplied by the application, so it is not freed when the event group is deleted. */
+	#endif
+
 } EventGroup_t;
 
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+	/* StaticEventGroup_t (FreeRTOS.h) must be kept the same size as the event
+	group it stands in for.  This fails to compile if the two have drifted
+	apart. */
+	typedef char eventSTATIC_EVENT_GROUP_SIZE_CHECK[ ( sizeof( StaticEventGroup_t ) == sizeof( EventGroup_t ) ) ? 1 : -1 ];
+#endif
+
 /*-----------------------------------------------------------*/
 
 /*
@@ -135,24 +146,61 @@ static BaseType_t prvTestWaitCondition( const EventBits_t uxCurrentEventBits, co
 
 /*-----------------------------------------------------------*/
 
-EventGroupHandle_t xEventGroupCreate( void )
-{
-EventGroup_t *pxEventBits;
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
 
-	pxEventBits = pvPortMalloc( sizeof( EventGroup_t ) );
-	if( pxEventBits != NULL )
+	EventGroupHandle_t xEventGroupCreate( void )
 	{
-		pxEventBits->uxEventBits = 0;
-		vListInitialise( &( pxEventBits->xTasksWaitingForBits ) );
-		traceEVENT_GROUP_CREATE( pxEventBits );
+	EventGroup_t *pxEventBits;
+
+		pxEventBits = pvPortMalloc( sizeof( EventGroup_t ) );
+		if( pxEventBits != NULL )
+		{
+			pxEventBits->uxEventBits = 0;
+			vListInitialise( &( pxEventBits->xTasksWaitingForBits ) );
+
+			#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+			{
+				pxEventBits->ucStaticallyAllocated = pdFALSE;
+			}
+			#endif /* configSUPPORT_STATIC_ALLOCATION */
+
+			traceEVENT_GROUP_CREATE( pxEventBits );
+		}
+		else
+		{
+			traceEVENT_GROUP_CREATE_FAILED();
+		}
+
+		return ( EventGroupHandle_t ) pxEventBits;
 	}
-	else
+
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+/*-----------------------------------------------------------*/
+
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+
+	EventGroupHandle_t xEventGroupCreateStatic( StaticEventGroup_t *pxEventGroupBuffer )
 	{
-		traceEVENT_GROUP_CREATE_FAILED();
+	EventGroup_t *pxEventBits = ( EventGroup_t * ) pxEventGroupBuffer;
+
+		configASSERT( pxEventBits );
+
+		if( pxEventBits != NULL )
+		{
+			pxEventBits->uxEventBits = 0;
+			vListInitialise( &( pxEventBits->xTasksWaitingForBits ) );
+			pxEventBits->ucStaticallyAllocated = pdTRUE;
+			traceEVENT_GROUP_CREATE( pxEventBits );
+		}
+		else
+		{
+			traceEVENT_GROUP_CREATE_FAILED();
+		}
+
+		return ( EventGroupHandle_t ) pxEventBits;
 	}
 
-	return ( EventGroupHandle_t ) pxEventBits;
-}
+#endif /* configSUPPORT_STATIC_ALLOCATION */
 /*-----------------------------------------------------------*/
 
 EventBits_t xEventGroupSync( EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet, const EventBits_t uxBitsToWaitFor, TickType_t xTicksToWait )
@@ -588,7 +636,17 @@ const List_t *pxTasksWaitingForBits = &( pxEventBits->xTasksWaitingForBits );
 			( void ) xTaskRemoveFromUnorderedEventList( pxTasksWaitingForBits->xListEnd.pxNext, eventUNBLOCKED_DUE_TO_BIT_SET );
 		}
 
-		vPortFree( pxEventBits );
+		#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+		{
+			#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+				/* Nothing to free if the application supplied the memory. */
+				if( pxEventBits->ucStaticallyAllocated == pdFALSE )
+			#endif /* configSUPPORT_STATIC_ALLOCATION */
+			{
+				vPortFree( pxEventBits );
+			}
+		}
+		#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
 	}
 	( void ) xTaskResumeAll();
 }
@@ -173,7 +173,30 @@ typedef TickType_t EventBits_t;
  * \defgroup xEventGroupCreate xEventGroupCreate
  * \ingroup EventGroup
  */
-EventGroupHandle_t xEventGroupCreate( void ) PRIVILEGED_FUNCTION;
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+	EventGroupHandle_t xEventGroupCreate( void ) PRIVILEGED_FUNCTION;
+#endif
+
+/**
+ * event_groups.h
+ *<pre>
+ EventGroupHandle_t xEventGroupCreateStatic( StaticEventGroup_t *pxEventGroupBuffer );
+ </pre>
+ *
+ * As xEventGroupCreate(), but the event group is held in the
+ * StaticEventGroup_t variable pointed to by pxEventGroupBuffer instead of in
+ * memory allocated from the FreeRTOS heap.  The variable must persist for the
+ * lifetime of the event group.  Only available when
+ * configSUPPORT_STATIC_ALLOCATION is set to 1 in FreeRTOSConfig.h.
+ *
+ * @return The handle of the event group, or NULL if pxEventGroupBuffer is NULL.
+ *
+ * \defgroup xEventGroupCreateStatic xEventGroupCreateStatic
+ * \ingroup EventGroup
+ */
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+	EventGroupHandle_t xEventGroupCreateStatic( StaticEventGroup_t *pxEventGroupBuffer ) PRIVILEGED_FUNCTION;
+#endif
 
 /**
  * event_groups.h
@@ -0,0 +1,239 @@
+/*
+ * Relay event log.  See event_log.h.
+ *
+ * The ring holds each record with the full run time counter value it was
+ * written at, so vEventLogWrite() does no arithmetic.  xEventLogRead(), in the
+ * drain task, converts it to microseconds.  The indexes run freely and wrap
+ * with a mask, so configEVENT_LOG_RECORDS must be a power of two.
+ */
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "event_log.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( configUSE_EVENT_LOG == 1 )
+
+#if( ( configEVENT_LOG_RECORDS & ( configEVENT_LOG_RECORDS - 1 ) ) != 0 )
+	#error configEVENT_LOG_RECORDS must be a power of two.
+#endif
+
+#if( ( portRUN_TIME_COUNTER_HZ % 1000000UL ) != 0 )
+	#error The event log needs a run time counter clocked at a whole number of MHz.
+#endif
+
+#define eventlogBUFFER_MASK		( ( uint32_t ) configEVENT_LOG_RECORDS - 1UL )
+#define eventlogCOUNTS_PER_US	( ( uint64_t ) ( portRUN_TIME_COUNTER_HZ / 1000000UL ) )
+
+typedef struct xEVENT_LOG_ENTRY
+{
+	uint64_t ullTime;
+	EventLogRecord_t xRecord;
+} EventLogEntry_t;
+
+static EventLogEntry_t xEventLogBuffer[ configEVENT_LOG_RECORDS ];
+
+/* Records written and read since boot.  The next record written goes in
+xEventLogBuffer[ ulEventLogHead & eventlogBUFFER_MASK ] and the next read comes
+from xEventLogBuffer[ ulEventLogTail & eventlogBUFFER_MASK ]. */
+static uint32_t ulEventLogHead = 0;
+static uint32_t ulEventLogTail = 0;
+
+/* Records dropped since boot, and how many of those have been reported.  While
+some are waiting to be reported, ulEventLogDropIndex is where the first of them
+would have gone. */
+static uint32_t ulEventLogDropped = 0;
+static uint32_t ulEventLogDroppedReported = 0;
+static uint32_t ulEventLogDropIndex = 0;
+
+static TaskHandle_t xEventLogDrainTask = NULL;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Stores ulValue at pucBuffer, least significant byte first.
+ */
+static void prvPutLittleEndian( uint8_t *pucBuffer, uint32_t ulValue, size_t xBytes );
+
+/*-----------------------------------------------------------*/
+
+void vEventLogWrite( const EventLogRecord_t *pxRecord )
+{
+UBaseType_t uxSavedInterruptStatus;
+EventLogEntry_t *pxEntry;
+BaseType_t xWasEmpty = pdFALSE;
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		/* The counter is read with interrupts masked, as port_runtime.c needs,
+		and in the same critical section as the store so records stay in time
+		order. */
+		if( ( ulEventLogHead - ulEventLogTail ) < ( uint32_t ) configEVENT_LOG_RECORDS )
+		{
+			xWasEmpty = ( ulEventLogHead == ulEventLogTail ) ? pdTRUE : pdFALSE;
+
+			pxEntry = &( xEventLogBuffer[ ulEventLogHead & eventlogBUFFER_MASK ] );
+			pxEntry->ullTime = portGET_RUN_TIME_COUNTER_VALUE();
+			pxEntry->xRecord = *pxRecord;
+			ulEventLogHead++;
+		}
+		else
+		{
+			if( ulEventLogDropped == ulEventLogDroppedReported )
+			{
+				ulEventLogDropIndex = ulEventLogHead;
+			}
+			ulEventLogDropped++;
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	/* As in logger.c, only a record into an empty ring needs to wake the drain
+	task. */
+	if( ( xWasEmpty != pdFALSE ) && ( xEventLogDrainTask != NULL ) )
+	{
+		xTaskNotifyGive( xEventLogDrainTask );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vEventLogSetDrainTask( TaskHandle_t xTask )
+{
+	xEventLogDrainTask = xTask;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xEventLogRead( EventLogRecord_t *pxRecord )
+{
+UBaseType_t uxSavedInterruptStatus;
+BaseType_t xReturn = pdFALSE;
+uint32_t ulDropped;
+uint64_t ullTime = 0;
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		ulDropped = ulEventLogDropped - ulEventLogDroppedReported;
+
+		/* The drops are reported in the place they happened, after the last
+		record written before them.  Later drops reported in the same record
+		are counted there too. */
+		if( ( ulDropped != 0UL ) && ( ulEventLogTail == ulEventLogDropIndex ) )
+		{
+			ulEventLogDroppedReported = ulEventLogDropped;
+			xReturn = pdTRUE;
+
+			/* Stamped with the first record kept after them, if there is one
+			yet, otherwise now. */
+			if( ulEventLogHead != ulEventLogTail )
+			{
+				ullTime = xEventLogBuffer[ ulEventLogTail & eventlogBUFFER_MASK ].ullTime;
+			}
+			else
+			{
+				ullTime = portGET_RUN_TIME_COUNTER_VALUE();
+			}
+		}
+		else if( ulEventLogHead != ulEventLogTail )
+		{
+			ullTime = xEventLogBuffer[ ulEventLogTail & eventlogBUFFER_MASK ].ullTime;
+			*pxRecord = xEventLogBuffer[ ulEventLogTail & eventlogBUFFER_MASK ].xRecord;
+			ulEventLogTail++;
+			ulDropped = 0;
+			xReturn = pdTRUE;
+		}
+		else
+		{
+			ulDropped = 0;
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	if( ulDropped != 0UL )
+	{
+		memset( pxRecord, 0x00, sizeof( EventLogRecord_t ) );
+		pxRecord->ucEvent = eventlogEVENT_DROPPED;
+		pxRecord->ucLoad = eventlogNO_LOAD;
+		pxRecord->ulValue = ulDropped;
+	}
+
+	if( xReturn != pdFALSE )
+	{
+		pxRecord->ulTimeUs = ( uint32_t ) ( ullTime / eventlogCOUNTS_PER_US );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPutLittleEndian( uint8_t *pucBuffer, uint32_t ulValue, size_t xBytes )
+{
+size_t x;
+
+	for( x = 0; x < xBytes; x++ )
+	{
+		pucBuffer[ x ] = ( uint8_t ) ( ulValue >> ( 8U * x ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vEventLogEncodeHeader( uint8_t *pucBuffer )
+{
+	pucBuffer[ 0 ] = ( uint8_t ) 'R';
+	pucBuffer[ 1 ] = ( uint8_t ) 'L';
+	pucBuffer[ 2 ] = ( uint8_t ) 'O';
+	pucBuffer[ 3 ] = ( uint8_t ) 'G';
+	prvPutLittleEndian( &( pucBuffer[ 4 ] ), eventlogVERSION, 2 );
+	prvPutLittleEndian( &( pucBuffer[ 6 ] ), eventlogRECORD_SIZE, 2 );
+}
+/*-----------------------------------------------------------*/
+
+void vEventLogEncode( const EventLogRecord_t *pxRecord, uint8_t *pucBuffer )
+{
+	prvPutLittleEndian( &( pucBuffer[ 0 ] ), pxRecord->ulTimeUs, 4 );
+	pucBuffer[ 4 ] = pxRecord->ucEvent;
+	pucBuffer[ 5 ] = pxRecord->ucState;
+	pucBuffer[ 6 ] = pxRecord->ucLoads;
+	pucBuffer[ 7 ] = pxRecord->ucLoad;
+	prvPutLittleEndian( &( pucBuffer[ 8 ] ), pxRecord->usFrequency, 2 );
+	prvPutLittleEndian( &( pucBuffer[ 10 ] ), ( uint16_t ) pxRecord->sRoc, 2 );
+	prvPutLittleEndian( &( pucBuffer[ 12 ] ), pxRecord->ulValue, 4 );
+}
+/*-----------------------------------------------------------*/
+
+void vEventLogPrintHeader( EventLogPrintFunction_t pxPrint )
+{
+	pxPrint( "EVENTS %d %d\n", eventlogVERSION, eventlogRECORD_SIZE );
+}
+/*-----------------------------------------------------------*/
+
+void vEventLogPrintRecord( const EventLogRecord_t *pxRecord, EventLogPrintFunction_t pxPrint )
+{
+static const char cHex[] = "0123456789abcdef";
+uint8_t ucBytes[ eventlogRECORD_SIZE ];
+char cLine[ 2 + ( 2 * eventlogRECORD_SIZE ) + 2 ];
+size_t x;
+
+	/* One call to pxPrint per record, with nothing for it to convert. */
+	vEventLogEncode( pxRecord, ucBytes );
+	cLine[ 0 ] = 'E';
+	cLine[ 1 ] = ' ';
+	for( x = 0; x < eventlogRECORD_SIZE; x++ )
+	{
+		cLine[ 2 + ( 2 * x ) ] = cHex[ ucBytes[ x ] >> 4 ];
+		cLine[ 3 + ( 2 * x ) ] = cHex[ ucBytes[ x ] & 0x0F ];
+	}
+	cLine[ 2 + ( 2 * eventlogRECORD_SIZE ) ] = '\n';
+	cLine[ 3 + ( 2 * eventlogRECORD_SIZE ) ] = '\0';
+
+	pxPrint( "%s", cLine );
+}
+
+#endif /* configUSE_EVENT_LOG */
@@ -0,0 +1,150 @@
+/*
+ * Relay event log.
+ *
+ * When configUSE_EVENT_LOG is 1 the application describes each thing the load
+ * manager does - a sample breaking the thresholds, a load shed or reconnected,
+ * a change of state - as a fixed size binary record, and vEventLogWrite()
+ * queues it in a RAM ring of configEVENT_LOG_RECORDS entries.  Nothing is
+ * formatted.  A low priority task takes records out with xEventLogRead() and
+ * sends them to the host, either as raw bytes (vEventLogEncode()) on a serial
+ * link or as one hex line per record (vEventLogPrintRecord()) mixed in with
+ * the JTAG UART console.  host/tools/event_decode reads both and rebuilds the
+ * timeline and the reaction time figures.
+ *
+ * Records are stamped with the run time statistics counter (port_runtime.c),
+ * so configGENERATE_RUN_TIME_STATS must be 1.  When the ring is full new
+ * records are dropped, and the next read returns an eventlogEVENT_DROPPED
+ * record carrying the count before anything else.
+ */
+
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Version of the encoded stream, in its header. */
+#define eventlogVERSION					1
+
+/* Encoded sizes in bytes.  The header is the magic "RLOG", the version and the
+record size, the last two 16-bit. */
+#define eventlogHEADER_SIZE				8
+#define eventlogRECORD_SIZE				16
+
+/* Record types.  Values are part of the stream format read by event_decode, so
+only ever add to the end. */
+#define eventlogEVENT_BOOT				0	/* The load manager has started. */
+#define eventlogEVENT_SAMPLE			1	/* A sample reached the load manager.  ulValue: its tick. */
+#define eventlogEVENT_TRIP				2	/* A sample broke a threshold while stable.  ulValue: its tick. */
+#define eventlogEVENT_STABLE			3	/* A sample inside the thresholds after one that was not.  ulValue: its tick. */
+#define eventlogEVENT_SHED				4	/* ucLoad: load shed, or eventlogNO_LOAD if none was on. */
+#define eventlogEVENT_RECONNECT			5	/* ucLoad: load reconnected, or eventlogNO_LOAD if none could be. */
+#define eventlogEVENT_MANUAL_OFF		6	/* ucLoad: load switched off.  ulValue: 1 if it was on, 0 if already shed. */
+#define eventlogEVENT_LOAD_SWITCH		7	/* ucLoad: load switched by its slide switch.  ulValue: 1 on, 0 off. */
+#define eventlogEVENT_STATE				8	/* ucState: new state.  ulValue: previous state. */
+#define eventlogEVENT_STABILITY_EXPIRY	9	/* The stability timer expired before a new sample. */
+#define eventlogEVENT_REACTION			10	/* ulValue: ms from the sample to the first load being shed. */
+#define eventlogEVENT_MAINTENANCE_TIME	11	/* ulValue: ms from a switch moving to the load following it. */
+#define eventlogEVENT_THRESHOLDS		12	/* ulValue: frequency threshold in 0.1 Hz << 16 | RoC threshold in 0.1 Hz/s. */
+#define eventlogEVENT_DROPPED			13	/* ulValue: records dropped since the last report. */
+
+#define eventlogNO_LOAD					0xFF
+
+/* Frequencies are held in hundredths of a hertz and rates of change in
+hundredths of a hertz per second. */
+#define eventlogFIXED_POINT_SCALE		100
+
+/* 16 bytes, encoded little endian in this order. */
+typedef struct xEVENT_LOG_RECORD
+{
+	uint32_t ulTimeUs;			/* Low word of the microseconds since boot. */
+	uint8_t ucEvent;
+	uint8_t ucState;			/* Load manager state. */
+	uint8_t ucLoads;			/* Bitmap of the loads connected. */
+	uint8_t ucLoad;				/* Load the event is about, or eventlogNO_LOAD. */
+	uint16_t usFrequency;		/* Latest frequency, 0.01 Hz. */
+	int16_t sRoc;				/* Latest rate of change, 0.01 Hz/s. */
+	uint32_t ulValue;
+} EventLogRecord_t;
+
+/* printf() or anything that behaves like it. */
+typedef int ( *EventLogPrintFunction_t )( const char *pcFormat, ... );
+
+/* Only the definitions above are needed to decode the stream, so the host
+decoder includes this header without FreeRTOS.h. */
+#ifdef INC_FREERTOS_H
+
+#include "task.h"
+
+/**
+ * event_log. h
+ * <pre>
+ void vEventLogEncodeHeader( uint8_t *pucBuffer );
+ void vEventLogEncode( const EventLogRecord_t *pxRecord, uint8_t *pucBuffer );
+ * </pre>
+ *
+ * Write the stream header into eventlogHEADER_SIZE bytes, or a record into
+ * eventlogRECORD_SIZE bytes.  Use these for a binary link.
+ */
+void vEventLogEncodeHeader( uint8_t *pucBuffer ) PRIVILEGED_FUNCTION;
+void vEventLogEncode( const EventLogRecord_t *pxRecord, uint8_t *pucBuffer ) PRIVILEGED_FUNCTION;
+
+/**
+ * event_log. h
+ * <pre>
+ void vEventLogPrintHeader( EventLogPrintFunction_t pxPrint );
+ void vEventLogPrintRecord( const EventLogRecord_t *pxRecord, EventLogPrintFunction_t pxPrint );
+ * </pre>
+ *
+ * The same bytes as text, for a console: an "EVENTS <version> <record size>"
+ * line, then "E " and the record's bytes in hex per record.
+ */
+void vEventLogPrintHeader( EventLogPrintFunction_t pxPrint ) PRIVILEGED_FUNCTION;
+void vEventLogPrintRecord( const EventLogRecord_t *pxRecord, EventLogPrintFunction_t pxPrint ) PRIVILEGED_FUNCTION;
+
+/**
+ * event_log. h
+ * <pre>
+ void vEventLogWrite( const EventLogRecord_t *pxRecord );
+ * </pre>
+ *
+ * Queues a copy of the record with the current time.  ulTimeUs is ignored.
+ * Masks interrupts for a few stores and never blocks.  Tasks only.
+ */
+void vEventLogWrite( const EventLogRecord_t *pxRecord ) PRIVILEGED_FUNCTION;
+
+/**
+ * event_log. h
+ * <pre>
+ void vEventLogSetDrainTask( TaskHandle_t xTask );
+ * </pre>
+ *
+ * Sets the task woken by the first record written into an empty ring.
+ */
+void vEventLogSetDrainTask( TaskHandle_t xTask ) PRIVILEGED_FUNCTION;
+
+/**
+ * event_log. h
+ * <pre>
+ BaseType_t xEventLogRead( EventLogRecord_t *pxRecord );
+ * </pre>
+ *
+ * Takes the oldest record out of the ring, with its time in microseconds.  If
+ * records have been dropped since the last read, returns an
+ * eventlogEVENT_DROPPED record first.
+ *
+ * @return pdTRUE if a record was copied to pxRecord, pdFALSE if the ring is
+ * empty.
+ */
+BaseType_t xEventLogRead( EventLogRecord_t *pxRecord ) PRIVILEGED_FUNCTION;
+
+#endif /* INC_FREERTOS_H */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVENT_LOG_H */
@@ -73,6 +73,7 @@
  * memory management pages of http://www.FreeRTOS.org for more information.
  */
 #include <stdlib.h>
+#include <string.h>
 
 /* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
 all the API functions to use the MPU wrappers.  That should only be done when
@@ -84,6 +85,11 @@ task.h is included from an application file. */
 #include "FreeRTOSConfig.h"
 
 #undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+/* This allocator is only built when there is a heap at all and the TLSF
+allocator in heap_tlsf.c is not selected. */
+#if( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configUSE_TLSF_HEAP == 0 ) )
+
 #define size_t long unsigned int
 /* Block sizes must not get too small. */
 #define heapMINIMUM_BLOCK_SIZE  ( ( size_t ) ( heapSTRUCT_SIZE * 2 ) )
@@ -271,6 +277,41 @@ void vPortInitialiseBlocks( void )
 }
 /*-----------------------------------------------------------*/
 
+void vPortGetHeapStats( HeapStats_t *pxHeapStats )
+{
+xBlockLink *pxBlock;
+size_t xLargest = 0, xBlocks = 0;
+
+        vTaskSuspendAll();
+        {
+                /* Unlike the TLSF allocator this has to walk the whole free
+                list. */
+                if( pxEnd != NULL )
+                {
+                        for( pxBlock = xStart.pxNextFreeBlock; pxBlock != pxEnd; pxBlock = pxBlock->pxNextFreeBlock )
+                        {
+                                xBlocks++;
+                                if( pxBlock->xBlockSize > xLargest )
+                                {
+                                        xLargest = pxBlock->xBlockSize;
+                                }
+                        }
+                }
+
+                memset( pxHeapStats, 0, sizeof( HeapStats_t ) );
+                pxHeapStats->xAvailableHeapSpaceInBytes = xFreeBytesRemaining;
+                pxHeapStats->xSizeOfLargestFreeBlockInBytes = xLargest;
+                pxHeapStats->xNumberOfFreeBlocks = xBlocks;
+
+                if( xFreeBytesRemaining > 0 )
+                {
+                        pxHeapStats->uxFragmentationPercent = ( UBaseType_t ) ( 100U - ( ( xLargest * 100U ) / xFreeBytesRemaining ) );
+                }
+        }
+        xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
 static void prvHeapInit( void )
 {
 xBlockLink *pxFirstFreeBlock;
@@ -355,3 +396,5 @@ unsigned char *puc;
                 pxIterator->pxNextFreeBlock = pxBlockToInsert;
         }
 }
+
+#endif /* ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && configUSE_TLSF_HEAP */
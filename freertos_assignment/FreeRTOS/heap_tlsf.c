@@ -0,0 +1,511 @@
+/*
+ * A two-level segregated fit (TLSF) implementation of pvPortMalloc() and
+ * vPortFree().
+ *
+ * Free blocks are kept in an array of lists indexed by a first level (the
+ * power of two range the block size falls in) and a second level (a linear
+ * subdivision of that range).  Two bitmaps record which lists are non-empty so
+ * a suitable list is found with a couple of count-leading-zeros operations
+ * rather than by walking the free list as heap.c does.  Both pvPortMalloc()
+ * and vPortFree() are therefore O(1), whatever the fragmentation of the heap.
+ * Adjacent free blocks are coalesced when a block is freed.
+ *
+ * The first fit allocator in heap.c can still be used by setting
+ * configUSE_TLSF_HEAP to 0 in FreeRTOSConfig.h.  Neither allocator is built
+ * when configSUPPORT_DYNAMIC_ALLOCATION is 0.
+ */
+#include <stdlib.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "FreeRTOSConfig.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configUSE_TLSF_HEAP == 1 ) )
+
+/* Number of second level lists per first level range, as a power of two. */
+#define tlsfSL_INDEX_COUNT_LOG2		( 4 )
+#define tlsfSL_INDEX_COUNT			( 1U << tlsfSL_INDEX_COUNT_LOG2 )
+
+/* Blocks smaller than tlsfSMALL_BLOCK_SIZE all live in first level list 0,
+which is split linearly into tlsfSL_INDEX_COUNT lists. */
+#if portBYTE_ALIGNMENT == 8
+	#define tlsfALIGN_SIZE_LOG2		( 3 )
+#else
+	#define tlsfALIGN_SIZE_LOG2		( 2 )
+#endif
+#define tlsfFL_INDEX_SHIFT			( tlsfSL_INDEX_COUNT_LOG2 + tlsfALIGN_SIZE_LOG2 )
+#define tlsfSMALL_BLOCK_SIZE		( ( size_t ) 1 << tlsfFL_INDEX_SHIFT )
+
+/* The largest first level index needed to cover configTOTAL_HEAP_SIZE.  30
+covers any heap up to 1GB which is far more than any Nios II system has. */
+#define tlsfFL_INDEX_MAX			( 30 )
+#define tlsfFL_INDEX_COUNT			( tlsfFL_INDEX_MAX - tlsfFL_INDEX_SHIFT + 1 )
+
+/* The low bit of xSize marks a free block.  Block sizes are always a multiple
+of portBYTE_ALIGNMENT so the bit is otherwise unused. */
+#define tlsfBLOCK_FREE_BIT			( ( size_t ) 1 )
+
+/* Allocate the memory for the heap.  The union is used to force byte
+alignment without using any non-portable code. */
+static union xTLSF_HEAP
+{
+	#if portBYTE_ALIGNMENT == 8
+		volatile portDOUBLE dDummy;
+	#else
+		volatile unsigned long ulDummy;
+	#endif
+	unsigned char ucHeap[ configTOTAL_HEAP_SIZE ];
+} xTlsfHeap;
+
+/* Header placed at the start of every block, free or allocated.  The free
+list links overlay the first bytes of the payload so are only valid while the
+block is free. */
+typedef struct TLSF_BLOCK
+{
+	struct TLSF_BLOCK *pxPrevPhysBlock;	/*<< The block immediately below this one in memory, NULL for the first block. */
+	size_t xSize;						/*<< Size of the block including this header, plus tlsfBLOCK_FREE_BIT. */
+	struct TLSF_BLOCK *pxNextFree;		/*<< Next block in the same segregated list (free blocks only). */
+	struct TLSF_BLOCK *pxPrevFree;		/*<< Previous block in the same segregated list (free blocks only). */
+} xTlsfBlock;
+
+/* Only pxPrevPhysBlock and xSize remain in front of an allocated block. */
+#define tlsfHEADER_SIZE				( ( ( offsetof( xTlsfBlock, pxNextFree ) ) + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK ) )
+
+/* A free block must be able to hold its list links. */
+#define tlsfMINIMUM_BLOCK_SIZE		( ( sizeof( xTlsfBlock ) + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK ) )
+
+#define tlsfBLOCK_SIZE( pxBlock )	( ( pxBlock )->xSize & ~tlsfBLOCK_FREE_BIT )
+#define tlsfBLOCK_IS_FREE( pxBlock )	( ( ( pxBlock )->xSize & tlsfBLOCK_FREE_BIT ) != 0 )
+#define tlsfNEXT_PHYS_BLOCK( pxBlock )	( ( xTlsfBlock * ) ( ( ( unsigned char * ) ( pxBlock ) ) + tlsfBLOCK_SIZE( pxBlock ) ) )
+
+/* Index of the most and least significant set bits.  ulValue must not be
+zero.  The builtins map onto libgcc's table driven helpers on Nios II, so both
+are constant time. */
+#define prvTlsfFls( ulValue )		( ( UBaseType_t ) ( 31 - __builtin_clz( ( uint32_t ) ( ulValue ) ) ) )
+#define prvTlsfFfs( ulValue )		( ( UBaseType_t ) __builtin_ctz( ( uint32_t ) ( ulValue ) ) )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Called automatically to setup the required heap structures the first time
+ * pvPortMalloc() is called.
+ */
+static void prvTlsfInit( void );
+
+/*
+ * Map a block size onto the first and second level indexes of the list that
+ * holds blocks of that size.
+ */
+static void prvTlsfMappingInsert( size_t xSize, UBaseType_t *puxFl, UBaseType_t *puxSl );
+
+/*
+ * As prvTlsfMappingInsert(), but rounds the size up so that any block in the
+ * selected list is guaranteed to be big enough.
+ */
+static void prvTlsfMappingSearch( size_t xSize, UBaseType_t *puxFl, UBaseType_t *puxSl );
+
+/*
+ * Find a non-empty list at or above the given indexes.  Returns NULL if the
+ * heap has no block large enough.
+ */
+static xTlsfBlock *prvTlsfFindSuitableBlock( UBaseType_t *puxFl, UBaseType_t *puxSl );
+
+static void prvTlsfInsertFreeBlock( xTlsfBlock *pxBlock );
+static void prvTlsfRemoveFreeBlock( xTlsfBlock *pxBlock );
+
+/*-----------------------------------------------------------*/
+
+/* Bitmap of non-empty first level ranges, and for each range a bitmap of
+non-empty second level lists. */
+static uint32_t ulFlBitmap = 0;
+static uint32_t ulSlBitmap[ tlsfFL_INDEX_COUNT ];
+
+/* Heads of the segregated free lists. */
+static xTlsfBlock *pxFreeLists[ tlsfFL_INDEX_COUNT ][ tlsfSL_INDEX_COUNT ];
+
+/* Ensure the heap end marker will end up on the correct byte alignment. */
+static const size_t xTlsfTotalHeapSize = ( ( size_t ) configTOTAL_HEAP_SIZE ) & ( ( size_t ) ~portBYTE_ALIGNMENT_MASK );
+
+/* Zero sized, permanently allocated block at the very end of the heap that
+stops coalescing from running off the end. */
+static xTlsfBlock *pxTlsfEnd = NULL;
+
+/* Running statistics reported by vPortGetHeapStats(). */
+static size_t xTlsfFreeBytesRemaining = 0;
+static size_t xTlsfMinimumEverFreeBytesRemaining = 0;
+static size_t xTlsfNumberOfFreeBlocks = 0;
+static size_t xTlsfNumberOfSuccessfulAllocations = 0;
+static size_t xTlsfNumberOfSuccessfulFrees = 0;
+static size_t xTlsfNumberOfFailedAllocations = 0;
+
+/*-----------------------------------------------------------*/
+
+void *pvPortMalloc( size_t xWantedSize )
+{
+xTlsfBlock *pxBlock, *pxRemainder;
+UBaseType_t uxFl, uxSl;
+void *pvReturn = NULL;
+
+	vTaskSuspendAll();
+	{
+		/* If this is the first call to malloc then the heap will require
+		initialisation to setup the list of free blocks. */
+		if( pxTlsfEnd == NULL )
+		{
+			prvTlsfInit();
+		}
+
+		if( ( xWantedSize > 0 ) && ( xWantedSize < xTlsfTotalHeapSize ) )
+		{
+			/* The wanted size is increased so it can contain the block header,
+			rounded to the required alignment, and never less than a free block
+			needs to hold its list links. */
+			xWantedSize = ( xWantedSize + tlsfHEADER_SIZE + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+			if( xWantedSize < tlsfMINIMUM_BLOCK_SIZE )
+			{
+				xWantedSize = tlsfMINIMUM_BLOCK_SIZE;
+			}
+
+			prvTlsfMappingSearch( xWantedSize, &uxFl, &uxSl );
+
+			if( uxFl < tlsfFL_INDEX_COUNT )
+			{
+				pxBlock = prvTlsfFindSuitableBlock( &uxFl, &uxSl );
+			}
+			else
+			{
+				pxBlock = NULL;
+			}
+
+			if( pxBlock != NULL )
+			{
+				/* Every block in the selected list is large enough, so take the
+				one at the head. */
+				prvTlsfRemoveFreeBlock( pxBlock );
+
+				/* If the block is larger than required it can be split into two
+				and the remainder returned to the free lists. */
+				if( ( tlsfBLOCK_SIZE( pxBlock ) - xWantedSize ) >= tlsfMINIMUM_BLOCK_SIZE )
+				{
+					pxRemainder = ( xTlsfBlock * ) ( ( ( unsigned char * ) pxBlock ) + xWantedSize );
+					pxRemainder->xSize = tlsfBLOCK_SIZE( pxBlock ) - xWantedSize;
+					pxRemainder->pxPrevPhysBlock = pxBlock;
+					tlsfNEXT_PHYS_BLOCK( pxRemainder )->pxPrevPhysBlock = pxRemainder;
+					pxBlock->xSize = xWantedSize;
+
+					prvTlsfInsertFreeBlock( pxRemainder );
+				}
+				else
+				{
+					pxBlock->xSize &= ~tlsfBLOCK_FREE_BIT;
+				}
+
+				xTlsfFreeBytesRemaining -= tlsfBLOCK_SIZE( pxBlock );
+
+				if( xTlsfFreeBytesRemaining < xTlsfMinimumEverFreeBytesRemaining )
+				{
+					xTlsfMinimumEverFreeBytesRemaining = xTlsfFreeBytesRemaining;
+				}
+
+				xTlsfNumberOfSuccessfulAllocations++;
+				pvReturn = ( void * ) ( ( ( unsigned char * ) pxBlock ) + tlsfHEADER_SIZE );
+			}
+		}
+
+		if( pvReturn == NULL )
+		{
+			xTlsfNumberOfFailedAllocations++;
+		}
+
+		traceMALLOC( pvReturn, xWantedSize );
+	}
+	( void ) xTaskResumeAll();
+
+	#if( configUSE_MALLOC_FAILED_HOOK == 1 )
+	{
+		if( pvReturn == NULL )
+		{
+			extern void vApplicationMallocFailedHook( void );
+			vApplicationMallocFailedHook();
+		}
+	}
+	#endif
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void *pv )
+{
+xTlsfBlock *pxBlock, *pxNeighbour;
+
+	if( pv != NULL )
+	{
+		/* The memory being freed will have a block header immediately before
+		it. */
+		pxBlock = ( xTlsfBlock * ) ( ( ( unsigned char * ) pv ) - tlsfHEADER_SIZE );
+		configASSERT( !tlsfBLOCK_IS_FREE( pxBlock ) );
+
+		vTaskSuspendAll();
+		{
+			xTlsfFreeBytesRemaining += tlsfBLOCK_SIZE( pxBlock );
+			xTlsfNumberOfSuccessfulFrees++;
+			traceFREE( pv, tlsfBLOCK_SIZE( pxBlock ) );
+
+			/* Merge with the block below if it is free. */
+			pxNeighbour = pxBlock->pxPrevPhysBlock;
+			if( ( pxNeighbour != NULL ) && tlsfBLOCK_IS_FREE( pxNeighbour ) )
+			{
+				prvTlsfRemoveFreeBlock( pxNeighbour );
+				pxNeighbour->xSize = tlsfBLOCK_SIZE( pxNeighbour ) + tlsfBLOCK_SIZE( pxBlock );
+				pxBlock = pxNeighbour;
+			}
+
+			/* Merge with the block above if it is free.  The end marker is
+			never free so this cannot run off the end of the heap. */
+			pxNeighbour = tlsfNEXT_PHYS_BLOCK( pxBlock );
+			if( tlsfBLOCK_IS_FREE( pxNeighbour ) )
+			{
+				prvTlsfRemoveFreeBlock( pxNeighbour );
+				pxBlock->xSize = tlsfBLOCK_SIZE( pxBlock ) + tlsfBLOCK_SIZE( pxNeighbour );
+			}
+			else
+			{
+				pxBlock->xSize = tlsfBLOCK_SIZE( pxBlock );
+			}
+
+			tlsfNEXT_PHYS_BLOCK( pxBlock )->pxPrevPhysBlock = pxBlock;
+			prvTlsfInsertFreeBlock( pxBlock );
+		}
+		( void ) xTaskResumeAll();
+	}
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+	return xTlsfFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+	return xTlsfMinimumEverFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+void vPortInitialiseBlocks( void )
+{
+	/* This just exists to keep the linker quiet. */
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetHeapStats( HeapStats_t *pxHeapStats )
+{
+xTlsfBlock *pxBlock;
+UBaseType_t uxFl, uxSl;
+size_t xLargest = 0;
+
+	vTaskSuspendAll();
+	{
+		if( pxTlsfEnd == NULL )
+		{
+			prvTlsfInit();
+		}
+
+		/* The largest free block lives in the highest non-empty list.  Only
+		that one list has to be searched, and it only holds blocks within one
+		size class. */
+		if( ulFlBitmap != 0 )
+		{
+			uxFl = prvTlsfFls( ulFlBitmap );
+			uxSl = prvTlsfFls( ulSlBitmap[ uxFl ] );
+
+			for( pxBlock = pxFreeLists[ uxFl ][ uxSl ]; pxBlock != NULL; pxBlock = pxBlock->pxNextFree )
+			{
+				if( tlsfBLOCK_SIZE( pxBlock ) > xLargest )
+				{
+					xLargest = tlsfBLOCK_SIZE( pxBlock );
+				}
+			}
+		}
+
+		pxHeapStats->xAvailableHeapSpaceInBytes = xTlsfFreeBytesRemaining;
+		pxHeapStats->xSizeOfLargestFreeBlockInBytes = xLargest;
+		pxHeapStats->xNumberOfFreeBlocks = xTlsfNumberOfFreeBlocks;
+		pxHeapStats->xMinimumEverFreeBytesRemaining = xTlsfMinimumEverFreeBytesRemaining;
+		pxHeapStats->xNumberOfSuccessfulAllocations = xTlsfNumberOfSuccessfulAllocations;
+		pxHeapStats->xNumberOfSuccessfulFrees = xTlsfNumberOfSuccessfulFrees;
+		pxHeapStats->xNumberOfFailedAllocations = xTlsfNumberOfFailedAllocations;
+
+		/* Fragmentation is the share of free memory that cannot be handed out
+		as one block, in percent. */
+		if( xTlsfFreeBytesRemaining > 0 )
+		{
+			pxHeapStats->uxFragmentationPercent = ( UBaseType_t ) ( 100U - ( ( xLargest * 100U ) / xTlsfFreeBytesRemaining ) );
+		}
+		else
+		{
+			pxHeapStats->uxFragmentationPercent = 0;
+		}
+	}
+	( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+static void prvTlsfInit( void )
+{
+xTlsfBlock *pxFirstFreeBlock;
+
+	/* Ensure the start of the heap is aligned. */
+	configASSERT( ( ( ( unsigned long ) xTlsfHeap.ucHeap ) & ( ( unsigned long ) portBYTE_ALIGNMENT_MASK ) ) == 0UL );
+
+	/* The end marker sits at the top of the heap and is permanently marked as
+	allocated. */
+	pxTlsfEnd = ( xTlsfBlock * ) ( xTlsfHeap.ucHeap + xTlsfTotalHeapSize - tlsfMINIMUM_BLOCK_SIZE );
+	pxTlsfEnd->xSize = 0;
+
+	/* To start with there is a single free block that is sized to take up the
+	entire heap space, minus the space taken by the end marker. */
+	pxFirstFreeBlock = ( xTlsfBlock * ) xTlsfHeap.ucHeap;
+	pxFirstFreeBlock->pxPrevPhysBlock = NULL;
+	pxFirstFreeBlock->xSize = xTlsfTotalHeapSize - tlsfMINIMUM_BLOCK_SIZE;
+	pxTlsfEnd->pxPrevPhysBlock = pxFirstFreeBlock;
+
+	xTlsfFreeBytesRemaining = tlsfBLOCK_SIZE( pxFirstFreeBlock );
+	xTlsfMinimumEverFreeBytesRemaining = xTlsfFreeBytesRemaining;
+
+	prvTlsfInsertFreeBlock( pxFirstFreeBlock );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTlsfMappingInsert( size_t xSize, UBaseType_t *puxFl, UBaseType_t *puxSl )
+{
+UBaseType_t uxFls;
+
+	if( xSize < tlsfSMALL_BLOCK_SIZE )
+	{
+		/* Small blocks are stored in the first list, split linearly. */
+		*puxFl = 0;
+		*puxSl = ( UBaseType_t ) ( xSize / ( tlsfSMALL_BLOCK_SIZE / tlsfSL_INDEX_COUNT ) );
+	}
+	else
+	{
+		uxFls = prvTlsfFls( ( uint32_t ) xSize );
+		*puxSl = ( UBaseType_t ) ( ( xSize >> ( uxFls - tlsfSL_INDEX_COUNT_LOG2 ) ) ^ tlsfSL_INDEX_COUNT );
+		*puxFl = uxFls - ( tlsfFL_INDEX_SHIFT - 1 );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvTlsfMappingSearch( size_t xSize, UBaseType_t *puxFl, UBaseType_t *puxSl )
+{
+	if( xSize >= tlsfSMALL_BLOCK_SIZE )
+	{
+		/* Round up to the start of the next second level list. */
+		xSize += ( ( size_t ) 1 << ( prvTlsfFls( ( uint32_t ) xSize ) - tlsfSL_INDEX_COUNT_LOG2 ) ) - 1;
+	}
+
+	prvTlsfMappingInsert( xSize, puxFl, puxSl );
+}
+/*-----------------------------------------------------------*/
+
+static xTlsfBlock *prvTlsfFindSuitableBlock( UBaseType_t *puxFl, UBaseType_t *puxSl )
+{
+uint32_t ulSlMap, ulFlMap;
+
+	/* First look for a non-empty list in the same first level range. */
+	ulSlMap = ulSlBitmap[ *puxFl ] & ( ~( uint32_t ) 0 << *puxSl );
+
+	if( ulSlMap == 0 )
+	{
+		/* Nothing there, so move up to the next non-empty first level range. */
+		if( ( *puxFl + 1 ) >= 32 )
+		{
+			return NULL;
+		}
+
+		ulFlMap = ulFlBitmap & ( ~( uint32_t ) 0 << ( *puxFl + 1 ) );
+
+		if( ulFlMap == 0 )
+		{
+			/* The heap has no block large enough. */
+			return NULL;
+		}
+
+		*puxFl = prvTlsfFfs( ulFlMap );
+		ulSlMap = ulSlBitmap[ *puxFl ];
+	}
+
+	*puxSl = prvTlsfFfs( ulSlMap );
+
+	return pxFreeLists[ *puxFl ][ *puxSl ];
+}
+/*-----------------------------------------------------------*/
+
+static void prvTlsfInsertFreeBlock( xTlsfBlock *pxBlock )
+{
+UBaseType_t uxFl, uxSl;
+
+	prvTlsfMappingInsert( tlsfBLOCK_SIZE( pxBlock ), &uxFl, &uxSl );
+
+	pxBlock->xSize |= tlsfBLOCK_FREE_BIT;
+	pxBlock->pxPrevFree = NULL;
+	pxBlock->pxNextFree = pxFreeLists[ uxFl ][ uxSl ];
+
+	if( pxBlock->pxNextFree != NULL )
+	{
+		pxBlock->pxNextFree->pxPrevFree = pxBlock;
+	}
+
+	pxFreeLists[ uxFl ][ uxSl ] = pxBlock;
+	ulFlBitmap |= ( 1UL << uxFl );
+	ulSlBitmap[ uxFl ] |= ( 1UL << uxSl );
+	xTlsfNumberOfFreeBlocks++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTlsfRemoveFreeBlock( xTlsfBlock *pxBlock )
+{
+UBaseType_t uxFl, uxSl;
+
+	prvTlsfMappingInsert( tlsfBLOCK_SIZE( pxBlock ), &uxFl, &uxSl );
+
+	if( pxBlock->pxPrevFree != NULL )
+	{
+		pxBlock->pxPrevFree->pxNextFree = pxBlock->pxNextFree;
+	}
+	else
+	{
+		/* The block was at the head of its list. */
+		pxFreeLists[ uxFl ][ uxSl ] = pxBlock->pxNextFree;
+
+		if( pxFreeLists[ uxFl ][ uxSl ] == NULL )
+		{
+			ulSlBitmap[ uxFl ] &= ~( 1UL << uxSl );
+
+			if( ulSlBitmap[ uxFl ] == 0 )
+			{
+				ulFlBitmap &= ~( 1UL << uxFl );
+			}
+		}
+	}
+
+	if( pxBlock->pxNextFree != NULL )
+	{
+		pxBlock->pxNextFree->pxPrevFree = pxBlock->pxPrevFree;
+	}
+
+	pxBlock->xSize &= ~tlsfBLOCK_FREE_BIT;
+	xTlsfNumberOfFreeBlocks--;
+}
+
+#endif /* ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && configUSE_TLSF_HEAP */
@@ -0,0 +1,128 @@
+/*
+ * Deferred logger.  See logger.h.
+ *
+ * Writing a record masks interrupts, stores a pointer and three words and
+ * moves the head index.  The indexes run freely and wrap with a mask, so
+ * configLOG_BUFFER_RECORDS must be a power of two.
+ */
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "logger.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( configUSE_LOGGER == 1 )
+
+#if( ( configLOG_BUFFER_RECORDS & ( configLOG_BUFFER_RECORDS - 1 ) ) != 0 )
+	#error configLOG_BUFFER_RECORDS must be a power of two.
+#endif
+
+#define logBUFFER_MASK	( ( uint32_t ) configLOG_BUFFER_RECORDS - 1UL )
+
+static LogRecord_t xLogBuffer[ configLOG_BUFFER_RECORDS ];
+
+/* Records written and read since boot.  The next record written goes in
+xLogBuffer[ ulLogHead & logBUFFER_MASK ] and the next read comes from
+xLogBuffer[ ulLogTail & logBUFFER_MASK ]. */
+static uint32_t ulLogHead = 0;
+static uint32_t ulLogTail = 0;
+
+static uint32_t ulLogDropped = 0;
+static UBaseType_t uxLogMaximumUsed = 0;
+
+static TaskHandle_t xLogDrainTask = NULL;
+
+/*-----------------------------------------------------------*/
+
+void vLogWrite3( const char *pcFormat, int32_t lArg0, int32_t lArg1, int32_t lArg2 )
+{
+UBaseType_t uxSavedInterruptStatus;
+LogRecord_t *pxRecord;
+uint32_t ulUsed;
+BaseType_t xWasEmpty = pdFALSE;
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		ulUsed = ulLogHead - ulLogTail;
+
+		if( ulUsed < ( uint32_t ) configLOG_BUFFER_RECORDS )
+		{
+			pxRecord = &( xLogBuffer[ ulLogHead & logBUFFER_MASK ] );
+			pxRecord->pcFormat = pcFormat;
+			pxRecord->lArgs[ 0 ] = lArg0;
+			pxRecord->lArgs[ 1 ] = lArg1;
+			pxRecord->lArgs[ 2 ] = lArg2;
+			ulLogHead++;
+
+			if( ulUsed == 0UL )
+			{
+				xWasEmpty = pdTRUE;
+			}
+
+			if( ( UBaseType_t ) ( ulUsed + 1UL ) > uxLogMaximumUsed )
+			{
+				uxLogMaximumUsed = ( UBaseType_t ) ( ulUsed + 1UL );
+			}
+		}
+		else
+		{
+			ulLogDropped++;
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	/* A drain task that found the ring empty is, or is about to be, blocked
+	waiting for this.  Otherwise it has records left to read and will come to
+	this one before it blocks again.  Before the scheduler starts the drain
+	task is not waiting, so the notification is only left pending. */
+	if( ( xWasEmpty != pdFALSE ) && ( xLogDrainTask != NULL ) )
+	{
+		xTaskNotifyGive( xLogDrainTask );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vLogSetDrainTask( TaskHandle_t xTask )
+{
+	xLogDrainTask = xTask;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xLogRead( LogRecord_t *pxRecord )
+{
+UBaseType_t uxSavedInterruptStatus;
+BaseType_t xReturn = pdFALSE;
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		if( ulLogHead != ulLogTail )
+		{
+			*pxRecord = xLogBuffer[ ulLogTail & logBUFFER_MASK ];
+			ulLogTail++;
+			xReturn = pdTRUE;
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulLogGetDropped( void )
+{
+	return ulLogDropped;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxLogGetMaximumUsed( void )
+{
+	return uxLogMaximumUsed;
+}
+
+#endif /* configUSE_LOGGER */
@@ -0,0 +1,148 @@
+/*
+ * Deferred logger.
+ *
+ * When configUSE_LOGGER is 1, vLogPrintf() records a pointer to its format
+ * string and up to three integer arguments in a RAM ring of
+ * configLOG_BUFFER_RECORDS entries instead of formatting anything.  A low
+ * priority task drains the ring with xLogRead() and does the printf() later,
+ * so the caller never runs newlib's formatting or waits on the UART.
+ *
+ * Arguments are stored as 32-bit integers and handed back to printf() as int,
+ * so formats may only use %d, %i, %u, %x, %X, %c and %%.  The format string
+ * must stay valid until the record is drained, which a string literal always
+ * does.  When the ring is full new records are dropped and counted.
+ *
+ * Only tasks may log: the first record into an empty ring wakes the drain
+ * task with xTaskNotifyGive().
+ *
+ * logENABLED() filters messages by level and subsystem at compile time, with
+ * or without configUSE_LOGGER.
+ */
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#ifndef INC_FREERTOS_H
+	#error "include FreeRTOS.h" must appear in source files before "include logger.h"
+#endif
+
+#include "task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 16 bytes on the Nios II. */
+typedef struct xLOG_RECORD
+{
+	const char *pcFormat;
+	int32_t lArgs[ 3 ];
+} LogRecord_t;
+
+/**
+ * logger. h
+ * <pre>
+ void vLogPrintf( const char *pcFormat, ... );
+ * </pre>
+ *
+ * Records a message with no more than three integer arguments.  Picks
+ * vLogWrite0() to vLogWrite3() by the number of arguments given.
+ */
+#define logSELECT( _0, _1, _2, _3, NAME, ... )	NAME
+#define vLogPrintf( ... )	logSELECT( __VA_ARGS__, vLogWrite3, vLogWrite2, vLogWrite1, vLogWrite0, 0 )( __VA_ARGS__ )
+
+#define vLogWrite0( pcFormat )					vLogWrite3( ( pcFormat ), 0, 0, 0 )
+#define vLogWrite1( pcFormat, lArg0 )			vLogWrite3( ( pcFormat ), ( int32_t ) ( lArg0 ), 0, 0 )
+#define vLogWrite2( pcFormat, lArg0, lArg1 )	vLogWrite3( ( pcFormat ), ( int32_t ) ( lArg0 ), ( int32_t ) ( lArg1 ), 0 )
+
+/**
+ * logger. h
+ * <pre>
+ void vLogWrite3( const char *pcFormat, int32_t lArg0, int32_t lArg1, int32_t lArg2 );
+ * </pre>
+ *
+ * Appends a record to the ring.  Masks interrupts for a handful of stores and
+ * never blocks.
+ */
+void vLogWrite3( const char *pcFormat, int32_t lArg0, int32_t lArg1, int32_t lArg2 ) PRIVILEGED_FUNCTION;
+
+/**
+ * logger. h
+ * <pre>
+ void vLogSetDrainTask( TaskHandle_t xTask );
+ * </pre>
+ *
+ * Sets the task woken by the first record written into an empty ring.
+ */
+void vLogSetDrainTask( TaskHandle_t xTask ) PRIVILEGED_FUNCTION;
+
+/**
+ * logger. h
+ * <pre>
+ BaseType_t xLogRead( LogRecord_t *pxRecord );
+ * </pre>
+ *
+ * Takes the oldest record out of the ring.
+ *
+ * @return pdTRUE if a record was copied to pxRecord, pdFALSE if the ring is
+ * empty.
+ */
+BaseType_t xLogRead( LogRecord_t *pxRecord ) PRIVILEGED_FUNCTION;
+
+/**
+ * logger. h
+ * <pre>
+ uint32_t ulLogGetDropped( void );
+ UBaseType_t uxLogGetMaximumUsed( void );
+ * </pre>
+ *
+ * The number of records dropped because the ring was full, and the most
+ * records the ring has held at once.
+ */
+uint32_t ulLogGetDropped( void ) PRIVILEGED_FUNCTION;
+UBaseType_t uxLogGetMaximumUsed( void ) PRIVILEGED_FUNCTION;
+
+/* Message levels, most severe first. */
+#define logLEVEL_NONE		0
+#define logLEVEL_ERROR		1
+#define logLEVEL_WARN		2
+#define logLEVEL_INFO		3
+#define logLEVEL_DEBUG		4
+
+/**
+ * logger. h
+ * <pre>
+ logENABLED( uxLevel, ulSubsystem )
+ * </pre>
+ *
+ * Whether messages at uxLevel from the subsystem with bit ulSubsystem are
+ * built, going by configLOG_LEVEL and configLOG_SUBSYSTEMS.  The subsystem
+ * bits are the application's.  This is a constant expression, so a message
+ * written as
+ *
+ *     if( logENABLED( logLEVEL_DEBUG, ulSubsystem ) ) { vLogPrintf( ... ); }
+ *
+ * is removed by the compiler, format string and all, when it is false.  GCC
+ * does so at -O0 as well.  The message is still compiled, so a disabled
+ * message cannot rot.
+ */
+#define logENABLED( uxLevel, ulSubsystem )	( ( ( uxLevel ) <= ( configLOG_LEVEL ) ) && ( ( ( ulSubsystem ) & ( configLOG_SUBSYSTEMS ) ) != 0UL ) )
+
+/* printf() or anything that behaves like it. */
+typedef int ( *LogPrintFunction_t )( const char *pcFormat, ... );
+
+/**
+ * logger. h
+ * <pre>
+ void vLogPrintRecord( const LogRecord_t *pxRecord, LogPrintFunction_t pxPrint );
+ * </pre>
+ *
+ * Formats a record read by xLogRead() with pxPrint.
+ */
+#define vLogPrintRecord( pxRecord, pxPrint )	( void ) ( pxPrint )( ( pxRecord )->pcFormat, ( int ) ( pxRecord )->lArgs[ 0 ], ( int ) ( pxRecord )->lArgs[ 1 ], ( int ) ( pxRecord )->lArgs[ 2 ] )
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOGGER_H */
@@ -0,0 +1,289 @@
+/*
+ * Fixed size block pools.  See pool.h for a description of the API.
+ */
+
+#include <stdlib.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "pool.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( configUSE_POOLS == 1 )
+
+/* Rounds a size up to the port's byte alignment. */
+#define poolALIGN( x )		( ( ( size_t ) ( x ) + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK ) )
+
+/* A free block holds the link to the next free block in its first bytes. */
+typedef struct POOL_FREE_BLOCK
+{
+	struct POOL_FREE_BLOCK *pxNext;
+} xPoolFreeBlock;
+
+typedef struct POOL_DEFINITION
+{
+	xPoolFreeBlock *pxFreeList;			/*<< Head of the list of free blocks. */
+	unsigned char *pucStart;			/*<< First block, used to check blocks being returned. */
+	unsigned char *pucEnd;				/*<< One past the last block. */
+	size_t xBlockSize;					/*<< Size of each block after alignment. */
+	UBaseType_t uxFreeCount;			/*<< Number of blocks currently in the free list. */
+	UBaseType_t uxMinimumEverFreeCount;	/*<< Lowest value uxFreeCount has reached. */
+	uint32_t ulExhaustedCount;			/*<< Number of get calls that found the pool empty. */
+} xPOOL;
+
+/* The region every pool is carved from.  The union is used to force byte
+alignment without using any non-portable code. */
+static union xPOOL_REGION
+{
+	#if portBYTE_ALIGNMENT == 8
+		volatile portDOUBLE dDummy;
+	#else
+		volatile unsigned long ulDummy;
+	#endif
+	unsigned char ucRegion[ configPOOL_REGION_SIZE ];
+} xPoolRegion;
+
+/* Offset of the first unused byte of the region. */
+static size_t xPoolRegionUsed = 0;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Unlinks the block at the head of the free list, or returns NULL if the
+ * list is empty.  Must be called with interrupts masked.
+ */
+static void *prvPoolTake( xPOOL *pxPool );
+
+/*
+ * Pushes a block onto the head of the free list.  Must be called with
+ * interrupts masked.
+ */
+static void prvPoolGive( xPOOL *pxPool, void *pvBlock );
+
+/*-----------------------------------------------------------*/
+
+PoolHandle_t xPoolCreate( size_t xBlockSize, UBaseType_t uxBlockCount )
+{
+xPOOL *pxPool = NULL;
+size_t xRequired;
+UBaseType_t ux;
+unsigned char *pucBlock;
+
+	configASSERT( uxBlockCount > 0 );
+
+	/* Every block must be able to hold the free list link. */
+	if( xBlockSize < sizeof( xPoolFreeBlock ) )
+	{
+		xBlockSize = sizeof( xPoolFreeBlock );
+	}
+	xBlockSize = poolALIGN( xBlockSize );
+
+	xRequired = poolALIGN( sizeof( xPOOL ) ) + ( xBlockSize * ( size_t ) uxBlockCount );
+
+	vTaskSuspendAll();
+	{
+		if( ( configPOOL_REGION_SIZE - xPoolRegionUsed ) >= xRequired )
+		{
+			pxPool = ( xPOOL * ) &( xPoolRegion.ucRegion[ xPoolRegionUsed ] );
+			xPoolRegionUsed += xRequired;
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	if( pxPool != NULL )
+	{
+		pxPool->xBlockSize = xBlockSize;
+		pxPool->pucStart = ( ( unsigned char * ) pxPool ) + poolALIGN( sizeof( xPOOL ) );
+		pxPool->pucEnd = pxPool->pucStart + ( xBlockSize * ( size_t ) uxBlockCount );
+		pxPool->uxFreeCount = uxBlockCount;
+		pxPool->uxMinimumEverFreeCount = uxBlockCount;
+		pxPool->ulExhaustedCount = 0;
+
+		/* Thread every block onto the free list in address order. */
+		pxPool->pxFreeList = NULL;
+		pucBlock = pxPool->pucEnd;
+		for( ux = 0; ux < uxBlockCount; ux++ )
+		{
+			pucBlock -= xBlockSize;
+			( ( xPoolFreeBlock * ) pucBlock )->pxNext = pxPool->pxFreeList;
+			pxPool->pxFreeList = ( xPoolFreeBlock * ) pucBlock;
+		}
+	}
+
+	return ( PoolHandle_t ) pxPool;
+}
+/*-----------------------------------------------------------*/
+
+void *pvPoolGet( PoolHandle_t xPool )
+{
+void *pvBlock;
+
+	configASSERT( xPool );
+
+	taskENTER_CRITICAL();
+	{
+		pvBlock = prvPoolTake( ( xPOOL * ) xPool );
+	}
+	taskEXIT_CRITICAL();
+
+	return pvBlock;
+}
+/*-----------------------------------------------------------*/
+
+void *pvPoolGetFromISR( PoolHandle_t xPool )
+{
+void *pvBlock;
+UBaseType_t uxSavedInterruptStatus;
+
+	configASSERT( xPool );
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		pvBlock = prvPoolTake( ( xPOOL * ) xPool );
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	return pvBlock;
+}
+/*-----------------------------------------------------------*/
+
+void vPoolPut( PoolHandle_t xPool, void *pvBlock )
+{
+	configASSERT( xPool );
+
+	if( pvBlock != NULL )
+	{
+		taskENTER_CRITICAL();
+		{
+			prvPoolGive( ( xPOOL * ) xPool, pvBlock );
+		}
+		taskEXIT_CRITICAL();
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPoolPutFromISR( PoolHandle_t xPool, void *pvBlock )
+{
+UBaseType_t uxSavedInterruptStatus;
+
+	configASSERT( xPool );
+
+	if( pvBlock != NULL )
+	{
+		uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+		{
+			prvPoolGive( ( xPOOL * ) xPool, pvBlock );
+		}
+		portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPoolSendToQueue( PoolHandle_t xPool, QueueHandle_t xQueue, void *pvBlock, TickType_t xTicksToWait )
+{
+BaseType_t xReturn;
+
+	configASSERT( pvBlock );
+
+	xReturn = xQueueSendToBack( xQueue, &pvBlock, xTicksToWait );
+	if( xReturn != pdPASS )
+	{
+		vPoolPut( xPool, pvBlock );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPoolSendToQueueFromISR( PoolHandle_t xPool, QueueHandle_t xQueue, void *pvBlock, BaseType_t *pxHigherPriorityTaskWoken )
+{
+BaseType_t xReturn;
+
+	configASSERT( pvBlock );
+
+	xReturn = xQueueSendToBackFromISR( xQueue, &pvBlock, pxHigherPriorityTaskWoken );
+	if( xReturn != pdPASS )
+	{
+		vPoolPutFromISR( xPool, pvBlock );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void *pvPoolReceiveFromQueue( QueueHandle_t xQueue, TickType_t xTicksToWait )
+{
+void *pvBlock = NULL;
+
+	if( xQueueReceive( xQueue, &pvBlock, xTicksToWait ) != pdPASS )
+	{
+		pvBlock = NULL;
+	}
+
+	return pvBlock;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxPoolGetFreeCount( PoolHandle_t xPool )
+{
+	configASSERT( xPool );
+	return ( ( xPOOL * ) xPool )->uxFreeCount;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxPoolGetMinimumEverFreeCount( PoolHandle_t xPool )
+{
+	configASSERT( xPool );
+	return ( ( xPOOL * ) xPool )->uxMinimumEverFreeCount;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulPoolGetExhaustedCount( PoolHandle_t xPool )
+{
+	configASSERT( xPool );
+	return ( ( xPOOL * ) xPool )->ulExhaustedCount;
+}
+/*-----------------------------------------------------------*/
+
+static void *prvPoolTake( xPOOL *pxPool )
+{
+xPoolFreeBlock *pxBlock = pxPool->pxFreeList;
+
+	if( pxBlock != NULL )
+	{
+		pxPool->pxFreeList = pxBlock->pxNext;
+		pxPool->uxFreeCount--;
+
+		if( pxPool->uxFreeCount < pxPool->uxMinimumEverFreeCount )
+		{
+			pxPool->uxMinimumEverFreeCount = pxPool->uxFreeCount;
+		}
+	}
+	else
+	{
+		pxPool->ulExhaustedCount++;
+	}
+
+	return ( void * ) pxBlock;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPoolGive( xPOOL *pxPool, void *pvBlock )
+{
+	/* The block must belong to this pool and be on a block boundary. */
+	configASSERT( ( ( unsigned char * ) pvBlock >= pxPool->pucStart ) && ( ( unsigned char * ) pvBlock < pxPool->pucEnd ) );
+	configASSERT( ( ( size_t ) ( ( unsigned char * ) pvBlock - pxPool->pucStart ) % pxPool->xBlockSize ) == 0 );
+
+	( ( xPoolFreeBlock * ) pvBlock )->pxNext = pxPool->pxFreeList;
+	pxPool->pxFreeList = ( xPoolFreeBlock * ) pvBlock;
+	pxPool->uxFreeCount++;
+}
+
+#endif /* configUSE_POOLS */
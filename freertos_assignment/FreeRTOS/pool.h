@@ -0,0 +1,131 @@
+/*
+ * Fixed size block pools.
+ *
+ * A pool hands out blocks of one fixed size from storage carved out of a
+ * single statically allocated region (configPOOL_REGION_SIZE bytes) when the
+ * pool is created.  Taking and returning a block are O(1) and never touch the
+ * heap, and both have ...FromISR() variants so an ISR can fill a block and
+ * pass a pointer to it through a queue instead of copying the whole record.
+ * xPoolSendToQueue() and pvPoolReceiveFromQueue() hand a block's ownership
+ * through a queue of pointers that way.  That pays off only for large
+ * records: items of up to 16 bytes are cheaper copied by value, which
+ * configUSE_QUEUE_SIZED_COPY does a word at a time.
+ *
+ * Pools are created once at start up and are never deleted.
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#ifndef INC_FREERTOS_H
+	#error "include FreeRTOS.h" must appear in source files before "include pool.h"
+#endif
+
+#include "queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Type by which pools are referenced.  xPoolCreate() returns a PoolHandle_t
+ * that is then passed to pvPoolGet(), vPoolPut(), etc.
+ */
+typedef void * PoolHandle_t;
+
+/**
+ * pool. h
+ * <pre>
+ PoolHandle_t xPoolCreate( size_t xBlockSize, UBaseType_t uxBlockCount );
+ * </pre>
+ *
+ * Creates a pool of uxBlockCount blocks of xBlockSize bytes.  The pool control
+ * structure and the blocks are carved out of the static pool region, so this
+ * must only be called before the scheduler is started or from a task.
+ *
+ * @param xBlockSize The number of bytes in each block.  Rounded up to
+ * portBYTE_ALIGNMENT and to at least the size of a pointer.
+ *
+ * @param uxBlockCount The number of blocks in the pool.
+ *
+ * @return A handle to the pool, or NULL if the pool region does not have room
+ * for it.
+ */
+PoolHandle_t xPoolCreate( size_t xBlockSize, UBaseType_t uxBlockCount ) PRIVILEGED_FUNCTION;
+
+/**
+ * pool. h
+ * <pre>
+ void *pvPoolGet( PoolHandle_t xPool );
+ void *pvPoolGetFromISR( PoolHandle_t xPool );
+ * </pre>
+ *
+ * Takes a block from the pool.  Neither call blocks: if the pool is empty NULL
+ * is returned and the pool's exhaustion counter is incremented.
+ */
+void *pvPoolGet( PoolHandle_t xPool ) PRIVILEGED_FUNCTION;
+void *pvPoolGetFromISR( PoolHandle_t xPool ) PRIVILEGED_FUNCTION;
+
+/**
+ * pool. h
+ * <pre>
+ void vPoolPut( PoolHandle_t xPool, void *pvBlock );
+ void vPoolPutFromISR( PoolHandle_t xPool, void *pvBlock );
+ * </pre>
+ *
+ * Returns a block previously obtained from the same pool.
+ */
+void vPoolPut( PoolHandle_t xPool, void *pvBlock ) PRIVILEGED_FUNCTION;
+void vPoolPutFromISR( PoolHandle_t xPool, void *pvBlock ) PRIVILEGED_FUNCTION;
+
+/**
+ * pool. h
+ * <pre>
+ UBaseType_t uxPoolGetFreeCount( PoolHandle_t xPool );
+ UBaseType_t uxPoolGetMinimumEverFreeCount( PoolHandle_t xPool );
+ uint32_t ulPoolGetExhaustedCount( PoolHandle_t xPool );
+ * </pre>
+ *
+ * Pool statistics: the number of blocks currently free, the lowest the free
+ * count has ever been, and the number of get calls that failed because the
+ * pool was empty.
+ */
+UBaseType_t uxPoolGetFreeCount( PoolHandle_t xPool ) PRIVILEGED_FUNCTION;
+UBaseType_t uxPoolGetMinimumEverFreeCount( PoolHandle_t xPool ) PRIVILEGED_FUNCTION;
+uint32_t ulPoolGetExhaustedCount( PoolHandle_t xPool ) PRIVILEGED_FUNCTION;
+
+/**
+ * pool. h
+ * <pre>
+ BaseType_t xPoolSendToQueue( PoolHandle_t xPool, QueueHandle_t xQueue, void *pvBlock, TickType_t xTicksToWait );
+ BaseType_t xPoolSendToQueueFromISR( PoolHandle_t xPool, QueueHandle_t xQueue, void *pvBlock, BaseType_t *pxHigherPriorityTaskWoken );
+ * </pre>
+ *
+ * Passes a block to the back of a queue by reference.  Only the pointer is
+ * copied, so xQueue must have been created with an item size of
+ * sizeof( void * ).  The caller gives up the block whatever the result: if
+ * the queue stays full it is returned to xPool.
+ *
+ * @return pdPASS if the block was queued, otherwise errQUEUE_FULL.
+ */
+BaseType_t xPoolSendToQueue( PoolHandle_t xPool, QueueHandle_t xQueue, void *pvBlock, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+BaseType_t xPoolSendToQueueFromISR( PoolHandle_t xPool, QueueHandle_t xQueue, void *pvBlock, BaseType_t *pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * pool. h
+ * <pre>
+ void *pvPoolReceiveFromQueue( QueueHandle_t xQueue, TickType_t xTicksToWait );
+ * </pre>
+ *
+ * Takes a block sent with xPoolSendToQueue().  The caller then owns the block
+ * and returns it to its pool with vPoolPut() when done.
+ *
+ * @return The block, or NULL if none arrived within xTicksToWait.
+ */
+void *pvPoolReceiveFromQueue( QueueHandle_t xQueue, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POOL_H */
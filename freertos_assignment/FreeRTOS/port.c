@@ -84,6 +84,10 @@
 #include "FreeRTOS.h"
 #include "task.h"
 
+#if( configUSE_PROFILER == 1 )
+	#include "profiler.h"
+#endif
+
 /* Interrupts are enabled. */
 #define portINITIAL_ESTATUS     ( StackType_t ) 0x01 
 #define SYS_CLK_BASE TIMER1MS_BASE
@@ -108,6 +112,78 @@ static void prvSetupTimerInterrupt( void );
  */
 void vPortSysTickHandler( void * context, alt_u32 id );
 
+/*
+ * alt_irq_handler() calls the registered handlers directly, so
+ * alt_irq_register() puts this in front of each handler.  It lets interrupts
+ * of a higher priority nest on the handler and records interrupt entry and
+ * exit for the trace recorder.
+ */
+static void prvInterruptEntry( void * context, alt_u32 id );
+
+/*
+ * Works out which interrupts may nest on each interrupt from the priorities.
+ */
+static void prvUpdateNestingMasks( void );
+
+/* The handlers prvInterruptEntry() passes on to. */
+static struct
+{
+	void ( *handler )( void *, alt_u32 );
+	void *context;
+} xPortHandlers[ ALT_NIRQ ];
+
+/* Priority of each interrupt, set with vPortSetInterruptPriority(), and the
+interrupts of a higher priority that may nest on it. */
+static UBaseType_t uxInterruptPriorities[ ALT_NIRQ ] = { [ 0 ... ALT_NIRQ - 1 ] = configKERNEL_INTERRUPT_PRIORITY };
+static alt_u32 ulNestingMasks[ ALT_NIRQ ];
+
+/* Interrupts that may nest on the one being handled, all of them while a task
+is running. */
+static alt_u32 ulCurrentNestingMask = ~( alt_u32 ) 0;
+
+/* Priority of the interrupt being handled, 0 while a task is running. */
+volatile UBaseType_t uxPortInterruptPriority = 0;
+
+/* Set by portEND_SWITCHING_ISR().  port_asm.S makes the switch once the
+outermost interrupt has been handled, so however many handlers ask for a switch
+the scheduler is only run once. */
+volatile uint32_t ulPortYieldPending = 0;
+
+/* Number of interrupts being handled, kept by port_asm.S.  Only the outermost
+one saves the task's stack pointer to its TCB. */
+volatile uint32_t ulPortInterruptNesting = 0;
+
+/* Interrupt handlers run on this stack instead of the stack of the task they
+interrupt.  port_asm.S moves to it on entry to the outermost interrupt and
+leaves it on the way out, so a task stack only has to hold the one context
+frame saved on entry.  It is filled with portISR_STACK_FILL_BYTE when the
+scheduler starts so its use can be measured. */
+#define portISR_STACK_FILL_BYTE		( 0xa5U )
+#define portISR_STACK_FILL_WORD		( ( StackType_t ) 0xa5a5a5a5UL )
+static StackType_t xISRStack[ configISR_STACK_SIZE ];
+StackType_t * const pxPortISRStackTop = &( xISRStack[ configISR_STACK_SIZE ] );
+
+/* The HAL's copy of ienable, kept by alt_irq_enable() and alt_irq_disable(). */
+extern volatile alt_u32 alt_irq_active;
+
+#if( configUSE_PROFILER == 1 )
+
+	/* port_asm.S saves a task's context frame at the top of its stack, and
+	the first member of the TCB points to it.  The PC is the 19th word. */
+	extern void * volatile pxCurrentTCB;
+	#define portFRAME_PC_WORD		18
+
+	/* The interrupt being handled, profilerNO_INTERRUPT while a task is
+	running. */
+	static uint32_t ulCurrentInterrupt = profilerNO_INTERRUPT;
+
+	/*
+	 * Takes the profiler's sample on entry to the tick interrupt.
+	 */
+	static void prvProfilerTick( void );
+
+#endif
+
 /*-----------------------------------------------------------*/
 
 static void prvReadGp( uint32_t *ulValue )
@@ -163,6 +239,8 @@ BaseType_t xPortStartScheduler( void )
 	/* Start the timer that generates the tick ISR.  Interrupts are disabled
 	here already. */
 	prvSetupTimerInterrupt();
+
+	memset( xISRStack, ( int ) portISR_STACK_FILL_BYTE, sizeof( xISRStack ) );
 	
 	/* Start the first task. */
     asm volatile (  " movia r2, restore_sp_from_pxCurrentTCB        \n"
@@ -196,8 +274,9 @@ void prvSetupTimerInterrupt( void )
 	{
 		/* Configure SysTick to interrupt at the requested rate. */
 		IOWR_ALTERA_AVALON_TIMER_CONTROL( SYS_CLK_BASE, ALTERA_AVALON_TIMER_CONTROL_STOP_MSK );
-		IOWR_ALTERA_AVALON_TIMER_PERIODL( SYS_CLK_BASE, ( configCPU_CLOCK_HZ / configTICK_RATE_HZ ) & 0xFFFF );
-		IOWR_ALTERA_AVALON_TIMER_PERIODH( SYS_CLK_BASE, ( configCPU_CLOCK_HZ / configTICK_RATE_HZ ) >> 16 );
+		/* The timer times out one count after reaching zero. */
+		IOWR_ALTERA_AVALON_TIMER_PERIODL( SYS_CLK_BASE, ( ( configCPU_CLOCK_HZ / configTICK_RATE_HZ ) - 1 ) & 0xFFFF );
+		IOWR_ALTERA_AVALON_TIMER_PERIODH( SYS_CLK_BASE, ( ( configCPU_CLOCK_HZ / configTICK_RATE_HZ ) - 1 ) >> 16 );
 		IOWR_ALTERA_AVALON_TIMER_CONTROL( SYS_CLK_BASE, ALTERA_AVALON_TIMER_CONTROL_CONT_MSK | ALTERA_AVALON_TIMER_CONTROL_START_MSK | ALTERA_AVALON_TIMER_CONTROL_ITO_MSK );	
 	} 
 
@@ -208,11 +287,42 @@ void prvSetupTimerInterrupt( void )
 
 void vPortSysTickHandler( void * context, alt_u32 id )
 {
-	/* Increment the kernel tick. */
-	if( xTaskIncrementTick() != pdFALSE )
+UBaseType_t uxSavedInterruptStatus;
+
+	/* Higher priority interrupts can nest on the tick, and call the kernel
+	too, so they are held off while the tick is processed. */
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		#if( configUSE_TICKLESS_IDLE == 1 )
+		{
+			/* Put the one tick period back after a sleep (port_tickless.c). */
+			vPortTicklessTickInterrupt();
+		}
+		#endif
+
+		#if( configGENERATE_RUN_TIME_STATS == 1 )
+		{
+			/* Keep the run time counter from wrapping unseen (port_runtime.c). */
+			vPortRunTimeTickInterrupt();
+		}
+		#endif
+
+		/* Increment the kernel tick. */
+		portEND_SWITCHING_ISR( xTaskIncrementTick() );
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	#if( configCHECK_FOR_STACK_OVERFLOW > 1 )
 	{
-        vTaskSwitchContext();
+		/* As the kernel checks task stacks, look for the fill pattern at the
+		far end of the interrupt stack. */
+		if( ( xISRStack[ 0 ] != portISR_STACK_FILL_WORD ) || ( xISRStack[ 1 ] != portISR_STACK_FILL_WORD ) ||
+			( xISRStack[ 2 ] != portISR_STACK_FILL_WORD ) || ( xISRStack[ 3 ] != portISR_STACK_FILL_WORD ) )
+		{
+			vApplicationStackOverflowHook( NULL, ( signed char * ) "ISR" );
+		}
 	}
+	#endif
 		
 	/* Clear the interrupt. */
 	IOWR_ALTERA_AVALON_TIMER_STATUS( SYS_CLK_BASE, ~ALTERA_AVALON_TIMER_STATUS_TO_MSK );
@@ -240,7 +350,9 @@ int alt_irq_register( alt_u32 id, void* context, void (*handler)(void*, alt_u32)
 	
 		status = alt_irq_disable_all ();
 	
-		alt_irq[id].handler = handler;
+		xPortHandlers[id].handler = handler;
+		xPortHandlers[id].context = context;
+		alt_irq[id].handler = (handler) ? prvInterruptEntry : handler;
 		alt_irq[id].context = context;
 	
 		rc = (handler) ? alt_irq_enable (id): alt_irq_disable (id);
@@ -252,3 +364,145 @@ int alt_irq_register( alt_u32 id, void* context, void (*handler)(void*, alt_u32)
 }
 /*-----------------------------------------------------------*/
 
+void vPortSetInterruptPriority( uint32_t ulIrq, UBaseType_t uxPriority )
+{
+alt_irq_context status;
+
+	configASSERT( ulIrq < ALT_NIRQ );
+	configASSERT( uxPriority >= configKERNEL_INTERRUPT_PRIORITY );
+
+	status = alt_irq_disable_all();
+	{
+		uxInterruptPriorities[ ulIrq ] = uxPriority;
+		prvUpdateNestingMasks();
+	}
+	alt_irq_enable_all( status );
+}
+/*-----------------------------------------------------------*/
+
+static void prvUpdateNestingMasks( void )
+{
+alt_u32 ulIrq, ulOther;
+
+	for( ulIrq = 0; ulIrq < ALT_NIRQ; ulIrq++ )
+	{
+		ulNestingMasks[ ulIrq ] = 0;
+
+		for( ulOther = 0; ulOther < ALT_NIRQ; ulOther++ )
+		{
+			if( uxInterruptPriorities[ ulOther ] > uxInterruptPriorities[ ulIrq ] )
+			{
+				ulNestingMasks[ ulIrq ] |= ( alt_u32 ) 1 << ulOther;
+			}
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxPortGetISRStackHighWaterMark( void )
+{
+UBaseType_t uxUnused = 0;
+
+	while( ( uxUnused < configISR_STACK_SIZE ) && ( xISRStack[ uxUnused ] == portISR_STACK_FILL_WORD ) )
+	{
+		uxUnused++;
+	}
+
+	return uxUnused;
+}
+/*-----------------------------------------------------------*/
+
+#if( configUSE_PROFILER == 1 )
+
+static void prvProfilerTick( void )
+{
+	if( ulCurrentInterrupt == profilerNO_INTERRUPT )
+	{
+		/* The tick interrupted a task, whose context frame holds the PC. */
+		vProfilerSampleFromISR( ( uintptr_t ) ( *( StackType_t ** ) pxCurrentTCB )[ portFRAME_PC_WORD ] );
+	}
+	else
+	{
+		/* Only if the tick has been given a higher priority than another
+		interrupt.  The handler's frame is somewhere on the interrupt stack,
+		so the sample goes to its entry point as a claimed one does. */
+		vProfilerClaimSampleFromISR( ulCurrentInterrupt, ( uintptr_t ) xPortHandlers[ ulCurrentInterrupt ].handler );
+		vProfilerSampleFromISR( 0 );
+	}
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configUSE_PROFILER */
+
+static void prvInterruptEntry( void * context, alt_u32 id )
+{
+alt_u32 ulSavedNestingMask = ulCurrentNestingMask;
+UBaseType_t uxSavedPriority = uxPortInterruptPriority;
+alt_u32 ulStatus;
+#if( configUSE_PROFILER == 1 )
+	uint32_t ulSavedInterrupt = ulCurrentInterrupt;
+	alt_u32 ulTickDue;
+#endif
+
+	( void ) context;
+
+	traceISR_ENTER( id );
+
+	#if( configUSE_PROFILER == 1 )
+	{
+		if( id == SYS_CLK_IRQ )
+		{
+			prvProfilerTick();
+		}
+
+		/* Whether the tick was already due, so it is only claimed below if it
+		came due while this handler ran. */
+		ulTickDue = IORD_ALTERA_AVALON_TIMER_STATUS( SYS_CLK_BASE ) & ALTERA_AVALON_TIMER_STATUS_TO_MSK;
+		ulCurrentInterrupt = id;
+	}
+	#endif
+
+	uxPortInterruptPriority = uxInterruptPriorities[ id ];
+	ulCurrentNestingMask = ulNestingMasks[ id ];
+
+	if( ulCurrentNestingMask != 0 )
+	{
+		/* Only the interrupts of a higher priority are left enabled in
+		ienable, then interrupts are enabled for the length of the handler.
+		The exception entry code in port_asm.S saves a nested interrupt's
+		context on top of this one.  Only PIE is changed in status, which is
+		put back as it was before ienable is. */
+		NIOS2_READ_STATUS( ulStatus );
+		NIOS2_WRITE_IENABLE( alt_irq_active & ulCurrentNestingMask );
+		NIOS2_WRITE_STATUS( ulStatus | NIOS2_STATUS_PIE_MSK );
+
+		xPortHandlers[ id ].handler( xPortHandlers[ id ].context, id );
+
+		NIOS2_WRITE_STATUS( ulStatus );
+		NIOS2_WRITE_IENABLE( alt_irq_active & ulSavedNestingMask );
+	}
+	else
+	{
+		/* Nothing can nest on this one, so it runs with interrupts disabled
+		as it always has. */
+		xPortHandlers[ id ].handler( xPortHandlers[ id ].context, id );
+	}
+
+	ulCurrentNestingMask = ulSavedNestingMask;
+	uxPortInterruptPriority = uxSavedPriority;
+
+	#if( configUSE_PROFILER == 1 )
+	{
+		ulCurrentInterrupt = ulSavedInterrupt;
+
+		if( ( id != SYS_CLK_IRQ ) && ( ulTickDue == 0 ) &&
+			( ( IORD_ALTERA_AVALON_TIMER_STATUS( SYS_CLK_BASE ) & ALTERA_AVALON_TIMER_STATUS_TO_MSK ) != 0 ) )
+		{
+			vProfilerClaimSampleFromISR( id, ( uintptr_t ) xPortHandlers[ id ].handler );
+		}
+	}
+	#endif
+
+	traceISR_EXIT( id );
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,88 @@
+/*
+ * Run time statistics clock for the Nios II port.  The host simulated port in
+ * host/port builds this file too.
+ *
+ * The counter is the TIMER1US Avalon interval timer running down from
+ * 0xFFFFFFFF in continuous mode with its interrupt disabled - the same set up
+ * the relay uses to time its boot, so if the application has already started
+ * the timer it is left running and boot times and run times share one time
+ * base.  At 100MHz the 32-bit counter wraps every 42.9 seconds, so it is
+ * extended to 64 bits in software.  That relies on it being read at least once
+ * per wrap.  The kernel reads it on every context switch, and in case one task
+ * runs for longer than that without a switch vPortRunTimeTickInterrupt() reads
+ * it once a second from the tick.  The tickless idle code reads it before each
+ * sleep and keeps sleeps shorter than half a wrap.
+ *
+ * Reading the counter costs one write to latch the snapshot, two register
+ * reads and a 64-bit compare and add.  There are no loops and no divides.
+ */
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Altera includes. */
+#include "altera_avalon_timer_regs.h"
+
+#if( configGENERATE_RUN_TIME_STATS == 1 )
+
+#define portRUN_TIME_TIMER_BASE		TIMER1US_BASE
+
+/* Low word of the last reading and the software high word above it. */
+static uint32_t ulLastRunTimeLow = 0;
+static uint32_t ulRunTimeHigh = 0;
+
+/* Ticks until vPortRunTimeTickInterrupt() next reads the counter. */
+static UBaseType_t uxTicksUntilRunTimeRead = configTICK_RATE_HZ;
+
+/*-----------------------------------------------------------*/
+
+void vPortConfigureRunTimeCounter( void )
+{
+	if( ( IORD_ALTERA_AVALON_TIMER_STATUS( portRUN_TIME_TIMER_BASE ) & ALTERA_AVALON_TIMER_STATUS_RUN_MSK ) != 0 )
+	{
+		/* Already running, started by the application. */
+		return;
+	}
+
+	IOWR_ALTERA_AVALON_TIMER_CONTROL( portRUN_TIME_TIMER_BASE, ALTERA_AVALON_TIMER_CONTROL_STOP_MSK );
+	IOWR_ALTERA_AVALON_TIMER_PERIODL( portRUN_TIME_TIMER_BASE, 0xFFFF );
+	IOWR_ALTERA_AVALON_TIMER_PERIODH( portRUN_TIME_TIMER_BASE, 0xFFFF );
+	IOWR_ALTERA_AVALON_TIMER_CONTROL( portRUN_TIME_TIMER_BASE, ALTERA_AVALON_TIMER_CONTROL_CONT_MSK | ALTERA_AVALON_TIMER_CONTROL_START_MSK );
+}
+/*-----------------------------------------------------------*/
+
+uint64_t ullPortGetRunTimeCounterValue( void )
+{
+uint32_t ulLow;
+
+	/* Must be called with interrupts disabled, as the kernel does, so the tick
+	interrupt cannot read the counter part way through an update. */
+	IOWR_ALTERA_AVALON_TIMER_SNAPL( portRUN_TIME_TIMER_BASE, 0 );
+	ulLow = ( ( ( uint32_t ) IORD_ALTERA_AVALON_TIMER_SNAPH( portRUN_TIME_TIMER_BASE ) & 0xFFFF ) << 16 ) | ( ( uint32_t ) IORD_ALTERA_AVALON_TIMER_SNAPL( portRUN_TIME_TIMER_BASE ) & 0xFFFF );
+
+	/* The timer counts down, so the elapsed count is the complement. */
+	ulLow = ~ulLow;
+
+	if( ulLow < ulLastRunTimeLow )
+	{
+		ulRunTimeHigh++;
+	}
+	ulLastRunTimeLow = ulLow;
+
+	return ( ( uint64_t ) ulRunTimeHigh << 32 ) | ( uint64_t ) ulLow;
+}
+/*-----------------------------------------------------------*/
+
+void vPortRunTimeTickInterrupt( void )
+{
+	uxTicksUntilRunTimeRead--;
+
+	if( uxTicksUntilRunTimeRead == 0 )
+	{
+		uxTicksUntilRunTimeRead = configTICK_RATE_HZ;
+		( void ) ullPortGetRunTimeCounterValue();
+	}
+}
+
+#endif /* configGENERATE_RUN_TIME_STATS */
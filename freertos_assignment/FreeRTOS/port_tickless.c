@@ -0,0 +1,200 @@
+/*
+ * Tickless idle for the Nios II port.  The host simulated port in host/port
+ * builds this file too, so the timer arithmetic it exercises is the same code
+ * that runs on the board.
+ *
+ * The tick comes from the TIMER1MS Avalon interval timer running in
+ * continuous mode with a period of one tick.  When the idle task finds that
+ * no task is due for at least configEXPECTED_IDLE_TIME_BEFORE_SLEEP ticks it
+ * calls vPortSuppressTicksAndSleep(), which stretches the timer period so the
+ * next timeout falls on the tick boundary at which the first blocked task is
+ * due, waits for any interrupt, then works out how many tick boundaries really
+ * passed and steps the tick count forward by that many.
+ *
+ * Writing the period registers of an Avalon timer also reloads its counter,
+ * so the one tick period cannot be queued up behind the stretched one.  The
+ * period is instead left at whatever brings the timer back onto the tick grid
+ * and vPortTicklessTickInterrupt() puts the one tick period back from the tick
+ * interrupt at the following boundary.  The counts that pass between that
+ * timeout and the rewrite are lost, so each sleep moves the tick grid later by
+ * the entry latency of the tick interrupt.  The tick count itself is never
+ * wrong.
+ */
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Altera includes. */
+#include "altera_avalon_timer_regs.h"
+
+#if( configUSE_TICKLESS_IDLE == 1 )
+
+#define portTICK_TIMER_BASE			TIMER1MS_BASE
+
+/* Timer counts in one tick.  The timer times out one count after reaching
+zero, so the period registers are always written with one less than the number
+of counts wanted. */
+#define portTIMER_COUNTS_PER_TICK	( ( uint32_t ) ( TIMER1MS_FREQ / configTICK_RATE_HZ ) )
+
+/* Number of counts the timer misses while it is stopped to be reprogrammed on
+the way into a sleep.  Leaving this at 0 lets the tick grid slip later by that
+many counts per sleep. */
+#ifndef portTICKLESS_STOPPED_COUNTS
+	#define portTICKLESS_STOPPED_COUNTS	0UL
+#endif
+
+#define portTIMER_RUN_CONTROL		( ALTERA_AVALON_TIMER_CONTROL_ITO_MSK | ALTERA_AVALON_TIMER_CONTROL_CONT_MSK | ALTERA_AVALON_TIMER_CONTROL_START_MSK )
+
+/* The 32-bit counter limits how many ticks one sleep can cover.  The run time
+statistics counter in port_runtime.c is extended to 64 bits in software and
+must be read more than once per wrap, so with statistics on a sleep is kept to
+half that. */
+#if( configGENERATE_RUN_TIME_STATS == 1 )
+	static const TickType_t xMaximumSuppressedTicks = ( TickType_t ) ( 0x7FFFFFFFUL / portTIMER_COUNTS_PER_TICK );
+#else
+	static const TickType_t xMaximumSuppressedTicks = ( TickType_t ) ( 0xFFFFFFFFUL / portTIMER_COUNTS_PER_TICK );
+#endif
+
+/* Number of tick interrupts still to be taken before the period is set back
+to one tick.  0 when the period already is one tick. */
+static volatile UBaseType_t uxTicksUntilPeriodRestore = 0;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Writes the period registers, which also stops the timer and loads the
+ * counter with ulPeriod.
+ */
+static void prvWritePeriod( uint32_t ulPeriod );
+
+/*
+ * Latches and returns the current counter value.
+ */
+static uint32_t prvReadCounter( void );
+
+/*-----------------------------------------------------------*/
+
+static void prvWritePeriod( uint32_t ulPeriod )
+{
+	IOWR_ALTERA_AVALON_TIMER_PERIODL( portTICK_TIMER_BASE, ulPeriod & 0xFFFF );
+	IOWR_ALTERA_AVALON_TIMER_PERIODH( portTICK_TIMER_BASE, ulPeriod >> 16 );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvReadCounter( void )
+{
+	IOWR_ALTERA_AVALON_TIMER_SNAPL( portTICK_TIMER_BASE, 0 );
+	return ( ( ( uint32_t ) IORD_ALTERA_AVALON_TIMER_SNAPH( portTICK_TIMER_BASE ) & 0xFFFF ) << 16 ) | ( ( uint32_t ) IORD_ALTERA_AVALON_TIMER_SNAPL( portTICK_TIMER_BASE ) & 0xFFFF );
+}
+/*-----------------------------------------------------------*/
+
+void vPortTicklessTickInterrupt( void )
+{
+	if( uxTicksUntilPeriodRestore > 0 )
+	{
+		uxTicksUntilPeriodRestore--;
+
+		if( uxTicksUntilPeriodRestore == 0 )
+		{
+			prvWritePeriod( portTIMER_COUNTS_PER_TICK - 1UL );
+			IOWR_ALTERA_AVALON_TIMER_CONTROL( portTICK_TIMER_BASE, portTIMER_RUN_CONTROL );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
+{
+uint32_t ulCountAtSleep, ulReload, ulCountAtWake, ulSinceTimeout;
+TickType_t xModifiableIdleTime, xCompleteTicks;
+
+	if( xExpectedIdleTime > xMaximumSuppressedTicks )
+	{
+		xExpectedIdleTime = xMaximumSuppressedTicks;
+	}
+
+	/* Stop the timer so the counter cannot move, or time out, while the
+	sleep period is worked out. */
+	portDISABLE_INTERRUPTS();
+	IOWR_ALTERA_AVALON_TIMER_CONTROL( portTICK_TIMER_BASE, ALTERA_AVALON_TIMER_CONTROL_STOP_MSK );
+	ulCountAtSleep = prvReadCounter();
+
+	#if( configGENERATE_RUN_TIME_STATS == 1 )
+	{
+		/* Start the sleep with a fresh reading so it cannot span a wrap. */
+		( void ) portGET_RUN_TIME_COUNTER_VALUE();
+	}
+	#endif
+
+	/* A tick that has timed out but not been handled, or a task readied by an
+	interrupt since the idle task looked, means there is nothing to gain from
+	sleeping.  Restart the timer from where it was stopped. */
+	if( ( ( IORD_ALTERA_AVALON_TIMER_STATUS( portTICK_TIMER_BASE ) & ALTERA_AVALON_TIMER_STATUS_TO_MSK ) != 0 ) ||
+		( eTaskConfirmSleepModeStatus() == eAbortSleep ) )
+	{
+		IOWR_ALTERA_AVALON_TIMER_CONTROL( portTICK_TIMER_BASE, portTIMER_RUN_CONTROL );
+		portENABLE_INTERRUPTS();
+		return;
+	}
+
+	/* The counter holds the counts to the next tick boundary less one.  Add
+	the whole ticks after that boundary that can be skipped. */
+	ulReload = ulCountAtSleep + ( portTIMER_COUNTS_PER_TICK * ( uint32_t ) ( xExpectedIdleTime - 1UL ) );
+	if( ulReload > portTICKLESS_STOPPED_COUNTS )
+	{
+		ulReload -= portTICKLESS_STOPPED_COUNTS;
+	}
+
+	prvWritePeriod( ulReload );
+	IOWR_ALTERA_AVALON_TIMER_CONTROL( portTICK_TIMER_BASE, portTIMER_RUN_CONTROL );
+
+	/* The sleep hooks may shorten the sleep to nothing, for example if they
+	find something to do. */
+	xModifiableIdleTime = xExpectedIdleTime;
+	configPRE_SLEEP_PROCESSING( xModifiableIdleTime );
+	if( xModifiableIdleTime > 0 )
+	{
+		portWAIT_FOR_INTERRUPT();
+	}
+	configPOST_SLEEP_PROCESSING( xExpectedIdleTime );
+
+	IOWR_ALTERA_AVALON_TIMER_CONTROL( portTICK_TIMER_BASE, ALTERA_AVALON_TIMER_CONTROL_STOP_MSK );
+	ulCountAtWake = prvReadCounter();
+
+	if( ( IORD_ALTERA_AVALON_TIMER_STATUS( portTICK_TIMER_BASE ) & ALTERA_AVALON_TIMER_STATUS_TO_MSK ) != 0 )
+	{
+		/* The whole sleep elapsed.  The timeout is left pending so the tick
+		interrupt accounts for the last tick, and the counter has already been
+		reloaded with the stretched period, so the counts since the timeout
+		come off the first normal tick. */
+		ulSinceTimeout = ulReload - ulCountAtWake;
+		if( ulSinceTimeout > ( portTIMER_COUNTS_PER_TICK - 1UL ) )
+		{
+			ulSinceTimeout = portTIMER_COUNTS_PER_TICK - 1UL;
+		}
+
+		vTaskStepTick( xExpectedIdleTime - 1 );
+		prvWritePeriod( ( portTIMER_COUNTS_PER_TICK - 1UL ) - ulSinceTimeout );
+
+		/* One interrupt for the pending timeout, one at the next boundary. */
+		uxTicksUntilPeriodRestore = 2;
+	}
+	else
+	{
+		/* Something other than the tick woke the processor.  The sleep ends on
+		a tick boundary ulCountAtWake + 1 counts from now, so every tick that
+		is not still partly ahead of that has already passed. */
+		xCompleteTicks = xExpectedIdleTime - ( TickType_t ) ( ( ulCountAtWake / portTIMER_COUNTS_PER_TICK ) + 1UL );
+		vTaskStepTick( xCompleteTicks );
+
+		/* Time out at the next tick boundary, then go back to one tick. */
+		prvWritePeriod( ulCountAtWake % portTIMER_COUNTS_PER_TICK );
+		uxTicksUntilPeriodRestore = 1;
+	}
+
+	IOWR_ALTERA_AVALON_TIMER_CONTROL( portTICK_TIMER_BASE, portTIMER_RUN_CONTROL );
+	portENABLE_INTERRUPTS();
+}
+
+#endif /* configUSE_TICKLESS_IDLE */
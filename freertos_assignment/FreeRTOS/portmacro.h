@@ -74,6 +74,12 @@
 extern "C" {
 #endif
 
+/* Host builds (see host/ at the top of the repository) supply their own port
+layer in place of the Nios II one below. */
+#if defined( portHOST_SIMULATION )
+	#include "portmacro_host.h"
+#else
+
 #include "sys/alt_irq.h"
 
 /*-----------------------------------------------------------
@@ -121,8 +127,18 @@ typedef unsigned long UBaseType_t;
 /*-----------------------------------------------------------*/
 
 extern void vTaskSwitchContext( void );
+extern volatile uint32_t ulPortYieldPending;
 #define portYIELD()									asm volatile ( "trap" );
-#define portEND_SWITCHING_ISR( xSwitchRequired ) 	if( xSwitchRequired ) 	vTaskSwitchContext()
+
+/* Interrupts only ask for a switch.  The exception exit code in port_asm.S
+makes it after the outermost handler has returned. */
+#define portEND_SWITCHING_ISR( xSwitchRequired ) 	if( xSwitchRequired ) 	ulPortYieldPending = 1UL
+#define portYIELD_FROM_ISR( xSwitchRequired )		portEND_SWITCHING_ISR( xSwitchRequired )
+
+/* Interrupt handlers run on a stack of their own, configISR_STACK_SIZE words
+long (port.c), so task stacks need not leave room for them.  Returns the number
+of words of it that have never been used. */
+extern UBaseType_t uxPortGetISRStackHighWaterMark( void );
 
 
 /* Include the port_asm.S file where the Context saving/restoring is defined. */
@@ -135,14 +151,114 @@ extern void vTaskExitCritical( void );
 
 #define portDISABLE_INTERRUPTS()	alt_irq_disable_all()
 #define portENABLE_INTERRUPTS()		alt_irq_enable_all( 0x01 );
+
+/* Save and restore the interrupt enable rather than force it on, for code
+such as the trace recorder that runs both in and out of interrupts. */
+#define portSET_INTERRUPT_MASK_FROM_ISR()						alt_irq_disable_all()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedStatusValue )	alt_irq_enable_all( uxSavedStatusValue )
 #define portENTER_CRITICAL()        vTaskEnterCritical()
 #define portEXIT_CRITICAL()         vTaskExitCritical()
 /*-----------------------------------------------------------*/
 
+/* Tickless idle, implemented in port_tickless.c. */
+#if( configUSE_TICKLESS_IDLE == 1 )
+	extern void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime );
+	extern void vPortTicklessTickInterrupt( void );
+	#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) vPortSuppressTicksAndSleep( xExpectedIdleTime )
+#endif
+
+/* Run time statistics clock, implemented in port_runtime.c. */
+#if( configGENERATE_RUN_TIME_STATS == 1 )
+	extern void vPortConfigureRunTimeCounter( void );
+	extern uint64_t ullPortGetRunTimeCounterValue( void );
+	extern void vPortRunTimeTickInterrupt( void );
+	#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()	vPortConfigureRunTimeCounter()
+	#define portGET_RUN_TIME_COUNTER_VALUE()			ullPortGetRunTimeCounterValue()
+	#define portRUN_TIME_COUNTER_HZ						TIMER1US_FREQ
+#endif
+
+/* The Nios II has no wait for interrupt instruction, so this spins until an
+enabled interrupt is pending.  ipending is readable with interrupts disabled. */
+#define portWAIT_FOR_INTERRUPT()									\
+{																	\
+	uint32_t ulPending;												\
+	do																\
+	{																\
+		NIOS2_READ_IPENDING( ulPending );							\
+	} while( ulPending == 0 );										\
+}
+/*-----------------------------------------------------------*/
+
 /* Task function macros as described on the FreeRTOS.org WEB site. */
 #define portTASK_FUNCTION_PROTO( vFunction, pvParameters ) void vFunction( void *pvParameters )
 #define portTASK_FUNCTION( vFunction, pvParameters ) void vFunction( void *pvParameters )
 
+#endif /* portHOST_SIMULATION */
+
+/*-----------------------------------------------------------*/
+
+/* Interrupt priorities, shared with the host port.  An interrupt handler is
+only interrupted by an interrupt of a higher priority.  Every interrupt starts
+at configKERNEL_INTERRUPT_PRIORITY, the priority of the tick, and those that
+call the ...FromISR() API must stay at or below
+configMAX_SYSCALL_INTERRUPT_PRIORITY.  Critical sections still mask every
+interrupt. */
+extern void vPortSetInterruptPriority( uint32_t ulIrq, UBaseType_t uxPriority );
+
+/* Priority of the interrupt being handled, 0 while a task is running. */
+extern volatile UBaseType_t uxPortInterruptPriority;
+
+#define portASSERT_IF_INTERRUPT_PRIORITY_INVALID()	configASSERT( uxPortInterruptPriority <= configMAX_SYSCALL_INTERRUPT_PRIORITY )
+
+/*-----------------------------------------------------------*/
+
+/* Port optimised task selection, shared with the host port so that it can be
+benchmarked there.  Bit n of uxTopReadyPriority is set while the ready list for
+priority n is not empty, and the highest priority with a ready task is found by
+counting the leading zeros of that bitmap.  The Nios II has no count leading
+zeros instruction, so ulPortCountLeadingZeros() looks the answer up a byte at a
+time in ucPortCountLeadingZeros[] (port_select.c).  With twelve priorities that
+is two compares and one table read, however many priorities are empty. */
+#if( configUSE_PORT_OPTIMISED_TASK_SELECTION == 1 )
+
+	/* Check the configuration. */
+	#if( configMAX_PRIORITIES > 32 )
+		#error configUSE_PORT_OPTIMISED_TASK_SELECTION can only be set to 1 when configMAX_PRIORITIES is less than or equal to 32.
+	#endif
+
+	/* Leading zeros of each byte value, 8 for zero. */
+	extern const uint8_t ucPortCountLeadingZeros[ 256 ];
+
+	static inline uint32_t ulPortCountLeadingZeros( uint32_t ulBitmap )
+	{
+		if( ulBitmap >= 0x10000UL )
+		{
+			if( ulBitmap >= 0x1000000UL )
+			{
+				return ( uint32_t ) ucPortCountLeadingZeros[ ulBitmap >> 24 ];
+			}
+
+			return 8UL + ( uint32_t ) ucPortCountLeadingZeros[ ulBitmap >> 16 ];
+		}
+
+		if( ulBitmap >= 0x100UL )
+		{
+			return 16UL + ( uint32_t ) ucPortCountLeadingZeros[ ulBitmap >> 8 ];
+		}
+
+		return 24UL + ( uint32_t ) ucPortCountLeadingZeros[ ulBitmap ];
+	}
+
+	/* Store/clear the ready priorities in a bit map. */
+	#define portRECORD_READY_PRIORITY( uxPriority, uxReadyPriorities ) ( uxReadyPriorities ) |= ( 1UL << ( uxPriority ) )
+	#define portRESET_READY_PRIORITY( uxPriority, uxReadyPriorities ) ( uxReadyPriorities ) &= ~( 1UL << ( uxPriority ) )
+
+	/*-----------------------------------------------------------*/
+
+	#define portGET_HIGHEST_PRIORITY( uxTopPriority, uxReadyPriorities ) uxTopPriority = ( 31UL - ulPortCountLeadingZeros( ( uint32_t ) ( uxReadyPriorities ) ) )
+
+#endif /* configUSE_PORT_OPTIMISED_TASK_SELECTION */
+
 #ifdef __cplusplus
 }
 #endif
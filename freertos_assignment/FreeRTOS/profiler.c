@@ -0,0 +1,208 @@
+/*
+ * Statistical PC sampling profiler.  See profiler.h.
+ *
+ * The buckets are an open addressed hash table keyed on the task, the
+ * interrupt and the PC.  A sample probes at most configPROFILER_MAX_PROBES
+ * buckets from where its key hashes to, so the time it takes in the tick
+ * interrupt is bounded however full the table gets; a sample that finds
+ * neither its own bucket nor a free one is only counted as dropped.
+ * configPROFILER_BUCKETS must be a power of two.
+ */
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "profiler.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( configUSE_PROFILER == 1 )
+
+#if( ( configPROFILER_BUCKETS & ( configPROFILER_BUCKETS - 1 ) ) != 0 )
+	#error configPROFILER_BUCKETS must be a power of two.
+#endif
+
+#if( configPROFILER_BUCKETS > 65536 )
+	#error configPROFILER_BUCKETS must be 65536 or less.
+#endif
+
+#define profilerBUCKET_MASK		( ( uint32_t ) configPROFILER_BUCKETS - 1UL )
+
+static ProfilerBucket_t xProfilerBuckets[ configPROFILER_BUCKETS ];
+static ProfilerStats_t xProfilerStats;
+
+/* Sampling starts at boot. */
+static volatile BaseType_t xProfilerRunning = pdTRUE;
+
+/* Set by vProfilerClaimSampleFromISR() for the next sample. */
+static uint32_t ulProfilerClaimedInterrupt = profilerNO_INTERRUPT;
+static uintptr_t uxProfilerClaimedPC = 0;
+
+/* For the task names in the dump. */
+static TaskStatus_t xProfilerTasks[ configPROFILER_MAX_TASKS ];
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Returns the bucket for the key, taking a free one if it has none, or NULL
+ * if neither is within configPROFILER_MAX_PROBES.
+ */
+static ProfilerBucket_t *prvFindBucket( uintptr_t uxPC, uint8_t ucTask, uint8_t ucInterrupt );
+
+/*-----------------------------------------------------------*/
+
+static ProfilerBucket_t *prvFindBucket( uintptr_t uxPC, uint8_t ucTask, uint8_t ucInterrupt )
+{
+ProfilerBucket_t *pxBucket;
+uint32_t ulHash, ulProbe;
+
+	/* Instructions are word aligned, so the low two bits of the PC carry
+	nothing.  The multiply spreads neighbouring PCs across the table and the
+	high half of the product is the best mixed. */
+	ulHash = ( ( uint32_t ) ( uxPC >> 2 ) ^ ( ( uint32_t ) ucTask << 16 ) ^ ( ( uint32_t ) ucInterrupt << 24 ) ) * 2654435761UL;
+	ulHash >>= 16;
+
+	for( ulProbe = 0; ulProbe < configPROFILER_MAX_PROBES; ulProbe++ )
+	{
+		pxBucket = &( xProfilerBuckets[ ( ulHash + ulProbe ) & profilerBUCKET_MASK ] );
+
+		if( pxBucket->ulCount == 0UL )
+		{
+			pxBucket->uxPC = uxPC;
+			pxBucket->ucTask = ucTask;
+			pxBucket->ucInterrupt = ucInterrupt;
+			xProfilerStats.ulBucketsUsed++;
+			return pxBucket;
+		}
+
+		if( ( pxBucket->uxPC == uxPC ) && ( pxBucket->ucTask == ucTask ) && ( pxBucket->ucInterrupt == ucInterrupt ) )
+		{
+			return pxBucket;
+		}
+	}
+
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+void vProfilerSampleFromISR( uintptr_t uxPC )
+{
+ProfilerBucket_t *pxBucket;
+uint8_t ucInterrupt = profilerNO_INTERRUPT;
+
+	/* A claim is for this sample only, whether or not it is counted. */
+	if( ulProfilerClaimedInterrupt != profilerNO_INTERRUPT )
+	{
+		ucInterrupt = ( uint8_t ) ulProfilerClaimedInterrupt;
+		uxPC = uxProfilerClaimedPC;
+		ulProfilerClaimedInterrupt = profilerNO_INTERRUPT;
+	}
+
+	if( xProfilerRunning == pdFALSE )
+	{
+		return;
+	}
+
+	pxBucket = prvFindBucket( uxPC, ( uint8_t ) uxTaskGetCurrentTCBNumberFromISR(), ucInterrupt );
+
+	if( pxBucket == NULL )
+	{
+		xProfilerStats.ulDropped++;
+		return;
+	}
+
+	pxBucket->ulCount++;
+	xProfilerStats.ulSamples++;
+
+	if( ucInterrupt != profilerNO_INTERRUPT )
+	{
+		xProfilerStats.ulInterruptSamples++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vProfilerClaimSampleFromISR( uint32_t ulInterrupt, uintptr_t uxHandler )
+{
+	/* A nested handler returns first, and if it saw the tick time out the
+	handler it interrupted did not see it happen while it ran itself. */
+	if( ulProfilerClaimedInterrupt == profilerNO_INTERRUPT )
+	{
+		ulProfilerClaimedInterrupt = ulInterrupt;
+		uxProfilerClaimedPC = uxHandler;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vProfilerStart( void )
+{
+	xProfilerRunning = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void vProfilerStop( void )
+{
+	xProfilerRunning = pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vProfilerClear( void )
+{
+BaseType_t xWasRunning = xProfilerRunning;
+
+	/* The tick leaves the table alone while it is stopped, so it can be
+	cleared without masking interrupts for the length of the memset(). */
+	xProfilerRunning = pdFALSE;
+	memset( xProfilerBuckets, 0, sizeof( xProfilerBuckets ) );
+	memset( &xProfilerStats, 0, sizeof( xProfilerStats ) );
+	xProfilerRunning = xWasRunning;
+}
+/*-----------------------------------------------------------*/
+
+void vProfilerGetStats( ProfilerStats_t *pxStats )
+{
+	taskENTER_CRITICAL();
+	{
+		*pxStats = xProfilerStats;
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void vProfilerDump( ProfilerPrintFunction_t pxPrint )
+{
+UBaseType_t uxTasks, uxTask;
+uint32_t ulIndex;
+const ProfilerBucket_t *pxBucket;
+
+	/* Version, samples a second, samples counted, of those inside a handler,
+	samples dropped and buckets used. */
+	pxPrint( "PROFILE %d %lu %lu %lu %lu %lu\n", profilerDUMP_VERSION, ( unsigned long ) configTICK_RATE_HZ,
+			( unsigned long ) xProfilerStats.ulSamples, ( unsigned long ) xProfilerStats.ulInterruptSamples,
+			( unsigned long ) xProfilerStats.ulDropped, ( unsigned long ) xProfilerStats.ulBucketsUsed );
+
+	uxTasks = uxTaskGetSystemState( xProfilerTasks, configPROFILER_MAX_TASKS, NULL );
+	for( uxTask = 0; uxTask < uxTasks; uxTask++ )
+	{
+		pxPrint( "T %lu %s\n", ( unsigned long ) xProfilerTasks[ uxTask ].xTaskNumber, xProfilerTasks[ uxTask ].pcTaskName );
+	}
+
+	for( ulIndex = 0; ulIndex < configPROFILER_BUCKETS; ulIndex++ )
+	{
+		pxBucket = &( xProfilerBuckets[ ulIndex ] );
+		if( pxBucket->ulCount != 0UL )
+		{
+			pxPrint( "S %02x %02x %08lx %lu\n", ( unsigned ) pxBucket->ucTask, ( unsigned ) pxBucket->ucInterrupt,
+					( unsigned long ) pxBucket->uxPC, ( unsigned long ) pxBucket->ulCount );
+		}
+	}
+
+	pxPrint( "END\n" );
+}
+
+#endif /* configUSE_PROFILER */
@@ -0,0 +1,117 @@
+/*
+ * Statistical PC sampling profiler.
+ *
+ * When configUSE_PROFILER is 1 the port takes a sample on every tick: the PC
+ * the tick interrupted, the number of the task that was running and, if the
+ * tick fell inside another interrupt's handler, that interrupt.  Samples are
+ * counted in a fixed table of configPROFILER_BUCKETS buckets, one for each
+ * task, interrupt and PC seen, so nothing is allocated and a sample takes a
+ * bounded time.  vProfilerDump() prints the table for host/tools/profile_fold,
+ * which maps the PCs to functions with the image's symbols and writes folded
+ * stacks for a flame graph of each task.
+ *
+ * The tick is the lowest priority interrupt, so it is never taken inside
+ * another handler.  Instead the port checks, as each handler returns, whether
+ * the tick timer timed out while it ran and not before.  If it did the sample
+ * belongs to that handler, and is counted against the handler's entry point
+ * since the PC it was at is gone by then.
+ *
+ * Sampling on the tick sees a task in proportion to the time it runs, except a
+ * task that always starts just after a tick and finishes before the next one,
+ * such as a short job in a vTaskDelay() loop, which is never seen.  Ticks
+ * skipped by tickless idle are not sampled either, so the idle task is under
+ * counted unless configUSE_TICKLESS_IDLE is 0.  A handler that runs for more
+ * than a tick period loses a tick, as the timer has only one TO bit, and with
+ * it a sample, so it is under counted too.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Version of the text produced by vProfilerDump(). */
+#define profilerDUMP_VERSION		1
+
+/* ucInterrupt of a sample taken while a task was running. */
+#define profilerNO_INTERRUPT		0xFF
+
+/* One bucket: the samples with the same task, interrupt and PC.  12 bytes on
+the Nios II. */
+typedef struct xPROFILER_BUCKET
+{
+	uintptr_t uxPC;
+	uint32_t ulCount;				/*<< 0 for a bucket not yet used. */
+	uint8_t ucTask;					/*<< Task number, as uxTaskGetSystemState() gives it. */
+	uint8_t ucInterrupt;			/*<< profilerNO_INTERRUPT, or the interrupt whose handler uxPC is. */
+} ProfilerBucket_t;
+
+/* Counts returned by vProfilerGetStats(). */
+typedef struct xPROFILER_STATS
+{
+	uint32_t ulSamples;				/*<< Counted in a bucket. */
+	uint32_t ulInterruptSamples;	/*<< Of those, taken inside a handler. */
+	uint32_t ulDropped;				/*<< Found no free bucket within configPROFILER_MAX_PROBES. */
+	uint32_t ulBucketsUsed;
+} ProfilerStats_t;
+
+/* printf() or anything that behaves like it. */
+typedef int ( *ProfilerPrintFunction_t )( const char *pcFormat, ... );
+
+/**
+ * profiler. h
+ * <pre>
+ void vProfilerStart( void );
+ void vProfilerStop( void );
+ void vProfilerClear( void );
+ * </pre>
+ *
+ * Sampling starts at boot.  vProfilerStop() holds the table still, for a
+ * dump, vProfilerStart() carries on counting and vProfilerClear() empties it.
+ */
+void vProfilerStart( void );
+void vProfilerStop( void );
+void vProfilerClear( void );
+
+/**
+ * profiler. h
+ * <pre>
+ void vProfilerGetStats( ProfilerStats_t *pxStats );
+ * </pre>
+ */
+void vProfilerGetStats( ProfilerStats_t *pxStats );
+
+/**
+ * profiler. h
+ * <pre>
+ void vProfilerDump( ProfilerPrintFunction_t pxPrint );
+ * </pre>
+ *
+ * Prints the table between a "PROFILE" and an "END" line.  The lines in
+ * between start with "T" (a task number and name) or "S" (the task, the
+ * interrupt and the PC of a bucket in hex, then its count).  Stop the profiler
+ * first or the counts may move during the dump.  The dump goes at the speed
+ * of pxPrint, so call it from a low priority task.
+ */
+void vProfilerDump( ProfilerPrintFunction_t pxPrint );
+
+/*
+ * Called by the port with interrupts masked.  Not for application use.
+ *
+ * vProfilerSampleFromISR() is called on each tick with the PC the tick
+ * interrupted.  vProfilerClaimSampleFromISR() is called when a handler
+ * returns having seen the tick time out while it ran, with the interrupt and
+ * the handler's address; the next sample is then counted against them.
+ */
+void vProfilerSampleFromISR( uintptr_t uxPC );
+void vProfilerClaimSampleFromISR( uint32_t ulInterrupt, uintptr_t uxHandler );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROFILER_H */
@@ -158,12 +158,23 @@ typedef struct QueueDefinition
 		struct QueueDefinition *pxQueueSetContainer;
 	#endif
 
+	#if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+		uint8_t ucStaticallyAllocated;	/*< Set to pdTRUE if the memory used by the queue was supplied by the application, so it is not freed when the queue is deleted. */
+	#endif
+
 } xQUEUE;
 
 /* The old xQUEUE name is maintained above then typedefed to the new Queue_t
 name below to enable the use of older kernel aware debuggers. */
 typedef xQUEUE Queue_t;
 
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+	/* StaticQueue_t (FreeRTOS.h) must be kept the same size as the queue
+	structure it stands in for.  This fails to compile if the two have drifted
+	apart. */
+	typedef char queueSTATIC_QUEUE_SIZE_CHECK[ ( sizeof( StaticQueue_t ) == sizeof( Queue_t ) ) ? 1 : -1 ];
+#endif
+
 /*-----------------------------------------------------------*/
 
 /*
@@ -228,6 +239,18 @@ static BaseType_t prvCopyDataToQueue( Queue_t * const pxQueue, const void *pvIte
  */
 static void prvCopyDataFromQueue( Queue_t * const pxQueue, void * const pvBuffer ) PRIVILEGED_FUNCTION;
 
+#if ( configUSE_QUEUE_SIZED_COPY == 1 )
+	/*
+	 * Copies an item of 4, 8, 12 or 16 bytes between word aligned buffers one
+	 * word at a time, and anything else with memcpy().
+	 */
+	static void prvCopyItem( void * const pvDest, const void * const pvSource, const UBaseType_t uxItemSize ) PRIVILEGED_FUNCTION;
+
+	#define queueCOPY_ITEM( pvDest, pvSource, uxItemSize )	prvCopyItem( ( pvDest ), ( pvSource ), ( uxItemSize ) )
+#else
+	#define queueCOPY_ITEM( pvDest, pvSource, uxItemSize )	( void ) memcpy( ( pvDest ), ( pvSource ), ( size_t ) ( uxItemSize ) )
+#endif
+
 #if ( configUSE_QUEUE_SETS == 1 )
 	/*
 	 * Checks to see if a queue is a member of a queue set, and if so, notifies
@@ -236,6 +259,21 @@ static void prvCopyDataFromQueue( Queue_t * const pxQueue, void * const pvBuffer
 	static BaseType_t prvNotifyQueueSetContainer( const Queue_t * const pxQueue, const BaseType_t xCopyPosition ) PRIVILEGED_FUNCTION;
 #endif
 
+/*
+ * Sets up a newly created queue in memory that has already been obtained,
+ * either from the heap or from the application.  pucQueueStorage is NULL when
+ * uxItemSize is 0.
+ */
+static void prvInitialiseNewQueue( const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, uint8_t *pucQueueStorage, const uint8_t ucQueueType, Queue_t *pxNewQueue ) PRIVILEGED_FUNCTION;
+
+#if ( configUSE_MUTEXES == 1 )
+	/*
+	 * Sets up a newly created queue structure to be used as a mutex, then gives
+	 * the mutex so it starts available.
+	 */
+	static void prvInitialiseMutex( Queue_t *pxNewQueue, const uint8_t ucQueueType ) PRIVILEGED_FUNCTION;
+#endif
+
 /*-----------------------------------------------------------*/
 
 /*
@@ -310,148 +348,235 @@ Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 }
 /*-----------------------------------------------------------*/
 
-QueueHandle_t xQueueGenericCreate( const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, const uint8_t ucQueueType )
+static void prvInitialiseNewQueue( const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, uint8_t *pucQueueStorage, const uint8_t ucQueueType, Queue_t *pxNewQueue )
 {
-Queue_t *pxNewQueue;
-size_t xQueueSizeInBytes;
-QueueHandle_t xReturn = NULL;
-int8_t *pcAllocatedBuffer;
-
 	/* Remove compiler warnings about unused parameters should
 	configUSE_TRACE_FACILITY not be set to 1. */
 	( void ) ucQueueType;
 
-	configASSERT( uxQueueLength > ( UBaseType_t ) 0 );
-
 	if( uxItemSize == ( UBaseType_t ) 0 )
 	{
-		/* There is not going to be a queue storage area. */
-		xQueueSizeInBytes = ( size_t ) 0;
+		/* No RAM was allocated for the queue storage area, but PC head
+		cannot be set to NULL because NULL is used as a key to say the queue
+		is used as a mutex.  Therefore just set pcHead to point to the queue
+		as a benign value that is known to be within the memory map. */
+		pxNewQueue->pcHead = ( int8_t * ) pxNewQueue;
 	}
 	else
 	{
-		/* The queue is one byte longer than asked for to make wrap checking
-		easier/faster. */
-		xQueueSizeInBytes = ( size_t ) ( uxQueueLength * uxItemSize ) + ( size_t ) 1; /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+		pxNewQueue->pcHead = ( int8_t * ) pucQueueStorage;
+	}
+
+	/* Initialise the queue members as described above where the queue type
+	is defined. */
+	pxNewQueue->uxLength = uxQueueLength;
+	pxNewQueue->uxItemSize = uxItemSize;
+	( void ) xQueueGenericReset( pxNewQueue, pdTRUE );
+
+	#if ( configUSE_TRACE_FACILITY == 1 )
+	{
+		pxNewQueue->ucQueueType = ucQueueType;
 	}
+	#endif /* configUSE_TRACE_FACILITY */
 
-	/* Allocate the new queue structure and storage area. */
-	pcAllocatedBuffer = ( int8_t * ) pvPortMalloc( sizeof( Queue_t ) + xQueueSizeInBytes );
+	#if( configUSE_QUEUE_SETS == 1 )
+	{
+		pxNewQueue->pxQueueSetContainer = NULL;
+	}
+	#endif /* configUSE_QUEUE_SETS */
+
+	traceQUEUE_CREATE( pxNewQueue );
+}
+/*-----------------------------------------------------------*/
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
 
-	if( pcAllocatedBuffer != NULL )
+	QueueHandle_t xQueueGenericCreate( const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, const uint8_t ucQueueType )
 	{
-		pxNewQueue = ( Queue_t * ) pcAllocatedBuffer; /*lint !e826 MISRA The buffer cannot be to small because it was dimensioned by sizeof( Queue_t ) + xQueueSizeInBytes. */
+	Queue_t *pxNewQueue;
+	size_t xQueueSizeInBytes;
+	QueueHandle_t xReturn = NULL;
+	int8_t *pcAllocatedBuffer;
+
+		configASSERT( uxQueueLength > ( UBaseType_t ) 0 );
 
 		if( uxItemSize == ( UBaseType_t ) 0 )
 		{
-			/* No RAM was allocated for the queue storage area, but PC head
-			cannot be set to NULL because NULL is used as a key to say the queue
-			is used as a mutex.  Therefore just set pcHead to point to the queue
-			as a benign value that is known to be within the memory map. */
-			pxNewQueue->pcHead = ( int8_t * ) pxNewQueue;
+			/* There is not going to be a queue storage area. */
+			xQueueSizeInBytes = ( size_t ) 0;
 		}
 		else
 		{
-			/* Jump past the queue structure to find the location of the queue
-			storage area - adding the padding bytes to get a better alignment. */
-			pxNewQueue->pcHead = pcAllocatedBuffer + sizeof( Queue_t );
+			/* The queue is one byte longer than asked for to make wrap checking
+			easier/faster. */
+			xQueueSizeInBytes = ( size_t ) ( uxQueueLength * uxItemSize ) + ( size_t ) 1; /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
 		}
 
-		/* Initialise the queue members as described above where the queue type
-		is defined. */
-		pxNewQueue->uxLength = uxQueueLength;
-		pxNewQueue->uxItemSize = uxItemSize;
-		( void ) xQueueGenericReset( pxNewQueue, pdTRUE );
+		/* Allocate the new queue structure and storage area. */
+		pcAllocatedBuffer = ( int8_t * ) pvPortMalloc( sizeof( Queue_t ) + xQueueSizeInBytes );
 
-		#if ( configUSE_TRACE_FACILITY == 1 )
+		if( pcAllocatedBuffer != NULL )
 		{
-			pxNewQueue->ucQueueType = ucQueueType;
-		}
-		#endif /* configUSE_TRACE_FACILITY */
+			pxNewQueue = ( Queue_t * ) pcAllocatedBuffer; /*lint !e826 MISRA The buffer cannot be to small because it was dimensioned by sizeof( Queue_t ) + xQueueSizeInBytes. */
 
-		#if( configUSE_QUEUE_SETS == 1 )
+			/* The storage area follows the queue structure. */
+			prvInitialiseNewQueue( uxQueueLength, uxItemSize, ( uint8_t * ) ( pcAllocatedBuffer + sizeof( Queue_t ) ), ucQueueType, pxNewQueue );
+
+			#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+			{
+				pxNewQueue->ucStaticallyAllocated = pdFALSE;
+			}
+			#endif /* configSUPPORT_STATIC_ALLOCATION */
+
+			xReturn = pxNewQueue;
+		}
+		else
 		{
-			pxNewQueue->pxQueueSetContainer = NULL;
+			mtCOVERAGE_TEST_MARKER();
 		}
-		#endif /* configUSE_QUEUE_SETS */
 
-		traceQUEUE_CREATE( pxNewQueue );
-		xReturn = pxNewQueue;
+		configASSERT( xReturn );
+
+		return xReturn;
 	}
-	else
+
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+/*-----------------------------------------------------------*/
+
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+
+	QueueHandle_t xQueueGenericCreateStatic( const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, uint8_t *pucQueueStorage, StaticQueue_t *pxStaticQueue, const uint8_t ucQueueType )
 	{
-		mtCOVERAGE_TEST_MARKER();
-	}
+	Queue_t *pxNewQueue = NULL;
 
-	configASSERT( xReturn );
+		configASSERT( uxQueueLength > ( UBaseType_t ) 0 );
+		configASSERT( pxStaticQueue != NULL );
 
-	return xReturn;
-}
+		/* A storage area must be supplied if, and only if, items have a size. */
+		configASSERT( !( ( pucQueueStorage != NULL ) && ( uxItemSize == 0 ) ) );
+		configASSERT( !( ( pucQueueStorage == NULL ) && ( uxItemSize != 0 ) ) );
+
+		if( ( pxStaticQueue != NULL ) && ( ( pucQueueStorage != NULL ) || ( uxItemSize == ( UBaseType_t ) 0 ) ) )
+		{
+			pxNewQueue = ( Queue_t * ) pxStaticQueue;
+			prvInitialiseNewQueue( uxQueueLength, uxItemSize, pucQueueStorage, ucQueueType, pxNewQueue );
+			pxNewQueue->ucStaticallyAllocated = pdTRUE;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		return ( QueueHandle_t ) pxNewQueue;
+	}
+
+#endif /* configSUPPORT_STATIC_ALLOCATION */
 /*-----------------------------------------------------------*/
 
 #if ( configUSE_MUTEXES == 1 )
 
-	QueueHandle_t xQueueCreateMutex( const uint8_t ucQueueType )
+	static void prvInitialiseMutex( Queue_t *pxNewQueue, const uint8_t ucQueueType )
 	{
-	Queue_t *pxNewQueue;
-
 		/* Prevent compiler warnings about unused parameters if
 		configUSE_TRACE_FACILITY does not equal 1. */
 		( void ) ucQueueType;
 
+		/* Information required for priority inheritance. */
+		pxNewQueue->pxMutexHolder = NULL;
+		pxNewQueue->uxQueueType = queueQUEUE_IS_MUTEX;
+
+		/* Queues used as a mutex no data is actually copied into or out
+		of the queue. */
+		pxNewQueue->pcWriteTo = NULL;
+		pxNewQueue->u.pcReadFrom = NULL;
+
+		/* Each mutex has a length of 1 (like a binary semaphore) and
+		an item size of 0 as nothing is actually copied into or out
+		of the mutex. */
+		pxNewQueue->uxMessagesWaiting = ( UBaseType_t ) 0U;
+		pxNewQueue->uxLength = ( UBaseType_t ) 1U;
+		pxNewQueue->uxItemSize = ( UBaseType_t ) 0U;
+		pxNewQueue->xRxLock = queueUNLOCKED;
+		pxNewQueue->xTxLock = queueUNLOCKED;
+
+		#if ( configUSE_TRACE_FACILITY == 1 )
+		{
+			pxNewQueue->ucQueueType = ucQueueType;
+		}
+		#endif
+
+		#if ( configUSE_QUEUE_SETS == 1 )
+		{
+			pxNewQueue->pxQueueSetContainer = NULL;
+		}
+		#endif
+
+		/* Ensure the event queues start with the correct state. */
+		vListInitialise( &( pxNewQueue->xTasksWaitingToSend ) );
+		vListInitialise( &( pxNewQueue->xTasksWaitingToReceive ) );
+
+		traceCREATE_MUTEX( pxNewQueue );
+
+		/* Start with the semaphore in the expected state. */
+		( void ) xQueueGenericSend( pxNewQueue, NULL, ( TickType_t ) 0U, queueSEND_TO_BACK );
+	}
+
+#endif /* configUSE_MUTEXES */
+/*-----------------------------------------------------------*/
+
+#if ( ( configUSE_MUTEXES == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+
+	QueueHandle_t xQueueCreateMutex( const uint8_t ucQueueType )
+	{
+	Queue_t *pxNewQueue;
+
 		/* Allocate the new queue structure. */
 		pxNewQueue = ( Queue_t * ) pvPortMalloc( sizeof( Queue_t ) );
 		if( pxNewQueue != NULL )
 		{
-			/* Information required for priority inheritance. */
-			pxNewQueue->pxMutexHolder = NULL;
-			pxNewQueue->uxQueueType = queueQUEUE_IS_MUTEX;
-
-			/* Queues used as a mutex no data is actually copied into or out
-			of the queue. */
-			pxNewQueue->pcWriteTo = NULL;
-			pxNewQueue->u.pcReadFrom = NULL;
-
-			/* Each mutex has a length of 1 (like a binary semaphore) and
-			an item size of 0 as nothing is actually copied into or out
-			of the mutex. */
-			pxNewQueue->uxMessagesWaiting = ( UBaseType_t ) 0U;
-			pxNewQueue->uxLength = ( UBaseType_t ) 1U;
-			pxNewQueue->uxItemSize = ( UBaseType_t ) 0U;
-			pxNewQueue->xRxLock = queueUNLOCKED;
-			pxNewQueue->xTxLock = queueUNLOCKED;
-
-			#if ( configUSE_TRACE_FACILITY == 1 )
+			#if( configSUPPORT_STATIC_ALLOCATION == 1 )
 			{
-				pxNewQueue->ucQueueType = ucQueueType;
+				pxNewQueue->ucStaticallyAllocated = pdFALSE;
 			}
-			#endif
+			#endif /* configSUPPORT_STATIC_ALLOCATION */
 
-			#if ( configUSE_QUEUE_SETS == 1 )
-			{
-				pxNewQueue->pxQueueSetContainer = NULL;
-			}
-			#endif
+			prvInitialiseMutex( pxNewQueue, ucQueueType );
+		}
+		else
+		{
+			( void ) ucQueueType;
+			traceCREATE_MUTEX_FAILED();
+		}
 
-			/* Ensure the event queues start with the correct state. */
-			vListInitialise( &( pxNewQueue->xTasksWaitingToSend ) );
-			vListInitialise( &( pxNewQueue->xTasksWaitingToReceive ) );
+		configASSERT( pxNewQueue );
+		return pxNewQueue;
+	}
+
+#endif /* ( configUSE_MUTEXES == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) */
+/*-----------------------------------------------------------*/
+
+#if ( ( configUSE_MUTEXES == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 1 ) )
+
+	QueueHandle_t xQueueCreateMutexStatic( const uint8_t ucQueueType, StaticQueue_t *pxStaticQueue )
+	{
+	Queue_t *pxNewQueue = ( Queue_t * ) pxStaticQueue;
 
-			traceCREATE_MUTEX( pxNewQueue );
+		configASSERT( pxNewQueue );
 
-			/* Start with the semaphore in the expected state. */
-			( void ) xQueueGenericSend( pxNewQueue, NULL, ( TickType_t ) 0U, queueSEND_TO_BACK );
+		if( pxNewQueue != NULL )
+		{
+			pxNewQueue->ucStaticallyAllocated = pdTRUE;
+			prvInitialiseMutex( pxNewQueue, ucQueueType );
 		}
 		else
 		{
 			traceCREATE_MUTEX_FAILED();
 		}
 
-		configASSERT( pxNewQueue );
 		return pxNewQueue;
 	}
 
-#endif /* configUSE_MUTEXES */
+#endif /* ( configUSE_MUTEXES == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 1 ) */
 /*-----------------------------------------------------------*/
 
 #if ( ( configUSE_MUTEXES == 1 ) && ( INCLUDE_xSemaphoreGetMutexHolder == 1 ) )
@@ -581,7 +706,7 @@ int8_t *pcAllocatedBuffer;
 #endif /* configUSE_RECURSIVE_MUTEXES */
 /*-----------------------------------------------------------*/
 
-#if ( configUSE_COUNTING_SEMAPHORES == 1 )
+#if ( ( configUSE_COUNTING_SEMAPHORES == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
 
 	QueueHandle_t xQueueCreateCountingSemaphore( const UBaseType_t uxMaxCount, const UBaseType_t uxInitialCount )
 	{
@@ -607,7 +732,7 @@ int8_t *pcAllocatedBuffer;
 		return xHandle;
 	}
 
-#endif /* configUSE_COUNTING_SEMAPHORES */
+#endif /* ( configUSE_COUNTING_SEMAPHORES == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) */
 /*-----------------------------------------------------------*/
 
 BaseType_t xQueueGenericSend( QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait, const BaseType_t xCopyPosition )
@@ -1746,7 +1871,23 @@ Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 		vQueueUnregisterQueue( pxQueue );
 	}
 	#endif
-	vPortFree( pxQueue );
+
+	#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+	{
+		#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+			/* Nothing to free if the application supplied the memory. */
+			if( pxQueue->ucStaticallyAllocated == pdFALSE )
+		#endif /* configSUPPORT_STATIC_ALLOCATION */
+		{
+			vPortFree( pxQueue );
+		}
+	}
+	#else
+	{
+		/* The queue can only have been supplied by the application. */
+		( void ) pxQueue;
+	}
+	#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
 }
 /*-----------------------------------------------------------*/
 
@@ -1803,7 +1944,7 @@ BaseType_t xReturn = pdFALSE;
 	}
 	else if( xPosition == queueSEND_TO_BACK )
 	{
-		( void ) memcpy( ( void * ) pxQueue->pcWriteTo, pvItemToQueue, ( size_t ) pxQueue->uxItemSize ); /*lint !e961 !e418 MISRA exception as the casts are only redundant for some ports, plus previous logic ensures a null pointer can only be passed to memcpy() if the copy size is 0. */
+		queueCOPY_ITEM( ( void * ) pxQueue->pcWriteTo, pvItemToQueue, pxQueue->uxItemSize ); /*lint !e961 !e418 MISRA exception as the casts are only redundant for some ports, plus previous logic ensures a null pointer can only be passed to memcpy() if the copy size is 0. */
 		pxQueue->pcWriteTo += pxQueue->uxItemSize;
 		if( pxQueue->pcWriteTo >= pxQueue->pcTail ) /*lint !e946 MISRA exception justified as comparison of pointers is the cleanest solution. */
 		{
@@ -1816,7 +1957,7 @@ BaseType_t xReturn = pdFALSE;
 	}
 	else
 	{
-		( void ) memcpy( ( void * ) pxQueue->u.pcReadFrom, pvItemToQueue, ( size_t ) pxQueue->uxItemSize ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+		queueCOPY_ITEM( ( void * ) pxQueue->u.pcReadFrom, pvItemToQueue, pxQueue->uxItemSize ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
 		pxQueue->u.pcReadFrom -= pxQueue->uxItemSize;
 		if( pxQueue->u.pcReadFrom < pxQueue->pcHead ) /*lint !e946 MISRA exception justified as comparison of pointers is the cleanest solution. */
 		{
@@ -1867,11 +2008,52 @@ static void prvCopyDataFromQueue( Queue_t * const pxQueue, void * const pvBuffer
 		{
 			mtCOVERAGE_TEST_MARKER();
 		}
-		( void ) memcpy( ( void * ) pvBuffer, ( void * ) pxQueue->u.pcReadFrom, ( size_t ) pxQueue->uxItemSize ); /*lint !e961 !e418 MISRA exception as the casts are only redundant for some ports.  Also previous logic ensures a null pointer can only be passed to memcpy() when the count is 0. */
+		queueCOPY_ITEM( ( void * ) pvBuffer, ( void * ) pxQueue->u.pcReadFrom, pxQueue->uxItemSize ); /*lint !e961 !e418 MISRA exception as the casts are only redundant for some ports.  Also previous logic ensures a null pointer can only be passed to memcpy() when the count is 0. */
 	}
 }
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_QUEUE_SIZED_COPY == 1 )
+
+	static void prvCopyItem( void * const pvDest, const void * const pvSource, const UBaseType_t uxItemSize )
+	{
+	uint32_t * const pulDest = ( uint32_t * ) pvDest;
+	const uint32_t * const pulSource = ( const uint32_t * ) pvSource;
+
+		/* The Nios II cannot load or store a word that is not word aligned, so
+		only aligned buffers take the word copies.  Queue storage is aligned
+		when the buffer given to xQueueCreateStatic() is, or comes from the
+		heap, and these item sizes keep every item in it aligned. */
+		if( ( ( ( size_t ) pvDest | ( size_t ) pvSource ) & ( sizeof( uint32_t ) - 1 ) ) != 0 )
+		{
+			( void ) memcpy( pvDest, pvSource, ( size_t ) uxItemSize );
+			return;
+		}
+
+		switch( uxItemSize )
+		{
+			case 16 :
+				pulDest[ 3 ] = pulSource[ 3 ];
+				/* Fall through. */
+			case 12 :
+				pulDest[ 2 ] = pulSource[ 2 ];
+				/* Fall through. */
+			case 8 :
+				pulDest[ 1 ] = pulSource[ 1 ];
+				/* Fall through. */
+			case 4 :
+				pulDest[ 0 ] = pulSource[ 0 ];
+				break;
+
+			default :
+				( void ) memcpy( pvDest, pvSource, ( size_t ) uxItemSize );
+				break;
+		}
+	}
+
+#endif /* configUSE_QUEUE_SIZED_COPY */
+/*-----------------------------------------------------------*/
+
 static void prvUnlockQueue( Queue_t * const pxQueue )
 {
 	/* THIS FUNCTION MUST BE CALLED WITH THE SCHEDULER SUSPENDED. */
@@ -2432,7 +2614,7 @@ BaseType_t xReturn;
 #endif /* configUSE_TIMERS */
 /*-----------------------------------------------------------*/
 
-#if ( configUSE_QUEUE_SETS == 1 )
+#if ( ( configUSE_QUEUE_SETS == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
 
 	QueueSetHandle_t xQueueCreateSet( const UBaseType_t uxEventQueueLength )
 	{
@@ -2443,7 +2625,7 @@ BaseType_t xReturn;
 		return pxQueue;
 	}
 
-#endif /* configUSE_QUEUE_SETS */
+#endif /* ( configUSE_QUEUE_SETS == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) */
 /*-----------------------------------------------------------*/
 
 #if ( configUSE_QUEUE_SETS == 1 )
@@ -184,6 +184,21 @@ typedef QueueHandle_t SemaphoreHandle_t;
  */
 #define xSemaphoreCreateBinary() xQueueGenericCreate( ( UBaseType_t ) 1, semSEMAPHORE_QUEUE_ITEM_LENGTH, queueQUEUE_TYPE_BINARY_SEMAPHORE )
 
+/**
+ * semphr. h
+ * <pre>SemaphoreHandle_t xSemaphoreCreateBinaryStatic( StaticSemaphore_t *pxSemaphoreBuffer )</pre>
+ *
+ * As xSemaphoreCreateBinary(), but the semaphore is held in the
+ * StaticSemaphore_t variable pointed to by pxSemaphoreBuffer instead of in
+ * memory allocated from the FreeRTOS heap.  The variable must persist for the
+ * lifetime of the semaphore.  Only available when
+ * configSUPPORT_STATIC_ALLOCATION is set to 1 in FreeRTOSConfig.h.
+ *
+ * \defgroup xSemaphoreCreateBinaryStatic xSemaphoreCreateBinaryStatic
+ * \ingroup Semaphores
+ */
+#define xSemaphoreCreateBinaryStatic( pxSemaphoreBuffer ) xQueueGenericCreateStatic( ( UBaseType_t ) 1, semSEMAPHORE_QUEUE_ITEM_LENGTH, NULL, ( pxSemaphoreBuffer ), queueQUEUE_TYPE_BINARY_SEMAPHORE )
+
 /**
  * semphr. h
  * <pre>xSemaphoreTake(
@@ -692,6 +707,31 @@ typedef QueueHandle_t SemaphoreHandle_t;
  */
 #define xSemaphoreCreateMutex() xQueueCreateMutex( queueQUEUE_TYPE_MUTEX )
 
+/**
+ * semphr. h
+ * <pre>SemaphoreHandle_t xSemaphoreCreateMutexStatic( StaticSemaphore_t *pxMutexBuffer )</pre>
+ *
+ * As xSemaphoreCreateMutex(), but the mutex is held in the StaticSemaphore_t
+ * variable pointed to by pxMutexBuffer instead of in memory allocated from the
+ * FreeRTOS heap.  The variable must persist for the lifetime of the mutex.
+ * Only available when configSUPPORT_STATIC_ALLOCATION is set to 1 in
+ * FreeRTOSConfig.h.
+ *
+ * Example usage:
+ <pre>
+ static StaticSemaphore_t xMutexBuffer;
+ SemaphoreHandle_t xSemaphore;
+
+ void vATask( void * pvParameters )
+ {
+    xSemaphore = xSemaphoreCreateMutexStatic( &xMutexBuffer );
+ }
+ </pre>
+ * \defgroup xSemaphoreCreateMutexStatic xSemaphoreCreateMutexStatic
+ * \ingroup Semaphores
+ */
+#define xSemaphoreCreateMutexStatic( pxMutexBuffer ) xQueueCreateMutexStatic( queueQUEUE_TYPE_MUTEX, ( pxMutexBuffer ) )
+
 
 /**
  * semphr. h
@@ -747,6 +787,18 @@ typedef QueueHandle_t SemaphoreHandle_t;
  */
 #define xSemaphoreCreateRecursiveMutex() xQueueCreateMutex( queueQUEUE_TYPE_RECURSIVE_MUTEX )
 
+/**
+ * semphr. h
+ * <pre>SemaphoreHandle_t xSemaphoreCreateRecursiveMutexStatic( StaticSemaphore_t *pxMutexBuffer )</pre>
+ *
+ * As xSemaphoreCreateRecursiveMutex(), but using the StaticSemaphore_t
+ * variable pointed to by pxMutexBuffer instead of the FreeRTOS heap.
+ *
+ * \defgroup xSemaphoreCreateRecursiveMutexStatic xSemaphoreCreateRecursiveMutexStatic
+ * \ingroup Semaphores
+ */
+#define xSemaphoreCreateRecursiveMutexStatic( pxMutexBuffer ) xQueueCreateMutexStatic( queueQUEUE_TYPE_RECURSIVE_MUTEX, ( pxMutexBuffer ) )
+
 /**
  * semphr. h
  * <pre>SemaphoreHandle_t xSemaphoreCreateCounting( UBaseType_t uxMaxCount, UBaseType_t uxInitialCount )</pre>
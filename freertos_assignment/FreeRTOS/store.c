@@ -0,0 +1,869 @@
+/*
+ * Relay persistent store.  See store.h.
+ *
+ * The values are held in RAM, with a bit each to say which are held and which
+ * have changed since they were last written.  Events wait in one of two batch
+ * buffers as their type, length and data; xStoreFlush() swaps the buffers with
+ * interrupts masked and writes out the one it took while the other fills, so
+ * nothing is copied in the critical section.  Records are built in a small
+ * program buffer and programmed a buffer at a time.
+ *
+ * Only xStoreFlush() changes the flash, and it is called from one task, so
+ * the block and offset being written need no protection.
+ */
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "store.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( configUSE_STORE == 1 )
+
+#if( configSTORE_KEYS > 32 )
+	#error configSTORE_KEYS must be 32 or less.
+#endif
+
+#if( configSTORE_BATCH_BYTES < ( 2 + storeMAX_EVENT ) )
+	#error configSTORE_BATCH_BYTES must hold at least one event.
+#endif
+
+/* Bytes programmed in one call, at most. */
+#define storePROGRAM_BYTES			128
+
+/* Header fields, byte offsets. */
+#define storeHEADER_SEQUENCE		4
+#define storeHEADER_ERASES			8
+#define storeHEADER_CRC				12
+
+/* Batch entries are the event type and length, then the data. */
+#define storeBATCH_ENTRY_HEADER		2
+
+#define storeCRC_INITIAL			( ( uint16_t ) 0xFFFFU )
+
+/* What prvReadRecord() found. */
+#define storeREAD_OK				0
+#define storeREAD_END				1
+#define storeREAD_CORRUPT			2
+
+typedef struct xSTORE_VALUE
+{
+	uint8_t ucLength;
+	uint8_t ucData[ storeMAX_VALUE ];
+} StoreValue_t;
+
+/* A record read from the flash. */
+typedef struct xSTORE_RECORD
+{
+	uint8_t ucType;
+	uint8_t ucKey;
+	uint8_t ucLength;
+	uint8_t ucData[ storeMAX_VALUE + storeRECORD_CRC_SIZE ];
+} StoreRecord_t;
+
+static const uint8_t ucStoreMagic[ 4 ] = { 'R', 'S', 'T', '1' };
+
+/* CRC-16/CCITT-FALSE a nibble at a time, as telemetry.c. */
+static const uint16_t usStoreCrcTable[ 16 ] =
+{
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+static const StoreFlash_t *pxStoreFlash = NULL;
+
+/* A bit per key: a value is held for it, and it has changed since it was last
+written. */
+static StoreValue_t xStoreValues[ configSTORE_KEYS ];
+static uint32_t ulStoreHeld = 0;
+static uint32_t ulStoreDirty = 0;
+
+/* Events are appended to ucStoreBatch[ uxStoreBatchFilling ], which holds
+xStoreBatchUsed bytes. */
+static uint8_t ucStoreBatch[ 2 ][ configSTORE_BATCH_BYTES ];
+static UBaseType_t uxStoreBatchFilling = 0;
+static size_t xStoreBatchUsed = 0;
+
+static TaskHandle_t xStoreFlushTask = NULL;
+
+/* The block being written, its sequence number and erase count, and the
+offset the next record goes at.  An offset of the block size means the next
+record starts a new block. */
+static uint32_t ulStoreActive = 0;
+static uint32_t ulStoreSequence = 0;
+static uint32_t ulStoreActiveErases = 0;
+static uint32_t ulStoreOffset = 0;
+
+/* Records built but not yet programmed, which go at ulStoreProgramOffset in
+the active block. */
+static uint8_t ucStoreProgram[ storePROGRAM_BYTES ];
+static size_t xStoreProgramUsed = 0;
+static uint32_t ulStoreProgramOffset = 0;
+
+static StoreStats_t xStoreStats;
+static uint32_t ulStoreBytesRead = 0;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * CRC-16/CCITT-FALSE of xLength bytes, continuing from usCrc.
+ */
+static uint16_t prvCrc( uint16_t usCrc, const uint8_t *pucData, size_t xLength );
+
+/*
+ * Little endian fields.
+ */
+static void prvPutLittleEndian( uint8_t *pucBuffer, uint32_t ulValue, size_t xBytes );
+static uint32_t prvGetLittleEndian( const uint8_t *pucBuffer, size_t xBytes );
+
+/*
+ * The flash functions, counting errors and the bytes read.
+ */
+static BaseType_t prvRead( uint32_t ulBlock, uint32_t ulOffset, void *pvBuffer, size_t xLength );
+static BaseType_t prvProgram( uint32_t ulBlock, uint32_t ulOffset, const void *pvData, size_t xLength );
+
+/*
+ * Reads a block's header.  Returns pdTRUE if it is valid.
+ */
+static BaseType_t prvReadHeader( uint32_t ulBlock, uint32_t *pulSequence, uint32_t *pulErases );
+
+/*
+ * Reads and checks the record at ulOffset in ulBlock.  Returns storeREAD_*.
+ */
+static BaseType_t prvReadRecord( uint32_t ulBlock, uint32_t ulOffset, StoreRecord_t *pxRecord );
+
+/*
+ * Reads back every value from the active block and sets ulStoreOffset to the
+ * end of its records.
+ */
+static void prvRecoverValues( void );
+
+/*
+ * Adds a record to the program buffer, starting a new block first if it does
+ * not fit in the active one.
+ */
+static BaseType_t prvWriteRecord( uint8_t ucType, uint8_t ucKey, const uint8_t *pucData, size_t xLength );
+
+/*
+ * Adds a record to the program buffer, which must have room in the block.
+ */
+static BaseType_t prvBuildRecord( uint8_t ucType, uint8_t ucKey, const uint8_t *pucData, size_t xLength );
+
+/*
+ * Programs the program buffer.  On failure the active block is given up.
+ */
+static BaseType_t prvProgramPending( void );
+
+/*
+ * Erases the next block in the ring, writes a checkpoint of every value into
+ * it and then its header.
+ */
+static BaseType_t prvStartBlock( void );
+
+/*
+ * Copies the value for ucKey and clears its changed bit.  Returns its length,
+ * 0 if none is held.
+ */
+static size_t prvTakeValue( uint8_t ucKey, uint8_t *pucValue );
+
+/*-----------------------------------------------------------*/
+
+static uint16_t prvCrc( uint16_t usCrc, const uint8_t *pucData, size_t xLength )
+{
+	while( xLength-- > 0 )
+	{
+		usCrc = ( uint16_t ) ( ( usCrc << 4 ) ^ usStoreCrcTable[ ( usCrc >> 12 ) ^ ( *pucData >> 4 ) ] );
+		usCrc = ( uint16_t ) ( ( usCrc << 4 ) ^ usStoreCrcTable[ ( usCrc >> 12 ) ^ ( *pucData & 0x0FU ) ] );
+		pucData++;
+	}
+
+	return usCrc;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPutLittleEndian( uint8_t *pucBuffer, uint32_t ulValue, size_t xBytes )
+{
+size_t x;
+
+	for( x = 0; x < xBytes; x++ )
+	{
+		pucBuffer[ x ] = ( uint8_t ) ( ulValue >> ( 8U * x ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvGetLittleEndian( const uint8_t *pucBuffer, size_t xBytes )
+{
+uint32_t ulValue = 0;
+size_t x;
+
+	for( x = 0; x < xBytes; x++ )
+	{
+		ulValue |= ( uint32_t ) pucBuffer[ x ] << ( 8U * x );
+	}
+
+	return ulValue;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvRead( uint32_t ulBlock, uint32_t ulOffset, void *pvBuffer, size_t xLength )
+{
+BaseType_t xReturn;
+
+	xReturn = pxStoreFlash->pxRead( pxStoreFlash->pvContext, pxStoreFlash->ulBase + ( ulBlock * pxStoreFlash->ulBlockSize ) + ulOffset, pvBuffer, xLength );
+	ulStoreBytesRead += ( uint32_t ) xLength;
+	if( xReturn != pdPASS )
+	{
+		xStoreStats.ulFlashErrors++;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvProgram( uint32_t ulBlock, uint32_t ulOffset, const void *pvData, size_t xLength )
+{
+BaseType_t xReturn;
+
+	xReturn = pxStoreFlash->pxProgram( pxStoreFlash->pvContext, pxStoreFlash->ulBase + ( ulBlock * pxStoreFlash->ulBlockSize ) + ulOffset, pvData, xLength );
+	if( xReturn == pdPASS )
+	{
+		xStoreStats.ulBytesProgrammed += ( uint32_t ) xLength;
+	}
+	else
+	{
+		xStoreStats.ulFlashErrors++;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvReadHeader( uint32_t ulBlock, uint32_t *pulSequence, uint32_t *pulErases )
+{
+uint8_t ucHeader[ storeBLOCK_HEADER_SIZE ];
+
+	if( prvRead( ulBlock, 0, ucHeader, sizeof( ucHeader ) ) != pdPASS )
+	{
+		return pdFALSE;
+	}
+
+	if( ( memcmp( ucHeader, ucStoreMagic, sizeof( ucStoreMagic ) ) != 0 ) ||
+		( prvGetLittleEndian( &( ucHeader[ storeHEADER_CRC ] ), 2 ) != prvCrc( storeCRC_INITIAL, ucHeader, storeHEADER_CRC ) ) )
+	{
+		return pdFALSE;
+	}
+
+	*pulSequence = prvGetLittleEndian( &( ucHeader[ storeHEADER_SEQUENCE ] ), 4 );
+	*pulErases = prvGetLittleEndian( &( ucHeader[ storeHEADER_ERASES ] ), 4 );
+
+	/* 0 is never written, so a header with it is not one of ours. */
+	return ( *pulSequence != 0UL ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvReadRecord( uint32_t ulBlock, uint32_t ulOffset, StoreRecord_t *pxRecord )
+{
+uint8_t ucHeader[ storeRECORD_HEADER_SIZE ];
+size_t xMaximum;
+uint16_t usCrc;
+
+	if( ( ulOffset + storeRECORD_HEADER_SIZE ) > pxStoreFlash->ulBlockSize )
+	{
+		return storeREAD_END;
+	}
+
+	if( prvRead( ulBlock, ulOffset, ucHeader, sizeof( ucHeader ) ) != pdPASS )
+	{
+		return storeREAD_CORRUPT;
+	}
+
+	/* The end of the records is erased.  A header only partly erased is a
+	record cut short. */
+	if( ( ucHeader[ 0 ] == 0xFFU ) && ( ucHeader[ 1 ] == 0xFFU ) && ( ucHeader[ 2 ] == 0xFFU ) && ( ucHeader[ 3 ] == 0xFFU ) )
+	{
+		return storeREAD_END;
+	}
+
+	pxRecord->ucType = ucHeader[ 0 ];
+	pxRecord->ucKey = ucHeader[ 1 ];
+	pxRecord->ucLength = ucHeader[ 2 ];
+
+	if( pxRecord->ucType == storeRECORD_VALUE )
+	{
+		xMaximum = ( pxRecord->ucKey < configSTORE_KEYS ) ? storeMAX_VALUE : 0U;
+	}
+	else if( pxRecord->ucType == storeRECORD_EVENT )
+	{
+		xMaximum = storeMAX_EVENT;
+	}
+	else
+	{
+		xMaximum = 0U;
+	}
+
+	if( ( pxRecord->ucLength == 0U ) || ( pxRecord->ucLength > xMaximum ) || ( ucHeader[ 3 ] != 0U ) ||
+		( ( ulOffset + storeRECORD_SIZE( pxRecord->ucLength ) ) > pxStoreFlash->ulBlockSize ) )
+	{
+		return storeREAD_CORRUPT;
+	}
+
+	if( prvRead( ulBlock, ulOffset + storeRECORD_HEADER_SIZE, pxRecord->ucData, pxRecord->ucLength + storeRECORD_CRC_SIZE ) != pdPASS )
+	{
+		return storeREAD_CORRUPT;
+	}
+
+	usCrc = prvCrc( storeCRC_INITIAL, ucHeader, sizeof( ucHeader ) );
+	usCrc = prvCrc( usCrc, pxRecord->ucData, pxRecord->ucLength );
+	if( prvGetLittleEndian( &( pxRecord->ucData[ pxRecord->ucLength ] ), 2 ) != usCrc )
+	{
+		return storeREAD_CORRUPT;
+	}
+
+	return storeREAD_OK;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRecoverValues( void )
+{
+StoreRecord_t xRecord;
+BaseType_t xResult;
+
+	ulStoreOffset = storeBLOCK_HEADER_SIZE;
+
+	for( ;; )
+	{
+		xResult = prvReadRecord( ulStoreActive, ulStoreOffset, &xRecord );
+		if( xResult != storeREAD_OK )
+		{
+			break;
+		}
+
+		if( xRecord.ucType == storeRECORD_VALUE )
+		{
+			if( ( ulStoreHeld & ( 1UL << xRecord.ucKey ) ) == 0UL )
+			{
+				xStoreStats.ulRecoveredValues++;
+			}
+			xStoreValues[ xRecord.ucKey ].ucLength = xRecord.ucLength;
+			memcpy( xStoreValues[ xRecord.ucKey ].ucData, xRecord.ucData, xRecord.ucLength );
+			ulStoreHeld |= 1UL << xRecord.ucKey;
+		}
+
+		ulStoreOffset += storeRECORD_SIZE( xRecord.ucLength );
+	}
+
+	/* Whatever follows a bad record may be half programmed, so nothing more
+	is written to this block. */
+	if( xResult == storeREAD_CORRUPT )
+	{
+		xStoreStats.ulCorruptRecords++;
+		ulStoreOffset = pxStoreFlash->ulBlockSize;
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xStoreInit( const StoreFlash_t *pxFlash )
+{
+uint32_t ulBlock, ulSequence, ulErases;
+BaseType_t xFound = pdFALSE;
+
+	pxStoreFlash = pxFlash;
+
+	memset( xStoreValues, 0x00, sizeof( xStoreValues ) );
+	memset( &xStoreStats, 0x00, sizeof( xStoreStats ) );
+	ulStoreHeld = 0;
+	ulStoreDirty = 0;
+	uxStoreBatchFilling = 0;
+	xStoreBatchUsed = 0;
+	xStoreProgramUsed = 0;
+	ulStoreBytesRead = 0;
+	ulStoreSequence = 0;
+	ulStoreActiveErases = 0;
+
+	/* A block must hold its header, a checkpoint and something after it. */
+	if( ( pxFlash->ulBlockCount < 2UL ) || ( ( pxFlash->ulBlockSize & 3UL ) != 0UL ) ||
+		( pxFlash->ulBlockSize < ( storeBLOCK_HEADER_SIZE + ( ( configSTORE_KEYS + 1UL ) * storeRECORD_SIZE( storeMAX_VALUE ) ) ) ) )
+	{
+		pxStoreFlash = NULL;
+		return pdFAIL;
+	}
+
+	xStoreStats.ulBlockCount = pxFlash->ulBlockCount;
+
+	for( ulBlock = 0; ulBlock < pxFlash->ulBlockCount; ulBlock++ )
+	{
+		if( prvReadHeader( ulBlock, &ulSequence, &ulErases ) != pdFALSE )
+		{
+			if( ( xFound == pdFALSE ) || ( ulSequence > ulStoreSequence ) )
+			{
+				ulStoreActive = ulBlock;
+				ulStoreSequence = ulSequence;
+				ulStoreActiveErases = ulErases;
+			}
+
+			if( ( xFound == pdFALSE ) || ( ulErases < xStoreStats.ulMinErases ) )
+			{
+				xStoreStats.ulMinErases = ulErases;
+			}
+			if( ulErases > xStoreStats.ulMaxErases )
+			{
+				xStoreStats.ulMaxErases = ulErases;
+			}
+			xFound = pdTRUE;
+		}
+	}
+
+	if( xStoreStats.ulFlashErrors != 0UL )
+	{
+		pxStoreFlash = NULL;
+		return pdFAIL;
+	}
+
+	if( xFound != pdFALSE )
+	{
+		prvRecoverValues();
+	}
+	else
+	{
+		/* Nothing stored yet.  The first flush starts block 0. */
+		ulStoreActive = pxFlash->ulBlockCount - 1UL;
+		ulStoreOffset = pxFlash->ulBlockSize;
+	}
+
+	xStoreStats.ulRecoveryBytesRead = ulStoreBytesRead;
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+size_t xStoreGetValue( uint8_t ucKey, void *pvValue, size_t xLength )
+{
+UBaseType_t uxSavedInterruptStatus;
+size_t xHeld = 0;
+
+	if( ucKey >= configSTORE_KEYS )
+	{
+		return 0;
+	}
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		if( ( ulStoreHeld & ( 1UL << ucKey ) ) != 0UL )
+		{
+			xHeld = xStoreValues[ ucKey ].ucLength;
+			memcpy( pvValue, xStoreValues[ ucKey ].ucData, ( xHeld < xLength ) ? xHeld : xLength );
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	return xHeld;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xStoreSetValue( uint8_t ucKey, const void *pvValue, size_t xLength )
+{
+UBaseType_t uxSavedInterruptStatus;
+StoreValue_t *pxValue;
+
+	if( ( ucKey >= configSTORE_KEYS ) || ( xLength == 0U ) || ( xLength > storeMAX_VALUE ) )
+	{
+		return pdFAIL;
+	}
+
+	pxValue = &( xStoreValues[ ucKey ] );
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		/* Writing the value already held would only wear the flash. */
+		if( ( ( ulStoreHeld & ( 1UL << ucKey ) ) == 0UL ) || ( pxValue->ucLength != xLength ) || ( memcmp( pxValue->ucData, pvValue, xLength ) != 0 ) )
+		{
+			pxValue->ucLength = ( uint8_t ) xLength;
+			memcpy( pxValue->ucData, pvValue, xLength );
+			ulStoreHeld |= 1UL << ucKey;
+			ulStoreDirty |= 1UL << ucKey;
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xStoreAppendEvent( uint8_t ucType, const void *pvData, size_t xLength )
+{
+UBaseType_t uxSavedInterruptStatus;
+BaseType_t xReturn = pdFAIL;
+BaseType_t xWake = pdFALSE;
+uint8_t *pucEntry;
+
+	if( ( xLength == 0U ) || ( xLength > storeMAX_EVENT ) )
+	{
+		return pdFAIL;
+	}
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		if( ( xStoreBatchUsed + storeBATCH_ENTRY_HEADER + xLength ) <= ( size_t ) configSTORE_BATCH_BYTES )
+		{
+			pucEntry = &( ucStoreBatch[ uxStoreBatchFilling ][ xStoreBatchUsed ] );
+			pucEntry[ 0 ] = ucType;
+			pucEntry[ 1 ] = ( uint8_t ) xLength;
+			memcpy( &( pucEntry[ storeBATCH_ENTRY_HEADER ] ), pvData, xLength );
+
+			/* Only the event that crosses half full wakes the flush task. */
+			xWake = ( ( xStoreBatchUsed < ( configSTORE_BATCH_BYTES / 2 ) ) &&
+					  ( ( xStoreBatchUsed + storeBATCH_ENTRY_HEADER + xLength ) >= ( configSTORE_BATCH_BYTES / 2 ) ) ) ? pdTRUE : pdFALSE;
+
+			xStoreBatchUsed += storeBATCH_ENTRY_HEADER + xLength;
+			if( xStoreBatchUsed > xStoreStats.xBatchHighWater )
+			{
+				xStoreStats.xBatchHighWater = xStoreBatchUsed;
+			}
+			xReturn = pdPASS;
+		}
+		else
+		{
+			xStoreStats.ulEventsDropped++;
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	if( ( xWake != pdFALSE ) && ( xStoreFlushTask != NULL ) )
+	{
+		xTaskNotifyGive( xStoreFlushTask );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vStoreSetFlushTask( TaskHandle_t xTask )
+{
+	xStoreFlushTask = xTask;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvBuildRecord( uint8_t ucType, uint8_t ucKey, const uint8_t *pucData, size_t xLength )
+{
+size_t xSize = storeRECORD_SIZE( xLength );
+uint8_t *pucRecord;
+uint16_t usCrc;
+
+	if( ( xStoreProgramUsed + xSize ) > sizeof( ucStoreProgram ) )
+	{
+		if( prvProgramPending() != pdPASS )
+		{
+			return pdFAIL;
+		}
+	}
+
+	if( xStoreProgramUsed == 0U )
+	{
+		ulStoreProgramOffset = ulStoreOffset;
+	}
+
+	pucRecord = &( ucStoreProgram[ xStoreProgramUsed ] );
+	pucRecord[ 0 ] = ucType;
+	pucRecord[ 1 ] = ucKey;
+	pucRecord[ 2 ] = ( uint8_t ) xLength;
+	pucRecord[ 3 ] = 0U;
+	memcpy( &( pucRecord[ storeRECORD_HEADER_SIZE ] ), pucData, xLength );
+	usCrc = prvCrc( storeCRC_INITIAL, pucRecord, storeRECORD_HEADER_SIZE + xLength );
+	prvPutLittleEndian( &( pucRecord[ storeRECORD_HEADER_SIZE + xLength ] ), usCrc, storeRECORD_CRC_SIZE );
+
+	/* The padding is left as erased flash. */
+	memset( &( pucRecord[ storeRECORD_HEADER_SIZE + xLength + storeRECORD_CRC_SIZE ] ), 0xFF, xSize - ( storeRECORD_HEADER_SIZE + xLength + storeRECORD_CRC_SIZE ) );
+
+	xStoreProgramUsed += xSize;
+	ulStoreOffset += ( uint32_t ) xSize;
+	xStoreStats.ulRecordsWritten++;
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvProgramPending( void )
+{
+BaseType_t xReturn = pdPASS;
+
+	if( xStoreProgramUsed != 0U )
+	{
+		xReturn = prvProgram( ulStoreActive, ulStoreProgramOffset, ucStoreProgram, xStoreProgramUsed );
+		xStoreProgramUsed = 0;
+
+		if( xReturn != pdPASS )
+		{
+			ulStoreOffset = pxStoreFlash->ulBlockSize;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvTakeValue( uint8_t ucKey, uint8_t *pucValue )
+{
+UBaseType_t uxSavedInterruptStatus;
+size_t xLength = 0;
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		if( ( ulStoreHeld & ( 1UL << ucKey ) ) != 0UL )
+		{
+			xLength = xStoreValues[ ucKey ].ucLength;
+			memcpy( pucValue, xStoreValues[ ucKey ].ucData, xLength );
+		}
+		ulStoreDirty &= ~( 1UL << ucKey );
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	return xLength;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvStartBlock( void )
+{
+uint8_t ucHeader[ storeBLOCK_HEADER_SIZE ];
+uint8_t ucValue[ storeMAX_VALUE ];
+uint32_t ulNext, ulSequence, ulErases;
+size_t xLength;
+uint8_t ucKey;
+
+	ulNext = ( ulStoreActive + 1UL ) % pxStoreFlash->ulBlockCount;
+
+	/* Blocks are erased in turn, so one without a header has been erased once
+	less than the one before it, or never. */
+	if( prvReadHeader( ulNext, &ulSequence, &ulErases ) == pdFALSE )
+	{
+		ulErases = ( ulStoreActiveErases != 0UL ) ? ( ulStoreActiveErases - 1UL ) : 0UL;
+	}
+	ulErases++;
+
+	/* From here the block is given up on any failure and the next start tries
+	the block after it. */
+	ulStoreActive = ulNext;
+	ulStoreOffset = pxStoreFlash->ulBlockSize;
+
+	xStoreStats.ulErases++;
+	if( pxStoreFlash->pxErase( pxStoreFlash->pvContext, pxStoreFlash->ulBase + ( ulNext * pxStoreFlash->ulBlockSize ) ) != pdPASS )
+	{
+		xStoreStats.ulFlashErrors++;
+		return pdFAIL;
+	}
+
+	ulStoreOffset = storeBLOCK_HEADER_SIZE;
+
+	/* Every value held, current as it is copied.  A value set after its copy
+	is marked changed again and written after the checkpoint. */
+	for( ucKey = 0; ucKey < configSTORE_KEYS; ucKey++ )
+	{
+		xLength = prvTakeValue( ucKey, ucValue );
+		if( xLength != 0U )
+		{
+			if( prvBuildRecord( storeRECORD_VALUE, ucKey, ucValue, xLength ) != pdPASS )
+			{
+				return pdFAIL;
+			}
+		}
+	}
+
+	if( prvProgramPending() != pdPASS )
+	{
+		return pdFAIL;
+	}
+
+	/* Last, so the block only counts once its checkpoint is complete. */
+	memcpy( ucHeader, ucStoreMagic, sizeof( ucStoreMagic ) );
+	prvPutLittleEndian( &( ucHeader[ storeHEADER_SEQUENCE ] ), ulStoreSequence + 1UL, 4 );
+	prvPutLittleEndian( &( ucHeader[ storeHEADER_ERASES ] ), ulErases, 4 );
+	prvPutLittleEndian( &( ucHeader[ storeHEADER_CRC ] ), prvCrc( storeCRC_INITIAL, ucHeader, storeHEADER_CRC ), 2 );
+	ucHeader[ storeHEADER_CRC + 2 ] = 0xFFU;
+	ucHeader[ storeHEADER_CRC + 3 ] = 0xFFU;
+
+	if( prvProgram( ulNext, 0, ucHeader, sizeof( ucHeader ) ) != pdPASS )
+	{
+		ulStoreOffset = pxStoreFlash->ulBlockSize;
+		return pdFAIL;
+	}
+
+	ulStoreSequence++;
+	ulStoreActiveErases = ulErases;
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvWriteRecord( uint8_t ucType, uint8_t ucKey, const uint8_t *pucData, size_t xLength )
+{
+	if( ( ulStoreOffset + storeRECORD_SIZE( xLength ) ) > pxStoreFlash->ulBlockSize )
+	{
+		if( prvProgramPending() != pdPASS )
+		{
+			return pdFAIL;
+		}
+
+		if( prvStartBlock() != pdPASS )
+		{
+			return pdFAIL;
+		}
+	}
+
+	return prvBuildRecord( ucType, ucKey, pucData, xLength );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xStoreFlush( void )
+{
+UBaseType_t uxSavedInterruptStatus;
+uint8_t ucValue[ storeMAX_VALUE ];
+BaseType_t xReturn = pdPASS;
+const uint8_t *pucBatch;
+size_t xBatchLength, x;
+uint32_t ulWritten;
+uint8_t ucKey;
+
+	if( pxStoreFlash == NULL )
+	{
+		return pdFAIL;
+	}
+
+	ulWritten = xStoreStats.ulRecordsWritten;
+
+	/* Take the batch being filled and start the other.  The one taken was
+	emptied by the last flush. */
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		pucBatch = ucStoreBatch[ uxStoreBatchFilling ];
+		xBatchLength = xStoreBatchUsed;
+		uxStoreBatchFilling ^= 1U;
+		xStoreBatchUsed = 0;
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	/* Values first.  A new block's checkpoint writes every value and clears
+	their changed bits, so those after it are not written twice. */
+	for( ucKey = 0; ( ucKey < configSTORE_KEYS ) && ( xReturn == pdPASS ); ucKey++ )
+	{
+		if( ( ulStoreDirty & ( 1UL << ucKey ) ) != 0UL )
+		{
+			x = prvTakeValue( ucKey, ucValue );
+			if( x != 0U )
+			{
+				xReturn = prvWriteRecord( storeRECORD_VALUE, ucKey, ucValue, x );
+			}
+		}
+	}
+
+	for( x = 0; ( x < xBatchLength ) && ( xReturn == pdPASS ); x += storeBATCH_ENTRY_HEADER + pucBatch[ x + 1 ] )
+	{
+		xReturn = prvWriteRecord( storeRECORD_EVENT, pucBatch[ x ], &( pucBatch[ x + storeBATCH_ENTRY_HEADER ] ), pucBatch[ x + 1 ] );
+	}
+
+	if( xReturn == pdPASS )
+	{
+		xReturn = prvProgramPending();
+	}
+	else
+	{
+		/* Values that did not make it are written next time.  The value
+		being written when it failed is in the next block's checkpoint. */
+		xStoreProgramUsed = 0;
+	}
+
+	if( xStoreStats.ulRecordsWritten != ulWritten )
+	{
+		xStoreStats.ulFlushes++;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vStoreCursorInit( StoreCursor_t *pxCursor )
+{
+	/* From the block after the active one round to the active one. */
+	pxCursor->ulOffset = 0;
+	if( ( pxStoreFlash != NULL ) && ( ulStoreSequence != 0UL ) )
+	{
+		pxCursor->ulBlock = ( ulStoreActive + 1UL ) % pxStoreFlash->ulBlockCount;
+		pxCursor->ulBlocksLeft = pxStoreFlash->ulBlockCount;
+	}
+	else
+	{
+		pxCursor->ulBlock = 0;
+		pxCursor->ulBlocksLeft = 0;
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xStoreReadEvent( StoreCursor_t *pxCursor, StoreEvent_t *pxEvent )
+{
+StoreRecord_t xRecord;
+uint32_t ulSequence, ulErases;
+BaseType_t xResult;
+
+	while( pxCursor->ulBlocksLeft != 0UL )
+	{
+		if( pxCursor->ulOffset == 0UL )
+		{
+			if( prvReadHeader( pxCursor->ulBlock, &ulSequence, &ulErases ) != pdFALSE )
+			{
+				pxCursor->ulOffset = storeBLOCK_HEADER_SIZE;
+			}
+			else
+			{
+				pxCursor->ulOffset = pxStoreFlash->ulBlockSize;
+			}
+		}
+
+		xResult = prvReadRecord( pxCursor->ulBlock, pxCursor->ulOffset, &xRecord );
+		if( xResult == storeREAD_OK )
+		{
+			pxCursor->ulOffset += storeRECORD_SIZE( xRecord.ucLength );
+
+			if( xRecord.ucType == storeRECORD_EVENT )
+			{
+				pxEvent->ucType = xRecord.ucKey;
+				pxEvent->ucLength = xRecord.ucLength;
+				memcpy( pxEvent->ucData, xRecord.ucData, xRecord.ucLength );
+				return pdTRUE;
+			}
+		}
+		else
+		{
+			/* The end of the block's records, or a bad one ending them. */
+			pxCursor->ulBlock = ( pxCursor->ulBlock + 1UL ) % pxStoreFlash->ulBlockCount;
+			pxCursor->ulBlocksLeft--;
+			pxCursor->ulOffset = 0;
+		}
+	}
+
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vStoreGetStats( StoreStats_t *pxStats )
+{
+UBaseType_t uxSavedInterruptStatus;
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		*pxStats = xStoreStats;
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	pxStats->ulActiveBlock = ulStoreActive;
+	pxStats->ulSequence = ulStoreSequence;
+	pxStats->ulUsed = ulStoreOffset;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configUSE_STORE */
@@ -0,0 +1,263 @@
+/*
+ * Relay persistent store.
+ *
+ * When configUSE_STORE is 1 the application can keep small values (the
+ * thresholds, the reaction time statistics) and a log of events (loads shed
+ * and reconnected) in NOR flash across resets.  The store is append only: a
+ * value is changed by writing a new record for it, and the newest record for
+ * a key wins.
+ *
+ * The flash is a ring of equal sized erase blocks, reached through the
+ * functions in a StoreFlash_t, so the store runs on the board's CFI flash and
+ * on a RAM model of it on the host.  Records are written into the newest
+ * block until it is full, then the next block in the ring is erased and
+ * begins with a checkpoint: a record for every value held.  So the newest
+ * block alone holds every value, older blocks only hold the event log, and
+ * blocks are erased strictly in turn, which spreads the wear evenly.  When the
+ * ring wraps the oldest events are lost.
+ *
+ * Every block starts with a storeBLOCK_HEADER_SIZE byte header:
+ *
+ *     magic       4 bytes, "RST1"
+ *     sequence    4 bytes, one more than the block written before it
+ *     erases      4 bytes, times this block has been erased by the store
+ *     CRC         2 bytes, CRC-16/CCITT-FALSE of the 12 bytes above
+ *     unused      2 bytes, left erased
+ *
+ * followed by records, each padded to a multiple of 4 bytes:
+ *
+ *     type        1 byte, storeRECORD_*
+ *     key         1 byte, the value's key or the event's type
+ *     length      1 byte, of the data
+ *     zero        1 byte, 0
+ *     data        length bytes
+ *     CRC         2 bytes, of the type, key, length, zero and data
+ *
+ * A block's header is programmed after its checkpoint, so a block only counts
+ * once it holds every value.  At boot xStoreInit() reads the header of every
+ * block and then the records of the newest block only.  A record that fails
+ * its CRC, such as one cut short by a reset, ends its block: nothing after it
+ * is trusted and the next write starts a new block.
+ *
+ * xStoreSetValue() and xStoreAppendEvent() only copy into RAM, with
+ * interrupts masked for a few stores, and never block or touch the flash, so
+ * they can be called from the control path.  Changes are batched until a low
+ * priority task calls xStoreFlush(), which does all of the erasing and
+ * programming.  A value set several times between flushes is written once.
+ * Multi-byte header fields are little endian; values and events are stored as
+ * the application gives them.
+ */
+
+#ifndef STORE_H
+#define STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Sizes in flash, in bytes. */
+#define storeBLOCK_HEADER_SIZE		16
+#define storeRECORD_HEADER_SIZE		4
+#define storeRECORD_CRC_SIZE		2
+
+/* Largest value and largest event data. */
+#define storeMAX_VALUE				32
+#define storeMAX_EVENT				16
+
+/* Bytes a record with xLength bytes of data takes in flash. */
+#define storeRECORD_SIZE( xLength )	( ( ( storeRECORD_HEADER_SIZE + ( xLength ) + storeRECORD_CRC_SIZE ) + 3U ) & ~( ( size_t ) 3U ) )
+
+/* Record types.  Erased flash reads as storeRECORD_ERASED and ends a block. */
+#define storeRECORD_VALUE			0x01
+#define storeRECORD_EVENT			0x02
+#define storeRECORD_ERASED			0xFF
+
+#ifdef INC_FREERTOS_H
+
+#include "task.h"
+
+/**
+ * The flash the store lives in: ulBlockCount erase blocks of ulBlockSize
+ * bytes, starting ulBase bytes into the device.  Offsets passed to the
+ * functions are from the start of the device.  Each returns pdPASS or pdFAIL.
+ *
+ * pxProgram is only ever asked to program bytes that are erased, and must not
+ * erase anything itself.  pxErase sets the whole block starting at ulOffset
+ * to 0xFF.
+ */
+typedef struct xSTORE_FLASH
+{
+	BaseType_t ( *pxRead )( void *pvContext, uint32_t ulOffset, void *pvBuffer, size_t xLength );
+	BaseType_t ( *pxProgram )( void *pvContext, uint32_t ulOffset, const void *pvData, size_t xLength );
+	BaseType_t ( *pxErase )( void *pvContext, uint32_t ulOffset );
+	void *pvContext;		/*<< Passed to the functions above. */
+	uint32_t ulBase;
+	uint32_t ulBlockSize;
+	uint32_t ulBlockCount;	/*<< At least 2. */
+} StoreFlash_t;
+
+/**
+ * An event read back by xStoreReadEvent().
+ */
+typedef struct xSTORE_EVENT
+{
+	uint8_t ucType;					/*<< As given to xStoreAppendEvent(). */
+	uint8_t ucLength;				/*<< Bytes of ucData. */
+	uint8_t ucData[ storeMAX_EVENT ];
+} StoreEvent_t;
+
+/**
+ * Position in the event log, for xStoreReadEvent().  Set up with
+ * vStoreCursorInit() and only accessed through those functions.
+ */
+typedef struct xSTORE_CURSOR
+{
+	uint32_t ulBlock;			/*<< Block being read. */
+	uint32_t ulBlocksLeft;		/*<< Blocks after it still to read. */
+	uint32_t ulOffset;			/*<< Of the next record in the block, 0 before its header is checked. */
+} StoreCursor_t;
+
+/**
+ * Counts returned by vStoreGetStats().
+ */
+typedef struct xSTORE_STATS
+{
+	uint32_t ulBlockCount;
+	uint32_t ulActiveBlock;			/*<< Block being written. */
+	uint32_t ulSequence;			/*<< Of the active block.  0 if nothing has been written. */
+	uint32_t ulUsed;				/*<< Bytes written in the active block, header included.  The block size once the next record starts a new block. */
+	uint32_t ulMinErases;			/*<< Fewest and most erases of any block with a header, as found by xStoreInit(). */
+	uint32_t ulMaxErases;
+	uint32_t ulRecoveredValues;		/*<< Values found by xStoreInit(). */
+	uint32_t ulRecoveryBytesRead;	/*<< Bytes xStoreInit() read from the flash. */
+	uint32_t ulCorruptRecords;		/*<< Records that failed their checks, each ending its block. */
+	uint32_t ulFlushes;				/*<< xStoreFlush() calls that wrote something. */
+	uint32_t ulRecordsWritten;		/*<< Checkpoints included. */
+	uint32_t ulBytesProgrammed;
+	uint32_t ulErases;				/*<< Since xStoreInit(). */
+	uint32_t ulEventsDropped;		/*<< Events that found the batch full. */
+	uint32_t ulFlashErrors;			/*<< Reads, programs and erases that failed. */
+	size_t xBatchHighWater;			/*<< Most event bytes waiting for a flush. */
+} StoreStats_t;
+
+/**
+ * store. h
+ * <pre>
+ BaseType_t xStoreInit( const StoreFlash_t *pxFlash );
+ * </pre>
+ *
+ * Finds the newest block and reads back every value from it.  Flash that has
+ * never held the store is not touched until the first flush.  Call before
+ * any other store function, before the scheduler starts or from the task
+ * that flushes.  pxFlash must stay valid.
+ *
+ * @return pdPASS, or pdFAIL if the geometry cannot hold a checkpoint or a
+ * header could not be read.  The store is empty and unusable after pdFAIL.
+ */
+BaseType_t xStoreInit( const StoreFlash_t *pxFlash ) PRIVILEGED_FUNCTION;
+
+/**
+ * store. h
+ * <pre>
+ size_t xStoreGetValue( uint8_t ucKey, void *pvValue, size_t xLength );
+ * </pre>
+ *
+ * Copies the newest value held for ucKey, set or recovered, into pvValue, at
+ * most xLength bytes.  Never touches the flash.
+ *
+ * @return The length of the value, or 0 if none is held for ucKey.
+ */
+size_t xStoreGetValue( uint8_t ucKey, void *pvValue, size_t xLength ) PRIVILEGED_FUNCTION;
+
+/**
+ * store. h
+ * <pre>
+ BaseType_t xStoreSetValue( uint8_t ucKey, const void *pvValue, size_t xLength );
+ * </pre>
+ *
+ * Sets the value for ucKey, less than configSTORE_KEYS, to xLength bytes, at
+ * most storeMAX_VALUE.  It is written at the next flush unless it is the
+ * value already held.  Never blocks.  Tasks only.
+ *
+ * @return pdPASS, or pdFAIL if the key or length is out of range.
+ */
+BaseType_t xStoreSetValue( uint8_t ucKey, const void *pvValue, size_t xLength ) PRIVILEGED_FUNCTION;
+
+/**
+ * store. h
+ * <pre>
+ BaseType_t xStoreAppendEvent( uint8_t ucType, const void *pvData, size_t xLength );
+ * </pre>
+ *
+ * Queues an event of xLength bytes, at most storeMAX_EVENT, for the next
+ * flush.  Wakes the flush task once the batch is half full.  Never blocks.
+ * Tasks only.
+ *
+ * @return pdPASS, or pdFAIL if the length is out of range or the batch is
+ * full, in which case the event is dropped and counted.
+ */
+BaseType_t xStoreAppendEvent( uint8_t ucType, const void *pvData, size_t xLength ) PRIVILEGED_FUNCTION;
+
+/**
+ * store. h
+ * <pre>
+ void vStoreSetFlushTask( TaskHandle_t xTask );
+ * </pre>
+ *
+ * Sets the task notified when the event batch is half full.
+ */
+void vStoreSetFlushTask( TaskHandle_t xTask ) PRIVILEGED_FUNCTION;
+
+/**
+ * store. h
+ * <pre>
+ BaseType_t xStoreFlush( void );
+ * </pre>
+ *
+ * Writes the values changed and the events queued since the last flush,
+ * starting new blocks as needed.  Waits for the flash, so only call it from
+ * one low priority task.  The values and events are kept in RAM while it
+ * works, so other tasks can go on setting and appending.
+ *
+ * @return pdPASS, or pdFAIL if the flash failed.  What could not be written
+ * is lost, apart from the values, which are all in the next checkpoint.
+ */
+BaseType_t xStoreFlush( void ) PRIVILEGED_FUNCTION;
+
+/**
+ * store. h
+ * <pre>
+ void vStoreCursorInit( StoreCursor_t *pxCursor );
+ BaseType_t xStoreReadEvent( StoreCursor_t *pxCursor, StoreEvent_t *pxEvent );
+ * </pre>
+ *
+ * Read the event log back, oldest first.  Only events already flushed are
+ * read.  Reads the flash, so only call these from the task that flushes, or
+ * before the scheduler starts.
+ *
+ * @return pdTRUE if an event was copied to pxEvent, pdFALSE at the end of the
+ * log.
+ */
+void vStoreCursorInit( StoreCursor_t *pxCursor ) PRIVILEGED_FUNCTION;
+BaseType_t xStoreReadEvent( StoreCursor_t *pxCursor, StoreEvent_t *pxEvent ) PRIVILEGED_FUNCTION;
+
+/**
+ * store. h
+ * <pre>
+ void vStoreGetStats( StoreStats_t *pxStats );
+ * </pre>
+ *
+ * Copies the store's counts.
+ */
+void vStoreGetStats( StoreStats_t *pxStats ) PRIVILEGED_FUNCTION;
+
+#endif /* INC_FREERTOS_H */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STORE_H */
@@ -171,7 +171,7 @@ typedef struct xTASK_STATUS
 	eTaskState eCurrentState;		/* The state in which the task existed when the structure was populated. */
 	UBaseType_t uxCurrentPriority;	/* The priority at which the task was running (may be inherited) when the structure was populated. */
 	UBaseType_t uxBasePriority;		/* The priority to which the task will return if the task's current priority has been inherited to avoid unbounded priority inversion when obtaining a mutex.  Only valid if configUSE_MUTEXES is defined as 1 in FreeRTOSConfig.h. */
-	uint32_t ulRunTimeCounter;		/* The total run time allocated to the task so far, as defined by the run time stats clock.  See http://www.freertos.org/rtos-run-time-stats.html.  Only valid when configGENERATE_RUN_TIME_STATS is defined as 1 in FreeRTOSConfig.h. */
+	configRUN_TIME_COUNTER_TYPE ulRunTimeCounter;	/* The total run time allocated to the task so far, as defined by the run time stats clock.  See http://www.freertos.org/rtos-run-time-stats.html.  Only valid when configGENERATE_RUN_TIME_STATS is defined as 1 in FreeRTOSConfig.h. */
 	uint16_t usStackHighWaterMark;	/* The minimum amount of stack space that has remained for the task since the task was created.  The closer this value is to zero the closer the task has come to overflowing its stack. */
 } TaskStatus_t;
 
@@ -343,6 +343,58 @@ is used in assert() statements. */
  */
 #define xTaskCreate( pvTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pxCreatedTask ) xTaskGenericCreate( ( pvTaskCode ), ( pcName ), ( usStackDepth ), ( pvParameters ), ( uxPriority ), ( pxCreatedTask ), ( NULL ), ( NULL ) )
 
+/**
+ * task. h
+ *<pre>
+ TaskHandle_t xTaskCreateStatic(
+							  TaskFunction_t pvTaskCode,
+							  const char * const pcName,
+							  uint16_t usStackDepth,
+							  void *pvParameters,
+							  UBaseType_t uxPriority,
+							  StackType_t *puxStackBuffer,
+							  StaticTask_t *pxTaskBuffer
+						  );</pre>
+ *
+ * Create a new task using memory supplied by the application instead of memory
+ * allocated from the FreeRTOS heap.  Only available when
+ * configSUPPORT_STATIC_ALLOCATION is set to 1 in FreeRTOSConfig.h.
+ *
+ * The parameters are the same as those of xTaskCreate() with the following
+ * additions:
+ *
+ * @param puxStackBuffer An array of at least usStackDepth StackType_t
+ * variables to use as the task's stack.  The array must persist for the
+ * lifetime of the task.
+ *
+ * @param pxTaskBuffer A StaticTask_t variable to hold the task's data
+ * structures (its TCB).  It must persist for the lifetime of the task.
+ *
+ * @return The handle of the created task, or NULL if puxStackBuffer or
+ * pxTaskBuffer is NULL.  Nothing is allocated so creation cannot otherwise
+ * fail.  Deleting the task does not free either buffer.
+ *
+ * Example usage:
+   <pre>
+ #define STACK_SIZE 200
+
+ static StaticTask_t xTaskBuffer;
+ static StackType_t xStack[ STACK_SIZE ];
+
+ void vOtherFunction( void )
+ {
+ TaskHandle_t xHandle;
+
+	 xHandle = xTaskCreateStatic( vTaskCode, "NAME", STACK_SIZE, NULL, tskIDLE_PRIORITY, xStack, &xTaskBuffer );
+ }
+   </pre>
+ * \defgroup xTaskCreateStatic xTaskCreateStatic
+ * \ingroup Tasks
+ */
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+	TaskHandle_t xTaskCreateStatic( TaskFunction_t pxTaskCode, const char * const pcName, const uint16_t usStackDepth, void * const pvParameters, UBaseType_t uxPriority, StackType_t * const puxStackBuffer, StaticTask_t * const pxTaskBuffer ) PRIVILEGED_FUNCTION; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+#endif
+
 /**
  * task. h
  *<pre>
@@ -1130,6 +1182,42 @@ char *pcTaskGetTaskName( TaskHandle_t xTaskToQuery ) PRIVILEGED_FUNCTION; /*lint
  */
 UBaseType_t uxTaskGetStackHighWaterMark( TaskHandle_t xTask ) PRIVILEGED_FUNCTION;
 
+/**
+ * task.h
+ * <PRE>configRUN_TIME_COUNTER_TYPE ulTaskGetRunTimeCounter( TaskHandle_t xTask );</PRE>
+ *
+ * configGENERATE_RUN_TIME_STATS must be set to 1 in FreeRTOSConfig.h for this
+ * function to be available.
+ *
+ * Returns the time xTask has spent in the Running state, in counts of the run
+ * time stats clock, including the current time slice if xTask is running.
+ * This is a single field read in a short critical section, so unlike
+ * uxTaskGetSystemState() it can be called often.
+ *
+ * @param xTask Handle of the task to query.  Set xTask to NULL to query the
+ * calling task.
+ *
+ * @return The task's accumulated run time.
+ */
+configRUN_TIME_COUNTER_TYPE ulTaskGetRunTimeCounter( TaskHandle_t xTask ) PRIVILEGED_FUNCTION;
+
+/**
+ * task.h
+ * <PRE>configRUN_TIME_COUNTER_TYPE ulTaskGetRunTimePercent( TaskHandle_t xTask );</PRE>
+ *
+ * configGENERATE_RUN_TIME_STATS must be set to 1 in FreeRTOSConfig.h for this
+ * function to be available.
+ *
+ * Returns the time xTask has spent in the Running state as a whole percentage
+ * of the time since the run time stats clock was started.
+ *
+ * @param xTask Handle of the task to query.  Set xTask to NULL to query the
+ * calling task.
+ *
+ * @return The task's share of the processor, 0 to 100.
+ */
+configRUN_TIME_COUNTER_TYPE ulTaskGetRunTimePercent( TaskHandle_t xTask ) PRIVILEGED_FUNCTION;
+
 /* When using trace macros it is sometimes necessary to include task.h before
 FreeRTOS.h.  When this is done TaskHookFunction_t will not yet have been defined,
 so the following two prototypes will cause a compilation error.  This can be
@@ -1223,7 +1311,7 @@ TaskHandle_t xTaskGetIdleTaskHandle( void );
 	{
 	TaskStatus_t *pxTaskStatusArray;
 	volatile UBaseType_t uxArraySize, x;
-	uint32_t ulTotalRunTime, ulStatsAsPercentage;
+	configRUN_TIME_COUNTER_TYPE ulTotalRunTime, ulStatsAsPercentage;
 
 		// Make sure the write buffer does not contain a string.
 		*pcWriteBuffer = 0x00;
@@ -1277,7 +1365,7 @@ TaskHandle_t xTaskGetIdleTaskHandle( void );
 	}
 	</pre>
  */
-UBaseType_t uxTaskGetSystemState( TaskStatus_t * const pxTaskStatusArray, const UBaseType_t uxArraySize, uint32_t * const pulTotalRunTime );
+UBaseType_t uxTaskGetSystemState( TaskStatus_t * const pxTaskStatusArray, const UBaseType_t uxArraySize, configRUN_TIME_COUNTER_TYPE * const pulTotalRunTime );
 
 /**
  * task. h
@@ -1946,7 +2034,23 @@ BaseType_t xTaskPriorityDisinherit( TaskHandle_t const pxMutexHolder ) PRIVILEGE
  * Generic version of the task creation function which is in turn called by the
  * xTaskCreate() and xTaskCreateRestricted() macros.
  */
-BaseType_t xTaskGenericCreate( TaskFunction_t pxTaskCode, const char * const pcName, const uint16_t usStackDepth, void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask, StackType_t * const puxStackBuffer, const MemoryRegion_t * const xRegions ) PRIVILEGED_FUNCTION; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+	BaseType_t xTaskGenericCreate( TaskFunction_t pxTaskCode, const char * const pcName, const uint16_t usStackDepth, void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask, StackType_t * const puxStackBuffer, const MemoryRegion_t * const xRegions ) PRIVILEGED_FUNCTION; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+#endif
+
+/*
+ * When configSUPPORT_STATIC_ALLOCATION is 1 the kernel's own tasks are created
+ * from memory supplied by the application.  vTaskStartScheduler() calls
+ * vApplicationGetIdleTaskMemory() for the idle task's TCB and stack, and the
+ * timer service calls vApplicationGetTimerTaskMemory() when configUSE_TIMERS is
+ * also 1.  The stack size is in words and is pre-set to the default
+ * (configMINIMAL_STACK_SIZE and configTIMER_TASK_STACK_DEPTH respectively) so
+ * the application only needs to change it if it supplies a different size.
+ */
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+	void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint16_t *pusIdleTaskStackSize );
+	void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint16_t *pusTimerTaskStackSize );
+#endif
 
 /*
  * Get the uxTCBNumber assigned to the task referenced by the xTask parameter.
@@ -1959,6 +2063,13 @@ UBaseType_t uxTaskGetTaskNumber( TaskHandle_t xTask ) PRIVILEGED_FUNCTION;
  */
 void vTaskSetTaskNumber( TaskHandle_t xTask, const UBaseType_t uxHandle ) PRIVILEGED_FUNCTION;
 
+/*
+ * Get the uxTCBNumber of the running task, the number uxTaskGetSystemState()
+ * reports as xTaskNumber.  For the profiler, which calls it from the tick
+ * interrupt.
+ */
+UBaseType_t uxTaskGetCurrentTCBNumberFromISR( void ) PRIVILEGED_FUNCTION;
+
 /*
  * Only available when configUSE_TICKLESS_IDLE is set to 1.
  * If tickless mode is being used, or a low power mode is implemented, then
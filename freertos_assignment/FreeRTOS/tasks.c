@@ -82,6 +82,10 @@ task.h is included from an application file. */
 #include "timers.h"
 #include "StackMacros.h"
 
+#if( configUSE_TICK_TIMERS == 1 )
+	#include "tick_timer.h"
+#endif
+
 /* Lint e961 and e750 are suppressed as a MISRA exception justified because the
 MPU ports require MPU_WRAPPERS_INCLUDED_FROM_API_FILE to be defined for the
 header files above, but not in this file, in order to generate the correct
@@ -169,7 +173,7 @@ typedef struct tskTaskControlBlock
 	#endif
 
 	#if ( configGENERATE_RUN_TIME_STATS == 1 )
-		uint32_t		ulRunTimeCounter;	/*< Stores the amount of time the task has spent in the Running state. */
+		configRUN_TIME_COUNTER_TYPE	ulRunTimeCounter;	/*< Stores the amount of time the task has spent in the Running state. */
 	#endif
 
 	#if ( configUSE_NEWLIB_REENTRANT == 1 )
@@ -188,12 +192,22 @@ typedef struct tskTaskControlBlock
 		volatile eNotifyValue eNotifyState;
 	#endif
 
+	#if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+		uint8_t ucStaticallyAllocated;		/*< Set to pdTRUE if the TCB and stack were supplied by the application, in which case neither is freed if the task is deleted. */
+	#endif
+
 } tskTCB;
 
 /* The old tskTCB name is maintained above then typedefed to the new TCB_t name
 below to enable the use of older kernel aware debuggers. */
 typedef tskTCB TCB_t;
 
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+	/* StaticTask_t (FreeRTOS.h) must be kept the same size as the TCB it
+	stands in for.  This fails to compile if the two have drifted apart. */
+	typedef char tskSTATIC_TCB_SIZE_CHECK[ ( sizeof( StaticTask_t ) == sizeof( TCB_t ) ) ? 1 : -1 ];
+#endif
+
 /*
  * Some kernel aware debuggers require the data the debugger needs access to to
  * be global, rather than file scope.
@@ -257,8 +271,8 @@ PRIVILEGED_DATA static volatile UBaseType_t uxSchedulerSuspended	= ( UBaseType_t
 
 #if ( configGENERATE_RUN_TIME_STATS == 1 )
 
-	PRIVILEGED_DATA static uint32_t ulTaskSwitchedInTime = 0UL;	/*< Holds the value of a timer/counter the last time a task was switched in. */
-	PRIVILEGED_DATA static uint32_t ulTotalRunTime = 0UL;		/*< Holds the total amount of execution time as defined by the run time counter clock. */
+	PRIVILEGED_DATA static configRUN_TIME_COUNTER_TYPE ulTaskSwitchedInTime = 0UL;	/*< Holds the value of a timer/counter the last time a task was switched in. */
+	PRIVILEGED_DATA static configRUN_TIME_COUNTER_TYPE ulTotalRunTime = 0UL;		/*< Holds the total amount of execution time as defined by the run time counter clock. */
 
 #endif
 
@@ -383,7 +397,7 @@ count overflows. */
  * the task.  It is inserted at the end of the list.
  */
 #define prvAddTaskToReadyList( pxTCB )																\
-	traceMOVED_TASK_TO_READY_STATE( pxTCB )															\
+	traceMOVED_TASK_TO_READY_STATE( pxTCB );														\
 	taskRECORD_READY_PRIORITY( ( pxTCB )->uxPriority );												\
 	vListInsertEnd( &( pxReadyTasksLists[ ( pxTCB )->uxPriority ] ), &( ( pxTCB )->xGenericListItem ) )
 /*-----------------------------------------------------------*/
@@ -483,9 +497,19 @@ static void prvAddCurrentTaskToDelayedList( const TickType_t xTimeToWake ) PRIVI
 
 /*
  * Allocates memory from the heap for a TCB and associated stack.  Checks the
- * allocation was successful.
+ * allocation was successful.  If pxTaskBuffer is not NULL the application
+ * has supplied both the TCB and the stack, and nothing is allocated.
  */
-static TCB_t *prvAllocateTCBAndStack( const uint16_t usStackDepth, StackType_t * const puxStackBuffer ) PRIVILEGED_FUNCTION;
+static TCB_t *prvAllocateTCBAndStack( const uint16_t usStackDepth, StackType_t * const puxStackBuffer, StaticTask_t * const pxTaskBuffer ) PRIVILEGED_FUNCTION;
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+	static TCB_t *prvAllocateTCBAndStackFromHeap( const uint16_t usStackDepth, StackType_t * const puxStackBuffer ) PRIVILEGED_FUNCTION;
+#endif
+
+/*
+ * Does the work of both xTaskGenericCreate() and xTaskCreateStatic().
+ */
+static BaseType_t prvTaskGenericCreate( TaskFunction_t pxTaskCode, const char * const pcName, const uint16_t usStackDepth, void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask, StackType_t * const puxStackBuffer, const MemoryRegion_t * const xRegions, StaticTask_t * const pxTaskBuffer ) PRIVILEGED_FUNCTION; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
 
 /*
  * Fills an TaskStatus_t structure with information on each task that is
@@ -544,7 +568,41 @@ static void prvResetNextTaskUnblockTime( void );
 #endif
 /*-----------------------------------------------------------*/
 
-BaseType_t xTaskGenericCreate( TaskFunction_t pxTaskCode, const char * const pcName, const uint16_t usStackDepth, void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask, StackType_t * const puxStackBuffer, const MemoryRegion_t * const xRegions ) /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+
+	BaseType_t xTaskGenericCreate( TaskFunction_t pxTaskCode, const char * const pcName, const uint16_t usStackDepth, void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask, StackType_t * const puxStackBuffer, const MemoryRegion_t * const xRegions ) /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+	{
+		return prvTaskGenericCreate( pxTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pxCreatedTask, puxStackBuffer, xRegions, NULL );
+	}
+
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+/*-----------------------------------------------------------*/
+
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+
+	TaskHandle_t xTaskCreateStatic( TaskFunction_t pxTaskCode, const char * const pcName, const uint16_t usStackDepth, void * const pvParameters, UBaseType_t uxPriority, StackType_t * const puxStackBuffer, StaticTask_t * const pxTaskBuffer ) /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+	{
+	TaskHandle_t xReturn = NULL;
+
+		configASSERT( puxStackBuffer != NULL );
+		configASSERT( pxTaskBuffer != NULL );
+
+		if( ( puxStackBuffer != NULL ) && ( pxTaskBuffer != NULL ) )
+		{
+			( void ) prvTaskGenericCreate( pxTaskCode, pcName, usStackDepth, pvParameters, uxPriority, &xReturn, puxStackBuffer, NULL, pxTaskBuffer );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		return xReturn;
+	}
+
+#endif /* configSUPPORT_STATIC_ALLOCATION */
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvTaskGenericCreate( TaskFunction_t pxTaskCode, const char * const pcName, const uint16_t usStackDepth, void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask, StackType_t * const puxStackBuffer, const MemoryRegion_t * const xRegions, StaticTask_t * const pxTaskBuffer ) /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
 {
 BaseType_t xReturn;
 TCB_t * pxNewTCB;
@@ -555,7 +613,7 @@ StackType_t *pxTopOfStack;
 
 	/* Allocate the memory required by the TCB and stack for the new task,
 	checking that the allocation was successful. */
-	pxNewTCB = prvAllocateTCBAndStack( usStackDepth, puxStackBuffer );
+	pxNewTCB = prvAllocateTCBAndStack( usStackDepth, puxStackBuffer, pxTaskBuffer );
 
 	if( pxNewTCB != NULL )
 	{
@@ -1541,7 +1599,33 @@ void vTaskStartScheduler( void )
 BaseType_t xReturn;
 
 	/* Add the idle task at the lowest priority. */
-	#if ( INCLUDE_xTaskGetIdleTaskHandle == 1 )
+	#if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+	{
+	StaticTask_t *pxIdleTaskTCBBuffer = NULL;
+	StackType_t *pxIdleTaskStackBuffer = NULL;
+	uint16_t usIdleTaskStackSize = tskIDLE_STACK_SIZE;
+	TaskHandle_t xIdleHandle;
+
+		/* The memory used by the idle task is supplied by the application so
+		starting the scheduler never touches the heap. */
+		vApplicationGetIdleTaskMemory( &pxIdleTaskTCBBuffer, &pxIdleTaskStackBuffer, &usIdleTaskStackSize );
+		xIdleHandle = xTaskCreateStatic( prvIdleTask, "IDLE", usIdleTaskStackSize, ( void * ) NULL, ( tskIDLE_PRIORITY | portPRIVILEGE_BIT ), pxIdleTaskStackBuffer, pxIdleTaskTCBBuffer ); /*lint !e961 MISRA exception, justified as it is not a redundant explicit cast to all supported compilers. */
+
+		if( xIdleHandle != NULL )
+		{
+			#if ( INCLUDE_xTaskGetIdleTaskHandle == 1 )
+			{
+				xIdleTaskHandle = xIdleHandle;
+			}
+			#endif /* INCLUDE_xTaskGetIdleTaskHandle */
+			xReturn = pdPASS;
+		}
+		else
+		{
+			xReturn = pdFAIL;
+		}
+	}
+	#elif ( INCLUDE_xTaskGetIdleTaskHandle == 1 )
 	{
 		/* Create the idle task, storing its handle in xIdleTaskHandle so it can
 		be returned by the xTaskGetIdleTaskHandle() function. */
@@ -1552,7 +1636,7 @@ BaseType_t xReturn;
 		/* Create the idle task without storing its handle. */
 		xReturn = xTaskCreate( prvIdleTask, "IDLE", tskIDLE_STACK_SIZE, ( void * ) NULL, ( tskIDLE_PRIORITY | portPRIVILEGE_BIT ), NULL );  /*lint !e961 MISRA exception, justified as it is not a redundant explicit cast to all supported compilers. */
 	}
-	#endif /* INCLUDE_xTaskGetIdleTaskHandle */
+	#endif /* configSUPPORT_STATIC_ALLOCATION */
 
 	#if ( configUSE_TIMERS == 1 )
 	{
@@ -1655,6 +1739,13 @@ void vTaskSuspendAll( void )
 		else
 		{
 			xReturn = xNextTaskUnblockTime - xTickCount;
+
+			#if ( configUSE_TICK_TIMERS == 1 )
+			{
+				/* Wake in time for the next tick timer as well. */
+				xReturn = xTickTimerLimitIdleTime( xTickCount, xReturn );
+			}
+			#endif /* configUSE_TICK_TIMERS */
 		}
 
 		return xReturn;
@@ -1827,7 +1918,7 @@ UBaseType_t uxTaskGetNumberOfTasks( void )
 
 #if ( configUSE_TRACE_FACILITY == 1 )
 
-	UBaseType_t uxTaskGetSystemState( TaskStatus_t * const pxTaskStatusArray, const UBaseType_t uxArraySize, uint32_t * const pulTotalRunTime )
+	UBaseType_t uxTaskGetSystemState( TaskStatus_t * const pxTaskStatusArray, const UBaseType_t uxArraySize, configRUN_TIME_COUNTER_TYPE * const pulTotalRunTime )
 	{
 	UBaseType_t uxTask = 0, uxQueue = configMAX_PRIORITIES;
 
@@ -1870,11 +1961,17 @@ UBaseType_t uxTaskGetNumberOfTasks( void )
 				{
 					if( pulTotalRunTime != NULL )
 					{
-						#ifdef portALT_GET_RUN_TIME_COUNTER_VALUE
-							portALT_GET_RUN_TIME_COUNTER_VALUE( ( *pulTotalRunTime ) );
-						#else
-							*pulTotalRunTime = portGET_RUN_TIME_COUNTER_VALUE();
-						#endif
+						/* Suspending the scheduler does not stop a port that
+						also reads the counter from an interrupt. */
+						taskENTER_CRITICAL();
+						{
+							#ifdef portALT_GET_RUN_TIME_COUNTER_VALUE
+								portALT_GET_RUN_TIME_COUNTER_VALUE( ( *pulTotalRunTime ) );
+							#else
+								*pulTotalRunTime = portGET_RUN_TIME_COUNTER_VALUE();
+							#endif
+						}
+						taskEXIT_CRITICAL();
 					}
 				}
 				#else
@@ -2042,6 +2139,16 @@ BaseType_t xSwitchRequired = pdFALSE;
 					}
 				}
 			}
+
+			#if ( configUSE_TICK_TIMERS == 1 )
+			{
+				/* Tick timers wake their tasks directly (tick_timer.c). */
+				if( xTickTimerProcessTick( xConstTickCount ) != pdFALSE )
+				{
+					xSwitchRequired = pdTRUE;
+				}
+			}
+			#endif /* configUSE_TICK_TIMERS */
 		}
 
 		/* Tasks of equal priority to the currently running task will share
@@ -3016,65 +3123,111 @@ static void prvAddCurrentTaskToDelayedList( const TickType_t xTimeToWake )
 }
 /*-----------------------------------------------------------*/
 
-static TCB_t *prvAllocateTCBAndStack( const uint16_t usStackDepth, StackType_t * const puxStackBuffer )
-{
-TCB_t *pxNewTCB;
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
 
-	/* If the stack grows down then allocate the stack then the TCB so the stack
-	does not grow into the TCB.  Likewise if the stack grows up then allocate
-	the TCB then the stack. */
-	#if( portSTACK_GROWTH > 0 )
+	static TCB_t *prvAllocateTCBAndStackFromHeap( const uint16_t usStackDepth, StackType_t * const puxStackBuffer )
 	{
-		/* Allocate space for the TCB.  Where the memory comes from depends on
-		the implementation of the port malloc function. */
-		pxNewTCB = ( TCB_t * ) pvPortMalloc( sizeof( TCB_t ) );
+	TCB_t *pxNewTCB;
 
-		if( pxNewTCB != NULL )
+		/* If the stack grows down then allocate the stack then the TCB so the stack
+		does not grow into the TCB.  Likewise if the stack grows up then allocate
+		the TCB then the stack. */
+		#if( portSTACK_GROWTH > 0 )
 		{
-			/* Allocate space for the stack used by the task being created.
-			The base of the stack memory stored in the TCB so the task can
-			be deleted later if required. */
-			pxNewTCB->pxStack = ( StackType_t * ) pvPortMallocAligned( ( ( ( size_t ) usStackDepth ) * sizeof( StackType_t ) ), puxStackBuffer ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+			/* Allocate space for the TCB.  Where the memory comes from depends on
+			the implementation of the port malloc function. */
+			pxNewTCB = ( TCB_t * ) pvPortMalloc( sizeof( TCB_t ) );
 
-			if( pxNewTCB->pxStack == NULL )
+			if( pxNewTCB != NULL )
 			{
-				/* Could not allocate the stack.  Delete the allocated TCB. */
-				vPortFree( pxNewTCB );
-				pxNewTCB = NULL;
+				/* Allocate space for the stack used by the task being created.
+				The base of the stack memory stored in the TCB so the task can
+				be deleted later if required. */
+				pxNewTCB->pxStack = ( StackType_t * ) pvPortMallocAligned( ( ( ( size_t ) usStackDepth ) * sizeof( StackType_t ) ), puxStackBuffer ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+
+				if( pxNewTCB->pxStack == NULL )
+				{
+					/* Could not allocate the stack.  Delete the allocated TCB. */
+					vPortFree( pxNewTCB );
+					pxNewTCB = NULL;
+				}
 			}
 		}
-	}
-	#else /* portSTACK_GROWTH */
-	{
-	StackType_t *pxStack;
-
-		/* Allocate space for the stack used by the task being created. */
-		pxStack = ( StackType_t * ) pvPortMallocAligned( ( ( ( size_t ) usStackDepth ) * sizeof( StackType_t ) ), puxStackBuffer ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
-
-		if( pxStack != NULL )
+		#else /* portSTACK_GROWTH */
 		{
-			/* Allocate space for the TCB.  Where the memory comes from depends
-			on the implementation of the port malloc function. */
-			pxNewTCB = ( TCB_t * ) pvPortMalloc( sizeof( TCB_t ) );
+		StackType_t *pxStack;
 
-			if( pxNewTCB != NULL )
+			/* Allocate space for the stack used by the task being created. */
+			pxStack = ( StackType_t * ) pvPortMallocAligned( ( ( ( size_t ) usStackDepth ) * sizeof( StackType_t ) ), puxStackBuffer ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+
+			if( pxStack != NULL )
 			{
-				/* Store the stack location in the TCB. */
-				pxNewTCB->pxStack = pxStack;
+				/* Allocate space for the TCB.  Where the memory comes from depends
+				on the implementation of the port malloc function. */
+				pxNewTCB = ( TCB_t * ) pvPortMalloc( sizeof( TCB_t ) );
+
+				if( pxNewTCB != NULL )
+				{
+					/* Store the stack location in the TCB. */
+					pxNewTCB->pxStack = pxStack;
+				}
+				else
+				{
+					/* The stack cannot be used as the TCB was not created.  Free it
+					again. */
+					vPortFree( pxStack );
+				}
 			}
 			else
 			{
-				/* The stack cannot be used as the TCB was not created.  Free it
-				again. */
-				vPortFree( pxStack );
+				pxNewTCB = NULL;
 			}
 		}
+		#endif /* portSTACK_GROWTH */
+
+		return pxNewTCB;
+	}
+
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+/*-----------------------------------------------------------*/
+
+static TCB_t *prvAllocateTCBAndStack( const uint16_t usStackDepth, StackType_t * const puxStackBuffer, StaticTask_t * const pxTaskBuffer )
+{
+TCB_t *pxNewTCB;
+
+	#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+	{
+		if( pxTaskBuffer != NULL )
+		{
+			/* The application supplied both the TCB and the stack. */
+			pxNewTCB = ( TCB_t * ) pxTaskBuffer;
+			pxNewTCB->pxStack = puxStackBuffer;
+			pxNewTCB->ucStaticallyAllocated = pdTRUE;
+		}
 		else
 		{
-			pxNewTCB = NULL;
+			#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+			{
+				pxNewTCB = prvAllocateTCBAndStackFromHeap( usStackDepth, puxStackBuffer );
+
+				if( pxNewTCB != NULL )
+				{
+					pxNewTCB->ucStaticallyAllocated = pdFALSE;
+				}
+			}
+			#else
+			{
+				pxNewTCB = NULL;
+			}
+			#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
 		}
 	}
-	#endif /* portSTACK_GROWTH */
+	#else
+	{
+		( void ) pxTaskBuffer;
+		pxNewTCB = prvAllocateTCBAndStackFromHeap( usStackDepth, puxStackBuffer );
+	}
+	#endif /* configSUPPORT_STATIC_ALLOCATION */
 
 	if( pxNewTCB != NULL )
 	{
@@ -3176,6 +3329,17 @@ TCB_t *pxNewTCB;
 #endif /* configUSE_TRACE_FACILITY */
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_TRACE_FACILITY == 1 )
+
+	UBaseType_t uxTaskGetCurrentTCBNumberFromISR( void )
+	{
+		/* The running task cannot change while an interrupt is handled. */
+		return pxCurrentTCB->uxTCBNumber;
+	}
+
+#endif /* configUSE_TRACE_FACILITY */
+/*-----------------------------------------------------------*/
+
 #if ( ( configUSE_TRACE_FACILITY == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark == 1 ) )
 
 	static uint16_t prvTaskCheckFreeStackSpace( const uint8_t * pucStackByte )
@@ -3224,6 +3388,89 @@ TCB_t *pxNewTCB;
 #endif /* INCLUDE_uxTaskGetStackHighWaterMark */
 /*-----------------------------------------------------------*/
 
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+
+	configRUN_TIME_COUNTER_TYPE ulTaskGetRunTimeCounter( TaskHandle_t xTask )
+	{
+	TCB_t *pxTCB;
+	configRUN_TIME_COUNTER_TYPE ulReturn, ulNow;
+
+		taskENTER_CRITICAL();
+		{
+			pxTCB = prvGetTCBFromHandle( xTask );
+			ulReturn = pxTCB->ulRunTimeCounter;
+
+			/* The running task is only credited with its current time slice
+			when it is switched out, so add the slice so far. */
+			if( pxTCB == pxCurrentTCB )
+			{
+				#ifdef portALT_GET_RUN_TIME_COUNTER_VALUE
+					portALT_GET_RUN_TIME_COUNTER_VALUE( ulNow );
+				#else
+					ulNow = portGET_RUN_TIME_COUNTER_VALUE();
+				#endif
+
+				if( ulNow > ulTaskSwitchedInTime )
+				{
+					ulReturn += ( ulNow - ulTaskSwitchedInTime );
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		return ulReturn;
+	}
+
+#endif /* configGENERATE_RUN_TIME_STATS */
+/*-----------------------------------------------------------*/
+
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+
+	configRUN_TIME_COUNTER_TYPE ulTaskGetRunTimePercent( TaskHandle_t xTask )
+	{
+	configRUN_TIME_COUNTER_TYPE ulTotalTime, ulReturn;
+
+		/* Both readings are taken in the one critical section, the task's first,
+		so the task's time can never exceed the total. */
+		taskENTER_CRITICAL();
+		{
+			ulReturn = ulTaskGetRunTimeCounter( xTask );
+
+			#ifdef portALT_GET_RUN_TIME_COUNTER_VALUE
+				portALT_GET_RUN_TIME_COUNTER_VALUE( ulTotalTime );
+			#else
+				ulTotalTime = portGET_RUN_TIME_COUNTER_VALUE();
+			#endif
+		}
+		taskEXIT_CRITICAL();
+
+		/* Divide the total rather than multiply the task's time so a 32-bit
+		counter type cannot overflow, as vTaskGetRunTimeStats() does. */
+		ulTotalTime /= 100UL;
+
+		if( ulTotalTime > 0UL )
+		{
+			ulReturn /= ulTotalTime;
+		}
+		else
+		{
+			ulReturn = 0UL;
+		}
+
+		return ulReturn;
+	}
+
+#endif /* configGENERATE_RUN_TIME_STATS */
+/*-----------------------------------------------------------*/
+
 #if ( INCLUDE_vTaskDelete == 1 )
 
 	static void prvDeleteTCB( TCB_t *pxTCB )
@@ -3241,22 +3488,32 @@ TCB_t *pxNewTCB;
 		}
 		#endif /* configUSE_NEWLIB_REENTRANT */
 
-		#if( portUSING_MPU_WRAPPERS == 1 )
+		#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
 		{
-			/* Only free the stack if it was allocated dynamically in the first
-			place. */
-			if( pxTCB->xUsingStaticallyAllocatedStack == pdFALSE )
+			#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+				/* Nothing to free if the application supplied the memory. */
+				if( pxTCB->ucStaticallyAllocated == pdFALSE )
+			#endif /* configSUPPORT_STATIC_ALLOCATION */
 			{
-				vPortFreeAligned( pxTCB->pxStack );
+				#if( portUSING_MPU_WRAPPERS == 1 )
+				{
+					/* Only free the stack if it was allocated dynamically in the
+					first place. */
+					if( pxTCB->xUsingStaticallyAllocatedStack == pdFALSE )
+					{
+						vPortFreeAligned( pxTCB->pxStack );
+					}
+				}
+				#else
+				{
+					vPortFreeAligned( pxTCB->pxStack );
+				}
+				#endif
+
+				vPortFree( pxTCB );
 			}
 		}
-		#else
-		{
-			vPortFreeAligned( pxTCB->pxStack );
-		}
-		#endif
-
-		vPortFree( pxTCB );
+		#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
 	}
 
 #endif /* INCLUDE_vTaskDelete */
@@ -3656,7 +3913,7 @@ TCB_t *pxTCB;
 	{
 	TaskStatus_t *pxTaskStatusArray;
 	volatile UBaseType_t uxArraySize, x;
-	uint32_t ulTotalTime, ulStatsAsPercentage;
+	configRUN_TIME_COUNTER_TYPE ulTotalTime, ulStatsAsPercentage;
 
 		#if( configUSE_TRACE_FACILITY != 1 )
 		{
@@ -3727,7 +3984,7 @@ TCB_t *pxTCB;
 					{
 						#ifdef portLU_PRINTF_SPECIFIER_REQUIRED
 						{
-							sprintf( pcWriteBuffer, "\t%lu\t\t%lu%%\r\n", pxTaskStatusArray[ x ].ulRunTimeCounter, ulStatsAsPercentage );
+							sprintf( pcWriteBuffer, "\t%lu\t\t%lu%%\r\n", ( unsigned long ) pxTaskStatusArray[ x ].ulRunTimeCounter, ( unsigned long ) ulStatsAsPercentage );
 						}
 						#else
 						{
@@ -3743,7 +4000,7 @@ TCB_t *pxTCB;
 						consumed less than 1% of the total run time. */
 						#ifdef portLU_PRINTF_SPECIFIER_REQUIRED
 						{
-							sprintf( pcWriteBuffer, "\t%lu\t\t<1%%\r\n", pxTaskStatusArray[ x ].ulRunTimeCounter );
+							sprintf( pcWriteBuffer, "\t%lu\t\t<1%%\r\n", ( unsigned long ) pxTaskStatusArray[ x ].ulRunTimeCounter );
 						}
 						#else
 						{
@@ -3867,6 +4124,8 @@ TickType_t uxReturn;
 					}
 					#endif /* INCLUDE_vTaskSuspend */
 
+					traceTASK_NOTIFY_TAKE_BLOCK();
+
 					/* All ports are written to allow a yield in a critical
 					section (some will yield immediately, others wait until the
 					critical section exits) - but it is not something that
@@ -3887,6 +4146,7 @@ TickType_t uxReturn;
 
 		taskENTER_CRITICAL();
 		{
+			traceTASK_NOTIFY_TAKE();
 			ulReturn = pxCurrentTCB->ulNotifiedValue;
 
 			if( ulReturn != 0UL )
@@ -3982,6 +4242,8 @@ TickType_t uxReturn;
 					}
 					#endif /* INCLUDE_vTaskSuspend */
 
+					traceTASK_NOTIFY_WAIT_BLOCK();
+
 					/* All ports are written to allow a yield in a critical
 					section (some will yield immediately, others wait until the
 					critical section exits) - but it is not something that
@@ -4002,6 +4264,8 @@ TickType_t uxReturn;
 
 		taskENTER_CRITICAL();
 		{
+			traceTASK_NOTIFY_WAIT();
+
 			if( pulNotificationValue != NULL )
 			{
 				/* Output the current notification value, which may or may not
@@ -4049,6 +4313,7 @@ TickType_t uxReturn;
 
 		taskENTER_CRITICAL();
 		{
+			traceTASK_NOTIFY();
 			eOriginalNotifyState = pxTCB->eNotifyState;
 
 			pxTCB->eNotifyState = eNotified;
@@ -4153,6 +4418,7 @@ TickType_t uxReturn;
 
 		uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
 		{
+			traceTASK_NOTIFY_FROM_ISR();
 			eOriginalNotifyState = pxTCB->eNotifyState;
 
 			pxTCB->eNotifyState = eNotified;
@@ -4264,6 +4530,7 @@ TickType_t uxReturn;
 
 		uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
 		{
+			traceTASK_NOTIFY_GIVE_FROM_ISR();
 			eOriginalNotifyState = pxTCB->eNotifyState;
 			pxTCB->eNotifyState = eNotified;
 
@@ -0,0 +1,328 @@
+/*
+ * Relay telemetry stream.  See telemetry.h.
+ *
+ * Frames are built and copied into the ring with the scheduler suspended, so
+ * frames from different tasks go in whole and in sequence order, and
+ * interrupts are only masked to read the run time counter.  The drain task
+ * hands the bytes to the link outside that section: producers only ever add
+ * after the head, so the bytes between the tail and the head stay put until
+ * the drain task moves the tail.  The indexes run freely and wrap with a mask,
+ * so configTELEMETRY_BUFFER_BYTES must be a power of two.
+ */
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "telemetry.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include <string.h>
+
+#if( configUSE_TELEMETRY == 1 )
+
+#if( ( configTELEMETRY_BUFFER_BYTES & ( configTELEMETRY_BUFFER_BYTES - 1 ) ) != 0 )
+	#error configTELEMETRY_BUFFER_BYTES must be a power of two.
+#endif
+
+#if( ( portRUN_TIME_COUNTER_HZ % 1000000UL ) != 0 )
+	#error Telemetry needs a run time counter clocked at a whole number of MHz.
+#endif
+
+#define telemetryBUFFER_MASK		( ( uint32_t ) configTELEMETRY_BUFFER_BYTES - 1UL )
+#define telemetryCOUNTS_PER_US		( ( uint64_t ) ( portRUN_TIME_COUNTER_HZ / 1000000UL ) )
+
+static uint8_t ucTelemetryBuffer[ configTELEMETRY_BUFFER_BYTES ];
+
+/* Bytes queued and sent since boot.  The next byte queued goes in
+ucTelemetryBuffer[ ulTelemetryHead & telemetryBUFFER_MASK ] and the next sent
+comes from ucTelemetryBuffer[ ulTelemetryTail & telemetryBUFFER_MASK ]. */
+static uint32_t ulTelemetryHead = 0;
+static volatile uint32_t ulTelemetryTail = 0;
+
+static uint16_t usTelemetrySequence = 0;
+static uint32_t ulTelemetryDropped = 0;
+static size_t xTelemetryMaximumQueued = 0;
+
+static TaskHandle_t xTelemetryDrainTask = NULL;
+
+/* CRC-16/CCITT-FALSE a nibble at a time. */
+static const uint16_t usTelemetryCrcTable[ 16 ] =
+{
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Stores ulValue at pucBuffer, least significant byte first.
+ */
+static void prvPutLittleEndian( uint8_t *pucBuffer, uint32_t ulValue, size_t xBytes );
+
+/*
+ * The time in microseconds, low word.
+ */
+static uint32_t prvTimeUs( void );
+
+/*
+ * Numbers, checks, encodes and queues a frame whose payload is already in
+ * pucFrame after the sequence and type.
+ */
+static BaseType_t prvSend( uint8_t ucType, uint8_t *pucFrame, size_t xPayloadLength );
+
+/*-----------------------------------------------------------*/
+
+static void prvPutLittleEndian( uint8_t *pucBuffer, uint32_t ulValue, size_t xBytes )
+{
+size_t x;
+
+	for( x = 0; x < xBytes; x++ )
+	{
+		pucBuffer[ x ] = ( uint8_t ) ( ulValue >> ( 8U * x ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvTimeUs( void )
+{
+UBaseType_t uxSavedInterruptStatus;
+uint64_t ullNow;
+
+	/* port_runtime.c needs interrupts masked while the counter is read. */
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		ullNow = portGET_RUN_TIME_COUNTER_VALUE();
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	return ( uint32_t ) ( ullNow / telemetryCOUNTS_PER_US );
+}
+/*-----------------------------------------------------------*/
+
+uint16_t usTelemetryCrc( uint16_t usCrc, const uint8_t *pucData, size_t xLength )
+{
+	while( xLength-- > 0 )
+	{
+		usCrc = ( uint16_t ) ( ( usCrc << 4 ) ^ usTelemetryCrcTable[ ( usCrc >> 12 ) ^ ( *pucData >> 4 ) ] );
+		usCrc = ( uint16_t ) ( ( usCrc << 4 ) ^ usTelemetryCrcTable[ ( usCrc >> 12 ) ^ ( *pucData & 0x0FU ) ] );
+		pucData++;
+	}
+
+	return usCrc;
+}
+/*-----------------------------------------------------------*/
+
+size_t xTelemetryCobsEncode( const uint8_t *pucData, size_t xLength, uint8_t *pucEncoded )
+{
+size_t xIn, xOut = 1, xCode = 0;
+uint8_t ucRun = 1;
+
+	/* Each zero is replaced by the distance to the next one, the first held in
+	a code byte before the data.  A run of 254 non-zero bytes closes a block
+	without a zero. */
+	for( xIn = 0; xIn < xLength; xIn++ )
+	{
+		if( pucData[ xIn ] == 0U )
+		{
+			pucEncoded[ xCode ] = ucRun;
+			xCode = xOut++;
+			ucRun = 1;
+		}
+		else
+		{
+			pucEncoded[ xOut++ ] = pucData[ xIn ];
+			ucRun++;
+			if( ucRun == 0xFFU )
+			{
+				pucEncoded[ xCode ] = ucRun;
+				xCode = xOut++;
+				ucRun = 1;
+			}
+		}
+	}
+	pucEncoded[ xCode ] = ucRun;
+
+	return xOut;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSend( uint8_t ucType, uint8_t *pucFrame, size_t xPayloadLength )
+{
+uint8_t ucEncoded[ telemetryMAX_ENCODED ];
+size_t xFrameLength = 3 + xPayloadLength, xEncodedLength, xQueued, x;
+uint16_t usCrc;
+BaseType_t xReturn = pdFALSE, xWasEmpty = pdFALSE;
+
+	vTaskSuspendAll();
+	{
+		prvPutLittleEndian( &( pucFrame[ 0 ] ), usTelemetrySequence, 2 );
+		pucFrame[ 2 ] = ucType;
+		usTelemetrySequence++;
+
+		usCrc = usTelemetryCrc( telemetryCRC_INITIAL, pucFrame, xFrameLength );
+		prvPutLittleEndian( &( pucFrame[ xFrameLength ] ), usCrc, 2 );
+		xEncodedLength = xTelemetryCobsEncode( pucFrame, xFrameLength + 2, ucEncoded );
+		ucEncoded[ xEncodedLength++ ] = 0U;
+
+		xQueued = ( size_t ) ( ulTelemetryHead - ulTelemetryTail );
+		if( ( xQueued + xEncodedLength ) <= ( size_t ) configTELEMETRY_BUFFER_BYTES )
+		{
+			for( x = 0; x < xEncodedLength; x++ )
+			{
+				ucTelemetryBuffer[ ( ulTelemetryHead + x ) & telemetryBUFFER_MASK ] = ucEncoded[ x ];
+			}
+			ulTelemetryHead += ( uint32_t ) xEncodedLength;
+
+			xWasEmpty = ( xQueued == 0 ) ? pdTRUE : pdFALSE;
+			if( ( xQueued + xEncodedLength ) > xTelemetryMaximumQueued )
+			{
+				xTelemetryMaximumQueued = xQueued + xEncodedLength;
+			}
+			xReturn = pdTRUE;
+		}
+		else
+		{
+			/* Its sequence number is used up, which tells the receiver. */
+			ulTelemetryDropped++;
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	/* As in logger.c, only a frame into an empty ring needs to wake the drain
+	task. */
+	if( ( xWasEmpty != pdFALSE ) && ( xTelemetryDrainTask != NULL ) )
+	{
+		xTaskNotifyGive( xTelemetryDrainTask );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTelemetrySendSample( uint16_t usFrequency, int16_t sRoc )
+{
+uint8_t ucFrame[ telemetryFRAME_OVERHEAD + 8 ];
+
+	prvPutLittleEndian( &( ucFrame[ 3 ] ), prvTimeUs(), 4 );
+	prvPutLittleEndian( &( ucFrame[ 7 ] ), usFrequency, 2 );
+	prvPutLittleEndian( &( ucFrame[ 9 ] ), ( uint16_t ) sRoc, 2 );
+
+	return prvSend( telemetryFRAME_SAMPLE, ucFrame, 8 );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTelemetrySendState( uint8_t ucState, uint8_t ucPreviousState, uint8_t ucLoads )
+{
+uint8_t ucFrame[ telemetryFRAME_OVERHEAD + 7 ];
+
+	prvPutLittleEndian( &( ucFrame[ 3 ] ), prvTimeUs(), 4 );
+	ucFrame[ 7 ] = ucState;
+	ucFrame[ 8 ] = ucPreviousState;
+	ucFrame[ 9 ] = ucLoads;
+
+	return prvSend( telemetryFRAME_STATE, ucFrame, 7 );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTelemetrySendHeartbeat( void )
+{
+uint8_t ucFrame[ telemetryFRAME_OVERHEAD + 12 ];
+
+	/* Read without the scheduler suspended, so the counts may be a frame
+	behind. */
+	prvPutLittleEndian( &( ucFrame[ 3 ] ), prvTimeUs(), 4 );
+	prvPutLittleEndian( &( ucFrame[ 7 ] ), ulTelemetryDropped, 4 );
+	prvPutLittleEndian( &( ucFrame[ 11 ] ), ulTelemetryHead, 4 );
+
+	return prvSend( telemetryFRAME_HEARTBEAT, ucFrame, 12 );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTelemetrySendEnd( void )
+{
+uint8_t ucFrame[ telemetryFRAME_OVERHEAD ];
+
+	return prvSend( telemetryFRAME_END, ucFrame, 0 );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTelemetrySendFrame( uint8_t ucType, const uint8_t *pucPayload, size_t xLength )
+{
+uint8_t ucFrame[ telemetryFRAME_OVERHEAD + telemetryMAX_PAYLOAD ];
+
+	configASSERT( xLength <= telemetryMAX_PAYLOAD );
+
+	memcpy( &( ucFrame[ 3 ] ), pucPayload, xLength );
+
+	return prvSend( ucType, ucFrame, xLength );
+}
+/*-----------------------------------------------------------*/
+
+void vTelemetrySetDrainTask( TaskHandle_t xTask )
+{
+	xTelemetryDrainTask = xTask;
+}
+/*-----------------------------------------------------------*/
+
+size_t xTelemetryDrain( TelemetryWriteFunction_t pxWrite )
+{
+uint32_t ulHead, ulTail = ulTelemetryTail;
+size_t xContiguous, xWritten;
+
+	for( ;; )
+	{
+		vTaskSuspendAll();
+		{
+			ulHead = ulTelemetryHead;
+		}
+		( void ) xTaskResumeAll();
+
+		if( ulHead == ulTail )
+		{
+			break;
+		}
+
+		/* Up to the end of the buffer at most. */
+		xContiguous = ( size_t ) ( ulHead - ulTail );
+		if( xContiguous > ( size_t ) ( configTELEMETRY_BUFFER_BYTES - ( ulTail & telemetryBUFFER_MASK ) ) )
+		{
+			xContiguous = ( size_t ) ( configTELEMETRY_BUFFER_BYTES - ( ulTail & telemetryBUFFER_MASK ) );
+		}
+
+		xWritten = pxWrite( &( ucTelemetryBuffer[ ulTail & telemetryBUFFER_MASK ] ), xContiguous );
+		ulTail += ( uint32_t ) xWritten;
+		ulTelemetryTail = ulTail;
+
+		if( xWritten < xContiguous )
+		{
+			break;
+		}
+	}
+
+	return ( size_t ) ( ulHead - ulTail );
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulTelemetryGetDropped( void )
+{
+	return ulTelemetryDropped;
+}
+/*-----------------------------------------------------------*/
+
+size_t xTelemetryGetMaximumQueued( void )
+{
+	return xTelemetryMaximumQueued;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulTelemetryGetQueuedBytes( void )
+{
+	return ulTelemetryHead;
+}
+
+#endif /* configUSE_TELEMETRY */
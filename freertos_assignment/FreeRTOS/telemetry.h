@@ -0,0 +1,156 @@
+/*
+ * Relay telemetry stream.
+ *
+ * When configUSE_TELEMETRY is 1 the application sends every frequency sample
+ * and every load manager state change as a small binary frame, and
+ * xTelemetrySend*() queues the encoded frame in a RAM ring of
+ * configTELEMETRY_BUFFER_BYTES bytes.  A low priority task moves the bytes to
+ * the serial UART with xTelemetryDrain(), through a write function that must
+ * not block, such as write() on a UART opened with O_NONBLOCK.  The HAL
+ * driver's interrupt driven transmit buffer then sends them.  If the ring has
+ * no room for a frame the frame is dropped and counted.  Sending never waits,
+ * so a slow or disconnected link cannot hold up the control tasks.
+ *
+ * On the wire each frame is COBS encoded and followed by a zero byte, so a
+ * receiver that starts mid-stream or loses bytes finds the next frame at the
+ * next zero.  Before encoding a frame is:
+ *
+ *     sequence    2 bytes, one more than the previous frame's, dropped
+ *                 frames included, so the receiver can count them
+ *     type        1 byte, telemetryFRAME_*
+ *     payload     0 to telemetryMAX_PAYLOAD bytes, by type, below
+ *     CRC         2 bytes, CRC-16/CCITT-FALSE of the sequence, type and
+ *                 payload
+ *
+ * Multi-byte fields are little endian.  host/tools/telemetry_recv decodes the
+ * stream.  Times come from the run time statistics counter (port_runtime.c),
+ * so configGENERATE_RUN_TIME_STATS must be 1.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Frame types.  Values are part of the stream format read by telemetry_recv,
+so only ever add to the end. */
+#define telemetryFRAME_SAMPLE		1	/* Time in us (4), frequency in 0.01 Hz (2), RoC in 0.01 Hz/s (2, signed). */
+#define telemetryFRAME_STATE		2	/* Time in us (4), new state (1), previous state (1), loads connected (1). */
+#define telemetryFRAME_HEARTBEAT	3	/* Time in us (4), frames dropped since boot (4), bytes queued since boot (4). */
+#define telemetryFRAME_END			4	/* No payload.  The sender has stopped, used by the host bench. */
+#define telemetryFRAME_RESPONSE		5	/* The reply to a request on the command channel, laid out in command.h. */
+
+/* Enough for the largest command response. */
+#define telemetryMAX_PAYLOAD		56
+
+/* Sequence, type and CRC around the payload. */
+#define telemetryFRAME_OVERHEAD		5
+
+/* Largest frame on the wire: COBS adds a byte per 254 and the delimiter one
+more.  Frames are built on the sender's stack, so keep this small. */
+#define telemetryMAX_ENCODED		( telemetryFRAME_OVERHEAD + telemetryMAX_PAYLOAD + 2 )
+
+/* CRC-16/CCITT-FALSE: polynomial 0x1021, initial value 0xFFFF. */
+#define telemetryCRC_INITIAL		0xFFFFU
+
+/* Writes up to xLength bytes without blocking and returns how many it took,
+which may be 0. */
+typedef size_t ( *TelemetryWriteFunction_t )( const uint8_t *pucData, size_t xLength );
+
+/* Only the definitions above are needed to decode the stream, so the host
+receiver includes this header without FreeRTOS.h. */
+#ifdef INC_FREERTOS_H
+
+#include "task.h"
+
+/**
+ * telemetry. h
+ * <pre>
+ uint16_t usTelemetryCrc( uint16_t usCrc, const uint8_t *pucData, size_t xLength );
+ size_t xTelemetryCobsEncode( const uint8_t *pucData, size_t xLength, uint8_t *pucEncoded );
+ * </pre>
+ *
+ * The frame's CRC, continued from usCrc, and its COBS encoding.  The encoding
+ * is written to pucEncoded without the delimiter, and its length returned.
+ * pucEncoded needs xLength + 1 bytes for frames under 254 bytes.
+ */
+uint16_t usTelemetryCrc( uint16_t usCrc, const uint8_t *pucData, size_t xLength ) PRIVILEGED_FUNCTION;
+size_t xTelemetryCobsEncode( const uint8_t *pucData, size_t xLength, uint8_t *pucEncoded ) PRIVILEGED_FUNCTION;
+
+/**
+ * telemetry. h
+ * <pre>
+ BaseType_t xTelemetrySendSample( uint16_t usFrequency, int16_t sRoc );
+ BaseType_t xTelemetrySendState( uint8_t ucState, uint8_t ucPreviousState, uint8_t ucLoads );
+ BaseType_t xTelemetrySendHeartbeat( void );
+ BaseType_t xTelemetrySendEnd( void );
+ BaseType_t xTelemetrySendFrame( uint8_t ucType, const uint8_t *pucPayload, size_t xLength );
+ * </pre>
+ *
+ * Stamp, encode and queue a frame.  The scheduler is suspended while the
+ * frame is numbered and copied into the ring, and interrupts are masked only
+ * to read the time.  Never blocks.  Tasks only.  xTelemetrySendFrame() sends
+ * a payload of up to telemetryMAX_PAYLOAD bytes built by the caller, such as
+ * a command response.
+ *
+ * @return pdTRUE if the frame was queued, pdFALSE if it was dropped because
+ * the ring was full.
+ */
+BaseType_t xTelemetrySendSample( uint16_t usFrequency, int16_t sRoc ) PRIVILEGED_FUNCTION;
+BaseType_t xTelemetrySendState( uint8_t ucState, uint8_t ucPreviousState, uint8_t ucLoads ) PRIVILEGED_FUNCTION;
+BaseType_t xTelemetrySendHeartbeat( void ) PRIVILEGED_FUNCTION;
+BaseType_t xTelemetrySendEnd( void ) PRIVILEGED_FUNCTION;
+BaseType_t xTelemetrySendFrame( uint8_t ucType, const uint8_t *pucPayload, size_t xLength ) PRIVILEGED_FUNCTION;
+
+/**
+ * telemetry. h
+ * <pre>
+ void vTelemetrySetDrainTask( TaskHandle_t xTask );
+ * </pre>
+ *
+ * Sets the task woken by the first frame queued into an empty ring.
+ */
+void vTelemetrySetDrainTask( TaskHandle_t xTask ) PRIVILEGED_FUNCTION;
+
+/**
+ * telemetry. h
+ * <pre>
+ size_t xTelemetryDrain( TelemetryWriteFunction_t pxWrite );
+ * </pre>
+ *
+ * Hands queued bytes to pxWrite, oldest first, until the ring is empty or
+ * pxWrite takes less than it was offered.  Only one task may drain.
+ *
+ * @return The bytes still queued.  When not 0 the link is busy; try again
+ * later.
+ */
+size_t xTelemetryDrain( TelemetryWriteFunction_t pxWrite ) PRIVILEGED_FUNCTION;
+
+/**
+ * telemetry. h
+ * <pre>
+ uint32_t ulTelemetryGetDropped( void );
+ size_t xTelemetryGetMaximumQueued( void );
+ uint32_t ulTelemetryGetQueuedBytes( void );
+ * </pre>
+ *
+ * Frames dropped since boot because the ring was full, the most bytes the
+ * ring has held at once, and the bytes queued since boot, which a frame just
+ * sent ends at.
+ */
+uint32_t ulTelemetryGetDropped( void ) PRIVILEGED_FUNCTION;
+size_t xTelemetryGetMaximumQueued( void ) PRIVILEGED_FUNCTION;
+uint32_t ulTelemetryGetQueuedBytes( void ) PRIVILEGED_FUNCTION;
+
+#endif /* INC_FREERTOS_H */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TELEMETRY_H */
@@ -0,0 +1,180 @@
+/*
+ * One-shot tick timers.  See tick_timer.h for a description of the API.
+ */
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "tick_timer.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( configUSE_TICK_TIMERS == 1 )
+
+/* Running timers, in no particular order.  Initialised by the first call to
+vTickTimerInit(), and only read by the kernel once it has been. */
+static List_t xRunningTickTimers;
+
+/*-----------------------------------------------------------*/
+
+void vTickTimerInit( TickTimer_t *pxTimer, TaskHandle_t xTask, uint32_t ulNotifyBits )
+{
+	configASSERT( pxTimer );
+	configASSERT( xTask );
+
+	taskENTER_CRITICAL();
+	{
+		if( listLIST_IS_INITIALISED( &xRunningTickTimers ) == pdFALSE )
+		{
+			vListInitialise( &xRunningTickTimers );
+		}
+
+		vListInitialiseItem( &( pxTimer->xListItem ) );
+		listSET_LIST_ITEM_OWNER( &( pxTimer->xListItem ), pxTimer );
+		pxTimer->xStartTick = 0;
+		pxTimer->xPeriod = 0;
+		pxTimer->xTask = xTask;
+		pxTimer->ulNotifyBits = ulNotifyBits;
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void vTickTimerStart( TickTimer_t *pxTimer, TickType_t xPeriod )
+{
+	configASSERT( pxTimer );
+	configASSERT( xPeriod > 0 );
+
+	taskENTER_CRITICAL();
+	{
+		/* Expiry is kept as a start and a length rather than an absolute
+		tick so the compare in xTickTimerProcessTick() survives the tick count
+		wrapping. */
+		pxTimer->xStartTick = xTaskGetTickCount();
+		pxTimer->xPeriod = xPeriod;
+
+		if( listLIST_ITEM_CONTAINER( &( pxTimer->xListItem ) ) == NULL )
+		{
+			vListInsertEnd( &xRunningTickTimers, &( pxTimer->xListItem ) );
+		}
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void vTickTimerStop( TickTimer_t *pxTimer )
+{
+	configASSERT( pxTimer );
+
+	taskENTER_CRITICAL();
+	{
+		if( listLIST_ITEM_CONTAINER( &( pxTimer->xListItem ) ) != NULL )
+		{
+			( void ) uxListRemove( &( pxTimer->xListItem ) );
+		}
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTickTimerIsActive( TickTimer_t *pxTimer )
+{
+BaseType_t xReturn;
+
+	configASSERT( pxTimer );
+
+	taskENTER_CRITICAL();
+	{
+		xReturn = ( listLIST_ITEM_CONTAINER( &( pxTimer->xListItem ) ) != NULL ) ? pdTRUE : pdFALSE;
+	}
+	taskEXIT_CRITICAL();
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+TickType_t xTickTimerGetRemaining( TickTimer_t *pxTimer )
+{
+TickType_t xElapsed, xRemaining = 0;
+
+	configASSERT( pxTimer );
+
+	taskENTER_CRITICAL();
+	{
+		if( listLIST_ITEM_CONTAINER( &( pxTimer->xListItem ) ) != NULL )
+		{
+			xElapsed = ( TickType_t ) ( xTaskGetTickCount() - pxTimer->xStartTick );
+			xRemaining = ( xElapsed < pxTimer->xPeriod ) ? ( pxTimer->xPeriod - xElapsed ) : 0;
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return xRemaining;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTickTimerProcessTick( TickType_t xNow )
+{
+ListItem_t *pxItem, *pxNext;
+TickTimer_t *pxTimer;
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	if( listLIST_IS_INITIALISED( &xRunningTickTimers ) == pdFALSE )
+	{
+		return pdFALSE;
+	}
+
+	for( pxItem = listGET_HEAD_ENTRY( &xRunningTickTimers ); pxItem != listGET_END_MARKER( &xRunningTickTimers ); pxItem = pxNext )
+	{
+		pxNext = listGET_NEXT( pxItem );
+		pxTimer = ( TickTimer_t * ) listGET_LIST_ITEM_OWNER( pxItem );
+
+		if( ( TickType_t ) ( xNow - pxTimer->xStartTick ) >= pxTimer->xPeriod )
+		{
+			( void ) uxListRemove( pxItem );
+			( void ) xTaskNotifyFromISR( pxTimer->xTask, pxTimer->ulNotifyBits, eSetBits, &xHigherPriorityTaskWoken );
+		}
+	}
+
+	return xHigherPriorityTaskWoken;
+}
+/*-----------------------------------------------------------*/
+
+TickType_t xTickTimerLimitIdleTime( TickType_t xNow, TickType_t xExpectedIdleTime )
+{
+ListItem_t *pxItem;
+TickTimer_t *pxTimer;
+TickType_t xElapsed, xRemaining;
+UBaseType_t uxSavedInterruptStatus;
+
+	if( listLIST_IS_INITIALISED( &xRunningTickTimers ) == pdFALSE )
+	{
+		return xExpectedIdleTime;
+	}
+
+	/* The idle task calls this with the scheduler suspended, but the tick
+	interrupt can still take timers off the list. */
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		for( pxItem = listGET_HEAD_ENTRY( &xRunningTickTimers ); pxItem != listGET_END_MARKER( &xRunningTickTimers ); pxItem = listGET_NEXT( pxItem ) )
+		{
+			pxTimer = ( TickTimer_t * ) listGET_LIST_ITEM_OWNER( pxItem );
+			xElapsed = ( TickType_t ) ( xNow - pxTimer->xStartTick );
+			xRemaining = ( xElapsed < pxTimer->xPeriod ) ? ( pxTimer->xPeriod - xElapsed ) : 0;
+
+			if( xRemaining < xExpectedIdleTime )
+			{
+				xExpectedIdleTime = xRemaining;
+			}
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	return xExpectedIdleTime;
+}
+
+#endif /* configUSE_TICK_TIMERS */
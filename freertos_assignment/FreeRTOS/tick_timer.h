@@ -0,0 +1,96 @@
+/*
+ * One-shot tick timers that wake a task directly.
+ *
+ * A tick timer is checked by the kernel on every tick, from
+ * xTaskIncrementTick(), and when it expires it sets bits in its task's
+ * notification value with xTaskNotifyFromISR( eSetBits ).  There is no timer
+ * service task and no command queue: starting, restarting and stopping a timer
+ * take a short critical section and never block, switch task or fail.  The
+ * tickless idle code will not sleep past the next expiry.
+ *
+ * Running timers are kept in one unsorted list, so each tick costs one compare
+ * per running timer.  They suit a handful of timers that are restarted often.
+ * Software timers (timers.h) remain for callbacks and for large numbers of
+ * timers.
+ */
+
+#ifndef TICK_TIMER_H
+#define TICK_TIMER_H
+
+#ifndef INC_TASK_H
+	#error "include task.h" must appear in source files before "include tick_timer.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A tick timer.  Declared by the application, normally statically, and only
+ * accessed through the functions below.
+ */
+typedef struct xTICK_TIMER
+{
+	ListItem_t xListItem;		/*<< In the running timer list while the timer runs. */
+	TickType_t xStartTick;		/*<< Tick count when the timer was last started. */
+	TickType_t xPeriod;			/*<< Ticks from the start to expiry. */
+	TaskHandle_t xTask;			/*<< Task notified on expiry. */
+	uint32_t ulNotifyBits;		/*<< Bits set in its notification value. */
+} TickTimer_t;
+
+/**
+ * tick_timer. h
+ * <pre>
+ void vTickTimerInit( TickTimer_t *pxTimer, TaskHandle_t xTask, uint32_t ulNotifyBits );
+ * </pre>
+ *
+ * Sets up a stopped timer that, each time it expires, sets ulNotifyBits in
+ * xTask's notification value.  The task can wait for them with
+ * xTaskNotifyWait().  Must be called before the timer is used, from a task or
+ * before the scheduler is started.
+ */
+void vTickTimerInit( TickTimer_t *pxTimer, TaskHandle_t xTask, uint32_t ulNotifyBits ) PRIVILEGED_FUNCTION;
+
+/**
+ * tick_timer. h
+ * <pre>
+ void vTickTimerStart( TickTimer_t *pxTimer, TickType_t xPeriod );
+ void vTickTimerStop( TickTimer_t *pxTimer );
+ BaseType_t xTickTimerIsActive( TickTimer_t *pxTimer );
+ TickType_t xTickTimerGetRemaining( TickTimer_t *pxTimer );
+ * </pre>
+ *
+ * vTickTimerStart() starts the timer to expire xPeriod ticks from now, or
+ * restarts it if it is already running.  vTickTimerStop() stops it if it is
+ * running.  Neither clears bits already set by an earlier expiry.  Both are
+ * O(1) and must be called from a task.
+ *
+ * xTickTimerIsActive() returns pdTRUE while the timer is running.
+ * xTickTimerGetRemaining() returns the ticks left before it expires, 0 if it
+ * is not running, so a timer can be saved and started again later with what
+ * it had left.
+ */
+void vTickTimerStart( TickTimer_t *pxTimer, TickType_t xPeriod ) PRIVILEGED_FUNCTION;
+void vTickTimerStop( TickTimer_t *pxTimer ) PRIVILEGED_FUNCTION;
+BaseType_t xTickTimerIsActive( TickTimer_t *pxTimer ) PRIVILEGED_FUNCTION;
+TickType_t xTickTimerGetRemaining( TickTimer_t *pxTimer ) PRIVILEGED_FUNCTION;
+
+/*
+ * THE FOLLOWING FUNCTIONS ARE CALLED BY THE KERNEL AND ARE NOT PART OF THE
+ * PUBLIC API.
+ *
+ * xTickTimerProcessTick() notifies the tasks of every timer that has expired
+ * by xNow and returns pdTRUE if one of them should preempt the running task.
+ * Called from xTaskIncrementTick() with interrupts masked.
+ *
+ * xTickTimerLimitIdleTime() returns xExpectedIdleTime, cut short so the idle
+ * task does not sleep past the next expiry.
+ */
+BaseType_t xTickTimerProcessTick( TickType_t xNow ) PRIVILEGED_FUNCTION;
+TickType_t xTickTimerLimitIdleTime( TickType_t xNow, TickType_t xExpectedIdleTime ) PRIVILEGED_FUNCTION;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TICK_TIMER_H */
@@ -100,6 +100,17 @@ configUSE_TIMERS is set to 1 in FreeRTOSConfig.h. */
 /* Misc definitions. */
 #define tmrNO_DELAY		( TickType_t ) 0U
 
+#if( configUSE_TIMER_WHEEL == 1 )
+
+	/* Levels of 64 slots each, enough levels to span every bit of the tick
+	count.  A slot in level N covers 64^N ticks. */
+	#define tmrWHEEL_SLOT_BITS		( 6 )
+	#define tmrWHEEL_SLOTS			( ( UBaseType_t ) 1 << tmrWHEEL_SLOT_BITS )
+	#define tmrWHEEL_SLOT_MASK		( tmrWHEEL_SLOTS - ( UBaseType_t ) 1 )
+	#define tmrWHEEL_LEVELS			( ( ( sizeof( TickType_t ) * 8 ) + tmrWHEEL_SLOT_BITS - 1 ) / tmrWHEEL_SLOT_BITS )
+
+#endif /* configUSE_TIMER_WHEEL */
+
 /* The definition of the timers themselves. */
 typedef struct tmrTimerControl
 {
@@ -112,12 +123,22 @@ typedef struct tmrTimerControl
 	#if( configUSE_TRACE_FACILITY == 1 )
 		UBaseType_t			uxTimerNumber;		/*<< An ID assigned by trace tools such as FreeRTOS+Trace */
 	#endif
+	#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+		uint8_t				ucStaticallyAllocated; /*<< Set to pdTRUE if the timer structure was supplied by the application, so it is not freed when the timer is deleted. */
+	#endif
 } xTIMER;
 
 /* The old xTIMER name is maintained above then typedefed to the new Timer_t
 name below to enable the use of older kernel aware debuggers. */
 typedef xTIMER Timer_t;
 
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+	/* StaticTimer_t (FreeRTOS.h) must be kept the same size as the timer
+	structure it stands in for.  This fails to compile if the two have drifted
+	apart. */
+	typedef char tmrSTATIC_TIMER_SIZE_CHECK[ ( sizeof( StaticTimer_t ) == sizeof( Timer_t ) ) ? 1 : -1 ];
+#endif
+
 /* The definition of messages that can be sent and received on the timer queue.
 Two types of message can be queued - messages that manipulate a software timer,
 and messages that request the execution of a non-timer related callback.  The
@@ -157,13 +178,38 @@ typedef struct tmrTimerQueueMessage
 /*lint -e956 A manual analysis and inspection has been used to determine which
 static variables must be declared volatile. */
 
-/* The list in which active timers are stored.  Timers are referenced in expire
-time order, with the nearest expiry time at the front of the list.  Only the
-timer service task is allowed to access these lists. */
-PRIVILEGED_DATA static List_t xActiveTimerList1;
-PRIVILEGED_DATA static List_t xActiveTimerList2;
-PRIVILEGED_DATA static List_t *pxCurrentTimerList;
-PRIVILEGED_DATA static List_t *pxOverflowTimerList;
+#if( configUSE_TIMER_WHEEL == 1 )
+
+	/* Active timers are hashed into a hierarchical timer wheel by expiry time.
+	A timer due within 64 ticks of xTimerWheelTime sits in the level 0 slot for
+	its expiry tick.  A timer due further out sits in the slot of the lowest
+	level that can hold it, and is moved (cascaded) down a level each time
+	xTimerWheelTime reaches the start of its slot, so it is in level 0 by the
+	time it is due.  Starting, stopping and expiring a timer are each a list
+	insert or remove at a known slot, so no list is ever searched.  A bit per
+	slot records which slots hold timers, so ticks with nothing to do are
+	stepped over.  Only the timer service task is allowed to access the
+	wheel. */
+	PRIVILEGED_DATA static List_t xTimerWheel[ tmrWHEEL_LEVELS ][ tmrWHEEL_SLOTS ];
+	PRIVILEGED_DATA static uint64_t ullTimerWheelOccupied[ tmrWHEEL_LEVELS ];
+
+	/* The first tick the wheel has not yet processed. */
+	PRIVILEGED_DATA static TickType_t xTimerWheelTime = ( TickType_t ) 0U;
+
+	/* Number of timers in the wheel. */
+	PRIVILEGED_DATA static UBaseType_t uxTimerWheelCount = ( UBaseType_t ) 0U;
+
+#else
+
+	/* The list in which active timers are stored.  Timers are referenced in
+	expire time order, with the nearest expiry time at the front of the list.
+	Only the timer service task is allowed to access these lists. */
+	PRIVILEGED_DATA static List_t xActiveTimerList1;
+	PRIVILEGED_DATA static List_t xActiveTimerList2;
+	PRIVILEGED_DATA static List_t *pxCurrentTimerList;
+	PRIVILEGED_DATA static List_t *pxOverflowTimerList;
+
+#endif /* configUSE_TIMER_WHEEL */
 
 /* A queue that is used to send commands to the timer service task. */
 PRIVILEGED_DATA static QueueHandle_t xTimerQueue = NULL;
@@ -174,6 +220,15 @@ PRIVILEGED_DATA static QueueHandle_t xTimerQueue = NULL;
 
 #endif
 
+#if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+
+	/* The timer queue is created by the kernel rather than the application, so
+	when static allocation is in use its memory is reserved here. */
+	PRIVILEGED_DATA static StaticQueue_t xStaticTimerQueue;
+	PRIVILEGED_DATA static uint8_t ucStaticTimerQueueStorage[ ( size_t ) configTIMER_QUEUE_LENGTH * sizeof( DaemonTaskMessage_t ) ];
+
+#endif
+
 /*lint +e956 */
 
 /*-----------------------------------------------------------*/
@@ -210,10 +265,46 @@ static BaseType_t prvInsertTimerInActiveList( Timer_t * const pxTimer, const Tic
 static void prvProcessExpiredTimer( const TickType_t xNextExpireTime, const TickType_t xTimeNow ) PRIVILEGED_FUNCTION;
 
 /*
- * The tick count has overflowed.  Switch the timer lists after ensuring the
- * current timer list does not still reference some timers.
+ * Remove a timer from the active timers.  The timer must be active.
  */
-static void prvSwitchTimerLists( void ) PRIVILEGED_FUNCTION;
+static void prvRemoveTimerFromActiveList( Timer_t * const pxTimer ) PRIVILEGED_FUNCTION;
+
+#if( configUSE_TIMER_WHEEL == 1 )
+
+	/*
+	 * Place a timer in the wheel slot for xExpiryTime, relative to
+	 * xTimerWheelTime.
+	 */
+	static void prvInsertTimerInWheel( Timer_t * const pxTimer, const TickType_t xExpiryTime ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Return how many slots on from uxSlot, wrapping, the next occupied slot
+	 * in level uxLevel is, or tmrWHEEL_SLOTS if the level is empty.
+	 */
+	static UBaseType_t prvNextOccupiedSlot( const UBaseType_t uxLevel, const UBaseType_t uxSlot ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * xTimerWheelTime has reached the start of a level 1 slot.  Move the timers
+	 * in that slot, and in any higher level slot that also starts now, down the
+	 * wheel.
+	 */
+	static void prvCascadeTimerWheel( void ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Process every tick from xTimerWheelTime up to and including xTimeNow,
+	 * expiring the timers due in them.
+	 */
+	static void prvAdvanceTimerWheel( const TickType_t xTimeNow ) PRIVILEGED_FUNCTION;
+
+#else
+
+	/*
+	 * The tick count has overflowed.  Switch the timer lists after ensuring the
+	 * current timer list does not still reference some timers.
+	 */
+	static void prvSwitchTimerLists( void ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_TIMER_WHEEL */
 
 /*
  * Obtain the current tick count, setting *pxTimerListsWereSwitched to pdTRUE
@@ -225,7 +316,8 @@ static TickType_t prvSampleTimeNow( BaseType_t * const pxTimerListsWereSwitched
  * If the timer list contains any active timers then return the expire time of
  * the timer that will expire first and set *pxListWasEmpty to false.  If the
  * timer list does not contain any timers then return 0 and set *pxListWasEmpty
- * to pdTRUE.
+ * to pdTRUE.  With the timer wheel the time returned is the next tick at which
+ * the wheel has work to do, which may be a cascade rather than an expiry.
  */
 static TickType_t prvGetNextExpireTime( BaseType_t * const pxListWasEmpty ) PRIVILEGED_FUNCTION;
 
@@ -235,6 +327,12 @@ static TickType_t prvGetNextExpireTime( BaseType_t * const pxListWasEmpty ) PRIV
  */
 static void prvProcessTimerOrBlockTask( const TickType_t xNextExpireTime, const BaseType_t xListWasEmpty ) PRIVILEGED_FUNCTION;
 
+/*
+ * Initialises the members of a timer structure that has already been obtained,
+ * either from the heap or from the application.
+ */
+static void prvInitialiseNewTimer( const char * const pcTimerName, const TickType_t xTimerPeriodInTicks, const UBaseType_t uxAutoReload, void * const pvTimerID, TimerCallbackFunction_t pxCallbackFunction, Timer_t *pxNewTimer ) PRIVILEGED_FUNCTION; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+
 /*-----------------------------------------------------------*/
 
 BaseType_t xTimerCreateTimerTask( void )
@@ -249,7 +347,29 @@ BaseType_t xReturn = pdFAIL;
 
 	if( xTimerQueue != NULL )
 	{
-		#if ( INCLUDE_xTimerGetTimerDaemonTaskHandle == 1 )
+		#if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+		{
+		StaticTask_t *pxTimerTaskTCBBuffer = NULL;
+		StackType_t *pxTimerTaskStackBuffer = NULL;
+		uint16_t usTimerTaskStackSize = ( uint16_t ) configTIMER_TASK_STACK_DEPTH;
+		TaskHandle_t xTimerHandle;
+
+			/* The memory used by the timer task is supplied by the
+			application. */
+			vApplicationGetTimerTaskMemory( &pxTimerTaskTCBBuffer, &pxTimerTaskStackBuffer, &usTimerTaskStackSize );
+			xTimerHandle = xTaskCreateStatic( prvTimerTask, "Tmr Svc", usTimerTaskStackSize, NULL, ( ( UBaseType_t ) configTIMER_TASK_PRIORITY ) | portPRIVILEGE_BIT, pxTimerTaskStackBuffer, pxTimerTaskTCBBuffer );
+
+			if( xTimerHandle != NULL )
+			{
+				#if ( INCLUDE_xTimerGetTimerDaemonTaskHandle == 1 )
+				{
+					xTimerTaskHandle = xTimerHandle;
+				}
+				#endif
+				xReturn = pdPASS;
+			}
+		}
+		#elif ( INCLUDE_xTimerGetTimerDaemonTaskHandle == 1 )
 		{
 			/* Create the timer task, storing its handle in xTimerTaskHandle so
 			it can be returned by the xTimerGetTimerDaemonTaskHandle() function. */
@@ -272,45 +392,88 @@ BaseType_t xReturn = pdFAIL;
 }
 /*-----------------------------------------------------------*/
 
-TimerHandle_t xTimerCreate( const char * const pcTimerName, const TickType_t xTimerPeriodInTicks, const UBaseType_t uxAutoReload, void * const pvTimerID, TimerCallbackFunction_t pxCallbackFunction ) /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+static void prvInitialiseNewTimer( const char * const pcTimerName, const TickType_t xTimerPeriodInTicks, const UBaseType_t uxAutoReload, void * const pvTimerID, TimerCallbackFunction_t pxCallbackFunction, Timer_t *pxNewTimer ) /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
 {
-Timer_t *pxNewTimer;
+	/* Ensure the infrastructure used by the timer service task has been
+	created/initialised. */
+	prvCheckForValidListAndQueue();
+
+	/* Initialise the timer structure members using the function parameters. */
+	pxNewTimer->pcTimerName = pcTimerName;
+	pxNewTimer->xTimerPeriodInTicks = xTimerPeriodInTicks;
+	pxNewTimer->uxAutoReload = uxAutoReload;
+	pxNewTimer->pvTimerID = pvTimerID;
+	pxNewTimer->pxCallbackFunction = pxCallbackFunction;
+	vListInitialiseItem( &( pxNewTimer->xTimerListItem ) );
 
-	/* Allocate the timer structure. */
-	if( xTimerPeriodInTicks == ( TickType_t ) 0U )
+	traceTIMER_CREATE( pxNewTimer );
+}
+/*-----------------------------------------------------------*/
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+
+	TimerHandle_t xTimerCreate( const char * const pcTimerName, const TickType_t xTimerPeriodInTicks, const UBaseType_t uxAutoReload, void * const pvTimerID, TimerCallbackFunction_t pxCallbackFunction ) /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
 	{
-		pxNewTimer = NULL;
+	Timer_t *pxNewTimer;
+
+		/* Allocate the timer structure. */
+		if( xTimerPeriodInTicks == ( TickType_t ) 0U )
+		{
+			pxNewTimer = NULL;
+		}
+		else
+		{
+			pxNewTimer = ( Timer_t * ) pvPortMalloc( sizeof( Timer_t ) );
+			if( pxNewTimer != NULL )
+			{
+				prvInitialiseNewTimer( pcTimerName, xTimerPeriodInTicks, uxAutoReload, pvTimerID, pxCallbackFunction, pxNewTimer );
+
+				#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+				{
+					pxNewTimer->ucStaticallyAllocated = pdFALSE;
+				}
+				#endif /* configSUPPORT_STATIC_ALLOCATION */
+			}
+			else
+			{
+				traceTIMER_CREATE_FAILED();
+			}
+		}
+
+		/* 0 is not a valid value for xTimerPeriodInTicks. */
+		configASSERT( ( xTimerPeriodInTicks > 0 ) );
+
+		return ( TimerHandle_t ) pxNewTimer;
 	}
-	else
+
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+/*-----------------------------------------------------------*/
+
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+
+	TimerHandle_t xTimerCreateStatic( const char * const pcTimerName, const TickType_t xTimerPeriodInTicks, const UBaseType_t uxAutoReload, void * const pvTimerID, TimerCallbackFunction_t pxCallbackFunction, StaticTimer_t *pxTimerBuffer ) /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
 	{
-		pxNewTimer = ( Timer_t * ) pvPortMalloc( sizeof( Timer_t ) );
-		if( pxNewTimer != NULL )
-		{
-			/* Ensure the infrastructure used by the timer service task has been
-			created/initialised. */
-			prvCheckForValidListAndQueue();
+	Timer_t *pxNewTimer = NULL;
 
-			/* Initialise the timer structure members using the function parameters. */
-			pxNewTimer->pcTimerName = pcTimerName;
-			pxNewTimer->xTimerPeriodInTicks = xTimerPeriodInTicks;
-			pxNewTimer->uxAutoReload = uxAutoReload;
-			pxNewTimer->pvTimerID = pvTimerID;
-			pxNewTimer->pxCallbackFunction = pxCallbackFunction;
-			vListInitialiseItem( &( pxNewTimer->xTimerListItem ) );
+		/* 0 is not a valid value for xTimerPeriodInTicks. */
+		configASSERT( ( xTimerPeriodInTicks > 0 ) );
+		configASSERT( pxTimerBuffer != NULL );
 
-			traceTIMER_CREATE( pxNewTimer );
+		if( ( xTimerPeriodInTicks != ( TickType_t ) 0U ) && ( pxTimerBuffer != NULL ) )
+		{
+			pxNewTimer = ( Timer_t * ) pxTimerBuffer;
+			prvInitialiseNewTimer( pcTimerName, xTimerPeriodInTicks, uxAutoReload, pvTimerID, pxCallbackFunction, pxNewTimer );
+			pxNewTimer->ucStaticallyAllocated = pdTRUE;
 		}
 		else
 		{
 			traceTIMER_CREATE_FAILED();
 		}
-	}
 
-	/* 0 is not a valid value for xTimerPeriodInTicks. */
-	configASSERT( ( xTimerPeriodInTicks > 0 ) );
+		return ( TimerHandle_t ) pxNewTimer;
+	}
 
-	return ( TimerHandle_t ) pxNewTimer;
-}
+#endif /* configSUPPORT_STATIC_ALLOCATION */
 /*-----------------------------------------------------------*/
 
 BaseType_t xTimerGenericCommand( TimerHandle_t xTimer, const BaseType_t xCommandID, const TickType_t xOptionalValue, BaseType_t * const pxHigherPriorityTaskWoken, const TickType_t xTicksToWait )
@@ -378,11 +541,15 @@ Timer_t *pxTimer = ( Timer_t * ) xTimer;
 static void prvProcessExpiredTimer( const TickType_t xNextExpireTime, const TickType_t xTimeNow )
 {
 BaseType_t xResult;
-Timer_t * const pxTimer = ( Timer_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxCurrentTimerList );
+#if( configUSE_TIMER_WHEEL == 1 )
+	Timer_t * const pxTimer = ( Timer_t * ) listGET_OWNER_OF_HEAD_ENTRY( &( xTimerWheel[ 0 ][ xNextExpireTime & tmrWHEEL_SLOT_MASK ] ) );
+#else
+	Timer_t * const pxTimer = ( Timer_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxCurrentTimerList );
+#endif
 
 	/* Remove the timer from the list of active timers.  A check has already
 	been performed to ensure the list is not empty. */
-	( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
+	prvRemoveTimerFromActiveList( pxTimer );
 	traceTIMER_EXPIRED( pxTimer );
 
 	/* If the timer is an auto reload timer then calculate the next
@@ -442,7 +609,7 @@ BaseType_t xListWasEmpty;
 static void prvProcessTimerOrBlockTask( const TickType_t xNextExpireTime, const BaseType_t xListWasEmpty )
 {
 TickType_t xTimeNow;
-BaseType_t xTimerListsWereSwitched;
+BaseType_t xTimerListsWereSwitched, xTimerDue;
 
 	vTaskSuspendAll();
 	{
@@ -454,11 +621,33 @@ BaseType_t xTimerListsWereSwitched;
 		xTimeNow = prvSampleTimeNow( &xTimerListsWereSwitched );
 		if( xTimerListsWereSwitched == pdFALSE )
 		{
-			/* The tick count has not overflowed, has the timer expired? */
-			if( ( xListWasEmpty == pdFALSE ) && ( xNextExpireTime <= xTimeNow ) )
+			#if( configUSE_TIMER_WHEEL == 1 )
+			{
+				/* The wheel never switches lists.  Is its next piece of work
+				due within the ticks it has not yet processed?  If so, process
+				all of those ticks in one go. */
+				xTimerDue = ( ( xListWasEmpty == pdFALSE ) && ( ( TickType_t ) ( xNextExpireTime - xTimerWheelTime ) < ( TickType_t ) ( ( xTimeNow + 1 ) - xTimerWheelTime ) ) ) ? pdTRUE : pdFALSE;
+			}
+			#else
+			{
+				/* The tick count has not overflowed, has the timer expired? */
+				xTimerDue = ( ( xListWasEmpty == pdFALSE ) && ( xNextExpireTime <= xTimeNow ) ) ? pdTRUE : pdFALSE;
+			}
+			#endif /* configUSE_TIMER_WHEEL */
+
+			if( xTimerDue != pdFALSE )
 			{
 				( void ) xTaskResumeAll();
-				prvProcessExpiredTimer( xNextExpireTime, xTimeNow );
+
+				#if( configUSE_TIMER_WHEEL == 1 )
+				{
+					prvAdvanceTimerWheel( xTimeNow );
+				}
+				#else
+				{
+					prvProcessExpiredTimer( xNextExpireTime, xTimeNow );
+				}
+				#endif /* configUSE_TIMER_WHEEL */
 			}
 			else
 			{
@@ -492,6 +681,59 @@ BaseType_t xTimerListsWereSwitched;
 }
 /*-----------------------------------------------------------*/
 
+#if( configUSE_TIMER_WHEEL == 1 )
+
+	static TickType_t prvGetNextExpireTime( BaseType_t * const pxListWasEmpty )
+	{
+	TickType_t xNextExpireTime, xTicksToSlot, xTicksToWork, xLevelTicks, xLevelStart;
+	UBaseType_t uxLevel, uxSlots;
+
+		*pxListWasEmpty = ( uxTimerWheelCount == ( UBaseType_t ) 0U ) ? pdTRUE : pdFALSE;
+		if( *pxListWasEmpty == pdFALSE )
+		{
+			xTicksToWork = portMAX_DELAY;
+
+			/* The next level 0 slot with timers in it, which is never more
+			than 63 ticks away. */
+			uxSlots = prvNextOccupiedSlot( 0, ( UBaseType_t ) ( xTimerWheelTime & tmrWHEEL_SLOT_MASK ) );
+			if( uxSlots < tmrWHEEL_SLOTS )
+			{
+				xTicksToWork = ( TickType_t ) uxSlots;
+			}
+
+			/* The next cascade out of each higher level.  A level's slots are
+			cascaded in turn as the time reaches a multiple of the level's slot
+			length, starting from the first multiple not yet processed. */
+			for( uxLevel = 1; uxLevel < tmrWHEEL_LEVELS; uxLevel++ )
+			{
+				xLevelTicks = ( TickType_t ) ( ( TickType_t ) 1 << ( tmrWHEEL_SLOT_BITS * uxLevel ) );
+				xLevelStart = ( TickType_t ) ( ( xTimerWheelTime + ( xLevelTicks - 1 ) ) & ~( xLevelTicks - 1 ) );
+				uxSlots = prvNextOccupiedSlot( uxLevel, ( UBaseType_t ) ( ( xLevelStart >> ( tmrWHEEL_SLOT_BITS * uxLevel ) ) & tmrWHEEL_SLOT_MASK ) );
+				if( uxSlots < tmrWHEEL_SLOTS )
+				{
+					/* In the top level the shift drops the slots the tick
+					count cannot reach, which is the wrap wanted. */
+					xTicksToSlot = ( TickType_t ) ( ( xLevelStart - xTimerWheelTime ) + ( TickType_t ) ( ( TickType_t ) uxSlots << ( tmrWHEEL_SLOT_BITS * uxLevel ) ) );
+					if( xTicksToSlot < xTicksToWork )
+					{
+						xTicksToWork = xTicksToSlot;
+					}
+				}
+			}
+
+			xNextExpireTime = ( TickType_t ) ( xTimerWheelTime + xTicksToWork );
+		}
+		else
+		{
+			/* As with the lists, unblock when the tick count rolls over. */
+			xNextExpireTime = ( TickType_t ) 0U;
+		}
+
+		return xNextExpireTime;
+	}
+
+#else
+
 static TickType_t prvGetNextExpireTime( BaseType_t * const pxListWasEmpty )
 {
 TickType_t xNextExpireTime;
@@ -516,6 +758,8 @@ TickType_t xNextExpireTime;
 
 	return xNextExpireTime;
 }
+
+#endif /* configUSE_TIMER_WHEEL */
 /*-----------------------------------------------------------*/
 
 static TickType_t prvSampleTimeNow( BaseType_t * const pxTimerListsWereSwitched )
@@ -525,15 +769,32 @@ PRIVILEGED_DATA static TickType_t xLastTime = ( TickType_t ) 0U; /*lint !e956 Va
 
 	xTimeNow = xTaskGetTickCount();
 
-	if( xTimeNow < xLastTime )
+	#if( configUSE_TIMER_WHEEL == 1 )
 	{
-		prvSwitchTimerLists();
-		*pxTimerListsWereSwitched = pdTRUE;
+		/* Expiry times are held relative to the wheel's own time, so the tick
+		count overflowing needs no special handling.  An empty wheel is
+		brought up to date so timers are placed relative to now. */
+		( void ) xLastTime;
+		*pxTimerListsWereSwitched = pdFALSE;
+
+		if( uxTimerWheelCount == ( UBaseType_t ) 0U )
+		{
+			xTimerWheelTime = ( TickType_t ) ( xTimeNow + 1 );
+		}
 	}
-	else
+	#else
 	{
-		*pxTimerListsWereSwitched = pdFALSE;
+		if( xTimeNow < xLastTime )
+		{
+			prvSwitchTimerLists();
+			*pxTimerListsWereSwitched = pdTRUE;
+		}
+		else
+		{
+			*pxTimerListsWereSwitched = pdFALSE;
+		}
 	}
+	#endif /* configUSE_TIMER_WHEEL */
 
 	xLastTime = xTimeNow;
 
@@ -560,7 +821,11 @@ BaseType_t xProcessTimerNow = pdFALSE;
 		}
 		else
 		{
-			vListInsert( pxOverflowTimerList, &( pxTimer->xTimerListItem ) );
+			#if( configUSE_TIMER_WHEEL == 1 )
+				prvInsertTimerInWheel( pxTimer, xNextExpiryTime );
+			#else
+				vListInsert( pxOverflowTimerList, &( pxTimer->xTimerListItem ) );
+			#endif
 		}
 	}
 	else
@@ -574,7 +839,11 @@ BaseType_t xProcessTimerNow = pdFALSE;
 		}
 		else
 		{
-			vListInsert( pxCurrentTimerList, &( pxTimer->xTimerListItem ) );
+			#if( configUSE_TIMER_WHEEL == 1 )
+				prvInsertTimerInWheel( pxTimer, xNextExpiryTime );
+			#else
+				vListInsert( pxCurrentTimerList, &( pxTimer->xTimerListItem ) );
+			#endif
 		}
 	}
 
@@ -582,6 +851,182 @@ BaseType_t xProcessTimerNow = pdFALSE;
 }
 /*-----------------------------------------------------------*/
 
+static void prvRemoveTimerFromActiveList( Timer_t * const pxTimer )
+{
+	#if( configUSE_TIMER_WHEEL == 1 )
+	{
+	const List_t * const pxSlot = ( const List_t * ) listLIST_ITEM_CONTAINER( &( pxTimer->xTimerListItem ) );
+	const UBaseType_t uxIndex = ( UBaseType_t ) ( pxSlot - &( xTimerWheel[ 0 ][ 0 ] ) );
+
+		if( uxListRemove( &( pxTimer->xTimerListItem ) ) == ( UBaseType_t ) 0U )
+		{
+			ullTimerWheelOccupied[ uxIndex >> tmrWHEEL_SLOT_BITS ] &= ~( ( uint64_t ) 1 << ( uxIndex & tmrWHEEL_SLOT_MASK ) );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		uxTimerWheelCount--;
+	}
+	#else
+	{
+		( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
+	}
+	#endif /* configUSE_TIMER_WHEEL */
+}
+/*-----------------------------------------------------------*/
+
+#if( configUSE_TIMER_WHEEL == 1 )
+
+	static void prvInsertTimerInWheel( Timer_t * const pxTimer, const TickType_t xExpiryTime )
+	{
+	const TickType_t xTicksToExpiry = ( TickType_t ) ( xExpiryTime - xTimerWheelTime );
+	UBaseType_t uxLevel, uxSlot;
+
+		/* The lowest level whose span reaches the expiry time.  The top level
+		reaches any time the tick count can hold. */
+		for( uxLevel = 0; uxLevel < ( tmrWHEEL_LEVELS - 1 ); uxLevel++ )
+		{
+			if( ( xTicksToExpiry >> ( tmrWHEEL_SLOT_BITS * ( uxLevel + 1 ) ) ) == ( TickType_t ) 0U )
+			{
+				break;
+			}
+		}
+
+		uxSlot = ( UBaseType_t ) ( xExpiryTime >> ( tmrWHEEL_SLOT_BITS * uxLevel ) ) & tmrWHEEL_SLOT_MASK;
+		vListInsertEnd( &( xTimerWheel[ uxLevel ][ uxSlot ] ), &( pxTimer->xTimerListItem ) );
+		ullTimerWheelOccupied[ uxLevel ] |= ( uint64_t ) 1 << uxSlot;
+		uxTimerWheelCount++;
+	}
+	/*-----------------------------------------------------------*/
+
+	static UBaseType_t prvNextOccupiedSlot( const UBaseType_t uxLevel, const UBaseType_t uxSlot )
+	{
+	uint64_t ullOccupied = ullTimerWheelOccupied[ uxLevel ];
+	UBaseType_t uxReturn = tmrWHEEL_SLOTS;
+
+		if( ullOccupied != ( uint64_t ) 0U )
+		{
+			/* Rotate uxSlot down to bit 0 so the lowest set bit is the
+			distance to the next occupied slot. */
+			if( uxSlot != ( UBaseType_t ) 0U )
+			{
+				ullOccupied = ( ullOccupied >> uxSlot ) | ( ullOccupied << ( tmrWHEEL_SLOTS - uxSlot ) );
+			}
+
+			uxReturn = ( UBaseType_t ) __builtin_ctzll( ullOccupied );
+		}
+
+		return uxReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvCascadeTimerWheel( void )
+	{
+	UBaseType_t uxLevel, uxSlot;
+	List_t *pxSlot;
+	Timer_t *pxTimer;
+
+		/* A level's slot starts when every level below it wraps to slot 0, so
+		stop at the first level that has not. */
+		for( uxLevel = 1; uxLevel < tmrWHEEL_LEVELS; uxLevel++ )
+		{
+			uxSlot = ( UBaseType_t ) ( xTimerWheelTime >> ( tmrWHEEL_SLOT_BITS * uxLevel ) ) & tmrWHEEL_SLOT_MASK;
+			pxSlot = &( xTimerWheel[ uxLevel ][ uxSlot ] );
+
+			/* Everything in the slot is due within the slot's span of
+			xTimerWheelTime, so is placed in a lower level and cannot come back
+			to this slot. */
+			while( listLIST_IS_EMPTY( pxSlot ) == pdFALSE )
+			{
+				pxTimer = ( Timer_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxSlot );
+				prvRemoveTimerFromActiveList( pxTimer );
+				prvInsertTimerInWheel( pxTimer, listGET_LIST_ITEM_VALUE( &( pxTimer->xTimerListItem ) ) );
+			}
+
+			if( uxSlot != ( UBaseType_t ) 0U )
+			{
+				break;
+			}
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvAdvanceTimerWheel( const TickType_t xTimeNow )
+	{
+	TickType_t xTicksDue = ( TickType_t ) ( ( xTimeNow + 1 ) - xTimerWheelTime ), xTicksToSkip;
+	UBaseType_t uxSlot, uxSlotsToTimer;
+	BaseType_t xTimerFound;
+
+		while( xTicksDue > ( TickType_t ) 0U )
+		{
+			if( uxTimerWheelCount == ( UBaseType_t ) 0U )
+			{
+				/* Nothing left to cascade or expire. */
+				xTimerWheelTime = ( TickType_t ) ( xTimeNow + 1 );
+				break;
+			}
+
+			uxSlot = ( UBaseType_t ) ( xTimerWheelTime & tmrWHEEL_SLOT_MASK );
+
+			if( uxSlot == ( UBaseType_t ) 0U )
+			{
+				prvCascadeTimerWheel();
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+
+			/* Step straight to the next tick that has timers due, or to the
+			next cascade if that comes first.  Level 0 slots before uxSlot hold
+			timers due after the cascade. */
+			uxSlotsToTimer = prvNextOccupiedSlot( 0, uxSlot );
+			if( uxSlotsToTimer < ( tmrWHEEL_SLOTS - uxSlot ) )
+			{
+				xTicksToSkip = ( TickType_t ) uxSlotsToTimer;
+				xTimerFound = pdTRUE;
+			}
+			else
+			{
+				xTicksToSkip = ( TickType_t ) ( tmrWHEEL_SLOTS - uxSlot );
+				xTimerFound = pdFALSE;
+			}
+
+			if( xTicksToSkip >= xTicksDue )
+			{
+				xTimerWheelTime += xTicksDue;
+				break;
+			}
+
+			xTimerWheelTime += xTicksToSkip;
+			xTicksDue -= xTicksToSkip;
+
+			if( xTimerFound != pdFALSE )
+			{
+				/* Expire every timer in the slot.  xTimerWheelTime is left on
+				the slot's tick until they are all done, so a timer that reloads
+				cannot land back in the slot being emptied. */
+				uxSlot = ( UBaseType_t ) ( xTimerWheelTime & tmrWHEEL_SLOT_MASK );
+				while( listLIST_IS_EMPTY( &( xTimerWheel[ 0 ][ uxSlot ] ) ) == pdFALSE )
+				{
+					prvProcessExpiredTimer( xTimerWheelTime, xTimeNow );
+				}
+
+				xTimerWheelTime++;
+				xTicksDue--;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+	}
+
+#endif /* configUSE_TIMER_WHEEL */
+/*-----------------------------------------------------------*/
+
 static void	prvProcessReceivedCommands( void )
 {
 DaemonTaskMessage_t xMessage;
@@ -624,7 +1069,7 @@ TickType_t xTimeNow;
 			if( listIS_CONTAINED_WITHIN( NULL, &( pxTimer->xTimerListItem ) ) == pdFALSE )
 			{
 				/* The timer is in a list, remove it. */
-				( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
+				prvRemoveTimerFromActiveList( pxTimer );
 			}
 			else
 			{
@@ -695,8 +1140,17 @@ TickType_t xTimeNow;
 
 				case tmrCOMMAND_DELETE :
 					/* The timer has already been removed from the active list,
-					just free up the memory. */
-					vPortFree( pxTimer );
+					just free up the memory if it came from the heap. */
+					#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+					{
+						#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+							if( pxTimer->ucStaticallyAllocated == pdFALSE )
+						#endif /* configSUPPORT_STATIC_ALLOCATION */
+						{
+							vPortFree( pxTimer );
+						}
+					}
+					#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
 					break;
 
 				default	:
@@ -708,6 +1162,8 @@ TickType_t xTimeNow;
 }
 /*-----------------------------------------------------------*/
 
+#if( configUSE_TIMER_WHEEL == 0 )
+
 static void prvSwitchTimerLists( void )
 {
 TickType_t xNextExpireTime, xReloadTime;
@@ -765,6 +1221,8 @@ BaseType_t xResult;
 	pxCurrentTimerList = pxOverflowTimerList;
 	pxOverflowTimerList = pxTemp;
 }
+
+#endif /* configUSE_TIMER_WHEEL */
 /*-----------------------------------------------------------*/
 
 static void prvCheckForValidListAndQueue( void )
@@ -776,11 +1234,35 @@ static void prvCheckForValidListAndQueue( void )
 	{
 		if( xTimerQueue == NULL )
 		{
-			vListInitialise( &xActiveTimerList1 );
-			vListInitialise( &xActiveTimerList2 );
-			pxCurrentTimerList = &xActiveTimerList1;
-			pxOverflowTimerList = &xActiveTimerList2;
-			xTimerQueue = xQueueCreate( ( UBaseType_t ) configTIMER_QUEUE_LENGTH, sizeof( DaemonTaskMessage_t ) );
+			#if( configUSE_TIMER_WHEEL == 1 )
+			{
+			UBaseType_t uxLevel, uxSlot;
+
+				for( uxLevel = 0; uxLevel < tmrWHEEL_LEVELS; uxLevel++ )
+				{
+					for( uxSlot = 0; uxSlot < tmrWHEEL_SLOTS; uxSlot++ )
+					{
+						vListInitialise( &( xTimerWheel[ uxLevel ][ uxSlot ] ) );
+					}
+				}
+			}
+			#else
+			{
+				vListInitialise( &xActiveTimerList1 );
+				vListInitialise( &xActiveTimerList2 );
+				pxCurrentTimerList = &xActiveTimerList1;
+				pxOverflowTimerList = &xActiveTimerList2;
+			}
+			#endif /* configUSE_TIMER_WHEEL */
+			#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+			{
+				xTimerQueue = xQueueCreateStatic( ( UBaseType_t ) configTIMER_QUEUE_LENGTH, sizeof( DaemonTaskMessage_t ), ucStaticTimerQueueStorage, &xStaticTimerQueue );
+			}
+			#else
+			{
+				xTimerQueue = xQueueCreate( ( UBaseType_t ) configTIMER_QUEUE_LENGTH, sizeof( DaemonTaskMessage_t ) );
+			}
+			#endif /* configSUPPORT_STATIC_ALLOCATION */
 			configASSERT( xTimerQueue );
 
 			#if ( configQUEUE_REGISTRY_SIZE > 0 )
@@ -257,7 +257,43 @@ typedef void (*PendedFunction_t)( void *, uint32_t );
  * }
  * @endverbatim
  */
-TimerHandle_t xTimerCreate( const char * const pcTimerName, const TickType_t xTimerPeriodInTicks, const UBaseType_t uxAutoReload, void * const pvTimerID, TimerCallbackFunction_t pxCallbackFunction ) PRIVILEGED_FUNCTION; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+	TimerHandle_t xTimerCreate( const char * const pcTimerName, const TickType_t xTimerPeriodInTicks, const UBaseType_t uxAutoReload, void * const pvTimerID, TimerCallbackFunction_t pxCallbackFunction ) PRIVILEGED_FUNCTION; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+#endif
+
+/**
+ * TimerHandle_t xTimerCreateStatic(	const char * const pcTimerName,
+ * 										TickType_t xTimerPeriodInTicks,
+ * 										UBaseType_t uxAutoReload,
+ * 										void * pvTimerID,
+ * 										TimerCallbackFunction_t pxCallbackFunction,
+ * 										StaticTimer_t *pxTimerBuffer );
+ *
+ * As xTimerCreate(), but the timer is held in the StaticTimer_t variable
+ * pointed to by pxTimerBuffer instead of in memory allocated from the FreeRTOS
+ * heap.  The variable must persist for the lifetime of the timer.  Only
+ * available when configSUPPORT_STATIC_ALLOCATION is set to 1 in
+ * FreeRTOSConfig.h.
+ *
+ * @return The handle of the timer, or NULL if xTimerPeriodInTicks is 0 or
+ * pxTimerBuffer is NULL.
+ *
+ * Example usage:
+ * @verbatim
+ * static StaticTimer_t xTimerBuffer;
+ *
+ * void main( void )
+ * {
+ * TimerHandle_t xTimer;
+ *
+ *     xTimer = xTimerCreateStatic( "Timer", 100, pdFALSE, NULL, vCallbackFunction, &xTimerBuffer );
+ *     ...
+ * }
+ * @endverbatim
+ */
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+	TimerHandle_t xTimerCreateStatic( const char * const pcTimerName, const TickType_t xTimerPeriodInTicks, const UBaseType_t uxAutoReload, void * const pvTimerID, TimerCallbackFunction_t pxCallbackFunction, StaticTimer_t *pxTimerBuffer ) PRIVILEGED_FUNCTION; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+#endif
 
 /**
  * void *pvTimerGetTimerID( TimerHandle_t xTimer );
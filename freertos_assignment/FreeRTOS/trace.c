@@ -0,0 +1,184 @@
+/*
+ * Kernel event trace recorder.  See trace.h.
+ *
+ * Writing a record masks interrupts, reads the run time counter and fills in
+ * twelve bytes.  The ring index wraps with a mask, so
+ * configTRACE_BUFFER_RECORDS must be a power of two.
+ */
+
+#include <string.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#if( configUSE_TRACE_RECORDER == 1 )
+
+#if( ( configTRACE_BUFFER_RECORDS & ( configTRACE_BUFFER_RECORDS - 1 ) ) != 0 )
+	#error configTRACE_BUFFER_RECORDS must be a power of two.
+#endif
+
+#define traceBUFFER_MASK	( ( uint32_t ) configTRACE_BUFFER_RECORDS - 1UL )
+
+/* Version of the text produced by vTraceDump(). */
+#define traceDUMP_VERSION	1
+
+static TraceRecord_t xTraceBuffer[ configTRACE_BUFFER_RECORDS ];
+
+/* Total records written since the last clear.  The next record goes in
+xTraceBuffer[ ulTraceWritten & traceBUFFER_MASK ]. */
+static uint32_t ulTraceWritten = 0;
+
+/* Recording starts at boot. */
+static volatile BaseType_t xTraceRunning = pdTRUE;
+
+/* Tasks are created, and recorded, before the scheduler starts the run time
+counter, so the first record starts it. */
+static BaseType_t xTraceClockStarted = pdFALSE;
+
+/* Number of the running task, kept here because queue.c and timers.c cannot
+see pxCurrentTCB. */
+static uint8_t ucTraceCurrentTask = 0;
+
+/* High word of the timestamp of the last record. */
+static uint32_t ulTraceTimeHigh = 0;
+
+/* Names and priorities from task creation, indexed by task number.  Tasks
+numbered beyond configTRACE_MAX_TASKS are recorded but not named. */
+static char cTraceTaskNames[ configTRACE_MAX_TASKS + 1 ][ configMAX_TASK_NAME_LEN ];
+static uint8_t ucTraceTaskPriorities[ configTRACE_MAX_TASKS + 1 ];
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Appends a record.  Must be called with interrupts masked.
+ */
+static void prvWriteRecord( uint32_t ulTimestamp, uint8_t ucEvent, uint32_t ulObject, uint16_t usValue );
+
+/*-----------------------------------------------------------*/
+
+static void prvWriteRecord( uint32_t ulTimestamp, uint8_t ucEvent, uint32_t ulObject, uint16_t usValue )
+{
+TraceRecord_t *pxRecord = &( xTraceBuffer[ ulTraceWritten & traceBUFFER_MASK ] );
+
+	pxRecord->ulTimestamp = ulTimestamp;
+	pxRecord->ucEvent = ucEvent;
+	pxRecord->ucTask = ucTraceCurrentTask;
+	pxRecord->usValue = usValue;
+	pxRecord->ulObject = ulObject;
+	ulTraceWritten++;
+}
+/*-----------------------------------------------------------*/
+
+void vTraceRecord( uint8_t ucEvent, uint32_t ulObject, uint16_t usValue )
+{
+UBaseType_t uxSavedInterruptStatus;
+uint64_t ullNow;
+uint32_t ulHigh;
+
+	if( xTraceRunning == pdFALSE )
+	{
+		return;
+	}
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		if( xTraceClockStarted == pdFALSE )
+		{
+			portCONFIGURE_TIMER_FOR_RUN_TIME_STATS();
+			xTraceClockStarted = pdTRUE;
+		}
+
+		ullNow = ( uint64_t ) portGET_RUN_TIME_COUNTER_VALUE();
+		ulHigh = ( uint32_t ) ( ullNow >> 32 );
+
+		/* Records only carry the low word, so mark each change of the high
+		word.  The decoder works back from the high word in the dump header. */
+		if( ulHigh != ulTraceTimeHigh )
+		{
+			prvWriteRecord( ( uint32_t ) ullNow, traceEVENT_TIME_HIGH, ulHigh, ( uint16_t ) ulTraceTimeHigh );
+			ulTraceTimeHigh = ulHigh;
+		}
+
+		prvWriteRecord( ( uint32_t ) ullNow, ucEvent, ulObject, usValue );
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+}
+/*-----------------------------------------------------------*/
+
+void vTraceTaskCreate( uint32_t ulTaskNumber, uint32_t ulPriority, const char *pcName )
+{
+	if( ulTaskNumber <= configTRACE_MAX_TASKS )
+	{
+		strncpy( cTraceTaskNames[ ulTaskNumber ], pcName, configMAX_TASK_NAME_LEN );
+		cTraceTaskNames[ ulTaskNumber ][ configMAX_TASK_NAME_LEN - 1 ] = '\0';
+		ucTraceTaskPriorities[ ulTaskNumber ] = ( uint8_t ) ulPriority;
+	}
+
+	vTraceRecord( traceEVENT_TASK_CREATE, ulTaskNumber, ( uint16_t ) ulPriority );
+}
+/*-----------------------------------------------------------*/
+
+void vTraceTaskSwitchedIn( uint32_t ulTaskNumber, uint32_t ulPriority )
+{
+	/* Only called from the kernel with interrupts masked, so this cannot be
+	torn by an interrupt recording an event. */
+	ucTraceCurrentTask = ( uint8_t ) ulTaskNumber;
+	vTraceRecord( traceEVENT_TASK_SWITCHED_IN, ulTaskNumber, ( uint16_t ) ulPriority );
+}
+/*-----------------------------------------------------------*/
+
+void vTraceStart( void )
+{
+	xTraceRunning = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void vTraceStop( void )
+{
+	xTraceRunning = pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vTraceClear( void )
+{
+UBaseType_t uxSavedInterruptStatus;
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		ulTraceWritten = 0;
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+}
+/*-----------------------------------------------------------*/
+
+void vTraceDump( TracePrintFunction_t pxPrint )
+{
+uint32_t ulFirst, ulIndex, ulTask;
+const TraceRecord_t *pxRecord;
+
+	/* Version, counter rate, high word of the newest record's timestamp,
+	records held and records lost off the start of the ring. */
+	ulFirst = ( ulTraceWritten > configTRACE_BUFFER_RECORDS ) ? ( ulTraceWritten - configTRACE_BUFFER_RECORDS ) : 0UL;
+	pxPrint( "TRACE %d %lu %lu %lu %lu\n", traceDUMP_VERSION, ( unsigned long ) portRUN_TIME_COUNTER_HZ,
+			( unsigned long ) ulTraceTimeHigh, ( unsigned long ) ( ulTraceWritten - ulFirst ), ( unsigned long ) ulFirst );
+
+	for( ulTask = 1; ulTask <= configTRACE_MAX_TASKS; ulTask++ )
+	{
+		if( cTraceTaskNames[ ulTask ][ 0 ] != '\0' )
+		{
+			pxPrint( "T %lu %u %s\n", ( unsigned long ) ulTask, ( unsigned ) ucTraceTaskPriorities[ ulTask ], cTraceTaskNames[ ulTask ] );
+		}
+	}
+
+	for( ulIndex = ulFirst; ulIndex != ulTraceWritten; ulIndex++ )
+	{
+		pxRecord = &( xTraceBuffer[ ulIndex & traceBUFFER_MASK ] );
+		pxPrint( "R %08lx %02x %02x %04x %08lx\n", ( unsigned long ) pxRecord->ulTimestamp, ( unsigned ) pxRecord->ucEvent,
+				( unsigned ) pxRecord->ucTask, ( unsigned ) pxRecord->usValue, ( unsigned long ) pxRecord->ulObject );
+	}
+
+	pxPrint( "END\n" );
+}
+
+#endif /* configUSE_TRACE_RECORDER */
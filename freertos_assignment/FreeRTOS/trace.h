@@ -0,0 +1,162 @@
+/*
+ * Kernel event trace recorder.
+ *
+ * When configUSE_TRACE_RECORDER is 1 the kernel's trace macros are defined
+ * here to write fixed size binary records into a RAM ring buffer of
+ * configTRACE_BUFFER_RECORDS entries.  Each record is stamped with the run time
+ * statistics counter (port_runtime.c), so configGENERATE_RUN_TIME_STATS must
+ * be 1.  configUSE_TRACE_FACILITY must be 1 too, for the task numbers.
+ *
+ * The ring always holds the most recent events.  vTraceStop() freezes it, for
+ * example when the application sees something go wrong, and vTraceDump()
+ * prints it as text that host/tools/trace_decode turns into a Chrome trace
+ * JSON timeline and per task latency figures.
+ *
+ * This header is included by FreeRTOSConfig.h so that the macros are defined
+ * before FreeRTOS.h supplies the empty defaults.  It must not depend on
+ * anything FreeRTOS.h defines.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Record types.  Values are part of the dump format read by trace_decode, so
+only ever add to the end. */
+#define traceEVENT_TIME_HIGH				0	/* ulObject: new high word of the timestamp, usValue: low 16 bits of the previous one. */
+#define traceEVENT_TASK_CREATE				1	/* ulObject: task number, usValue: priority. */
+#define traceEVENT_TASK_SWITCHED_IN			2	/* ulObject: task number, usValue: priority. */
+#define traceEVENT_TASK_READY				3	/* ulObject: task number, usValue: priority. */
+#define traceEVENT_TASK_DELAY				4
+#define traceEVENT_TASK_DELAY_UNTIL			5
+#define traceEVENT_TASK_SUSPEND				6	/* ulObject: task number. */
+#define traceEVENT_TASK_RESUME				7	/* ulObject: task number. */
+#define traceEVENT_TASK_DELETE				8	/* ulObject: task number. */
+#define traceEVENT_QUEUE_SEND				9	/* Queue events - ulObject: queue, usValue: queue type << 8 | items waiting. */
+#define traceEVENT_QUEUE_SEND_FAILED		10
+#define traceEVENT_QUEUE_SEND_FROM_ISR		11
+#define traceEVENT_QUEUE_RECEIVE			12
+#define traceEVENT_QUEUE_RECEIVE_FAILED		13
+#define traceEVENT_QUEUE_RECEIVE_FROM_ISR	14
+#define traceEVENT_QUEUE_PEEK				15
+#define traceEVENT_QUEUE_BLOCK_ON_SEND		16
+#define traceEVENT_QUEUE_BLOCK_ON_RECEIVE	17
+#define traceEVENT_NOTIFY					18	/* Notify events - ulObject: task notified. */
+#define traceEVENT_NOTIFY_FROM_ISR			19
+#define traceEVENT_NOTIFY_GIVE_FROM_ISR		20
+#define traceEVENT_NOTIFY_TAKE_BLOCK		21
+#define traceEVENT_NOTIFY_TAKE				22
+#define traceEVENT_NOTIFY_WAIT_BLOCK		23
+#define traceEVENT_NOTIFY_WAIT				24
+#define traceEVENT_TIMER_COMMAND_SEND		25	/* Timer events - ulObject: timer, usValue: command (and pass/fail << 8 on send). */
+#define traceEVENT_TIMER_COMMAND_RECEIVED	26
+#define traceEVENT_TIMER_EXPIRED			27
+#define traceEVENT_ISR_ENTER				28	/* ulObject: interrupt number. */
+#define traceEVENT_ISR_EXIT					29	/* ulObject: interrupt number. */
+#define traceEVENT_LOW_POWER_IDLE_BEGIN		30
+#define traceEVENT_LOW_POWER_IDLE_END		31
+
+/* 12 bytes.  ucTask is the task that was running when the event happened,
+which for events inside an interrupt is the task that was interrupted. */
+typedef struct xTRACE_RECORD
+{
+	uint32_t ulTimestamp;		/* Low word of the run time counter. */
+	uint8_t ucEvent;
+	uint8_t ucTask;
+	uint16_t usValue;
+	uint32_t ulObject;
+} TraceRecord_t;
+
+/* printf() or anything that behaves like it. */
+typedef int ( *TracePrintFunction_t )( const char *pcFormat, ... );
+
+/**
+ * trace. h
+ * <pre>
+ void vTraceStart( void );
+ void vTraceStop( void );
+ void vTraceClear( void );
+ * </pre>
+ *
+ * Recording starts at boot.  vTraceStop() freezes the ring so the
+ * events leading up to a problem are kept, vTraceStart() carries on recording
+ * and vTraceClear() empties the ring.
+ */
+void vTraceStart( void );
+void vTraceStop( void );
+void vTraceClear( void );
+
+/**
+ * trace. h
+ * <pre>
+ void vTraceDump( TracePrintFunction_t pxPrint );
+ * </pre>
+ *
+ * Prints the ring, oldest record first, between a "TRACE" and an "END" line.
+ * Lines in between start with "T" (a task number, priority and name) or "R"
+ * (one record in hex).  The recorder should be stopped first or records
+ * written during the dump may be torn.  The dump goes at the speed of
+ * pxPrint, so call it from a low priority task.
+ */
+void vTraceDump( TracePrintFunction_t pxPrint );
+
+/*
+ * Called by the trace macros below.  Not for application use.
+ */
+void vTraceRecord( uint8_t ucEvent, uint32_t ulObject, uint16_t usValue );
+void vTraceTaskCreate( uint32_t ulTaskNumber, uint32_t ulPriority, const char *pcName );
+void vTraceTaskSwitchedIn( uint32_t ulTaskNumber, uint32_t ulPriority );
+
+/* Object identifiers are the low 32 bits of the object's address. */
+#define traceOBJECT( pxObject )		( ( uint32_t ) ( uintptr_t ) ( pxObject ) )
+#define traceQUEUE_VALUE( pxQueue )	( ( uint16_t ) ( ( ( uint32_t ) ( pxQueue )->ucQueueType << 8 ) | ( ( uint32_t ) ( pxQueue )->uxMessagesWaiting & 0xFFUL ) ) )
+
+#define traceTASK_CREATE( pxNewTCB )						vTraceTaskCreate( ( pxNewTCB )->uxTCBNumber, ( pxNewTCB )->uxPriority, ( pxNewTCB )->pcTaskName )
+#define traceTASK_SWITCHED_IN()								vTraceTaskSwitchedIn( pxCurrentTCB->uxTCBNumber, pxCurrentTCB->uxPriority )
+#define traceMOVED_TASK_TO_READY_STATE( pxTCB )				vTraceRecord( traceEVENT_TASK_READY, ( pxTCB )->uxTCBNumber, ( uint16_t ) ( pxTCB )->uxPriority )
+#define traceTASK_DELAY()									vTraceRecord( traceEVENT_TASK_DELAY, 0, 0 )
+#define traceTASK_DELAY_UNTIL()								vTraceRecord( traceEVENT_TASK_DELAY_UNTIL, 0, 0 )
+#define traceTASK_SUSPEND( pxTCB )							vTraceRecord( traceEVENT_TASK_SUSPEND, ( pxTCB )->uxTCBNumber, 0 )
+#define traceTASK_RESUME( pxTCB )							vTraceRecord( traceEVENT_TASK_RESUME, ( pxTCB )->uxTCBNumber, 0 )
+#define traceTASK_RESUME_FROM_ISR( pxTCB )					vTraceRecord( traceEVENT_TASK_RESUME, ( pxTCB )->uxTCBNumber, 0 )
+#define traceTASK_DELETE( pxTCB )							vTraceRecord( traceEVENT_TASK_DELETE, ( pxTCB )->uxTCBNumber, 0 )
+
+#define traceQUEUE_SEND( pxQueue )							vTraceRecord( traceEVENT_QUEUE_SEND, traceOBJECT( pxQueue ), traceQUEUE_VALUE( pxQueue ) )
+#define traceQUEUE_SEND_FAILED( pxQueue )					vTraceRecord( traceEVENT_QUEUE_SEND_FAILED, traceOBJECT( pxQueue ), traceQUEUE_VALUE( pxQueue ) )
+#define traceQUEUE_SEND_FROM_ISR( pxQueue )					vTraceRecord( traceEVENT_QUEUE_SEND_FROM_ISR, traceOBJECT( pxQueue ), traceQUEUE_VALUE( pxQueue ) )
+#define traceQUEUE_SEND_FROM_ISR_FAILED( pxQueue )			vTraceRecord( traceEVENT_QUEUE_SEND_FAILED, traceOBJECT( pxQueue ), traceQUEUE_VALUE( pxQueue ) )
+#define traceQUEUE_RECEIVE( pxQueue )						vTraceRecord( traceEVENT_QUEUE_RECEIVE, traceOBJECT( pxQueue ), traceQUEUE_VALUE( pxQueue ) )
+#define traceQUEUE_RECEIVE_FAILED( pxQueue )				vTraceRecord( traceEVENT_QUEUE_RECEIVE_FAILED, traceOBJECT( pxQueue ), traceQUEUE_VALUE( pxQueue ) )
+#define traceQUEUE_RECEIVE_FROM_ISR( pxQueue )				vTraceRecord( traceEVENT_QUEUE_RECEIVE_FROM_ISR, traceOBJECT( pxQueue ), traceQUEUE_VALUE( pxQueue ) )
+#define traceQUEUE_RECEIVE_FROM_ISR_FAILED( pxQueue )		vTraceRecord( traceEVENT_QUEUE_RECEIVE_FAILED, traceOBJECT( pxQueue ), traceQUEUE_VALUE( pxQueue ) )
+#define traceQUEUE_PEEK( pxQueue )							vTraceRecord( traceEVENT_QUEUE_PEEK, traceOBJECT( pxQueue ), traceQUEUE_VALUE( pxQueue ) )
+#define traceBLOCKING_ON_QUEUE_SEND( pxQueue )				vTraceRecord( traceEVENT_QUEUE_BLOCK_ON_SEND, traceOBJECT( pxQueue ), traceQUEUE_VALUE( pxQueue ) )
+#define traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue )			vTraceRecord( traceEVENT_QUEUE_BLOCK_ON_RECEIVE, traceOBJECT( pxQueue ), traceQUEUE_VALUE( pxQueue ) )
+
+#define traceTASK_NOTIFY()									vTraceRecord( traceEVENT_NOTIFY, pxTCB->uxTCBNumber, 0 )
+#define traceTASK_NOTIFY_FROM_ISR()							vTraceRecord( traceEVENT_NOTIFY_FROM_ISR, pxTCB->uxTCBNumber, 0 )
+#define traceTASK_NOTIFY_GIVE_FROM_ISR()					vTraceRecord( traceEVENT_NOTIFY_GIVE_FROM_ISR, pxTCB->uxTCBNumber, 0 )
+#define traceTASK_NOTIFY_TAKE_BLOCK()						vTraceRecord( traceEVENT_NOTIFY_TAKE_BLOCK, 0, 0 )
+#define traceTASK_NOTIFY_TAKE()								vTraceRecord( traceEVENT_NOTIFY_TAKE, 0, 0 )
+#define traceTASK_NOTIFY_WAIT_BLOCK()						vTraceRecord( traceEVENT_NOTIFY_WAIT_BLOCK, 0, 0 )
+#define traceTASK_NOTIFY_WAIT()								vTraceRecord( traceEVENT_NOTIFY_WAIT, 0, 0 )
+
+#define traceTIMER_COMMAND_SEND( xTimer, xMessageID, xMessageValue, xReturn )	vTraceRecord( traceEVENT_TIMER_COMMAND_SEND, traceOBJECT( xTimer ), ( uint16_t ) ( ( ( uint32_t ) ( xReturn ) << 8 ) | ( ( uint32_t ) ( xMessageID ) & 0xFFUL ) ) )
+#define traceTIMER_COMMAND_RECEIVED( pxTimer, xMessageID, xMessageValue )		vTraceRecord( traceEVENT_TIMER_COMMAND_RECEIVED, traceOBJECT( pxTimer ), ( uint16_t ) ( xMessageID ) )
+#define traceTIMER_EXPIRED( pxTimer )						vTraceRecord( traceEVENT_TIMER_EXPIRED, traceOBJECT( pxTimer ), 0 )
+
+#define traceISR_ENTER( ulIrq )								vTraceRecord( traceEVENT_ISR_ENTER, ( ulIrq ), 0 )
+#define traceISR_EXIT( ulIrq )								vTraceRecord( traceEVENT_ISR_EXIT, ( ulIrq ), 0 )
+#define traceLOW_POWER_IDLE_BEGIN()							vTraceRecord( traceEVENT_LOW_POWER_IDLE_BEGIN, 0, 0 )
+#define traceLOW_POWER_IDLE_END()							vTraceRecord( traceEVENT_LOW_POWER_IDLE_END, 0, 0 )
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_H */
@@ -8,16 +8,26 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
 
 // Scheduler includes
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
-#include "freertos/timers.h"
+#include "freertos/tick_timer.h"
 #include "freertos/semphr.h"
+#include "freertos/logger.h"
+#include "freertos/event_log.h"
+#include "freertos/telemetry.h"
+#include "freertos/command.h"
+#include "freertos/store.h"
+#include "freertos/profiler.h"
 
 // Altera Peripherals
 #include <altera_avalon_pio_regs.h>
+#include <altera_avalon_timer_regs.h>
 #include "altera_up_avalon_video_pixel_buffer_dma.h"
 #include "altera_up_avalon_ps2.h"
 #include "altera_up_ps2_keyboard.h"
@@ -26,33 +36,256 @@
 #include "altera_avalon_sysid_qsys_regs.h"
 #include "alt_types.h"
 #include <sys/alt_alarm.h>
-
-// Definition of Task Stacks
-#define TASK_STACKSIZE       2048
+#include <sys/alt_flash.h>
+
+// Definition of Task Stacks, in words. Interrupts run on their own stack
+// (configISR_STACK_SIZE) so these only cover the task itself. Tasks that call
+// printf with %f get 1024, as newlib's vfprintf and dtoa need about 2KB.
+#define VGA_TASK_STACKSIZE 1024
+#define KEYBOARD_TASK_STACKSIZE 1024
+#define FREQUENCY_UPDATER_TASK_STACKSIZE 512
+#define LOAD_MANAGER_TASK_STACKSIZE 1024
+#define RUN_TIME_STATS_TASK_STACKSIZE 1024
+#define TRACE_DUMP_TASK_STACKSIZE 1024
+#define STACK_MONITOR_TASK_STACKSIZE 512
+#define LOG_DRAIN_TASK_STACKSIZE 512
+#define TELEMETRY_TASK_STACKSIZE 512
+#define COMMAND_TASK_STACKSIZE 512
+#define STORE_TASK_STACKSIZE 512
+#define PROFILE_DUMP_TASK_STACKSIZE 1024
+
+// stackMonitorTask reports how much of each stack has been used. Build with
+// -DSTACK_MONITOR_TEST=1 to have every task run its deepest library calls
+// once at start up, so the report covers them from the first period
+#ifndef STACK_MONITOR
+#define STACK_MONITOR 1
+#endif
+#ifndef STACK_MONITOR_TEST
+#define STACK_MONITOR_TEST 0
+#endif
+#if (STACK_MONITOR_TEST == 1) && (STACK_MONITOR != 1)
+#error STACK_MONITOR_TEST needs STACK_MONITOR
+#endif
 
 // Definition of Task Priorities
 #define VGA_TASK_PRIORITY 1
 #define KEYBOARD_TASK_PRIORITY 4
 #define FREQUENCY_UPDATER_TASK_PRIORITY 5
 #define LOAD_MANAGER_TASK_PRIORITY 2
+// Same priority as the VGA task so its printf never holds up the relay tasks
+#define RUN_TIME_STATS_TASK_PRIORITY 1
+#define TRACE_DUMP_TASK_PRIORITY 1
+#define STACK_MONITOR_TASK_PRIORITY 1
+// Prints what the control path has logged whenever nothing else needs the CPU
+#define LOG_DRAIN_TASK_PRIORITY 1
+// Only moves bytes to the UART driver, which sends them from its interrupt
+#define TELEMETRY_TASK_PRIORITY 1
+// Requests are only settings and reports, so they wait for the relay tasks
+#define COMMAND_TASK_PRIORITY 1
+// Waits on the flash for whole erases, so everything else runs first
+#define STORE_TASK_PRIORITY 1
+// Prints at the speed of the JTAG UART, like traceDumpTask
+#define PROFILE_DUMP_TASK_PRIORITY 1
 //Timer Vars
 
 // 500ms for Stability Observation
 #define TIMER_PERIOD (500)/portTICK_PERIOD_MS
-// FreeRTOS Timer
-TimerHandle_t timer500ms;
+// Wait between VGA redraws, one frame at 60Hz, so lower priority tasks and the
+// idle task (and with it tickless idle) get to run
+#define VGA_REFRESH_PERIOD (17)/portTICK_PERIOD_MS
+// Tick timer that wakes loadManagerTask with STABILITY_TIMER_EXPIRED
+TickTimer_t stabilityTimer;
 
 //Declaration of Mutexes
 SemaphoreHandle_t thresholdSemaphore;
+StaticSemaphore_t thresholdSemaphoreBuffer;
 // LCD macros
 #define ESC 27
 #define CLEAR_LCD_STRING "[2J"
+
+/*#################################################################
+############################### Logging ###########################
+################################################################### */
+// The load manager logs with LOG() rather than printf(). With configUSE_LOGGER
+// it only records the format and up to three integer arguments (logger.h) and
+// logDrainTask prints them later, so shedding a load never waits on the
+// JTAG UART. LOG() formats may only use %d, %u, %x and %c.
+#if (configUSE_LOGGER == 1)
+#define LOG(...) vLogPrintf(__VA_ARGS__)
+#else
+#define LOG(...) printf(__VA_ARGS__)
+#endif
+
+// Messages are written with LOG_ERROR() to LOG_DEBUG() and the subsystem they
+// come from. configLOG_LEVEL and configLOG_SUBSYSTEMS (FreeRTOSConfig.h)
+// choose which are built; the rest compile to nothing, format string
+// included (logENABLED() in logger.h). The default, logLEVEL_INFO, leaves out
+// the per-load switch messages and the stability timer expiries
+#define LOG_LOAD_MANAGER 0x01
+#define LOG_KEYBOARD 0x02
+#define LOG_VGA 0x04
+#define LOG_TIMER 0x08
+#define LOG_BOOT 0x10
+#define LOG_COMMAND 0x20
+
+#define LOG_AT(level, subsystem, ...) do { if (logENABLED(level, subsystem)) { LOG(__VA_ARGS__); } } while (0)
+#define LOG_ERROR(subsystem, ...) LOG_AT(logLEVEL_ERROR, subsystem, __VA_ARGS__)
+#define LOG_WARN(subsystem, ...) LOG_AT(logLEVEL_WARN, subsystem, __VA_ARGS__)
+#define LOG_INFO(subsystem, ...) LOG_AT(logLEVEL_INFO, subsystem, __VA_ARGS__)
+#define LOG_DEBUG(subsystem, ...) LOG_AT(logLEVEL_DEBUG, subsystem, __VA_ARGS__)
+
+// The load manager's decisions are also recorded as binary events
+// (event_log.h) for host/tools/event_decode. logDrainTask sends them as hex
+// lines on the JTAG UART console, or with EVENT_LOG_SERIAL as raw records on
+// the serial UART. EVENT_LOG_SAMPLES adds an event for every sample
+#ifndef EVENT_LOG_SERIAL
+#define EVENT_LOG_SERIAL 0
+#endif
+#ifndef EVENT_LOG_SAMPLES
+#define EVENT_LOG_SAMPLES 0
+#endif
+#if (configUSE_EVENT_LOG == 1)
+#define LOG_EVENT(event, load, value) logEvent(event, load, value)
+#else
+#define LOG_EVENT(event, load, value)
+#endif
+// logDrainTask sends both
+#define LOG_DRAIN_TASK ((configUSE_LOGGER == 1) || (configUSE_EVENT_LOG == 1))
+
+/*#################################################################
+############################### Telemetry #########################
+################################################################### */
+// Every sample and load manager state change is sent as a COBS framed binary
+// frame on the serial UART (telemetry.h) for host/tools/telemetry_recv.
+// Sending only copies the frame into a RAM ring. telemetryTask moves the ring
+// into the UART driver's interrupt driven transmit buffer without blocking,
+// and frames that find the ring full are dropped and counted, so a slow or
+// unplugged link never holds up the control tasks
+#if (configUSE_TELEMETRY == 1)
+#if (EVENT_LOG_SERIAL == 1)
+#error EVENT_LOG_SERIAL and configUSE_TELEMETRY both need the serial UART
+#endif
+// How often a heartbeat with the drop count is sent
+#define TELEMETRY_HEARTBEAT_PERIOD (1000)/portTICK_PERIOD_MS
+#define TELEMETRY_SAMPLE(freqRocMsg) xTelemetrySendSample((uint16_t)toEventLogFixedPoint((freqRocMsg).freqData, 0, UINT16_MAX), \
+		(int16_t)toEventLogFixedPoint((freqRocMsg).rocData, INT16_MIN, INT16_MAX))
+#define TELEMETRY_STATE(newState, oldState) xTelemetrySendState(newState, oldState, loadStatus)
+// Serial UART opened with O_NONBLOCK. telemetryTask only
+int telemetryUart = -1;
+#else
+#define TELEMETRY_SAMPLE(freqRocMsg)
+#define TELEMETRY_STATE(newState, oldState)
+#endif
+
+/*#################################################################
+############################### Command Channel ###################
+################################################################### */
+// A host can read and change the thresholds, read the statistics and the
+// sample history, switch maintenance mode and dump the kernel trace with
+// requests on the serial UART (command.h), sent by host/tools/command_client.
+// commandTask polls the UART driver's receive buffer and answers in the
+// telemetry stream. The client sends one request at a time and a request is
+// at most commandMAX_ENCODED bytes, so it fits in the driver's 64 byte buffer
+// between polls
+#if (configUSE_COMMAND_CHANNEL == 1)
+// Polled quickly for a while after a byte arrives so a run of requests is
+// answered promptly, and slowly otherwise so tickless idle can sleep
+#define COMMAND_POLL_PERIOD (5)/portTICK_PERIOD_MS
+#define COMMAND_IDLE_POLL_PERIOD (50)/portTICK_PERIOD_MS
+#define COMMAND_ACTIVE_TIME (1000)/portTICK_PERIOD_MS
+// Largest thresholds accepted, the most the keyboard can enter
+#define COMMAND_MAX_FREQUENCY_THRESHOLD 999	// 0.1 Hz
+#define COMMAND_MAX_ROC_THRESHOLD 999		// 0.1 Hz/s
+// Serial UART opened with O_NONBLOCK. commandTask only
+int commandUart = -1;
+// commandTask only
+CommandParser_t commandParser;
+#endif
+
+/*#################################################################
+############################### Persistent Store ##################
+################################################################### */
+// The thresholds, the reaction time statistics and a log of the loads shed
+// and reconnected are kept in the last STORE_FLASH_BLOCKS erase blocks of the
+// CFI flash (store.h), so they survive a reset. The control tasks only copy
+// them into RAM with STORE_THRESHOLDS(), STORE_REACTION_STATS() and
+// STORE_EVENT(). storeTask, at the lowest priority, does all of the erasing
+// and programming every STORE_FLUSH_PERIOD, or sooner once the batch of
+// events is half full. initStore() reads the values back before the
+// scheduler starts
+//
+// A snapshot of the load manager (its state, the loads connected, where it is
+// in the stability window and the newest samples) is written with every
+// flush, and a shed or reconnect flushes at once. With STORE_SNAPSHOT_RESTORE
+// initStore() puts it back before the loads are driven, so a reset on a
+// stressed grid keeps the loads that were shed off rather than reconnecting
+// them all
+#if (configUSE_STORE == 1)
+#define STORE_FLASH_BLOCKS 8
+#define STORE_FLUSH_PERIOD (10000)/portTICK_PERIOD_MS
+// Keys. Only ever add to the end, the flash keeps them across builds
+#define STORE_KEY_THRESHOLDS 0
+#define STORE_KEY_REACTION_STATS 1
+#define STORE_KEY_BOOT_COUNT 2
+#define STORE_KEY_SNAPSHOT 3
+// 0 still writes the snapshot, so boot can be timed with and without it
+#define STORE_SNAPSHOT_RESTORE 1
+#define STORE_SNAPSHOT_SAMPLES 5
+#define STORE_THRESHOLDS() storeThresholds()
+#define STORE_REACTION_STATS() storeReactionStats()
+#define STORE_EVENT(event, load) storeEvent(event, load)
+
+// Values as they are kept. Cleared before they are filled in, so the padding
+// does not make an unchanged value look new
+struct storedThresholds{
+	uint16_t frequency;	// 0.1 Hz
+	uint16_t roc;		// 0.1 Hz/s
+};
+
+struct storedReactionStats{
+	uint32_t count;
+	int32_t min;
+	int32_t max;
+	uint16_t times[5];	// Newest first, ms
+	uint8_t held;
+};
+
+struct storedSnapshot{
+	uint8_t state;			// loadManagerState
+	uint8_t loads;			// loadStatus
+	uint8_t wasStable;
+	uint8_t maintenance;	// maintainenceModeEn
+	uint16_t timerRemaining;	// Ticks left in the stability window, 0 if stopped
+	uint8_t samples;		// Held below
+	uint8_t unused;
+	uint16_t frequency[STORE_SNAPSHOT_SAMPLES];	// 0.01 Hz, newest first
+	int16_t roc[STORE_SNAPSHOT_SAMPLES];		// 0.01 Hz/s
+};
+
+// Event data, after its eventlogEVENT_* type: the boot it happened in (2),
+// its tick (4), the load (1) and the loads connected after it (1)
+#define STORE_EVENT_SIZE 8
+
+// NULL if the flash could not be used. Set up by initStore(), then storeTask
+// only
+alt_flash_fd *storeFlashDevice = NULL;
+StoreFlash_t storeFlash;
+// Counted in the store, so events from different boots can be told apart
+uint16_t storeBootCount = 0;
+// Left in the stability window by the snapshot restored, for loadManagerTask
+// to carry on with
+TickType_t restoredTimerRemaining = 0;
+#else
+#define STORE_THRESHOLDS()
+#define STORE_REACTION_STATS()
+#define STORE_EVENT(event, load)
+#endif
 /*#################################################################
 #######################HW PERIPHERALS #############################
 ################################################################### */
 // NOTE: VGA Task only
 alt_up_pixel_buffer_dma_dev *pixel_buf;
-alt_up_pixel_buffer_dma_dev *char_buf;
+alt_up_char_buffer_dev *char_buf;
 // NOTE: Keyboard Task only
 FILE *lcd;
 
@@ -64,10 +297,16 @@ uint8_t wasStable = 1;
 float frequencyData[50];
 float rocData[50];
 int runningDataIndex;
+// Samples written at index 0 since the arrays filled, up to 50
+int runningDataShifts = 0;
 
 /*#################### Time Reaction Data ########################## */
 int reactionTimes[5] ={0,0,0,0,0};
 unsigned int reactionTimeIndex = 0;
+// Reaction times written at index 0 since the array filled, up to 5
+int reactionTimeShifts = 0;
+// Loads shed on a trip since boot
+unsigned int reactionCount = 0;
 int avgReactionTime,totalTime = 0;
 // 10^6 = 1000 seconds (Arbitrary Large Value)
 int minReactionTime = 1000000;
@@ -94,16 +333,43 @@ float frequencyThreshold = 30.0;
 int rocThreshold = 300;
 
 /*#################### Timer Expiry Flag ########################### */
+// Set by waitForLoadManagerEvents() when stabilityTimer has expired
 uint8_t timerExpiryFlag = 0;
 /*#################### Maintainence Mode Flag ###################### */
 uint8_t maintainenceModeEn = 0;
 
-/*#################################################################
-############################### Queues ############################
-################################################################### */
-xQueueHandle frequencyQ;
-xQueueHandle ps2KeyQ;
-xQueueHandle freqRocDataQ;
+/*#################### Load Manager State ########################## */
+#define NORMAL 0
+#define LOAD_MANAGE 1
+#define MAINTENANCE 2
+// Changed through setLoadManagerState(). loadManagerTask only.
+uint8_t loadManagerState = NORMAL;
+
+/*#################### Load Manager Events ######################### */
+// loadManagerTask sleeps in a single xTaskNotifyWait() until one of these
+// notification bits is set, so it uses no CPU while nothing is happening
+// Set by stabilityTimer when the 500ms window ends
+#define STABILITY_TIMER_EXPIRED 0x01
+// Set by frequencyUpdaterTask after it queues a record on freqRocDataQ
+#define NEW_SAMPLE_EVENT 0x02
+// Set by buttonISR when it toggles maintainenceModeEn
+#define MAINTENANCE_TOGGLE_EVENT 0x04
+// Set by the tick hook when the slide switches have changed
+#define SWITCH_CHANGE_EVENT 0x08
+#define LOAD_MANAGER_EVENTS (STABILITY_TIMER_EXPIRED | NEW_SAMPLE_EVENT | MAINTENANCE_TOGGLE_EVENT | SWITCH_CHANGE_EVENT)
+// Events taken from the notification value but not yet returned by
+// waitForLoadManagerEvents(). loadManagerTask only.
+uint32_t loadManagerEvents = 0;
+
+// The slide switch PIO has no interrupt, so the tick hook reads it every tick
+// and reports a new value once it has been steady for SWITCH_DEBOUNCE_TICKS
+#define SWITCH_DEBOUNCE_TICKS 5
+alt_u32 switchScanValue = ALLON;
+alt_u32 switchReportedValue = ALLON;
+uint8_t switchScanStableTicks = 0;
+// Tick at which the last reported switch change was first seen
+TickType_t switchScanChangeTick = 0;
+TickType_t switchChangeTick = 0;
 
 /*#################################################################
 ####################### COMPOUND TYPES ############################
@@ -122,7 +388,255 @@ struct freqQMsg
 	float frequency;
     int timestamp;
 
- } freqISRMsg;
+ };
+
+// Last record received by loadManagerTask, for the event log
+struct freqRocQMsg latestFreqRocMsg;
+
+/*#################################################################
+############################### Queues ############################
+################################################################### */
+xQueueHandle freqRocDataQ;
+
+#define FREQ_ROC_DATA_Q_LENGTH 50
+
+// Queue storage. Records are copied in and out by value; at 12 bytes that is
+// three word copies, cheaper than taking and returning a pool block.
+struct freqRocQMsg freqRocDataQStorage[FREQ_ROC_DATA_Q_LENGTH];
+StaticQueue_t freqRocDataQBuffer;
+
+/*#################################################################
+############################### ISR Rings #########################
+################################################################### */
+// ps2ISR and frequencyAnalyserISR hand key codes and sample records to their
+// tasks through these single producer, single consumer rings and wake the task
+// with a direct to task notification instead of a queue. Each notification
+// counts one ring entry. A ring holds one entry less than its length.
+#define PS2_KEY_RING_LENGTH 100
+#define FREQUENCY_RING_LENGTH 100
+
+volatile unsigned char ps2KeyRing[PS2_KEY_RING_LENGTH];
+volatile unsigned int ps2KeyRingHead = 0;	// Written by ps2ISR only
+volatile unsigned int ps2KeyRingTail = 0;	// Written by keyboardManagerTask only
+
+// Sample records are copied into the ring by value
+volatile struct freqQMsg frequencyRing[FREQUENCY_RING_LENGTH];
+volatile unsigned int frequencyRingHead = 0;	// Written by frequencyAnalyserISR only
+volatile unsigned int frequencyRingTail = 0;	// Written by frequencyUpdaterTask only
+
+/*#################################################################
+############################### Task Memory #######################
+################################################################### */
+// There is no FreeRTOS heap (configSUPPORT_DYNAMIC_ALLOCATION is 0). Every
+// task, queue, mutex and timer lives in the memory below, fixed at link time.
+StackType_t vgaTaskStack[VGA_TASK_STACKSIZE];
+StackType_t keyboardManagerTaskStack[KEYBOARD_TASK_STACKSIZE];
+StackType_t frequencyUpdaterTaskStack[FREQUENCY_UPDATER_TASK_STACKSIZE];
+StackType_t loadManagerTaskStack[LOAD_MANAGER_TASK_STACKSIZE];
+StaticTask_t vgaTaskTCB;
+StaticTask_t keyboardManagerTaskTCB;
+StaticTask_t frequencyUpdaterTaskTCB;
+StaticTask_t loadManagerTaskTCB;
+#if (configGENERATE_RUN_TIME_STATS == 1)
+StackType_t runTimeStatsTaskStack[RUN_TIME_STATS_TASK_STACKSIZE];
+StaticTask_t runTimeStatsTaskTCB;
+#endif
+#if (configUSE_TRACE_RECORDER == 1)
+StackType_t traceDumpTaskStack[TRACE_DUMP_TASK_STACKSIZE];
+StaticTask_t traceDumpTaskTCB;
+#endif
+#if LOG_DRAIN_TASK
+StackType_t logDrainTaskStack[LOG_DRAIN_TASK_STACKSIZE];
+StaticTask_t logDrainTaskTCB;
+#endif
+#if (configUSE_TELEMETRY == 1)
+StackType_t telemetryTaskStack[TELEMETRY_TASK_STACKSIZE];
+StaticTask_t telemetryTaskTCB;
+#endif
+#if (configUSE_COMMAND_CHANNEL == 1)
+StackType_t commandTaskStack[COMMAND_TASK_STACKSIZE];
+StaticTask_t commandTaskTCB;
+#endif
+#if (configUSE_STORE == 1)
+StackType_t storeTaskStack[STORE_TASK_STACKSIZE];
+StaticTask_t storeTaskTCB;
+#endif
+#if (configUSE_PROFILER == 1)
+StackType_t profileDumpTaskStack[PROFILE_DUMP_TASK_STACKSIZE];
+StaticTask_t profileDumpTaskTCB;
+#endif
+
+// Kernel tasks, handed over by vApplicationGetIdleTaskMemory() and
+// vApplicationGetTimerTaskMemory()
+StackType_t idleTaskStack[configMINIMAL_STACK_SIZE];
+StaticTask_t idleTaskTCB;
+#if (configUSE_TIMERS == 1)
+StackType_t timerTaskStack[configTIMER_TASK_STACK_DEPTH];
+StaticTask_t timerTaskTCB;
+#endif
+
+/*#################################################################
+############################### Stack Monitor #####################
+################################################################### */
+// stackMonitorTask samples the high water mark of every stack each
+// STACK_MONITOR_PERIOD and keeps the least headroom seen. It recommends the
+// words used plus STACK_MONITOR_MARGIN_PERCENT, rounded up to
+// STACK_MONITOR_ROUND_WORDS. The margin covers calls made deeper in a task
+// than the test mode reaches.
+#if (STACK_MONITOR == 1)
+#if (STACK_MONITOR_TEST == 1)
+#define STACK_MONITOR_PERIOD (5000)/portTICK_PERIOD_MS
+#else
+#define STACK_MONITOR_PERIOD (60000)/portTICK_PERIOD_MS
+#endif
+#define STACK_MONITOR_MARGIN_PERCENT 25
+#define STACK_MONITOR_ROUND_WORDS 64
+
+StackType_t stackMonitorTaskStack[STACK_MONITOR_TASK_STACKSIZE];
+StaticTask_t stackMonitorTaskTCB;
+
+struct stackMonitorEntry{
+	const char *name;
+	TaskHandle_t handle;	// NULL for the interrupt stack
+	UBaseType_t size;		// Words
+	UBaseType_t minFree;	// Fewest words ever left free
+};
+
+// xTaskCreateStatic() hands back the TCB buffer as the task's handle
+struct stackMonitorEntry stackMonitorEntries[] = {
+	{"vgaTask", (TaskHandle_t)&vgaTaskTCB, VGA_TASK_STACKSIZE, VGA_TASK_STACKSIZE},
+	{"keyboardManagerTask", (TaskHandle_t)&keyboardManagerTaskTCB, KEYBOARD_TASK_STACKSIZE, KEYBOARD_TASK_STACKSIZE},
+	{"frequencyUpdaterTask", (TaskHandle_t)&frequencyUpdaterTaskTCB, FREQUENCY_UPDATER_TASK_STACKSIZE, FREQUENCY_UPDATER_TASK_STACKSIZE},
+	{"loadManagerTask", (TaskHandle_t)&loadManagerTaskTCB, LOAD_MANAGER_TASK_STACKSIZE, LOAD_MANAGER_TASK_STACKSIZE},
+#if (configGENERATE_RUN_TIME_STATS == 1)
+	{"runTimeStatsTask", (TaskHandle_t)&runTimeStatsTaskTCB, RUN_TIME_STATS_TASK_STACKSIZE, RUN_TIME_STATS_TASK_STACKSIZE},
+#endif
+#if (configUSE_TRACE_RECORDER == 1)
+	{"traceDumpTask", (TaskHandle_t)&traceDumpTaskTCB, TRACE_DUMP_TASK_STACKSIZE, TRACE_DUMP_TASK_STACKSIZE},
+#endif
+#if LOG_DRAIN_TASK
+	{"logDrainTask", (TaskHandle_t)&logDrainTaskTCB, LOG_DRAIN_TASK_STACKSIZE, LOG_DRAIN_TASK_STACKSIZE},
+#endif
+#if (configUSE_TELEMETRY == 1)
+	{"telemetryTask", (TaskHandle_t)&telemetryTaskTCB, TELEMETRY_TASK_STACKSIZE, TELEMETRY_TASK_STACKSIZE},
+#endif
+#if (configUSE_COMMAND_CHANNEL == 1)
+	{"commandTask", (TaskHandle_t)&commandTaskTCB, COMMAND_TASK_STACKSIZE, COMMAND_TASK_STACKSIZE},
+#endif
+#if (configUSE_STORE == 1)
+	{"storeTask", (TaskHandle_t)&storeTaskTCB, STORE_TASK_STACKSIZE, STORE_TASK_STACKSIZE},
+#endif
+#if (configUSE_PROFILER == 1)
+	{"profileDumpTask", (TaskHandle_t)&profileDumpTaskTCB, PROFILE_DUMP_TASK_STACKSIZE, PROFILE_DUMP_TASK_STACKSIZE},
+#endif
+	{"stackMonitorTask", (TaskHandle_t)&stackMonitorTaskTCB, STACK_MONITOR_TASK_STACKSIZE, STACK_MONITOR_TASK_STACKSIZE},
+	{"idle", (TaskHandle_t)&idleTaskTCB, configMINIMAL_STACK_SIZE, configMINIMAL_STACK_SIZE},
+#if (configUSE_TIMERS == 1)
+	{"timer service", (TaskHandle_t)&timerTaskTCB, configTIMER_TASK_STACK_DEPTH, configTIMER_TASK_STACK_DEPTH},
+#endif
+	{"interrupts", NULL, configISR_STACK_SIZE, configISR_STACK_SIZE}
+};
+#define STACK_MONITOR_ENTRIES (sizeof(stackMonitorEntries) / sizeof(stackMonitorEntries[0]))
+#endif
+
+// Library calls stackMonitorExercise() can run, the deepest the tasks make
+#define STACK_PATH_PRINTF 0x01
+#define STACK_PATH_PRINTF_FLOAT 0x02
+#define STACK_PATH_LCD 0x04
+#if (STACK_MONITOR_TEST == 1)
+#define STACK_MONITOR_EXERCISE(paths) stackMonitorExercise(paths)
+#else
+#define STACK_MONITOR_EXERCISE(paths)
+#endif
+
+// Tasks woken from an ISR by notification
+TaskHandle_t keyboardManagerTaskHandle;
+TaskHandle_t frequencyUpdaterTaskHandle;
+// Woken by stabilityTimer
+TaskHandle_t loadManagerTaskHandle;
+#if (configUSE_TRACE_RECORDER == 1)
+TaskHandle_t traceDumpTaskHandle;
+#endif
+// Woken by the first LOG() or LOG_EVENT() record into an empty ring
+#if LOG_DRAIN_TASK
+TaskHandle_t logDrainTaskHandle;
+#endif
+// Woken by the first telemetry frame into an empty ring
+#if (configUSE_TELEMETRY == 1)
+TaskHandle_t telemetryTaskHandle;
+#endif
+// Woken when the store's batch of events is half full
+#if (configUSE_STORE == 1)
+TaskHandle_t storeTaskHandle;
+#endif
+// Woken by a profile request on the command channel
+#if (configUSE_PROFILER == 1)
+TaskHandle_t profileDumpTaskHandle;
+#endif
+
+/*#################################################################
+############################### Boot Timing #######################
+################################################################### */
+// TIMER1US is left free running from the top of main() so the time taken to
+// create the OS objects and get the first task running can be reported.
+// Times are TIMER1US cycles since main() was entered, except
+// bootObjectCreationTime which covers initOSDataStructs() and initCreateTasks().
+#define BOOT_TIMER_CYCLES_PER_US (TIMER1US_FREQ / 1000000)
+alt_u32 bootObjectCreationTime = 0;
+alt_u32 bootTimeSchedulerStart = 0;
+alt_u32 bootTimeFirstTask = 0;
+// Time initStore() took to read back the store
+alt_u32 bootStoreRecoveryTime = 0;
+// When loadManagerTask first judged a sample or a stability window
+alt_u32 bootTimeFirstDecision = 0;
+
+/*#################################################################
+############################### Run Time Stats ####################
+################################################################### */
+// The kernel charges every TIMER1US cycle to the task that was running
+// (port_runtime.c). runTimeStatsTask prints each task's share to the JTAG UART.
+#define RUN_TIME_STATS_PERIOD (10000)/portTICK_PERIOD_MS
+#define RUN_TIME_CYCLES_PER_MS (TIMER1US_FREQ / 1000)
+// Application tasks plus the idle and timer tasks, with room to spare
+#define RUN_TIME_STATS_MAX_TASKS 16
+
+/*#################################################################
+############################### Kernel Trace ######################
+################################################################### */
+// The kernel records every context switch, queue operation and interrupt
+// into a ring (FreeRTOS/trace.c). loadManagerTask times how long it takes to
+// wake after frequencyUpdaterTask queues a sample and if it wakes late the ring
+// is frozen and traceDumpTask prints it to the JTAG UART for
+// host/tools/trace_decode.
+#define LOAD_MANAGER_WAKE_TRIGGER_US 2000
+alt_u32 loadManagerOverrunUs = 0;
+// Set by a snapshot request on the command channel, which also freezes the
+// ring for traceDumpTask
+volatile uint8_t traceSnapshotRequested = 0;
+// bootTimerRead() when frequencyUpdaterTask last queued a sample
+alt_u32 newSampleTime = 0;
+
+/*#################################################################
+############################### PC Sampling Profiler ##############
+################################################################### */
+// With configUSE_PROFILER the port samples the interrupted PC on every tick
+// (FreeRTOS/profiler.c). A profile request on the command channel has
+// profileDumpTask print the samples since the last one to the JTAG UART for
+// host/tools/profile_fold and start counting afresh.
+// Set while profileDumpTask prints, so a second request gets BUSY
+volatile uint8_t profileDumpRequested = 0;
+
+/*#################################################################
+############################### Interrupt Priorities ##############
+################################################################### */
+// Higher numbers interrupt lower ones' handlers (FreeRTOS/port.c). The
+// frequency analyser sits above the keyboard and buttons so a slow PS/2 decode
+// cannot delay the sample the shedding decision is made on. The tick stays at
+// configKERNEL_INTERRUPT_PRIORITY. No ISR may be above
+// configMAX_SYSCALL_INTERRUPT_PRIORITY as they all call FromISR functions.
+#define BUTTON_IRQ_PRIORITY 2
+#define PS2_IRQ_PRIORITY 2
+#define FREQUENCY_ANALYSER_IRQ_PRIORITY configMAX_SYSCALL_INTERRUPT_PRIORITY
 
 /*#################################################################
 ############################### PROTOTYPES ########################
@@ -132,6 +646,10 @@ struct freqQMsg
 void initOSDataStructs(void);
 void initCreateTasks(void);
 void initPeripheralsAndIsrs(void);
+void bootTimerStart(void);
+alt_u32 bootTimerRead(void);
+void printBootTimes(void);
+void initStore(void);
 /*####################### Init ISR Prototypes ################## */
 void setupKeyboardISR(void);
 void setupButtonsISR(void);
@@ -140,16 +658,24 @@ void setupVGA(void);
 void frequencyAnalyserISR(void* context, alt_u32 id);
 void ps2ISR (void* context, alt_u32 id);
 void buttonISR (void* context, alt_u32 id);
-/*####################### Timer Callback ######################### */
-void vTimer500MSCallback(xTimerHandle t_timer);
 /*####################### Tasks Prototypes ######################### */
 void vgaTask(void *pvParameters);
 void keyboardManagerTask(void *pvParameters);
 void loadManagerTask(void *pvParameters);
 void frequencyUpdaterTask(void *pvParameters);
+void runTimeStatsTask(void *pvParameters);
+void traceDumpTask(void *pvParameters);
+void stackMonitorTask(void *pvParameters);
+void logDrainTask(void *pvParameters);
+void telemetryTask(void *pvParameters);
+void commandTask(void *pvParameters);
+void storeTask(void *pvParameters);
+void profileDumpTask(void *pvParameters);
 /*####################### Helper Prototypes ######################### */
-void stopFreeRTOSTimer(void);
-void restartFreeRTOSTimer(void);
+void stopStabilityTimer(void);
+void restartStabilityTimer(void);
+uint32_t waitForLoadManagerEvents(void);
+void stackMonitorExercise(uint8_t paths);
 uint8_t checkTrippingConditions(struct freqRocQMsg freqRocMsg, float freqThresholdLocal, int rocThresholdLocal);
 void updateSwitches(uint8_t SWITCHES[]);
 int loadUpdater(int reqTime, uint8_t SWITCHES[]);
@@ -157,13 +683,40 @@ uint8_t reconnectLoad(uint8_t SWITCHES[]);
 uint8_t shedLoad(uint8_t SWITCHES[]);
 void computeReactionTimeStats(int currentTime,struct freqRocQMsg freqRocMsg);
 void updateRunningData(struct freqRocQMsg freqRocMsg);
+int heldEntries(int index, int shifts, int size);
+int newestFirst(int i, int index, int shifts, int size);
+int reactionTimeAverage(void);
 void manualCheckAndSwitchOffLoads(uint8_t SWITCHES[]);
-/*####################### Test Prototypes ######################### */
-void testLoadSheddingAndReconnecting();
-void testComputeReactionTimeStats();
-void testUpdateRunningData();
-void testManualSwitchOffLoad1();
-void testManualSwitchOffLoad2();
+void setLoadManagerState(uint8_t newState);
+void noteFirstDecision(void);
+int32_t toEventLogFixedPoint(float value, int32_t min, int32_t max);
+void logEvent(uint8_t event, uint8_t load, uint32_t value);
+size_t telemetryUartWrite(const uint8_t *data, size_t length);
+#if (configUSE_COMMAND_CHANNEL == 1)
+void handleCommand(const Command_t *command);
+uint8_t commandThresholds(const Command_t *command, uint8_t *result, size_t *length);
+uint8_t commandStats(uint8_t *result, size_t *length);
+uint8_t commandHistory(const Command_t *command, uint8_t *result, size_t *length);
+uint8_t commandMaintenance(const Command_t *command, uint8_t *result, size_t *length);
+uint8_t commandSnapshot(void);
+uint8_t commandProfile(void);
+void commandPut(uint8_t *buffer, uint32_t value, uint8_t bytes);
+#endif
+#if (configUSE_STORE == 1)
+void storeThresholds(void);
+void storeReactionStats(void);
+void storeEvent(uint8_t event, uint8_t load);
+void storeSnapshot(void);
+void restoreSnapshot(void);
+BaseType_t storeFlashRead(void *context, uint32_t offset, void *buffer, size_t length);
+BaseType_t storeFlashProgram(void *context, uint32_t offset, const void *data, size_t length);
+BaseType_t storeFlashErase(void *context, uint32_t offset);
+#endif
+uint8_t receiveFreqRocMsg(struct freqRocQMsg *freqRocMsg);
+uint8_t ps2KeyRingPut(unsigned char key);
+uint8_t ps2KeyRingGet(unsigned char *key);
+uint8_t frequencyRingPut(const struct freqQMsg *msg);
+uint8_t frequencyRingGet(struct freqQMsg *msg);
 /*##################################################################
 ############################### ISR CODE ###########################
 #################################################################### */
@@ -175,22 +728,32 @@ void buttonISR (void* context, alt_u32 id){
 	  uint8_t buttonValue;
 	  buttonValue = IORD_ALTERA_AVALON_PIO_EDGE_CAP(PUSH_BUTTON_BASE);
 
+	  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
 	  //Key3
 	  maintainenceModeEn = !maintainenceModeEn;
 	  // clears the edge capture register
 	  IOWR_ALTERA_AVALON_PIO_EDGE_CAP(PUSH_BUTTON_BASE, 0x4);
+	  (void)buttonValue;
 
+	  xTaskNotifyFromISR(loadManagerTaskHandle, MAINTENANCE_TOGGLE_EVENT, eSetBits, &xHigherPriorityTaskWoken);
+	  portEND_SWITCHING_ISR(xHigherPriorityTaskWoken);
 }
 
 /*ADC ISR Values for frequency and timestamp generation*/
 void frequencyAnalyserISR(void* context, alt_u32 id){
 	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+	struct freqQMsg freqISRMsg;
 
 	freqISRMsg.frequency = 16000/(double)IORD(FREQUENCY_ANALYSER_BASE, 0);
 	freqISRMsg.timestamp = xTaskGetTickCountFromISR();
 
-	xQueueSendToBackFromISR(frequencyQ, &freqISRMsg, &xHigherPriorityTaskWoken);
+	// Ring full: drop the sample. Otherwise wake frequencyUpdaterTask
+	if(frequencyRingPut(&freqISRMsg)){
+		vTaskNotifyGiveFromISR(frequencyUpdaterTaskHandle, &xHigherPriorityTaskWoken);
+	}
 
+	portEND_SWITCHING_ISR(xHigherPriorityTaskWoken);
 	return;
 }
 
@@ -212,16 +775,20 @@ void ps2ISR (void* context, alt_u32 id)
     {
       case KB_ASCII_MAKE_CODE :
 
-    	//Write to Queue
-		xQueueSendToBackFromISR(ps2KeyQ, &key, &xHigherPriorityTaskWoken);
+    	//Write to Ring and wake keyboardManagerTask
+		if(ps2KeyRingPut(key)){
+			vTaskNotifyGiveFromISR(keyboardManagerTaskHandle, &xHigherPriorityTaskWoken);
+		}
 
         break ;
       case KB_LONG_BINARY_MAKE_CODE :
         // do nothing
 		break;
       case KB_BINARY_MAKE_CODE :
-    	//Write to Queue
-    	xQueueSendToBackFromISR(ps2KeyQ, &key, &xHigherPriorityTaskWoken);
+    	//Write to Ring and wake keyboardManagerTask
+		if(ps2KeyRingPut(key)){
+			vTaskNotifyGiveFromISR(keyboardManagerTaskHandle, &xHigherPriorityTaskWoken);
+		}
         break ;
       case KB_BREAK_CODE :
         // do nothing
@@ -236,6 +803,7 @@ void ps2ISR (void* context, alt_u32 id)
 
   }
 
+  portEND_SWITCHING_ISR(xHigherPriorityTaskWoken);
 }
 
 /*Init VGA*/
@@ -246,10 +814,10 @@ void setupVGA(){
 	pixel_buf = alt_up_pixel_buffer_dma_open_dev(VIDEO_PIXEL_BUFFER_DMA_NAME);
 
 	if(pixel_buf == NULL){
-		printf("Cannot find pixel buffer device\n");
+		LOG_ERROR(LOG_VGA, "Cannot find pixel buffer device\n");
 	}else{
 		alt_up_pixel_buffer_dma_clear_screen(pixel_buf, 0);
-		printf("Initialised pixel buffer\n");
+		LOG_INFO(LOG_VGA, "Initialised pixel buffer\n");
 
 	}
 	// initialize character buffer
@@ -257,10 +825,10 @@ void setupVGA(){
 	char_buf = alt_up_char_buffer_open_dev("/dev/video_character_buffer_with_dma");
 
 	if(char_buf == NULL){
-		printf("Cannot find char buffer device\n");
+		LOG_ERROR(LOG_VGA, "Cannot find char buffer device\n");
 	}else{
 		alt_up_char_buffer_clear(char_buf);
-		printf("Initialised char buffer\n");
+		LOG_INFO(LOG_VGA, "Initialised char buffer\n");
 
 	}
 }
@@ -270,18 +838,19 @@ void setupKeyboardISR(){
   alt_up_ps2_dev * ps2_device = alt_up_ps2_open_dev(PS2_NAME);
 
   if(ps2_device == NULL){
-    printf("Can't find PS/2 Keyboard\n");
+    LOG_ERROR(LOG_KEYBOARD, "Can't find PS/2 Keyboard\n");
   }else{
-    printf("Connected to PS/2 Keyboard\n");
+    LOG_INFO(LOG_KEYBOARD, "Connected to PS/2 Keyboard\n");
   }
 
   alt_up_ps2_clear_fifo (ps2_device) ;
 
   alt_irq_register(PS2_IRQ, ps2_device, ps2ISR);
+  vPortSetInterruptPriority(PS2_IRQ, PS2_IRQ_PRIORITY);
   // register the PS/2 interrupt
   IOWR_8DIRECT(PS2_BASE,4,1);
 
-  printf("Registered PS2 ISR!\n");
+  LOG_DEBUG(LOG_KEYBOARD, "Registered PS2 ISR!\n");
 
 }
 
@@ -297,8 +866,9 @@ void setupButtonsISR(){
 
   // register the ISR
   alt_irq_register(PUSH_BUTTON_IRQ,0, buttonISR);
+  vPortSetInterruptPriority(PUSH_BUTTON_IRQ, BUTTON_IRQ_PRIORITY);
 
-  printf("Registered Button ISR!\n");
+  LOG_DEBUG(LOG_LOAD_MANAGER, "Registered Button ISR!\n");
 
 }
 
@@ -310,14 +880,66 @@ void setupButtonsISR(){
 void initCreateTasks()
 {
 	/*INIT TASKS*/
-	xTaskCreate (vgaTask,"vgaTask", TASK_STACKSIZE, NULL, VGA_TASK_PRIORITY, NULL);
-	xTaskCreate(keyboardManagerTask, "keyboardManagerTask", TASK_STACKSIZE, NULL, KEYBOARD_TASK_PRIORITY, NULL);
-	xTaskCreate(frequencyUpdaterTask, "frequencyUpdaterTask", TASK_STACKSIZE,NULL,FREQUENCY_UPDATER_TASK_PRIORITY,NULL);
-	xTaskCreate(loadManagerTask, "loadManagerTask", TASK_STACKSIZE,NULL,LOAD_MANAGER_TASK_PRIORITY,NULL);
+	xTaskCreateStatic(vgaTask, "vgaTask", VGA_TASK_STACKSIZE, NULL, VGA_TASK_PRIORITY, vgaTaskStack, &vgaTaskTCB);
+	keyboardManagerTaskHandle = xTaskCreateStatic(keyboardManagerTask, "keyboardManagerTask", KEYBOARD_TASK_STACKSIZE, NULL, KEYBOARD_TASK_PRIORITY, keyboardManagerTaskStack, &keyboardManagerTaskTCB);
+	frequencyUpdaterTaskHandle = xTaskCreateStatic(frequencyUpdaterTask, "frequencyUpdaterTask", FREQUENCY_UPDATER_TASK_STACKSIZE, NULL, FREQUENCY_UPDATER_TASK_PRIORITY, frequencyUpdaterTaskStack, &frequencyUpdaterTaskTCB);
+	loadManagerTaskHandle = xTaskCreateStatic(loadManagerTask, "loadManagerTask", LOAD_MANAGER_TASK_STACKSIZE, NULL, LOAD_MANAGER_TASK_PRIORITY, loadManagerTaskStack, &loadManagerTaskTCB);
+	// Timer for Stability Observation
+	vTickTimerInit(&stabilityTimer, loadManagerTaskHandle, STABILITY_TIMER_EXPIRED);
+#if (configGENERATE_RUN_TIME_STATS == 1)
+	xTaskCreateStatic(runTimeStatsTask, "runTimeStatsTask", RUN_TIME_STATS_TASK_STACKSIZE, NULL, RUN_TIME_STATS_TASK_PRIORITY, runTimeStatsTaskStack, &runTimeStatsTaskTCB);
+#endif
+#if (configUSE_TRACE_RECORDER == 1)
+	traceDumpTaskHandle = xTaskCreateStatic(traceDumpTask, "traceDumpTask", TRACE_DUMP_TASK_STACKSIZE, NULL, TRACE_DUMP_TASK_PRIORITY, traceDumpTaskStack, &traceDumpTaskTCB);
+#endif
+#if (STACK_MONITOR == 1)
+	xTaskCreateStatic(stackMonitorTask, "stackMonitorTask", STACK_MONITOR_TASK_STACKSIZE, NULL, STACK_MONITOR_TASK_PRIORITY, stackMonitorTaskStack, &stackMonitorTaskTCB);
+#endif
+#if LOG_DRAIN_TASK
+	logDrainTaskHandle = xTaskCreateStatic(logDrainTask, "logDrainTask", LOG_DRAIN_TASK_STACKSIZE, NULL, LOG_DRAIN_TASK_PRIORITY, logDrainTaskStack, &logDrainTaskTCB);
+#endif
+#if (configUSE_LOGGER == 1)
+	vLogSetDrainTask(logDrainTaskHandle);
+#endif
+#if (configUSE_EVENT_LOG == 1)
+	vEventLogSetDrainTask(logDrainTaskHandle);
+#endif
+#if (configUSE_TELEMETRY == 1)
+	telemetryTaskHandle = xTaskCreateStatic(telemetryTask, "telemetryTask", TELEMETRY_TASK_STACKSIZE, NULL, TELEMETRY_TASK_PRIORITY, telemetryTaskStack, &telemetryTaskTCB);
+	vTelemetrySetDrainTask(telemetryTaskHandle);
+#endif
+#if (configUSE_COMMAND_CHANNEL == 1)
+	xTaskCreateStatic(commandTask, "commandTask", COMMAND_TASK_STACKSIZE, NULL, COMMAND_TASK_PRIORITY, commandTaskStack, &commandTaskTCB);
+#endif
+#if (configUSE_STORE == 1)
+	storeTaskHandle = xTaskCreateStatic(storeTask, "storeTask", STORE_TASK_STACKSIZE, NULL, STORE_TASK_PRIORITY, storeTaskStack, &storeTaskTCB);
+	vStoreSetFlushTask(storeTaskHandle);
+#endif
+#if (configUSE_PROFILER == 1)
+	profileDumpTaskHandle = xTaskCreateStatic(profileDumpTask, "profileDumpTask", PROFILE_DUMP_TASK_STACKSIZE, NULL, PROFILE_DUMP_TASK_PRIORITY, profileDumpTaskStack, &profileDumpTaskTCB);
+#endif
 
 	return;
 }
 
+// Called by vTaskStartScheduler() for the idle task's memory
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint16_t *pusIdleTaskStackSize)
+{
+	*ppxIdleTaskTCBBuffer = &idleTaskTCB;
+	*ppxIdleTaskStackBuffer = idleTaskStack;
+	*pusIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+#if (configUSE_TIMERS == 1)
+// Called by vTaskStartScheduler() for the timer service task's memory
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint16_t *pusTimerTaskStackSize)
+{
+	*ppxTimerTaskTCBBuffer = &timerTaskTCB;
+	*ppxTimerTaskStackBuffer = timerTaskStack;
+	*pusTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+#endif
+
 void initPeripheralsAndIsrs(){
 	setupKeyboardISR();
 	setupButtonsISR();
@@ -325,12 +947,11 @@ void initPeripheralsAndIsrs(){
 
 	// setup freq isr
 	alt_irq_register(FREQUENCY_ANALYSER_IRQ, 0, frequencyAnalyserISR);
-    // create Timer for Stability Observation
-	timer500ms = xTimerCreate("Timer", TIMER_PERIOD, pdFALSE, NULL, vTimer500MSCallback);
+	vPortSetInterruptPriority(FREQUENCY_ANALYSER_IRQ, FREQUENCY_ANALYSER_IRQ_PRIORITY);
 
-	// Init LEDS
-	IOWR_ALTERA_AVALON_PIO_DATA(RED_LEDS_BASE, ALLON);
-	IOWR_ALTERA_AVALON_PIO_DATA(GREEN_LEDS_BASE, ALLOFF);
+	// Init LEDS. The loads as restored by initStore(), all on without it
+	IOWR_ALTERA_AVALON_PIO_DATA(RED_LEDS_BASE, loadStatus);
+	IOWR_ALTERA_AVALON_PIO_DATA(GREEN_LEDS_BASE, (loadManagerState == LOAD_MANAGE) ? (ALLON & ~loadStatus) : ALLOFF);
 }
 
 
@@ -340,39 +961,197 @@ void initPeripheralsAndIsrs(){
 void initOSDataStructs()
 {
 	/*INIT Q's*/
-	ps2KeyQ = xQueueCreate(100, sizeof(uint32_t));
-	frequencyQ = xQueueCreate(100, sizeof(struct freqQMsg));
-	freqRocDataQ = xQueueCreate(50, sizeof( struct freqRocQMsg));
+	freqRocDataQ = xQueueCreateStatic(FREQ_ROC_DATA_Q_LENGTH, sizeof(struct freqRocQMsg), (uint8_t *)freqRocDataQStorage, &freqRocDataQBuffer);
 
 	/*INIT Mutexes*/
-	thresholdSemaphore = xSemaphoreCreateMutex();
+	thresholdSemaphore = xSemaphoreCreateMutexStatic(&thresholdSemaphoreBuffer);
 
 	return;
 }
 
+#if (configUSE_STORE == 1)
+/*
+ * Opens the CFI flash, finds what the store holds and restores the
+ * thresholds and the reaction time statistics. Only reads block headers and
+ * the newest block, and runs before the scheduler so the tasks start with
+ * what was kept. Without the flash the relay starts with its defaults and
+ * nothing is kept
+ * */
+void initStore(void){
+	flash_region *regions;
+	int regionCount;
+	int i, sum = 0;
+	struct storedThresholds thresholds;
+	struct storedReactionStats stats;
+
+	storeFlashDevice = alt_flash_open_dev(FLASH_CONTROLLER_NAME);
+	if(storeFlashDevice == NULL || alt_get_flash_info(storeFlashDevice, &regions, &regionCount) != 0){
+		printf("Can't open %s, settings will not be kept\n", FLASH_CONTROLLER_NAME);
+		storeFlashDevice = NULL;
+		return;
+	}
+
+	// The top blocks of the last region big enough, which skips the small
+	// boot blocks at the top of a top boot device
+	for(i = regionCount - 1; i >= 0; i--){
+		if(regions[i].number_of_blocks >= STORE_FLASH_BLOCKS){
+			break;
+		}
+	}
+	if(i < 0){
+		printf("No %d erase blocks in %s, settings will not be kept\n", STORE_FLASH_BLOCKS, FLASH_CONTROLLER_NAME);
+		storeFlashDevice = NULL;
+		return;
+	}
+
+	storeFlash.pxRead = storeFlashRead;
+	storeFlash.pxProgram = storeFlashProgram;
+	storeFlash.pxErase = storeFlashErase;
+	storeFlash.pvContext = storeFlashDevice;
+	storeFlash.ulBlockSize = regions[i].block_size;
+	storeFlash.ulBlockCount = STORE_FLASH_BLOCKS;
+	storeFlash.ulBase = regions[i].offset + regions[i].region_size - STORE_FLASH_BLOCKS * regions[i].block_size;
+
+	if(xStoreInit(&storeFlash) != pdPASS){
+		printf("Can't read the store in %s, settings will not be kept\n", FLASH_CONTROLLER_NAME);
+		storeFlashDevice = NULL;
+		return;
+	}
+
+	if(xStoreGetValue(STORE_KEY_THRESHOLDS, &thresholds, sizeof(thresholds)) == sizeof(thresholds)){
+		frequencyThreshold = (float)thresholds.frequency / 10;
+		rocThreshold = thresholds.roc;
+	}
+
+	if(xStoreGetValue(STORE_KEY_REACTION_STATS, &stats, sizeof(stats)) == sizeof(stats) && stats.held <= 5){
+		reactionCount = stats.count;
+		minReactionTime = stats.min;
+		maxReactionTime = stats.max;
+		// Stored newest first. Put them back as computeReactionTimeStats() leaves them
+		if(stats.held == 5){
+			for(i = 0; i < 5; i++){
+				reactionTimes[i] = stats.times[i];
+			}
+			reactionTimeIndex = 4;
+			reactionTimeShifts = 5;
+		}else{
+			for(i = 0; i < stats.held; i++){
+				reactionTimes[i] = stats.times[stats.held - 1 - i];
+			}
+			reactionTimeIndex = stats.held;
+		}
+		for(i = 0; i < 5; i++){
+			sum += reactionTimes[i];
+		}
+		// As computeReactionTimeStats() averages them
+		avgReactionTime = sum / 5;
+	}
+
+	xStoreGetValue(STORE_KEY_BOOT_COUNT, &storeBootCount, sizeof(storeBootCount));
+	storeBootCount++;
+	xStoreSetValue(STORE_KEY_BOOT_COUNT, &storeBootCount, sizeof(storeBootCount));
+
+#if (STORE_SNAPSHOT_RESTORE == 1)
+	restoreSnapshot();
+#endif
+}
+
+/*
+ * Puts the load manager back as the last snapshot left it. Anything out of
+ * range is ignored and the relay starts with its defaults
+ * */
+void restoreSnapshot(void){
+	struct storedSnapshot snapshot;
+	int i;
+
+	if(xStoreGetValue(STORE_KEY_SNAPSHOT, &snapshot, sizeof(snapshot)) != sizeof(snapshot) || snapshot.state > MAINTENANCE ||
+			snapshot.loads > ALLON || snapshot.samples > STORE_SNAPSHOT_SAMPLES || snapshot.timerRemaining > TIMER_PERIOD){
+		return;
+	}
+
+	loadManagerState = snapshot.state;
+	loadStatus = snapshot.loads;
+	wasStable = snapshot.wasStable ? 1 : 0;
+	maintainenceModeEn = snapshot.maintenance ? 1 : 0;
+	restoredTimerRemaining = snapshot.timerRemaining;
+
+	// Stored newest first, put back oldest first as updateRunningData() fills
+	runningDataIndex = snapshot.samples;
+	for(i = 0; i < snapshot.samples; i++){
+		frequencyData[i] = (float)snapshot.frequency[snapshot.samples - 1 - i] / eventlogFIXED_POINT_SCALE;
+		rocData[i] = (float)snapshot.roc[snapshot.samples - 1 - i] / eventlogFIXED_POINT_SCALE;
+	}
+
+	printf("Store: restored state %u, loads 0x%02x, %u ticks left in the stability window\n",
+			(unsigned)loadManagerState, (unsigned)loadStatus, (unsigned)restoredTimerRemaining);
+}
+#endif
+
 /*##################################################################
-############################### Timer Callback #####################
+############################### Boot Timing ########################
 #################################################################### */
-void vTimer500MSCallback(xTimerHandle t_timer){
 
-	// Set Timer Exp Flag
-	timerExpiryFlag = 1;
-	printf("\n\n################Timer Expired!##############\n\n");
+// Runs TIMER1US down from 0xFFFFFFFF without interrupts. Wraps after ~42s at
+// 100MHz, long after boot has finished.
+void bootTimerStart(void){
+	IOWR_ALTERA_AVALON_TIMER_CONTROL(TIMER1US_BASE, ALTERA_AVALON_TIMER_CONTROL_STOP_MSK);
+	IOWR_ALTERA_AVALON_TIMER_PERIODL(TIMER1US_BASE, 0xFFFF);
+	IOWR_ALTERA_AVALON_TIMER_PERIODH(TIMER1US_BASE, 0xFFFF);
+	IOWR_ALTERA_AVALON_TIMER_CONTROL(TIMER1US_BASE, ALTERA_AVALON_TIMER_CONTROL_CONT_MSK | ALTERA_AVALON_TIMER_CONTROL_START_MSK);
 }
 
+// Cycles since bootTimerStart(). The counter runs down from all ones so the
+// elapsed count is its complement.
+alt_u32 bootTimerRead(void){
+	alt_u32 snapshot;
+
+	IOWR_ALTERA_AVALON_TIMER_SNAPL(TIMER1US_BASE, 0);
+	snapshot = (IORD_ALTERA_AVALON_TIMER_SNAPH(TIMER1US_BASE) & 0xFFFF) << 16;
+	snapshot |= IORD_ALTERA_AVALON_TIMER_SNAPL(TIMER1US_BASE) & 0xFFFF;
+
+	return ~snapshot;
+}
 
+void printBootTimes(void){
+	printf("Boot: OS objects created in %luus, scheduler started at %luus, first task at %luus\n",
+			(unsigned long)(bootObjectCreationTime / BOOT_TIMER_CYCLES_PER_US),
+			(unsigned long)(bootTimeSchedulerStart / BOOT_TIMER_CYCLES_PER_US),
+			(unsigned long)(bootTimeFirstTask / BOOT_TIMER_CYCLES_PER_US));
+#if (configUSE_STORE == 1)
+	printf("Boot: store read back in %luus\n", (unsigned long)(bootStoreRecoveryTime / BOOT_TIMER_CYCLES_PER_US));
+#endif
+}
 
 /*##################################################################
 ############################### MAIN() ##############################
 #################################################################### */
 int main(int argc, char* argv[], char* envp[])
 {
+	alt_u32 objectCreationStart;
+#if (configUSE_STORE == 1)
+	alt_u32 storeStart;
+#endif
+
+	bootTimerStart();
+
+#if (configUSE_STORE == 1)
+	// Before the loads are driven and the scheduler starts, so the relay
+	// starts as it was left
+	storeStart = bootTimerRead();
+	initStore();
+	bootStoreRecoveryTime = bootTimerRead() - storeStart;
+#endif
+
 	initPeripheralsAndIsrs();
+
+	objectCreationStart = bootTimerRead();
 	initOSDataStructs();
-	printf("Struct initialised!\n");
 	initCreateTasks();
-	printf("Tasks initialised!\n");
+	bootObjectCreationTime = bootTimerRead() - objectCreationStart;
+	LOG_DEBUG(LOG_BOOT, "Struct initialised!\n");
+	LOG_DEBUG(LOG_BOOT, "Tasks initialised!\n");
 
+	bootTimeSchedulerStart = bootTimerRead();
 	vTaskStartScheduler();
 
 	/*Code is not executed after Scheduler Starts  */
@@ -408,9 +1187,10 @@ void vgaTask(void *pvParameters){
 	unsigned int startX  ;
 	unsigned int dpWidth ;
 	unsigned long currentSystemTime = 0;
-	char str[10] = "str";
-
+	// Holds up to "Min:1000000", the initial minimum reaction time
+	char str[16] = "str";
 
+	STACK_MONITOR_EXERCISE(STACK_PATH_PRINTF_FLOAT);
 
 	while(1){
 		// Clear the screen
@@ -543,7 +1323,8 @@ void vgaTask(void *pvParameters){
 
 		}
 
-		// Refresh Rate(As quick as possible rather than a specified rate)
+		// Redraw once a frame rather than as quickly as possible
+		vTaskDelay(VGA_REFRESH_PERIOD);
 	}
 
 }
@@ -596,6 +1377,8 @@ void keyboardManagerTask(void *pvParameters){
 	int freqBuffer[2];
 	int freqBufferItems;
 
+	STACK_MONITOR_EXERCISE(STACK_PATH_PRINTF_FLOAT | STACK_PATH_LCD);
+
 	lcd = fopen(CHARACTER_LCD_NAME, "w");
 	fprintf(lcd, "%c%s", ESC, CLEAR_LCD_STRING);
 	fprintf(lcd, "ENTER 1 FOR Freq \r\n");
@@ -606,7 +1389,10 @@ void keyboardManagerTask(void *pvParameters){
 
 	while(1)
 	{
-		if(xQueueReceive(ps2KeyQ, &input, 0) == pdPASS){
+		// Sleeps until ps2ISR has put a key in the ring
+		ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+
+		if(ps2KeyRingGet(&input)){
 		  if (ps2RisingEdgeFlag == 0){
 			  ps2RisingEdgeFlag =1;
 		  }else{
@@ -651,8 +1437,10 @@ void keyboardManagerTask(void *pvParameters){
 							xSemaphoreTake(thresholdSemaphore, 0);
 
 							frequencyThreshold = freqBuffer[0] * 10 + freqBuffer[1];
+							LOG_EVENT(eventlogEVENT_THRESHOLDS, eventlogNO_LOAD, ((uint32_t)(frequencyThreshold * 10) << 16) | (uint16_t)rocThreshold);
 							// To notify user on console
-							printf("New FreqThres: %.1f Hz\n", frequencyThreshold);
+							LOG_INFO(LOG_KEYBOARD, "New FreqThres: %d Hz\n", (int)frequencyThreshold);
+							STORE_THRESHOLDS();
 
 							xSemaphoreGive(thresholdSemaphore);
 
@@ -728,8 +1516,10 @@ void keyboardManagerTask(void *pvParameters){
 							xSemaphoreTake(thresholdSemaphore, 0);
 
 							rocThreshold = rocBuffer[0] * 100 + rocBuffer[1] * 10 + rocBuffer[2];
+							LOG_EVENT(eventlogEVENT_THRESHOLDS, eventlogNO_LOAD, ((uint32_t)(frequencyThreshold * 10) << 16) | (uint16_t)rocThreshold);
 							// To notify user on console
-							printf("New RocThres: %.1f Hz/Sec\n", (float)rocThreshold/10);
+							LOG_INFO(LOG_KEYBOARD, "New RocThres: %d.%d Hz/Sec\n", rocThreshold / 10, rocThreshold % 10);
+							STORE_THRESHOLDS();
 							xSemaphoreGive(thresholdSemaphore);
 
 						}else{
@@ -798,9 +1588,6 @@ void keyboardManagerTask(void *pvParameters){
 			// To prevent registering incorrect values from fast typing
 			vTaskDelay(200);
 		}
-		// This restricts checking of Keyboard Q at 50ms intervals
-		// (I dont know why someone would want to type that fast)
-		vTaskDelay(50);
 	}
 }
 
@@ -820,16 +1607,13 @@ void keyboardManagerTask(void *pvParameters){
  * -> Manually Switch Off Loads
  * -> Compute Reaction Time Params
  * -> Check Maintenance Mode En Flag to switch mode
+ *
+ * Sleeps between passes until a Load Manager Event arrives (new sample,
+ * stability timer expiry, maintenance button or switch change)
  * */
 
 void loadManagerTask(void *pvParameters){
 
-	//Load Manager State Machine
-	#define NORMAL 0
-	#define LOAD_MANAGE 1
-	#define MAINTENANCE 2
-
-	uint8_t loadManagerState = NORMAL;
 	uint8_t isTripCond = 0;
 
 	float freqThresholdLocal =  0.0;
@@ -839,18 +1623,53 @@ void loadManagerTask(void *pvParameters){
 	struct freqRocQMsg freqRocMsg;
 
 	int timeTaken, reqTime = 0;
+	uint32_t events;
+#if (configUSE_TRACE_RECORDER == 1)
+	alt_u32 wakeTaken;
+#endif
+
+	STACK_MONITOR_EXERCISE(STACK_PATH_PRINTF);
+
+	printBootTimes();
+	LOG_EVENT(eventlogEVENT_BOOT, eventlogNO_LOAD, 0);
+
+#if (configUSE_STORE == 1)
+	// Carry on with the stability window the snapshot was taken in, or a whole
+	// one if it had run out
+	if(loadManagerState == LOAD_MANAGE){
+		vTickTimerStart(&stabilityTimer, (restoredTimerRemaining != 0) ? restoredTimerRemaining : TIMER_PERIOD);
+	}
+#endif
 
 	while(1){
+		// Sleep until there is something to do
+		events = waitForLoadManagerEvents();
+
+#if (configUSE_TRACE_RECORDER == 1)
+		if(events & NEW_SAMPLE_EVENT){
+			wakeTaken = (bootTimerRead() - newSampleTime) / BOOT_TIMER_CYCLES_PER_US;
+
+			// Woke late: keep the events that led up to it
+			if(wakeTaken > LOAD_MANAGER_WAKE_TRIGGER_US && loadManagerOverrunUs == 0){
+				vTraceStop();
+				loadManagerOverrunUs = wakeTaken;
+				xTaskNotifyGive(traceDumpTaskHandle);
+			}
+		}
+#endif
 
 		switch(loadManagerState){
 			case NORMAL:
 
-				if(xQueueReceive(freqRocDataQ, &freqRocMsg, 0)){
-					updateRunningData(freqRocMsg);
+				if(events & SWITCH_CHANGE_EVENT){
 					// Check Switches
 					updateSwitches(SWITCHES);
 					// Manually switch on/off in Normal mode
-					loadUpdater(freqRocMsg.timestamp, SWITCHES);
+					loadUpdater(switchChangeTick, SWITCHES);
+				}
+
+				if(receiveFreqRocMsg(&freqRocMsg)){
+					updateRunningData(freqRocMsg);
 					// Copy over thresholds
 					xSemaphoreTake(thresholdSemaphore, 0);
 
@@ -860,36 +1679,38 @@ void loadManagerTask(void *pvParameters){
 					xSemaphoreGive(thresholdSemaphore);
 
 					isTripCond = checkTrippingConditions(freqRocMsg, freqThresholdLocal, rocThresholdLocal);
+					noteFirstDecision();
 
  	 	 	 	 	if(isTripCond){
+ 	 	 	 	 		LOG_EVENT(eventlogEVENT_TRIP, eventlogNO_LOAD, freqRocMsg.timestamp);
  	 	 	 	 		// Sent Request to Trip Load 0
  	 	 	 	 		shedLoad(SWITCHES);
  	 	 	 	 		computeReactionTimeStats(xTaskGetTickCount(), freqRocMsg);
 
  	 	 	 	 		// Connection is Unstable
  	 	 	 	 		wasStable = 0;
- 	 	 	 	 		loadManagerState = LOAD_MANAGE;
- 	 	 	 	 		restartFreeRTOSTimer();
+ 	 	 	 	 		setLoadManagerState(LOAD_MANAGE);
+ 	 	 	 	 		restartStabilityTimer();
 
- 	 	 	 	 		printf("\n################LOAD MANAGER MODE##########################\n");
+ 	 	 	 	 		LOG_INFO(LOG_LOAD_MANAGER, "\n################LOAD MANAGER MODE##########################\n");
  	 	 	 	 	}
 
 				}
 
-				if (maintainenceModeEn){
+				if (maintainenceModeEn && loadManagerState == NORMAL){
 
-					// If switches are not all turned on do not let the mode be executed
-					while(!(SWITCHES[0]&& SWITCHES[1]&& SWITCHES[2] && SWITCHES[3]&&SWITCHES[4])){
-						printf("\n\nTO BEGIN MAINTENANCE MODE PLEASE SWITCH ALL LOADS ON\n\n");
-						updateSwitches(SWITCHES);
-						vTaskDelay(1000);
+					// If switches are not all turned on do not let the mode be executed,
+					// check again when they change
+					if(!(SWITCHES[0]&& SWITCHES[1]&& SWITCHES[2] && SWITCHES[3]&&SWITCHES[4])){
+						if(events & (MAINTENANCE_TOGGLE_EVENT | SWITCH_CHANGE_EVENT)){
+							LOG_WARN(LOG_LOAD_MANAGER, "\n\nTO BEGIN MAINTENANCE MODE PLEASE SWITCH ALL LOADS ON\n\n");
+						}
+					}else{
+						loadStatus = ALLON;
+						setLoadManagerState(MAINTENANCE);
 
+						LOG_INFO(LOG_LOAD_MANAGER, "\n################MAINTENANCE MODE##########################\n");
 					}
-
-					loadStatus = ALLON;
-					loadManagerState = MAINTENANCE;
-
-					printf("\n################MAINTENANCE MODE##########################\n");
 				}
 
 				break;
@@ -897,32 +1718,36 @@ void loadManagerTask(void *pvParameters){
 			case LOAD_MANAGE:
 
 				// Check if manually disconnected
-				manualCheckAndSwitchOffLoads(SWITCHES);
+				if(events & SWITCH_CHANGE_EVENT){
+					manualCheckAndSwitchOffLoads(SWITCHES);
+				}
 				// Handles timer expiry if an input has not arrived yet
 				if (timerExpiryFlag){
-					printf("#######TIMER EXPIRY BEFORE NEW INPUT RECEIVED#####\n");
+					LOG_DEBUG(LOG_TIMER, "#######TIMER EXPIRY BEFORE NEW INPUT RECEIVED#####\n");
+					LOG_EVENT(eventlogEVENT_STABILITY_EXPIRY, eventlogNO_LOAD, 0);
+					noteFirstDecision();
 					if(wasStable){
 						// Reconnect load (if it returns 1 all loads connected)
 						if(reconnectLoad(SWITCHES) == 1){
-								stopFreeRTOSTimer();
-								loadManagerState = NORMAL;
-								printf("\n\n############ NORMAL MODE ########!\n\n");
+								stopStabilityTimer();
+								setLoadManagerState(NORMAL);
+								LOG_INFO(LOG_LOAD_MANAGER, "\n\n############ NORMAL MODE ########!\n\n");
 						}else{
 							// If not then need to start stability observation again
-							restartFreeRTOSTimer();
+							restartStabilityTimer();
 						}
 
 					}else{
 						// Disconnect
 						shedLoad(SWITCHES);
 
-						restartFreeRTOSTimer();
+						restartStabilityTimer();
 					}
 
 					break;
 				}
 				// Receive a new Frequency/RoC Value
-				if(xQueueReceive(freqRocDataQ, &freqRocMsg, 0)){
+				if(receiveFreqRocMsg(&freqRocMsg)){
 					 updateRunningData(freqRocMsg);
 
 					xSemaphoreTake(thresholdSemaphore, 0);
@@ -933,11 +1758,13 @@ void loadManagerTask(void *pvParameters){
 					xSemaphoreGive(thresholdSemaphore);
 
 					isTripCond = checkTrippingConditions(freqRocMsg, freqThresholdLocal, rocThresholdLocal);
+					noteFirstDecision();
 
 					if(isTripCond && wasStable){
+						LOG_EVENT(eventlogEVENT_TRIP, eventlogNO_LOAD, freqRocMsg.timestamp);
 						wasStable = 0;
 						// Restart Timer as it is now Tripping Condition
-						restartFreeRTOSTimer();
+						restartStabilityTimer();
 
 					}else if(isTripCond && !wasStable){
 
@@ -948,7 +1775,7 @@ void loadManagerTask(void *pvParameters){
 							//shed the next load
 							shedLoad(SWITCHES);
 							// Restart Timer for next 500ms observation
-							restartFreeRTOSTimer();
+							restartStabilityTimer();
 						}
 
 
@@ -959,11 +1786,11 @@ void loadManagerTask(void *pvParameters){
 						if(timerExpiryFlag){
 							if(reconnectLoad(SWITCHES) == 1){
 								// If all loads are connected back to normal state
-								stopFreeRTOSTimer();
-								loadManagerState = NORMAL;
-								printf("\n\n############ NORMAL MODE ########!\n\n");
+								stopStabilityTimer();
+								setLoadManagerState(NORMAL);
+								LOG_INFO(LOG_LOAD_MANAGER, "\n\n############ NORMAL MODE ########!\n\n");
 							}else{
-								restartFreeRTOSTimer();
+								restartStabilityTimer();
 							}
 
 						}
@@ -971,11 +1798,12 @@ void loadManagerTask(void *pvParameters){
 
 
 					}else if(!isTripCond && !wasStable){
+						LOG_EVENT(eventlogEVENT_STABLE, eventlogNO_LOAD, freqRocMsg.timestamp);
 
 						// Loads are currently stable
 						wasStable = 1;
 						// Load Manager needs to start Timer for Stability Observation
-						restartFreeRTOSTimer();
+						restartStabilityTimer();
 
 
 					}
@@ -986,34 +1814,35 @@ void loadManagerTask(void *pvParameters){
 
 			case MAINTENANCE:
 
-				if(xQueueReceive(freqRocDataQ, &freqRocMsg, 0)){
+				if(receiveFreqRocMsg(&freqRocMsg)){
 					updateRunningData(freqRocMsg);
 				}
 
-				// Store the time before reading switch
-				reqTime= xTaskGetTickCount();
-				// Check Switches
-				updateSwitches(SWITCHES);
+				if(events & SWITCH_CHANGE_EVENT){
+					// Time from the switch first moving
+					reqTime = switchChangeTick;
+					// Check Switches
+					updateSwitches(SWITCHES);
 
-				timeTaken = loadUpdater(reqTime, SWITCHES);
+					timeTaken = loadUpdater(reqTime, SWITCHES);
 
-				// Notify user of Response Time for this mode if more than 0 ms
-				// N.B. Does not show response time in VGA for maintenance
-				if(timeTaken != 0){
-					printf("Maintenance Mode Response Time: %u\n", timeTaken);
+					// Notify user of Response Time for this mode if more than 0 ms
+					// N.B. Does not show response time in VGA for maintenance
+					if(timeTaken != 0){
+						LOG_INFO(LOG_LOAD_MANAGER, "Maintenance Mode Response Time: %u\n", timeTaken);
+						LOG_EVENT(eventlogEVENT_MAINTENANCE_TIME, eventlogNO_LOAD, timeTaken);
+					}
 				}
 
 				// Go back to Normal Mode on Button press
 				if (!maintainenceModeEn){
 
-					loadManagerState = NORMAL;
-					printf("\n\n############ NORMAL MODE ########!\n\n");
+					setLoadManagerState(NORMAL);
+					LOG_INFO(LOG_LOAD_MANAGER, "\n\n############ NORMAL MODE ########!\n\n");
 				}
 
 				break;
 		}
-		// Delay for 10 ms (is 2 Times speed of ADC so should never miss an input)
-		vTaskDelay(10);
 	}
 }
 
@@ -1030,13 +1859,22 @@ void frequencyUpdaterTask(void *pvParameters){
 
 	uint8_t isFirstIteration = 1;
 
+	int timestamp;
+
 	struct freqRocQMsg freqRocMsg;
 	struct freqQMsg receiveIsrMsg;
 
+		// Highest priority application task, so the first one to run
+		bootTimeFirstTask = bootTimerRead();
+
 		while(1)
 		{
-			if(xQueueReceive(frequencyQ, &receiveIsrMsg, 0) == pdPASS){
+			// Sleeps until frequencyAnalyserISR has put a sample in the ring
+			ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+
+			if(frequencyRingGet(&receiveIsrMsg)){
 				freqValNew = receiveIsrMsg.frequency;
+				timestamp = receiveIsrMsg.timestamp;
 
 				if(isFirstIteration ){
 					isFirstIteration = 0;
@@ -1046,18 +1884,687 @@ void frequencyUpdaterTask(void *pvParameters){
 				}
 				roc = ((freqValNew - freqValOld) * 2) / ((1/freqValNew) + (1/freqValOld));
 				freqValOld = freqValNew;
+
 				freqRocMsg.freqData = freqValNew;
 				freqRocMsg.rocData = roc;
-				freqRocMsg.timestamp = receiveIsrMsg.timestamp;
-				xQueueSendToBack(freqRocDataQ, &freqRocMsg, 0);
+				freqRocMsg.timestamp = timestamp;
+				// Copied into the queue; dropped if the queue is full
+				if(xQueueSendToBack(freqRocDataQ, &freqRocMsg, 0) == pdPASS){
+#if (configUSE_TRACE_RECORDER == 1)
+					newSampleTime = bootTimerRead();
+#endif
+					xTaskNotify(loadManagerTaskHandle, NEW_SAMPLE_EVENT, eSetBits);
+				}
+
+			}
+		}
+}
+
+#if (configGENERATE_RUN_TIME_STATS == 1)
+/*
+ * Every RUN_TIME_STATS_PERIOD prints how long each task has run, as a share of
+ * the time since boot and of the last period
+ */
+void runTimeStatsTask(void *pvParameters){
+
+	static TaskStatus_t taskStatus[RUN_TIME_STATS_MAX_TASKS];
+	// Run time at the last report, indexed by xTaskNumber
+	static uint64_t previousRunTime[RUN_TIME_STATS_MAX_TASKS + 1];
+	uint64_t previousTotalRunTime = 0;
+	uint64_t totalRunTime;
+	uint64_t periodRunTime;
+	uint64_t taskPeriodRunTime;
+	UBaseType_t taskCount;
+	UBaseType_t i;
+
+	STACK_MONITOR_EXERCISE(STACK_PATH_PRINTF);
+
+	while(1)
+	{
+		vTaskDelay(RUN_TIME_STATS_PERIOD);
+
+		taskCount = uxTaskGetSystemState(taskStatus, RUN_TIME_STATS_MAX_TASKS, &totalRunTime);
+		if(taskCount == 0){
+			printf("Run time stats: more than %d tasks\n", RUN_TIME_STATS_MAX_TASKS);
+			continue;
+		}
+
+		periodRunTime = totalRunTime - previousTotalRunTime;
+		previousTotalRunTime = totalRunTime;
+
+		printf("\nTask      run time(ms)  %%boot  %%last %lus  stack free\n", (unsigned long)(RUN_TIME_STATS_PERIOD / configTICK_RATE_HZ));
+		for(i = 0; i < taskCount; i++){
+			taskPeriodRunTime = 0;
+			if(taskStatus[i].xTaskNumber <= RUN_TIME_STATS_MAX_TASKS){
+				taskPeriodRunTime = taskStatus[i].ulRunTimeCounter - previousRunTime[taskStatus[i].xTaskNumber];
+				previousRunTime[taskStatus[i].xTaskNumber] = taskStatus[i].ulRunTimeCounter;
+			}
+
+			printf("%-8s  %12lu  %5lu  %5lu  %10u\n", taskStatus[i].pcTaskName,
+					(unsigned long)(taskStatus[i].ulRunTimeCounter / RUN_TIME_CYCLES_PER_MS),
+					(unsigned long)((taskStatus[i].ulRunTimeCounter * 100) / totalRunTime),
+					(unsigned long)(periodRunTime ? (taskPeriodRunTime * 100) / periodRunTime : 0),
+					(unsigned)taskStatus[i].usStackHighWaterMark);
+		}
+		// Words never used, like the stack free column
+		printf("ISR stack: %lu of %d words free\n", (unsigned long)uxPortGetISRStackHighWaterMark(), configISR_STACK_SIZE);
+	}
+}
+#endif
+
+#if (configUSE_TRACE_RECORDER == 1)
+/*
+ * Prints the kernel trace when loadManagerTask wakes late or a snapshot is
+ * requested on the command channel, then starts recording again for the
+ * next one
+ */
+void traceDumpTask(void *pvParameters){
+
+	STACK_MONITOR_EXERCISE(STACK_PATH_PRINTF);
+
+	while(1)
+	{
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+		if(loadManagerOverrunUs != 0){
+			printf("\nloadManagerTask took %luus to wake for a sample, trace follows\n", (unsigned long)loadManagerOverrunUs);
+		}else{
+			printf("\nTrace snapshot requested, trace follows\n");
+		}
+		vTraceDump(printf);
+
+		vTraceClear();
+		loadManagerOverrunUs = 0;
+		traceSnapshotRequested = 0;
+		vTraceStart();
+	}
+}
+#endif
+
+#if (configUSE_PROFILER == 1)
+/*
+ * Prints the samples taken since the last profile request and starts counting
+ * again. Sampling is held while the dump is printed, so the dump is
+ * consistent and its own printf is not profiled
+ */
+void profileDumpTask(void *pvParameters){
+
+	STACK_MONITOR_EXERCISE(STACK_PATH_PRINTF);
+
+	while(1)
+	{
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+		vProfilerStop();
+		printf("\nProfile requested, samples follow\n");
+		vProfilerDump(printf);
+
+		vProfilerClear();
+		profileDumpRequested = 0;
+		vProfilerStart();
+	}
+}
+#endif
+
+#if (STACK_MONITOR == 1)
+/*
+ * Every STACK_MONITOR_PERIOD samples the high water mark of every stack and
+ * prints the least headroom seen and a recommended size for each
+ */
+void stackMonitorTask(void *pvParameters){
+
+	struct stackMonitorEntry *entry;
+	UBaseType_t freeWords;
+	UBaseType_t usedWords;
+	UBaseType_t recommended;
+	unsigned long totalSize;
+	unsigned long totalRecommended;
+	UBaseType_t i;
+
+	STACK_MONITOR_EXERCISE(STACK_PATH_PRINTF);
+
+	while(1)
+	{
+		vTaskDelay(STACK_MONITOR_PERIOD);
 
+		totalSize = 0;
+		totalRecommended = 0;
+
+		printf("\nStack                   size  min free  recommended (words%s)\n", (STACK_MONITOR_TEST == 1) ? ", test mode" : "");
+		for(i = 0; i < STACK_MONITOR_ENTRIES; i++){
+			entry = &stackMonitorEntries[i];
+
+			if(entry->handle == NULL){
+				freeWords = uxPortGetISRStackHighWaterMark();
+			}else{
+				freeWords = uxTaskGetStackHighWaterMark(entry->handle);
+			}
+			if(freeWords < entry->minFree){
+				entry->minFree = freeWords;
+			}
+
+			usedWords = entry->size - entry->minFree;
+			recommended = usedWords + (usedWords * STACK_MONITOR_MARGIN_PERCENT) / 100;
+			recommended = ((recommended + STACK_MONITOR_ROUND_WORDS - 1) / STACK_MONITOR_ROUND_WORDS) * STACK_MONITOR_ROUND_WORDS;
+			if(recommended == 0){
+				recommended = STACK_MONITOR_ROUND_WORDS;
+			}
+
+			totalSize += entry->size;
+			totalRecommended += recommended;
+
+			printf("%-20s  %6lu  %8lu  %11lu%s\n", entry->name, (unsigned long)entry->size,
+					(unsigned long)entry->minFree, (unsigned long)recommended,
+					(entry->minFree == 0) ? "  FULL" : "");
+		}
+		printf("Total                 %6lu            %11lu (%ld bytes to reclaim)\n", totalSize, totalRecommended,
+				((long)totalSize - (long)totalRecommended) * (long)sizeof(StackType_t));
+	}
+}
+#endif
+
+
+#if LOG_DRAIN_TASK
+/*
+ * Prints what has been logged with LOG() and sends the LOG_EVENT() records,
+ * oldest first. Sleeps once both rings are empty until the next record is
+ * written into either
+ */
+void logDrainTask(void *pvParameters){
+
+#if (configUSE_LOGGER == 1)
+	LogRecord_t record;
+	uint32_t dropped;
+	uint32_t droppedReported = 0;
+#endif
+#if (configUSE_EVENT_LOG == 1)
+	EventLogRecord_t event;
+	uint8_t eventBytes[eventlogRECORD_SIZE];
+	// Raw records on the serial UART, or hex lines on the console if NULL
+	FILE *eventUart = NULL;
+#endif
+
+	STACK_MONITOR_EXERCISE(STACK_PATH_PRINTF);
+
+#if (configUSE_EVENT_LOG == 1)
+#if (EVENT_LOG_SERIAL == 1)
+	eventUart = fopen(UART_NAME, "w");
+	if(eventUart == NULL){
+		printf("Can't open %s, sending events to the console\n", UART_NAME);
+	}
+#endif
+	if(eventUart != NULL){
+		vEventLogEncodeHeader(eventBytes);
+		fwrite(eventBytes, 1, eventlogHEADER_SIZE, eventUart);
+	}else{
+		vEventLogPrintHeader(printf);
+	}
+#endif
+
+	while(1)
+	{
+#if (configUSE_LOGGER == 1)
+		// Anything logged before the scheduler started is printed first
+		while(xLogRead(&record)){
+			vLogPrintRecord(&record, printf);
+		}
+
+		// The ring filled while the UART was busy
+		dropped = ulLogGetDropped();
+		if(dropped != droppedReported){
+			printf("Log: %lu messages dropped\n", (unsigned long)(dropped - droppedReported));
+			droppedReported = dropped;
+		}
+#endif
+
+#if (configUSE_EVENT_LOG == 1)
+		while(xEventLogRead(&event)){
+			if(eventUart != NULL){
+				vEventLogEncode(&event, eventBytes);
+				fwrite(eventBytes, 1, eventlogRECORD_SIZE, eventUart);
+			}else{
+				vEventLogPrintRecord(&event, printf);
 			}
-			// To run at same speed as inputs are received
-			// Task execution takes under 1 tick so same rate should be fine.
-			vTaskDelay(20);
 		}
+		if(eventUart != NULL){
+			fflush(eventUart);
+		}
+#endif
+
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+	}
+}
+#endif
+
+#if (configUSE_TELEMETRY == 1)
+/*
+ * Moves queued telemetry frames into the serial UART driver's transmit
+ * buffer. While the driver is full it retries every tick, otherwise it sleeps
+ * until the next frame or heartbeat
+ * */
+void telemetryTask(void *pvParameters){
+
+	TickType_t now;
+	TickType_t lastHeartbeat;
+
+	STACK_MONITOR_EXERCISE(STACK_PATH_PRINTF);
+
+	// Writes return EWOULDBLOCK instead of waiting for the transmit buffer
+	telemetryUart = open(UART_NAME, O_WRONLY | O_NONBLOCK);
+	if(telemetryUart < 0){
+		printf("Can't open %s, telemetry is discarded\n", UART_NAME);
+	}
+
+	lastHeartbeat = xTaskGetTickCount();
+	while(1)
+	{
+		now = xTaskGetTickCount();
+		if((now - lastHeartbeat) >= TELEMETRY_HEARTBEAT_PERIOD){
+			xTelemetrySendHeartbeat();
+			lastHeartbeat = now;
+		}
+
+		if(xTelemetryDrain(telemetryUartWrite) != 0){
+			// The driver's buffer is full. 1 tick is ~11 bytes at 115200 baud
+			vTaskDelay(1);
+		}else{
+			ulTaskNotifyTake(pdTRUE, TELEMETRY_HEARTBEAT_PERIOD - (now - lastHeartbeat));
+		}
+	}
 }
 
+/*
+ * Non-blocking write for xTelemetryDrain(). Returns the bytes the UART
+ * driver took, 0 if its transmit buffer is full. Without a UART everything
+ * is taken and discarded so the ring does not fill
+ * */
+size_t telemetryUartWrite(const uint8_t *data, size_t length){
+	int written;
+
+	if(telemetryUart < 0){
+		return length;
+	}
+
+	written = write(telemetryUart, data, length);
+	if(written < 0){
+		// EWOULDBLOCK when full. Other errors drop the chunk
+		return (errno == EWOULDBLOCK) ? 0 : length;
+	}
+	return (size_t)written;
+}
+#endif
+
+#if (configUSE_COMMAND_CHANNEL == 1)
+/*
+ * Reads requests from the serial UART without blocking and answers each one
+ * in the telemetry stream. Polls every COMMAND_POLL_PERIOD while requests are
+ * arriving and every COMMAND_IDLE_POLL_PERIOD otherwise
+ * */
+void commandTask(void *pvParameters){
+
+	uint8_t received[64];
+	int count, i;
+	Command_t command;
+	TickType_t lastReceived;
+
+	STACK_MONITOR_EXERCISE(STACK_PATH_PRINTF);
+
+	vCommandParserInit(&commandParser);
+
+	// Reads return EWOULDBLOCK instead of waiting for a byte. telemetryTask
+	// has its own write only descriptor on the same UART
+	commandUart = open(UART_NAME, O_RDONLY | O_NONBLOCK);
+	if(commandUart < 0){
+		printf("Can't open %s, commands are disabled\n", UART_NAME);
+		vTaskSuspend(NULL);
+	}
+
+	lastReceived = xTaskGetTickCount() - COMMAND_ACTIVE_TIME;
+	while(1)
+	{
+		count = read(commandUart, received, sizeof(received));
+		if(count > 0){
+			lastReceived = xTaskGetTickCount();
+			for(i = 0; i < count; i++){
+				if(xCommandParserFeed(&commandParser, received[i], &command)){
+					handleCommand(&command);
+				}
+			}
+			// The buffer may hold more
+			continue;
+		}
+
+		if((xTaskGetTickCount() - lastReceived) < COMMAND_ACTIVE_TIME){
+			vTaskDelay(COMMAND_POLL_PERIOD);
+		}else{
+			vTaskDelay(COMMAND_IDLE_POLL_PERIOD);
+		}
+	}
+}
+
+/*
+ * Carries out a request and sends its response
+ * */
+void handleCommand(const Command_t *command){
+	uint8_t result[commandMAX_RESULT];
+	size_t length = 0;
+	uint8_t status;
+
+	switch(command->ucCommand){
+		case commandCOMMAND_PING:
+			memcpy(result, command->pucArguments, command->xLength);
+			length = command->xLength;
+			status = commandSTATUS_OK;
+			break;
+		case commandCOMMAND_GET_THRESHOLDS:
+		case commandCOMMAND_SET_THRESHOLDS:
+			status = commandThresholds(command, result, &length);
+			break;
+		case commandCOMMAND_GET_STATS:
+			status = (command->xLength == 0) ? commandStats(result, &length) : commandSTATUS_BAD_LENGTH;
+			break;
+		case commandCOMMAND_GET_HISTORY:
+			status = commandHistory(command, result, &length);
+			break;
+		case commandCOMMAND_SET_MAINTENANCE:
+			status = commandMaintenance(command, result, &length);
+			break;
+		case commandCOMMAND_SNAPSHOT:
+			status = (command->xLength == 0) ? commandSnapshot() : commandSTATUS_BAD_LENGTH;
+			break;
+		case commandCOMMAND_PROFILE:
+			status = (command->xLength == 0) ? commandProfile() : commandSTATUS_BAD_LENGTH;
+			break;
+		default:
+			status = commandSTATUS_UNKNOWN;
+			break;
+	}
+
+	if(status != commandSTATUS_OK){
+		length = 0;
+	}
+	// If the telemetry ring is full the client times out and asks again
+	xCommandRespond(command, status, result, length);
+}
+
+/*
+ * Reads or sets both thresholds. loadManagerTask takes thresholdSemaphore
+ * without waiting and reads the thresholds whether it got it or not, so the
+ * mutex would not keep it from seeing half an update. Both are written in one
+ * critical section instead, and the mutex is not taken here: a give by
+ * loadManagerTask while this task held it would release it from under us
+ * */
+uint8_t commandThresholds(const Command_t *command, uint8_t *result, size_t *length){
+	uint16_t newFrequency = 0, newRoc = 0;
+
+	if(command->ucCommand == commandCOMMAND_SET_THRESHOLDS){
+		if(command->xLength != 4){
+			return commandSTATUS_BAD_LENGTH;
+		}
+		newFrequency = command->pucArguments[0] | (command->pucArguments[1] << 8);
+		newRoc = command->pucArguments[2] | (command->pucArguments[3] << 8);
+		if(newFrequency > COMMAND_MAX_FREQUENCY_THRESHOLD || newRoc > COMMAND_MAX_ROC_THRESHOLD){
+			return commandSTATUS_BAD_VALUE;
+		}
+	}else if(command->xLength != 0){
+		return commandSTATUS_BAD_LENGTH;
+	}
+
+	taskENTER_CRITICAL();
+	if(command->ucCommand == commandCOMMAND_SET_THRESHOLDS){
+		frequencyThreshold = (float)newFrequency / 10;
+		rocThreshold = newRoc;
+	}
+	newFrequency = (uint16_t)(frequencyThreshold * 10 + 0.5f);
+	newRoc = (uint16_t)rocThreshold;
+	taskEXIT_CRITICAL();
+
+	if(command->ucCommand == commandCOMMAND_SET_THRESHOLDS){
+		LOG_EVENT(eventlogEVENT_THRESHOLDS, eventlogNO_LOAD, ((uint32_t)newFrequency << 16) | newRoc);
+		LOG_INFO(LOG_COMMAND, "New thresholds by command: %u (0.1 Hz) %u (0.1 Hz/Sec)\n", newFrequency, newRoc);
+		STORE_THRESHOLDS();
+	}
+
+	commandPut(&result[0], newFrequency, 2);
+	commandPut(&result[2], newRoc, 2);
+	*length = 4;
+	return commandSTATUS_OK;
+}
+
+/*
+ * Copies the load manager's state and the reaction time statistics. The
+ * scheduler is suspended so they all come from between two of its passes
+ * */
+uint8_t commandStats(uint8_t *result, size_t *length){
+	int held, reaction, i;
+
+	vTaskSuspendAll();
+	result[commandSTATS_STATE] = loadManagerState;
+	result[commandSTATS_LOADS] = loadStatus;
+	result[commandSTATS_MAINTENANCE] = maintainenceModeEn;
+	held = heldEntries(reactionTimeIndex, reactionTimeShifts, 5);
+	result[commandSTATS_REACTIONS_HELD] = held;
+	commandPut(&result[commandSTATS_REACTION_COUNT], reactionCount, 4);
+	commandPut(&result[commandSTATS_REACTION_MIN], (reactionCount != 0) ? minReactionTime : 0, 4);
+	commandPut(&result[commandSTATS_REACTION_MAX], maxReactionTime, 4);
+	commandPut(&result[commandSTATS_REACTION_AVERAGE], reactionTimeAverage(), 4);
+	// Newest first
+	for(i = 0; i < 5; i++){
+		reaction = (i < held) ? reactionTimes[newestFirst(i, reactionTimeIndex, reactionTimeShifts, 5)] : 0;
+		commandPut(&result[commandSTATS_REACTIONS + 2 * i], (reaction > UINT16_MAX) ? UINT16_MAX : reaction, 2);
+	}
+	xTaskResumeAll();
+
+	commandPut(&result[commandSTATS_TELEMETRY_DROPPED], ulTelemetryGetDropped(), 4);
+	commandPut(&result[commandSTATS_REJECTED], commandParser.ulRejected, 4);
+	commandPut(&result[commandSTATS_UPTIME], xTaskGetTickCount(), 4);
+	*length = commandSTATS_SIZE;
+	return commandSTATUS_OK;
+}
+
+/*
+ * Copies up to commandHISTORY_MAX_SAMPLES of the running data, newest first,
+ * after skipping the number of samples asked for
+ * */
+uint8_t commandHistory(const Command_t *command, uint8_t *result, size_t *length){
+	int skip, held, count, slot, i;
+
+	if(command->xLength != 1){
+		return commandSTATUS_BAD_LENGTH;
+	}
+	skip = command->pucArguments[0];
+
+	// loadManagerTask adds to the running data
+	vTaskSuspendAll();
+	held = heldEntries(runningDataIndex, runningDataShifts, 50);
+	count = held - skip;
+	if(count < 0){
+		count = 0;
+	}else if(count > commandHISTORY_MAX_SAMPLES){
+		count = commandHISTORY_MAX_SAMPLES;
+	}
+	result[0] = held;
+	for(i = 0; i < count; i++){
+		slot = newestFirst(skip + i, runningDataIndex, runningDataShifts, 50);
+		commandPut(&result[commandHISTORY_HEADER + commandHISTORY_SAMPLE_SIZE * i], toEventLogFixedPoint(frequencyData[slot], 0, UINT16_MAX), 2);
+		commandPut(&result[commandHISTORY_HEADER + commandHISTORY_SAMPLE_SIZE * i + 2], toEventLogFixedPoint(rocData[slot], INT16_MIN, INT16_MAX), 2);
+	}
+	xTaskResumeAll();
+
+	result[1] = skip;
+	result[2] = count;
+	*length = commandHISTORY_HEADER + commandHISTORY_SAMPLE_SIZE * count;
+	return commandSTATUS_OK;
+}
+
+/*
+ * Switches maintenance mode as the button does. loadManagerTask changes state
+ * on its next pass, and only enters maintenance with every switch on
+ * */
+uint8_t commandMaintenance(const Command_t *command, uint8_t *result, size_t *length){
+	uint8_t mode;
+
+	if(command->xLength != 1){
+		return commandSTATUS_BAD_LENGTH;
+	}
+	mode = command->pucArguments[0];
+	if(mode > commandMAINTENANCE_TOGGLE){
+		return commandSTATUS_BAD_VALUE;
+	}
+
+	// buttonISR also toggles the flag
+	taskENTER_CRITICAL();
+	if(mode == commandMAINTENANCE_TOGGLE){
+		maintainenceModeEn = !maintainenceModeEn;
+	}else{
+		maintainenceModeEn = mode;
+	}
+	result[0] = maintainenceModeEn;
+	taskEXIT_CRITICAL();
+
+	xTaskNotify(loadManagerTaskHandle, MAINTENANCE_TOGGLE_EVENT, eSetBits);
+	LOG_INFO(LOG_COMMAND, "Maintenance mode set to %u by command\n", result[0]);
+
+	result[1] = loadManagerState;
+	*length = 2;
+	return commandSTATUS_OK;
+}
+
+/*
+ * Freezes the kernel trace and has traceDumpTask print it. BUSY while a dump
+ * is still being printed
+ * */
+uint8_t commandSnapshot(void){
+#if (configUSE_TRACE_RECORDER == 1)
+	uint8_t status = commandSTATUS_BUSY;
+
+	// loadManagerTask freezes the ring itself when it wakes late
+	vTaskSuspendAll();
+	if(loadManagerOverrunUs == 0 && !traceSnapshotRequested){
+		traceSnapshotRequested = 1;
+		vTraceStop();
+		status = commandSTATUS_OK;
+	}
+	xTaskResumeAll();
+
+	if(status == commandSTATUS_OK){
+		xTaskNotifyGive(traceDumpTaskHandle);
+	}
+	return status;
+#else
+	return commandSTATUS_UNSUPPORTED;
+#endif
+}
+
+/*
+ * Has profileDumpTask print the profile. BUSY while a dump is still being
+ * printed
+ * */
+uint8_t commandProfile(void){
+#if (configUSE_PROFILER == 1)
+	uint8_t status = commandSTATUS_BUSY;
+
+	taskENTER_CRITICAL();
+	if(!profileDumpRequested){
+		profileDumpRequested = 1;
+		status = commandSTATUS_OK;
+	}
+	taskEXIT_CRITICAL();
+
+	if(status == commandSTATUS_OK){
+		xTaskNotifyGive(profileDumpTaskHandle);
+	}
+	return status;
+#else
+	return commandSTATUS_UNSUPPORTED;
+#endif
+}
+
+/*
+ * Stores value at buffer, least significant byte first
+ * */
+void commandPut(uint8_t *buffer, uint32_t value, uint8_t bytes){
+	uint8_t i;
+
+	for(i = 0; i < bytes; i++){
+		buffer[i] = (uint8_t)(value >> (8 * i));
+	}
+}
+#endif
+
+#if (configUSE_STORE == 1)
+/*
+ * Writes what the control tasks have stored to the flash every
+ * STORE_FLUSH_PERIOD, or once the batch of events is half full. The only task
+ * that reads or writes the flash after boot. An erase keeps it busy for
+ * hundreds of milliseconds, so it runs below everything else
+ * */
+void storeTask(void *pvParameters){
+
+	StoreCursor_t cursor;
+	StoreEvent_t event;
+	StoreStats_t stats;
+	unsigned long shed = 0;
+	unsigned long reconnected = 0;
+	uint32_t errorsReported = 0;
+
+	STACK_MONITOR_EXERCISE(STACK_PATH_PRINTF);
+
+	if(storeFlashDevice == NULL){
+		vTaskSuspend(NULL);
+	}
+
+	// The history kept by earlier boots. This boot's events are still in RAM
+	vStoreCursorInit(&cursor);
+	while(xStoreReadEvent(&cursor, &event)){
+		if(event.ucType == eventlogEVENT_SHED){
+			shed++;
+		}else if(event.ucType == eventlogEVENT_RECONNECT){
+			reconnected++;
+		}
+	}
+
+	vStoreGetStats(&stats);
+	printf("Store: boot %u, %lu values from %lu bytes, %lu sheds and %lu reconnects kept, blocks erased %lu to %lu times\n",
+			(unsigned)storeBootCount, (unsigned long)stats.ulRecoveredValues, (unsigned long)stats.ulRecoveryBytesRead,
+			shed, reconnected, (unsigned long)stats.ulMinErases, (unsigned long)stats.ulMaxErases);
+
+	while(1)
+	{
+		ulTaskNotifyTake(pdTRUE, STORE_FLUSH_PERIOD);
+
+		storeSnapshot();
+
+		// What did not get written is kept or dropped by the store, so a
+		// failure is only reported
+		if(xStoreFlush() != pdPASS){
+			vStoreGetStats(&stats);
+			printf("Store: %lu flash errors\n", (unsigned long)(stats.ulFlashErrors - errorsReported));
+			errorsReported = stats.ulFlashErrors;
+		}
+	}
+}
+
+/*
+ * StoreFlash_t functions on the HAL CFI flash driver. Offsets are from the
+ * start of the flash. Programs with alt_write_flash_block(), which does not
+ * erase first as alt_write_flash() would
+ * */
+BaseType_t storeFlashRead(void *context, uint32_t offset, void *buffer, size_t length){
+	return (alt_read_flash((alt_flash_fd *)context, offset, buffer, length) == 0) ? pdPASS : pdFAIL;
+}
+
+BaseType_t storeFlashProgram(void *context, uint32_t offset, const void *data, size_t length){
+	uint32_t blockOffset = offset - ((offset - storeFlash.ulBase) % storeFlash.ulBlockSize);
+
+	return (alt_write_flash_block((alt_flash_fd *)context, blockOffset, offset, data, length) == 0) ? pdPASS : pdFAIL;
+}
+
+BaseType_t storeFlashErase(void *context, uint32_t offset){
+	return (alt_erase_flash_block((alt_flash_fd *)context, offset, storeFlash.ulBlockSize) == 0) ? pdPASS : pdFAIL;
+}
+#endif
+
 
 /*##################################################################
 ############################### HELPER FUNCTIONS ###################
@@ -1078,7 +2585,8 @@ int loadUpdater(int reqTime, uint8_t SWITCHES[]){
 		// If switch value has changed update loadStatus
 		if(SWITCHES[i] != (loadStatus & loads[i])>>i){
 
-			printf("Load ID: %d\n isTurnON: %d\n", loads[i], SWITCHES[i]);
+			LOG_DEBUG(LOG_LOAD_MANAGER, "Load ID: %d\n isTurnON: %d\n", loads[i], SWITCHES[i]);
+			LOG_EVENT(eventlogEVENT_LOAD_SWITCH, i, SWITCHES[i]);
 
 			if (SWITCHES[i]){
 				//Set the bit corresponding to load
@@ -1101,6 +2609,221 @@ int loadUpdater(int reqTime, uint8_t SWITCHES[]){
 	return timeTaken;
 }
 
+/*
+ * Moves the load manager to newState and records the change
+ * */
+void setLoadManagerState(uint8_t newState){
+	uint8_t oldState = loadManagerState;
+
+	loadManagerState = newState;
+	LOG_EVENT(eventlogEVENT_STATE, eventlogNO_LOAD, oldState);
+	TELEMETRY_STATE(newState, oldState);
+	(void)oldState;
+}
+
+/*
+ * Records when loadManagerTask first judged a sample or a stability window,
+ * the end of boot as far as the grid is concerned
+ * */
+void noteFirstDecision(void){
+	if(bootTimeFirstDecision != 0){
+		return;
+	}
+	bootTimeFirstDecision = bootTimerRead();
+	LOG_INFO(LOG_BOOT, "Boot: first decision at %uus, loads 0x%x, state %u\n",
+			(unsigned)(bootTimeFirstDecision / BOOT_TIMER_CYCLES_PER_US), (unsigned)loadStatus, (unsigned)loadManagerState);
+}
+
+#if (configUSE_EVENT_LOG == 1) || (configUSE_TELEMETRY == 1) || (configUSE_STORE == 1)
+/*
+ * Scales value to hundredths for the event log, telemetry and the snapshot,
+ * saturating at min and max
+ * */
+int32_t toEventLogFixedPoint(float value, int32_t min, int32_t max){
+	float scaled = value * eventlogFIXED_POINT_SCALE;
+
+	// Also catches NaN
+	if(!(scaled > min)){
+		return min;
+	}
+	if(scaled >= max){
+		return max;
+	}
+	return (int32_t)scaled;
+}
+#endif
+
+#if (configUSE_EVENT_LOG == 1)
+/*
+ * Records an event with the load manager's state, the loads connected and
+ * the latest Frequency/RoC record. Never blocks
+ * */
+void logEvent(uint8_t event, uint8_t load, uint32_t value){
+	EventLogRecord_t record;
+
+	record.ulTimeUs = 0;
+	record.ucEvent = event;
+	record.ucState = loadManagerState;
+	record.ucLoads = loadStatus;
+	record.ucLoad = load;
+	record.usFrequency = (uint16_t)toEventLogFixedPoint(latestFreqRocMsg.freqData, 0, UINT16_MAX);
+	record.sRoc = (int16_t)toEventLogFixedPoint(latestFreqRocMsg.rocData, INT16_MIN, INT16_MAX);
+	record.ulValue = value;
+
+	vEventLogWrite(&record);
+}
+#endif
+
+#if (configUSE_STORE == 1)
+/*
+ * Stores the thresholds, to be written at the next flush if they changed.
+ * Called by whichever task just changed them
+ * */
+void storeThresholds(void){
+	struct storedThresholds thresholds;
+
+	memset(&thresholds, 0, sizeof(thresholds));
+	thresholds.frequency = (uint16_t)(frequencyThreshold * 10 + 0.5f);
+	thresholds.roc = (uint16_t)rocThreshold;
+	xStoreSetValue(STORE_KEY_THRESHOLDS, &thresholds, sizeof(thresholds));
+}
+
+/*
+ * Stores the reaction time statistics. Only copies them into RAM
+ * */
+void storeReactionStats(void){
+	struct storedReactionStats stats;
+	int i;
+
+	memset(&stats, 0, sizeof(stats));
+	stats.count = reactionCount;
+	stats.min = minReactionTime;
+	stats.max = maxReactionTime;
+	// Newest first
+	stats.held = heldEntries(reactionTimeIndex, reactionTimeShifts, 5);
+	for(i = 0; i < stats.held; i++){
+		stats.times[i] = (uint16_t)reactionTimes[newestFirst(i, reactionTimeIndex, reactionTimeShifts, 5)];
+	}
+	xStoreSetValue(STORE_KEY_REACTION_STATS, &stats, sizeof(stats));
+}
+
+/*
+ * Adds a load shed or reconnected to the history kept in flash. Never
+ * blocks; if the batch is full the event is dropped and counted
+ * */
+void storeEvent(uint8_t event, uint8_t load){
+	uint8_t data[STORE_EVENT_SIZE];
+	TickType_t now = xTaskGetTickCount();
+
+	data[0] = (uint8_t)storeBootCount;
+	data[1] = (uint8_t)(storeBootCount >> 8);
+	data[2] = (uint8_t)now;
+	data[3] = (uint8_t)(now >> 8);
+	data[4] = (uint8_t)(now >> 16);
+	data[5] = (uint8_t)(now >> 24);
+	data[6] = load;
+	data[7] = loadStatus;
+	xStoreAppendEvent(event, data, sizeof(data));
+
+	// Write it and a new snapshot at once, rather than at the next period
+	xTaskNotifyGive(storeTaskHandle);
+}
+
+/*
+ * Copies the load manager's state into the snapshot. Called by storeTask,
+ * which loadManagerTask and frequencyUpdaterTask can preempt, so the
+ * scheduler is suspended while copying and the snapshot all comes from
+ * between two of the load manager's passes
+ * */
+void storeSnapshot(void){
+	struct storedSnapshot snapshot;
+	int held, slot, i;
+
+	memset(&snapshot, 0, sizeof(snapshot));
+	vTaskSuspendAll();
+	snapshot.state = loadManagerState;
+	snapshot.loads = loadStatus;
+	snapshot.wasStable = wasStable;
+	snapshot.maintenance = maintainenceModeEn;
+	snapshot.timerRemaining = (uint16_t)xTickTimerGetRemaining(&stabilityTimer);
+	held = heldEntries(runningDataIndex, runningDataShifts, 50);
+	snapshot.samples = (held < STORE_SNAPSHOT_SAMPLES) ? held : STORE_SNAPSHOT_SAMPLES;
+	for(i = 0; i < snapshot.samples; i++){
+		slot = newestFirst(i, runningDataIndex, runningDataShifts, 50);
+		snapshot.frequency[i] = (uint16_t)toEventLogFixedPoint(frequencyData[slot], 0, UINT16_MAX);
+		snapshot.roc[i] = (int16_t)toEventLogFixedPoint(rocData[slot], INT16_MIN, INT16_MAX);
+	}
+	xTaskResumeAll();
+
+	xStoreSetValue(STORE_KEY_SNAPSHOT, &snapshot, sizeof(snapshot));
+}
+#endif
+
+/*
+ * Receives the next Frequency/RoC record from the frequency updater
+ * Copies it into freqRocMsg
+ * Returns 1 if a record was received 0 if not
+ * */
+uint8_t receiveFreqRocMsg(struct freqRocQMsg *freqRocMsg){
+	if(xQueueReceive(freqRocDataQ, freqRocMsg, 0) != pdPASS){
+		return 0;
+	}
+
+	latestFreqRocMsg = *freqRocMsg;
+	TELEMETRY_SAMPLE(*freqRocMsg);
+#if (EVENT_LOG_SAMPLES == 1)
+	LOG_EVENT(eventlogEVENT_SAMPLE, eventlogNO_LOAD, freqRocMsg->timestamp);
+#endif
+
+	return 1;
+}
+
+/*
+ * Single producer, single consumer rings between the ISRs and their tasks.
+ * Put is only called from the ISR and Get only from the task, so each index
+ * has one writer and no critical section is needed. Return 0 if the ring is
+ * full or empty.
+ * */
+uint8_t ps2KeyRingPut(unsigned char key){
+	unsigned int next = (ps2KeyRingHead + 1) % PS2_KEY_RING_LENGTH;
+
+	if(next == ps2KeyRingTail){
+		return 0;
+	}
+	ps2KeyRing[ps2KeyRingHead] = key;
+	ps2KeyRingHead = next;
+	return 1;
+}
+
+uint8_t ps2KeyRingGet(unsigned char *key){
+	if(ps2KeyRingTail == ps2KeyRingHead){
+		return 0;
+	}
+	*key = ps2KeyRing[ps2KeyRingTail];
+	ps2KeyRingTail = (ps2KeyRingTail + 1) % PS2_KEY_RING_LENGTH;
+	return 1;
+}
+
+uint8_t frequencyRingPut(const struct freqQMsg *msg){
+	unsigned int next = (frequencyRingHead + 1) % FREQUENCY_RING_LENGTH;
+
+	if(next == frequencyRingTail){
+		return 0;
+	}
+	frequencyRing[frequencyRingHead] = *msg;
+	frequencyRingHead = next;
+	return 1;
+}
+
+uint8_t frequencyRingGet(struct freqQMsg *msg){
+	if(frequencyRingTail == frequencyRingHead){
+		return 0;
+	}
+	*msg = frequencyRing[frequencyRingTail];
+	frequencyRingTail = (frequencyRingTail + 1) % FREQUENCY_RING_LENGTH;
+	return 1;
+}
+
 /*
  * Reads and stores switch value
  * */
@@ -1115,43 +2838,110 @@ void updateSwitches(uint8_t SWITCHES[]){
 }
 
 /*
- * Restarts FreeRTOS timer and clears global Timer expiry Flag
+ * Restarts the stability timer and clears global Timer expiry Flag
  * */
-void restartFreeRTOSTimer(){
-	if (xTimerIsTimerActive(timer500ms) == pdTRUE){
+void restartStabilityTimer(){
+	stopStabilityTimer();
+	vTickTimerStart(&stabilityTimer, TIMER_PERIOD);
+}
 
-		while (xTimerStop(timer500ms, 0) ==  pdFAIL){
-			// Restart Timer
-			printf("Cannot stop timer\n\n");
+/*
+ * Stops the stability timer and clears global Timer expiry Flag, including an
+ * expiry that has been notified but not yet seen by waitForLoadManagerEvents()
+ * */
+void stopStabilityTimer(){
+	uint32_t events = 0;
 
-		}
+	vTickTimerStop(&stabilityTimer);
+
+	// Taking the notification clears the task's notified state, so keep the
+	// other events for waitForLoadManagerEvents()
+	if(xTaskNotifyWait(0, LOAD_MANAGER_EVENTS, &events, 0) == pdTRUE){
+		loadManagerEvents |= events;
 	}
+	loadManagerEvents &= ~STABILITY_TIMER_EXPIRED;
 
 	timerExpiryFlag = 0;
+}
+
+/*
+ * Sleeps until loadManagerTask has something to act on and returns the Load
+ * Manager Events that woke it. Does not sleep while records are still queued.
+ * Sets global Timer expiry Flag if the stability timer has expired
+ * */
+uint32_t waitForLoadManagerEvents(){
+	uint32_t events = 0;
+	TickType_t ticksToWait = portMAX_DELAY;
 
-	while (xTimerStart(timer500ms, 0) == pdFAIL){
-		printf("Cannot start timer\n\n");
+	if(loadManagerEvents != 0 || uxQueueMessagesWaiting(freqRocDataQ) != 0){
+		ticksToWait = 0;
 	}
 
+	if(xTaskNotifyWait(0, LOAD_MANAGER_EVENTS, &events, ticksToWait) == pdTRUE){
+		loadManagerEvents |= events;
+	}
+
+	events = loadManagerEvents;
+	loadManagerEvents = 0;
+
+	if(events & STABILITY_TIMER_EXPIRED){
+		timerExpiryFlag = 1;
+	}
+
+	return events;
 }
 
 /*
- * Stops FreeRTOS timer and clears global Timer expiry Flag
+ * The slide switches have no interrupt. Reads them every tick and wakes
+ * loadManagerTask once a new value has been steady for SWITCH_DEBOUNCE_TICKS
  * */
-void stopFreeRTOSTimer(){
-	if (xTimerIsTimerActive(timer500ms) == pdTRUE){
-
-		while (xTimerStop(timer500ms, 0) ==  pdFAIL){
-			// Restart Timer
-			printf("Cannot stop timer\n\n");
-
+void vApplicationTickHook(void){
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+	alt_u32 switchValue = IORD_ALTERA_AVALON_PIO_DATA(SLIDE_SWITCH_BASE) & ALLON;
+
+	if(switchValue != switchScanValue){
+		switchScanValue = switchValue;
+		switchScanStableTicks = 0;
+		switchScanChangeTick = xTaskGetTickCountFromISR();
+	}else if(switchScanStableTicks < SWITCH_DEBOUNCE_TICKS){
+		switchScanStableTicks++;
+
+		if(switchScanStableTicks == SWITCH_DEBOUNCE_TICKS && switchValue != switchReportedValue){
+			switchReportedValue = switchValue;
+			switchChangeTick = switchScanChangeTick;
+			xTaskNotifyFromISR(loadManagerTaskHandle, SWITCH_CHANGE_EVENT, eSetBits, &xHigherPriorityTaskWoken);
 		}
 	}
 
-	timerExpiryFlag = 0;
+	portEND_SWITCHING_ISR(xHigherPriorityTaskWoken);
+}
+
+#if (STACK_MONITOR_TEST == 1)
+/*
+ * Runs the deepest library calls a task makes (STACK_PATH_*) so its high
+ * water mark covers them before the task has taken those paths itself
+ * */
+void stackMonitorExercise(uint8_t paths){
+	FILE *testLcd;
+
+	if(paths & STACK_PATH_PRINTF){
+		printf("Stack test: printf %d %lu %s\n", -1, (unsigned long)xTaskGetTickCount(), "ok");
+	}
 
+	if(paths & STACK_PATH_PRINTF_FLOAT){
+		printf("Stack test: printf %.1f %f\n", frequencyThreshold, (float)rocThreshold/10);
+	}
 
+	if(paths & STACK_PATH_LCD){
+		testLcd = fopen(CHARACTER_LCD_NAME, "w");
+		if(testLcd != NULL){
+			fprintf(testLcd, "%c%s", ESC, CLEAR_LCD_STRING);
+			fprintf(testLcd, "STACK TEST %.1f\n", frequencyThreshold);
+			fclose(testLcd);
+		}
+	}
 }
+#endif
 
 /*
  * Checks Tripping Conditions
@@ -1215,12 +3005,15 @@ uint8_t shedLoad(uint8_t SWITCHES[]){
 		greenLed |= (1 << loadToShed);
 		// TURN ON GREEN LED
 		IOWR_ALTERA_AVALON_PIO_DATA(GREEN_LEDS_BASE, greenLed);
-		printf("Shed Load: %d\n", loadToShed);
+		LOG_INFO(LOG_LOAD_MANAGER, "Shed Load: %d\n", loadToShed);
+		LOG_EVENT(eventlogEVENT_SHED, loadToShed, 0);
+		STORE_EVENT(eventlogEVENT_SHED, loadToShed);
 
 		// Return success
 		return 1;
 	}else{
-		printf("\n ############ ATTEMPT TO DISCONNECT LOAD ERROR: ALL LOADS ARE ALREADY DISCONNECTED##### \n");
+		LOG_WARN(LOG_LOAD_MANAGER, "\n ############ ATTEMPT TO DISCONNECT LOAD ERROR: ALL LOADS ARE ALREADY DISCONNECTED##### \n");
+		LOG_EVENT(eventlogEVENT_SHED, eventlogNO_LOAD, 0);
 		return 0;
 	}
 }
@@ -1260,7 +3053,9 @@ uint8_t reconnectLoad(uint8_t SWITCHES[]){
 			// CLEAR GREEN LED BIT
 			greenLED &= ~(1UL << loadToReconnect) ;
 			IOWR_ALTERA_AVALON_PIO_DATA(GREEN_LEDS_BASE, greenLED);
-			printf("Reconnected Load: %d\n", loadToReconnect);
+			LOG_INFO(LOG_LOAD_MANAGER, "Reconnected Load: %d\n", loadToReconnect);
+			LOG_EVENT(eventlogEVENT_RECONNECT, loadToReconnect, 0);
+			STORE_EVENT(eventlogEVENT_RECONNECT, loadToReconnect);
 			// Return success
 			if (loadStatus == ALLON){
 				return 1;
@@ -1269,7 +3064,8 @@ uint8_t reconnectLoad(uint8_t SWITCHES[]){
 			}
 
 	}else{
-		printf("\n ############ ATTEMPT TO RECONNECT LOAD ERROR: ALL LOAD CONNECTED OR LOADS MANUALLY SWITCHED OFF##### \n");
+		LOG_WARN(LOG_LOAD_MANAGER, "\n ############ ATTEMPT TO RECONNECT LOAD ERROR: ALL LOAD CONNECTED OR LOADS MANUALLY SWITCHED OFF##### \n");
+		LOG_EVENT(eventlogEVENT_RECONNECT, eventlogNO_LOAD, 0);
 		return -1;
 	}
 }
@@ -1299,7 +3095,8 @@ void manualCheckAndSwitchOffLoads(uint8_t SWITCHES[]){
 				//TURN OFF RED LED
 				IOWR_ALTERA_AVALON_PIO_DATA(RED_LEDS_BASE, loadStatus);
 
-				printf("Manually Turned Off Load %d!\n",i);
+				LOG_INFO(LOG_LOAD_MANAGER, "Manually Turned Off Load %d!\n",i);
+				LOG_EVENT(eventlogEVENT_MANUAL_OFF, i, 1);
 
 			}else{
 
@@ -1309,7 +3106,8 @@ void manualCheckAndSwitchOffLoads(uint8_t SWITCHES[]){
 				greenLED &= ~(1UL << i) ;
 				IOWR_ALTERA_AVALON_PIO_DATA(GREEN_LEDS_BASE, greenLED);
 				// If Load is already Shed
-				printf("Load %d already turned off by Relay/Switch !\n",i);
+				LOG_DEBUG(LOG_LOAD_MANAGER, "Load %d already turned off by Relay/Switch !\n",i);
+				LOG_EVENT(eventlogEVENT_MANUAL_OFF, i, 0);
 
 			}
 		}
@@ -1326,6 +3124,7 @@ void computeReactionTimeStats(int currentTime,struct freqRocQMsg freqRocMsg){
 	// DONOT CHANGE TO UINT
 	int8_t i;
 	int reactionTimeLocal = currentTime -freqRocMsg.timestamp;
+	LOG_EVENT(eventlogEVENT_REACTION, eventlogNO_LOAD, reactionTimeLocal);
 	// Add the current reactiontime  if its already full take the first item out
 	if(reactionTimeIndex<4){
 		reactionTimes[reactionTimeIndex] = reactionTimeLocal;
@@ -1339,9 +3138,14 @@ void computeReactionTimeStats(int currentTime,struct freqRocQMsg freqRocMsg){
 		}
 		// Write new value to index 0
 		reactionTimes[0] = reactionTimeLocal;
+		if(reactionTimeShifts < 5){
+			reactionTimeShifts++;
+		}
 
 
 	}
+	reactionCount++;
+
 	int sum = 0;
 	// Compute average reaction time using for loop and dividing by 5
 	for (i=0;i<5;i++){
@@ -1361,6 +3165,8 @@ void computeReactionTimeStats(int currentTime,struct freqRocQMsg freqRocMsg){
 	if(reactionTimeLocal < minReactionTime){
 		minReactionTime = reactionTimeLocal;
 	}
+
+	STORE_REACTION_STATS();
 }
 
 /*
@@ -1388,120 +3194,46 @@ void updateRunningData(struct freqRocQMsg freqRocMsg){
 		// Write new value to index 0
 		frequencyData[0] = freqDataLocal;
 		rocData[0] = rocDataLocal;
+		if(runningDataShifts < 50){
+			runningDataShifts++;
+		}
 
 
 	}
 }
 
-/*##################################################################
-#################### TEST FUNCTIONS (Dev Use Only) #################
-####################################################################*/
-void testLoadSheddingAndReconnecting(){
-
-	uint8_t SWITCHES[5] = {1, 1, 1, 1, 1};
-
-	IOWR_ALTERA_AVALON_PIO_DATA(GREEN_LEDS_BASE, ALLOFF);
-	IOWR_ALTERA_AVALON_PIO_DATA(RED_LEDS_BASE, ALLON);
-
-	printf("LOAD STATUS %d\n",loadStatus);
-	shedLoad(SWITCHES);
-	printf("LOAD STATUS AFTER SHED:  %d\n",loadStatus);
-
-	shedLoad(SWITCHES);
-	usleep(1000000);
-	shedLoad(SWITCHES);
-	usleep(1000000);
-	shedLoad(SWITCHES);
-	usleep(100000);
-	shedLoad(SWITCHES);
-	usleep(100000);
-	printf("LOAD STATUS AFTER SHED:  %d\n",loadStatus);
-
-	reconnectLoad(SWITCHES);
-	usleep(1000000);
-	printf("LOAD STATUS AFTER CONNECT: %d\n",loadStatus);
-	reconnectLoad(SWITCHES);
-	usleep(1000000);
-	reconnectLoad(SWITCHES);
-	usleep(1000000);
-	reconnectLoad(SWITCHES);
-	usleep(1000000);
-	reconnectLoad(SWITCHES);
-	usleep(1000000);
-	printf("LOAD STATUS AFTER CONNECT: %d\n",loadStatus);
-
-}
-
-void testComputeReactionTimeStats(){
-	// Create Dummy Message
-	struct freqRocQMsg freqRocMsg;
-	// Assign a sample timestamp
-	freqRocMsg.timestamp = 5000;
-
-	computeReactionTimeStats(5005, freqRocMsg);
-	computeReactionTimeStats(5010, freqRocMsg);
-	computeReactionTimeStats(5007, freqRocMsg);
-	computeReactionTimeStats(5006, freqRocMsg);
-	computeReactionTimeStats(5002, freqRocMsg);
-	computeReactionTimeStats(5003, freqRocMsg);
-	// Avg is calculated from the latest 5 values
-	printf("Avg %d, Min %d, Max %d\n", avgReactionTime, minReactionTime, maxReactionTime);
+/*
+ * Number of entries held in an array filled as updateRunningData() and
+ * computeReactionTimeStats() fill theirs
+ * */
+int heldEntries(int index, int shifts, int size){
+	return (shifts == 0) ? index : size;
 }
 
-void testUpdateRunningData(){
-	struct freqRocQMsg freqRocMsg;
-	int i;
-
-	freqRocMsg.freqData = 50;
-	freqRocMsg.rocData = 7.0;
-
-	updateRunningData(freqRocMsg);
-	printf("ADD A VALUE\n");
-	printf("Roc Value:%f\n",rocData[0]);
-	printf("Freq Value:%f\n",frequencyData[0]);
-
-	freqRocMsg.freqData = 51;
-	freqRocMsg.rocData = 8.0;
-	updateRunningData(freqRocMsg);
-	printf("ADD A VALUE\n");
-
-	for (i=0;i<runningDataIndex;i++){
-			printf("Roc Value:%f\n",rocData[i]);
-			printf("Freq Value:%f\n",frequencyData[i]);
-	}
-
-	freqRocMsg.freqData = 52;
-	freqRocMsg.rocData = 9.0;
-	updateRunningData(freqRocMsg);
-	printf("ADD A VALUE\n");
-
-	for (i=0;i<runningDataIndex;i++){
-		printf("Roc Value:%f\n",rocData[i]);
-		printf("Freq Value:%f\n",frequencyData[i]);
+/*
+ * Index of the i-th newest entry held in such an array. They fill oldest
+ * first to one short of full, then each new entry is written at index 0 and
+ * the rest move along, so they only read newest first once size more have
+ * come in
+ * */
+int newestFirst(int i, int index, int shifts, int size){
+	if(i < shifts){
+		return i;
 	}
+	return heldEntries(index, shifts, size) - 1 - (i - shifts);
 }
 
-void testManualSwitchOffLoad1(){
-	// Can add delays with usleep to see changes
-	uint8_t SWITCHES[5] = {1, 1, 1, 1, 1};
-	usleep(3000000);
-	manualCheckAndSwitchOffLoads(SWITCHES);
-	usleep(3000000);
-	manualCheckAndSwitchOffLoads(SWITCHES);
-	usleep(3000000);
-	manualCheckAndSwitchOffLoads(SWITCHES);
-}
+/*
+ * Average of the reaction times held, 0 with none. avgReactionTime, shown on
+ * the VGA, divides by 5 however many are held
+ * */
+int reactionTimeAverage(void){
+	int held = heldEntries(reactionTimeIndex, reactionTimeShifts, 5);
+	int sum = 0;
+	int i;
 
-void testManualSwitchOffLoad2(){
-	// Can add delays with usleep to see changes
-	uint8_t SWITCHES[5] = {1,1,1,1,1};
-	shedLoad(SWITCHES);
-	shedLoad(SWITCHES);
-	manualCheckAndSwitchOffLoads(SWITCHES);
-	printf("Test Load Status after User: %d\n", loadStatus);
-	printf("Test Load Status before 2nd shedLoad : %d\n", loadStatus);
-	shedLoad(SWITCHES);
-	reconnectLoad(SWITCHES);
-	reconnectLoad(SWITCHES);
-	reconnectLoad(SWITCHES);
+	for(i = 0; i < held; i++){
+		sum += reactionTimes[i];
+	}
+	return (held != 0) ? sum / held : 0;
 }
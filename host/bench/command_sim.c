@@ -0,0 +1,736 @@
+/*
+ * Host simulation of the relay command channel (command.c): answers
+ * command_client's requests from a pseudo terminal as Relay.c's commandTask
+ * does, with the responses going out in the telemetry stream among the
+ * samples.
+ *
+ *   command_sim <command_client> [client options] command...
+ *
+ * The client is started on the slave side of a pseudo terminal, which stands
+ * in for the serial cable, and given its name with -d.  A task shaped like
+ * commandTask polls the master side without blocking, every 5 ticks while
+ * requests are arriving and every 50 otherwise, and feeds each byte to the
+ * parser.  Its handlers keep the result layouts of Relay.c's: the thresholds
+ * are read and set together in a critical section, the statistics and the
+ * newest first sample history are copied with the scheduler suspended, and
+ * maintenance mode is a flag.  A producer task adds a 50Hz sample to the
+ * history and the telemetry stream, and a trip with a reaction time every
+ * 2.5s.  The telemetry ring is drained through the same model of a 115200
+ * baud UART with a 64 byte transmit buffer as telemetry_sim's.
+ *
+ * The idle hook holds simulated time to the host's wall clock, so the
+ * client's round trip times, which are wall clock, include the wait for the
+ * next poll as they would on the board.  They leave out the time the request
+ * and response spend on the line, because the pseudo terminal delivers bytes
+ * as soon as the modelled UART takes them.  The simulation also times each
+ * request in simulated time, from the poll that completed it to the last
+ * byte of its response leaving the modelled UART.  Nothing here was measured
+ * on the board.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "telemetry.h"
+#include "command.h"
+
+#define simSAMPLE_TICKS			( ( TickType_t ) 20 )
+#define simTRIP_TICKS			( ( TickType_t ) 2500 )
+#define simHEARTBEAT_TICKS		( ( TickType_t ) 1000 )
+#define simPOLL_TICKS			( ( TickType_t ) 5 )
+#define simIDLE_POLL_TICKS		( ( TickType_t ) 50 )
+#define simACTIVE_TICKS			( ( TickType_t ) 1000 )
+
+/* Requests timed in simulated time. */
+#define simMAX_TIMED			100000
+
+/* The serial UART (UART_BAUD in system.h) and the HAL driver's transmit
+buffer (ALT_AVALON_UART_BUF_LEN). */
+#define simBAUD					115200ULL
+#define simUART_BUFFER			64ULL
+#define simCYCLES_PER_BYTE		( ( ( uint64_t ) TIMER1MS_FREQ * 10ULL ) / simBAUD )
+#define simCYCLES_PER_US		( ( uint64_t ) TIMER1MS_FREQ / 1000000ULL )
+
+/* Work charged for building and checking a sample in loadManagerTask, and
+for carrying out a request. */
+#define simSAMPLE_CYCLES		5000
+#define simREQUEST_CYCLES		2000
+
+/* As Relay.c keeps them. */
+#define simHISTORY				50
+#define simREACTIONS			5
+#define simMAX_FREQUENCY_THRESHOLD	999
+#define simMAX_ROC_THRESHOLD	999
+#define simNORMAL				0
+#define simLOAD_MANAGE			1
+#define simALL_LOADS			0x1FU
+
+#define simSTACK_DEPTH			( 256 )
+
+static StaticTask_t xProducerTaskBuffer, xCommandTaskBuffer, xDrainTaskBuffer, xIdleTaskBuffer, xTimerTaskBuffer;
+static StackType_t xProducerTaskStack[ simSTACK_DEPTH ], xCommandTaskStack[ simSTACK_DEPTH ], xDrainTaskStack[ simSTACK_DEPTH ], xIdleTaskStack[ simSTACK_DEPTH ], xTimerTaskStack[ simSTACK_DEPTH ];
+static TaskHandle_t xDrainTask;
+
+static int iMaster = -1;
+static pid_t xClient = -1;
+static int iClientStatus = 0;
+
+/* The simulated UART: the cycle its transmitter finishes what it holds, and
+the bytes it has taken. */
+static uint64_t ullLineFreeAt = 0, ullUartBytes = 0;
+
+/* The relay's settings and records. */
+static float fFrequencyThreshold = 30.0f;
+static int iRocThreshold = 300;
+static float fFrequencyData[ simHISTORY ], fRocData[ simHISTORY ];
+static int iHistoryHeld = 0;
+static int iReactionTimes[ simREACTIONS ];
+static unsigned uReactionsHeld = 0, uReactionCount = 0;
+static int iMinReaction = 1000000, iMaxReaction = 0, iAverageReaction = 0;
+static uint8_t ucState = simNORMAL, ucLoads = simALL_LOADS, ucMaintenance = 0;
+
+static CommandParser_t xParser;
+
+/* The response being timed: the telemetry byte count its frame ends at, and
+the cycle its request was complete. */
+static BaseType_t xTiming = pdFALSE;
+static uint32_t ulResponseEnd;
+static uint64_t ullRequestAt;
+static uint64_t ullServiceCycles[ simMAX_TIMED ];
+static uint32_t ulTimed = 0, ulUntimed = 0;
+
+/* Statistics responses whose average reaction time was not between the
+minimum and the maximum. */
+static uint32_t ulBadAverages = 0;
+static uint32_t ulPolls = 0, ulSamples = 0, ulCommands[ commandCOMMAND_SNAPSHOT + 1 ];
+
+static volatile BaseType_t xClientDone = pdFALSE;
+
+static uint64_t ullStartNs;
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNowNs( void )
+{
+struct timespec xNow;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPut( uint8_t *pucBuffer, uint32_t ulValue, size_t xBytes )
+{
+size_t x;
+
+	for( x = 0; x < xBytes; x++ )
+	{
+		pucBuffer[ x ] = ( uint8_t ) ( ulValue >> ( 8U * x ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * As write() on the UART opened with O_NONBLOCK: takes what fits in the
+ * transmit buffer and returns 0 rather than waiting when it is full.  Marks
+ * when the last byte of the response being timed leaves the line.
+ */
+static size_t prvUartWrite( const uint8_t *pucData, size_t xLength )
+{
+uint64_t ullNow = ullPortSimGetCycles(), ullHeld = 0, ullRoom, ullSentAt;
+size_t xTaken, xWritten = 0;
+ssize_t xResult;
+
+	if( ullLineFreeAt > ullNow )
+	{
+		ullHeld = ( ullLineFreeAt - ullNow + simCYCLES_PER_BYTE - 1ULL ) / simCYCLES_PER_BYTE;
+	}
+	else
+	{
+		ullLineFreeAt = ullNow;
+	}
+	ullRoom = ( ullHeld < simUART_BUFFER ) ? ( simUART_BUFFER - ullHeld ) : 0;
+	xTaken = ( ( uint64_t ) xLength < ullRoom ) ? xLength : ( size_t ) ullRoom;
+
+	ullLineFreeAt += ( uint64_t ) xTaken * simCYCLES_PER_BYTE;
+	ullUartBytes += xTaken;
+
+	if( ( xTiming != pdFALSE ) && ( ullUartBytes >= ulResponseEnd ) )
+	{
+		ullSentAt = ullLineFreeAt - ( ( ullUartBytes - ulResponseEnd ) * simCYCLES_PER_BYTE );
+		if( ulTimed < simMAX_TIMED )
+		{
+			ullServiceCycles[ ulTimed++ ] = ullSentAt - ullRequestAt;
+		}
+		xTiming = pdFALSE;
+	}
+
+	while( xWritten < xTaken )
+	{
+		xResult = write( iMaster, &( pucData[ xWritten ] ), xTaken - xWritten );
+		if( xResult >= 0 )
+		{
+			xWritten += ( size_t ) xResult;
+		}
+		else if( errno == EAGAIN )
+		{
+			/* The client only reads while it waits for a response, so once
+			it has finished nothing empties the pseudo terminal. */
+			if( xClientDone != pdFALSE )
+			{
+				break;
+			}
+			usleep( 100 );
+		}
+		else if( errno != EINTR )
+		{
+			break;
+		}
+	}
+
+	return xTaken;
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t prvThresholds( const Command_t *pxCommand, uint8_t *pucResult, size_t *pxLength )
+{
+uint16_t usFrequency = 0, usRoc = 0;
+
+	if( pxCommand->ucCommand == commandCOMMAND_SET_THRESHOLDS )
+	{
+		if( pxCommand->xLength != 4 )
+		{
+			return commandSTATUS_BAD_LENGTH;
+		}
+		usFrequency = ( uint16_t ) ( pxCommand->pucArguments[ 0 ] | ( pxCommand->pucArguments[ 1 ] << 8 ) );
+		usRoc = ( uint16_t ) ( pxCommand->pucArguments[ 2 ] | ( pxCommand->pucArguments[ 3 ] << 8 ) );
+		if( ( usFrequency > simMAX_FREQUENCY_THRESHOLD ) || ( usRoc > simMAX_ROC_THRESHOLD ) )
+		{
+			return commandSTATUS_BAD_VALUE;
+		}
+	}
+	else if( pxCommand->xLength != 0 )
+	{
+		return commandSTATUS_BAD_LENGTH;
+	}
+
+	taskENTER_CRITICAL();
+	{
+		if( pxCommand->ucCommand == commandCOMMAND_SET_THRESHOLDS )
+		{
+			fFrequencyThreshold = ( float ) usFrequency / 10.0f;
+			iRocThreshold = usRoc;
+		}
+		usFrequency = ( uint16_t ) ( ( fFrequencyThreshold * 10.0f ) + 0.5f );
+		usRoc = ( uint16_t ) iRocThreshold;
+	}
+	taskEXIT_CRITICAL();
+
+	prvPut( &( pucResult[ 0 ] ), usFrequency, 2 );
+	prvPut( &( pucResult[ 2 ] ), usRoc, 2 );
+	*pxLength = 4;
+	return commandSTATUS_OK;
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t prvStats( uint8_t *pucResult, size_t *pxLength )
+{
+unsigned u;
+
+	vTaskSuspendAll();
+	{
+		pucResult[ commandSTATS_STATE ] = ucState;
+		pucResult[ commandSTATS_LOADS ] = ucLoads;
+		pucResult[ commandSTATS_MAINTENANCE ] = ucMaintenance;
+		pucResult[ commandSTATS_REACTIONS_HELD ] = ( uint8_t ) uReactionsHeld;
+		prvPut( &( pucResult[ commandSTATS_REACTION_COUNT ] ), uReactionCount, 4 );
+		prvPut( &( pucResult[ commandSTATS_REACTION_MIN ] ), ( uReactionCount != 0U ) ? ( uint32_t ) iMinReaction : 0U, 4 );
+		prvPut( &( pucResult[ commandSTATS_REACTION_MAX ] ), ( uint32_t ) iMaxReaction, 4 );
+		prvPut( &( pucResult[ commandSTATS_REACTION_AVERAGE ] ), ( uint32_t ) iAverageReaction, 4 );
+		for( u = 0; u < simREACTIONS; u++ )
+		{
+			prvPut( &( pucResult[ commandSTATS_REACTIONS + ( 2U * u ) ] ), ( uint32_t ) iReactionTimes[ u ], 2 );
+		}
+
+		if( ( uReactionCount != 0U ) && ( ( iAverageReaction < iMinReaction ) || ( iAverageReaction > iMaxReaction ) ) )
+		{
+			ulBadAverages++;
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	prvPut( &( pucResult[ commandSTATS_TELEMETRY_DROPPED ] ), ulTelemetryGetDropped(), 4 );
+	prvPut( &( pucResult[ commandSTATS_REJECTED ] ), xParser.ulRejected, 4 );
+	prvPut( &( pucResult[ commandSTATS_UPTIME ] ), xTaskGetTickCount(), 4 );
+	*pxLength = commandSTATS_SIZE;
+	return commandSTATUS_OK;
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t prvHistory( const Command_t *pxCommand, uint8_t *pucResult, size_t *pxLength )
+{
+int iSkip, iCount, i;
+
+	if( pxCommand->xLength != 1 )
+	{
+		return commandSTATUS_BAD_LENGTH;
+	}
+	iSkip = pxCommand->pucArguments[ 0 ];
+
+	vTaskSuspendAll();
+	{
+		iCount = iHistoryHeld - iSkip;
+		if( iCount < 0 )
+		{
+			iCount = 0;
+		}
+		else if( iCount > ( int ) commandHISTORY_MAX_SAMPLES )
+		{
+			iCount = commandHISTORY_MAX_SAMPLES;
+		}
+		pucResult[ 0 ] = ( uint8_t ) iHistoryHeld;
+		for( i = 0; i < iCount; i++ )
+		{
+			prvPut( &( pucResult[ commandHISTORY_HEADER + ( commandHISTORY_SAMPLE_SIZE * i ) ] ), ( uint32_t ) ( fFrequencyData[ iSkip + i ] * 100.0f ), 2 );
+			prvPut( &( pucResult[ commandHISTORY_HEADER + ( commandHISTORY_SAMPLE_SIZE * i ) + 2 ] ), ( uint32_t ) ( int32_t ) ( fRocData[ iSkip + i ] * 100.0f ), 2 );
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	pucResult[ 1 ] = ( uint8_t ) iSkip;
+	pucResult[ 2 ] = ( uint8_t ) iCount;
+	*pxLength = commandHISTORY_HEADER + ( commandHISTORY_SAMPLE_SIZE * ( size_t ) iCount );
+	return commandSTATUS_OK;
+}
+/*-----------------------------------------------------------*/
+
+static void prvHandle( const Command_t *pxCommand )
+{
+uint8_t ucResult[ commandMAX_RESULT ];
+size_t xLength = 0;
+uint8_t ucStatus;
+
+	vPortSimConsume( simREQUEST_CYCLES );
+	if( pxCommand->ucCommand <= commandCOMMAND_SNAPSHOT )
+	{
+		ulCommands[ pxCommand->ucCommand ]++;
+	}
+
+	switch( pxCommand->ucCommand )
+	{
+		case commandCOMMAND_PING :
+			memcpy( ucResult, pxCommand->pucArguments, pxCommand->xLength );
+			xLength = pxCommand->xLength;
+			ucStatus = commandSTATUS_OK;
+			break;
+
+		case commandCOMMAND_GET_THRESHOLDS :
+		case commandCOMMAND_SET_THRESHOLDS :
+			ucStatus = prvThresholds( pxCommand, ucResult, &xLength );
+			break;
+
+		case commandCOMMAND_GET_STATS :
+			ucStatus = ( pxCommand->xLength == 0 ) ? prvStats( ucResult, &xLength ) : commandSTATUS_BAD_LENGTH;
+			break;
+
+		case commandCOMMAND_GET_HISTORY :
+			ucStatus = prvHistory( pxCommand, ucResult, &xLength );
+			break;
+
+		case commandCOMMAND_SET_MAINTENANCE :
+			if( pxCommand->xLength != 1 )
+			{
+				ucStatus = commandSTATUS_BAD_LENGTH;
+			}
+			else if( pxCommand->pucArguments[ 0 ] > commandMAINTENANCE_TOGGLE )
+			{
+				ucStatus = commandSTATUS_BAD_VALUE;
+			}
+			else
+			{
+				ucMaintenance = ( pxCommand->pucArguments[ 0 ] == commandMAINTENANCE_TOGGLE ) ? ( uint8_t ) !ucMaintenance : pxCommand->pucArguments[ 0 ];
+				ucResult[ 0 ] = ucMaintenance;
+				ucResult[ 1 ] = ucState;
+				xLength = 2;
+				ucStatus = commandSTATUS_OK;
+			}
+			break;
+
+		case commandCOMMAND_SNAPSHOT :
+			/* There is no trace dump task here. */
+			ucStatus = ( pxCommand->xLength == 0 ) ? commandSTATUS_OK : commandSTATUS_BAD_LENGTH;
+			break;
+
+		default :
+			ucStatus = commandSTATUS_UNKNOWN;
+			break;
+	}
+
+	if( ucStatus != commandSTATUS_OK )
+	{
+		xLength = 0;
+	}
+
+	if( xCommandRespond( pxCommand, ucStatus, ucResult, xLength ) != pdFALSE )
+	{
+		ulResponseEnd = ulTelemetryGetQueuedBytes();
+		xTiming = pdTRUE;
+	}
+	else
+	{
+		ulUntimed++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Stands in for Relay.c's commandTask, reading the pseudo terminal.
+ */
+static void prvCommandTask( void *pvParameters )
+{
+uint8_t ucReceived[ 64 ];
+ssize_t xCount, x;
+Command_t xCommand;
+TickType_t xLastReceived;
+
+	( void ) pvParameters;
+
+	vCommandParserInit( &xParser );
+	xLastReceived = xTaskGetTickCount() - simACTIVE_TICKS;
+
+	for( ;; )
+	{
+		ulPolls++;
+		xCount = read( iMaster, ucReceived, sizeof( ucReceived ) );
+		if( xCount > 0 )
+		{
+			xLastReceived = xTaskGetTickCount();
+			for( x = 0; x < xCount; x++ )
+			{
+				if( xCommandParserFeed( &xParser, ucReceived[ x ], &xCommand ) != pdFALSE )
+				{
+					if( xTiming != pdFALSE )
+					{
+						/* The last response is still going out. */
+						ulUntimed++;
+					}
+					ullRequestAt = ullPortSimGetCycles();
+					prvHandle( &xCommand );
+				}
+			}
+			continue;
+		}
+
+		if( waitpid( xClient, &iClientStatus, WNOHANG ) == xClient )
+		{
+			break;
+		}
+
+		if( ( xTaskGetTickCount() - xLastReceived ) < simACTIVE_TICKS )
+		{
+			vTaskDelay( simPOLL_TICKS );
+		}
+		else
+		{
+			vTaskDelay( simIDLE_POLL_TICKS );
+		}
+	}
+
+	xClientDone = pdTRUE;
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Adds samples to the history and the telemetry stream as loadManagerTask
+ * does, and a trip with a reaction time every simTRIP_TICKS.
+ */
+static void prvProducerTask( void *pvParameters )
+{
+TickType_t xNow;
+float fFrequency = 50.0f, fPrevious;
+int i, iReaction, iSum;
+
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		vTaskDelay( simSAMPLE_TICKS );
+		xNow = xTaskGetTickCount();
+
+		fPrevious = fFrequency;
+		fFrequency = 50.0f + ( ( float ) ( ( int ) ( ( xNow * 7U ) % 9U ) - 4 ) / 100.0f );
+		vPortSimConsume( simSAMPLE_CYCLES );
+
+		vTaskSuspendAll();
+		{
+			if( iHistoryHeld < simHISTORY )
+			{
+				iHistoryHeld++;
+			}
+			for( i = iHistoryHeld - 2; i >= 0; i-- )
+			{
+				fFrequencyData[ i + 1 ] = fFrequencyData[ i ];
+				fRocData[ i + 1 ] = fRocData[ i ];
+			}
+			fFrequencyData[ 0 ] = fFrequency;
+			fRocData[ 0 ] = ( fFrequency - fPrevious ) * ( float ) ( configTICK_RATE_HZ / simSAMPLE_TICKS );
+
+			if( ( xNow % simTRIP_TICKS ) < simSAMPLE_TICKS )
+			{
+				/* A shed timed from its sample, a few ms. */
+				iReaction = 2 + ( int ) ( ( xNow / simTRIP_TICKS ) % 5U );
+				if( uReactionsHeld < simREACTIONS )
+				{
+					uReactionsHeld++;
+				}
+				for( i = ( int ) uReactionsHeld - 2; i >= 0; i-- )
+				{
+					iReactionTimes[ i + 1 ] = iReactionTimes[ i ];
+				}
+				iReactionTimes[ 0 ] = iReaction;
+				uReactionCount++;
+				for( i = 0, iSum = 0; i < ( int ) uReactionsHeld; i++ )
+				{
+					iSum += iReactionTimes[ i ];
+				}
+				iAverageReaction = iSum / ( int ) uReactionsHeld;
+				iMinReaction = ( iReaction < iMinReaction ) ? iReaction : iMinReaction;
+				iMaxReaction = ( iReaction > iMaxReaction ) ? iReaction : iMaxReaction;
+				ucState = ( ucState == simNORMAL ) ? simLOAD_MANAGE : simNORMAL;
+				ucLoads = ( ucState == simNORMAL ) ? simALL_LOADS : ( uint8_t ) ( simALL_LOADS & ~1U );
+			}
+		}
+		( void ) xTaskResumeAll();
+
+		( void ) xTelemetrySendSample( ( uint16_t ) ( fFrequency * 100.0f ), ( int16_t ) ( fRocData[ 0 ] * 100.0f ) );
+		ulSamples++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Stands in for Relay.c's telemetryTask, draining into prvUartWrite().
+ */
+static void prvDrainTask( void *pvParameters )
+{
+TickType_t xNow, xLastHeartbeat = xTaskGetTickCount();
+
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		xNow = xTaskGetTickCount();
+		if( ( xNow - xLastHeartbeat ) >= simHEARTBEAT_TICKS )
+		{
+			( void ) xTelemetrySendHeartbeat();
+			xLastHeartbeat = xNow;
+		}
+
+		if( xTelemetryDrain( prvUartWrite ) != 0 )
+		{
+			vTaskDelay( 1 );
+		}
+		else
+		{
+			ulTaskNotifyTake( pdTRUE, simHEARTBEAT_TICKS - ( xNow - xLastHeartbeat ) );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationIdleHook( void )
+{
+uint64_t ullSimulatedUs, ullWallUs;
+
+	vPortSimConsume( 1000 );
+
+	/* Wait for the wall clock to catch up with simulated time. */
+	ullSimulatedUs = ullPortSimGetCycles() / simCYCLES_PER_US;
+	ullWallUs = ( prvNowNs() - ullStartNs ) / 1000ULL;
+	if( ullSimulatedUs > ullWallUs + 1000ULL )
+	{
+		usleep( ( useconds_t ) ( ullSimulatedUs - ullWallUs ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint16_t *pusIdleTaskStackSize )
+{
+	*ppxIdleTaskTCBBuffer = &xIdleTaskBuffer;
+	*ppxIdleTaskStackBuffer = xIdleTaskStack;
+	*pusIdleTaskStackSize = simSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint16_t *pusTimerTaskStackSize )
+{
+	*ppxTimerTaskTCBBuffer = &xTimerTaskBuffer;
+	*ppxTimerTaskStackBuffer = xTimerTaskStack;
+	*pusTimerTaskStackSize = simSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Opens a pseudo terminal in raw mode and starts the client on its slave
+ * side, passing the slave's name with -d before the client's own arguments.
+ */
+static pid_t prvStartClient( int argc, char **argv )
+{
+struct termios xTerm;
+const char *pcSlave;
+char **ppcArgs;
+int iSlave, iArg;
+pid_t xPid;
+
+	iMaster = posix_openpt( O_RDWR | O_NOCTTY | O_NONBLOCK );
+	if( ( iMaster < 0 ) || ( grantpt( iMaster ) != 0 ) || ( unlockpt( iMaster ) != 0 ) || ( ( pcSlave = ptsname( iMaster ) ) == NULL ) )
+	{
+		perror( "command_sim: pseudo terminal" );
+		return -1;
+	}
+
+	/* Raw before anything is written, and kept open here so the pseudo
+	terminal always has a reader. */
+	iSlave = open( pcSlave, O_RDWR | O_NOCTTY );
+	if( ( iSlave < 0 ) || ( tcgetattr( iSlave, &xTerm ) != 0 ) )
+	{
+		perror( pcSlave );
+		return -1;
+	}
+	cfmakeraw( &xTerm );
+	( void ) tcsetattr( iSlave, TCSANOW, &xTerm );
+
+	ppcArgs = calloc( ( size_t ) argc + 3U, sizeof( char * ) );
+	if( ppcArgs == NULL )
+	{
+		return -1;
+	}
+	ppcArgs[ 0 ] = argv[ 1 ];
+	ppcArgs[ 1 ] = "-d";
+	ppcArgs[ 2 ] = ( char * ) pcSlave;
+	for( iArg = 2; iArg < argc; iArg++ )
+	{
+		ppcArgs[ iArg + 1 ] = argv[ iArg ];
+	}
+
+	fflush( stdout );
+	xPid = fork();
+	if( xPid == 0 )
+	{
+		close( iMaster );
+		close( iSlave );
+		execv( ppcArgs[ 0 ], ppcArgs );
+		perror( ppcArgs[ 0 ] );
+		_exit( 127 );
+	}
+	free( ppcArgs );
+
+	if( xPid < 0 )
+	{
+		perror( "command_sim: fork" );
+	}
+
+	return xPid;
+}
+/*-----------------------------------------------------------*/
+
+static int prvCompare( const void *pvA, const void *pvB )
+{
+uint64_t ullA = *( const uint64_t * ) pvA, ullB = *( const uint64_t * ) pvB;
+
+	return ( ullA > ullB ) - ( ullA < ullB );
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc, char **argv )
+{
+static const char * const pcCommandNames[] = { "", "ping", "get", "set", "stats", "history", "maintenance", "snapshot" };
+CommandParser_t xCheck;
+Command_t xCommand;
+static const uint8_t ucBroken[] = { 0x03, 0x01, 0x00 };
+uint32_t ul;
+
+	if( argc < 3 )
+	{
+		fprintf( stderr, "usage: command_sim <command_client> [client options] command...\n" );
+		return 1;
+	}
+
+	/* A frame with a broken encoding and back to back delimiters: one
+	rejection, no request. */
+	vCommandParserInit( &xCheck );
+	for( ul = 0; ul < sizeof( ucBroken ); ul++ )
+	{
+		if( xCommandParserFeed( &xCheck, ucBroken[ ul ], &xCommand ) != pdFALSE )
+		{
+			fprintf( stderr, "command_sim: parser accepted a broken frame\n" );
+			return 1;
+		}
+	}
+	if( ( xCommandParserFeed( &xCheck, 0U, &xCommand ) != pdFALSE ) || ( xCheck.ulRejected != 1U ) )
+	{
+		fprintf( stderr, "command_sim: parser counted %lu rejections, expected 1\n", ( unsigned long ) xCheck.ulRejected );
+		return 1;
+	}
+
+	xClient = prvStartClient( argc, argv );
+	if( xClient < 0 )
+	{
+		return 1;
+	}
+
+	xTaskCreateStatic( prvProducerTask, "producer", simSTACK_DEPTH, NULL, 2, xProducerTaskStack, &xProducerTaskBuffer );
+	xTaskCreateStatic( prvCommandTask, "command", simSTACK_DEPTH, NULL, 1, xCommandTaskStack, &xCommandTaskBuffer );
+	xDrainTask = xTaskCreateStatic( prvDrainTask, "drain", simSTACK_DEPTH, NULL, 1, xDrainTaskStack, &xDrainTaskBuffer );
+	vTelemetrySetDrainTask( xDrainTask );
+
+	ullStartNs = prvNowNs();
+	vTaskStartScheduler();
+
+	fflush( stdout );
+	close( iMaster );
+	if( ( WIFEXITED( iClientStatus ) == 0 ) || ( WEXITSTATUS( iClientStatus ) != 0 ) )
+	{
+		fprintf( stderr, "command_sim: client failed\n" );
+		return 1;
+	}
+
+	printf( "Command channel over %.1f simulated seconds (host), %llu baud, polled every %lu/%lu ticks\n",
+			( double ) xTaskGetTickCount() / configTICK_RATE_HZ, ( unsigned long long ) simBAUD,
+			( unsigned long ) simPOLL_TICKS, ( unsigned long ) simIDLE_POLL_TICKS );
+	printf( "  requests:" );
+	for( ul = commandCOMMAND_PING; ul <= commandCOMMAND_SNAPSHOT; ul++ )
+	{
+		printf( " %lu %s", ( unsigned long ) ulCommands[ ul ], pcCommandNames[ ul ] );
+	}
+	printf( ", %lu rejected; %lu samples, %lu telemetry frames dropped, %lu polls\n", ( unsigned long ) xParser.ulRejected,
+			( unsigned long ) ulSamples, ( unsigned long ) ulTelemetryGetDropped(), ( unsigned long ) ulPolls );
+
+	if( ulTimed > 0 )
+	{
+		qsort( ullServiceCycles, ulTimed, sizeof( ullServiceCycles[ 0 ] ), prvCompare );
+		printf( "  simulated request to last response byte on the line, us: min %.0f  p50 %.0f  p99 %.0f  max %.0f (%lu timed, %lu not)\n",
+				( double ) ullServiceCycles[ 0 ] / simCYCLES_PER_US, ( double ) ullServiceCycles[ ulTimed / 2U ] / simCYCLES_PER_US,
+				( double ) ullServiceCycles[ ( ulTimed * 99U ) / 100U ] / simCYCLES_PER_US, ( double ) ullServiceCycles[ ulTimed - 1U ] / simCYCLES_PER_US,
+				( unsigned long ) ulTimed, ( unsigned long ) ulUntimed );
+	}
+
+	if( ulBadAverages != 0U )
+	{
+		fprintf( stderr, "command_sim: %lu statistics with the average reaction time outside min to max\n", ( unsigned long ) ulBadAverages );
+		return 1;
+	}
+
+	return 0;
+}
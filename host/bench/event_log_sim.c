@@ -0,0 +1,509 @@
+/*
+ * Host simulation of the relay event log (event_log.c): runs a load manager
+ * shaped like loadManagerTask against a synthetic grid on the simulated port,
+ * records its decisions as events and writes them out for event_decode.
+ *
+ *   event_log_sim <events.txt> <events.bin>
+ *
+ * The manager task takes a sample every 20ms (the relay's 50Hz frequency
+ * input).  Every few seconds the frequency sags below the threshold for a
+ * while and recovers.  The manager sheds a load on the first sample that
+ * breaks a threshold, then sheds or reconnects one load per 500ms window as
+ * Relay.c does, returning to normal once every load is back.  The work before
+ * each shed is charged with vPortSimConsume(), a pseudo random 0.2 to 2.2ms,
+ * so the reaction times event_decode reports have a spread to show.
+ *
+ * A drain task below the manager writes every record to both files: the text
+ * file as vEventLogPrintRecord() lines, as the relay prints them on the JTAG
+ * UART, and the binary file as vEventLogEncode() bytes, as sent with
+ * EVENT_LOG_SERIAL.  Decoding either must give the same summary.  Last, the
+ * ring is filled past its size with the drain task held off, to check the
+ * drops are reported in the stream.
+ *
+ * Printed figures: bytes per record in each form against the text the
+ * printf() calls these events replace would have produced, and host
+ * nanoseconds per vEventLogWrite() of a shed event against formatting
+ * shedLoad()'s message with snprintf(), timed in batches that fill the ring.
+ * Both are host figures only.
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "event_log.h"
+
+#define simSECONDS				300
+#define simSAMPLE_TICKS			( ( TickType_t ) 20 )
+#define simWINDOW_TICKS			( ( TickType_t ) 500 )
+#define simLOADS				5
+#define simALL_LOADS			( ( 1U << simLOADS ) - 1U )
+#define simOVERFILL				8
+#define simBATCHES				2000
+
+/* The relay's states, as Relay.c numbers them. */
+#define simNORMAL				0
+#define simLOAD_MANAGE			1
+
+/* Thresholds, 0.1 Hz and 0.1 Hz/s, as the keyboard sets them. */
+#define simFREQUENCY_THRESHOLD	490
+#define simROC_THRESHOLD		150
+
+#define simSTACK_DEPTH			( 256 )
+
+static StaticTask_t xManagerTaskBuffer, xDrainTaskBuffer, xIdleTaskBuffer, xTimerTaskBuffer;
+static StackType_t xManagerTaskStack[ simSTACK_DEPTH ], xDrainTaskStack[ simSTACK_DEPTH ], xIdleTaskStack[ simSTACK_DEPTH ], xTimerTaskStack[ simSTACK_DEPTH ];
+static TaskHandle_t xDrainTask;
+
+static FILE *pxText, *pxBinary;
+
+/* The manager's view, copied into every record as logEvent() does. */
+static uint8_t ucState = simNORMAL, ucLoads = simALL_LOADS;
+static int32_t lFrequency = 5000, lRoc = 0;
+
+static uint32_t ulRandom = 0x2545F491UL;
+
+/* Written by the manager, reported by the drain task. */
+static uint32_t ulWrites = 0;
+static uint64_t ullWriteNs = UINT64_MAX, ullCounterNs = UINT64_MAX, ullSnprintfNs = UINT64_MAX;
+static volatile BaseType_t xFinished = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNowNs( void )
+{
+struct timespec xNow;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRandom( void )
+{
+	ulRandom ^= ulRandom << 13;
+	ulRandom ^= ulRandom >> 17;
+	ulRandom ^= ulRandom << 5;
+	return ulRandom;
+}
+/*-----------------------------------------------------------*/
+
+static void prvLogEvent( uint8_t ucEvent, uint8_t ucLoad, uint32_t ulValue )
+{
+EventLogRecord_t xRecord;
+
+	xRecord.ulTimeUs = 0;
+	xRecord.ucEvent = ucEvent;
+	xRecord.ucState = ucState;
+	xRecord.ucLoads = ucLoads;
+	xRecord.ucLoad = ucLoad;
+	xRecord.usFrequency = ( uint16_t ) lFrequency;
+	xRecord.sRoc = ( int16_t ) lRoc;
+	xRecord.ulValue = ulValue;
+	vEventLogWrite( &xRecord );
+
+	ulWrites++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetState( uint8_t ucNewState )
+{
+uint8_t ucOldState = ucState;
+
+	ucState = ucNewState;
+	prvLogEvent( eventlogEVENT_STATE, eventlogNO_LOAD, ucOldState );
+}
+/*-----------------------------------------------------------*/
+
+/* Lowest numbered load first, as shedLoad() does. */
+static void prvShed( void )
+{
+uint8_t ucLoad;
+
+	for( ucLoad = 0; ucLoad < simLOADS; ucLoad++ )
+	{
+		if( ( ucLoads & ( 1U << ucLoad ) ) != 0 )
+		{
+			ucLoads &= ( uint8_t ) ~( 1U << ucLoad );
+			prvLogEvent( eventlogEVENT_SHED, ucLoad, 0 );
+			return;
+		}
+	}
+	prvLogEvent( eventlogEVENT_SHED, eventlogNO_LOAD, 0 );
+}
+/*-----------------------------------------------------------*/
+
+/* Highest numbered load shed first, as reconnectLoad() does. */
+static void prvReconnect( void )
+{
+uint8_t ucLoad;
+
+	for( ucLoad = simLOADS; ucLoad-- > 0; )
+	{
+		if( ( ucLoads & ( 1U << ucLoad ) ) == 0 )
+		{
+			ucLoads |= ( uint8_t ) ( 1U << ucLoad );
+			prvLogEvent( eventlogEVENT_RECONNECT, ucLoad, 0 );
+			return;
+		}
+	}
+	prvLogEvent( eventlogEVENT_RECONNECT, eventlogNO_LOAD, 0 );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * The grid in 0.01 Hz at a tick: 50Hz with a little noise, and a sag of up to
+ * 1.6Hz every 3 to 8 seconds that lasts 0.3 to 2.8 seconds.
+ */
+static int32_t prvFrequency( TickType_t xNow )
+{
+static TickType_t xSagStart = 2000, xSagLength = 1000;
+static int32_t lSagDepth = 120;
+int32_t lFrequency = 5000 + ( int32_t ) ( prvRandom() % 9 ) - 4;
+TickType_t xInto;
+
+	if( xNow >= ( xSagStart + xSagLength ) )
+	{
+		xSagStart = xNow + 3000 + ( prvRandom() % 5000 );
+		xSagLength = 300 + ( prvRandom() % 2500 );
+		lSagDepth = 40 + ( int32_t ) ( prvRandom() % 120 );
+	}
+
+	if( xNow >= xSagStart )
+	{
+		/* Falls over 200ms, holds, and recovers over the last 200ms. */
+		xInto = xNow - xSagStart;
+		if( xInto < 200 )
+		{
+			lFrequency -= ( lSagDepth * ( int32_t ) xInto ) / 200;
+		}
+		else if( xInto > ( xSagLength - 200 ) )
+		{
+			lFrequency -= ( lSagDepth * ( int32_t ) ( xSagLength - xInto ) ) / 200;
+		}
+		else
+		{
+			lFrequency -= lSagDepth;
+		}
+	}
+
+	return lFrequency;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvIsTripping( void )
+{
+	return ( ( lFrequency < ( simFREQUENCY_THRESHOLD * 10 ) ) || ( lRoc > ( simROC_THRESHOLD * 10 ) ) ||
+			( lRoc < -( simROC_THRESHOLD * 10 ) ) ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvKeepFastest( uint64_t ullTime, uint64_t *pullBest )
+{
+	if( ullTime < *pullBest )
+	{
+		*pullBest = ullTime;
+	}
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Times a ring's worth of shed events against formatting the message
+ * shedLoad() used to print for each, the fastest of simBATCHES batches, and
+ * the run time counter reads the writes make.  The drain task is below this
+ * one, so the records are read back here and never reach the files.
+ */
+static void prvTimeWrites( void )
+{
+EventLogRecord_t xRecord;
+char cBuffer[ 32 ];
+uint64_t ullStart;
+uint32_t ulBatch, ulItem, ulWritesBefore = ulWrites;
+UBaseType_t uxSavedInterruptStatus;
+
+	for( ulBatch = 0; ulBatch < simBATCHES; ulBatch++ )
+	{
+		ullStart = prvNowNs();
+		for( ulItem = 0; ulItem < configEVENT_LOG_RECORDS; ulItem++ )
+		{
+			prvLogEvent( eventlogEVENT_SHED, ( uint8_t ) ( ulItem % simLOADS ), 0 );
+		}
+		prvKeepFastest( prvNowNs() - ullStart, &ullWriteNs );
+
+		while( xEventLogRead( &xRecord ) != pdFALSE )
+		{
+		}
+
+		ullStart = prvNowNs();
+		for( ulItem = 0; ulItem < configEVENT_LOG_RECORDS; ulItem++ )
+		{
+			snprintf( cBuffer, sizeof( cBuffer ), "Shed Load: %d\n", ( int ) ( ulItem % simLOADS ) );
+		}
+		prvKeepFastest( prvNowNs() - ullStart, &ullSnprintfNs );
+
+		uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+		ullStart = prvNowNs();
+		for( ulItem = 0; ulItem < configEVENT_LOG_RECORDS; ulItem++ )
+		{
+			( void ) portGET_RUN_TIME_COUNTER_VALUE();
+		}
+		prvKeepFastest( prvNowNs() - ullStart, &ullCounterNs );
+		portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+	}
+
+	ulWrites = ulWritesBefore;
+}
+/*-----------------------------------------------------------*/
+
+static void prvManagerTask( void *pvParameters )
+{
+TickType_t xSampleTick, xWindowEnd = 0;
+BaseType_t xTripping, xWasStable = pdTRUE;
+int32_t lPrevious;
+uint32_t ulItem;
+
+	( void ) pvParameters;
+
+	prvLogEvent( eventlogEVENT_BOOT, eventlogNO_LOAD, 0 );
+	prvLogEvent( eventlogEVENT_THRESHOLDS, eventlogNO_LOAD, ( ( uint32_t ) simFREQUENCY_THRESHOLD << 16 ) | simROC_THRESHOLD );
+
+	while( xTaskGetTickCount() < ( TickType_t ) ( simSECONDS * configTICK_RATE_HZ ) )
+	{
+		vTaskDelay( simSAMPLE_TICKS );
+		xSampleTick = xTaskGetTickCount();
+
+		lPrevious = lFrequency;
+		lFrequency = prvFrequency( xSampleTick );
+		lRoc = ( ( lFrequency - lPrevious ) * ( int32_t ) configTICK_RATE_HZ ) / ( int32_t ) simSAMPLE_TICKS;
+		xTripping = prvIsTripping();
+
+		/* Receiving and checking the sample. */
+		vPortSimConsume( 5000 );
+
+		if( ucState == simNORMAL )
+		{
+			if( xTripping != pdFALSE )
+			{
+				prvLogEvent( eventlogEVENT_TRIP, eventlogNO_LOAD, xSampleTick );
+				vPortSimConsume( 20000 + ( prvRandom() % 200000 ) );
+				prvShed();
+				prvLogEvent( eventlogEVENT_REACTION, eventlogNO_LOAD, xTaskGetTickCount() - xSampleTick );
+				xWasStable = pdFALSE;
+				prvSetState( simLOAD_MANAGE );
+				xWindowEnd = xSampleTick + simWINDOW_TICKS;
+			}
+			continue;
+		}
+
+		if( ( xTripping != pdFALSE ) && ( xWasStable != pdFALSE ) )
+		{
+			prvLogEvent( eventlogEVENT_TRIP, eventlogNO_LOAD, xSampleTick );
+			xWasStable = pdFALSE;
+			xWindowEnd = xSampleTick + simWINDOW_TICKS;
+		}
+		else if( ( xTripping == pdFALSE ) && ( xWasStable == pdFALSE ) )
+		{
+			prvLogEvent( eventlogEVENT_STABLE, eventlogNO_LOAD, xSampleTick );
+			xWasStable = pdTRUE;
+			xWindowEnd = xSampleTick + simWINDOW_TICKS;
+		}
+		else if( xSampleTick >= xWindowEnd )
+		{
+			prvLogEvent( eventlogEVENT_STABILITY_EXPIRY, eventlogNO_LOAD, 0 );
+			if( xWasStable != pdFALSE )
+			{
+				prvReconnect();
+				if( ucLoads == simALL_LOADS )
+				{
+					prvSetState( simNORMAL );
+				}
+			}
+			else
+			{
+				prvShed();
+			}
+			xWindowEnd = xSampleTick + simWINDOW_TICKS;
+		}
+	}
+
+	/* Let the drain task empty the ring first. */
+	vTaskDelay( simSAMPLE_TICKS );
+	prvTimeWrites();
+
+	/* The drain task is below this one, so it cannot run until the ring has
+	been overfilled. */
+	for( ulItem = 0; ulItem < configEVENT_LOG_RECORDS + simOVERFILL; ulItem++ )
+	{
+		prvLogEvent( eventlogEVENT_LOAD_SWITCH, ( uint8_t ) ( ulItem % simLOADS ), ulItem & 1UL );
+	}
+
+	xFinished = pdTRUE;
+	xTaskNotifyGive( xDrainTask );
+	vTaskSuspend( NULL );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * What the printf() calls in Relay.c that these events stand for would have
+ * printed, for the byte count.
+ */
+static int prvFormatRelayText( const EventLogRecord_t *pxRecord, char *pcBuffer, size_t xLength )
+{
+	switch( pxRecord->ucEvent )
+	{
+		case eventlogEVENT_SHED :
+			if( pxRecord->ucLoad == eventlogNO_LOAD )
+			{
+				return snprintf( pcBuffer, xLength, "\n ############ ATTEMPT TO DISCONNECT LOAD ERROR: ALL LOADS ARE ALREADY DISCONNECTED##### \n" );
+			}
+			return snprintf( pcBuffer, xLength, "Shed Load: %d\n", pxRecord->ucLoad );
+
+		case eventlogEVENT_RECONNECT :
+			return snprintf( pcBuffer, xLength, "Reconnected Load: %d\n", pxRecord->ucLoad );
+
+		case eventlogEVENT_LOAD_SWITCH :
+			return snprintf( pcBuffer, xLength, "Load ID: %d\n isTurnON: %d\n", pxRecord->ucLoad, ( int ) pxRecord->ulValue );
+
+		case eventlogEVENT_STATE :
+			if( pxRecord->ucState == simLOAD_MANAGE )
+			{
+				return snprintf( pcBuffer, xLength, "\n################LOAD MANAGER MODE##########################\n" );
+			}
+			return snprintf( pcBuffer, xLength, "\n\n############ NORMAL MODE ########!\n\n" );
+
+		case eventlogEVENT_STABILITY_EXPIRY :
+			return snprintf( pcBuffer, xLength, "#######TIMER EXPIRY BEFORE NEW INPUT RECEIVED#####\n" );
+
+		default :
+			/* Trips, recoveries, reaction times and the rest were not printed. */
+			pcBuffer[ 0 ] = '\0';
+			return 0;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static int prvPrintText( const char *pcFormat, ... )
+{
+va_list xArgs;
+int iLength;
+
+	va_start( xArgs, pcFormat );
+	iLength = vfprintf( pxText, pcFormat, xArgs );
+	va_end( xArgs );
+
+	return iLength;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Stands in for Relay.c's logDrainTask, writing both forms.
+ */
+static void prvDrainTask( void *pvParameters )
+{
+EventLogRecord_t xRecord;
+uint8_t ucBytes[ eventlogRECORD_SIZE ];
+char cRelayText[ 128 ];
+uint32_t ulRecords = 0, ulDropped = 0;
+uint64_t ullRelayBytes = 0;
+long lTextBytes;
+
+	( void ) pvParameters;
+
+	vEventLogPrintHeader( prvPrintText );
+	vEventLogEncodeHeader( ucBytes );
+	fwrite( ucBytes, 1, eventlogHEADER_SIZE, pxBinary );
+
+	for( ;; )
+	{
+		while( xEventLogRead( &xRecord ) != pdFALSE )
+		{
+			vEventLogPrintRecord( &xRecord, prvPrintText );
+			vEventLogEncode( &xRecord, ucBytes );
+			fwrite( ucBytes, 1, eventlogRECORD_SIZE, pxBinary );
+
+			ullRelayBytes += ( uint64_t ) prvFormatRelayText( &xRecord, cRelayText, sizeof( cRelayText ) );
+
+			if( xRecord.ucEvent == eventlogEVENT_DROPPED )
+			{
+				ulDropped += xRecord.ulValue;
+			}
+			ulRecords++;
+		}
+
+		if( xFinished != pdFALSE )
+		{
+			break;
+		}
+
+		ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+	}
+
+	lTextBytes = ftell( pxText );
+
+	printf( "Event log over %d simulated seconds (host)\n", simSECONDS );
+	printf( "  %lu records drained, %lu written, %lu dropped with the drain task held off (ring of %d, %d over)\n",
+			( unsigned long ) ulRecords, ( unsigned long ) ulWrites, ( unsigned long ) ulDropped, configEVENT_LOG_RECORDS, simOVERFILL );
+	printf( "  %-30s %10s %12s\n", "form", "bytes", "per record" );
+	printf( "  %-30s %10lu %12.1f\n", "binary (EVENT_LOG_SERIAL)", ( unsigned long ) ftell( pxBinary ),
+			( double ) ( ftell( pxBinary ) - eventlogHEADER_SIZE ) / ( double ) ulRecords );
+	printf( "  %-30s %10ld %12.1f\n", "hex lines (JTAG UART)", lTextBytes, ( double ) lTextBytes / ( double ) ulRecords );
+	printf( "  %-30s %10lu %12.1f\n", "Relay.c printf text", ( unsigned long ) ullRelayBytes, ( double ) ullRelayBytes / ( double ) ulRecords );
+	printf( "  ns per shed event (fastest batch of %d): vEventLogWrite %.1f (%.1f of it reading the simulated counter), snprintf \"Shed Load: %%d\" %.1f\n",
+			simBATCHES, ( double ) ullWriteNs / configEVENT_LOG_RECORDS, ( double ) ullCounterNs / configEVENT_LOG_RECORDS,
+			( double ) ullSnprintfNs / configEVENT_LOG_RECORDS );
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationIdleHook( void )
+{
+	vPortSimConsume( 1000 );
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint16_t *pusIdleTaskStackSize )
+{
+	*ppxIdleTaskTCBBuffer = &xIdleTaskBuffer;
+	*ppxIdleTaskStackBuffer = xIdleTaskStack;
+	*pusIdleTaskStackSize = simSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint16_t *pusTimerTaskStackSize )
+{
+	*ppxTimerTaskTCBBuffer = &xTimerTaskBuffer;
+	*ppxTimerTaskStackBuffer = xTimerTaskStack;
+	*pusTimerTaskStackSize = simSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc, char **argv )
+{
+	if( argc != 3 )
+	{
+		fprintf( stderr, "usage: event_log_sim <events.txt> <events.bin>\n" );
+		return 1;
+	}
+
+	pxText = fopen( argv[ 1 ], "w" );
+	pxBinary = fopen( argv[ 2 ], "wb" );
+	if( ( pxText == NULL ) || ( pxBinary == NULL ) )
+	{
+		perror( "event_log_sim" );
+		return 1;
+	}
+
+	xTaskCreateStatic( prvManagerTask, "manager", simSTACK_DEPTH, NULL, 2, xManagerTaskStack, &xManagerTaskBuffer );
+	xDrainTask = xTaskCreateStatic( prvDrainTask, "drain", simSTACK_DEPTH, NULL, 1, xDrainTaskStack, &xDrainTaskBuffer );
+	vEventLogSetDrainTask( xDrainTask );
+
+	vTaskStartScheduler();
+
+	fclose( pxText );
+	fclose( pxBinary );
+
+	return 0;
+}
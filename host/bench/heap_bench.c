@@ -0,0 +1,287 @@
+/*
+ * Host benchmark for the FreeRTOS heap allocators.
+ *
+ * Runs randomised alloc/free traces against whichever allocator the binary was
+ * built with (heap.c when configUSE_TLSF_HEAP is 0, heap_tlsf.c when it is 1)
+ * and reports the mean, 99.9th percentile and worst case latency of each
+ * operation together with the heap statistics at the end of the trace.
+ *
+ * The traces are generated from a fixed seed so both allocators see exactly
+ * the same sequence of requests.  Each trace is replayed benchREPEATS times
+ * and every operation is charged its fastest time over the replays, which
+ * removes page faults and host interrupts from the worst case while keeping
+ * any latency the allocator itself causes.  Build and run both with
+ * "make bench".
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Number of alloc or free operations in each trace. */
+#define benchOPERATIONS		200000
+
+/* Maximum number of blocks live at once. */
+#define benchLIVE_SLOTS		1024
+
+/* Number of times each trace is replayed. */
+#define benchREPEATS		5
+
+/* The allocators suspend the scheduler around every operation.  There is no
+scheduler in this benchmark so these are no-ops. */
+void vTaskSuspendAll( void )
+{
+}
+
+BaseType_t xTaskResumeAll( void )
+{
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+/* Small deterministic generator so the traces do not depend on the C
+library. */
+static uint32_t ulBenchSeed;
+
+static uint32_t prvRand( void )
+{
+	ulBenchSeed = ( ulBenchSeed * 1103515245UL ) + 12345UL;
+	return ( ulBenchSeed >> 8 );
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNowNs( void )
+{
+struct timespec xNow;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+typedef struct
+{
+	const char *pcName;
+	size_t xMinSize;
+	size_t xMaxSize;
+	uint32_t ulLargePercent;	/* Share of requests drawn from the large range. */
+	size_t xLargeMin;
+	size_t xLargeMax;
+	uint32_t ulLiveTarget;		/* Number of live blocks the trace hovers around. */
+} BenchTrace_t;
+
+/* The size mixes are loosely based on what the relay allocates: queue items
+and TCBs at the small end, queue storage in the middle and 8KB task stacks at
+the top. */
+static const BenchTrace_t xTraces[] =
+{
+	{ "small-objects",	8,	128,	0,	0,		0,		512 },
+	{ "kernel-mix",		16,	1024,	5,	4096,	16384,	256 },
+	{ "fragmenting",	8,	256,	20,	2048,	32768,	1000 },
+};
+
+typedef struct
+{
+	uint64_t ullTotal;
+	uint64_t ullWorst;
+	uint32_t ulCount;
+	uint32_t ulHistogram[ 4096 ];	/* 10ns buckets, the last bucket collects everything above. */
+} BenchLatency_t;
+
+static BenchLatency_t xMallocLatency, xFreeLatency;
+static void *pvLive[ benchLIVE_SLOTS ];
+
+static void prvRecord( BenchLatency_t *pxLatency, uint64_t ullNs )
+{
+uint64_t ullBucket = ullNs / 10;
+
+	pxLatency->ullTotal += ullNs;
+	pxLatency->ulCount++;
+
+	if( ullNs > pxLatency->ullWorst )
+	{
+		pxLatency->ullWorst = ullNs;
+	}
+
+	if( ullBucket > 4095 )
+	{
+		ullBucket = 4095;
+	}
+
+	pxLatency->ulHistogram[ ullBucket ]++;
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvPercentile( const BenchLatency_t *pxLatency, uint32_t ulPerMille )
+{
+uint64_t ullWanted, ullSeen = 0;
+uint32_t ul;
+
+	ullWanted = ( ( uint64_t ) pxLatency->ulCount * ulPerMille ) / 1000;
+
+	for( ul = 0; ul < 4096; ul++ )
+	{
+		ullSeen += pxLatency->ulHistogram[ ul ];
+		if( ullSeen >= ullWanted )
+		{
+			return ( uint64_t ) ul * 10;
+		}
+	}
+
+	return pxLatency->ullWorst;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvPickSize( const BenchTrace_t *pxTrace )
+{
+	if( ( pxTrace->ulLargePercent > 0 ) && ( ( prvRand() % 100 ) < pxTrace->ulLargePercent ) )
+	{
+		return pxTrace->xLargeMin + ( prvRand() % ( pxTrace->xLargeMax - pxTrace->xLargeMin + 1 ) );
+	}
+
+	return pxTrace->xMinSize + ( prvRand() % ( pxTrace->xMaxSize - pxTrace->xMinSize + 1 ) );
+}
+/*-----------------------------------------------------------*/
+
+/* Fastest time seen for each operation of the trace across the replays, and
+whether the operation was a malloc. */
+static uint64_t ullBestNs[ benchOPERATIONS ];
+static uint8_t ucIsMalloc[ benchOPERATIONS ];
+
+static void prvReplayTrace( const BenchTrace_t *pxTrace, BaseType_t xFirstPass, uint32_t *pulLive, uint32_t *pulFailed )
+{
+uint32_t ulOp, ulSlot, ulLive = 0, ulFailed = 0;
+uint64_t ullStart, ullNs;
+size_t xSize;
+
+	ulBenchSeed = 0x5EED1234UL;
+
+	for( ulOp = 0; ulOp < benchOPERATIONS; ulOp++ )
+	{
+		ulSlot = prvRand() % benchLIVE_SLOTS;
+		ullNs = UINT64_MAX;
+
+		/* Allocate more often while below the live target, free more often
+		above it, so the heap settles into a steady, fragmented state. */
+		if( ( pvLive[ ulSlot ] == NULL ) && ( ( ulLive < pxTrace->ulLiveTarget ) || ( ( prvRand() % 4 ) == 0 ) ) )
+		{
+			xSize = prvPickSize( pxTrace );
+
+			ullStart = prvNowNs();
+			pvLive[ ulSlot ] = pvPortMalloc( xSize );
+			ullNs = prvNowNs() - ullStart;
+			ucIsMalloc[ ulOp ] = 1;
+
+			if( pvLive[ ulSlot ] != NULL )
+			{
+				/* Touch the block so a broken allocator shows up as corruption
+				rather than as a fast result. */
+				memset( pvLive[ ulSlot ], ( int ) ulSlot, xSize );
+				ulLive++;
+			}
+			else
+			{
+				ulFailed++;
+			}
+		}
+		else if( pvLive[ ulSlot ] != NULL )
+		{
+			ullStart = prvNowNs();
+			vPortFree( pvLive[ ulSlot ] );
+			ullNs = prvNowNs() - ullStart;
+			ucIsMalloc[ ulOp ] = 0;
+
+			pvLive[ ulSlot ] = NULL;
+			ulLive--;
+		}
+
+		if( ( xFirstPass != pdFALSE ) || ( ullNs < ullBestNs[ ulOp ] ) )
+		{
+			ullBestNs[ ulOp ] = ullNs;
+		}
+	}
+
+	*pulLive = ulLive;
+	*pulFailed = ulFailed;
+}
+/*-----------------------------------------------------------*/
+
+static void prvReleaseAll( void )
+{
+uint32_t ulSlot;
+
+	for( ulSlot = 0; ulSlot < benchLIVE_SLOTS; ulSlot++ )
+	{
+		if( pvLive[ ulSlot ] != NULL )
+		{
+			vPortFree( pvLive[ ulSlot ] );
+			pvLive[ ulSlot ] = NULL;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunTrace( const BenchTrace_t *pxTrace )
+{
+uint32_t ulOp, ulRepeat, ulLive = 0, ulFailed = 0;
+HeapStats_t xStats;
+
+	memset( &xMallocLatency, 0, sizeof( xMallocLatency ) );
+	memset( &xFreeLatency, 0, sizeof( xFreeLatency ) );
+
+	for( ulRepeat = 0; ulRepeat < benchREPEATS; ulRepeat++ )
+	{
+		prvReplayTrace( pxTrace, ( ulRepeat == 0 ) ? pdTRUE : pdFALSE, &ulLive, &ulFailed );
+
+		if( ulRepeat == ( benchREPEATS - 1 ) )
+		{
+			vPortGetHeapStats( &xStats );
+		}
+
+		/* Return everything so the next replay starts from an empty heap. */
+		prvReleaseAll();
+	}
+
+	for( ulOp = 0; ulOp < benchOPERATIONS; ulOp++ )
+	{
+		if( ullBestNs[ ulOp ] != UINT64_MAX )
+		{
+			prvRecord( ucIsMalloc[ ulOp ] ? &xMallocLatency : &xFreeLatency, ullBestNs[ ulOp ] );
+		}
+	}
+
+	printf( "%-14s malloc n=%-7u mean=%5lluns p99.9=%5lluns worst=%7lluns\n", pxTrace->pcName,
+			( unsigned ) xMallocLatency.ulCount,
+			( unsigned long long ) ( xMallocLatency.ullTotal / ( xMallocLatency.ulCount ? xMallocLatency.ulCount : 1 ) ),
+			( unsigned long long ) prvPercentile( &xMallocLatency, 999 ),
+			( unsigned long long ) xMallocLatency.ullWorst );
+	printf( "%-14s free   n=%-7u mean=%5lluns p99.9=%5lluns worst=%7lluns\n", "",
+			( unsigned ) xFreeLatency.ulCount,
+			( unsigned long long ) ( xFreeLatency.ullTotal / ( xFreeLatency.ulCount ? xFreeLatency.ulCount : 1 ) ),
+			( unsigned long long ) prvPercentile( &xFreeLatency, 999 ),
+			( unsigned long long ) xFreeLatency.ullWorst );
+	printf( "%-14s live=%u failed=%u free=%lu largest=%lu free-blocks=%lu fragmentation=%lu%%\n", "",
+			( unsigned ) ulLive, ( unsigned ) ulFailed,
+			( unsigned long ) xStats.xAvailableHeapSpaceInBytes,
+			( unsigned long ) xStats.xSizeOfLargestFreeBlockInBytes,
+			( unsigned long ) xStats.xNumberOfFreeBlocks,
+			( unsigned long ) xStats.uxFragmentationPercent );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+size_t x;
+
+	printf( "heap: %s, %lu bytes\n", ( configUSE_TLSF_HEAP == 1 ) ? "heap_tlsf.c (TLSF)" : "heap.c (first fit)", ( unsigned long ) configTOTAL_HEAP_SIZE );
+
+	for( x = 0; x < sizeof( xTraces ) / sizeof( xTraces[ 0 ] ); x++ )
+	{
+		prvRunTrace( &xTraces[ x ] );
+	}
+
+	return 0;
+}
@@ -0,0 +1,198 @@
+/*
+ * Interrupt latency demonstration on the host simulated port.
+ *
+ * Runs the relay's interrupt load - the tick, the push buttons, the PS/2
+ * keyboard and the 50Hz frequency analyser, each waking a task - for
+ * simDURATION_TICKS simulated ticks and reports, for each interrupt, the time
+ * from the line being raised to its handler being called.  The same source is
+ * built with simNESTED_INTERRUPTS 0, where every interrupt has the tick's
+ * priority and a handler runs to completion before the next one is taken, and
+ * 1, where the frequency analyser is given a higher priority than the keyboard
+ * and buttons, as Relay.c does, and so can interrupt their handlers.
+ *
+ * Handler and task costs are simulated cycles chosen to be of the order of
+ * the relay's, not measurements of it, as are the entry and exit costs the
+ * simulated port charges (portSIM_INTERRUPT_ENTRY_CYCLES and the rest).  The
+ * latency includes the interrupt's own entry and, with nesting, the mask and
+ * status writes before its handler, so the nested build pays for the
+ * bookkeeping that lets it preempt.
+ */
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "sys/alt_irq.h"
+
+#ifndef simNESTED_INTERRUPTS
+	#define simNESTED_INTERRUPTS	1
+#endif
+
+/* Simulated run time. */
+#define simDURATION_TICKS		( ( TickType_t ) 10000 )
+
+#define simCYCLES_PER_US		( TIMER1MS_FREQ / 1000000 )
+
+/* Priorities given to the interrupts in the nested build, as in Relay.c. */
+#define simKEY_IRQ_PRIORITY			2
+#define simFREQUENCY_IRQ_PRIORITY	configMAX_SYSCALL_INTERRUPT_PRIORITY
+
+/* Cycles a task spends in a critical section each time it runs, standing for
+the kernel's and the relay's own. */
+#define simCRITICAL_CYCLES		500
+
+#define simSTACK_DEPTH			( 256 )
+
+typedef struct
+{
+	const char *pcName;
+	uint32_t ulIrq;
+	uint64_t ullPeriod;			/* Cycles between interrupts, none of them a multiple of the tick. */
+	uint64_t ullPhase;
+	uint32_t ulHandlerCycles;
+	uint32_t ulTaskCycles;
+	UBaseType_t uxTaskPriority;
+	TaskHandle_t xTask;
+} SimSource_t;
+
+static SimSource_t xSimSources[] =
+{
+	{ "button",	PUSH_BUTTON_IRQ,		5000011,	777777,		300,	2000,	4, NULL },
+	{ "ps2",	PS2_IRQ,				130007,		55555,		6000,	10000,	4, NULL },
+	{ "freq",	FREQUENCY_ANALYSER_IRQ,	2000000,	1234567,	1500,	20000,	5, NULL },
+};
+#define simSOURCE_COUNT	( sizeof( xSimSources ) / sizeof( xSimSources[ 0 ] ) )
+
+static StaticTask_t xTaskBuffers[ simSOURCE_COUNT + 2 ];
+static StackType_t xTaskStacks[ simSOURCE_COUNT + 2 ][ simSTACK_DEPTH ];
+static StaticTask_t xIdleTaskBuffer, xTimerTaskBuffer;
+static StackType_t xIdleTaskStack[ simSTACK_DEPTH ], xTimerTaskStack[ simSTACK_DEPTH ];
+
+/*-----------------------------------------------------------*/
+
+static void prvSourceISR( void *pvContext, alt_u32 ulId )
+{
+SimSource_t *pxSource = ( SimSource_t * ) pvContext;
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	( void ) ulId;
+
+	vPortSimConsume( pxSource->ulHandlerCycles );
+	vTaskNotifyGiveFromISR( pxSource->xTask, &xHigherPriorityTaskWoken );
+	portEND_SWITCHING_ISR( xHigherPriorityTaskWoken );
+}
+/*-----------------------------------------------------------*/
+
+static void prvSourceTask( void *pvParameters )
+{
+SimSource_t *pxSource = ( SimSource_t * ) pvParameters;
+
+	for( ;; )
+	{
+		ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+		vPortSimConsume( pxSource->ulTaskCycles );
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* Polls every 10ms like loadManagerTask, with a critical section each time. */
+static void prvPollTask( void *pvParameters )
+{
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		vTaskDelay( 10 );
+
+		taskENTER_CRITICAL();
+		vPortSimConsume( simCRITICAL_CYCLES );
+		taskEXIT_CRITICAL();
+
+		vPortSimConsume( 30000 );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvControlTask( void *pvParameters )
+{
+uint32_t ul, ulIrqs[ simSOURCE_COUNT + 1 ], ulCount;
+const char *pcNames[ simSOURCE_COUNT + 1 ];
+
+	( void ) pvParameters;
+
+	for( ul = 0; ul < simSOURCE_COUNT; ul++ )
+	{
+		alt_irq_register( xSimSources[ ul ].ulIrq, &( xSimSources[ ul ] ), prvSourceISR );
+		vPortSimSetPeriodicInterrupt( xSimSources[ ul ].ulIrq, xSimSources[ ul ].ullPeriod, xSimSources[ ul ].ullPhase );
+	}
+
+	#if( simNESTED_INTERRUPTS == 1 )
+	{
+		vPortSetInterruptPriority( PUSH_BUTTON_IRQ, simKEY_IRQ_PRIORITY );
+		vPortSetInterruptPriority( PS2_IRQ, simKEY_IRQ_PRIORITY );
+		vPortSetInterruptPriority( FREQUENCY_ANALYSER_IRQ, simFREQUENCY_IRQ_PRIORITY );
+	}
+	#endif
+
+	vTaskDelay( simDURATION_TICKS );
+
+	ulIrqs[ 0 ] = TIMER1MS_IRQ;
+	pcNames[ 0 ] = "tick";
+	for( ul = 0; ul < simSOURCE_COUNT; ul++ )
+	{
+		ulIrqs[ ul + 1 ] = xSimSources[ ul ].ulIrq;
+		pcNames[ ul + 1 ] = xSimSources[ ul ].pcName;
+	}
+
+	printf( "interrupt latency: %s\n", ( simNESTED_INTERRUPTS == 1 ) ? "nested by priority" : "not nested" );
+	printf( "  %-8s %8s %10s %10s\n", "irq", "n", "avg (us)", "max (us)" );
+	for( ul = 0; ul < simSOURCE_COUNT + 1; ul++ )
+	{
+		ulCount = ulPortSimGetInterruptCount( ulIrqs[ ul ] );
+		printf( "  %-8s %8lu %10.2f %10.2f\n", pcNames[ ul ], ( unsigned long ) ulCount,
+				ulCount ? ( double ) ullPortSimGetInterruptLatencyTotal( ulIrqs[ ul ] ) / ( ( double ) ulCount * simCYCLES_PER_US ) : 0.0,
+				( double ) ullPortSimGetInterruptLatencyMax( ulIrqs[ ul ] ) / simCYCLES_PER_US );
+	}
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationIdleHook( void )
+{
+	vPortSimConsume( 1000 );
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint16_t *pusIdleTaskStackSize )
+{
+	*ppxIdleTaskTCBBuffer = &xIdleTaskBuffer;
+	*ppxIdleTaskStackBuffer = xIdleTaskStack;
+	*pusIdleTaskStackSize = simSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint16_t *pusTimerTaskStackSize )
+{
+	*ppxTimerTaskTCBBuffer = &xTimerTaskBuffer;
+	*ppxTimerTaskStackBuffer = xTimerTaskStack;
+	*pusTimerTaskStackSize = simSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+uint32_t ul;
+
+	for( ul = 0; ul < simSOURCE_COUNT; ul++ )
+	{
+		xSimSources[ ul ].xTask = xTaskCreateStatic( prvSourceTask, xSimSources[ ul ].pcName, simSTACK_DEPTH, &( xSimSources[ ul ] ),
+													 xSimSources[ ul ].uxTaskPriority, xTaskStacks[ ul ], &( xTaskBuffers[ ul ] ) );
+	}
+
+	xTaskCreateStatic( prvPollTask, "poll", simSTACK_DEPTH, NULL, 2, xTaskStacks[ simSOURCE_COUNT ], &( xTaskBuffers[ simSOURCE_COUNT ] ) );
+	xTaskCreateStatic( prvControlTask, "control", simSTACK_DEPTH, NULL, configMAX_PRIORITIES - 1, xTaskStacks[ simSOURCE_COUNT + 1 ], &( xTaskBuffers[ simSOURCE_COUNT + 1 ] ) );
+
+	vTaskStartScheduler();
+
+	return 0;
+}
@@ -0,0 +1,180 @@
+/*
+ * Host benchmark for compile time log filtering (logENABLED() in logger.h).
+ *
+ * Built once per configLOG_LEVEL.  The messages below are the load manager's,
+ * written with the same level and subsystem as in Relay.c, and the hot path is
+ * the work loadManagerTask does as the slide switches move and the relay sheds
+ * and reconnects: loadUpdater() checking five loads, a shed, a reconnect and a
+ * stability timer expiry.  The file is compiled at -O0, as the Nios II
+ * application is, so the Makefile's size of its object shows what each level
+ * leaves in the image at the optimisation the board build uses.
+ *
+ * The bench prints host nanoseconds per hot path pass, the fastest batch of
+ * benchBATCHES, with messages going to the deferred logger (logger.c) and a
+ * drain task that empties the ring between batches without printing.  It
+ * also prints how many records a pass produced, which is 0 when every message
+ * on the path is filtered out.
+ */
+#include <stdio.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "logger.h"
+
+/* As Relay.c numbers them. */
+#define LOG_LOAD_MANAGER 0x01
+#define LOG_KEYBOARD 0x02
+#define LOG_VGA 0x04
+#define LOG_TIMER 0x08
+
+#define LOG_AT(level, subsystem, ...) do { if (logENABLED(level, subsystem)) { vLogPrintf(__VA_ARGS__); } } while (0)
+#define LOG_WARN(subsystem, ...) LOG_AT(logLEVEL_WARN, subsystem, __VA_ARGS__)
+#define LOG_INFO(subsystem, ...) LOG_AT(logLEVEL_INFO, subsystem, __VA_ARGS__)
+#define LOG_DEBUG(subsystem, ...) LOG_AT(logLEVEL_DEBUG, subsystem, __VA_ARGS__)
+
+#define benchLOADS			5
+#define benchPASSES			4
+#define benchBATCHES		20000
+
+#define benchSTACK_DEPTH	( 256 )
+
+static StaticTask_t xBenchTaskBuffer, xDrainTaskBuffer, xIdleTaskBuffer, xTimerTaskBuffer;
+static StackType_t xBenchTaskStack[ benchSTACK_DEPTH ], xDrainTaskStack[ benchSTACK_DEPTH ], xIdleTaskStack[ benchSTACK_DEPTH ], xTimerTaskStack[ benchSTACK_DEPTH ];
+static TaskHandle_t xBenchTask, xDrainTask;
+
+static const char * const pcLevelNames[] = { "none", "error", "warn", "info", "debug" };
+
+/* The relay's load state, as loadUpdater() and shedLoad() keep it. */
+static uint8_t ucSwitches[ benchLOADS ];
+static volatile uint8_t ucLoadStatus = 0x1F;
+
+static uint32_t ulDrained;
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNowNs( void )
+{
+struct timespec xNow;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+/* loadUpdater(): every load whose switch moved is followed and reported. */
+static void prvLoadUpdater( void )
+{
+int i;
+
+	for( i = 0; i < benchLOADS; i++ )
+	{
+		if( ucSwitches[ i ] != ( ( ucLoadStatus >> i ) & 1U ) )
+		{
+			LOG_DEBUG( LOG_LOAD_MANAGER, "Load ID: %d\n isTurnON: %d\n", 1 << i, ucSwitches[ i ] );
+			ucLoadStatus ^= ( uint8_t ) ( 1U << i );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvHotPath( uint32_t ulPass )
+{
+int i;
+
+	/* Move every switch, as toggling them all does. */
+	for( i = 0; i < benchLOADS; i++ )
+	{
+		ucSwitches[ i ] = ( uint8_t ) ( ( ulPass + 1U ) & 1U );
+	}
+	prvLoadUpdater();
+
+	LOG_INFO( LOG_LOAD_MANAGER, "Shed Load: %d\n", ( int ) ( ulPass % benchLOADS ) );
+	LOG_INFO( LOG_LOAD_MANAGER, "\n################LOAD MANAGER MODE##########################\n" );
+	LOG_DEBUG( LOG_TIMER, "#######TIMER EXPIRY BEFORE NEW INPUT RECEIVED#####\n" );
+	LOG_INFO( LOG_LOAD_MANAGER, "Reconnected Load: %d\n", ( int ) ( ulPass % benchLOADS ) );
+	if( ucLoadStatus == 0 )
+	{
+		LOG_WARN( LOG_LOAD_MANAGER, "\n ############ ATTEMPT TO DISCONNECT LOAD ERROR: ALL LOADS ARE ALREADY DISCONNECTED##### \n" );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvDrainTask( void *pvParameters )
+{
+LogRecord_t xRecord;
+
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+		while( xLogRead( &xRecord ) != pdFALSE )
+		{
+			ulDrained++;
+		}
+
+		xTaskNotifyGive( xBenchTask );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchTask( void *pvParameters )
+{
+uint64_t ullStart, ullTime, ullBest = UINT64_MAX;
+uint32_t ulBatch, ulPass;
+
+	( void ) pvParameters;
+
+	for( ulBatch = 0; ulBatch < benchBATCHES; ulBatch++ )
+	{
+		ullStart = prvNowNs();
+		for( ulPass = 0; ulPass < benchPASSES; ulPass++ )
+		{
+			prvHotPath( ( ulBatch * benchPASSES ) + ulPass );
+		}
+		ullTime = prvNowNs() - ullStart;
+		if( ullTime < ullBest )
+		{
+			ullBest = ullTime;
+		}
+
+		/* Let the drain task empty the ring, as between bursts of switching. */
+		xTaskNotifyGive( xDrainTask );
+		ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+	}
+
+	printf( "Log level %-5s  %6.1f ns per hot path pass, %4.1f records per pass, %lu dropped (host, fastest batch of %d)\n",
+			pcLevelNames[ configLOG_LEVEL ], ( double ) ullBest / benchPASSES,
+			( double ) ulDrained / ( ( double ) benchBATCHES * benchPASSES ), ( unsigned long ) ulLogGetDropped(), benchBATCHES );
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint16_t *pusIdleTaskStackSize )
+{
+	*ppxIdleTaskTCBBuffer = &xIdleTaskBuffer;
+	*ppxIdleTaskStackBuffer = xIdleTaskStack;
+	*pusIdleTaskStackSize = benchSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint16_t *pusTimerTaskStackSize )
+{
+	*ppxTimerTaskTCBBuffer = &xTimerTaskBuffer;
+	*ppxTimerTaskStackBuffer = xTimerTaskStack;
+	*pusTimerTaskStackSize = benchSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	xBenchTask = xTaskCreateStatic( prvBenchTask, "bench", benchSTACK_DEPTH, NULL, 2, xBenchTaskStack, &xBenchTaskBuffer );
+	xDrainTask = xTaskCreateStatic( prvDrainTask, "drain", benchSTACK_DEPTH, NULL, 1, xDrainTaskStack, &xDrainTaskBuffer );
+
+	vTaskStartScheduler();
+
+	return 0;
+}
@@ -0,0 +1,295 @@
+/*
+ * Host benchmark for the deferred logger (logger.c) against formatting a
+ * message where it happens, for the messages the load manager logs.
+ *
+ * Runs on the simulated port with a drain task below the bench task, the way
+ * Relay.c runs logDrainTask below loadManagerTask.  Each message is timed
+ * three ways, in batches of benchBATCH calls:
+ *
+ *  - deferred: vLogPrintf(), which only records the format and arguments.  The
+ *    first call of each batch finds the ring empty and wakes the drain task,
+ *    so the figure includes one xTaskNotifyGive() per batch.
+ *  - snprintf: formatting the message into a buffer, the least printf() does.
+ *  - fprintf: formatting and writing it to /dev/null unbuffered, one write()
+ *    per message.  /dev/null takes the bytes at once, so this is a lower
+ *    bound for a blocking write to a real device such as the JTAG UART.
+ *
+ * After each deferred batch the bench task blocks, the drain task formats
+ * every record and checks it against snprintf() of the same message, then
+ * wakes the bench task.  Each figure is the fastest batch of benchBATCHES, in
+ * host nanoseconds per message.  Last, the ring is filled past its size with
+ * the drain task held off, to check records are dropped and counted.
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "logger.h"
+
+#define benchBATCH			32
+#define benchBATCHES		20000
+#define benchOVERFILL		8
+
+#define benchSTACK_DEPTH	( 256 )
+
+#if( benchBATCH > configLOG_BUFFER_RECORDS )
+	#error A batch must fit in the log ring.
+#endif
+
+typedef struct
+{
+	const char *pcLabel;
+	const char *pcFormat;
+	uint32_t ulArgs;
+} BenchMessage_t;
+
+/* The load manager's messages, as Relay.c logs them. */
+static const BenchMessage_t xMessages[] =
+{
+	{ "shed load", "Shed Load: %d\n", 1 },
+	{ "load switch", "Load ID: %d\n isTurnON: %d\n", 2 },
+	{ "response time", "Maintenance Mode Response Time: %u\n", 1 },
+	{ "mode banner", "\n################LOAD MANAGER MODE##########################\n", 0 }
+};
+#define benchMESSAGES		( sizeof( xMessages ) / sizeof( xMessages[ 0 ] ) )
+
+static StaticTask_t xBenchTaskBuffer, xDrainTaskBuffer, xIdleTaskBuffer, xTimerTaskBuffer;
+static StackType_t xBenchTaskStack[ benchSTACK_DEPTH ], xDrainTaskStack[ benchSTACK_DEPTH ], xIdleTaskStack[ benchSTACK_DEPTH ], xTimerTaskStack[ benchSTACK_DEPTH ];
+static TaskHandle_t xBenchTask, xDrainTask;
+
+/* The message being drained and the arguments each record was logged with. */
+static const BenchMessage_t *pxDraining;
+static int32_t lSent[ benchBATCH ][ 2 ];
+
+static uint32_t ulDrained, ulMismatches;
+
+static FILE *pxNull;
+
+/* What the drain task formatted last. */
+static char cDrained[ 96 ];
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNowNs( void )
+{
+struct timespec xNow;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+static void prvKeepFastest( uint64_t ullTime, uint64_t *pullBest )
+{
+	if( ullTime < *pullBest )
+	{
+		*pullBest = ullTime;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvFillArguments( uint32_t ulBatch )
+{
+uint32_t ulItem;
+
+	for( ulItem = 0; ulItem < benchBATCH; ulItem++ )
+	{
+		lSent[ ulItem ][ 0 ] = ( int32_t ) ( ( ulBatch + ulItem ) % 5 );
+		lSent[ ulItem ][ 1 ] = ( int32_t ) ( ulItem & 1 );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvLogBatch( const BenchMessage_t *pxMessage )
+{
+uint32_t ulItem;
+
+	/* The argument count is fixed at each call site, as it is in Relay.c. */
+	for( ulItem = 0; ulItem < benchBATCH; ulItem++ )
+	{
+		switch( pxMessage->ulArgs )
+		{
+			case 0:		vLogPrintf( pxMessage->pcFormat ); break;
+			case 1:		vLogPrintf( pxMessage->pcFormat, lSent[ ulItem ][ 0 ] ); break;
+			default:	vLogPrintf( pxMessage->pcFormat, lSent[ ulItem ][ 0 ], lSent[ ulItem ][ 1 ] ); break;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvSnprintfBatch( const BenchMessage_t *pxMessage )
+{
+char cBuffer[ 96 ];
+uint32_t ulItem;
+
+	for( ulItem = 0; ulItem < benchBATCH; ulItem++ )
+	{
+		snprintf( cBuffer, sizeof( cBuffer ), pxMessage->pcFormat, ( int ) lSent[ ulItem ][ 0 ], ( int ) lSent[ ulItem ][ 1 ] );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvFprintfBatch( const BenchMessage_t *pxMessage )
+{
+uint32_t ulItem;
+
+	for( ulItem = 0; ulItem < benchBATCH; ulItem++ )
+	{
+		fprintf( pxNull, pxMessage->pcFormat, ( int ) lSent[ ulItem ][ 0 ], ( int ) lSent[ ulItem ][ 1 ] );
+	}
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Formats into cDrained, so vLogPrintRecord() can be checked.
+ */
+static int prvFormatDrained( const char *pcFormat, ... )
+{
+va_list xArgs;
+int iLength;
+
+	va_start( xArgs, pcFormat );
+	iLength = vsnprintf( cDrained, sizeof( cDrained ), pcFormat, xArgs );
+	va_end( xArgs );
+
+	return iLength;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Stands in for Relay.c's logDrainTask, formatting into a buffer in place of
+ * printf() so every record can be checked.
+ */
+static void prvDrainTask( void *pvParameters )
+{
+LogRecord_t xRecord;
+char cExpected[ 96 ];
+uint32_t ulItem;
+
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+		ulItem = 0;
+		while( xLogRead( &xRecord ) != pdFALSE )
+		{
+			vLogPrintRecord( &xRecord, prvFormatDrained );
+			snprintf( cExpected, sizeof( cExpected ), pxDraining->pcFormat, ( int ) lSent[ ulItem ][ 0 ], ( int ) lSent[ ulItem ][ 1 ] );
+
+			ulDrained++;
+			if( ( ulItem >= benchBATCH ) || ( strcmp( cDrained, cExpected ) != 0 ) )
+			{
+				ulMismatches++;
+			}
+			ulItem++;
+		}
+
+		xTaskNotifyGive( xBenchTask );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchTask( void *pvParameters )
+{
+const BenchMessage_t *pxMessage;
+LogRecord_t xRecord;
+uint64_t ullStart, ullDeferred, ullSnprintf, ullFprintf;
+uint32_t ulMessage, ulBatch, ulItem, ulDroppedBefore;
+
+	( void ) pvParameters;
+
+	printf( "Logging from the control path, ns per message (host, fastest batch of %d)\n", benchBATCHES );
+	printf( "  %-16s %10s %10s %10s\n", "message", "deferred", "snprintf", "fprintf" );
+
+	for( ulMessage = 0; ulMessage < benchMESSAGES; ulMessage++ )
+	{
+		pxMessage = &( xMessages[ ulMessage ] );
+		pxDraining = pxMessage;
+		ullDeferred = UINT64_MAX;
+		ullSnprintf = UINT64_MAX;
+		ullFprintf = UINT64_MAX;
+
+		for( ulBatch = 0; ulBatch < benchBATCHES; ulBatch++ )
+		{
+			prvFillArguments( ulBatch );
+
+			ullStart = prvNowNs();
+			prvLogBatch( pxMessage );
+			prvKeepFastest( prvNowNs() - ullStart, &ullDeferred );
+
+			/* Let the drain task empty and check the ring. */
+			ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+			ullStart = prvNowNs();
+			prvSnprintfBatch( pxMessage );
+			prvKeepFastest( prvNowNs() - ullStart, &ullSnprintf );
+
+			ullStart = prvNowNs();
+			prvFprintfBatch( pxMessage );
+			prvKeepFastest( prvNowNs() - ullStart, &ullFprintf );
+		}
+
+		printf( "  %-16s %10.1f %10.1f %10.1f\n", pxMessage->pcLabel, ( double ) ullDeferred / benchBATCH,
+				( double ) ullSnprintf / benchBATCH, ( double ) ullFprintf / benchBATCH );
+	}
+
+	/* The drain task is below this one, so it cannot run until the ring has
+	been overfilled. */
+	pxDraining = &( xMessages[ 0 ] );
+	ulDroppedBefore = ulLogGetDropped();
+	for( ulItem = 0; ulItem < configLOG_BUFFER_RECORDS + benchOVERFILL; ulItem++ )
+	{
+		vLogPrintf( pxDraining->pcFormat, ulItem );
+	}
+	printf( "  ring of %d, %d logged with the drain task held off: %lu dropped, most held %lu\n",
+			configLOG_BUFFER_RECORDS, configLOG_BUFFER_RECORDS + benchOVERFILL,
+			( unsigned long ) ( ulLogGetDropped() - ulDroppedBefore ), ( unsigned long ) uxLogGetMaximumUsed() );
+
+	/* Empty the ring without checking it. */
+	while( xLogRead( &xRecord ) != pdFALSE )
+	{
+	}
+
+	printf( "  records drained %lu, not as logged %lu\n", ( unsigned long ) ulDrained, ( unsigned long ) ulMismatches );
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint16_t *pusIdleTaskStackSize )
+{
+	*ppxIdleTaskTCBBuffer = &xIdleTaskBuffer;
+	*ppxIdleTaskStackBuffer = xIdleTaskStack;
+	*pusIdleTaskStackSize = benchSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint16_t *pusTimerTaskStackSize )
+{
+	*ppxTimerTaskTCBBuffer = &xTimerTaskBuffer;
+	*ppxTimerTaskStackBuffer = xTimerTaskStack;
+	*pusTimerTaskStackSize = benchSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	pxNull = fopen( "/dev/null", "w" );
+	configASSERT( pxNull );
+	setvbuf( pxNull, NULL, _IONBF, 0 );
+
+	xBenchTask = xTaskCreateStatic( prvBenchTask, "bench", benchSTACK_DEPTH, NULL, 2, xBenchTaskStack, &xBenchTaskBuffer );
+	xDrainTask = xTaskCreateStatic( prvDrainTask, "drain", benchSTACK_DEPTH, NULL, 1, xDrainTaskStack, &xDrainTaskBuffer );
+	vLogSetDrainTask( xDrainTask );
+
+	vTaskStartScheduler();
+
+	fclose( pxNull );
+
+	return 0;
+}
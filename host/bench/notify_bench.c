@@ -0,0 +1,227 @@
+/*
+ * Host benchmark comparing an ISR to task signal sent through a queue with
+ * one sent as a direct to task notification.
+ *
+ * Runs on the simulated port.  Two measurements are taken for each method:
+ *
+ *  - signal/receive: the cost of xQueueSendToBackFromISR() against
+ *    vTaskNotifyGiveFromISR(), and of xQueueReceive() against
+ *    ulTaskNotifyTake(), with no task waiting, in batches of benchBATCH.
+ *  - wake: a full round trip in which the "ISR" signals a blocked higher
+ *    priority task, which runs, takes the signal and blocks again.  This
+ *    includes two host context switches, the same for both methods.
+ *
+ * Each figure is the fastest of benchREPEATS runs, in host nanoseconds per
+ * operation.  The ISR is called directly from the benchmark task with
+ * interrupts masked, which on this port is what an interrupt does.
+ */
+#include <stdio.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+#define benchBATCH			100
+#define benchBATCHES		2000
+#define benchWAKES			200000
+#define benchREPEATS		5
+
+#define benchSTACK_DEPTH	( 256 )
+
+static StaticTask_t xBenchTaskBuffer, xQueueWaiterBuffer, xNotifyWaiterBuffer, xIdleTaskBuffer, xTimerTaskBuffer;
+static StackType_t xBenchTaskStack[ benchSTACK_DEPTH ], xQueueWaiterStack[ benchSTACK_DEPTH ], xNotifyWaiterStack[ benchSTACK_DEPTH ];
+static StackType_t xIdleTaskStack[ benchSTACK_DEPTH ], xTimerTaskStack[ benchSTACK_DEPTH ];
+
+/* Sized and typed like the relay's old key queue.  xWakeQueue has a task
+waiting on it, xSignalQueue does not. */
+static QueueHandle_t xSignalQueue, xWakeQueue;
+static StaticQueue_t xSignalQueueBuffer, xWakeQueueBuffer;
+static uint8_t ucSignalQueueStorage[ benchBATCH * sizeof( unsigned char ) ];
+static uint8_t ucWakeQueueStorage[ benchBATCH * sizeof( unsigned char ) ];
+
+static TaskHandle_t xBenchTask, xQueueWaiter, xNotifyWaiter;
+static volatile uint32_t ulWaiterCount;
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNowNs( void )
+{
+struct timespec xNow;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+static void prvQueueISR( QueueHandle_t xQueue )
+{
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+unsigned char ucKey = 0x5a;
+
+	portDISABLE_INTERRUPTS();
+	xQueueSendToBackFromISR( xQueue, &ucKey, &xHigherPriorityTaskWoken );
+	portENABLE_INTERRUPTS();
+	portEND_SWITCHING_ISR( xHigherPriorityTaskWoken );
+}
+/*-----------------------------------------------------------*/
+
+static void prvNotifyISR( TaskHandle_t xTask )
+{
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	portDISABLE_INTERRUPTS();
+	vTaskNotifyGiveFromISR( xTask, &xHigherPriorityTaskWoken );
+	portENABLE_INTERRUPTS();
+	portEND_SWITCHING_ISR( xHigherPriorityTaskWoken );
+}
+/*-----------------------------------------------------------*/
+
+static void prvQueueWaiterTask( void *pvParameters )
+{
+unsigned char ucKey;
+
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		xQueueReceive( xWakeQueue, &ucKey, portMAX_DELAY );
+		ulWaiterCount++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvNotifyWaiterTask( void *pvParameters )
+{
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		ulTaskNotifyTake( pdFALSE, portMAX_DELAY );
+		ulWaiterCount++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvMin( uint64_t *pullBest, uint64_t ullNs )
+{
+	if( ullNs < *pullBest )
+	{
+		*pullBest = ullNs;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchTask( void *pvParameters )
+{
+uint64_t ullStart, ullQueueSend = UINT64_MAX, ullQueueReceive = UINT64_MAX, ullNotifyGive = UINT64_MAX, ullNotifyTake = UINT64_MAX;
+uint64_t ullQueueSendTotal, ullQueueReceiveTotal, ullNotifyGiveTotal, ullNotifyTakeTotal, ullQueueWake = UINT64_MAX, ullNotifyWake = UINT64_MAX;
+uint32_t ulRepeat, ulBatch, ul;
+unsigned char ucKey;
+
+	( void ) pvParameters;
+
+	for( ulRepeat = 0; ulRepeat < benchREPEATS; ulRepeat++ )
+	{
+		/* Signal and receive with nobody waiting.  The benchmark task
+		notifies itself. */
+		ullQueueSendTotal = ullQueueReceiveTotal = ullNotifyGiveTotal = ullNotifyTakeTotal = 0;
+
+		for( ulBatch = 0; ulBatch < benchBATCHES; ulBatch++ )
+		{
+			ullStart = prvNowNs();
+			for( ul = 0; ul < benchBATCH; ul++ )
+			{
+				prvQueueISR( xSignalQueue );
+			}
+			ullQueueSendTotal += prvNowNs() - ullStart;
+
+			ullStart = prvNowNs();
+			for( ul = 0; ul < benchBATCH; ul++ )
+			{
+				xQueueReceive( xSignalQueue, &ucKey, 0 );
+			}
+			ullQueueReceiveTotal += prvNowNs() - ullStart;
+
+			ullStart = prvNowNs();
+			for( ul = 0; ul < benchBATCH; ul++ )
+			{
+				prvNotifyISR( xBenchTask );
+			}
+			ullNotifyGiveTotal += prvNowNs() - ullStart;
+
+			ullStart = prvNowNs();
+			for( ul = 0; ul < benchBATCH; ul++ )
+			{
+				ulTaskNotifyTake( pdFALSE, 0 );
+			}
+			ullNotifyTakeTotal += prvNowNs() - ullStart;
+		}
+
+		prvMin( &ullQueueSend, ullQueueSendTotal );
+		prvMin( &ullQueueReceive, ullQueueReceiveTotal );
+		prvMin( &ullNotifyGive, ullNotifyGiveTotal );
+		prvMin( &ullNotifyTake, ullNotifyTakeTotal );
+
+		/* Wake a blocked higher priority task each time. */
+		ullStart = prvNowNs();
+		for( ul = 0; ul < benchWAKES; ul++ )
+		{
+			prvQueueISR( xWakeQueue );
+		}
+		prvMin( &ullQueueWake, prvNowNs() - ullStart );
+
+		ullStart = prvNowNs();
+		for( ul = 0; ul < benchWAKES; ul++ )
+		{
+			prvNotifyISR( xNotifyWaiter );
+		}
+		prvMin( &ullNotifyWake, prvNowNs() - ullStart );
+	}
+
+	printf( "ISR to task signal, ns per operation (host, best of %d runs)\n", benchREPEATS );
+	printf( "  %-14s signal %6.1f  receive %6.1f  wake round trip %6.1f\n", "queue",
+			( double ) ullQueueSend / ( benchBATCH * benchBATCHES ),
+			( double ) ullQueueReceive / ( benchBATCH * benchBATCHES ),
+			( double ) ullQueueWake / benchWAKES );
+	printf( "  %-14s signal %6.1f  receive %6.1f  wake round trip %6.1f\n", "notification",
+			( double ) ullNotifyGive / ( benchBATCH * benchBATCHES ),
+			( double ) ullNotifyTake / ( benchBATCH * benchBATCHES ),
+			( double ) ullNotifyWake / benchWAKES );
+	printf( "  waiter wakes %lu of %lu\n", ( unsigned long ) ulWaiterCount, ( unsigned long ) ( 2UL * benchWAKES * benchREPEATS ) );
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint16_t *pusIdleTaskStackSize )
+{
+	*ppxIdleTaskTCBBuffer = &xIdleTaskBuffer;
+	*ppxIdleTaskStackBuffer = xIdleTaskStack;
+	*pusIdleTaskStackSize = benchSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint16_t *pusTimerTaskStackSize )
+{
+	*ppxTimerTaskTCBBuffer = &xTimerTaskBuffer;
+	*ppxTimerTaskStackBuffer = xTimerTaskStack;
+	*pusTimerTaskStackSize = benchSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	xSignalQueue = xQueueCreateStatic( benchBATCH, sizeof( unsigned char ), ucSignalQueueStorage, &xSignalQueueBuffer );
+	xWakeQueue = xQueueCreateStatic( benchBATCH, sizeof( unsigned char ), ucWakeQueueStorage, &xWakeQueueBuffer );
+
+	/* The waiters have the higher priority, like the relay's keyboard and
+	frequency tasks. */
+	xBenchTask = xTaskCreateStatic( prvBenchTask, "bench", benchSTACK_DEPTH, NULL, 1, xBenchTaskStack, &xBenchTaskBuffer );
+	xQueueWaiter = xTaskCreateStatic( prvQueueWaiterTask, "queue", benchSTACK_DEPTH, NULL, 2, xQueueWaiterStack, &xQueueWaiterBuffer );
+	xNotifyWaiter = xTaskCreateStatic( prvNotifyWaiterTask, "notify", benchSTACK_DEPTH, NULL, 2, xNotifyWaiterStack, &xNotifyWaiterBuffer );
+
+	vTaskStartScheduler();
+
+	return 0;
+}
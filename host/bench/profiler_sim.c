@@ -0,0 +1,411 @@
+/*
+ * PC sampling profiler (FreeRTOS/profiler.c) on the host simulated port.
+ *
+ *   profiler_sim profile.txt
+ *
+ * Runs a load shaped like the relay's for simDURATION_TICKS ticks with the
+ * profiler sampling on every tick, then writes its dump to profile.txt for
+ * host/tools/profile_fold.  The load, in simulated cycles chosen to be of the
+ * order of the relay's and not measured from it:
+ *  - a frequency analyser interrupt every 13ms whose handler wakes a load
+ *    manager task, and a PS/2 interrupt below it in priority, so the first can
+ *    nest on the second.  Neither period is close to a multiple of the tick,
+ *    or each would always arrive at the same point between two ticks and get
+ *    all or none of the samples;
+ *  - a VGA task that draws a frame of 40 points every 20 ticks, each point a
+ *    soft float multiply and a line draw;
+ *  - a short job every 10 ticks that starts on the tick and is done well
+ *    before the next one;
+ *  - the idle task.
+ *
+ * Every cycle is spent in a vPortSimConsume() call made from one of the
+ * functions below, so the cycles each task and interrupt used are known
+ * exactly.  The dump is read back and each one's share of the samples
+ * compared with its share of the cycles.  A difference over four standard
+ * deviations of the sampling error, plus half a percent, fails, except for
+ * the short job, which sampling on the tick cannot see and which is only
+ * printed; its share is expected to show up in the idle task's.  Also prints
+ * the host time a sample takes.
+ *
+ * Built with -fno-optimize-sibling-calls, as a tail call to vPortSimConsume()
+ * would leave the caller's caller as the return address the port samples.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "profiler.h"
+#include "sys/alt_irq.h"
+
+/* Simulated run time. */
+#define simDURATION_TICKS		( ( TickType_t ) 20000 )
+
+#define simFREQUENCY_PERIOD		1313171ULL
+#define simFREQUENCY_CYCLES		40000
+#define simPS2_PERIOD			703013ULL
+#define simPS2_CYCLES			20000
+#define simLOAD_CYCLES			60000
+#define simPOINTS				40
+#define simMULTIPLY_CYCLES		9000
+#define simLINE_CYCLES			6000
+#define simFRAME_TICKS			( ( TickType_t ) 20 )
+#define simJOB_CYCLES			30000
+#define simJOB_TICKS			( ( TickType_t ) 10 )
+#define simIDLE_CYCLES			1000
+
+/* As Relay.c. */
+#define simKEY_IRQ_PRIORITY			2
+#define simFREQUENCY_IRQ_PRIORITY	configMAX_SYSCALL_INTERRUPT_PRIORITY
+
+#define simSTACK_DEPTH			( 256 )
+
+#define simHOST_SAMPLES			1000000UL
+
+/* What each part of the load spent, and the samples it got. */
+typedef enum
+{
+	eSimVga = 0,
+	eSimLoad,
+	eSimJob,
+	eSimIdle,
+	eSimFrequencyISR,
+	eSimPs2ISR,
+	eSimParts
+} SimPart_t;
+
+static const char * const pcSimPartNames[ eSimParts ] = { "vgaTask", "loadTask", "tickJob", "IDLE", "frequency ISR", "ps2 ISR" };
+
+static uint64_t ullSimCycles[ eSimParts ];
+static uint32_t ulSimSamples[ eSimParts ];
+
+static StaticTask_t xVgaTaskBuffer, xLoadTaskBuffer, xJobTaskBuffer, xControlTaskBuffer, xIdleTaskBuffer, xTimerTaskBuffer;
+static StackType_t xVgaTaskStack[ simSTACK_DEPTH ], xLoadTaskStack[ simSTACK_DEPTH ], xJobTaskStack[ simSTACK_DEPTH ], xControlTaskStack[ simSTACK_DEPTH ],
+	xIdleTaskStack[ simSTACK_DEPTH ], xTimerTaskStack[ simSTACK_DEPTH ];
+static TaskHandle_t xLoadTask;
+
+static FILE *pxDumpFile;
+
+/*-----------------------------------------------------------*/
+
+static void prvSpend( SimPart_t ePart, uint32_t ulCycles )
+{
+	ullSimCycles[ ePart ] += ulCycles;
+}
+/*-----------------------------------------------------------*/
+
+/* The functions the samples should land in.  noinline, so each has its own
+call to vPortSimConsume() and its own PCs. */
+static void __attribute__( ( noinline ) ) prvFrequencyAnalyserISR( void *pvContext, alt_u32 ulId )
+{
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	( void ) pvContext;
+	( void ) ulId;
+
+	prvSpend( eSimFrequencyISR, simFREQUENCY_CYCLES );
+	vPortSimConsume( simFREQUENCY_CYCLES );
+	vTaskNotifyGiveFromISR( xLoadTask, &xHigherPriorityTaskWoken );
+	portEND_SWITCHING_ISR( xHigherPriorityTaskWoken );
+}
+/*-----------------------------------------------------------*/
+
+static void __attribute__( ( noinline ) ) prvPs2ISR( void *pvContext, alt_u32 ulId )
+{
+	( void ) pvContext;
+	( void ) ulId;
+
+	prvSpend( eSimPs2ISR, simPS2_CYCLES );
+	vPortSimConsume( simPS2_CYCLES );
+}
+/*-----------------------------------------------------------*/
+
+static void __attribute__( ( noinline ) ) prvCheckThresholds( void )
+{
+	prvSpend( eSimLoad, simLOAD_CYCLES );
+	vPortSimConsume( simLOAD_CYCLES );
+}
+/*-----------------------------------------------------------*/
+
+/* Stands in for the soft float routines. */
+static void __attribute__( ( noinline ) ) prvSoftFloatMultiply( void )
+{
+	prvSpend( eSimVga, simMULTIPLY_CYCLES );
+	vPortSimConsume( simMULTIPLY_CYCLES );
+}
+/*-----------------------------------------------------------*/
+
+static void __attribute__( ( noinline ) ) prvDrawLine( void )
+{
+	prvSpend( eSimVga, simLINE_CYCLES );
+	vPortSimConsume( simLINE_CYCLES );
+}
+/*-----------------------------------------------------------*/
+
+static void __attribute__( ( noinline ) ) prvShortJob( void )
+{
+	prvSpend( eSimJob, simJOB_CYCLES );
+	vPortSimConsume( simJOB_CYCLES );
+}
+/*-----------------------------------------------------------*/
+
+static void prvVgaTask( void *pvParameters )
+{
+int iPoint;
+
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		for( iPoint = 0; iPoint < simPOINTS; iPoint++ )
+		{
+			prvSoftFloatMultiply();
+			prvDrawLine();
+		}
+		vTaskDelay( simFRAME_TICKS );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvLoadTask( void *pvParameters )
+{
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+		prvCheckThresholds();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvJobTask( void *pvParameters )
+{
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		vTaskDelay( simJOB_TICKS );
+		prvShortJob();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static int prvDumpPrint( const char *pcFormat, ... )
+{
+va_list xArgs;
+int iWritten;
+
+	va_start( xArgs, pcFormat );
+	iWritten = vfprintf( pxDumpFile, pcFormat, xArgs );
+	va_end( xArgs );
+
+	return iWritten;
+}
+/*-----------------------------------------------------------*/
+
+/* Reads the dump back, as profile_fold would, and counts the samples of each
+part of the load.  Tasks are told apart by the names in the dump. */
+static uint32_t prvReadDump( const char *pcPath )
+{
+FILE *pxFile = fopen( pcPath, "r" );
+char cLine[ 128 ], cName[ configMAX_TASK_NAME_LEN + 1 ];
+unsigned uTask, uInterrupt;
+unsigned long ulPC, ulCount;
+uint32_t ulTotal = 0;
+SimPart_t ePart, eTaskParts[ 256 ];
+
+	for( uTask = 0; uTask < 256; uTask++ )
+	{
+		eTaskParts[ uTask ] = eSimIdle;
+	}
+
+	if( pxFile == NULL )
+	{
+		perror( pcPath );
+		exit( 1 );
+	}
+
+	while( fgets( cLine, sizeof( cLine ), pxFile ) != NULL )
+	{
+		if( ( sscanf( cLine, "T %u %8s", &uTask, cName ) == 2 ) && ( uTask < 256 ) )
+		{
+			for( ePart = eSimVga; ePart < eSimIdle; ePart++ )
+			{
+				if( strncmp( cName, pcSimPartNames[ ePart ], configMAX_TASK_NAME_LEN - 1 ) == 0 )
+				{
+					eTaskParts[ uTask ] = ePart;
+				}
+			}
+			continue;
+		}
+
+		if( sscanf( cLine, "S %x %x %lx %lu", &uTask, &uInterrupt, &ulPC, &ulCount ) != 4 )
+		{
+			continue;
+		}
+
+		if( uInterrupt == FREQUENCY_ANALYSER_IRQ )
+		{
+			ePart = eSimFrequencyISR;
+		}
+		else if( uInterrupt == PS2_IRQ )
+		{
+			ePart = eSimPs2ISR;
+		}
+		else
+		{
+			ePart = eTaskParts[ uTask & 0xFFU ];
+		}
+
+		ulSimSamples[ ePart ] += ( uint32_t ) ulCount;
+		ulTotal += ( uint32_t ) ulCount;
+	}
+
+	fclose( pxFile );
+	return ulTotal;
+}
+/*-----------------------------------------------------------*/
+
+static void prvControlTask( void *pvParameters )
+{
+	( void ) pvParameters;
+
+	alt_irq_register( FREQUENCY_ANALYSER_IRQ, NULL, prvFrequencyAnalyserISR );
+	alt_irq_register( PS2_IRQ, NULL, prvPs2ISR );
+	vPortSetInterruptPriority( FREQUENCY_ANALYSER_IRQ, simFREQUENCY_IRQ_PRIORITY );
+	vPortSetInterruptPriority( PS2_IRQ, simKEY_IRQ_PRIORITY );
+	vPortSimSetPeriodicInterrupt( FREQUENCY_ANALYSER_IRQ, simFREQUENCY_PERIOD, 123457ULL );
+	vPortSimSetPeriodicInterrupt( PS2_IRQ, simPS2_PERIOD, 345679ULL );
+
+	/* Only what runs from here on is counted. */
+	vProfilerClear();
+
+	vTaskDelay( simDURATION_TICKS );
+
+	vProfilerStop();
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationIdleHook( void )
+{
+	prvSpend( eSimIdle, simIDLE_CYCLES );
+	vPortSimConsume( simIDLE_CYCLES );
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint16_t *pusIdleTaskStackSize )
+{
+	*ppxIdleTaskTCBBuffer = &xIdleTaskBuffer;
+	*ppxIdleTaskStackBuffer = xIdleTaskStack;
+	*pusIdleTaskStackSize = simSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint16_t *pusTimerTaskStackSize )
+{
+	*ppxTimerTaskTCBBuffer = &xTimerTaskBuffer;
+	*ppxTimerTaskStackBuffer = xTimerTaskStack;
+	*pusTimerTaskStackSize = simSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc, char **argv )
+{
+ProfilerStats_t xStats;
+uint64_t ullTotalCycles = 0, ullCycles;
+uint32_t ulTotalSamples, ul;
+double dExpected, dLimit;
+int iPart, iFailed = 0;
+struct timespec xStart, xEnd;
+
+	if( argc != 2 )
+	{
+		fprintf( stderr, "usage: %s profile.txt\n", argv[ 0 ] );
+		return 2;
+	}
+
+	xTaskCreateStatic( prvVgaTask, "vgaTask", simSTACK_DEPTH, NULL, 1, xVgaTaskStack, &xVgaTaskBuffer );
+	xLoadTask = xTaskCreateStatic( prvLoadTask, "loadTask", simSTACK_DEPTH, NULL, 3, xLoadTaskStack, &xLoadTaskBuffer );
+	xTaskCreateStatic( prvJobTask, "tickJob", simSTACK_DEPTH, NULL, 4, xJobTaskStack, &xJobTaskBuffer );
+	xTaskCreateStatic( prvControlTask, "control", simSTACK_DEPTH, NULL, configMAX_PRIORITIES - 1, xControlTaskStack, &xControlTaskBuffer );
+
+	vTaskStartScheduler();
+
+	pxDumpFile = fopen( argv[ 1 ], "w" );
+	if( pxDumpFile == NULL )
+	{
+		perror( argv[ 1 ] );
+		return 1;
+	}
+	vProfilerDump( prvDumpPrint );
+	fclose( pxDumpFile );
+
+	vProfilerGetStats( &xStats );
+	ulTotalSamples = prvReadDump( argv[ 1 ] );
+
+	for( iPart = 0; iPart < eSimParts; iPart++ )
+	{
+		ullTotalCycles += ullSimCycles[ iPart ];
+	}
+
+	printf( "PC sampling profiler, %lu ticks sampled (host simulation)\n", ( unsigned long ) simDURATION_TICKS );
+	printf( "  %lu samples, %lu in handlers, %lu dropped, %lu of %d buckets used\n", ( unsigned long ) xStats.ulSamples,
+			( unsigned long ) xStats.ulInterruptSamples, ( unsigned long ) xStats.ulDropped, ( unsigned long ) xStats.ulBucketsUsed, configPROFILER_BUCKETS );
+	printf( "  %-14s %9s %9s %9s\n", "", "cycles %", "samples %", "limit %" );
+
+	for( iPart = 0; iPart < eSimParts; iPart++ )
+	{
+		/* The samples the short job should have had go to whatever was
+		running when the tick came, nearly always the idle task. */
+		ullCycles = ullSimCycles[ iPart ];
+		if( iPart == eSimIdle )
+		{
+			ullCycles += ullSimCycles[ eSimJob ];
+		}
+
+		dExpected = ( double ) ulTotalSamples * ( double ) ullCycles / ( double ) ullTotalCycles;
+		dLimit = 4.0 * sqrt( dExpected * ( 1.0 - dExpected / ( double ) ulTotalSamples ) ) + 0.005 * ( double ) ulTotalSamples;
+
+		printf( "  %-14s %9.2f %9.2f %9.2f", pcSimPartNames[ iPart ], 100.0 * ( double ) ullSimCycles[ iPart ] / ( double ) ullTotalCycles,
+				100.0 * ( double ) ulSimSamples[ iPart ] / ( double ) ulTotalSamples, 100.0 * dLimit / ( double ) ulTotalSamples );
+
+		if( iPart == eSimJob )
+		{
+			printf( "  starts on the tick, not checked\n" );
+		}
+		else if( fabs( ( double ) ulSimSamples[ iPart ] - dExpected ) > dLimit )
+		{
+			printf( "  FAILED\n" );
+			iFailed = 1;
+		}
+		else
+		{
+			printf( "\n" );
+		}
+	}
+
+	if( ( ulTotalSamples != xStats.ulSamples ) || ( xStats.ulDropped != 0 ) )
+	{
+		printf( "  FAILED: the dump holds %lu samples\n", ( unsigned long ) ulTotalSamples );
+		iFailed = 1;
+	}
+
+	/* Host time for a sample that finds its bucket, the common case. */
+	vProfilerStart();
+	clock_gettime( CLOCK_MONOTONIC, &xStart );
+	for( ul = 0; ul < simHOST_SAMPLES; ul++ )
+	{
+		vProfilerSampleFromISR( ( uintptr_t ) prvDrawLine + ( ( ul & 7UL ) << 2 ) );
+	}
+	clock_gettime( CLOCK_MONOTONIC, &xEnd );
+	printf( "  vProfilerSampleFromISR() %.1f ns on the host\n",
+			( ( double ) ( xEnd.tv_sec - xStart.tv_sec ) * 1e9 + ( double ) ( xEnd.tv_nsec - xStart.tv_nsec ) ) / ( double ) simHOST_SAMPLES );
+
+	return iFailed;
+}
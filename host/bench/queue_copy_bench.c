@@ -0,0 +1,278 @@
+/*
+ * Host benchmark for the cost of passing an item through a queue, by size,
+ * built once with the queue's generic memcpy() item copy and once with the
+ * word copies for 4, 8, 12 and 16 byte items (configUSE_QUEUE_SIZED_COPY).
+ *
+ * Runs on the simulated port.  For each item size a task sends benchBATCH
+ * items to a queue with xQueueSendToBack() and then takes them all back with
+ * xQueueReceive(), neither blocking, and the two halves are timed separately.
+ * The last row passes a pooled record by reference instead: pvPoolGet() and
+ * xPoolSendToQueue() to send, pvPoolReceiveFromQueue() and vPoolPut() to
+ * receive, so the queue only ever copies a pointer whatever the record's size.
+ *
+ * Every item received is compared with the one sent, outside the timing.  A
+ * queue operation costs far more on the host than copying a few words, so
+ * each figure is the fastest batch of benchBATCHES * benchREPEATS, in host
+ * nanoseconds per item, to keep the copy from being lost in the noise.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "pool.h"
+
+#define benchBATCH			32
+#define benchBATCHES		20000
+#define benchREPEATS		5
+
+/* The largest item, in words, and the size of the pooled record. */
+#define benchMAX_WORDS		64
+#define benchRECORD_SIZE	64
+
+#define benchSTACK_DEPTH	( 256 )
+
+static const UBaseType_t uxItemSizes[] = { 4, 8, 12, 16, 24, 64, 256 };
+#define benchSIZES			( sizeof( uxItemSizes ) / sizeof( uxItemSizes[ 0 ] ) )
+
+static StaticTask_t xBenchTaskBuffer, xIdleTaskBuffer, xTimerTaskBuffer;
+static StackType_t xBenchTaskStack[ benchSTACK_DEPTH ], xIdleTaskStack[ benchSTACK_DEPTH ], xTimerTaskStack[ benchSTACK_DEPTH ];
+
+/* One queue per item size, plus one of pointers for the pooled records.
+Storage is declared as words so it is aligned the way Relay.c's is. */
+static QueueHandle_t xQueues[ benchSIZES ], xReferenceQueue;
+static StaticQueue_t xQueueBuffers[ benchSIZES ], xReferenceQueueBuffer;
+static uint32_t ulQueueStorage[ benchSIZES ][ benchBATCH * benchMAX_WORDS ];
+static void *pvReferenceQueueStorage[ benchBATCH ];
+
+static PoolHandle_t xRecordPool;
+
+/* Items sent and received in one batch. */
+static uint32_t ulSent[ benchBATCH ][ benchMAX_WORDS ];
+static uint32_t ulReceived[ benchBATCH ][ benchMAX_WORDS ];
+static uint32_t *pulReceived[ benchBATCH ];
+
+static uint32_t ulItems, ulMismatches;
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNowNs( void )
+{
+struct timespec xNow;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+static void prvFillBatch( uint32_t ulBatch )
+{
+uint32_t ulItem, ulWord;
+
+	for( ulItem = 0; ulItem < benchBATCH; ulItem++ )
+	{
+		for( ulWord = 0; ulWord < benchMAX_WORDS; ulWord++ )
+		{
+			ulSent[ ulItem ][ ulWord ] = ( ulBatch << 16 ) ^ ( ulItem << 8 ) ^ ulWord;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckBatch( const uint32_t *pulItems[], size_t xSize )
+{
+uint32_t ulItem;
+
+	for( ulItem = 0; ulItem < benchBATCH; ulItem++ )
+	{
+		ulItems++;
+		if( memcmp( pulItems[ ulItem ], ulSent[ ulItem ], xSize ) != 0 )
+		{
+			ulMismatches++;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Keeps the fastest batch time seen in *pullBest.
+ */
+static void prvKeepFastest( uint64_t ullTime, uint64_t *pullBest )
+{
+	if( ullTime < *pullBest )
+	{
+		*pullBest = ullTime;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvTimeCopies( UBaseType_t uxSize, QueueHandle_t xQueue, uint64_t *pullSend, uint64_t *pullReceive )
+{
+const uint32_t *pulItems[ benchBATCH ];
+uint64_t ullStart;
+uint32_t ulBatch, ulItem;
+
+	for( ulItem = 0; ulItem < benchBATCH; ulItem++ )
+	{
+		pulItems[ ulItem ] = ulReceived[ ulItem ];
+	}
+
+	for( ulBatch = 0; ulBatch < benchBATCHES; ulBatch++ )
+	{
+		prvFillBatch( ulBatch );
+
+		ullStart = prvNowNs();
+		for( ulItem = 0; ulItem < benchBATCH; ulItem++ )
+		{
+			xQueueSendToBack( xQueue, ulSent[ ulItem ], 0 );
+		}
+		prvKeepFastest( prvNowNs() - ullStart, pullSend );
+
+		ullStart = prvNowNs();
+		for( ulItem = 0; ulItem < benchBATCH; ulItem++ )
+		{
+			xQueueReceive( xQueue, ulReceived[ ulItem ], 0 );
+		}
+		prvKeepFastest( prvNowNs() - ullStart, pullReceive );
+
+		prvCheckBatch( pulItems, ( size_t ) uxSize );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvTimeReferences( uint64_t *pullSend, uint64_t *pullReceive )
+{
+uint64_t ullStart, ullSend, ullReceive;
+uint32_t ulBatch, ulItem;
+uint32_t *pulRecords[ benchBATCH ];
+
+	for( ulBatch = 0; ulBatch < benchBATCHES; ulBatch++ )
+	{
+		prvFillBatch( ulBatch );
+
+		ullStart = prvNowNs();
+		for( ulItem = 0; ulItem < benchBATCH; ulItem++ )
+		{
+			pulRecords[ ulItem ] = pvPoolGet( xRecordPool );
+		}
+		ullSend = prvNowNs() - ullStart;
+
+		/* The producer builds each record in its block, so filling it is not
+		part of passing it on. */
+		for( ulItem = 0; ulItem < benchBATCH; ulItem++ )
+		{
+			memcpy( pulRecords[ ulItem ], ulSent[ ulItem ], benchRECORD_SIZE );
+		}
+
+		ullStart = prvNowNs();
+		for( ulItem = 0; ulItem < benchBATCH; ulItem++ )
+		{
+			xPoolSendToQueue( xRecordPool, xReferenceQueue, pulRecords[ ulItem ], 0 );
+		}
+		ullSend += prvNowNs() - ullStart;
+		prvKeepFastest( ullSend, pullSend );
+
+		/* The consumer reads the record in place, so it is checked before the
+		block goes back. */
+		ullStart = prvNowNs();
+		for( ulItem = 0; ulItem < benchBATCH; ulItem++ )
+		{
+			pulReceived[ ulItem ] = pvPoolReceiveFromQueue( xReferenceQueue, 0 );
+		}
+		ullReceive = prvNowNs() - ullStart;
+
+		prvCheckBatch( ( const uint32_t ** ) pulReceived, benchRECORD_SIZE );
+
+		ullStart = prvNowNs();
+		for( ulItem = 0; ulItem < benchBATCH; ulItem++ )
+		{
+			vPoolPut( xRecordPool, pulReceived[ ulItem ] );
+		}
+		ullReceive += prvNowNs() - ullStart;
+		prvKeepFastest( ullReceive, pullReceive );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvPrintRow( const char *pcLabel, uint64_t ullSend, uint64_t ullReceive )
+{
+	printf( "  %-24s %8.1f %9.1f\n", pcLabel, ( double ) ullSend / benchBATCH, ( double ) ullReceive / benchBATCH );
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchTask( void *pvParameters )
+{
+uint64_t ullSend, ullReceive;
+uint32_t ulSize, ulRepeat;
+char cLabel[ 32 ];
+
+	( void ) pvParameters;
+
+	printf( "Queue item copy, %s, ns per item (host, fastest batch of %d)\n", ( configUSE_QUEUE_SIZED_COPY == 1 ) ? "sized copies" : "memcpy", benchBATCHES * benchREPEATS );
+	printf( "  %-24s %8s %9s\n", "item", "send", "receive" );
+
+	for( ulSize = 0; ulSize < benchSIZES; ulSize++ )
+	{
+		ullSend = UINT64_MAX;
+		ullReceive = UINT64_MAX;
+		for( ulRepeat = 0; ulRepeat < benchREPEATS; ulRepeat++ )
+		{
+			prvTimeCopies( uxItemSizes[ ulSize ], xQueues[ ulSize ], &ullSend, &ullReceive );
+		}
+
+		snprintf( cLabel, sizeof( cLabel ), "%lu bytes, copied", ( unsigned long ) uxItemSizes[ ulSize ] );
+		prvPrintRow( cLabel, ullSend, ullReceive );
+	}
+
+	ullSend = UINT64_MAX;
+	ullReceive = UINT64_MAX;
+	for( ulRepeat = 0; ulRepeat < benchREPEATS; ulRepeat++ )
+	{
+		prvTimeReferences( &ullSend, &ullReceive );
+	}
+	prvPrintRow( "any size, by reference", ullSend, ullReceive );
+
+	printf( "  items checked %lu, not as sent %lu, pool blocks free %lu of %d\n", ( unsigned long ) ulItems, ( unsigned long ) ulMismatches,
+			( unsigned long ) uxPoolGetFreeCount( xRecordPool ), benchBATCH );
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint16_t *pusIdleTaskStackSize )
+{
+	*ppxIdleTaskTCBBuffer = &xIdleTaskBuffer;
+	*ppxIdleTaskStackBuffer = xIdleTaskStack;
+	*pusIdleTaskStackSize = benchSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint16_t *pusTimerTaskStackSize )
+{
+	*ppxTimerTaskTCBBuffer = &xTimerTaskBuffer;
+	*ppxTimerTaskStackBuffer = xTimerTaskStack;
+	*pusTimerTaskStackSize = benchSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+uint32_t ulSize;
+
+	for( ulSize = 0; ulSize < benchSIZES; ulSize++ )
+	{
+		xQueues[ ulSize ] = xQueueCreateStatic( benchBATCH, uxItemSizes[ ulSize ], ( uint8_t * ) ulQueueStorage[ ulSize ], &( xQueueBuffers[ ulSize ] ) );
+	}
+
+	xReferenceQueue = xQueueCreateStatic( benchBATCH, sizeof( void * ), ( uint8_t * ) pvReferenceQueueStorage, &xReferenceQueueBuffer );
+	xRecordPool = xPoolCreate( benchRECORD_SIZE, benchBATCH );
+	configASSERT( xRecordPool );
+
+	xTaskCreateStatic( prvBenchTask, "bench", benchSTACK_DEPTH, NULL, 2, xBenchTaskStack, &xBenchTaskBuffer );
+
+	vTaskStartScheduler();
+
+	return 0;
+}
@@ -0,0 +1,880 @@
+/*
+ * Replays a trace of the mains frequency through the relay
+ * (../freertos_assignment/Relay.c) on the peripheral models, and reports how
+ * quickly and how often it decided to shed and reconnect loads.
+ *
+ *   relay_replay [-s speed-up] [-d decisions.csv] [-w trace.csv] [-t]
+ *                console.txt [trace.csv]
+ *
+ * The trace is a CSV file with the analyser's count, the number of 16kHz ADC
+ * samples in one period of the mains, as frequencyAnalyserISR() reads it from
+ * FREQUENCY_ANALYSER_BASE, in the first field of each line.  Blank lines,
+ * lines starting with '#' and a header line are skipped.  Without a trace a
+ * synthetic one is replayed (prvGenerate()), which -w writes out.  The counts
+ * are played by the frequency analyser model, one period after another, so
+ * each reaches the relay through its interrupt, frequencyAnalyserISR(),
+ * frequencyUpdaterTask and loadManagerTask as a live sample would.
+ *
+ * -s replays the periods speed-up times faster than their counts say; the
+ * counts, and so the frequencies the relay computes, are unchanged.  The
+ * relay's stability window is still 500ms of simulated time, so at a speed-up
+ * it spans more of the trace and the decisions differ from a real time
+ * replay.
+ *
+ * Every red LED write that changes the loads is a decision and is recorded
+ * with its simulated time; -d writes them out.  A trip is a shed made in the
+ * normal state, which is what the relay measures its own reaction time from.
+ * Its latency is taken from the interrupt for the first period that should
+ * have tripped, found by applying the relay's tripping conditions to the
+ * trace here, to the shed.  A period that ended while the relay was still
+ * reconnecting can trip it once it is back in the normal state, and then
+ * counts from the last such period.  Checked, with the exit status 1 if any
+ * fails: every trip follows such a period and each such period is followed by a trip
+ * within replayTRIP_DEADLINE_MS, sheds take the lowest priority load and
+ * reconnects the highest, the relay counted the same number of reactions,
+ * and it ends in the normal state with every load on.
+ *
+ * All figures are in simulated time and the same on every run of the same
+ * build and trace, so reports can be compared between builds; -t adds the
+ * host time, which is not.  As in relay_sim, a register access is charged
+ * replayACCESS_CYCLES, a critical section replayCRITICAL_CYCLES and a context
+ * switch replaySWITCH_CYCLES, which are assumed.  The relay's own code between
+ * them takes no simulated time, so the latencies are a lower bound.  A trip's
+ * latency is also split where its sample was sent to freqRocDataQ and read
+ * from it by loadManagerTask, which are seen by wrapping the queue calls at
+ * link time, so the report shows where it went.  The check fails too if more than one trip was measured and
+ * every percentile of the latency is the same, as that means the simulation
+ * has stopped charging for what the trip waits on.  Nothing here was measured
+ * on the board.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "system.h"
+#include "peripherals.h"
+
+/* Cycles each pass of the idle loop costs. */
+#define replayIDLE_PASS_CYCLES		1000
+
+/* Assumed cycles for a register access, as in relay_sim. */
+#define replayACCESS_CYCLES			8
+
+/* Assumed cycles for a critical section and a context switch, as in
+relay_sim. */
+#define replayCRITICAL_CYCLES		100
+#define replaySWITCH_CYCLES			150
+
+#define replayCYCLES_PER_MS			( ALT_CPU_FREQ / 1000ULL )
+#define replayCOUNTS_PER_SECOND		16000ULL
+
+/* Simulated time at 50Hz before the trace, for the relay to boot and enable
+the analyser's interrupt, and after it, for the relay to reconnect the loads:
+more than five stability windows. */
+#define replaySETTLE_MS				200ULL
+#define replayDRAIN_MS				3000ULL
+
+/* A period that should trip the relay in the normal state and has not by this
+much later is counted as missed. */
+#define replayTRIP_DEADLINE_MS		100ULL
+
+/* More than freqRocDataQ holds. */
+#define replaySENT_RING_LENGTH		64
+
+#define replayALL_LOADS				0x1F
+#define replayNORMAL				0		/* loadManagerState, as Relay.c defines it. */
+
+/* The synthetic trace: the grid at 50Hz with a count of noise, and
+replaySYNTHETIC_EVENTS disturbances replayEVENT_SPACING_MS apart. */
+#define replayCOUNT_50HZ			320
+#define replayLEAD_IN_MS			2000ULL
+#define replaySYNTHETIC_EVENTS		12
+#define replayEVENT_SPACING_MS		6000ULL
+#define replaySEED					0x2545F491UL
+
+/* Relay.c, which is linked in. */
+int relayMain( int argc, char *argv[], char *envp[] );
+extern float frequencyThreshold;
+extern int rocThreshold;
+extern unsigned int reactionCount;
+int reactionTimeAverage( void );
+extern int minReactionTime, maxReactionTime;
+extern uint8_t loadManagerState;
+extern QueueHandle_t freqRocDataQ;
+
+typedef enum
+{
+	eReplayShed = 0,
+	eReplayTrip,
+	eReplayReconnect
+} ReplayKind_t;
+
+static const char * const pcKindNames[] = { "shed", "trip", "reconnect" };
+
+/* A red LED write that changed the loads. */
+typedef struct REPLAY_DECISION
+{
+	uint64_t ullAt;
+	uint64_t ullLatency;		/*<< Cycles from the period that tripped, for a trip. */
+	uint64_t ullToQueue;		/*<< Of which to its sample being sent to freqRocDataQ, */
+	uint64_t ullInQueue;		/*<< and waiting there for loadManagerTask. */
+	uint32_t ulSample;			/*<< Periods of the trace ended by then. */
+	uint8_t ucBefore;
+	uint8_t ucAfter;
+	ReplayKind_t eKind;
+} ReplayDecision_t;
+
+static uint16_t *pusTrace = NULL;
+static uint32_t ulTraceLength = 0, ulTraceSize = 0;
+static uint64_t ullTraceCounts = 0;
+
+static ReplayDecision_t *pxDecisions = NULL;
+static uint32_t ulDecisionCount = 0, ulDecisionSize = 0;
+static uint32_t ulLoads = replayALL_LOADS;
+
+/* The trace as it plays: the count of the period in progress, 0 before the
+first, and whether it is from the trace; the next count of the trace; the
+periods ended, all of them and those of the trace; the frequency of the last
+one; and the end of the first period since the last trip that should have
+tripped the relay, 0 if none. */
+static uint16_t usPlaying = 0;
+static BaseType_t xPlayingTrace = pdFALSE;
+static uint32_t ulNextCount = 0, ulPeriodsEnded = 0, ulSamplesEnded = 0;
+static float fLastFrequency = 0.0f;
+static uint64_t ullTripDueAt = 0;
+static uint32_t ulUnattributed = 0, ulMissed = 0, ulOutOfOrder = 0;
+static uint64_t ullTraceStart = 0, ullTraceEnd = UINT64_MAX;
+
+/* The end of the last period that should have tripped the relay in any
+state. */
+static uint64_t ullLastTripAt = 0;
+
+/* When each record still in freqRocDataQ was sent, oldest first, and when the
+one loadManagerTask last received was sent and received. */
+static uint64_t ullSentAt[ replaySENT_RING_LENGTH ];
+static uint32_t ulSentHead = 0, ulSentTail = 0;
+static uint64_t ullReceivedSentAt = 0, ullReceivedAt = 0;
+
+/* Periods the relay's interrupt handler missed while it booted. */
+static uint32_t ulUnseenBeforeTrace = 0;
+
+static uint32_t ulSeed = replaySEED;
+static uint32_t ulSpeedUp = 1;
+static const char *pcTraceName = "the synthetic trace";
+static const char *pcDecisionsName = NULL;
+static int iHostTime = 0;
+static FILE *pxReport;
+static struct timespec xHostStart;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The end of the replay as a device with no registers: its one event is the
+ * end of the trace plus replayDRAIN_MS.
+ */
+static uint32_t prvEndRead( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulBytes );
+static void prvEndWrite( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulData, uint32_t ulBytes );
+static uint64_t prvEndNextEvent( SimDevice_t *pxDevice );
+static void prvEndUpdate( SimDevice_t *pxDevice, uint64_t ullNow );
+
+static SimDevice_t xEnd = { 0, 0, prvEndRead, prvEndWrite, prvEndNextEvent, prvEndUpdate };
+
+/*-----------------------------------------------------------*/
+
+static void *prvGrow( void *pvArray, uint32_t *pulSize, size_t xItemSize )
+{
+	*pulSize = ( *pulSize == 0 ) ? 1024 : *pulSize * 2;
+	pvArray = realloc( pvArray, *pulSize * xItemSize );
+	if( pvArray == NULL )
+	{
+		perror( "relay_replay" );
+		exit( 2 );
+	}
+
+	return pvArray;
+}
+/*-----------------------------------------------------------*/
+
+static void prvAppendCount( uint16_t usCount )
+{
+	if( ulTraceLength == ulTraceSize )
+	{
+		pusTrace = prvGrow( pusTrace, &ulTraceSize, sizeof( uint16_t ) );
+	}
+	pusTrace[ ulTraceLength++ ] = usCount;
+	ullTraceCounts += usCount;
+}
+/*-----------------------------------------------------------*/
+
+static uint16_t prvCountOf( double dFrequency )
+{
+	return ( uint16_t ) ( ( double ) replayCOUNTS_PER_SECOND / dFrequency + 0.5 );
+}
+/*-----------------------------------------------------------*/
+
+/* Trace time so far, in counts of the 16kHz ADC. */
+static uint64_t prvCountsOf( uint64_t ullMs )
+{
+	return ullMs * replayCOUNTS_PER_SECOND / 1000ULL;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRandom( uint32_t ulRange )
+{
+	ulSeed = ( ulSeed * 1664525UL ) + 1013904223UL;
+	return ( ulSeed >> 16 ) % ulRange;
+}
+/*-----------------------------------------------------------*/
+
+/* 50Hz, give or take a count, until the trace is ullUntil counts long. */
+static void prvQuiet( uint64_t ullUntil )
+{
+	while( ullTraceCounts < ullUntil )
+	{
+		prvAppendCount( ( uint16_t ) ( replayCOUNT_50HZ - 1 + prvRandom( 3 ) ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* dFrom to dTo Hz, linearly over ullMs. */
+static void prvRamp( double dFrom, double dTo, uint64_t ullMs )
+{
+uint64_t ullStart = ullTraceCounts, ullLength = prvCountsOf( ullMs );
+
+	while( ullTraceCounts - ullStart < ullLength )
+	{
+		prvAppendCount( prvCountOf( dFrom + ( dTo - dFrom ) * ( double ) ( ullTraceCounts - ullStart ) / ( double ) ullLength ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * The synthetic trace: replayLEAD_IN_MS at 50Hz, then in turn
+ *  - a step down to 48Hz for a second, a rate of change of about -95Hz/s
+ *    with the frequency above the 30Hz threshold, and back up;
+ *  - a sag at about -21Hz/s, under the rate of change threshold, to 29Hz,
+ *    held for 0.5 to 2s, and a ramp back;
+ *  - a single period at 51.3Hz, about +64Hz/s;
+ *  - a second of swinging between 49.4 and 50.6Hz every period, about
+ *    62Hz/s each way;
+ * replaySYNTHETIC_EVENTS times, each with replayEVENT_SPACING_MS to itself.
+ */
+static void prvGenerate( void )
+{
+uint64_t ullStart;
+uint32_t ul, ulPeriod;
+
+	prvQuiet( prvCountsOf( replayLEAD_IN_MS ) );
+
+	for( ul = 0; ul < replaySYNTHETIC_EVENTS; ul++ )
+	{
+		ullStart = ullTraceCounts;
+
+		switch( ul % 4 )
+		{
+			case 0 :
+				while( ullTraceCounts - ullStart < prvCountsOf( 1000 ) )
+				{
+					prvAppendCount( 333 );
+				}
+				break;
+			case 1 :
+				prvRamp( 50.0, 29.0, 1000 );
+				while( ullTraceCounts - ullStart < prvCountsOf( 1500 + 500 * prvRandom( 4 ) ) )
+				{
+					prvAppendCount( prvCountOf( 29.0 ) );
+				}
+				prvRamp( 29.0, 50.0, 1000 );
+				break;
+			case 2 :
+				prvAppendCount( 312 );
+				break;
+			default :
+				for( ulPeriod = 0; ullTraceCounts - ullStart < prvCountsOf( 1000 ); ulPeriod++ )
+				{
+					prvAppendCount( ( ( ulPeriod & 1 ) == 0 ) ? 324 : 316 );
+				}
+				break;
+		}
+
+		prvQuiet( ullStart + prvCountsOf( replayEVENT_SPACING_MS ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static int prvLoadTrace( const char *pcName )
+{
+FILE *pxFile = fopen( pcName, "r" );
+char cLine[ 256 ];
+char *pcEnd;
+unsigned long ulCount, ulLine = 0;
+
+	if( pxFile == NULL )
+	{
+		perror( pcName );
+		return 0;
+	}
+
+	while( fgets( cLine, sizeof( cLine ), pxFile ) != NULL )
+	{
+		ulLine++;
+		if( ( cLine[ 0 ] == '#' ) || ( cLine[ strspn( cLine, " \t\r\n" ) ] == '\0' ) ||
+			( ( ulLine == 1 ) && ( ( cLine[ 0 ] < '0' ) || ( cLine[ 0 ] > '9' ) ) ) )
+		{
+			continue;
+		}
+
+		errno = 0;
+		ulCount = strtoul( cLine, &pcEnd, 10 );
+		if( ( errno != 0 ) || ( pcEnd == cLine ) || ( ulCount == 0 ) || ( ulCount > 0xFFFFUL ) ||
+			( strchr( ",\r\n", *pcEnd ) == NULL ) )
+		{
+			fprintf( stderr, "%s:%lu: expected a count from 1 to 65535\n", pcName, ulLine );
+			fclose( pxFile );
+			return 0;
+		}
+		prvAppendCount( ( uint16_t ) ulCount );
+	}
+
+	fclose( pxFile );
+	if( ulTraceLength < 2 )
+	{
+		fprintf( stderr, "%s: fewer than two counts\n", pcName );
+		return 0;
+	}
+
+	return 1;
+}
+/*-----------------------------------------------------------*/
+
+static int prvWriteTrace( const char *pcName )
+{
+FILE *pxFile = fopen( pcName, "w" );
+uint32_t ul;
+
+	if( pxFile == NULL )
+	{
+		perror( pcName );
+		return 0;
+	}
+
+	fprintf( pxFile, "count\n" );
+	for( ul = 0; ul < ulTraceLength; ul++ )
+	{
+		fprintf( pxFile, "%u\n", ( unsigned ) pusTrace[ ul ] );
+	}
+
+	return fclose( pxFile ) == 0;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Whether the period with usCount, after one at fLastFrequency, trips the
+ * relay: the frequency as frequencyAnalyserISR() and the rate of change as
+ * frequencyUpdaterTask compute them, in float, against the thresholds as
+ * checkTrippingConditions() applies them.  The relay takes no rate of change
+ * from its first period, nor does this.
+ */
+static int prvTrips( uint16_t usCount )
+{
+float fFrequency = 16000 / ( double ) usCount;
+float fRoc;
+int iTrips;
+
+	if( ulPeriodsEnded == 1 )
+	{
+		iTrips = 0;
+	}
+	else
+	{
+		fRoc = ( ( fFrequency - fLastFrequency ) * 2 ) / ( ( 1 / fFrequency ) + ( 1 / fLastFrequency ) );
+		iTrips = ( fFrequency < frequencyThreshold ) || ( ( fRoc * 10 ) > rocThreshold ) || ( ( fRoc * 10 ) < -( rocThreshold ) );
+	}
+	fLastFrequency = fFrequency;
+
+	return iTrips;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * The analyser calls this at the start of each period, which is when the last
+ * one ended and its interrupt is raised.
+ */
+static uint16_t prvReplay( uint64_t ullNow )
+{
+	if( usPlaying != 0 )
+	{
+		ulPeriodsEnded++;
+		if( xPlayingTrace != pdFALSE )
+		{
+			ulSamplesEnded++;
+		}
+
+		if( ( ullTripDueAt != 0 ) && ( ullNow - ullTripDueAt > replayTRIP_DEADLINE_MS * replayCYCLES_PER_MS ) )
+		{
+			ulMissed++;
+			ullTripDueAt = 0;
+		}
+		if( prvTrips( usPlaying ) )
+		{
+			ullLastTripAt = ullNow;
+			if( ( loadManagerState == replayNORMAL ) && ( ullTripDueAt == 0 ) )
+			{
+				ullTripDueAt = ullNow;
+			}
+		}
+	}
+
+	if( ullNow < replaySETTLE_MS * replayCYCLES_PER_MS )
+	{
+		usPlaying = replayCOUNT_50HZ;
+	}
+	else if( ulNextCount < ulTraceLength )
+	{
+		if( ulNextCount == 0 )
+		{
+			/* The interrupt for the period that has just ended is still to
+			be taken, and is, as the relay is up by now. */
+			ullTraceStart = ullNow;
+			ulUnseenBeforeTrace = ulPeriodsEnded - ulPortSimGetInterruptCount( FREQUENCY_ANALYSER_IRQ ) - 1;
+		}
+		usPlaying = pusTrace[ ulNextCount++ ];
+		xPlayingTrace = pdTRUE;
+	}
+	else
+	{
+		usPlaying = 0;
+		ullTraceEnd = ullNow;
+		vPortSimEventsChanged();
+	}
+
+	return usPlaying;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * The relay's sends to and receives from freqRocDataQ, through -Wl,--wrap, so
+ * a trip's latency can be split where its sample went through the queue.
+ */
+BaseType_t __real_xQueueGenericSend( QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait, const BaseType_t xCopyPosition );
+BaseType_t __real_xQueueGenericReceive( QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait, const BaseType_t xJustPeeking );
+
+BaseType_t __wrap_xQueueGenericSend( QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait, const BaseType_t xCopyPosition )
+{
+BaseType_t xReturn = __real_xQueueGenericSend( xQueue, pvItemToQueue, xTicksToWait, xCopyPosition );
+
+	if( ( xQueue == freqRocDataQ ) && ( xReturn == pdPASS ) )
+	{
+		ullSentAt[ ulSentHead++ % replaySENT_RING_LENGTH ] = ullPortSimGetCycles();
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t __wrap_xQueueGenericReceive( QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait, const BaseType_t xJustPeeking )
+{
+BaseType_t xReturn = __real_xQueueGenericReceive( xQueue, pvBuffer, xTicksToWait, xJustPeeking );
+
+	if( ( xQueue == freqRocDataQ ) && ( xReturn == pdPASS ) && ( xJustPeeking == pdFALSE ) && ( ulSentTail != ulSentHead ) )
+	{
+		ullReceivedSentAt = ullSentAt[ ulSentTail++ % replaySENT_RING_LENGTH ];
+		ullReceivedAt = ullPortSimGetCycles();
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvObserveLeds( uint32_t ulBase, uint32_t ulData )
+{
+ReplayDecision_t *pxDecision;
+uint32_t ulChanged;
+uint64_t ullFrom;
+
+	if( ( ulBase != RED_LEDS_BASE ) || ( ( ulData & replayALL_LOADS ) == ulLoads ) )
+	{
+		return;
+	}
+
+	if( ulDecisionCount == ulDecisionSize )
+	{
+		pxDecisions = prvGrow( pxDecisions, &ulDecisionSize, sizeof( ReplayDecision_t ) );
+	}
+	pxDecision = &( pxDecisions[ ulDecisionCount++ ] );
+	pxDecision->ullAt = ullPortSimGetCycles();
+	pxDecision->ullLatency = 0;
+	pxDecision->ullToQueue = 0;
+	pxDecision->ullInQueue = 0;
+	pxDecision->ulSample = ulSamplesEnded;
+	pxDecision->ucBefore = ( uint8_t ) ulLoads;
+	pxDecision->ucAfter = ( uint8_t ) ( ulData & replayALL_LOADS );
+
+	/* A shed should take the lowest load that is on, a reconnect the highest
+	that is off, one at a time. */
+	ulChanged = ulLoads ^ pxDecision->ucAfter;
+	if( ( pxDecision->ucAfter & ~ulLoads ) == 0 )
+	{
+		pxDecision->eKind = eReplayShed;
+		if( ulChanged != ( ulLoads & -ulLoads ) )
+		{
+			ulOutOfOrder++;
+		}
+
+		/* shedLoad() writes the LEDs before loadManagerTask leaves the normal
+		state. */
+		if( loadManagerState == replayNORMAL )
+		{
+			pxDecision->eKind = eReplayTrip;
+			ullFrom = ullTripDueAt;
+			ullTripDueAt = 0;
+
+			/* A sample that ended while the relay was still reconnecting can
+			be read after it is back in the normal state. */
+			if( ( ullFrom == 0 ) && ( ullLastTripAt != 0 ) &&
+				( pxDecision->ullAt - ullLastTripAt <= replayTRIP_DEADLINE_MS * replayCYCLES_PER_MS ) )
+			{
+				ullFrom = ullLastTripAt;
+			}
+
+			if( ullFrom != 0 )
+			{
+				pxDecision->ullLatency = pxDecision->ullAt - ullFrom;
+				if( ( ullReceivedSentAt >= ullFrom ) && ( ullReceivedAt <= pxDecision->ullAt ) )
+				{
+					pxDecision->ullToQueue = ullReceivedSentAt - ullFrom;
+					pxDecision->ullInQueue = ullReceivedAt - ullReceivedSentAt;
+				}
+			}
+			else
+			{
+				ulUnattributed++;
+			}
+		}
+	}
+	else
+	{
+		pxDecision->eKind = eReplayReconnect;
+		if( ( ( ulChanged & ( ulChanged - 1 ) ) != 0 ) || ( ( ~ulLoads & replayALL_LOADS & ~( ( ulChanged << 1 ) - 1 ) ) != 0 ) )
+		{
+			ulOutOfOrder++;
+		}
+	}
+
+	ulLoads = pxDecision->ucAfter;
+}
+/*-----------------------------------------------------------*/
+
+static double prvUs( uint64_t ullCycles )
+{
+	return ( double ) ullCycles / ( double ) ( replayCYCLES_PER_MS / 1000ULL );
+}
+/*-----------------------------------------------------------*/
+
+static int prvCompareCycles( const void *pvA, const void *pvB )
+{
+uint64_t ullA = *( const uint64_t * ) pvA, ullB = *( const uint64_t * ) pvB;
+
+	return ( ullA > ullB ) - ( ullA < ullB );
+}
+/*-----------------------------------------------------------*/
+
+/* Nearest rank, of ulCount sorted latencies. */
+static uint64_t prvPercentile( const uint64_t *pullSorted, uint32_t ulCount, uint32_t ulPercent )
+{
+uint32_t ulRank = ( ulCount * ulPercent + 99 ) / 100;
+
+	return pullSorted[ ( ulRank == 0 ) ? 0 : ulRank - 1 ];
+}
+/*-----------------------------------------------------------*/
+
+/* Sorts ulCount latencies and prints their spread. */
+static void prvPrintLatencies( const char *pcWhat, uint64_t *pullCycles, uint32_t ulCount )
+{
+uint64_t ullTotal = 0;
+uint32_t ul;
+
+	if( ulCount == 0 )
+	{
+		return;
+	}
+
+	qsort( pullCycles, ulCount, sizeof( uint64_t ), prvCompareCycles );
+	for( ul = 0; ul < ulCount; ul++ )
+	{
+		ullTotal += pullCycles[ ul ];
+	}
+
+	fprintf( pxReport, "  %s: min %.2f us, p50 %.2f us, p90 %.2f us, p99 %.2f us, max %.2f us, mean %.2f us\n", pcWhat,
+			 prvUs( pullCycles[ 0 ] ), prvUs( prvPercentile( pullCycles, ulCount, 50 ) ), prvUs( prvPercentile( pullCycles, ulCount, 90 ) ),
+			 prvUs( prvPercentile( pullCycles, ulCount, 99 ) ), prvUs( pullCycles[ ulCount - 1 ] ), prvUs( ullTotal ) / ( double ) ulCount );
+}
+/*-----------------------------------------------------------*/
+
+static int prvWriteDecisions( const char *pcName )
+{
+FILE *pxFile = fopen( pcName, "w" );
+uint32_t ul;
+
+	if( pxFile == NULL )
+	{
+		perror( pcName );
+		return 0;
+	}
+
+	fprintf( pxFile, "time_us,sample,decision,loads_before,loads_after,latency_us,to_queue_us,in_queue_us\n" );
+	for( ul = 0; ul < ulDecisionCount; ul++ )
+	{
+		fprintf( pxFile, "%.2f,%lu,%s,0x%02x,0x%02x,", prvUs( pxDecisions[ ul ].ullAt ), ( unsigned long ) pxDecisions[ ul ].ulSample,
+				 pcKindNames[ pxDecisions[ ul ].eKind ], pxDecisions[ ul ].ucBefore, pxDecisions[ ul ].ucAfter );
+		if( ( pxDecisions[ ul ].eKind == eReplayTrip ) && ( pxDecisions[ ul ].ullLatency != 0 ) )
+		{
+			fprintf( pxFile, "%.2f,%.2f,%.2f", prvUs( pxDecisions[ ul ].ullLatency ), prvUs( pxDecisions[ ul ].ullToQueue ),
+					 prvUs( pxDecisions[ ul ].ullInQueue ) );
+		}
+		else
+		{
+			fprintf( pxFile, ",," );
+		}
+		fprintf( pxFile, "\n" );
+	}
+
+	return fclose( pxFile ) == 0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvReport( void )
+{
+struct timespec xHostEnd;
+uint32_t ul, ulKinds[ 3 ] = { 0, 0, 0 }, ulLatencies = 0, ulSplit = 0;
+uint64_t *pullLatencies, *pullToQueue, *pullInQueue, *pullToShed;
+double dSimSeconds, dHostSeconds;
+char cWhat[ 64 ];
+int iFailed = 0;
+
+	clock_gettime( CLOCK_MONOTONIC, &xHostEnd );
+	fflush( stdout );
+
+	pullLatencies = malloc( 4 * ( ulDecisionCount + 1 ) * sizeof( uint64_t ) );
+	if( pullLatencies == NULL )
+	{
+		perror( "relay_replay" );
+		exit( 2 );
+	}
+	pullToQueue = pullLatencies + ulDecisionCount + 1;
+	pullInQueue = pullToQueue + ulDecisionCount + 1;
+	pullToShed = pullInQueue + ulDecisionCount + 1;
+
+	for( ul = 0; ul < ulDecisionCount; ul++ )
+	{
+		ulKinds[ pxDecisions[ ul ].eKind ]++;
+		if( ( pxDecisions[ ul ].eKind == eReplayTrip ) && ( pxDecisions[ ul ].ullLatency != 0 ) )
+		{
+			pullLatencies[ ulLatencies++ ] = pxDecisions[ ul ].ullLatency;
+			if( pxDecisions[ ul ].ullToQueue != 0 )
+			{
+				pullToQueue[ ulSplit ] = pxDecisions[ ul ].ullToQueue;
+				pullInQueue[ ulSplit ] = pxDecisions[ ul ].ullInQueue;
+				pullToShed[ ulSplit ] = pxDecisions[ ul ].ullLatency - pxDecisions[ ul ].ullToQueue - pxDecisions[ ul ].ullInQueue;
+				ulSplit++;
+			}
+		}
+	}
+
+	dSimSeconds = ( double ) ullPortSimGetCycles() / ( double ) ALT_CPU_FREQ;
+
+	fprintf( pxReport, "Relay replay of %s, %lu periods, %.3f s at %lux in %.3f s simulated (host simulation)\n", pcTraceName,
+			 ( unsigned long ) ulTraceLength, ( double ) ullTraceCounts / ( double ) replayCOUNTS_PER_SECOND, ( unsigned long ) ulSpeedUp,
+			 dSimSeconds );
+	fprintf( pxReport, "  thresholds %.1f Hz and %d.%d Hz/s\n", ( double ) frequencyThreshold, rocThreshold / 10, rocThreshold % 10 );
+	fprintf( pxReport, "  decisions: %lu, %lu trips, %lu sheds in the stability window, %lu reconnects, %.2f per simulated second\n",
+			 ( unsigned long ) ulDecisionCount, ( unsigned long ) ulKinds[ eReplayTrip ], ( unsigned long ) ulKinds[ eReplayShed ],
+			 ( unsigned long ) ulKinds[ eReplayReconnect ], ( double ) ulDecisionCount / dSimSeconds );
+	snprintf( cWhat, sizeof( cWhat ), "reaction latency over %lu trips", ( unsigned long ) ulLatencies );
+	prvPrintLatencies( cWhat, pullLatencies, ulLatencies );
+	prvPrintLatencies( "  to the sample sent to freqRocDataQ", pullToQueue, ulSplit );
+	prvPrintLatencies( "  in freqRocDataQ", pullInQueue, ulSplit );
+	prvPrintLatencies( "  from the sample read to the shed", pullToShed, ulSplit );
+	fprintf( pxReport, "  relay's reaction times: %u measured, avg %d ms, min %d ms, max %d ms (tick resolution)\n", reactionCount,
+			 reactionTimeAverage(), minReactionTime, maxReactionTime );
+	fprintf( pxReport, "  throughput: %.1f periods per simulated second of the trace, %lu of them not seen by the ISR\n",
+			 ( double ) ulSamplesEnded * ( double ) ALT_CPU_FREQ / ( double ) ( ullTraceEnd - ullTraceStart ),
+			 ( unsigned long ) ( ulPeriodsEnded - ulPortSimGetInterruptCount( FREQUENCY_ANALYSER_IRQ ) - ulUnseenBeforeTrace ) );
+
+	if( iHostTime != 0 )
+	{
+		dHostSeconds = ( double ) ( xHostEnd.tv_sec - xHostStart.tv_sec ) + ( double ) ( xHostEnd.tv_nsec - xHostStart.tv_nsec ) / 1e9;
+		fprintf( pxReport, "  host: %.2f s, %.0f periods per second, %.1f times real time\n", dHostSeconds,
+				 ( double ) ulSamplesEnded / dHostSeconds, dSimSeconds / dHostSeconds );
+	}
+
+	if( ( ulUnattributed != 0 ) || ( ulMissed != 0 ) )
+	{
+		fprintf( pxReport, "  FAILED: %lu trips without a period that should trip, %lu such periods without a trip\n",
+				 ( unsigned long ) ulUnattributed, ( unsigned long ) ulMissed );
+		iFailed = 1;
+	}
+	if( ( ulLatencies > 1 ) && ( pullLatencies[ 0 ] == pullLatencies[ ulLatencies - 1 ] ) )
+	{
+		fprintf( pxReport, "  FAILED: every trip took the same time, so nothing it waits on is being charged\n" );
+		iFailed = 1;
+	}
+	if( ulOutOfOrder != 0 )
+	{
+		fprintf( pxReport, "  FAILED: %lu decisions out of priority order\n", ( unsigned long ) ulOutOfOrder );
+		iFailed = 1;
+	}
+	if( reactionCount != ulKinds[ eReplayTrip ] )
+	{
+		fprintf( pxReport, "  FAILED: the relay measured %u reactions for %lu trips\n", reactionCount, ( unsigned long ) ulKinds[ eReplayTrip ] );
+		iFailed = 1;
+	}
+	if( ( ulLoads != replayALL_LOADS ) || ( loadManagerState != replayNORMAL ) )
+	{
+		fprintf( pxReport, "  FAILED: the relay did not end in normal mode with every load on\n" );
+		iFailed = 1;
+	}
+	if( ( pcDecisionsName != NULL ) && ( prvWriteDecisions( pcDecisionsName ) == 0 ) )
+	{
+		iFailed = 1;
+	}
+
+	fflush( pxReport );
+	exit( iFailed );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvEndRead( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulBytes )
+{
+	( void ) pxDevice;
+	( void ) ulOffset;
+	( void ) ulBytes;
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvEndWrite( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulData, uint32_t ulBytes )
+{
+	( void ) pxDevice;
+	( void ) ulOffset;
+	( void ) ulData;
+	( void ) ulBytes;
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvEndNextEvent( SimDevice_t *pxDevice )
+{
+	( void ) pxDevice;
+
+	return ( ullTraceEnd == UINT64_MAX ) ? UINT64_MAX : ullTraceEnd + replayDRAIN_MS * replayCYCLES_PER_MS;
+}
+/*-----------------------------------------------------------*/
+
+static void prvEndUpdate( SimDevice_t *pxDevice, uint64_t ullNow )
+{
+	if( ullNow >= prvEndNextEvent( pxDevice ) )
+	{
+		prvReport();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvUsage( const char *pcName )
+{
+	fprintf( stderr, "usage: %s [-s speed-up] [-d decisions.csv] [-w trace.csv] [-t] console.txt [trace.csv]\n", pcName );
+	exit( 2 );
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationIdleHook( void )
+{
+	vPortSimConsume( replayIDLE_PASS_CYCLES );
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc, char **argv )
+{
+char *pcRelayArgv[] = { "relay", NULL };
+char *pcRelayEnvp[] = { NULL };
+const char *pcWriteName = NULL;
+char *pcEnd;
+int iOption, iReport;
+
+	while( ( iOption = getopt( argc, argv, "s:d:w:t" ) ) != -1 )
+	{
+		switch( iOption )
+		{
+			case 's' :
+				ulSpeedUp = ( uint32_t ) strtoul( optarg, &pcEnd, 10 );
+				if( ( *pcEnd != '\0' ) || ( ulSpeedUp == 0 ) || ( ulSpeedUp > 1000 ) )
+				{
+					fprintf( stderr, "%s: the speed-up is a whole number from 1 to 1000\n", argv[ 0 ] );
+					return 2;
+				}
+				break;
+			case 'd' :
+				pcDecisionsName = optarg;
+				break;
+			case 'w' :
+				pcWriteName = optarg;
+				break;
+			case 't' :
+				iHostTime = 1;
+				break;
+			default :
+				prvUsage( argv[ 0 ] );
+		}
+	}
+	if( ( optind != argc - 1 ) && ( optind != argc - 2 ) )
+	{
+		prvUsage( argv[ 0 ] );
+	}
+
+	if( optind == argc - 2 )
+	{
+		pcTraceName = argv[ optind + 1 ];
+		if( prvLoadTrace( pcTraceName ) == 0 )
+		{
+			return 2;
+		}
+	}
+	else
+	{
+		prvGenerate();
+	}
+	if( ( pcWriteName != NULL ) && ( prvWriteTrace( pcWriteName ) == 0 ) )
+	{
+		return 2;
+	}
+
+	/* The report goes to stdout, the relay's printing to the file. */
+	iReport = dup( STDOUT_FILENO );
+	pxReport = ( iReport < 0 ) ? NULL : fdopen( iReport, "w" );
+	if( ( pxReport == NULL ) || ( freopen( argv[ optind ], "w", stdout ) == NULL ) )
+	{
+		perror( argv[ optind ] );
+		return 1;
+	}
+
+	clock_gettime( CLOCK_MONOTONIC, &xHostStart );
+
+	/* Every load switched on, and the trace playing from power up. */
+	vPortSimSetAccessCycles( replayACCESS_CYCLES );
+	vPortSimSetKernelCycles( replayCRITICAL_CYCLES, replaySWITCH_CYCLES );
+	alt_sys_init();
+	vSimSetSwitches( replayALL_LOADS );
+	vSimSetPioObserver( prvObserveLeds );
+	vSimSetFrequencySpeedUp( ulSpeedUp );
+	vSimSetFrequencySource( prvReplay );
+	vPortSimAddDevice( &xEnd );
+
+	/* Does not return; the end device ends the program. */
+	return relayMain( 1, pcRelayArgv, pcRelayEnvp );
+}
@@ -0,0 +1,445 @@
+/*
+ * The relay (../freertos_assignment/Relay.c) on the host simulated port, on
+ * the register level models of the board's peripherals in port/peripherals.c.
+ *
+ *   relay_sim console.txt
+ *
+ * Relay.c is compiled unchanged apart from its main() being renamed, and runs
+ * with all of its tasks, interrupt handlers and BSP drivers: the frequency
+ * analyser's interrupt reaches frequencyAnalyserISR() through the port,
+ * keys typed on the model keyboard go through the PS/2 driver and ps2ISR() to
+ * keyboardManagerTask, which writes the LCD through its driver, and vgaTask
+ * draws into the model SRAM and character buffer.  Simulated time runs as
+ * fast as the host can go.  What the relay prints goes to console.txt.
+ *
+ * The scenario, simSCENARIO_MS long:
+ *  - the grid at 50Hz throughout, apart from the disturbances below;
+ *  - the lower frequency threshold set to 49Hz on the keyboard, '1', '4',
+ *    '9' and Enter, simKEY_SPACING_MS apart;
+ *  - a 2s sag to 48.5Hz, below the new threshold, so loads are shed every
+ *    stability window and reconnected after it;
+ *  - a single 20ms period at 50.8Hz, a rate of change of about 40Hz/s over
+ *    the 30Hz/s threshold with the frequency above its threshold;
+ *  - the maintenance button, load 4 switched off and on again, and the
+ *    button again.
+ *
+ * Every write to the red LEDs, which show the loads connected, is logged with
+ * its time.  The reaction to each disturbance is the time from the end of
+ * the first period the analyser counted at the new frequency, when its
+ * interrupt is raised, to the first load shed.  Also printed: the relay's
+ * own reaction statistics, interrupt counts and latencies, the LCD and part
+ * of the VGA character buffer, the flash operations, and the host time the
+ * run took.  Exits with 1 if the thresholds, the loads or the maintenance
+ * switching are not as the scenario should leave them.
+ *
+ * Each register access is charged simACCESS_CYCLES, assumed for an access
+ * over the Avalon bus and not measured, and each critical section and
+ * context switch simCRITICAL_CYCLES and simSWITCH_CYCLES, also assumed, for
+ * the kernel's code between them; the clock, the analyser's 16kHz
+ * sample rate and the thresholds are as on the board.  Only simulated and
+ * host figures are printed; nothing here was measured on the board.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "system.h"
+#include "peripherals.h"
+
+/* Cycles each pass of the idle loop costs. */
+#define simIDLE_PASS_CYCLES		1000
+
+/* Assumed cycles for a register access, see the top of the file. */
+#define simACCESS_CYCLES		8
+
+/* Assumed cycles for a critical section and a context switch. */
+#define simCRITICAL_CYCLES		100
+#define simSWITCH_CYCLES		150
+
+#define simCYCLES_PER_MS		( ALT_CPU_FREQ / 1000ULL )
+#define simSCENARIO_MS			17000ULL
+
+/* Frequency analyser counts of the 16kHz ADC. */
+#define simCOUNT_50HZ			320
+#define simCOUNT_SAG			330		/* 48.48Hz */
+#define simCOUNT_ROC_STEP		315		/* 50.79Hz */
+
+#define simSAG_START_MS			4000ULL
+#define simSAG_END_MS			6000ULL
+#define simROC_STEP_START_MS	10000ULL
+#define simROC_STEP_END_MS		10020ULL
+
+/* keyboardManagerTask waits 200ms after each of the two codes it sees for a
+key, so keys must be more than 400ms apart. */
+#define simKEY_SPACING_MS		500ULL
+#define simKEY_HOLD_CYCLES		( 80ULL * simCYCLES_PER_MS )
+
+/* Set 2 scan codes, as keyboardManagerTask knows them. */
+#define simKEY_1				105
+#define simKEY_4				107
+#define simKEY_9				125
+#define simKEY_ENTER			90
+
+/* KEY2, the maintenance button. */
+#define simMAINTENANCE_BUTTON	0x4
+#define simBUTTON_HOLD_MS		100ULL
+
+#define simALL_LOADS			0x1F
+#define simLOAD_4				0x10
+
+#define simMAX_DECISIONS		64
+
+/* Relay.c, which is linked in. */
+int relayMain( int argc, char *argv[], char *envp[] );
+extern float frequencyThreshold;
+extern int rocThreshold;
+extern unsigned int reactionCount;
+int reactionTimeAverage( void );
+extern int minReactionTime, maxReactionTime;
+extern uint8_t loadManagerState;
+
+typedef enum
+{
+	eSimTypeKey = 0,
+	eSimPressButton,
+	eSimReleaseButton,
+	eSimSetSwitches,
+	eSimEnd
+} SimAction_t;
+
+typedef struct SIM_STEP
+{
+	uint64_t ullAtMs;
+	SimAction_t eAction;
+	uint32_t ulArgument;
+} SimStep_t;
+
+static const SimStep_t xSteps[] =
+{
+	{ 1000, eSimTypeKey, simKEY_1 },
+	{ 1000 + simKEY_SPACING_MS, eSimTypeKey, simKEY_4 },
+	{ 1000 + 2 * simKEY_SPACING_MS, eSimTypeKey, simKEY_9 },
+	{ 1000 + 3 * simKEY_SPACING_MS, eSimTypeKey, simKEY_ENTER },
+	{ 13000, eSimPressButton, simMAINTENANCE_BUTTON },
+	{ 13000 + simBUTTON_HOLD_MS, eSimReleaseButton, simMAINTENANCE_BUTTON },
+	{ 13500, eSimSetSwitches, simALL_LOADS & ~simLOAD_4 },
+	{ 14500, eSimSetSwitches, simALL_LOADS },
+	{ 15500, eSimPressButton, simMAINTENANCE_BUTTON },
+	{ 15500 + simBUTTON_HOLD_MS, eSimReleaseButton, simMAINTENANCE_BUTTON },
+	{ simSCENARIO_MS, eSimEnd, 0 }
+};
+
+/* Red LED writes that changed the loads. */
+typedef struct SIM_DECISION
+{
+	uint64_t ullAt;
+	uint32_t ulLoads;
+} SimDecision_t;
+
+static SimDecision_t xDecisions[ simMAX_DECISIONS ];
+static uint32_t ulDecisionCount = 0, ulDecisionsLost = 0;
+static uint32_t ulLoads = simALL_LOADS;
+
+/* When the analyser raised the interrupt for the first period of each
+disturbance, 0 until then. */
+static uint64_t ullSagSampleAt = 0, ullRocSampleAt = 0;
+
+static uint32_t ulNextStep = 0;
+static FILE *pxReport;
+static struct timespec xHostStart;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The scenario's device: it has no registers, only the steps as its events.
+ */
+static uint32_t prvScenarioRead( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulBytes );
+static void prvScenarioWrite( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulData, uint32_t ulBytes );
+static uint64_t prvScenarioNextEvent( SimDevice_t *pxDevice );
+static void prvScenarioUpdate( SimDevice_t *pxDevice, uint64_t ullNow );
+
+static SimDevice_t xScenario = { 0, 0, prvScenarioRead, prvScenarioWrite, prvScenarioNextEvent, prvScenarioUpdate };
+
+/*-----------------------------------------------------------*/
+
+static uint16_t prvGrid( uint64_t ullNow )
+{
+uint64_t ullMs = ullNow / simCYCLES_PER_MS;
+uint16_t usCount = simCOUNT_50HZ;
+
+	if( ( ullMs >= simSAG_START_MS ) && ( ullMs < simSAG_END_MS ) )
+	{
+		usCount = simCOUNT_SAG;
+		if( ullSagSampleAt == 0 )
+		{
+			ullSagSampleAt = ullNow + ( uint64_t ) usCount * ( ALT_CPU_FREQ / 16000ULL );
+		}
+	}
+	else if( ( ullMs >= simROC_STEP_START_MS ) && ( ullMs < simROC_STEP_END_MS ) )
+	{
+		usCount = simCOUNT_ROC_STEP;
+		if( ullRocSampleAt == 0 )
+		{
+			ullRocSampleAt = ullNow + ( uint64_t ) usCount * ( ALT_CPU_FREQ / 16000ULL );
+		}
+	}
+
+	return usCount;
+}
+/*-----------------------------------------------------------*/
+
+static void prvObserveLeds( uint32_t ulBase, uint32_t ulData )
+{
+	if( ( ulBase != RED_LEDS_BASE ) || ( ( ulData & simALL_LOADS ) == ulLoads ) )
+	{
+		return;
+	}
+
+	ulLoads = ulData & simALL_LOADS;
+	if( ulDecisionCount < simMAX_DECISIONS )
+	{
+		xDecisions[ ulDecisionCount ].ullAt = ullPortSimGetCycles();
+		xDecisions[ ulDecisionCount ].ulLoads = ulLoads;
+		ulDecisionCount++;
+	}
+	else
+	{
+		ulDecisionsLost++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* Time from ullSampleAt to the first load shed after it, or -1. */
+static double prvReactionMs( uint64_t ullSampleAt )
+{
+uint32_t ulPrevious = simALL_LOADS, ul;
+
+	for( ul = 0; ul < ulDecisionCount; ul++ )
+	{
+		if( ( ullSampleAt != 0 ) && ( xDecisions[ ul ].ullAt >= ullSampleAt ) && ( ( xDecisions[ ul ].ulLoads & ~ulPrevious ) == 0 ) &&
+			( xDecisions[ ul ].ulLoads != ulPrevious ) )
+		{
+			return ( double ) ( xDecisions[ ul ].ullAt - ullSampleAt ) / ( double ) simCYCLES_PER_MS;
+		}
+		ulPrevious = xDecisions[ ul ].ulLoads;
+	}
+
+	return -1.0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPrintInterrupt( const char *pcName, uint32_t ulIrq )
+{
+uint32_t ulCount = ulPortSimGetInterruptCount( ulIrq );
+
+	fprintf( pxReport, "  %-18s %6lu interrupts, latency mean %.2f us, max %.2f us\n", pcName, ( unsigned long ) ulCount,
+			 ( ulCount != 0 ) ? ( double ) ullPortSimGetInterruptLatencyTotal( ulIrq ) / ( double ) ulCount / 100.0 : 0.0,
+			 ( double ) ullPortSimGetInterruptLatencyMax( ulIrq ) / 100.0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvReport( void )
+{
+struct timespec xHostEnd;
+uint32_t ul, ulPrevious = simALL_LOADS, ulSheds = 0, ulReconnects = 0, ulErases, ulWrites;
+uint32_t ulLoad4Off = 0, ulLoad4On = 0;
+double dHostSeconds, dSimSeconds;
+char cLine[ 81 ];
+int iFailed = 0;
+
+	clock_gettime( CLOCK_MONOTONIC, &xHostEnd );
+	fflush( stdout );
+
+	fprintf( pxReport, "Relay on peripheral models, %llu ms simulated (host simulation)\n", ( unsigned long long ) simSCENARIO_MS );
+	fprintf( pxReport, "  load decisions (red LEDs):\n" );
+	for( ul = 0; ul < ulDecisionCount; ul++ )
+	{
+		if( ( xDecisions[ ul ].ulLoads & ~ulPrevious ) == 0 )
+		{
+			ulSheds++;
+		}
+		else
+		{
+			ulReconnects++;
+		}
+
+		if( ( ( ulPrevious & simLOAD_4 ) != 0 ) && ( ( xDecisions[ ul ].ulLoads & simLOAD_4 ) == 0 ) )
+		{
+			ulLoad4Off++;
+		}
+		else if( ( ( ulPrevious & simLOAD_4 ) == 0 ) && ( ( xDecisions[ ul ].ulLoads & simLOAD_4 ) != 0 ) )
+		{
+			ulLoad4On++;
+		}
+
+		fprintf( pxReport, "    %10.3f ms  loads 0x%02lx -> 0x%02lx\n", ( double ) xDecisions[ ul ].ullAt / ( double ) simCYCLES_PER_MS,
+				 ( unsigned long ) ulPrevious, ( unsigned long ) xDecisions[ ul ].ulLoads );
+		ulPrevious = xDecisions[ ul ].ulLoads;
+	}
+	fprintf( pxReport, "  %lu switched off, %lu on, %lu not logged\n", ( unsigned long ) ulSheds, ( unsigned long ) ulReconnects,
+			 ( unsigned long ) ulDecisionsLost );
+
+	fprintf( pxReport, "  first shed after the sag's first period %.3f ms, after the rate of change step's %.3f ms\n",
+			 prvReactionMs( ullSagSampleAt ), prvReactionMs( ullRocSampleAt ) );
+	fprintf( pxReport, "  relay's reaction times: %u measured, avg %d ms, min %d ms, max %d ms (tick resolution)\n", reactionCount,
+			 reactionTimeAverage(), minReactionTime, maxReactionTime );
+	fprintf( pxReport, "  thresholds %.1f Hz and %d.%d Hz/s\n", ( double ) frequencyThreshold, rocThreshold / 10, rocThreshold % 10 );
+
+	prvPrintInterrupt( "tick", TIMER1MS_IRQ );
+	fprintf( pxReport, "  asleep in tickless idle %.1f%% of the time\n",
+			 ( double ) ullPortSimGetSleepCycles() * 100.0 / ( double ) ullPortSimGetCycles() );
+	prvPrintInterrupt( "frequency analyser", FREQUENCY_ANALYSER_IRQ );
+	prvPrintInterrupt( "PS/2", PS2_IRQ );
+	prvPrintInterrupt( "push buttons", PUSH_BUTTON_IRQ );
+
+	fprintf( pxReport, "  LCD:\n" );
+	for( ul = 0; ul < 2; ul++ )
+	{
+		vSimGetLcdLine( ul, cLine );
+		fprintf( pxReport, "    |%s|\n", cLine );
+	}
+	fprintf( pxReport, "  VGA character buffer, lines 50 to 56:\n" );
+	for( ul = 50; ul <= 56; ul++ )
+	{
+		vSimGetCharBufferLine( ul, cLine );
+		fprintf( pxReport, "    |%s|\n", cLine );
+	}
+
+	ulWrites = ulSimGetFlashOperations( &ulErases );
+	fprintf( pxReport, "  flash: %lu writes, %lu block erases\n", ( unsigned long ) ulWrites, ( unsigned long ) ulErases );
+
+	dHostSeconds = ( double ) ( xHostEnd.tv_sec - xHostStart.tv_sec ) + ( double ) ( xHostEnd.tv_nsec - xHostStart.tv_nsec ) / 1e9;
+	dSimSeconds = ( double ) ullPortSimGetCycles() / ( double ) ALT_CPU_FREQ;
+	fprintf( pxReport, "  %.2f s on the host, %.1f times real time\n", dHostSeconds, dSimSeconds / dHostSeconds );
+
+	if( ( int ) ( frequencyThreshold * 10.0f + 0.5f ) != 490 )
+	{
+		fprintf( pxReport, "  FAILED: the frequency threshold typed was not taken\n" );
+		iFailed = 1;
+	}
+	if( ( prvReactionMs( ullSagSampleAt ) < 0.0 ) || ( prvReactionMs( ullRocSampleAt ) < 0.0 ) )
+	{
+		fprintf( pxReport, "  FAILED: a disturbance shed no load\n" );
+		iFailed = 1;
+	}
+	if( ( ulLoad4Off == 0 ) || ( ulLoad4On == 0 ) )
+	{
+		fprintf( pxReport, "  FAILED: load 4 did not follow its switch in maintenance\n" );
+		iFailed = 1;
+	}
+	if( ( ulLoads != simALL_LOADS ) || ( loadManagerState != 0 ) )
+	{
+		fprintf( pxReport, "  FAILED: the relay did not end in normal mode with every load on\n" );
+		iFailed = 1;
+	}
+
+	fflush( pxReport );
+	exit( iFailed );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvScenarioRead( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulBytes )
+{
+	( void ) pxDevice;
+	( void ) ulOffset;
+	( void ) ulBytes;
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvScenarioWrite( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulData, uint32_t ulBytes )
+{
+	( void ) pxDevice;
+	( void ) ulOffset;
+	( void ) ulData;
+	( void ) ulBytes;
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvScenarioNextEvent( SimDevice_t *pxDevice )
+{
+	( void ) pxDevice;
+
+	return xSteps[ ulNextStep ].ullAtMs * simCYCLES_PER_MS;
+}
+/*-----------------------------------------------------------*/
+
+static void prvScenarioUpdate( SimDevice_t *pxDevice, uint64_t ullNow )
+{
+const SimStep_t *pxStep;
+
+	( void ) pxDevice;
+
+	while( xSteps[ ulNextStep ].ullAtMs * simCYCLES_PER_MS <= ullNow )
+	{
+		pxStep = &( xSteps[ ulNextStep++ ] );
+
+		switch( pxStep->eAction )
+		{
+			case eSimTypeKey :
+				vSimTypeKey( ( uint8_t ) pxStep->ulArgument, simKEY_HOLD_CYCLES );
+				break;
+			case eSimPressButton :
+				vSimPressButtons( pxStep->ulArgument );
+				break;
+			case eSimReleaseButton :
+				vSimReleaseButtons( pxStep->ulArgument );
+				break;
+			case eSimSetSwitches :
+				vSimSetSwitches( pxStep->ulArgument );
+				break;
+			case eSimEnd :
+				prvReport();
+				break;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationIdleHook( void )
+{
+	vPortSimConsume( simIDLE_PASS_CYCLES );
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc, char **argv )
+{
+char *pcRelayArgv[] = { "relay", NULL };
+char *pcRelayEnvp[] = { NULL };
+int iReport;
+
+	if( argc != 2 )
+	{
+		fprintf( stderr, "usage: %s console.txt\n", argv[ 0 ] );
+		return 2;
+	}
+
+	/* The report goes to stdout, the relay's printing to the file. */
+	iReport = dup( STDOUT_FILENO );
+	pxReport = ( iReport < 0 ) ? NULL : fdopen( iReport, "w" );
+	if( ( pxReport == NULL ) || ( freopen( argv[ 1 ], "w", stdout ) == NULL ) )
+	{
+		perror( argv[ 1 ] );
+		return 1;
+	}
+
+	clock_gettime( CLOCK_MONOTONIC, &xHostStart );
+
+	/* The board as it is powered up: every load switched on, and the grid at
+	50Hz from the start. */
+	vPortSimSetAccessCycles( simACCESS_CYCLES );
+	vPortSimSetKernelCycles( simCRITICAL_CYCLES, simSWITCH_CYCLES );
+	alt_sys_init();
+	vSimSetSwitches( simALL_LOADS );
+	vSimSetPioObserver( prvObserveLeds );
+	vSimSetFrequencySource( prvGrid );
+	vPortSimAddDevice( &xScenario );
+
+	/* Does not return; the last step ends the program. */
+	return relayMain( 1, pcRelayArgv, pcRelayEnvp );
+}
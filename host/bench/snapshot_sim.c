@@ -0,0 +1,619 @@
+/*
+ * Host simulation of the relay's boot snapshot: a reset on a stressed grid,
+ * with the load manager put back from the persistent store (store.c) or
+ * started from its defaults.  Built twice, as snapshot_sim_on and
+ * snapshot_sim_off, with simRESTORE 1 and 0.
+ *
+ *   snapshot_sim_on
+ *   snapshot_sim_off
+ *
+ * A sample task stands in for frequencyUpdaterTask, giving a sample every
+ * 20ms with the rate of change worked out as Relay.c does, so the first
+ * sample after a reset only seeds it.  A control task below it is shaped like
+ * loadManagerTask: it sheds a load when a threshold is broken and then sheds
+ * or reconnects one for each 500ms stability window, timed with a tick timer
+ * (tick_timer.c).  A flush task below that stands in for storeTask: on each
+ * shed or reconnect, and every 10s, it builds the snapshot Relay.c's
+ * storeSnapshot() does and flushes the store to a RAM model of the board's
+ * 8 blocks of 64KiB of NOR flash.
+ *
+ * The frequency drops to 48.8Hz, under the 49Hz threshold, at 1s and
+ * recovers at 6s.  At 2.3s, between flushes, the control task resets: its
+ * state, the store's RAM and the tick timer are cleared and xStoreInit() is
+ * run again, as initStore() does at boot.  With simRESTORE the snapshot is
+ * then put back as restoreSnapshot() does and the stability window carried on.
+ *
+ * Printed, all in simulated time: the time from the reset to the loads being
+ * driven, which is the store's flash reads at an assumed 100ns a byte and
+ * nothing else of the boot; the time to the first decision, the first sample
+ * or stability window judged; how long until as many loads are shed as were
+ * before the reset; and the load-seconds connected over that number until
+ * then.  Exits with 1 if the loads and state after the restore are not those
+ * before the reset.  Nothing here was measured on the board.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "tick_timer.h"
+#include "store.h"
+
+#ifndef simRESTORE
+	#define simRESTORE			1
+#endif
+
+#define simBLOCKS				8
+#define simBLOCK_SIZE			( 64UL * 1024UL )
+
+/* Assumed flash times in 100MHz cycles, as store_sim.  Not measured. */
+#define simREAD_CYCLES			10ULL
+#define simPROGRAM_CYCLES		1000ULL
+#define simERASE_CYCLES			50000000ULL
+
+#define simSAMPLE_TICKS			( ( TickType_t ) 20 )
+#define simWINDOW_TICKS			( ( TickType_t ) 500 )
+#define simSAG_START			( ( TickType_t ) 1000 )
+#define simSAG_END				( ( TickType_t ) 6000 )
+#define simRESET_TICK			( ( TickType_t ) 2300 )
+#define simEND_TICK				( ( TickType_t ) 9000 )
+#define simFLUSH_TICKS			( ( TickType_t ) 10000 )
+
+#define simNOMINAL				50.0f
+#define simSAG					48.8f
+#define simFREQUENCY_THRESHOLD	49.0f
+#define simROC_THRESHOLD		150		/* 0.1 Hz/s */
+
+#define simLOADS				5
+#define simALL_LOADS			( ( 1U << simLOADS ) - 1U )
+
+/* Load manager states and events, as Relay.c. */
+#define simNORMAL				0
+#define simLOAD_MANAGE			1
+#define simMAINTENANCE			2
+#define simWINDOW_EXPIRED		0x01UL
+#define simNEW_SAMPLE			0x02UL
+
+/* Keys, as Relay.c. */
+#define simKEY_SNAPSHOT			3
+#define simSNAPSHOT_SAMPLES		5
+
+#define simSTACK_DEPTH			( 256 )
+
+/* Relay.c's struct storedSnapshot. */
+typedef struct xSIM_SNAPSHOT
+{
+	uint8_t ucState;
+	uint8_t ucLoads;
+	uint8_t ucWasStable;
+	uint8_t ucMaintenance;
+	uint16_t usTimerRemaining;
+	uint8_t ucSamples;
+	uint8_t ucUnused;
+	uint16_t usFrequency[ simSNAPSHOT_SAMPLES ];
+	int16_t sRoc[ simSNAPSHOT_SAMPLES ];
+} SimSnapshot_t;
+
+static StaticTask_t xSampleTaskBuffer, xControlTaskBuffer, xFlushTaskBuffer, xIdleTaskBuffer, xTimerTaskBuffer;
+static StackType_t xSampleTaskStack[ simSTACK_DEPTH ], xControlTaskStack[ simSTACK_DEPTH ], xFlushTaskStack[ simSTACK_DEPTH ], xIdleTaskStack[ simSTACK_DEPTH ], xTimerTaskStack[ simSTACK_DEPTH ];
+static TaskHandle_t xControlTask, xFlushTask;
+
+static uint8_t ucFlash[ simBLOCKS * simBLOCK_SIZE ];
+static const StoreFlash_t *pxStore;
+
+/* The control task's state, as Relay.c's globals. */
+static uint8_t ucState = simNORMAL, ucLoads = simALL_LOADS, ucWasStable = 1;
+static float fFrequency[ simSNAPSHOT_SAMPLES ], fRoc[ simSNAPSHOT_SAMPLES ];
+static UBaseType_t uxSamples = 0;
+static TickTimer_t xWindow;
+
+/* The newest sample, from the sample task. */
+static float fSampleFrequency, fSampleRoc;
+static volatile BaseType_t xReseed = pdFALSE, xFlushing = pdFALSE;
+static volatile TickType_t xSnapshotTick = 0;
+
+/* Events taken while stopping the window, for prvWaitForEvents(). */
+static uint32_t ulPendingEvents = 0;
+
+/* Set once the control task runs, so flash times are charged. */
+static BaseType_t xCharge = pdFALSE;
+
+/* Results. */
+static uint8_t ucLoadsBefore, ucStateBefore, ucLoadsAfter, ucStateAfter;
+static TickType_t xSnapshotAge, xRemainingBefore, xRemainingAfter;
+static uint64_t ullResetCycles, ullDrivenCycles, ullDecisionCycles = 0, ullMatchCycles = 0, ullExcessCycles = 0;
+static uint32_t ulBootBytesRead;
+
+/*-----------------------------------------------------------*/
+
+static void prvCharge( uint64_t ullCycles )
+{
+	/* Before the scheduler starts there is nothing to charge it to. */
+	if( xCharge != pdFALSE )
+	{
+		vPortSimConsume( ( uint32_t ) ullCycles );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvFlashRead( void *pvContext, uint32_t ulOffset, void *pvBuffer, size_t xLength )
+{
+	( void ) pvContext;
+	memcpy( pvBuffer, &( ucFlash[ ulOffset ] ), xLength );
+	prvCharge( simREAD_CYCLES * xLength );
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvFlashProgram( void *pvContext, uint32_t ulOffset, const void *pvData, size_t xLength )
+{
+const uint8_t *pucData = ( const uint8_t * ) pvData;
+size_t x;
+
+	( void ) pvContext;
+	for( x = 0; x < xLength; x++ )
+	{
+		ucFlash[ ulOffset + x ] &= pucData[ x ];
+	}
+	prvCharge( simPROGRAM_CYCLES * xLength );
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvFlashErase( void *pvContext, uint32_t ulOffset )
+{
+	( void ) pvContext;
+	memset( &( ucFlash[ ulOffset ] ), 0xFF, simBLOCK_SIZE );
+	prvCharge( simERASE_CYCLES );
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static const StoreFlash_t xStore = { prvFlashRead, prvFlashProgram, prvFlashErase, NULL, 0, simBLOCK_SIZE, simBLOCKS };
+
+static uint32_t prvConnected( uint8_t ucBitmap )
+{
+uint32_t ulCount = 0;
+
+	for( ; ucBitmap != 0U; ucBitmap &= ( uint8_t ) ( ucBitmap - 1U ) )
+	{
+		ulCount++;
+	}
+	return ulCount;
+}
+/*-----------------------------------------------------------*/
+
+/* Lowest numbered load first, as shedLoad() does. */
+static void prvShed( void )
+{
+uint8_t ucLoad;
+
+	for( ucLoad = 0; ucLoad < simLOADS; ucLoad++ )
+	{
+		if( ( ucLoads & ( 1U << ucLoad ) ) != 0U )
+		{
+			ucLoads &= ( uint8_t ) ~( 1U << ucLoad );
+			xTaskNotifyGive( xFlushTask );
+			return;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* Highest numbered load first, as reconnectLoad() does.  Returns pdTRUE once
+every load is connected. */
+static BaseType_t prvReconnect( void )
+{
+int iLoad;
+
+	for( iLoad = simLOADS - 1; iLoad >= 0; iLoad-- )
+	{
+		if( ( ucLoads & ( 1U << iLoad ) ) == 0U )
+		{
+			ucLoads |= ( uint8_t ) ( 1U << iLoad );
+			xTaskNotifyGive( xFlushTask );
+			break;
+		}
+	}
+
+	return ( ucLoads == simALL_LOADS ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+/* As stopStabilityTimer(): an expiry already notified is dropped, the other
+events are kept. */
+static void prvStopWindow( void )
+{
+uint32_t ulEvents = 0;
+
+	vTickTimerStop( &xWindow );
+	if( xTaskNotifyWait( 0, UINT32_MAX, &ulEvents, 0 ) == pdTRUE )
+	{
+		ulPendingEvents |= ulEvents;
+	}
+	ulPendingEvents &= ~simWINDOW_EXPIRED;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRestartWindow( void )
+{
+	prvStopWindow();
+	vTickTimerStart( &xWindow, simWINDOW_TICKS );
+}
+/*-----------------------------------------------------------*/
+
+/* As waitForLoadManagerEvents(). */
+static uint32_t prvWaitForEvents( void )
+{
+uint32_t ulEvents = 0;
+
+	if( xTaskNotifyWait( 0, UINT32_MAX, &ulEvents, ( ulPendingEvents != 0UL ) ? 0 : portMAX_DELAY ) == pdTRUE )
+	{
+		ulPendingEvents |= ulEvents;
+	}
+	ulEvents = ulPendingEvents;
+	ulPendingEvents = 0;
+
+	return ulEvents;
+}
+/*-----------------------------------------------------------*/
+
+static void prvNoteDecision( void )
+{
+	if( ( ullResetCycles != 0ULL ) && ( ullDecisionCycles == 0ULL ) )
+	{
+		ullDecisionCycles = ullPortSimGetCycles();
+	}
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Stands in for frequencyUpdaterTask.
+ */
+static void prvSampleTask( void *pvParameters )
+{
+float fNew, fOld = simNOMINAL;
+BaseType_t xFirst = pdTRUE;
+TickType_t xNow;
+
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		vTaskDelay( simSAMPLE_TICKS );
+		xNow = xTaskGetTickCount();
+		fNew = ( ( xNow >= simSAG_START ) && ( xNow < simSAG_END ) ) ? simSAG : simNOMINAL;
+
+		if( xReseed != pdFALSE )
+		{
+			xReseed = pdFALSE;
+			xFirst = pdTRUE;
+		}
+
+		if( xFirst != pdFALSE )
+		{
+			xFirst = pdFALSE;
+			fOld = fNew;
+			continue;
+		}
+
+		fSampleRoc = ( ( fNew - fOld ) * 2.0f ) / ( ( 1.0f / fNew ) + ( 1.0f / fOld ) );
+		fSampleFrequency = fNew;
+		fOld = fNew;
+		xTaskNotify( xControlTask, simNEW_SAMPLE, eSetBits );
+	}
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * What initStore() and restoreSnapshot() do at boot.
+ */
+static void prvBoot( void )
+{
+SimSnapshot_t xSnapshot;
+StoreStats_t xStats;
+UBaseType_t ux;
+
+	ucState = simNORMAL;
+	ucLoads = simALL_LOADS;
+	ucWasStable = 1;
+	uxSamples = 0;
+	prvStopWindow();
+	ulPendingEvents = 0;
+	xReseed = pdTRUE;
+
+	if( xStoreInit( pxStore ) != pdPASS )
+	{
+		printf( "snapshot_sim: xStoreInit failed\n" );
+		exit( 1 );
+	}
+	vStoreGetStats( &xStats );
+	ulBootBytesRead = xStats.ulRecoveryBytesRead;
+
+	#if( simRESTORE == 1 )
+	{
+		if( ( xStoreGetValue( simKEY_SNAPSHOT, &xSnapshot, sizeof( xSnapshot ) ) == sizeof( xSnapshot ) ) && ( xSnapshot.ucState <= simMAINTENANCE ) &&
+			( xSnapshot.ucLoads <= simALL_LOADS ) && ( xSnapshot.ucSamples <= simSNAPSHOT_SAMPLES ) && ( xSnapshot.usTimerRemaining <= simWINDOW_TICKS ) )
+		{
+			ucState = xSnapshot.ucState;
+			ucLoads = xSnapshot.ucLoads;
+			ucWasStable = ( xSnapshot.ucWasStable != 0U ) ? 1U : 0U;
+			uxSamples = xSnapshot.ucSamples;
+			for( ux = 0; ux < uxSamples; ux++ )
+			{
+				fFrequency[ ux ] = ( float ) xSnapshot.usFrequency[ ux ] / 100.0f;
+				fRoc[ ux ] = ( float ) xSnapshot.sRoc[ ux ] / 100.0f;
+			}
+			xRemainingAfter = xSnapshot.usTimerRemaining;
+		}
+	}
+	#else
+	{
+		( void ) xSnapshot;
+		( void ) ux;
+	}
+	#endif
+
+	/* The loads are driven here. */
+	ullDrivenCycles = ullPortSimGetCycles();
+	ucLoadsAfter = ucLoads;
+	ucStateAfter = ucState;
+
+	/* As loadManagerTask does when it starts. */
+	if( ucState == simLOAD_MANAGE )
+	{
+		vTickTimerStart( &xWindow, ( xRemainingAfter != 0U ) ? xRemainingAfter : simWINDOW_TICKS );
+	}
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Stands in for loadManagerTask, with a reset at simRESET_TICK.
+ */
+static void prvControlTask( void *pvParameters )
+{
+uint32_t ulEvents = 0;
+UBaseType_t ux;
+TickType_t xNow;
+uint8_t ucTrip;
+BaseType_t xReset = pdFALSE;
+uint64_t ullLastCycles = 0, ullNow;
+
+	( void ) pvParameters;
+
+	vTickTimerInit( &xWindow, xControlTask, simWINDOW_EXPIRED );
+	xCharge = pdTRUE;
+
+	for( ;; )
+	{
+		ulEvents = prvWaitForEvents();
+		xNow = xTaskGetTickCount();
+		ullNow = ullPortSimGetCycles();
+
+		/* Load-seconds over what was connected before the reset, until as
+		many are shed. */
+		if( ( xReset != pdFALSE ) && ( ullMatchCycles == 0ULL ) )
+		{
+			if( prvConnected( ucLoads ) > prvConnected( ucLoadsBefore ) )
+			{
+				ullExcessCycles += ( uint64_t ) ( prvConnected( ucLoads ) - prvConnected( ucLoadsBefore ) ) * ( ullNow - ullLastCycles );
+			}
+		}
+		ullLastCycles = ullNow;
+
+		if( xNow >= simEND_TICK )
+		{
+			break;
+		}
+
+		/* Between flushes, so the reset does not also cut one short, which
+		store_sim covers. */
+		if( ( xReset == pdFALSE ) && ( xNow >= simRESET_TICK ) && ( xFlushing == pdFALSE ) )
+		{
+			xReset = pdTRUE;
+			ucLoadsBefore = ucLoads;
+			ucStateBefore = ucState;
+			xRemainingBefore = xTickTimerGetRemaining( &xWindow );
+			xSnapshotAge = xNow - xSnapshotTick;
+
+			ullResetCycles = ullPortSimGetCycles();
+			prvBoot();
+			ullLastCycles = ullDrivenCycles;
+			if( prvConnected( ucLoads ) <= prvConnected( ucLoadsBefore ) )
+			{
+				ullMatchCycles = ullDrivenCycles;
+			}
+			continue;
+		}
+
+		if( ucState == simLOAD_MANAGE )
+		{
+			if( ( ulEvents & simWINDOW_EXPIRED ) != 0UL )
+			{
+				prvNoteDecision();
+				if( ucWasStable != 0U )
+				{
+					if( prvReconnect() != pdFALSE )
+					{
+						vTickTimerStop( &xWindow );
+						ucState = simNORMAL;
+					}
+					else
+					{
+						prvRestartWindow();
+					}
+				}
+				else
+				{
+					prvShed();
+					prvRestartWindow();
+				}
+			}
+		}
+
+		if( ( ulEvents & simNEW_SAMPLE ) != 0UL )
+		{
+			for( ux = simSNAPSHOT_SAMPLES - 1U; ux > 0U; ux-- )
+			{
+				fFrequency[ ux ] = fFrequency[ ux - 1U ];
+				fRoc[ ux ] = fRoc[ ux - 1U ];
+			}
+			fFrequency[ 0 ] = fSampleFrequency;
+			fRoc[ 0 ] = fSampleRoc;
+			uxSamples = ( uxSamples < simSNAPSHOT_SAMPLES ) ? ( uxSamples + 1U ) : uxSamples;
+
+			ucTrip = ( ( fSampleFrequency < simFREQUENCY_THRESHOLD ) || ( ( fSampleRoc * 10.0f ) > simROC_THRESHOLD ) ||
+					   ( ( fSampleRoc * 10.0f ) < -simROC_THRESHOLD ) ) ? 1U : 0U;
+			prvNoteDecision();
+
+			if( ucState == simNORMAL )
+			{
+				if( ucTrip != 0U )
+				{
+					prvShed();
+					ucWasStable = 0;
+					ucState = simLOAD_MANAGE;
+					prvRestartWindow();
+				}
+			}
+			else if( ucState == simLOAD_MANAGE )
+			{
+				if( ( ucTrip != 0U ) && ( ucWasStable != 0U ) )
+				{
+					ucWasStable = 0;
+					prvRestartWindow();
+				}
+				else if( ( ucTrip == 0U ) && ( ucWasStable == 0U ) )
+				{
+					ucWasStable = 1;
+					prvRestartWindow();
+				}
+			}
+		}
+
+		if( ( xReset != pdFALSE ) && ( ullMatchCycles == 0ULL ) && ( prvConnected( ucLoads ) <= prvConnected( ucLoadsBefore ) ) )
+		{
+			ullMatchCycles = ullPortSimGetCycles();
+		}
+	}
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Stands in for storeTask, with Relay.c's storeSnapshot().
+ */
+static void prvFlushTask( void *pvParameters )
+{
+SimSnapshot_t xSnapshot;
+UBaseType_t ux;
+
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		ulTaskNotifyTake( pdTRUE, simFLUSH_TICKS );
+
+		xFlushing = pdTRUE;
+
+		memset( &xSnapshot, 0x00, sizeof( xSnapshot ) );
+		xSnapshot.ucState = ucState;
+		xSnapshot.ucLoads = ucLoads;
+		xSnapshot.ucWasStable = ucWasStable;
+		xSnapshot.usTimerRemaining = ( uint16_t ) xTickTimerGetRemaining( &xWindow );
+		xSnapshot.ucSamples = ( uint8_t ) uxSamples;
+		for( ux = 0; ux < uxSamples; ux++ )
+		{
+			xSnapshot.usFrequency[ ux ] = ( uint16_t ) ( fFrequency[ ux ] * 100.0f );
+			xSnapshot.sRoc[ ux ] = ( int16_t ) ( fRoc[ ux ] * 100.0f );
+		}
+		xStoreSetValue( simKEY_SNAPSHOT, &xSnapshot, sizeof( xSnapshot ) );
+		xSnapshotTick = xTaskGetTickCount();
+
+		if( xStoreFlush() != pdPASS )
+		{
+			printf( "snapshot_sim: flush failed\n" );
+		}
+
+		xFlushing = pdFALSE;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationIdleHook( void )
+{
+	vPortSimConsume( 1000 );
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint16_t *pusIdleTaskStackSize )
+{
+	*ppxIdleTaskTCBBuffer = &xIdleTaskBuffer;
+	*ppxIdleTaskStackBuffer = xIdleTaskStack;
+	*pusIdleTaskStackSize = simSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint16_t *pusTimerTaskStackSize )
+{
+	*ppxTimerTaskTCBBuffer = &xTimerTaskBuffer;
+	*ppxTimerTaskStackBuffer = xTimerTaskStack;
+	*pusTimerTaskStackSize = simSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+static double prvMs( uint64_t ullCycles )
+{
+	return ( double ) ullCycles * 1000.0 / TIMER1MS_FREQ;
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	memset( ucFlash, 0xFF, sizeof( ucFlash ) );
+	pxStore = &xStore;
+	if( xStoreInit( pxStore ) != pdPASS )
+	{
+		printf( "snapshot_sim: xStoreInit failed\n" );
+		return 1;
+	}
+
+	xTaskCreateStatic( prvSampleTask, "sample", simSTACK_DEPTH, NULL, 3, xSampleTaskStack, &xSampleTaskBuffer );
+	xControlTask = xTaskCreateStatic( prvControlTask, "control", simSTACK_DEPTH, NULL, 2, xControlTaskStack, &xControlTaskBuffer );
+	xFlushTask = xTaskCreateStatic( prvFlushTask, "store", simSTACK_DEPTH, NULL, 1, xFlushTaskStack, &xFlushTaskBuffer );
+	vStoreSetFlushTask( xFlushTask );
+
+	vTaskStartScheduler();
+
+	printf( "Boot snapshot %s, reset at %.0fms into a sag (host; flash reads assumed at 100ns a byte)\n",
+			( simRESTORE == 1 ) ? "restored" : "not restored", prvMs( ullResetCycles ) );
+	printf( "  before the reset: loads 0x%02x, state %u, %lu ticks left in the window, snapshot %lu ticks old\n",
+			( unsigned ) ucLoadsBefore, ( unsigned ) ucStateBefore, ( unsigned long ) xRemainingBefore, ( unsigned long ) xSnapshotAge );
+	printf( "  after boot:       loads 0x%02x, state %u, %lu ticks left in the window\n",
+			( unsigned ) ucLoadsAfter, ( unsigned ) ucStateAfter, ( unsigned long ) xRemainingAfter );
+	printf( "  reset to loads driven %.2fms (%lu bytes read), to first decision %.1fms\n",
+			prvMs( ullDrivenCycles - ullResetCycles ), ( unsigned long ) ulBootBytesRead, prvMs( ullDecisionCycles - ullResetCycles ) );
+	if( ullMatchCycles != 0ULL )
+	{
+		printf( "  as many loads shed as before the reset after %.1fms, %.3f load-seconds connected over that until then\n",
+				prvMs( ullMatchCycles - ullResetCycles ), prvMs( ullExcessCycles ) / 1000.0 );
+	}
+	else
+	{
+		printf( "  never as many loads shed as before the reset, %.3f load-seconds connected over that\n", prvMs( ullExcessCycles ) / 1000.0 );
+	}
+
+	#if( simRESTORE == 1 )
+	{
+		if( ( ucLoadsAfter != ucLoadsBefore ) || ( ucStateAfter != ucStateBefore ) )
+		{
+			printf( "snapshot_sim: the restore did not put back the loads and state\n" );
+			return 1;
+		}
+	}
+	#endif
+
+	return 0;
+}
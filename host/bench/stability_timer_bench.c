@@ -0,0 +1,281 @@
+/*
+ * Host benchmark comparing the relay's 500ms stability timer as a software
+ * timer (timers.h) with the same timer as a tick timer (tick_timer.h).
+ *
+ * Runs on the simulated port and measures two things:
+ *
+ *  - restart: the cost of restarting a running timer the way loadManagerTask
+ *    does, in host nanoseconds, the fastest of benchREPEATS runs of
+ *    benchRESTARTS.  The software timer is stopped and started with
+ *    xTimerStop() and xTimerStart() as restartFreeRTOSTimer() did, so this
+ *    includes the switches to and from the timer service task that process the
+ *    commands.  The tick timer is restarted as restartStabilityTimer() does.
+ *
+ *  - expiry to action: simulated time from the tick at which the timer is due
+ *    to the task acting on the expiry, over benchWINDOWS windows started at
+ *    pseudo random points and followed by up to 10ms of work, as when
+ *    loadManagerTask sheds a load and prints it.  The software timer's callback
+ *    sets a flag that the task finds when it next wakes from its 10ms poll.  The tick timer wakes
+ *    the task from the tick, either out of the 10ms poll or from a wait with
+ *    no timeout.  Task work is charged with vPortSimConsume(); the kernel and
+ *    the interrupts themselves cost no simulated time.
+ */
+#include <stdio.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+#include "tick_timer.h"
+
+#define benchRESTARTS			20000
+#define benchREPEATS			5
+#define benchWINDOWS			200
+
+/* The relay's stability window and loadManagerTask's poll. */
+#define benchPERIOD				( ( TickType_t ) 500 )
+#define benchPOLL				( ( TickType_t ) 10 )
+
+#define benchEXPIRED			0x01UL
+
+#define benchCYCLES_PER_TICK	( TIMER1MS_FREQ / configTICK_RATE_HZ )
+#define benchCYCLES_PER_US		( TIMER1MS_FREQ / 1000000 )
+
+#define benchSTACK_DEPTH		( 256 )
+
+typedef enum
+{
+	eSoftwareTimerPoll = 0,
+	eTickTimerPoll,
+	eTickTimerBlock,
+	eMethodCount
+} BenchMethod_t;
+
+static const char * const pcMethodNames[ eMethodCount ] =
+{
+	"software timer, 10ms poll",
+	"tick timer, 10ms poll",
+	"tick timer, blocking wait"
+};
+
+static StaticTask_t xBenchTaskBuffer, xIdleTaskBuffer, xTimerTaskBuffer;
+static StackType_t xBenchTaskStack[ benchSTACK_DEPTH ], xIdleTaskStack[ benchSTACK_DEPTH ], xTimerTaskStack[ benchSTACK_DEPTH ];
+
+static TimerHandle_t xSoftwareTimer;
+static StaticTimer_t xSoftwareTimerBuffer;
+static TickTimer_t xTickTimer;
+
+static volatile uint8_t ucSoftwareTimerExpired = 0;
+static uint32_t ulRandom = 0x12345678UL;
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNowNs( void )
+{
+struct timespec xNow;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRandom( uint32_t ulRange )
+{
+	ulRandom = ( ulRandom * 1103515245UL ) + 12345UL;
+	return ( ulRandom >> 8 ) % ulRange;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSoftwareTimerCallback( TimerHandle_t xTimer )
+{
+	( void ) xTimer;
+	ucSoftwareTimerExpired = 1;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRestartSoftwareTimer( void )
+{
+	if( xTimerIsTimerActive( xSoftwareTimer ) == pdTRUE )
+	{
+		while( xTimerStop( xSoftwareTimer, 0 ) == pdFAIL )
+		{
+		}
+	}
+
+	ucSoftwareTimerExpired = 0;
+
+	while( xTimerStart( xSoftwareTimer, 0 ) == pdFAIL )
+	{
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRestartTickTimer( void )
+{
+	vTickTimerStop( &xTickTimer );
+	( void ) xTaskNotifyWait( benchEXPIRED, benchEXPIRED, NULL, 0 );
+	vTickTimerStart( &xTickTimer, benchPERIOD );
+}
+/*-----------------------------------------------------------*/
+
+/* Waits for the timer started at xStart to expire by eMethod and returns the
+simulated cycles from the tick it was due to the task seeing it. */
+static uint64_t prvWaitForExpiry( BenchMethod_t eMethod, TickType_t xStart )
+{
+uint32_t ulBits;
+BaseType_t xExpired = pdFALSE;
+
+	while( xExpired == pdFALSE )
+	{
+		switch( eMethod )
+		{
+			case eSoftwareTimerPoll:
+				vTaskDelay( benchPOLL );
+				xExpired = ( ucSoftwareTimerExpired != 0 ) ? pdTRUE : pdFALSE;
+				break;
+
+			case eTickTimerPoll:
+				ulBits = 0;
+				( void ) xTaskNotifyWait( 0, benchEXPIRED, &ulBits, benchPOLL );
+				xExpired = ( ( ulBits & benchEXPIRED ) != 0 ) ? pdTRUE : pdFALSE;
+				break;
+
+			default:
+				ulBits = 0;
+				( void ) xTaskNotifyWait( 0, benchEXPIRED, &ulBits, portMAX_DELAY );
+				xExpired = ( ( ulBits & benchEXPIRED ) != 0 ) ? pdTRUE : pdFALSE;
+				break;
+		}
+
+		/* The rest of a pass of loadManagerTask. */
+		if( xExpired == pdFALSE )
+		{
+			vPortSimConsume( 2000 + prvRandom( 20000 ) );
+		}
+	}
+
+	return ullPortSimGetCycles() - ( ( uint64_t ) ( xStart + benchPERIOD ) * benchCYCLES_PER_TICK );
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchTask( void *pvParameters )
+{
+uint64_t ullStart, ullSoftwareRestart = UINT64_MAX, ullTickRestart = UINT64_MAX, ullLatency;
+uint64_t ullLatencyTotal[ eMethodCount ] = { 0 }, ullLatencyMax[ eMethodCount ] = { 0 };
+uint32_t ulRepeat, ul;
+BenchMethod_t eMethod;
+TickType_t xStart;
+
+	( void ) pvParameters;
+
+	vTickTimerInit( &xTickTimer, xTaskGetCurrentTaskHandle(), benchEXPIRED );
+
+	/* Simulated time stands still here, so neither timer can expire. */
+	for( ulRepeat = 0; ulRepeat < benchREPEATS; ulRepeat++ )
+	{
+		ullStart = prvNowNs();
+		for( ul = 0; ul < benchRESTARTS; ul++ )
+		{
+			prvRestartSoftwareTimer();
+		}
+		ullStart = prvNowNs() - ullStart;
+		if( ullStart < ullSoftwareRestart )
+		{
+			ullSoftwareRestart = ullStart;
+		}
+
+		ullStart = prvNowNs();
+		for( ul = 0; ul < benchRESTARTS; ul++ )
+		{
+			prvRestartTickTimer();
+		}
+		ullStart = prvNowNs() - ullStart;
+		if( ullStart < ullTickRestart )
+		{
+			ullTickRestart = ullStart;
+		}
+	}
+
+	xTimerStop( xSoftwareTimer, 0 );
+	vTickTimerStop( &xTickTimer );
+
+	for( eMethod = eSoftwareTimerPoll; eMethod < eMethodCount; eMethod++ )
+	{
+		for( ul = 0; ul < benchWINDOWS; ul++ )
+		{
+			/* Start each window part way through a tick. */
+			vPortSimConsume( prvRandom( 3 * benchCYCLES_PER_TICK ) );
+
+			xStart = xTaskGetTickCount();
+			if( eMethod == eSoftwareTimerPoll )
+			{
+				prvRestartSoftwareTimer();
+			}
+			else
+			{
+				prvRestartTickTimer();
+			}
+
+			/* Work done after the restart in the same pass, such as shedding
+			a load and printing it, which moves the 10ms poll off the timer's
+			start. */
+			vPortSimConsume( prvRandom( benchPOLL * benchCYCLES_PER_TICK ) );
+
+			ullLatency = prvWaitForExpiry( eMethod, xStart );
+			ullLatencyTotal[ eMethod ] += ullLatency;
+			if( ullLatency > ullLatencyMax[ eMethod ] )
+			{
+				ullLatencyMax[ eMethod ] = ullLatency;
+			}
+		}
+	}
+
+	printf( "stability timer restart, ns (host, best of %d runs of %d)\n", benchREPEATS, benchRESTARTS );
+	printf( "  %-28s %8.1f\n", "software timer", ( double ) ullSoftwareRestart / benchRESTARTS );
+	printf( "  %-28s %8.1f\n", "tick timer", ( double ) ullTickRestart / benchRESTARTS );
+	printf( "expiry to action, us (simulated, %d windows of %lu ticks)\n", benchWINDOWS, ( unsigned long ) benchPERIOD );
+	printf( "  %-28s %8s %8s\n", "", "avg", "max" );
+	for( eMethod = eSoftwareTimerPoll; eMethod < eMethodCount; eMethod++ )
+	{
+		printf( "  %-28s %8.1f %8.1f\n", pcMethodNames[ eMethod ],
+				( double ) ullLatencyTotal[ eMethod ] / ( benchWINDOWS * benchCYCLES_PER_US ),
+				( double ) ullLatencyMax[ eMethod ] / benchCYCLES_PER_US );
+	}
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationIdleHook( void )
+{
+	vPortSimConsume( 1000 );
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint16_t *pusIdleTaskStackSize )
+{
+	*ppxIdleTaskTCBBuffer = &xIdleTaskBuffer;
+	*ppxIdleTaskStackBuffer = xIdleTaskStack;
+	*pusIdleTaskStackSize = benchSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint16_t *pusTimerTaskStackSize )
+{
+	*ppxTimerTaskTCBBuffer = &xTimerTaskBuffer;
+	*ppxTimerTaskStackBuffer = xTimerTaskStack;
+	*pusTimerTaskStackSize = benchSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	xSoftwareTimer = xTimerCreateStatic( "stable", benchPERIOD, pdFALSE, NULL, prvSoftwareTimerCallback, &xSoftwareTimerBuffer );
+
+	/* loadManagerTask's priority. */
+	xTaskCreateStatic( prvBenchTask, "bench", benchSTACK_DEPTH, NULL, 2, xBenchTaskStack, &xBenchTaskBuffer );
+
+	vTaskStartScheduler();
+
+	return 0;
+}
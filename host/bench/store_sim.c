@@ -0,0 +1,903 @@
+/*
+ * Host simulation of the relay persistent store (store.c) on a RAM model of
+ * the NOR flash.
+ *
+ *   store_sim
+ *
+ * The model keeps the rules that matter to the store: an erase sets a whole
+ * block to 0xFF, programming can only clear bits, and a request to set one is
+ * counted as a violation and checked for at the end.  Each erase is counted
+ * per block, to show the wear.  When timed, it charges vPortSimConsume() with
+ * times assumed for the board's CFI flash, which were not measured:
+ * simREAD_CYCLES a byte read, simPROGRAM_CYCLES a byte programmed and
+ * simERASE_CYCLES a block erased.  It can also be armed to lose power after a
+ * given number of bytes programmed: the write in progress stops part way, an
+ * erase in progress clears only the first half of its block, and everything
+ * after fails until the model is reset.
+ *
+ * First, the scheduler runs a task shaped like loadManagerTask taking a sample
+ * every 20ms, shedding and reconnecting loads with an event each, updating
+ * its reaction statistics and now and then its thresholds, above a flush task
+ * shaped like Relay.c's storeTask on the board's 8 blocks of 64KiB.  The time
+ * each flush spends waiting on the flash and how late the control task ever
+ * woke are printed: the first is what the control path would lose to a write
+ * made in line, the second what it loses with the store.
+ *
+ * Then, with the scheduler stopped and the model untimed:
+ *
+ *   - a long random workload on 8 blocks of 4KiB, restarted with xStoreInit()
+ *     every so often without a flush, checks that the values read back are
+ *     those last flushed, that the events read back have no gap (each carries
+ *     a sequence number) and that the blocks are worn evenly;
+ *   - a flush that starts a new block has power cut after every number of
+ *     bytes it programs in turn.  After each restart every value must be the
+ *     one before the flush or the one it was writing, the events must have no
+ *     gap and end between the two, and the store must go on working;
+ *   - the bytes xStoreInit() reads with the newest of the board's blocks full
+ *     are compared with reading all of them;
+ *   - host nanoseconds per xStoreSetValue() and xStoreAppendEvent() are timed
+ *     in batches, the fastest of simBATCHES.
+ *
+ * Exits with 1 if any check fails.  Only host and model figures are printed;
+ * nothing here was measured on the board.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "store.h"
+
+/* The board's store, as Relay.c sets it up, and a small one for the checks. */
+#define simBOARD_BLOCKS			8
+#define simBOARD_BLOCK_SIZE		( 64UL * 1024UL )
+#define simSMALL_BLOCKS			8
+#define simSMALL_BLOCK_SIZE		( 4UL * 1024UL )
+#define simFLASH_SIZE			( simBOARD_BLOCKS * simBOARD_BLOCK_SIZE )
+
+/* Assumed flash times in 100MHz cycles: 100ns a byte read, 10us a byte
+programmed and 500ms a block erased.  Not measured. */
+#define simREAD_CYCLES			10ULL
+#define simPROGRAM_CYCLES		1000ULL
+#define simERASE_CYCLES			50000000ULL
+
+#define simSECONDS				1200
+#define simSAMPLE_TICKS			( ( TickType_t ) 20 )
+#define simSAG_SAMPLES			100
+#define simRECONNECT_SAMPLES	15
+#define simTHRESHOLD_SAMPLES	1500
+#define simFLUSH_TICKS			( ( TickType_t ) 10000 )
+#define simSAMPLE_CYCLES		20000
+#define simLOADS				5
+
+#define simRANDOM_OPERATIONS	200000
+#define simRESTART_EVERY		5000
+#define simBATCHES				2000
+#define simBATCH_EVENTS			20
+
+/* Keys and events, as Relay.c numbers them. */
+#define simKEY_THRESHOLDS		0
+#define simKEY_REACTION_STATS	1
+#define simKEY_BOOT_COUNT		2
+#define simEVENT_SHED			1
+#define simEVENT_RECONNECT		2
+#define simEVENT_SIZE			8
+
+#define simSTACK_DEPTH			( 256 )
+
+typedef struct xSIM_FLASH
+{
+	uint8_t ucBytes[ simFLASH_SIZE ];
+	uint32_t ulErases[ simBOARD_BLOCKS ];
+	uint32_t ulBlockSize;
+	uint32_t ulViolations;
+	BaseType_t xTimed;
+	uint64_t ullBusyCycles;		/* Charged since last cleared. */
+	long lCutAfter;				/* Bytes left to program before power is lost, -1 for never. */
+	BaseType_t xCut;
+} SimFlash_t;
+
+static SimFlash_t xFlash;
+
+static StaticTask_t xControlTaskBuffer, xFlushTaskBuffer, xIdleTaskBuffer, xTimerTaskBuffer;
+static StackType_t xControlTaskStack[ simSTACK_DEPTH ], xFlushTaskStack[ simSTACK_DEPTH ], xIdleTaskStack[ simSTACK_DEPTH ], xTimerTaskStack[ simSTACK_DEPTH ];
+
+static uint32_t ulRandom = 0x2545F491UL;
+static uint32_t ulFailures = 0;
+
+/* Reported once the scheduler stops. */
+static uint64_t ullMaxLateCycles = 0, ullMaxFlushBusy = 0, ullFlushBusyTotal = 0;
+static uint32_t ulSamples = 0, ulTimedFlushes = 0, ulSimEvents = 0;
+static volatile BaseType_t xFinished = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNowNs( void )
+{
+struct timespec xNow;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+static void prvKeepFastest( uint64_t *pullFastest, uint64_t ullNs )
+{
+	if( ullNs < *pullFastest )
+	{
+		*pullFastest = ullNs;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRandom( void )
+{
+	ulRandom ^= ulRandom << 13;
+	ulRandom ^= ulRandom >> 17;
+	ulRandom ^= ulRandom << 5;
+	return ulRandom;
+}
+/*-----------------------------------------------------------*/
+
+static void prvFail( const char *pcWhat, unsigned long ulDetail )
+{
+	/* The first few are enough to go on. */
+	if( ulFailures < 10 )
+	{
+		printf( "  FAILED: %s (%lu)\n", pcWhat, ulDetail );
+	}
+	ulFailures++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCharge( uint64_t ullCycles )
+{
+	if( xFlash.xTimed != pdFALSE )
+	{
+		xFlash.ullBusyCycles += ullCycles;
+		vPortSimConsume( ( uint32_t ) ullCycles );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvFlashRead( void *pvContext, uint32_t ulOffset, void *pvBuffer, size_t xLength )
+{
+	( void ) pvContext;
+
+	if( ( xFlash.xCut != pdFALSE ) || ( ( ulOffset + xLength ) > sizeof( xFlash.ucBytes ) ) )
+	{
+		return pdFAIL;
+	}
+
+	memcpy( pvBuffer, &( xFlash.ucBytes[ ulOffset ] ), xLength );
+	prvCharge( simREAD_CYCLES * xLength );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvFlashProgram( void *pvContext, uint32_t ulOffset, const void *pvData, size_t xLength )
+{
+const uint8_t *pucData = ( const uint8_t * ) pvData;
+size_t x, xProgram = xLength;
+
+	( void ) pvContext;
+
+	if( ( xFlash.xCut != pdFALSE ) || ( ( ulOffset + xLength ) > sizeof( xFlash.ucBytes ) ) )
+	{
+		return pdFAIL;
+	}
+
+	if( xFlash.lCutAfter >= 0 )
+	{
+		if( ( long ) xLength > xFlash.lCutAfter )
+		{
+			xProgram = ( size_t ) xFlash.lCutAfter;
+			xFlash.xCut = pdTRUE;
+		}
+		xFlash.lCutAfter -= ( long ) xProgram;
+	}
+
+	for( x = 0; x < xProgram; x++ )
+	{
+		if( ( pucData[ x ] & ~xFlash.ucBytes[ ulOffset + x ] ) != 0U )
+		{
+			xFlash.ulViolations++;
+		}
+		xFlash.ucBytes[ ulOffset + x ] &= pucData[ x ];
+	}
+	prvCharge( simPROGRAM_CYCLES * xProgram );
+
+	return ( xFlash.xCut == pdFALSE ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvFlashErase( void *pvContext, uint32_t ulOffset )
+{
+	( void ) pvContext;
+
+	if( ( xFlash.xCut != pdFALSE ) || ( ( ulOffset % xFlash.ulBlockSize ) != 0UL ) || ( ( ulOffset + xFlash.ulBlockSize ) > sizeof( xFlash.ucBytes ) ) )
+	{
+		return pdFAIL;
+	}
+
+	xFlash.ulErases[ ulOffset / xFlash.ulBlockSize ]++;
+
+	/* Power lost with nothing left to program cuts the erase short. */
+	if( xFlash.lCutAfter == 0 )
+	{
+		memset( &( xFlash.ucBytes[ ulOffset ] ), 0xFF, xFlash.ulBlockSize / 2UL );
+		xFlash.xCut = pdTRUE;
+		return pdFAIL;
+	}
+
+	memset( &( xFlash.ucBytes[ ulOffset ] ), 0xFF, xFlash.ulBlockSize );
+	prvCharge( simERASE_CYCLES );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static const StoreFlash_t xBoardStore = { prvFlashRead, prvFlashProgram, prvFlashErase, NULL, 0, simBOARD_BLOCK_SIZE, simBOARD_BLOCKS };
+static const StoreFlash_t xSmallStore = { prvFlashRead, prvFlashProgram, prvFlashErase, NULL, 0, simSMALL_BLOCK_SIZE, simSMALL_BLOCKS };
+
+/*
+ * A new, erased device with blocks of ulBlockSize.
+ */
+static void prvFlashReset( uint32_t ulBlockSize )
+{
+	memset( xFlash.ucBytes, 0xFF, sizeof( xFlash.ucBytes ) );
+	memset( xFlash.ulErases, 0x00, sizeof( xFlash.ulErases ) );
+	xFlash.ulBlockSize = ulBlockSize;
+	xFlash.ulViolations = 0;
+	xFlash.xTimed = pdFALSE;
+	xFlash.ullBusyCycles = 0;
+	xFlash.lCutAfter = -1;
+	xFlash.xCut = pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * The event Relay.c's storeEvent() writes: the boot count, the tick and the
+ * load, here with the load's state as its last byte.
+ */
+static void prvAppendRelayEvent( uint8_t ucType, uint32_t ulTick, uint8_t ucLoad )
+{
+uint8_t ucEvent[ simEVENT_SIZE ] = { 0 };
+
+	ucEvent[ 0 ] = 1;
+	memcpy( &( ucEvent[ 2 ] ), &ulTick, sizeof( ulTick ) );
+	ucEvent[ 6 ] = ucLoad;
+	ucEvent[ 7 ] = ( ucType == simEVENT_SHED ) ? 0U : 1U;
+	xStoreAppendEvent( ucType, ucEvent, sizeof( ucEvent ) );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Stands in for loadManagerTask: a sample every 20ms, a sag every two seconds
+ * that sheds every load and then reconnects them one every 300ms.
+ */
+static void prvControlTask( void *pvParameters )
+{
+TickType_t xNow, xEnd = ( TickType_t ) simSECONDS * configTICK_RATE_HZ;
+uint64_t ullDue, ullLate;
+uint16_t usThresholds[ 2 ] = { 490, 150 };
+uint32_t ulStats[ 4 ] = { 0, UINT32_MAX, 0, 0 };
+uint32_t ulReaction;
+uint8_t ucLoads = ( 1U << simLOADS ) - 1U, ucLoad;
+uint32_t ulPhase;
+
+	( void ) pvParameters;
+
+	xStoreSetValue( simKEY_THRESHOLDS, usThresholds, sizeof( usThresholds ) );
+
+	for( ;; )
+	{
+		xNow = xTaskGetTickCount();
+		if( xNow >= xEnd )
+		{
+			break;
+		}
+
+		vPortSimConsume( simSAMPLE_CYCLES );
+
+		/* Shed a load on each of the first samples of a sag, lowest first,
+		then reconnect them highest first. */
+		ulPhase = ulSamples % simSAG_SAMPLES;
+		if( ulPhase < simLOADS )
+		{
+			ucLoad = ( uint8_t ) ulPhase;
+			ucLoads &= ( uint8_t ) ~( 1U << ucLoad );
+			prvAppendRelayEvent( simEVENT_SHED, ( uint32_t ) xNow, ucLoad );
+			ulSimEvents++;
+
+			ulReaction = 200U + ( prvRandom() % 2000U );
+			ulStats[ 0 ]++;
+			ulStats[ 1 ] = ( ulReaction < ulStats[ 1 ] ) ? ulReaction : ulStats[ 1 ];
+			ulStats[ 2 ] = ( ulReaction > ulStats[ 2 ] ) ? ulReaction : ulStats[ 2 ];
+			ulStats[ 3 ] = ulReaction;
+			xStoreSetValue( simKEY_REACTION_STATS, ulStats, sizeof( ulStats ) );
+		}
+		else if( ( ulPhase != 0U ) && ( ( ulPhase % simRECONNECT_SAMPLES ) == 0U ) && ( ulPhase <= ( simLOADS * simRECONNECT_SAMPLES ) ) )
+		{
+			ucLoad = ( uint8_t ) ( simLOADS - ( ulPhase / simRECONNECT_SAMPLES ) );
+			ucLoads |= ( uint8_t ) ( 1U << ucLoad );
+			prvAppendRelayEvent( simEVENT_RECONNECT, ( uint32_t ) xNow, ucLoad );
+			ulSimEvents++;
+		}
+
+		if( ( ulSamples % simTHRESHOLD_SAMPLES ) == ( simTHRESHOLD_SAMPLES - 1U ) )
+		{
+			usThresholds[ 0 ] = ( uint16_t ) ( 480U + ( prvRandom() % 20U ) );
+			xStoreSetValue( simKEY_THRESHOLDS, usThresholds, sizeof( usThresholds ) );
+		}
+
+		ulSamples++;
+		xNow = xTaskGetTickCount();
+		vTaskDelay( simSAMPLE_TICKS );
+
+		ullDue = ( uint64_t ) ( xNow + simSAMPLE_TICKS ) * ( TIMER1MS_FREQ / configTICK_RATE_HZ );
+		ullLate = ullPortSimGetCycles() - ullDue;
+		if( ullLate > ullMaxLateCycles )
+		{
+			ullMaxLateCycles = ullLate;
+		}
+	}
+
+	xFinished = pdTRUE;
+	vTaskSuspend( NULL );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Stands in for Relay.c's storeTask.
+ */
+static void prvFlushTask( void *pvParameters )
+{
+uint64_t ullBusy;
+
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		ulTaskNotifyTake( pdTRUE, simFLUSH_TICKS );
+
+		xFlash.ullBusyCycles = 0;
+		if( xStoreFlush() != pdPASS )
+		{
+			prvFail( "flush on the board geometry", 0 );
+		}
+		ullBusy = xFlash.ullBusyCycles;
+
+		if( ullBusy != 0ULL )
+		{
+			ulTimedFlushes++;
+			ullFlushBusyTotal += ullBusy;
+			if( ullBusy > ullMaxFlushBusy )
+			{
+				ullMaxFlushBusy = ullBusy;
+			}
+		}
+
+		if( xFinished != pdFALSE )
+		{
+			break;
+		}
+	}
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * What the checks expect: the values and the last event sequence number as
+ * last flushed, and as set since.
+ */
+typedef struct xSIM_MODEL
+{
+	uint8_t ucFlushed[ configSTORE_KEYS ][ storeMAX_VALUE ];
+	uint8_t ucFlushedLength[ configSTORE_KEYS ];
+	uint8_t ucSet[ configSTORE_KEYS ][ storeMAX_VALUE ];
+	uint8_t ucSetLength[ configSTORE_KEYS ];
+	uint32_t ulFlushedSequence;
+	uint32_t ulSetSequence;
+} SimModel_t;
+
+static SimModel_t xModel;
+
+static void prvModelSet( uint8_t ucKey )
+{
+size_t xLength = 1U + ( prvRandom() % storeMAX_VALUE ), x;
+
+	for( x = 0; x < xLength; x++ )
+	{
+		xModel.ucSet[ ucKey ][ x ] = ( uint8_t ) prvRandom();
+	}
+	xModel.ucSetLength[ ucKey ] = ( uint8_t ) xLength;
+
+	if( xStoreSetValue( ucKey, xModel.ucSet[ ucKey ], xLength ) != pdPASS )
+	{
+		prvFail( "set value", ucKey );
+	}
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * An event carrying the next sequence number, of 4 to storeMAX_EVENT bytes.
+ */
+static void prvModelAppend( void )
+{
+uint8_t ucEvent[ storeMAX_EVENT ];
+uint32_t ulSequence = xModel.ulSetSequence + 1UL;
+size_t xLength = 4U + ( prvRandom() % ( storeMAX_EVENT - 3U ) );
+
+	memset( ucEvent, ( int ) ( ulSequence & 0xFFUL ), sizeof( ucEvent ) );
+	memcpy( ucEvent, &ulSequence, sizeof( ulSequence ) );
+
+	/* A full batch drops the event, so its number is used for the next. */
+	if( xStoreAppendEvent( ( uint8_t ) ( ulSequence & 0x7FUL ), ucEvent, xLength ) == pdPASS )
+	{
+		xModel.ulSetSequence = ulSequence;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvModelFlushed( void )
+{
+	memcpy( xModel.ucFlushed, xModel.ucSet, sizeof( xModel.ucFlushed ) );
+	memcpy( xModel.ucFlushedLength, xModel.ucSetLength, sizeof( xModel.ucFlushedLength ) );
+	xModel.ulFlushedSequence = xModel.ulSetSequence;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * After a restart: what was set and not flushed is gone.
+ */
+static void prvModelRestarted( void )
+{
+	memcpy( xModel.ucSet, xModel.ucFlushed, sizeof( xModel.ucSet ) );
+	memcpy( xModel.ucSetLength, xModel.ucFlushedLength, sizeof( xModel.ucSetLength ) );
+	xModel.ulSetSequence = xModel.ulFlushedSequence;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Reads the event log back and checks the sequence numbers run without a gap
+ * and end at one from ulLowest to ulHighest.  Returns the last, 0 if none.
+ */
+static uint32_t prvCheckEvents( uint32_t ulLowest, uint32_t ulHighest, uint32_t *pulCount )
+{
+StoreCursor_t xCursor;
+StoreEvent_t xEvent;
+uint32_t ulSequence, ulLast = 0, ulCount = 0;
+size_t x;
+
+	vStoreCursorInit( &xCursor );
+	while( xStoreReadEvent( &xCursor, &xEvent ) != pdFALSE )
+	{
+		memcpy( &ulSequence, xEvent.ucData, sizeof( ulSequence ) );
+
+		if( ( xEvent.ucLength < 4U ) || ( xEvent.ucType != ( uint8_t ) ( ulSequence & 0x7FUL ) ) )
+		{
+			prvFail( "event read back as written", ulSequence );
+		}
+		for( x = 4; x < xEvent.ucLength; x++ )
+		{
+			if( xEvent.ucData[ x ] != ( uint8_t ) ( ulSequence & 0xFFUL ) )
+			{
+				prvFail( "event data read back as written", ulSequence );
+				break;
+			}
+		}
+
+		if( ( ulCount != 0UL ) && ( ulSequence != ( ulLast + 1UL ) ) )
+		{
+			prvFail( "events without a gap", ulSequence );
+		}
+		ulLast = ulSequence;
+		ulCount++;
+	}
+
+	if( ( ulLast < ulLowest ) || ( ulLast > ulHighest ) )
+	{
+		prvFail( "last event read back", ulLast );
+	}
+
+	if( pulCount != NULL )
+	{
+		*pulCount = ulCount;
+	}
+
+	return ulLast;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Checks every value read back is the one flushed or, if xInFlight is pdTRUE,
+ * the one being flushed, and takes what was read back as flushed.
+ */
+static void prvCheckValues( BaseType_t xInFlight )
+{
+uint8_t ucValue[ storeMAX_VALUE ];
+size_t xLength;
+uint8_t ucKey;
+BaseType_t xFlushed, xSet;
+
+	for( ucKey = 0; ucKey < configSTORE_KEYS; ucKey++ )
+	{
+		xLength = xStoreGetValue( ucKey, ucValue, sizeof( ucValue ) );
+
+		xFlushed = ( ( xLength == xModel.ucFlushedLength[ ucKey ] ) && ( memcmp( ucValue, xModel.ucFlushed[ ucKey ], xLength ) == 0 ) ) ? pdTRUE : pdFALSE;
+		xSet = ( ( xLength == xModel.ucSetLength[ ucKey ] ) && ( memcmp( ucValue, xModel.ucSet[ ucKey ], xLength ) == 0 ) ) ? pdTRUE : pdFALSE;
+
+		if( ( xFlushed == pdFALSE ) && ( ( xInFlight == pdFALSE ) || ( xSet == pdFALSE ) ) )
+		{
+			prvFail( "value read back", ucKey );
+		}
+
+		/* Whichever it was is now what is held. */
+		xModel.ucFlushedLength[ ucKey ] = ( uint8_t ) xLength;
+		memcpy( xModel.ucFlushed[ ucKey ], ucValue, xLength );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRestart( const StoreFlash_t *pxStore )
+{
+	if( xStoreInit( pxStore ) != pdPASS )
+	{
+		prvFail( "xStoreInit", 0 );
+	}
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Random sets, appends and flushes, restarting without a flush every
+ * simRESTART_EVERY operations.
+ */
+static void prvRandomWorkload( void )
+{
+StoreStats_t xStats;
+uint32_t ulOperation, ulChoice, ulBlock, ulMin = UINT32_MAX, ulMax = 0, ulCount = 0, ulRestarts = 0;
+
+	prvFlashReset( simSMALL_BLOCK_SIZE );
+	memset( &xModel, 0x00, sizeof( xModel ) );
+	prvRestart( &xSmallStore );
+
+	for( ulOperation = 1; ulOperation <= simRANDOM_OPERATIONS; ulOperation++ )
+	{
+		ulChoice = prvRandom() % 100U;
+		if( ulChoice < 20U )
+		{
+			prvModelSet( ( uint8_t ) ( prvRandom() % configSTORE_KEYS ) );
+		}
+		else if( ulChoice < 95U )
+		{
+			prvModelAppend();
+		}
+		else
+		{
+			if( xStoreFlush() != pdPASS )
+			{
+				prvFail( "flush", ulOperation );
+			}
+			prvModelFlushed();
+		}
+
+		if( ( ulOperation % simRESTART_EVERY ) == 0UL )
+		{
+			prvRestart( &xSmallStore );
+			prvModelRestarted();
+			prvCheckValues( pdFALSE );
+			prvCheckEvents( xModel.ulFlushedSequence, xModel.ulFlushedSequence, &ulCount );
+			ulRestarts++;
+		}
+	}
+
+	vStoreGetStats( &xStats );
+	for( ulBlock = 0; ulBlock < simSMALL_BLOCKS; ulBlock++ )
+	{
+		ulMin = ( xFlash.ulErases[ ulBlock ] < ulMin ) ? xFlash.ulErases[ ulBlock ] : ulMin;
+		ulMax = ( xFlash.ulErases[ ulBlock ] > ulMax ) ? xFlash.ulErases[ ulBlock ] : ulMax;
+	}
+
+	if( ( ulMax - ulMin ) > 1UL )
+	{
+		prvFail( "erases even across the blocks", ulMax - ulMin );
+	}
+	if( ( xStats.ulMaxErases != ulMax ) || ( xStats.ulMinErases != ulMin ) )
+	{
+		prvFail( "erase counts in the block headers", xStats.ulMaxErases );
+	}
+
+	printf( "  random workload, %d blocks of %luKiB: %d operations, %lu restarts, %lu events flushed (%lu still readable)\n",
+			simSMALL_BLOCKS, simSMALL_BLOCK_SIZE / 1024UL, simRANDOM_OPERATIONS, ( unsigned long ) ulRestarts,
+			( unsigned long ) xModel.ulFlushedSequence, ( unsigned long ) ulCount );
+	printf( "    erases per block min %lu max %lu, as the headers count them min %lu max %lu\n",
+			( unsigned long ) ulMin, ( unsigned long ) ulMax, ( unsigned long ) xStats.ulMinErases, ( unsigned long ) xStats.ulMaxErases );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * The flush the power cut sweep cuts: changes every value and appends enough
+ * events to fill what is left of the active block.
+ */
+static void prvInFlight( void )
+{
+uint8_t ucKey;
+int i;
+
+	for( ucKey = 0; ucKey < configSTORE_KEYS; ucKey++ )
+	{
+		prvModelSet( ucKey );
+	}
+	for( i = 0; i < 12; i++ )
+	{
+		prvModelAppend();
+	}
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Fills the active block to within a few records of its end, from the same
+ * seed each time.
+ */
+static void prvBeforeCut( void )
+{
+StoreStats_t xStats;
+uint8_t ucKey;
+
+	prvFlashReset( simSMALL_BLOCK_SIZE );
+	memset( &xModel, 0x00, sizeof( xModel ) );
+	ulRandom = 0x1234567UL;
+	prvRestart( &xSmallStore );
+
+	for( ucKey = 0; ucKey < configSTORE_KEYS; ucKey++ )
+	{
+		prvModelSet( ucKey );
+	}
+
+	/* Round the ring once, so the block the flush starts was used. */
+	do
+	{
+		prvModelAppend();
+		prvModelAppend();
+		xStoreFlush();
+		prvModelFlushed();
+		vStoreGetStats( &xStats );
+	} while( ( xStats.ulSequence <= simSMALL_BLOCKS ) || ( xStats.ulUsed < ( simSMALL_BLOCK_SIZE - 100UL ) ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvPowerCutSweep( void )
+{
+StoreStats_t xStats;
+uint32_t ulProgrammed, ulBefore;
+uint32_t ulOld = 0, ulNew = 0, ulPartial = 0;
+long lCut;
+int i;
+
+	/* How much the flush programs when it is not cut. */
+	prvBeforeCut();
+	vStoreGetStats( &xStats );
+	ulBefore = xStats.ulBytesProgrammed;
+	prvInFlight();
+	xStoreFlush();
+	vStoreGetStats( &xStats );
+	ulProgrammed = xStats.ulBytesProgrammed - ulBefore;
+
+	for( lCut = 0; lCut <= ( long ) ulProgrammed; lCut++ )
+	{
+		uint32_t ulFlushed, ulLast;
+
+		prvBeforeCut();
+		ulFlushed = xModel.ulFlushedSequence;
+		prvInFlight();
+
+		xFlash.lCutAfter = lCut;
+		xStoreFlush();
+
+		/* Power back. */
+		xFlash.lCutAfter = -1;
+		xFlash.xCut = pdFALSE;
+		prvRestart( &xSmallStore );
+		prvCheckValues( pdTRUE );
+		ulLast = prvCheckEvents( ulFlushed, xModel.ulSetSequence, NULL );
+
+		if( ulLast == ulFlushed )
+		{
+			ulOld++;
+		}
+		else if( ulLast == xModel.ulSetSequence )
+		{
+			ulNew++;
+		}
+		else
+		{
+			ulPartial++;
+		}
+
+		/* Whatever survived is now what was flushed; carry on from there. */
+		xModel.ulFlushedSequence = ulLast;
+		prvModelRestarted();
+		for( i = 0; i < 400; i++ )
+		{
+			if( ( i % 50 ) == 0 )
+			{
+				prvModelSet( ( uint8_t ) ( prvRandom() % configSTORE_KEYS ) );
+			}
+			prvModelAppend();
+			if( ( i % 10 ) == 9 )
+			{
+				if( xStoreFlush() != pdPASS )
+				{
+					prvFail( "flush after a power cut", ( unsigned long ) lCut );
+				}
+				prvModelFlushed();
+			}
+		}
+
+		prvRestart( &xSmallStore );
+		prvModelRestarted();
+		prvCheckValues( pdFALSE );
+		prvCheckEvents( xModel.ulFlushedSequence, xModel.ulFlushedSequence, NULL );
+
+		if( xFlash.ulViolations != 0UL )
+		{
+			prvFail( "only erased bits programmed", ( unsigned long ) lCut );
+		}
+	}
+
+	printf( "  power cut after each of 0 to %lu bytes of a flush that starts a new block: %lu cuts kept none of its events, %lu some, %lu all\n",
+			( unsigned long ) ulProgrammed, ( unsigned long ) ulOld, ( unsigned long ) ulPartial, ( unsigned long ) ulNew );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRecoveryCost( void )
+{
+StoreStats_t xStats;
+uint64_t ullNs;
+uint32_t ulTick = 0;
+uint16_t usThresholds[ 2 ] = { 490, 150 };
+
+	prvFlashReset( simBOARD_BLOCK_SIZE );
+	prvRestart( &xBoardStore );
+	xStoreSetValue( simKEY_THRESHOLDS, usThresholds, sizeof( usThresholds ) );
+
+	/* Until the newest block is full. */
+	do
+	{
+		prvAppendRelayEvent( simEVENT_SHED, ulTick++, 0 );
+		prvAppendRelayEvent( simEVENT_RECONNECT, ulTick++, 0 );
+		xStoreFlush();
+		vStoreGetStats( &xStats );
+	} while( ( xStats.ulSequence < 2UL ) || ( xStats.ulUsed < ( simBOARD_BLOCK_SIZE - 32UL ) ) );
+
+	ullNs = prvNowNs();
+	prvRestart( &xBoardStore );
+	ullNs = prvNowNs() - ullNs;
+	vStoreGetStats( &xStats );
+
+	if( xStats.ulRecoveredValues != 1UL )
+	{
+		prvFail( "values recovered", xStats.ulRecoveredValues );
+	}
+
+	printf( "  boot recovery, %d blocks of %luKiB with the newest full: reads %lu bytes (%.1fms at the assumed read time, %.0fus on the host), a full scan %lu bytes (%.1fms)\n",
+			simBOARD_BLOCKS, simBOARD_BLOCK_SIZE / 1024UL, ( unsigned long ) xStats.ulRecoveryBytesRead,
+			( double ) ( xStats.ulRecoveryBytesRead * simREAD_CYCLES ) * 1000.0 / TIMER1MS_FREQ, ( double ) ullNs / 1000.0,
+			( unsigned long ) simFLASH_SIZE, ( double ) ( simFLASH_SIZE * simREAD_CYCLES ) * 1000.0 / TIMER1MS_FREQ );
+}
+/*-----------------------------------------------------------*/
+
+static void prvHostTimes( void )
+{
+uint64_t ullSetNs = UINT64_MAX, ullAppendNs = UINT64_MAX, ullStart;
+uint8_t ucEvent[ simEVENT_SIZE ] = { 0 };
+uint32_t ulStats[ 4 ] = { 0 };
+int iBatch, i;
+
+	prvFlashReset( simSMALL_BLOCK_SIZE );
+	prvRestart( &xSmallStore );
+	vStoreSetFlushTask( NULL );
+
+	for( iBatch = 0; iBatch < simBATCHES; iBatch++ )
+	{
+		ullStart = prvNowNs();
+		for( i = 0; i < simBATCH_EVENTS; i++ )
+		{
+			ulStats[ 0 ]++;
+			xStoreSetValue( simKEY_REACTION_STATS, ulStats, sizeof( ulStats ) );
+		}
+		prvKeepFastest( &ullSetNs, prvNowNs() - ullStart );
+
+		ullStart = prvNowNs();
+		for( i = 0; i < simBATCH_EVENTS; i++ )
+		{
+			ucEvent[ 2 ] = ( uint8_t ) i;
+			xStoreAppendEvent( simEVENT_SHED, ucEvent, sizeof( ucEvent ) );
+		}
+		prvKeepFastest( &ullAppendNs, prvNowNs() - ullStart );
+
+		xStoreFlush();
+	}
+
+	printf( "  ns per call (fastest batch of %d): xStoreSetValue of a changed 16 byte value %.1f, xStoreAppendEvent of %d bytes %.1f\n",
+			simBATCH_EVENTS, ( double ) ullSetNs / simBATCH_EVENTS, simEVENT_SIZE, ( double ) ullAppendNs / simBATCH_EVENTS );
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationIdleHook( void )
+{
+	vPortSimConsume( 1000 );
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint16_t *pusIdleTaskStackSize )
+{
+	*ppxIdleTaskTCBBuffer = &xIdleTaskBuffer;
+	*ppxIdleTaskStackBuffer = xIdleTaskStack;
+	*pusIdleTaskStackSize = simSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint16_t *pusTimerTaskStackSize )
+{
+	*ppxTimerTaskTCBBuffer = &xTimerTaskBuffer;
+	*ppxTimerTaskStackBuffer = xTimerTaskStack;
+	*pusTimerTaskStackSize = simSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+StoreStats_t xStats;
+TaskHandle_t xFlushTask;
+
+	prvFlashReset( simBOARD_BLOCK_SIZE );
+	if( xStoreInit( &xBoardStore ) != pdPASS )
+	{
+		printf( "store_sim: xStoreInit failed\n" );
+		return 1;
+	}
+	xFlash.xTimed = pdTRUE;
+
+	xTaskCreateStatic( prvControlTask, "control", simSTACK_DEPTH, NULL, 3, xControlTaskStack, &xControlTaskBuffer );
+	xFlushTask = xTaskCreateStatic( prvFlushTask, "store", simSTACK_DEPTH, NULL, 1, xFlushTaskStack, &xFlushTaskBuffer );
+	vStoreSetFlushTask( xFlushTask );
+
+	vTaskStartScheduler();
+
+	vStoreGetStats( &xStats );
+	printf( "Persistent store over %d simulated seconds (host; flash times assumed: %lluns a byte read, %lluus a byte programmed, %llums an erase)\n",
+			simSECONDS, simREAD_CYCLES * 10ULL, simPROGRAM_CYCLES / 100ULL, simERASE_CYCLES / 100000ULL );
+	printf( "  %lu samples, %lu events, %lu flushes writing %lu records, %lu bytes, %lu erases; batch high water %lu of %d bytes, %lu events dropped\n",
+			( unsigned long ) ulSamples, ( unsigned long ) ulSimEvents, ( unsigned long ) xStats.ulFlushes, ( unsigned long ) xStats.ulRecordsWritten,
+			( unsigned long ) xStats.ulBytesProgrammed, ( unsigned long ) xStats.ulErases, ( unsigned long ) xStats.xBatchHighWater,
+			configSTORE_BATCH_BYTES, ( unsigned long ) xStats.ulEventsDropped );
+	printf( "  flash busy per flush: mean %.2fms, max %.2fms (what the control task would stall for writing in line)\n",
+			( ulTimedFlushes != 0UL ) ? ( ( double ) ullFlushBusyTotal / ulTimedFlushes ) * 1000.0 / TIMER1MS_FREQ : 0.0,
+			( double ) ullMaxFlushBusy * 1000.0 / TIMER1MS_FREQ );
+	printf( "  control task woke at most %.1fus late with the flush task below it\n", ( double ) ullMaxLateCycles * 1000000.0 / TIMER1MS_FREQ );
+
+	xFlash.xTimed = pdFALSE;
+	if( ( xStats.ulFlashErrors != 0UL ) || ( xStats.ulEventsDropped != 0UL ) || ( xFlash.ulViolations != 0UL ) )
+	{
+		prvFail( "board geometry run clean", xStats.ulFlashErrors );
+	}
+
+	prvRandomWorkload();
+	prvPowerCutSweep();
+	prvRecoveryCost();
+	prvHostTimes();
+
+	if( ulFailures != 0UL )
+	{
+		printf( "store_sim: %lu checks failed\n", ( unsigned long ) ulFailures );
+		return 1;
+	}
+
+	return 0;
+}
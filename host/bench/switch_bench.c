@@ -0,0 +1,203 @@
+/*
+ * Host benchmark for the scheduler's choice of the next task to run, built
+ * once with the generic C task selection and once with the port optimised
+ * bitmap selection (configUSE_PORT_OPTIMISED_TASK_SELECTION).
+ *
+ * Runs on the simulated port.  Two operations are timed, and within them the
+ * time spent in vTaskSwitchContext(), taken by the kernel's trace hooks
+ * (switch_bench_hooks.h) less the cost of reading the clock:
+ *
+ *  - drop: the benchmark task raises its own priority to N and drops back to
+ *    1, as a task does when it gives back a mutex after priority inheritance.
+ *    Dropping yields, and the generic selection then searches down from N
+ *    through the empty ready lists to 1.  No host context switch takes place,
+ *    so this is close to the selection cost alone.
+ *  - wake: a full round trip in which the benchmark task notifies a blocked
+ *    task of priority configMAX_PRIORITIES - 1, which runs and blocks again.
+ *    This includes two host context switches, the same for both builds.
+ *
+ * Each figure is the fastest of benchREPEATS runs, in host nanoseconds per
+ * operation or per call of vTaskSwitchContext().
+ */
+#include <stdio.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define benchDROPS			1000000
+#define benchWAKES			200000
+#define benchREPEATS		5
+
+#define benchSTACK_DEPTH	( 256 )
+#define benchLOW_PRIORITY	( 1 )
+#define benchHIGH_PRIORITY	( configMAX_PRIORITIES - 1 )
+
+static StaticTask_t xBenchTaskBuffer, xWaiterBuffer, xIdleTaskBuffer, xTimerTaskBuffer;
+static StackType_t xBenchTaskStack[ benchSTACK_DEPTH ], xWaiterStack[ benchSTACK_DEPTH ];
+static StackType_t xIdleTaskStack[ benchSTACK_DEPTH ], xTimerTaskStack[ benchSTACK_DEPTH ];
+
+static TaskHandle_t xWaiter;
+static volatile uint32_t ulWaiterCount;
+
+/* Time spent in vTaskSwitchContext() and the number of calls. */
+static uint64_t ullSwitchStart, ullSwitchTotal;
+static uint32_t ulSwitchCount;
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNowNs( void )
+{
+struct timespec xNow;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+void vBenchSwitchedOut( void )
+{
+	ullSwitchStart = prvNowNs();
+}
+/*-----------------------------------------------------------*/
+
+void vBenchSwitchedIn( void )
+{
+	ullSwitchTotal += prvNowNs() - ullSwitchStart;
+	ulSwitchCount++;
+}
+/*-----------------------------------------------------------*/
+
+/* Mean cost of the hooks themselves, to take off the switch times. */
+static double prvHookCost( void )
+{
+uint64_t ullBest = UINT64_MAX;
+uint32_t ulRepeat, ul;
+
+	for( ulRepeat = 0; ulRepeat < benchREPEATS; ulRepeat++ )
+	{
+		ullSwitchTotal = 0;
+		for( ul = 0; ul < benchDROPS; ul++ )
+		{
+			vBenchSwitchedOut();
+			vBenchSwitchedIn();
+		}
+
+		if( ullSwitchTotal < ullBest )
+		{
+			ullBest = ullSwitchTotal;
+		}
+	}
+
+	return ( double ) ullBest / benchDROPS;
+}
+/*-----------------------------------------------------------*/
+
+static void prvWaiterTask( void *pvParameters )
+{
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		ulTaskNotifyTake( pdFALSE, portMAX_DELAY );
+		ulWaiterCount++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvMin( uint64_t *pullBest, uint64_t ullNs )
+{
+	if( ullNs < *pullBest )
+	{
+		*pullBest = ullNs;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchTask( void *pvParameters )
+{
+static const UBaseType_t uxDropFrom[] = { 2, 6, benchHIGH_PRIORITY };
+#define benchDROP_COUNT		( sizeof( uxDropFrom ) / sizeof( uxDropFrom[ 0 ] ) )
+uint64_t ullStart, ullDrop[ benchDROP_COUNT ], ullDropSwitch[ benchDROP_COUNT ], ullWake = UINT64_MAX, ullWakeSwitch = UINT64_MAX;
+uint32_t ulRepeat, ul, ulDrop, ulDropSwitches = 0, ulWakeSwitches = 0;
+double dHookCost;
+
+	( void ) pvParameters;
+
+	for( ulDrop = 0; ulDrop < benchDROP_COUNT; ulDrop++ )
+	{
+		ullDrop[ ulDrop ] = ullDropSwitch[ ulDrop ] = UINT64_MAX;
+	}
+
+	for( ulRepeat = 0; ulRepeat < benchREPEATS; ulRepeat++ )
+	{
+		for( ulDrop = 0; ulDrop < benchDROP_COUNT; ulDrop++ )
+		{
+			ullSwitchTotal = 0;
+			ulSwitchCount = 0;
+			ullStart = prvNowNs();
+			for( ul = 0; ul < benchDROPS; ul++ )
+			{
+				vTaskPrioritySet( NULL, uxDropFrom[ ulDrop ] );
+				vTaskPrioritySet( NULL, benchLOW_PRIORITY );
+			}
+			prvMin( &ullDrop[ ulDrop ], prvNowNs() - ullStart );
+			prvMin( &ullDropSwitch[ ulDrop ], ullSwitchTotal );
+			ulDropSwitches = ulSwitchCount;
+		}
+
+		ullSwitchTotal = 0;
+		ulSwitchCount = 0;
+		ullStart = prvNowNs();
+		for( ul = 0; ul < benchWAKES; ul++ )
+		{
+			xTaskNotifyGive( xWaiter );
+		}
+		prvMin( &ullWake, prvNowNs() - ullStart );
+		prvMin( &ullWakeSwitch, ullSwitchTotal );
+		ulWakeSwitches = ulSwitchCount;
+	}
+
+	dHookCost = prvHookCost();
+
+	printf( "Task selection, %s, ns per operation (host, best of %d runs)\n",
+			( configUSE_PORT_OPTIMISED_TASK_SELECTION == 1 ) ? "port optimised" : "generic", benchREPEATS );
+	printf( "  %-34s %9s %9s\n", "", "operation", "switch" );
+	for( ulDrop = 0; ulDrop < benchDROP_COUNT; ulDrop++ )
+	{
+		printf( "  raise to %2lu and drop to %d          %9.1f %9.1f\n", ( unsigned long ) uxDropFrom[ ulDrop ], benchLOW_PRIORITY,
+				( double ) ullDrop[ ulDrop ] / benchDROPS, ( ( double ) ullDropSwitch[ ulDrop ] / ulDropSwitches ) - dHookCost );
+	}
+	printf( "  wake priority %lu and block again   %9.1f %9.1f\n", ( unsigned long ) benchHIGH_PRIORITY,
+			( double ) ullWake / benchWAKES, ( ( double ) ullWakeSwitch / ulWakeSwitches ) - dHookCost );
+	printf( "  waiter wakes %lu of %lu\n", ( unsigned long ) ulWaiterCount, ( unsigned long ) ( benchWAKES * benchREPEATS ) );
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint16_t *pusIdleTaskStackSize )
+{
+	*ppxIdleTaskTCBBuffer = &xIdleTaskBuffer;
+	*ppxIdleTaskStackBuffer = xIdleTaskStack;
+	*pusIdleTaskStackSize = benchSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint16_t *pusTimerTaskStackSize )
+{
+	*ppxTimerTaskTCBBuffer = &xTimerTaskBuffer;
+	*ppxTimerTaskStackBuffer = xTimerTaskStack;
+	*pusTimerTaskStackSize = benchSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	xTaskCreateStatic( prvBenchTask, "bench", benchSTACK_DEPTH, NULL, benchLOW_PRIORITY, xBenchTaskStack, &xBenchTaskBuffer );
+	xWaiter = xTaskCreateStatic( prvWaiterTask, "waiter", benchSTACK_DEPTH, NULL, benchHIGH_PRIORITY, xWaiterStack, &xWaiterBuffer );
+
+	vTaskStartScheduler();
+
+	return 0;
+}
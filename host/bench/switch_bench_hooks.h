@@ -0,0 +1,18 @@
+/*
+ * Forced into every source file of the switch and timer benchmarks (gcc
+ * -include) so the kernel's context switch trace hooks call into the
+ * benchmark.  The switch benchmarks time vTaskSwitchContext() between them,
+ * which is the stack overflow check and the task selection.  The timer
+ * benchmarks time the timer service task from switch in to switch out.
+ */
+
+#ifndef SWITCH_BENCH_HOOKS_H
+#define SWITCH_BENCH_HOOKS_H
+
+extern void vBenchSwitchedOut( void );
+extern void vBenchSwitchedIn( void );
+
+#define traceTASK_SWITCHED_OUT()	vBenchSwitchedOut()
+#define traceTASK_SWITCHED_IN()		vBenchSwitchedIn()
+
+#endif /* SWITCH_BENCH_HOOKS_H */
@@ -0,0 +1,439 @@
+/*
+ * Host simulation of the relay telemetry stream (telemetry.c): sends samples
+ * and state changes as Relay.c does, drains them through a model of the
+ * serial UART and has telemetry_recv decode them from a pseudo terminal.
+ *
+ *   telemetry_sim <telemetry_recv> [receiver options]
+ *
+ * The receiver is started on the slave side of a pseudo terminal, which
+ * stands in for the serial cable.  A task shaped like Relay.c's telemetryTask
+ * drains the ring through prvUartWrite(), which takes bytes only as fast as
+ * a 115200 baud line, 10 bits a byte, empties the HAL driver's 64 byte
+ * transmit buffer in simulated time, and passes what it takes to the pseudo
+ * terminal.  So the stream and its timestamps run at the board's line rate
+ * while the host delivers them as fast as it can.
+ *
+ * The producer sends a sample every 20ms (the relay's 50Hz input) and a state
+ * change every 2.5s.  For one second in the middle it sends two samples every
+ * tick, 2000 a second, which is more than the line carries, so the ring fills
+ * and frames are dropped.  The stream ends with a heartbeat and an END frame.
+ * The receiver's sequence gaps must equal the drops counted here, as the pseudo
+ * terminal loses nothing.
+ *
+ * Last, with the drain task stopped, host nanoseconds per
+ * xTelemetrySendSample() are timed in batches that fill the ring, the fastest
+ * of simBATCHES.  Only host figures are printed; nothing here was measured on
+ * the board.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "telemetry.h"
+
+#define simSECONDS				15
+#define simBURST_START			( ( TickType_t ) 6000 )
+#define simBURST_TICKS			( ( TickType_t ) 1000 )
+#define simSAMPLE_TICKS			( ( TickType_t ) 20 )
+#define simSTATE_TICKS			( ( TickType_t ) 2500 )
+#define simHEARTBEAT_TICKS		( ( TickType_t ) 1000 )
+#define simBATCHES				2000
+
+/* The serial UART (UART_BAUD in system.h) and the HAL driver's transmit
+buffer (ALT_AVALON_UART_BUF_LEN). */
+#define simBAUD					115200ULL
+#define simUART_BUFFER			64ULL
+#define simCYCLES_PER_BYTE		( ( ( uint64_t ) TIMER1MS_FREQ * 10ULL ) / simBAUD )
+
+/* Work charged for building and checking a sample in loadManagerTask. */
+#define simSAMPLE_CYCLES		5000
+
+#define simLOADS				5
+#define simALL_LOADS			( ( 1U << simLOADS ) - 1U )
+
+/* The relay's states, as Relay.c numbers them. */
+#define simNORMAL				0
+#define simLOAD_MANAGE			1
+
+#define simSTACK_DEPTH			( 256 )
+
+static StaticTask_t xProducerTaskBuffer, xDrainTaskBuffer, xIdleTaskBuffer, xTimerTaskBuffer;
+static StackType_t xProducerTaskStack[ simSTACK_DEPTH ], xDrainTaskStack[ simSTACK_DEPTH ], xIdleTaskStack[ simSTACK_DEPTH ], xTimerTaskStack[ simSTACK_DEPTH ];
+static TaskHandle_t xDrainTask;
+
+static int iMaster = -1;
+static pid_t xReceiver = -1;
+
+/* The simulated UART: the cycle its transmitter finishes what it holds, and
+the bytes it has taken. */
+static uint64_t ullLineFreeAt = 0, ullUartBytes = 0;
+
+static uint32_t ulSamples = 0, ulStates = 0, ulSendFailures = 0, ulDropped = 0;
+static size_t xMaximumQueued = 0;
+static uint64_t ullSendNs = UINT64_MAX;
+
+static volatile BaseType_t xStopDrain = pdFALSE, xDrainStopped = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNowNs( void )
+{
+struct timespec xNow;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * As write() on the UART opened with O_NONBLOCK: takes what fits in the
+ * transmit buffer and returns 0 rather than waiting when it is full.
+ */
+static size_t prvUartWrite( const uint8_t *pucData, size_t xLength )
+{
+uint64_t ullNow = ullPortSimGetCycles(), ullHeld = 0, ullRoom;
+size_t xTaken, xWritten = 0;
+ssize_t xResult;
+
+	if( ullLineFreeAt > ullNow )
+	{
+		ullHeld = ( ullLineFreeAt - ullNow + simCYCLES_PER_BYTE - 1ULL ) / simCYCLES_PER_BYTE;
+	}
+	else
+	{
+		ullLineFreeAt = ullNow;
+	}
+	ullRoom = ( ullHeld < simUART_BUFFER ) ? ( simUART_BUFFER - ullHeld ) : 0;
+	xTaken = ( ( uint64_t ) xLength < ullRoom ) ? xLength : ( size_t ) ullRoom;
+
+	ullLineFreeAt += ( uint64_t ) xTaken * simCYCLES_PER_BYTE;
+	ullUartBytes += xTaken;
+
+	/* The receiver reads as fast as it can, so a full pseudo terminal only
+	holds up the host, not simulated time.  If the receiver has gone nothing
+	will empty it. */
+	while( xWritten < xTaken )
+	{
+		xResult = write( iMaster, &( pucData[ xWritten ] ), xTaken - xWritten );
+		if( xResult >= 0 )
+		{
+			xWritten += ( size_t ) xResult;
+		}
+		else if( ( errno == EAGAIN ) && ( waitpid( xReceiver, NULL, WNOHANG ) == 0 ) )
+		{
+			usleep( 100 );
+		}
+		else if( errno != EINTR )
+		{
+			fprintf( stderr, "telemetry_sim: receiver stopped reading\n" );
+			exit( 1 );
+		}
+	}
+
+	return xTaken;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvDiscard( const uint8_t *pucData, size_t xLength )
+{
+	( void ) pucData;
+	return xLength;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSample( int32_t lFrequency, int32_t lRoc )
+{
+	vPortSimConsume( simSAMPLE_CYCLES );
+	if( xTelemetrySendSample( ( uint16_t ) lFrequency, ( int16_t ) lRoc ) == pdFALSE )
+	{
+		ulSendFailures++;
+	}
+	ulSamples++;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Times a ring's worth of samples, then empties the ring.  The drain task
+ * must be stopped, as only one task may drain.
+ */
+static void prvTimeSends( void )
+{
+uint64_t ullStart, ullTime;
+uint32_t ulBatch, ulItem, ulPerBatch = configTELEMETRY_BUFFER_BYTES / telemetryMAX_ENCODED;
+
+	for( ulBatch = 0; ulBatch < simBATCHES; ulBatch++ )
+	{
+		ullStart = prvNowNs();
+		for( ulItem = 0; ulItem < ulPerBatch; ulItem++ )
+		{
+			( void ) xTelemetrySendSample( ( uint16_t ) ( 5000 + ulItem ), ( int16_t ) -( int32_t ) ulItem );
+		}
+		ullTime = prvNowNs() - ullStart;
+		if( ullTime < ullSendNs )
+		{
+			ullSendNs = ullTime;
+		}
+
+		( void ) xTelemetryDrain( prvDiscard );
+	}
+
+	ullSendNs /= ulPerBatch;
+}
+/*-----------------------------------------------------------*/
+
+static void prvProducerTask( void *pvParameters )
+{
+TickType_t xNow, xNextSample = 0, xNextState = simSTATE_TICKS;
+int32_t lFrequency = 5000, lPrevious = 5000;
+uint8_t ucState = simNORMAL, ucLoads = simALL_LOADS;
+
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		vTaskDelay( 1 );
+		xNow = xTaskGetTickCount();
+		if( xNow >= ( TickType_t ) ( simSECONDS * configTICK_RATE_HZ ) )
+		{
+			break;
+		}
+
+		if( ( xNow >= simBURST_START ) && ( xNow < ( simBURST_START + simBURST_TICKS ) ) )
+		{
+			/* Two samples a tick, each 0.5ms of a slow 1Hz ramp. */
+			prvSample( 5000 - ( int32_t ) ( ( xNow - simBURST_START ) / 10U ), -100 );
+			prvSample( 5000 - ( int32_t ) ( ( xNow - simBURST_START ) / 10U ), -100 );
+		}
+		else if( xNow >= xNextSample )
+		{
+			/* 50Hz with a little noise. */
+			lPrevious = lFrequency;
+			lFrequency = 5000 + ( int32_t ) ( ( xNow * 7U ) % 9U ) - 4;
+			prvSample( lFrequency, ( ( lFrequency - lPrevious ) * ( int32_t ) configTICK_RATE_HZ ) / ( int32_t ) simSAMPLE_TICKS );
+			xNextSample = xNow + simSAMPLE_TICKS;
+		}
+
+		if( xNow >= xNextState )
+		{
+			if( ucState == simNORMAL )
+			{
+				ucLoads = ( uint8_t ) ( simALL_LOADS & ~1U );
+				( void ) xTelemetrySendState( simLOAD_MANAGE, ucState, ucLoads );
+				ucState = simLOAD_MANAGE;
+			}
+			else
+			{
+				ucLoads = simALL_LOADS;
+				( void ) xTelemetrySendState( simNORMAL, ucState, ucLoads );
+				ucState = simNORMAL;
+			}
+			ulStates++;
+			xNextState = xNow + simSTATE_TICKS;
+		}
+	}
+
+	( void ) xTelemetrySendHeartbeat();
+	( void ) xTelemetrySendEnd();
+	ulDropped = ulTelemetryGetDropped();
+
+	/* Let the drain task send everything, then stop it. */
+	xStopDrain = pdTRUE;
+	while( xDrainStopped == pdFALSE )
+	{
+		vTaskDelay( simSAMPLE_TICKS );
+	}
+	vTelemetrySetDrainTask( NULL );
+	xMaximumQueued = xTelemetryGetMaximumQueued();
+
+	prvTimeSends();
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Stands in for Relay.c's telemetryTask, draining into prvUartWrite().
+ */
+static void prvDrainTask( void *pvParameters )
+{
+TickType_t xNow, xLastHeartbeat = xTaskGetTickCount();
+size_t xRemaining;
+
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		xNow = xTaskGetTickCount();
+		if( ( xNow - xLastHeartbeat ) >= simHEARTBEAT_TICKS )
+		{
+			( void ) xTelemetrySendHeartbeat();
+			xLastHeartbeat = xNow;
+		}
+
+		xRemaining = xTelemetryDrain( prvUartWrite );
+		if( ( xRemaining == 0 ) && ( xStopDrain != pdFALSE ) )
+		{
+			break;
+		}
+
+		if( xRemaining != 0 )
+		{
+			vTaskDelay( 1 );
+		}
+		else
+		{
+			ulTaskNotifyTake( pdTRUE, simHEARTBEAT_TICKS - ( xNow - xLastHeartbeat ) );
+		}
+	}
+
+	xDrainStopped = pdTRUE;
+	vTaskSuspend( NULL );
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationIdleHook( void )
+{
+	vPortSimConsume( 1000 );
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint16_t *pusIdleTaskStackSize )
+{
+	*ppxIdleTaskTCBBuffer = &xIdleTaskBuffer;
+	*ppxIdleTaskStackBuffer = xIdleTaskStack;
+	*pusIdleTaskStackSize = simSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint16_t *pusTimerTaskStackSize )
+{
+	*ppxTimerTaskTCBBuffer = &xTimerTaskBuffer;
+	*ppxTimerTaskStackBuffer = xTimerTaskStack;
+	*pusTimerTaskStackSize = simSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Opens a pseudo terminal in raw mode and starts the receiver on its slave
+ * side, with the slave's name after its own arguments.
+ */
+static pid_t prvStartReceiver( int argc, char **argv )
+{
+struct termios xTerm;
+const char *pcSlave;
+char **ppcArgs;
+int iSlave, iArg;
+pid_t xPid;
+
+	iMaster = posix_openpt( O_RDWR | O_NOCTTY | O_NONBLOCK );
+	if( ( iMaster < 0 ) || ( grantpt( iMaster ) != 0 ) || ( unlockpt( iMaster ) != 0 ) || ( ( pcSlave = ptsname( iMaster ) ) == NULL ) )
+	{
+		perror( "telemetry_sim: pseudo terminal" );
+		return -1;
+	}
+
+	/* Raw before anything is written, so no byte is translated or taken as a
+	control character even if the receiver has not opened the slave yet.  The
+	slave is kept open here so the pseudo terminal always has a reader. */
+	iSlave = open( pcSlave, O_RDWR | O_NOCTTY );
+	if( ( iSlave < 0 ) || ( tcgetattr( iSlave, &xTerm ) != 0 ) )
+	{
+		perror( pcSlave );
+		return -1;
+	}
+	cfmakeraw( &xTerm );
+	( void ) tcsetattr( iSlave, TCSANOW, &xTerm );
+
+	ppcArgs = calloc( ( size_t ) argc + 1U, sizeof( char * ) );
+	if( ppcArgs == NULL )
+	{
+		return -1;
+	}
+	for( iArg = 1; iArg < argc; iArg++ )
+	{
+		ppcArgs[ iArg - 1 ] = argv[ iArg ];
+	}
+	ppcArgs[ argc - 1 ] = ( char * ) pcSlave;
+
+	fflush( stdout );
+	xPid = fork();
+	if( xPid == 0 )
+	{
+		close( iMaster );
+		close( iSlave );
+		execv( ppcArgs[ 0 ], ppcArgs );
+		perror( ppcArgs[ 0 ] );
+		_exit( 127 );
+	}
+	free( ppcArgs );
+
+	if( xPid < 0 )
+	{
+		perror( "telemetry_sim: fork" );
+	}
+
+	return xPid;
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc, char **argv )
+{
+static const uint8_t ucCheck[] = "123456789";
+int iStatus;
+
+	if( argc < 2 )
+	{
+		fprintf( stderr, "usage: telemetry_sim <telemetry_recv> [receiver options]\n" );
+		return 1;
+	}
+
+	/* The CRC-16/CCITT-FALSE check value. */
+	if( usTelemetryCrc( telemetryCRC_INITIAL, ucCheck, 9 ) != 0x29B1U )
+	{
+		fprintf( stderr, "telemetry_sim: CRC check value 0x%04X, expected 0x29B1\n", usTelemetryCrc( telemetryCRC_INITIAL, ucCheck, 9 ) );
+		return 1;
+	}
+
+	xReceiver = prvStartReceiver( argc, argv );
+	if( xReceiver < 0 )
+	{
+		return 1;
+	}
+
+	xTaskCreateStatic( prvProducerTask, "producer", simSTACK_DEPTH, NULL, 2, xProducerTaskStack, &xProducerTaskBuffer );
+	xDrainTask = xTaskCreateStatic( prvDrainTask, "drain", simSTACK_DEPTH, NULL, 1, xDrainTaskStack, &xDrainTaskBuffer );
+	vTelemetrySetDrainTask( xDrainTask );
+
+	vTaskStartScheduler();
+
+	fflush( stdout );
+	if( ( waitpid( xReceiver, &iStatus, 0 ) != xReceiver ) || ( WIFEXITED( iStatus ) == 0 ) || ( WEXITSTATUS( iStatus ) != 0 ) )
+	{
+		fprintf( stderr, "telemetry_sim: receiver failed\n" );
+		return 1;
+	}
+	close( iMaster );
+
+	/* After the receiver's report, to check its sequence gaps against. */
+	printf( "Telemetry sender over %d simulated seconds (host), %d byte ring, %llu baud\n",
+			simSECONDS, configTELEMETRY_BUFFER_BYTES, ( unsigned long long ) simBAUD );
+	printf( "  %lu samples and %lu state changes sent, %lu frames dropped (%lu of them samples)\n", ( unsigned long ) ulSamples,
+			( unsigned long ) ulStates, ( unsigned long ) ulDropped, ( unsigned long ) ulSendFailures );
+	printf( "  %llu bytes to the UART, %.0f bytes/s, %.1f%% of the line; at most %lu bytes queued\n",
+			( unsigned long long ) ullUartBytes, ( double ) ullUartBytes / simSECONDS,
+			100.0 * ( double ) ullUartBytes * 10.0 / ( double ) ( simBAUD * simSECONDS ),
+			( unsigned long ) xMaximumQueued );
+	printf( "  ns per xTelemetrySendSample() (fastest batch of %d): %.1f\n", simBATCHES, ( double ) ullSendNs );
+
+	return 0;
+}
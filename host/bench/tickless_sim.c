@@ -0,0 +1,255 @@
+/*
+ * Tickless idle demonstration on the host simulated port.
+ *
+ * Runs a workload shaped like the relay - tasks polling every 10, 20, 50 and
+ * 200ms and a task woken from the 50Hz frequency analyser interrupt - for
+ * simDURATION_TICKS simulated ticks, then reports how many interrupts were
+ * taken.  The same source is built with configUSE_TICKLESS_IDLE 0 and 1
+ * ("make bench" runs both).  Every task folds the tick count and the
+ * simulated cycle at which it woke into a checksum, so matching checksums
+ * show that suppressing the tick did not move any wake up.
+ *
+ * With configGENERATE_RUN_TIME_STATS 1 it also prints each task's run time
+ * counter next to the cycles the task asked to consume.  Simulated time only
+ * moves in vPortSimConsume(), so the two agree unless a task was part way
+ * through its work when the run ended.
+ *
+ * With configUSE_TRACE_RECORDER 1, "tickless_sim <file>" writes the kernel
+ * trace to <file> for host/tools/trace_decode.
+ */
+#include <stdio.h>
+#include <stdarg.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "sys/alt_irq.h"
+
+/* Simulated run time. */
+#define simDURATION_TICKS		( ( TickType_t ) 10000 )
+
+/* Cycles each pass of the idle loop costs. */
+#define simIDLE_PASS_CYCLES		1000
+
+/* The frequency analyser interrupts at 50Hz, off the tick grid. */
+#define simFREQUENCY_PERIOD		( TIMER1MS_FREQ / 50 )
+#define simFREQUENCY_PHASE		1234567ULL
+
+#define simSTACK_DEPTH			( 256 )
+
+typedef struct
+{
+	const char *pcName;
+	TickType_t xPeriod;			/* 0 for the task woken by the interrupt. */
+	uint32_t ulWorkCycles;
+	UBaseType_t uxPriority;
+	uint32_t ulWakeCount;
+	TaskHandle_t xHandle;
+	uint64_t ullRunTime;
+} SimTask_t;
+
+static SimTask_t xSimTasks[] =
+{
+	{ "freq",	0,		20000,	4, 0, NULL, 0 },
+	{ "switch",	10,		5000,	3, 0, NULL, 0 },
+	{ "load",	20,		30000,	3, 0, NULL, 0 },
+	{ "lcd",	50,		80000,	2, 0, NULL, 0 },
+	{ "stats",	200,	150000,	1, 0, NULL, 0 },
+};
+#define simTASK_COUNT	( sizeof( xSimTasks ) / sizeof( xSimTasks[ 0 ] ) )
+
+static StaticTask_t xTaskBuffers[ simTASK_COUNT + 1 ];
+static StackType_t xTaskStacks[ simTASK_COUNT + 1 ][ simSTACK_DEPTH ];
+static StaticTask_t xIdleTaskBuffer, xTimerTaskBuffer;
+static StackType_t xIdleTaskStack[ simSTACK_DEPTH ], xTimerTaskStack[ simSTACK_DEPTH ];
+
+static SemaphoreHandle_t xFrequencySemaphore;
+static StaticSemaphore_t xFrequencySemaphoreBuffer;
+
+static uint64_t ullChecksum = 14695981039346656037ULL;
+
+#if( configUSE_TRACE_RECORDER == 1 )
+	static FILE *pxTraceFile;
+#endif
+
+/*-----------------------------------------------------------*/
+
+static void prvFold( uint64_t ullValue )
+{
+	/* FNV-1a over the value's bytes. */
+	uint32_t ul;
+
+	for( ul = 0; ul < 8; ul++ )
+	{
+		ullChecksum ^= ( ullValue >> ( ul * 8 ) ) & 0xFF;
+		ullChecksum *= 1099511628211ULL;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvFrequencyISR( void *pvContext, alt_u32 ulId )
+{
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	( void ) pvContext;
+	( void ) ulId;
+
+	xSemaphoreGiveFromISR( xFrequencySemaphore, &xHigherPriorityTaskWoken );
+	portEND_SWITCHING_ISR( xHigherPriorityTaskWoken );
+}
+/*-----------------------------------------------------------*/
+
+static void prvWorkTask( void *pvParameters )
+{
+SimTask_t *pxTask = ( SimTask_t * ) pvParameters;
+
+	for( ;; )
+	{
+		if( pxTask->xPeriod == 0 )
+		{
+			xSemaphoreTake( xFrequencySemaphore, portMAX_DELAY );
+		}
+		else
+		{
+			vTaskDelay( pxTask->xPeriod );
+		}
+
+		prvFold( ( uint64_t ) ( pxTask - xSimTasks ) );
+		prvFold( ( uint64_t ) xTaskGetTickCount() );
+		prvFold( ullPortSimGetCycles() );
+		pxTask->ulWakeCount++;
+
+		vPortSimConsume( pxTask->ulWorkCycles );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvControlTask( void *pvParameters )
+{
+	( void ) pvParameters;
+
+	alt_irq_register( FREQUENCY_ANALYSER_IRQ, NULL, prvFrequencyISR );
+	vPortSimSetPeriodicInterrupt( FREQUENCY_ANALYSER_IRQ, simFREQUENCY_PERIOD, simFREQUENCY_PHASE );
+
+	vTaskDelay( simDURATION_TICKS );
+
+	#if( configGENERATE_RUN_TIME_STATS == 1 )
+	{
+	uint32_t ul;
+
+		for( ul = 0; ul < simTASK_COUNT; ul++ )
+		{
+			xSimTasks[ ul ].ullRunTime = ulTaskGetRunTimeCounter( xSimTasks[ ul ].xHandle );
+		}
+	}
+	#endif
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+#if( configUSE_TRACE_RECORDER == 1 )
+
+	static int prvTracePrint( const char *pcFormat, ... )
+	{
+	va_list xArgs;
+	int iReturn;
+
+		va_start( xArgs, pcFormat );
+		iReturn = vfprintf( pxTraceFile, pcFormat, xArgs );
+		va_end( xArgs );
+
+		return iReturn;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+void vApplicationIdleHook( void )
+{
+	vPortSimConsume( simIDLE_PASS_CYCLES );
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint16_t *pusIdleTaskStackSize )
+{
+	*ppxIdleTaskTCBBuffer = &xIdleTaskBuffer;
+	*ppxIdleTaskStackBuffer = xIdleTaskStack;
+	*pusIdleTaskStackSize = simSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint16_t *pusTimerTaskStackSize )
+{
+	*ppxTimerTaskTCBBuffer = &xTimerTaskBuffer;
+	*ppxTimerTaskStackBuffer = xTimerTaskStack;
+	*pusTimerTaskStackSize = simSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc, char **argv )
+{
+uint32_t ul;
+uint64_t ullCycles;
+
+	xFrequencySemaphore = xSemaphoreCreateBinaryStatic( &xFrequencySemaphoreBuffer );
+
+	for( ul = 0; ul < simTASK_COUNT; ul++ )
+	{
+		xSimTasks[ ul ].xHandle = xTaskCreateStatic( prvWorkTask, xSimTasks[ ul ].pcName, simSTACK_DEPTH, &xSimTasks[ ul ], xSimTasks[ ul ].uxPriority, xTaskStacks[ ul ], &xTaskBuffers[ ul ] );
+	}
+	xTaskCreateStatic( prvControlTask, "control", simSTACK_DEPTH, NULL, configMAX_PRIORITIES - 1, xTaskStacks[ simTASK_COUNT ], &xTaskBuffers[ simTASK_COUNT ] );
+
+	vTaskStartScheduler();
+
+	ullCycles = ullPortSimGetCycles();
+
+	printf( "tickless idle: %s\n", ( configUSE_TICKLESS_IDLE == 1 ) ? "on" : "off" );
+	printf( "  simulated %llu cycles, tick count %lu\n", ( unsigned long long ) ullCycles, ( unsigned long ) xTaskGetTickCount() );
+	printf( "  tick interrupts %lu, frequency interrupts %lu\n",
+			( unsigned long ) ulPortSimGetInterruptCount( TIMER1MS_IRQ ),
+			( unsigned long ) ulPortSimGetInterruptCount( FREQUENCY_ANALYSER_IRQ ) );
+	printf( "  asleep %llu cycles (%llu%%)\n", ( unsigned long long ) ullPortSimGetSleepCycles(),
+			( unsigned long long ) ( ( ullPortSimGetSleepCycles() * 100ULL ) / ( ullCycles ? ullCycles : 1 ) ) );
+	printf( "  wakes" );
+	for( ul = 0; ul < simTASK_COUNT; ul++ )
+	{
+		printf( " %s=%lu", xSimTasks[ ul ].pcName, ( unsigned long ) xSimTasks[ ul ].ulWakeCount );
+	}
+	printf( "\n  wake checksum %016llx\n", ( unsigned long long ) ullChecksum );
+
+	#if( configUSE_TRACE_RECORDER == 1 )
+	{
+		if( argc > 1 )
+		{
+			pxTraceFile = fopen( argv[ 1 ], "w" );
+			if( pxTraceFile != NULL )
+			{
+				vTraceStop();
+				vTraceDump( prvTracePrint );
+				fclose( pxTraceFile );
+				printf( "  trace written to %s\n", argv[ 1 ] );
+			}
+		}
+	}
+	#else
+	{
+		( void ) argc;
+		( void ) argv;
+	}
+	#endif
+
+	#if( configGENERATE_RUN_TIME_STATS == 1 )
+	{
+		printf( "  run time (counted / consumed cycles)" );
+		for( ul = 0; ul < simTASK_COUNT; ul++ )
+		{
+			printf( " %s=%llu/%llu", xSimTasks[ ul ].pcName, ( unsigned long long ) xSimTasks[ ul ].ullRunTime,
+					( unsigned long long ) xSimTasks[ ul ].ulWakeCount * xSimTasks[ ul ].ulWorkCycles );
+		}
+		printf( "\n" );
+	}
+	#endif
+
+	return 0;
+}
@@ -0,0 +1,249 @@
+/*
+ * Host benchmark for the software timer service with its active timers kept in
+ * sorted lists or in the timer wheel (configUSE_TIMER_WHEEL), built once for
+ * each.
+ *
+ * Runs on the simulated port with 1, 10, 100 and 1000 auto reload timers
+ * running, their periods spread pseudo randomly between 1 and benchMAX_PERIOD
+ * ticks so the wheel has timers in three levels.  Three things are measured:
+ *
+ *  - reset: xTimerReset() of a random running timer, in host nanoseconds.  The
+ *    timer service task has the higher priority, so each call includes the
+ *    switches to it and back and the processing of the command.
+ *  - stop + start: xTimerStop() then xTimerStart() of a random running timer,
+ *    the same way.
+ *  - expiry: time spent in the timer service task while the timers run for
+ *    benchRUN_TICKS ticks, taken by the kernel's context switch trace hooks
+ *    (switch_bench_hooks.h), per tick and per expiry.  This includes the
+ *    callbacks, which only check the expiry happened on the tick it was due.
+ *
+ * Simulated time stands still while reset and stop + start are timed, so no
+ * timer expires.  Each figure is the fastest of benchREPEATS runs.
+ */
+#include <stdio.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+
+#define benchMAX_TIMERS			1000
+#define benchMAX_PERIOD			5000
+#define benchCOMMANDS			20000
+#define benchRUN_TICKS			( ( TickType_t ) 20000 )
+#define benchREPEATS			5
+
+#define benchSTACK_DEPTH		( 256 )
+
+static const uint32_t ulTimerCounts[] = { 1, 10, 100, 1000 };
+
+static StaticTask_t xBenchTaskBuffer, xIdleTaskBuffer, xTimerTaskBuffer;
+static StackType_t xBenchTaskStack[ benchSTACK_DEPTH ], xIdleTaskStack[ benchSTACK_DEPTH ], xTimerTaskStack[ benchSTACK_DEPTH ];
+
+static StaticTimer_t xTimerBuffers[ benchMAX_TIMERS ];
+static TimerHandle_t xTimers[ benchMAX_TIMERS ];
+
+/* Each timer's period. */
+static TickType_t xPeriods[ benchMAX_TIMERS ];
+
+/* The tick each timer is next due on, and counts of expiries and of those that
+happened on any other tick. */
+static TickType_t xExpected[ benchMAX_TIMERS ];
+static uint32_t ulExpiries, ulTotalExpiries, ulMistimed;
+
+/* Time spent in the timer service task while xTimingDaemon is set. */
+static uint64_t ullDaemonStart, ullDaemonTotal;
+static BaseType_t xTimingDaemon = pdFALSE;
+
+static uint32_t ulRandom = 0x12345678UL;
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNowNs( void )
+{
+struct timespec xNow;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRandom( uint32_t ulRange )
+{
+	ulRandom = ( ulRandom * 1103515245UL ) + 12345UL;
+	return ( ulRandom >> 8 ) % ulRange;
+}
+/*-----------------------------------------------------------*/
+
+void vBenchSwitchedOut( void )
+{
+	if( ( xTimingDaemon != pdFALSE ) && ( xTaskGetCurrentTaskHandle() == ( TaskHandle_t ) &xTimerTaskBuffer ) )
+	{
+		ullDaemonTotal += prvNowNs() - ullDaemonStart;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vBenchSwitchedIn( void )
+{
+	if( ( xTimingDaemon != pdFALSE ) && ( xTaskGetCurrentTaskHandle() == ( TaskHandle_t ) &xTimerTaskBuffer ) )
+	{
+		ullDaemonStart = prvNowNs();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvTimerCallback( TimerHandle_t xTimer )
+{
+uint32_t ulIndex = ( uint32_t ) ( uintptr_t ) pvTimerGetTimerID( xTimer );
+
+	ulExpiries++;
+	ulTotalExpiries++;
+	if( xTaskGetTickCount() != xExpected[ ulIndex ] )
+	{
+		ulMistimed++;
+	}
+
+	xExpected[ ulIndex ] += xPeriods[ ulIndex ];
+}
+/*-----------------------------------------------------------*/
+
+static void prvStartTimers( uint32_t ulCount )
+{
+uint32_t ul;
+
+	for( ul = 0; ul < ulCount; ul++ )
+	{
+		xExpected[ ul ] = xTaskGetTickCount() + xPeriods[ ul ];
+		xTimerStart( xTimers[ ul ], 0 );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvStopTimers( uint32_t ulCount )
+{
+uint32_t ul;
+
+	for( ul = 0; ul < ulCount; ul++ )
+	{
+		xTimerStop( xTimers[ ul ], 0 );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchTask( void *pvParameters )
+{
+uint64_t ullStart, ullReset, ullStopStart, ullDaemon;
+uint32_t ulCountIndex, ulCount, ulRepeat, ul, ulTimer, ulRunExpiries = 0;
+
+	( void ) pvParameters;
+
+	printf( "software timers, %s, ns (host, best of %d runs)\n", ( configUSE_TIMER_WHEEL == 1 ) ? "timer wheel" : "sorted lists", benchREPEATS );
+	printf( "  %7s %10s %14s %14s %14s\n", "timers", "reset", "stop + start", "expiry/tick", "per expiry" );
+
+	for( ulCountIndex = 0; ulCountIndex < ( sizeof( ulTimerCounts ) / sizeof( ulTimerCounts[ 0 ] ) ); ulCountIndex++ )
+	{
+		ulCount = ulTimerCounts[ ulCountIndex ];
+		ullReset = UINT64_MAX;
+		ullStopStart = UINT64_MAX;
+		ullDaemon = UINT64_MAX;
+
+		for( ulRepeat = 0; ulRepeat < benchREPEATS; ulRepeat++ )
+		{
+			prvStartTimers( ulCount );
+
+			ullStart = prvNowNs();
+			for( ul = 0; ul < benchCOMMANDS; ul++ )
+			{
+				xTimerReset( xTimers[ prvRandom( ulCount ) ], 0 );
+			}
+			ullStart = prvNowNs() - ullStart;
+			if( ullStart < ullReset )
+			{
+				ullReset = ullStart;
+			}
+
+			ullStart = prvNowNs();
+			for( ul = 0; ul < benchCOMMANDS; ul++ )
+			{
+				ulTimer = prvRandom( ulCount );
+				xTimerStop( xTimers[ ulTimer ], 0 );
+				xTimerStart( xTimers[ ulTimer ], 0 );
+			}
+			ullStart = prvNowNs() - ullStart;
+			if( ullStart < ullStopStart )
+			{
+				ullStopStart = ullStart;
+			}
+
+			/* Restart them all so each is due exactly a period from now, then
+			let them run. */
+			prvStopTimers( ulCount );
+			prvStartTimers( ulCount );
+
+			ulExpiries = 0;
+			ullDaemonTotal = 0;
+			xTimingDaemon = pdTRUE;
+			vTaskDelay( benchRUN_TICKS );
+			xTimingDaemon = pdFALSE;
+			prvStopTimers( ulCount );
+
+			if( ullDaemonTotal < ullDaemon )
+			{
+				ullDaemon = ullDaemonTotal;
+				ulRunExpiries = ulExpiries;
+			}
+		}
+
+		printf( "  %7lu %10.1f %14.1f %14.1f %14.1f\n", ( unsigned long ) ulCount,
+				( double ) ullReset / benchCOMMANDS,
+				( double ) ullStopStart / benchCOMMANDS,
+				( double ) ullDaemon / benchRUN_TICKS,
+				( ulRunExpiries != 0 ) ? ( double ) ullDaemon / ulRunExpiries : 0.0 );
+	}
+
+	printf( "  expiries %lu, not on the tick due %lu\n", ( unsigned long ) ulTotalExpiries, ( unsigned long ) ulMistimed );
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationIdleHook( void )
+{
+	vPortSimConsume( 1000 );
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint16_t *pusIdleTaskStackSize )
+{
+	*ppxIdleTaskTCBBuffer = &xIdleTaskBuffer;
+	*ppxIdleTaskStackBuffer = xIdleTaskStack;
+	*pusIdleTaskStackSize = benchSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint16_t *pusTimerTaskStackSize )
+{
+	*ppxTimerTaskTCBBuffer = &xTimerTaskBuffer;
+	*ppxTimerTaskStackBuffer = xTimerTaskStack;
+	*pusTimerTaskStackSize = benchSTACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+uint32_t ul;
+
+	for( ul = 0; ul < benchMAX_TIMERS; ul++ )
+	{
+		xPeriods[ ul ] = ( TickType_t ) ( 1 + prvRandom( benchMAX_PERIOD ) );
+		xTimers[ ul ] = xTimerCreateStatic( "bench", xPeriods[ ul ], pdTRUE, ( void * ) ( uintptr_t ) ul, prvTimerCallback, &( xTimerBuffers[ ul ] ) );
+	}
+
+	/* Below the timer service task, as application tasks normally are. */
+	xTaskCreateStatic( prvBenchTask, "bench", benchSTACK_DEPTH, NULL, 2, xBenchTaskStack, &xBenchTaskBuffer );
+
+	vTaskStartScheduler();
+
+	return 0;
+}
@@ -0,0 +1,19 @@
+/*
+ * Stand-in for the HAL alt_types.h when building on a Linux host.
+ */
+
+#ifndef __ALT_TYPES_H__
+#define __ALT_TYPES_H__
+
+#include <stdint.h>
+
+typedef int8_t		alt_8;
+typedef uint8_t		alt_u8;
+typedef int16_t		alt_16;
+typedef uint16_t	alt_u16;
+typedef int32_t		alt_32;
+typedef uint32_t	alt_u32;
+typedef int64_t		alt_64;
+typedef uint64_t	alt_u64;
+
+#endif /* __ALT_TYPES_H__ */
@@ -0,0 +1,214 @@
+/*
+ * HAL services the relay and the BSP drivers use, for building them on a
+ * Linux host.
+ *
+ * Devices are kept in a list and found by name as the HAL does.  usleep() is
+ * a busy wait in simulated time, as alt_busy_sleep() is on the board.  fopen()
+ * of a registered device name returns a stream whose writes go to the device's
+ * write function, so fprintf() to the LCD reaches the real driver; programs
+ * that want this link with -Wl,--wrap=fopen.  Other names under /dev/ fail, as
+ * they do on a HAL without that device, and the rest are host files.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "FreeRTOS.h"
+#include "system.h"
+#include "priv/alt_file.h"
+#include "sys/alt_alarm.h"
+#include "sys/alt_flash.h"
+
+/* Heads of the device lists, empty until something is registered. */
+alt_llist alt_dev_list = { &alt_dev_list, &alt_dev_list };
+static alt_llist xFlashDevList = { &xFlashDevList, &xFlashDevList };
+
+/* Set by the system clock driver on the board, from TIMER1MS. */
+alt_u32 _alt_tick_rate = configTICK_RATE_HZ;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Adds pxEntry to the end of pxList.
+ */
+static void prvListInsert( alt_llist *pxList, alt_llist *pxEntry );
+
+/*
+ * Returns the entry of pxList whose name, which follows the list links in
+ * both kinds of device, is pcName, or NULL.
+ */
+static alt_llist *prvListFind( const char *pcName, alt_llist *pxList );
+
+/*
+ * Cookie write function for a stream opened on a device.
+ */
+static ssize_t prvDeviceWrite( void *pvCookie, const char *pcBuffer, size_t xSize );
+
+/*
+ * Cookie close function, frees the descriptor.
+ */
+static int prvDeviceClose( void *pvCookie );
+
+/*-----------------------------------------------------------*/
+
+static void prvListInsert( alt_llist *pxList, alt_llist *pxEntry )
+{
+	pxEntry->previous = pxList->previous;
+	pxEntry->next = pxList;
+	pxList->previous->next = pxEntry;
+	pxList->previous = pxEntry;
+}
+/*-----------------------------------------------------------*/
+
+static alt_llist *prvListFind( const char *pcName, alt_llist *pxList )
+{
+alt_llist *pxEntry;
+
+	for( pxEntry = pxList->next; pxEntry != pxList; pxEntry = pxEntry->next )
+	{
+		if( strcmp( ( ( alt_dev * ) pxEntry )->name, pcName ) == 0 )
+		{
+			return pxEntry;
+		}
+	}
+
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+int alt_dev_reg( alt_dev *dev )
+{
+	if( ( dev->name == NULL ) || ( dev->name[ 0 ] != '/' ) )
+	{
+		return -ENODEV;
+	}
+
+	prvListInsert( &alt_dev_list, &( dev->llist ) );
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+alt_dev *alt_find_dev( const char *name, alt_llist *list )
+{
+	return ( alt_dev * ) prvListFind( name, list );
+}
+/*-----------------------------------------------------------*/
+
+int alt_flash_device_register( alt_flash_fd *fd )
+{
+	prvListInsert( &xFlashDevList, &( fd->llist ) );
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+alt_flash_fd *alt_flash_open_dev( const char *name )
+{
+alt_flash_dev *pxFlash = ( alt_flash_dev * ) prvListFind( name, &xFlashDevList );
+
+	if( ( pxFlash != NULL ) && ( pxFlash->open != NULL ) )
+	{
+		return pxFlash->open( pxFlash, name );
+	}
+
+	return pxFlash;
+}
+/*-----------------------------------------------------------*/
+
+void alt_flash_close_dev( alt_flash_fd *fd )
+{
+	if( ( fd != NULL ) && ( fd->close != NULL ) )
+	{
+		fd->close( fd );
+	}
+}
+/*-----------------------------------------------------------*/
+
+int alt_alarm_start( alt_alarm *the_alarm, alt_u32 nticks, alt_u32 ( *callback )( void *context ), void *context )
+{
+	the_alarm->time = nticks;
+	the_alarm->callback = callback;
+	the_alarm->context = context;
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+void alt_alarm_stop( alt_alarm *the_alarm )
+{
+	( void ) the_alarm;
+}
+/*-----------------------------------------------------------*/
+
+int usleep( useconds_t us )
+{
+uint64_t ullCycles = ( uint64_t ) us * ( ALT_CPU_FREQ / 1000000UL );
+
+	while( ullCycles > UINT32_MAX )
+	{
+		vPortSimConsume( UINT32_MAX );
+		ullCycles -= UINT32_MAX;
+	}
+	vPortSimConsume( ( uint32_t ) ullCycles );
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+static ssize_t prvDeviceWrite( void *pvCookie, const char *pcBuffer, size_t xSize )
+{
+alt_fd *pxFd = ( alt_fd * ) pvCookie;
+int iWritten;
+
+	if( pxFd->dev->write == NULL )
+	{
+		errno = EBADF;
+		return -1;
+	}
+
+	iWritten = pxFd->dev->write( pxFd, pcBuffer, ( int ) xSize );
+	return ( iWritten < 0 ) ? -1 : iWritten;
+}
+/*-----------------------------------------------------------*/
+
+static int prvDeviceClose( void *pvCookie )
+{
+	free( pvCookie );
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+FILE *__real_fopen( const char *pcPath, const char *pcMode );
+
+FILE *__wrap_fopen( const char *pcPath, const char *pcMode )
+{
+alt_dev *pxDev;
+alt_fd *pxFd;
+cookie_io_functions_t xFunctions = { NULL, prvDeviceWrite, NULL, prvDeviceClose };
+
+	if( strncmp( pcPath, "/dev/", 5 ) != 0 )
+	{
+		return __real_fopen( pcPath, pcMode );
+	}
+
+	pxDev = alt_find_dev( pcPath, &alt_dev_list );
+	if( pxDev == NULL )
+	{
+		errno = ENODEV;
+		return NULL;
+	}
+
+	/* The descriptor lives as long as the stream. */
+	pxFd = ( alt_fd * ) calloc( 1, sizeof( alt_fd ) );
+	if( pxFd == NULL )
+	{
+		return NULL;
+	}
+	pxFd->dev = pxDev;
+
+	return fopencookie( pxFd, pcMode, xFunctions );
+}
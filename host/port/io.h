@@ -0,0 +1,33 @@
+/*
+ * Stand-in for the HAL io.h when building on a Linux host.
+ *
+ * Register accesses made through the BSP register headers (for example
+ * altera_avalon_timer_regs.h) and the drivers are routed to the peripheral
+ * models in port.c instead of the Avalon bus.
+ */
+
+#ifndef __IO_H__
+#define __IO_H__
+
+#include "alt_types.h"
+
+extern alt_u32 ulPortSimIORead( alt_u32 ulBase, alt_u32 ulRegister );
+extern void vPortSimIOWrite( alt_u32 ulBase, alt_u32 ulRegister, alt_u32 ulData );
+
+#define __IO_CALC_ADDRESS_NATIVE( BASE, REGNUM )	( ( void * ) ( ( ( alt_u8 * ) ( uintptr_t ) ( BASE ) ) + ( ( REGNUM ) * 4 ) ) )
+
+#define IORD( BASE, REGNUM )			ulPortSimIORead( ( alt_u32 ) ( BASE ), ( alt_u32 ) ( REGNUM ) )
+#define IOWR( BASE, REGNUM, DATA )		vPortSimIOWrite( ( alt_u32 ) ( BASE ), ( alt_u32 ) ( REGNUM ), ( alt_u32 ) ( DATA ) )
+
+extern alt_u32 ulPortSimIOReadDirect( alt_u32 ulAddress, alt_u32 ulBytes );
+extern void vPortSimIOWriteDirect( alt_u32 ulAddress, alt_u32 ulData, alt_u32 ulBytes );
+
+#define IORD_32DIRECT( BASE, OFFSET )			ulPortSimIOReadDirect( ( alt_u32 ) ( BASE ) + ( alt_u32 ) ( OFFSET ), 4 )
+#define IORD_16DIRECT( BASE, OFFSET )			( ( alt_u16 ) ulPortSimIOReadDirect( ( alt_u32 ) ( BASE ) + ( alt_u32 ) ( OFFSET ), 2 ) )
+#define IORD_8DIRECT( BASE, OFFSET )			( ( alt_u8 ) ulPortSimIOReadDirect( ( alt_u32 ) ( BASE ) + ( alt_u32 ) ( OFFSET ), 1 ) )
+
+#define IOWR_32DIRECT( BASE, OFFSET, DATA )		vPortSimIOWriteDirect( ( alt_u32 ) ( BASE ) + ( alt_u32 ) ( OFFSET ), ( alt_u32 ) ( DATA ), 4 )
+#define IOWR_16DIRECT( BASE, OFFSET, DATA )		vPortSimIOWriteDirect( ( alt_u32 ) ( BASE ) + ( alt_u32 ) ( OFFSET ), ( alt_u16 ) ( DATA ), 2 )
+#define IOWR_8DIRECT( BASE, OFFSET, DATA )		vPortSimIOWriteDirect( ( alt_u32 ) ( BASE ) + ( alt_u32 ) ( OFFSET ), ( alt_u8 ) ( DATA ), 1 )
+
+#endif /* __IO_H__ */
@@ -0,0 +1,26 @@
+/*
+ * Stand-in for the HAL os/alt_sem.h when building on a Linux host.
+ *
+ * As in the single threaded HAL the board is built with, the drivers'
+ * semaphores do nothing.
+ */
+
+#ifndef __ALT_SEM_H__
+#define __ALT_SEM_H__
+
+#define ALT_SEM( sem )
+#define ALT_EXTERN_SEM( sem )
+#define ALT_STATIC_SEM( sem )
+
+/* A call rather than a bare 0, so a driver that ignores the result does not
+warn. */
+static inline int alt_sem_nop( void )
+{
+	return 0;
+}
+
+#define ALT_SEM_CREATE( sem, value )	alt_sem_nop()
+#define ALT_SEM_PEND( sem, timeout )	alt_sem_nop()
+#define ALT_SEM_POST( sem )				alt_sem_nop()
+
+#endif /* __ALT_SEM_H__ */
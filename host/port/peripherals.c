@@ -0,0 +1,943 @@
+/*
+ * Register level models of the DE2-115 peripherals the relay uses.  See
+ * peripherals.h.
+ *
+ * Each model embeds a SimDevice_t (portmacro_host.h) and is reached through
+ * IORD()/IOWR() and the *DIRECT() macros at the base address system.h gives
+ * it.  Only what the relay and the BSP drivers use is modelled: a register the
+ * model does not know reads 0 and ignores writes.
+ *
+ * Timings that were not measured on the board, and are only there so that
+ * events happen in a sensible order:
+ *
+ *   keyboard        the reset acknowledge 0xFA 1ms after the reset command
+ *                   and the self test result 0xAA 1ms after that, much sooner
+ *                   than a real keyboard's self test so that the driver's
+ *                   polling loop sees it; successive bytes of a key 1ms apart,
+ *                   the time an 11 bit PS/2 frame takes at about 11kHz.
+ *   LCD             never busy; the driver's usleep(100) before each access
+ *                   is what takes the time.
+ *   character       a clear completes at once.
+ *   buffer
+ *   flash           10 cycles a byte to read, 1000 to program and 50000000
+ *                   (0.5s) to erase a 64KB block, as in bench/store_sim.c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "system.h"
+#include "io.h"
+#include "priv/alt_file.h"
+#include "sys/alt_flash.h"
+
+#include "altera_avalon_pio_regs.h"
+#include "altera_up_avalon_ps2.h"
+#include "altera_up_avalon_ps2_regs.h"
+#include "altera_up_avalon_video_character_buffer_with_dma.h"
+#include "altera_up_avalon_video_character_buffer_with_dma_regs.h"
+#include "altera_up_avalon_video_pixel_buffer_dma.h"
+#include "altera_avalon_lcd_16207.h"
+#include "altera_avalon_lcd_16207_regs.h"
+
+#include "peripherals.h"
+
+/* Cycles of the system clock in a millisecond. */
+#define simMS							( ALT_CPU_FREQ / 1000ULL )
+
+/* The frequency analyser counts samples of a 16kHz ADC. */
+#define simANALYSER_CYCLES_PER_COUNT	( ALT_CPU_FREQ / 16000ULL )
+
+/* Keyboard timings, see the top of the file. */
+#define simKEYBOARD_REPLY_CYCLES		( 1ULL * simMS )
+#define simKEYBOARD_BYTE_CYCLES			( 1ULL * simMS )
+#define simKEYBOARD_ACK					0xFA
+#define simKEYBOARD_SELF_TEST_PASSED	0xAA
+#define simKEYBOARD_RESET				0xFF
+#define simKEYBOARD_BREAK				0xF0
+
+/* The PS/2 core's FIFO, and bytes the keyboard has yet to send. */
+#define simPS2_FIFO_SIZE				256
+#define simPS2_PENDING_SIZE				64
+
+/* The character buffer is 80 x 60 characters, each row 128 bytes apart. */
+#define simCHAR_COLUMNS					80
+#define simCHAR_ROWS					60
+#define simCHAR_ROW_SHIFT				7
+
+/* The pixel buffer: 640 x 480, 16 bit colour, X-Y addressing with 10 bits of
+x and 9 of y, both buffers at the start of the SRAM. */
+#define simPIXEL_WIDTH					640
+#define simPIXEL_HEIGHT					480
+#define simPIXEL_COLOUR_MODE			2
+#define simPIXEL_X_BITS					10
+#define simPIXEL_Y_BITS					9
+
+/* The LCD's display RAM holds 40 characters of each of its two lines, at
+0x00 and 0x40. */
+#define simLCD_LINE_LENGTH				40
+#define simLCD_LINE2_ADDRESS			0x40
+#define simLCD_CMD_CLEAR				0x01
+#define simLCD_CMD_HOME					0x02
+#define simLCD_CMD_SET_ADDRESS			0x80
+
+/* Flash timings, see the top of the file. */
+#define simFLASH_BLOCK_SIZE				( 64 * 1024 )
+#define simFLASH_READ_CYCLES			10UL
+#define simFLASH_PROGRAM_CYCLES			1000UL
+#define simFLASH_ERASE_CYCLES			50000000UL
+
+/*-----------------------------------------------------------*/
+
+typedef struct SIM_PIO
+{
+	SimDevice_t xDevice;
+	uint32_t ulIrq;				/*<< 0xFFFFFFFF if the PIO has no interrupt. */
+	uint32_t ulInput;			/*<< Level of the input pins. */
+	uint32_t ulOutput;
+	uint32_t ulIrqMask;
+	uint32_t ulEdgeCapture;
+	BaseType_t xLine;
+} SimPio_t;
+
+typedef struct SIM_ANALYSER
+{
+	SimDevice_t xDevice;
+	SimFrequencySource_t pxSource;
+	uint32_t ulCount;			/*<< Count of the period that last ended. */
+	uint16_t usPeriodCount;		/*<< Count of the period in progress. */
+	uint32_t ulSpeedUp;
+	uint64_t ullPeriodEnd;
+} SimAnalyser_t;
+
+typedef struct SIM_PS2_BYTE
+{
+	uint64_t ullAt;
+	uint8_t ucByte;
+} SimPs2Byte_t;
+
+typedef struct SIM_PS2
+{
+	SimDevice_t xDevice;
+	uint32_t ulControl;			/*<< The RE bit. */
+	uint8_t ucFifo[ simPS2_FIFO_SIZE ];
+	uint32_t ulFifoHead;
+	uint32_t ulFifoCount;
+	SimPs2Byte_t xPending[ simPS2_PENDING_SIZE ];	/*<< In order of arrival. */
+	uint32_t ulPendingCount;
+	BaseType_t xLine;
+} SimPs2_t;
+
+typedef struct SIM_MEMORY
+{
+	SimDevice_t xDevice;
+	uint8_t *pucData;
+} SimMemory_t;
+
+typedef struct SIM_CHAR_CONTROL
+{
+	SimDevice_t xDevice;
+	SimMemory_t *pxBuffer;
+} SimCharControl_t;
+
+typedef struct SIM_PIXEL_CONTROL
+{
+	SimDevice_t xDevice;
+	uint32_t ulFront;
+	uint32_t ulBack;
+} SimPixelControl_t;
+
+typedef struct SIM_LCD
+{
+	SimDevice_t xDevice;
+	char cRam[ 2 ][ simLCD_LINE_LENGTH ];
+	uint32_t ulAddress;
+} SimLcd_t;
+
+typedef struct SIM_FLASH
+{
+	alt_flash_dev xDevice;
+	uint8_t *pucData;
+	uint32_t ulWrites;
+	uint32_t ulErases;
+} SimFlash_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Register accesses to the PIOs.
+ */
+static uint32_t prvPioRead( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulBytes );
+static void prvPioWrite( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulData, uint32_t ulBytes );
+
+/*
+ * Sets the PIO's input pins, capturing falling edges.
+ */
+static void prvPioSetInput( SimPio_t *pxPio, uint32_t ulInput );
+
+/*
+ * Raises or drops the PIO's interrupt line to match its edge capture and mask.
+ */
+static void prvPioUpdateLine( SimPio_t *pxPio );
+
+/*
+ * The frequency analyser.
+ */
+static uint32_t prvAnalyserRead( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulBytes );
+static void prvAnalyserWrite( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulData, uint32_t ulBytes );
+static uint64_t prvAnalyserNextEvent( SimDevice_t *pxDevice );
+static void prvAnalyserUpdate( SimDevice_t *pxDevice, uint64_t ullNow );
+
+/*
+ * The PS/2 port and the keyboard on it.
+ */
+static uint32_t prvPs2Read( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulBytes );
+static void prvPs2Write( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulData, uint32_t ulBytes );
+static uint64_t prvPs2NextEvent( SimDevice_t *pxDevice );
+static void prvPs2Update( SimDevice_t *pxDevice, uint64_t ullNow );
+
+/*
+ * Queues a byte from the keyboard to arrive at ullAt.
+ */
+static void prvPs2Send( SimPs2_t *pxPs2, uint8_t ucByte, uint64_t ullAt );
+
+/*
+ * Raises or drops the PS/2 interrupt line to match RE and the FIFO.
+ */
+static void prvPs2UpdateLine( SimPs2_t *pxPs2 );
+
+/*
+ * Memory: the SRAM and the character buffer.
+ */
+static uint32_t prvMemoryRead( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulBytes );
+static void prvMemoryWrite( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulData, uint32_t ulBytes );
+
+/*
+ * The control registers of the character buffer and of the pixel buffer DMA
+ * controller.
+ */
+static uint32_t prvCharControlRead( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulBytes );
+static void prvCharControlWrite( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulData, uint32_t ulBytes );
+static uint32_t prvPixelControlRead( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulBytes );
+static void prvPixelControlWrite( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulData, uint32_t ulBytes );
+
+/*
+ * The LCD.
+ */
+static uint32_t prvLcdRead( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulBytes );
+static void prvLcdWrite( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulData, uint32_t ulBytes );
+
+/*
+ * The flash, through the HAL flash device's functions.
+ */
+static int prvFlashRead( alt_flash_dev *pxFlash, int iOffset, void *pvDest, int iLength );
+static int prvFlashWrite( alt_flash_dev *pxFlash, int iOffset, const void *pvSrc, int iLength );
+static int prvFlashGetInfo( alt_flash_dev *pxFlash, flash_region **ppxInfo, int *piRegions );
+static int prvFlashEraseBlock( alt_flash_dev *pxFlash, int iOffset );
+static int prvFlashWriteBlock( alt_flash_dev *pxFlash, int iBlockOffset, int iDataOffset, const void *pvData, int iLength );
+
+/*
+ * Spends the cycles a flash operation takes, which may be more than one call
+ * to vPortSimConsume() can.
+ */
+static void prvFlashConsume( uint64_t ullCycles );
+
+/*-----------------------------------------------------------*/
+
+#define simPIO( xName, ulIrq, ulInput )		{ { xName##_BASE, xName##_SPAN, prvPioRead, prvPioWrite, NULL, NULL }, ( ulIrq ), ( ulInput ), 0, 0, 0, pdFALSE }
+
+/* The push buttons are pulled up, so read 1 when released. */
+static SimPio_t xRedLeds = simPIO( RED_LEDS, 0xFFFFFFFFUL, 0 );
+static SimPio_t xGreenLeds = simPIO( GREEN_LEDS, 0xFFFFFFFFUL, 0 );
+static SimPio_t xSevenSeg = simPIO( SEVEN_SEG, 0xFFFFFFFFUL, 0 );
+static SimPio_t xSlideSwitch = simPIO( SLIDE_SWITCH, 0xFFFFFFFFUL, 0 );
+static SimPio_t xPushButton = simPIO( PUSH_BUTTON, PUSH_BUTTON_IRQ, 0xFUL );
+
+static SimPio_t * const pxOutputPios[] = { &xRedLeds, &xGreenLeds, &xSevenSeg };
+
+static SimAnalyser_t xAnalyser =
+{
+	{ FREQUENCY_ANALYSER_BASE, FREQUENCY_ANALYSER_SPAN, prvAnalyserRead, prvAnalyserWrite, prvAnalyserNextEvent, prvAnalyserUpdate },
+	NULL, 0, 0, 1, UINT64_MAX
+};
+
+static SimPs2_t xPs2 = { { PS2_BASE, PS2_SPAN, prvPs2Read, prvPs2Write, prvPs2NextEvent, prvPs2Update } };
+
+static uint8_t ucSram[ SRAM_SPAN ];
+static SimMemory_t xSram = { { SRAM_BASE, SRAM_SPAN, prvMemoryRead, prvMemoryWrite, NULL, NULL }, ucSram };
+
+static uint8_t ucCharBuffer[ VIDEO_CHARACTER_BUFFER_WITH_DMA_AVALON_CHAR_BUFFER_SLAVE_SPAN ];
+static SimMemory_t xCharBuffer =
+{
+	{ VIDEO_CHARACTER_BUFFER_WITH_DMA_AVALON_CHAR_BUFFER_SLAVE_BASE, VIDEO_CHARACTER_BUFFER_WITH_DMA_AVALON_CHAR_BUFFER_SLAVE_SPAN, prvMemoryRead, prvMemoryWrite, NULL, NULL },
+	ucCharBuffer
+};
+static SimCharControl_t xCharControl =
+{
+	{ VIDEO_CHARACTER_BUFFER_WITH_DMA_AVALON_CHAR_CONTROL_SLAVE_BASE, VIDEO_CHARACTER_BUFFER_WITH_DMA_AVALON_CHAR_CONTROL_SLAVE_SPAN, prvCharControlRead, prvCharControlWrite, NULL, NULL },
+	&xCharBuffer
+};
+
+static SimPixelControl_t xPixelControl =
+{
+	{ VIDEO_PIXEL_BUFFER_DMA_BASE, VIDEO_PIXEL_BUFFER_DMA_SPAN, prvPixelControlRead, prvPixelControlWrite, NULL, NULL },
+	SRAM_BASE, SRAM_BASE
+};
+
+static SimLcd_t xLcd = { { CHARACTER_LCD_BASE, CHARACTER_LCD_SPAN, prvLcdRead, prvLcdWrite, NULL, NULL } };
+
+static SimFlash_t xFlash =
+{
+	{
+		ALT_LLIST_ENTRY, FLASH_CONTROLLER_NAME, NULL, NULL, prvFlashWrite, prvFlashRead, prvFlashGetInfo,
+		prvFlashEraseBlock, prvFlashWriteBlock, ( void * ) FLASH_CONTROLLER_BASE, FLASH_CONTROLLER_SPAN, 1,
+		{ { 0, FLASH_CONTROLLER_SPAN, FLASH_CONTROLLER_SPAN / simFLASH_BLOCK_SIZE, simFLASH_BLOCK_SIZE } }
+	}
+};
+
+static SimPioObserver_t pxPioObserver = NULL;
+
+/* Driver instances, as the BSP's alt_sys_init.c declares them.  The character
+buffer driver cuts the "_avalon_char_buffer_slave" off its name in place, so
+the name has to be writable here, and the INIT macros of both video drivers
+read the controllers through plain pointers, so those two are set up by hand
+below. */
+ALTERA_AVALON_LCD_16207_INSTANCE( CHARACTER_LCD, character_lcd );
+ALTERA_UP_AVALON_PS2_INSTANCE( PS2, ps2 );
+static char cCharBufferName[] = VIDEO_CHARACTER_BUFFER_WITH_DMA_AVALON_CHAR_BUFFER_SLAVE_NAME;
+static alt_up_char_buffer_dev video_character_buffer_with_dma;
+static alt_up_pixel_buffer_dma_dev video_pixel_buffer_dma;
+
+/*-----------------------------------------------------------*/
+
+void alt_sys_init( void )
+{
+uint32_t ulRegister;
+SimDevice_t *pxDevices[] =
+{
+	&( xRedLeds.xDevice ), &( xGreenLeds.xDevice ), &( xSevenSeg.xDevice ), &( xSlideSwitch.xDevice ), &( xPushButton.xDevice ),
+	&( xAnalyser.xDevice ), &( xPs2.xDevice ), &( xSram.xDevice ), &( xCharBuffer.xDevice ), &( xCharControl.xDevice ),
+	&( xPixelControl.xDevice ), &( xLcd.xDevice )
+};
+uint32_t ul;
+
+	for( ul = 0; ul < sizeof( pxDevices ) / sizeof( pxDevices[ 0 ] ); ul++ )
+	{
+		vPortSimAddDevice( pxDevices[ ul ] );
+	}
+
+	xFlash.pucData = ( uint8_t * ) malloc( FLASH_CONTROLLER_SPAN );
+	if( xFlash.pucData == NULL )
+	{
+		fprintf( stderr, "peripherals: no memory for the flash\n" );
+		exit( 1 );
+	}
+	memset( xFlash.pucData, 0xFF, FLASH_CONTROLLER_SPAN );
+	memset( ucCharBuffer, ' ', sizeof( ucCharBuffer ) );
+	memset( xLcd.cRam, ' ', sizeof( xLcd.cRam ) );
+
+	/* In the BSP's order. */
+	alt_flash_device_register( &( xFlash.xDevice ) );
+	ALTERA_AVALON_LCD_16207_INIT( CHARACTER_LCD, character_lcd );
+	ALTERA_UP_AVALON_PS2_INIT( PS2, ps2 );
+
+	/* As ALTERA_UP_AVALON_VIDEO_CHARACTER_BUFFER_WITH_DMA_INSTANCE() and
+	..._INIT(), which also leave the defaults of an 80 column buffer alone. */
+	video_character_buffer_with_dma.dev.name = cCharBufferName;
+	video_character_buffer_with_dma.ctrl_reg_base = VIDEO_CHARACTER_BUFFER_WITH_DMA_AVALON_CHAR_CONTROL_SLAVE_BASE;
+	video_character_buffer_with_dma.buffer_base = VIDEO_CHARACTER_BUFFER_WITH_DMA_AVALON_CHAR_BUFFER_SLAVE_BASE;
+	ulRegister = IORD( video_character_buffer_with_dma.ctrl_reg_base, 1 );
+	video_character_buffer_with_dma.x_resolution = ulRegister & 0xFFFF;
+	video_character_buffer_with_dma.y_resolution = ( ulRegister >> 16 ) & 0xFFFF;
+	video_character_buffer_with_dma.x_coord_offset = 0;
+	video_character_buffer_with_dma.x_coord_mask = 0x007F;
+	video_character_buffer_with_dma.y_coord_offset = 7;
+	video_character_buffer_with_dma.y_coord_mask = 0x003F;
+	alt_up_char_buffer_init( &video_character_buffer_with_dma );
+	alt_dev_reg( &( video_character_buffer_with_dma.dev ) );
+
+	/* As ALTERA_UP_AVALON_VIDEO_PIXEL_BUFFER_DMA_INSTANCE() and ..._INIT(). */
+	video_pixel_buffer_dma.dev.name = VIDEO_PIXEL_BUFFER_DMA_NAME;
+	video_pixel_buffer_dma.base = VIDEO_PIXEL_BUFFER_DMA_BASE;
+	video_pixel_buffer_dma.buffer_start_address = IORD( video_pixel_buffer_dma.base, 0 );
+	video_pixel_buffer_dma.back_buffer_start_address = IORD( video_pixel_buffer_dma.base, 1 );
+	ulRegister = IORD( video_pixel_buffer_dma.base, 2 );
+	video_pixel_buffer_dma.x_resolution = ulRegister & 0xFFFF;
+	video_pixel_buffer_dma.y_resolution = ( ulRegister >> 16 ) & 0xFFFF;
+	ulRegister = IORD( video_pixel_buffer_dma.base, 3 );
+	video_pixel_buffer_dma.addressing_mode = ( ulRegister >> 1 ) & 0x1;
+	video_pixel_buffer_dma.color_mode = ( ulRegister >> 4 ) & 0xF;
+	video_pixel_buffer_dma.x_coord_offset = ( video_pixel_buffer_dma.color_mode == ALT_UP_8BIT_COLOR_MODE ) ? 0 :
+											( video_pixel_buffer_dma.color_mode == ALT_UP_16BIT_COLOR_MODE ) ? 1 : 2;
+	video_pixel_buffer_dma.x_coord_mask = 0xFFFFFFFFUL >> ( 32 - ( ( ulRegister >> 16 ) & 0xFF ) );
+	video_pixel_buffer_dma.y_coord_offset = ( ( ulRegister >> 16 ) & 0xFF ) + video_pixel_buffer_dma.x_coord_offset;
+	video_pixel_buffer_dma.y_coord_mask = 0xFFFFFFFFUL >> ( 32 - ( ( ulRegister >> 24 ) & 0xFF ) );
+	alt_dev_reg( &( video_pixel_buffer_dma.dev ) );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvPioRead( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulBytes )
+{
+SimPio_t *pxPio = ( SimPio_t * ) pxDevice;
+
+	( void ) ulBytes;
+
+	switch( ulOffset / 4 )
+	{
+		case 0 :
+			/* An output PIO reads back what was written. */
+			return ( pxPio->xDevice.ulBase == SLIDE_SWITCH_BASE || pxPio->xDevice.ulBase == PUSH_BUTTON_BASE ) ? pxPio->ulInput : pxPio->ulOutput;
+		case 2 :
+			return pxPio->ulIrqMask;
+		case 3 :
+			return pxPio->ulEdgeCapture;
+		default :
+			return 0;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvPioWrite( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulData, uint32_t ulBytes )
+{
+SimPio_t *pxPio = ( SimPio_t * ) pxDevice;
+
+	( void ) ulBytes;
+
+	switch( ulOffset / 4 )
+	{
+		case 0 :
+			pxPio->ulOutput = ulData;
+			if( pxPioObserver != NULL )
+			{
+				pxPioObserver( pxPio->xDevice.ulBase, ulData );
+			}
+			break;
+		case 2 :
+			pxPio->ulIrqMask = ulData;
+			prvPioUpdateLine( pxPio );
+			break;
+		case 3 :
+			/* Any write clears the whole of the edge capture register. */
+			pxPio->ulEdgeCapture = 0;
+			prvPioUpdateLine( pxPio );
+			break;
+		default :
+			break;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvPioSetInput( SimPio_t *pxPio, uint32_t ulInput )
+{
+	pxPio->ulEdgeCapture |= pxPio->ulInput & ~ulInput;
+	pxPio->ulInput = ulInput;
+	prvPioUpdateLine( pxPio );
+}
+/*-----------------------------------------------------------*/
+
+static void prvPioUpdateLine( SimPio_t *pxPio )
+{
+BaseType_t xLine = ( ( pxPio->ulEdgeCapture & pxPio->ulIrqMask ) != 0 ) ? pdTRUE : pdFALSE;
+
+	if( ( pxPio->ulIrq != 0xFFFFFFFFUL ) && ( xLine != pxPio->xLine ) )
+	{
+		pxPio->xLine = xLine;
+		vPortSimSetInterruptLine( pxPio->ulIrq, xLine );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vSimSetPioObserver( SimPioObserver_t pxObserver )
+{
+	pxPioObserver = pxObserver;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulSimGetPioData( uint32_t ulBase )
+{
+uint32_t ul;
+
+	for( ul = 0; ul < sizeof( pxOutputPios ) / sizeof( pxOutputPios[ 0 ] ); ul++ )
+	{
+		if( pxOutputPios[ ul ]->xDevice.ulBase == ulBase )
+		{
+			return pxOutputPios[ ul ]->ulOutput;
+		}
+	}
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+void vSimSetSwitches( uint32_t ulSwitches )
+{
+	xSlideSwitch.ulInput = ulSwitches;
+}
+/*-----------------------------------------------------------*/
+
+void vSimPressButtons( uint32_t ulMask )
+{
+	prvPioSetInput( &xPushButton, xPushButton.ulInput & ~ulMask );
+}
+/*-----------------------------------------------------------*/
+
+void vSimReleaseButtons( uint32_t ulMask )
+{
+	prvPioSetInput( &xPushButton, xPushButton.ulInput | ulMask );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvAnalyserRead( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulBytes )
+{
+	( void ) ulOffset;
+	( void ) ulBytes;
+
+	return ( ( SimAnalyser_t * ) pxDevice )->ulCount;
+}
+/*-----------------------------------------------------------*/
+
+static void prvAnalyserWrite( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulData, uint32_t ulBytes )
+{
+	( void ) pxDevice;
+	( void ) ulOffset;
+	( void ) ulData;
+	( void ) ulBytes;
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvAnalyserNextEvent( SimDevice_t *pxDevice )
+{
+	return ( ( SimAnalyser_t * ) pxDevice )->ullPeriodEnd;
+}
+/*-----------------------------------------------------------*/
+
+/* Cycles a period with count usCount lasts, at least one so the analyser
+always moves time on. */
+static uint64_t prvAnalyserPeriod( uint16_t usCount )
+{
+uint64_t ullCycles = ( ( uint64_t ) usCount * simANALYSER_CYCLES_PER_COUNT ) / xAnalyser.ulSpeedUp;
+
+	return ( ullCycles == 0 ) ? 1 : ullCycles;
+}
+/*-----------------------------------------------------------*/
+
+static void prvAnalyserUpdate( SimDevice_t *pxDevice, uint64_t ullNow )
+{
+SimAnalyser_t *pxAnalyser = ( SimAnalyser_t * ) pxDevice;
+
+	while( pxAnalyser->ullPeriodEnd <= ullNow )
+	{
+		pxAnalyser->ulCount = pxAnalyser->usPeriodCount;
+		vPortSimRaiseInterrupt( FREQUENCY_ANALYSER_IRQ, pxAnalyser->ullPeriodEnd );
+
+		pxAnalyser->usPeriodCount = pxAnalyser->pxSource( pxAnalyser->ullPeriodEnd );
+		if( pxAnalyser->usPeriodCount == 0 )
+		{
+			pxAnalyser->ullPeriodEnd = UINT64_MAX;
+		}
+		else
+		{
+			pxAnalyser->ullPeriodEnd += prvAnalyserPeriod( pxAnalyser->usPeriodCount );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vSimSetFrequencySource( SimFrequencySource_t pxSource )
+{
+uint64_t ullNow = ullPortSimGetCycles();
+
+	xAnalyser.pxSource = pxSource;
+	xAnalyser.usPeriodCount = pxSource( ullNow );
+	xAnalyser.ullPeriodEnd = ( xAnalyser.usPeriodCount == 0 ) ? UINT64_MAX : ullNow + prvAnalyserPeriod( xAnalyser.usPeriodCount );
+	vPortSimEventsChanged();
+}
+/*-----------------------------------------------------------*/
+
+void vSimSetFrequencySpeedUp( uint32_t ulSpeedUp )
+{
+	xAnalyser.ulSpeedUp = ( ulSpeedUp == 0 ) ? 1 : ulSpeedUp;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvPs2Read( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulBytes )
+{
+SimPs2_t *pxPs2 = ( SimPs2_t * ) pxDevice;
+uint32_t ulData;
+
+	( void ) ulBytes;
+
+	if( ulOffset >= 4 )
+	{
+		return pxPs2->ulControl | ( ( ( pxPs2->ulControl & ALT_UP_PS2_PORT_CTRL_REG_RE_MSK ) != 0 ) && ( pxPs2->ulFifoCount != 0 ) ?
+									ALT_UP_PS2_PORT_CTRL_REG_RI_MSK : 0 );
+	}
+
+	if( pxPs2->ulFifoCount == 0 )
+	{
+		return 0;
+	}
+
+	/* Reading the data register takes the byte from the FIFO.  RAVAIL counts
+	it. */
+	ulData = pxPs2->ucFifo[ pxPs2->ulFifoHead ] | ALT_UP_PS2_PORT_DATA_REG_RVALID_MSK | ( pxPs2->ulFifoCount << ALT_UP_PS2_PORT_DATA_REG_RAVAIL_OFST );
+	pxPs2->ulFifoHead = ( pxPs2->ulFifoHead + 1 ) % simPS2_FIFO_SIZE;
+	pxPs2->ulFifoCount--;
+	prvPs2UpdateLine( pxPs2 );
+
+	return ulData;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPs2Write( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulData, uint32_t ulBytes )
+{
+SimPs2_t *pxPs2 = ( SimPs2_t * ) pxDevice;
+uint64_t ullNow = ullPortSimGetCycles();
+
+	( void ) ulBytes;
+
+	if( ulOffset >= 4 )
+	{
+		pxPs2->ulControl = ulData & ALT_UP_PS2_PORT_CTRL_REG_RE_MSK;
+		prvPs2UpdateLine( pxPs2 );
+		return;
+	}
+
+	/* A command to the keyboard.  It acknowledges every one, and answers a
+	reset with the result of its self test as well. */
+	prvPs2Send( pxPs2, simKEYBOARD_ACK, ullNow + simKEYBOARD_REPLY_CYCLES );
+	if( ( uint8_t ) ulData == simKEYBOARD_RESET )
+	{
+		prvPs2Send( pxPs2, simKEYBOARD_SELF_TEST_PASSED, ullNow + simKEYBOARD_REPLY_CYCLES + simKEYBOARD_BYTE_CYCLES );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvPs2NextEvent( SimDevice_t *pxDevice )
+{
+SimPs2_t *pxPs2 = ( SimPs2_t * ) pxDevice;
+
+	return ( pxPs2->ulPendingCount != 0 ) ? pxPs2->xPending[ 0 ].ullAt : UINT64_MAX;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPs2Update( SimDevice_t *pxDevice, uint64_t ullNow )
+{
+SimPs2_t *pxPs2 = ( SimPs2_t * ) pxDevice;
+uint32_t ulArrived = 0;
+
+	while( ( ulArrived < pxPs2->ulPendingCount ) && ( pxPs2->xPending[ ulArrived ].ullAt <= ullNow ) )
+	{
+		/* A byte that finds the FIFO full is lost, as in the core. */
+		if( pxPs2->ulFifoCount < simPS2_FIFO_SIZE )
+		{
+			pxPs2->ucFifo[ ( pxPs2->ulFifoHead + pxPs2->ulFifoCount ) % simPS2_FIFO_SIZE ] = pxPs2->xPending[ ulArrived ].ucByte;
+			pxPs2->ulFifoCount++;
+		}
+		ulArrived++;
+	}
+
+	if( ulArrived != 0 )
+	{
+		pxPs2->ulPendingCount -= ulArrived;
+		memmove( &( pxPs2->xPending[ 0 ] ), &( pxPs2->xPending[ ulArrived ] ), pxPs2->ulPendingCount * sizeof( SimPs2Byte_t ) );
+		prvPs2UpdateLine( pxPs2 );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvPs2Send( SimPs2_t *pxPs2, uint8_t ucByte, uint64_t ullAt )
+{
+uint32_t ulIndex = pxPs2->ulPendingCount;
+
+	if( ulIndex == simPS2_PENDING_SIZE )
+	{
+		fprintf( stderr, "peripherals: more than %d keyboard bytes queued\n", simPS2_PENDING_SIZE );
+		exit( 1 );
+	}
+
+	/* Keys typed close together interleave their bytes in time. */
+	while( ( ulIndex > 0 ) && ( pxPs2->xPending[ ulIndex - 1 ].ullAt > ullAt ) )
+	{
+		pxPs2->xPending[ ulIndex ] = pxPs2->xPending[ ulIndex - 1 ];
+		ulIndex--;
+	}
+
+	pxPs2->xPending[ ulIndex ].ullAt = ullAt;
+	pxPs2->xPending[ ulIndex ].ucByte = ucByte;
+	pxPs2->ulPendingCount++;
+	vPortSimEventsChanged();
+}
+/*-----------------------------------------------------------*/
+
+static void prvPs2UpdateLine( SimPs2_t *pxPs2 )
+{
+BaseType_t xLine = ( ( ( pxPs2->ulControl & ALT_UP_PS2_PORT_CTRL_REG_RE_MSK ) != 0 ) && ( pxPs2->ulFifoCount != 0 ) ) ? pdTRUE : pdFALSE;
+
+	if( xLine != pxPs2->xLine )
+	{
+		pxPs2->xLine = xLine;
+		vPortSimSetInterruptLine( PS2_IRQ, xLine );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vSimTypeKey( uint8_t ucScanCode, uint32_t ulHoldCycles )
+{
+uint64_t ullNow = ullPortSimGetCycles();
+
+	prvPs2Send( &xPs2, ucScanCode, ullNow );
+	prvPs2Send( &xPs2, simKEYBOARD_BREAK, ullNow + ulHoldCycles );
+	prvPs2Send( &xPs2, ucScanCode, ullNow + ulHoldCycles + simKEYBOARD_BYTE_CYCLES );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvMemoryRead( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulBytes )
+{
+uint8_t *pucData = ( ( SimMemory_t * ) pxDevice )->pucData + ulOffset;
+uint32_t ulData = 0;
+
+	/* Little endian, as the Nios II. */
+	memcpy( &ulData, pucData, ulBytes );
+	return ulData;
+}
+/*-----------------------------------------------------------*/
+
+static void prvMemoryWrite( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulData, uint32_t ulBytes )
+{
+	memcpy( ( ( SimMemory_t * ) pxDevice )->pucData + ulOffset, &ulData, ulBytes );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvCharControlRead( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulBytes )
+{
+	( void ) pxDevice;
+	( void ) ulBytes;
+
+	/* Register 1 holds the resolution.  The clear bit in register 0 is never
+	seen set, as a clear completes at once. */
+	return ( ulOffset == 4 ) ? ( simCHAR_COLUMNS | ( simCHAR_ROWS << 16 ) ) : 0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCharControlWrite( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulData, uint32_t ulBytes )
+{
+SimCharControl_t *pxControl = ( SimCharControl_t * ) pxDevice;
+
+	if( ( ( ulOffset == ALT_UP_CHAR_BUFFER_CLR_SCRN ) && ( ulBytes == 1 ) && ( ( ulData & ALT_UP_CHAR_BUFFER_CLR_SCRN_MSK ) != 0 ) ) ||
+		( ( ulOffset == 0 ) && ( ulBytes == 4 ) && ( ( ulData & ALT_UP_CHAR_BUFFER_CTRL_REG_CLR_SCRN_MSK ) != 0 ) ) )
+	{
+		memset( pxControl->pxBuffer->pucData, ' ', pxControl->pxBuffer->xDevice.ulSpan );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvPixelControlRead( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulBytes )
+{
+SimPixelControl_t *pxControl = ( SimPixelControl_t * ) pxDevice;
+
+	( void ) ulBytes;
+
+	switch( ulOffset / 4 )
+	{
+		case 0 :
+			return pxControl->ulFront;
+		case 1 :
+			return pxControl->ulBack;
+		case 2 :
+			return simPIXEL_WIDTH | ( simPIXEL_HEIGHT << 16 );
+		case 3 :
+			/* X-Y addressing (bit 1 clear), no swap pending (bit 0). */
+			return ( simPIXEL_COLOUR_MODE << 4 ) | ( simPIXEL_X_BITS << 16 ) | ( simPIXEL_Y_BITS << 24 );
+		default :
+			return 0;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvPixelControlWrite( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulData, uint32_t ulBytes )
+{
+SimPixelControl_t *pxControl = ( SimPixelControl_t * ) pxDevice;
+uint32_t ulFront;
+
+	( void ) ulBytes;
+
+	/* Writing the front buffer register swaps the buffers, at once rather than
+	at the next vertical blank. */
+	if( ulOffset == 0 )
+	{
+		ulFront = pxControl->ulFront;
+		pxControl->ulFront = pxControl->ulBack;
+		pxControl->ulBack = ulFront;
+	}
+	else if( ulOffset == 4 )
+	{
+		pxControl->ulBack = ulData;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvLcdRead( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulBytes )
+{
+SimLcd_t *pxLcd = ( SimLcd_t * ) pxDevice;
+
+	( void ) ulBytes;
+
+	/* Register 1, the status, never shows busy.  Register 3 reads the display
+	RAM. */
+	if( ulOffset == 12 )
+	{
+		return ( uint8_t ) pxLcd->cRam[ ( pxLcd->ulAddress & simLCD_LINE2_ADDRESS ) ? 1 : 0 ][ ( pxLcd->ulAddress & 0x3F ) % simLCD_LINE_LENGTH ];
+	}
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvLcdWrite( SimDevice_t *pxDevice, uint32_t ulOffset, uint32_t ulData, uint32_t ulBytes )
+{
+SimLcd_t *pxLcd = ( SimLcd_t * ) pxDevice;
+
+	( void ) ulBytes;
+
+	if( ulOffset == 0 )
+	{
+		/* Of the commands only those that move the address or change the
+		display RAM matter here. */
+		if( ( ulData & simLCD_CMD_SET_ADDRESS ) != 0 )
+		{
+			pxLcd->ulAddress = ulData & 0x7F;
+		}
+		else if( ulData == simLCD_CMD_CLEAR )
+		{
+			memset( pxLcd->cRam, ' ', sizeof( pxLcd->cRam ) );
+			pxLcd->ulAddress = 0;
+		}
+		else if( ( ulData & ~1UL ) == simLCD_CMD_HOME )
+		{
+			pxLcd->ulAddress = 0;
+		}
+	}
+	else if( ulOffset == 8 )
+	{
+		if( ( pxLcd->ulAddress & 0x3F ) < simLCD_LINE_LENGTH )
+		{
+			pxLcd->cRam[ ( pxLcd->ulAddress & simLCD_LINE2_ADDRESS ) ? 1 : 0 ][ pxLcd->ulAddress & 0x3F ] = ( char ) ulData;
+		}
+		pxLcd->ulAddress = ( pxLcd->ulAddress + 1 ) & 0x7F;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vSimGetLcdLine( uint32_t ulLine, char *pcText )
+{
+	memcpy( pcText, xLcd.cRam[ ulLine & 1 ], ALT_LCD_WIDTH );
+	pcText[ ALT_LCD_WIDTH ] = '\0';
+}
+/*-----------------------------------------------------------*/
+
+void vSimGetCharBufferLine( uint32_t ulLine, char *pcText )
+{
+uint32_t ul;
+uint8_t ucChar;
+
+	for( ul = 0; ul < simCHAR_COLUMNS; ul++ )
+	{
+		ucChar = ucCharBuffer[ ( ( ulLine % simCHAR_ROWS ) << simCHAR_ROW_SHIFT ) + ul ];
+		pcText[ ul ] = ( ( ucChar >= ' ' ) && ( ucChar < 0x7F ) ) ? ( char ) ucChar : ' ';
+	}
+	pcText[ simCHAR_COLUMNS ] = '\0';
+}
+/*-----------------------------------------------------------*/
+
+static void prvFlashConsume( uint64_t ullCycles )
+{
+	while( ullCycles > UINT32_MAX )
+	{
+		vPortSimConsume( UINT32_MAX );
+		ullCycles -= UINT32_MAX;
+	}
+	vPortSimConsume( ( uint32_t ) ullCycles );
+}
+/*-----------------------------------------------------------*/
+
+static int prvFlashRead( alt_flash_dev *pxFlash, int iOffset, void *pvDest, int iLength )
+{
+SimFlash_t *pxSimFlash = ( SimFlash_t * ) pxFlash;
+
+	if( ( iOffset < 0 ) || ( iLength < 0 ) || ( iOffset + iLength > pxFlash->length ) )
+	{
+		return -1;
+	}
+
+	prvFlashConsume( ( uint64_t ) iLength * simFLASH_READ_CYCLES );
+	memcpy( pvDest, pxSimFlash->pucData + iOffset, ( size_t ) iLength );
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+static int prvFlashWriteBlock( alt_flash_dev *pxFlash, int iBlockOffset, int iDataOffset, const void *pvData, int iLength )
+{
+SimFlash_t *pxSimFlash = ( SimFlash_t * ) pxFlash;
+const uint8_t *pucData = ( const uint8_t * ) pvData;
+int i;
+
+	( void ) iBlockOffset;
+
+	if( ( iDataOffset < 0 ) || ( iLength < 0 ) || ( iDataOffset + iLength > pxFlash->length ) )
+	{
+		return -1;
+	}
+
+	/* Programming can only clear bits. */
+	prvFlashConsume( ( uint64_t ) iLength * simFLASH_PROGRAM_CYCLES );
+	for( i = 0; i < iLength; i++ )
+	{
+		pxSimFlash->pucData[ iDataOffset + i ] &= pucData[ i ];
+	}
+	pxSimFlash->ulWrites++;
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+static int prvFlashWrite( alt_flash_dev *pxFlash, int iOffset, const void *pvSrc, int iLength )
+{
+	/* The HAL's erase and write, used by nothing in the relay, is a block
+	write without the erase here. */
+	return prvFlashWriteBlock( pxFlash, iOffset - ( iOffset % simFLASH_BLOCK_SIZE ), iOffset, pvSrc, iLength );
+}
+/*-----------------------------------------------------------*/
+
+static int prvFlashGetInfo( alt_flash_dev *pxFlash, flash_region **ppxInfo, int *piRegions )
+{
+	*ppxInfo = pxFlash->region_info;
+	*piRegions = pxFlash->number_of_regions;
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+static int prvFlashEraseBlock( alt_flash_dev *pxFlash, int iOffset )
+{
+SimFlash_t *pxSimFlash = ( SimFlash_t * ) pxFlash;
+
+	if( ( iOffset < 0 ) || ( iOffset >= pxFlash->length ) || ( ( iOffset % simFLASH_BLOCK_SIZE ) != 0 ) )
+	{
+		return -1;
+	}
+
+	prvFlashConsume( simFLASH_ERASE_CYCLES );
+	memset( pxSimFlash->pucData + iOffset, 0xFF, simFLASH_BLOCK_SIZE );
+	pxSimFlash->ulErases++;
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulSimGetFlashOperations( uint32_t *pulErases )
+{
+	*pulErases = xFlash.ulErases;
+	return xFlash.ulWrites;
+}
@@ -0,0 +1,143 @@
+/*
+ * Register level models of the DE2-115 peripherals the relay uses, for
+ * building Relay.c on a Linux host.
+ *
+ * alt_sys_init() adds the models to the simulated bus (port.c) and brings up
+ * the BSP drivers on them, as the BSP's alt_sys_init.c does on the board, so
+ * the relay and the drivers run unchanged down to their register accesses.
+ * The functions below drive the inputs and read back the outputs from a test
+ * bench.
+ *
+ * Modelled: the LED, switch, push button and seven segment PIOs, the frequency
+ * analyser, the PS/2 port with a keyboard on it, the character LCD, the VGA
+ * pixel buffer DMA controller and the SRAM it draws into, the character
+ * buffer, and the CFI flash, which is modelled at the HAL flash API rather
+ * than its command set.  The UART and JTAG UART are not modelled: the relay's
+ * console is the host's stdout and opening the UART fails.
+ */
+
+#ifndef PERIPHERALS_H
+#define PERIPHERALS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Returns the number of 16kHz ADC samples in the period of the mains that
+starts at ullNow, which is what the frequency analyser counts, or 0 to stop the
+analyser. */
+typedef uint16_t ( *SimFrequencySource_t )( uint64_t ullNow );
+
+/* Called with the value written to an output PIO's data register. */
+typedef void ( *SimPioObserver_t )( uint32_t ulBase, uint32_t ulData );
+
+/**
+ * peripherals. h
+ * <pre>
+ void alt_sys_init( void );
+ * </pre>
+ *
+ * Adds the models and initialises the drivers on them.  Call once, before
+ * the relay's main(); the PS/2 and LCD drivers wait on the hardware in
+ * simulated time while they initialise.
+ */
+void alt_sys_init( void );
+
+/**
+ * peripherals. h
+ * <pre>
+ void vSimSetFrequencySource( SimFrequencySource_t pxSource );
+ * </pre>
+ *
+ * Starts the frequency analyser with the period pxSource gives for the
+ * current cycle.  An interrupt is raised at the end of each period, when its
+ * count can be read.
+ */
+void vSimSetFrequencySource( SimFrequencySource_t pxSource );
+
+/**
+ * peripherals. h
+ * <pre>
+ void vSimSetFrequencySpeedUp( uint32_t ulSpeedUp );
+ * </pre>
+ *
+ * Makes each period last 1/ulSpeedUp of the time its count says, as if the
+ * mains ran ulSpeedUp times faster while the analyser still counted at 16kHz,
+ * to replay a recorded trace in less simulated time.  The count read is left
+ * as it is.  1, the default, is real time.  Takes effect from the next period.
+ */
+void vSimSetFrequencySpeedUp( uint32_t ulSpeedUp );
+
+/**
+ * peripherals. h
+ * <pre>
+ void vSimSetPioObserver( SimPioObserver_t pxObserver );
+ uint32_t ulSimGetPioData( uint32_t ulBase );
+ * </pre>
+ *
+ * Watch or read the outputs, RED_LEDS_BASE, GREEN_LEDS_BASE and
+ * SEVEN_SEG_BASE.
+ */
+void vSimSetPioObserver( SimPioObserver_t pxObserver );
+uint32_t ulSimGetPioData( uint32_t ulBase );
+
+/**
+ * peripherals. h
+ * <pre>
+ void vSimSetSwitches( uint32_t ulSwitches );
+ void vSimPressButtons( uint32_t ulMask );
+ void vSimReleaseButtons( uint32_t ulMask );
+ * </pre>
+ *
+ * Set the slide switches, and press and release push buttons.  The buttons
+ * read 0 while pressed, as on the board, and the PIO captures the falling
+ * edge.
+ */
+void vSimSetSwitches( uint32_t ulSwitches );
+void vSimPressButtons( uint32_t ulMask );
+void vSimReleaseButtons( uint32_t ulMask );
+
+/**
+ * peripherals. h
+ * <pre>
+ void vSimTypeKey( uint8_t ucScanCode, uint32_t ulHoldCycles );
+ * </pre>
+ *
+ * Presses a key with a single byte scan code (set 2) on the PS/2 keyboard and
+ * releases it ulHoldCycles later: the make code arrives now, then the break
+ * prefix 0xF0 and the code again.
+ */
+void vSimTypeKey( uint8_t ucScanCode, uint32_t ulHoldCycles );
+
+/**
+ * peripherals. h
+ * <pre>
+ void vSimGetLcdLine( uint32_t ulLine, char *pcText );
+ void vSimGetCharBufferLine( uint32_t ulLine, char *pcText );
+ * </pre>
+ *
+ * Copy the visible text of a line of the LCD (16 characters) or of the VGA
+ * character buffer (80) to pcText, with a terminating NUL.  Characters never
+ * written read as spaces.
+ */
+void vSimGetLcdLine( uint32_t ulLine, char *pcText );
+void vSimGetCharBufferLine( uint32_t ulLine, char *pcText );
+
+/**
+ * peripherals. h
+ * <pre>
+ uint32_t ulSimGetFlashOperations( uint32_t *pulErases );
+ * </pre>
+ *
+ * Returns the number of flash block writes, and the number of block erases
+ * in *pulErases.
+ */
+uint32_t ulSimGetFlashOperations( uint32_t *pulErases );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERIPHERALS_H */
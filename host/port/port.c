@@ -0,0 +1,1160 @@
+/*
+ * Simulated port for running the FreeRTOS kernel on a Linux host.
+ *
+ * Everything runs on one host thread.  Each task gets a ucontext and a host
+ * stack of its own, and a context switch is a swapcontext() between them.
+ * Time is simulated: a cycle counter at the 100MHz system clock that only
+ * moves when a task calls vPortSimConsume(), an interrupt is taken or the
+ * processor sleeps in portWAIT_FOR_INTERRUPT(), so runs are exactly
+ * repeatable.
+ *
+ * The Avalon interval timers TIMER1MS and TIMER1US are modelled here,
+ * register for register, so the tick code (including FreeRTOS/port_tickless.c)
+ * programs them exactly as it does on the board.  Other peripherals are models
+ * added with vPortSimAddDevice() (port/peripherals.c has the DE2-115 ones),
+ * which IORD()/IOWR() and the *DIRECT() macros are routed to by address, and
+ * periodic interrupt sources can stand in for the rest of the system.
+ * Interrupt handlers are registered with alt_irq_register() as on the board,
+ * and nest by priority (vPortSetInterruptPriority()) as they do there: a
+ * handler that spends simulated time is interrupted by any higher priority
+ * interrupt that becomes pending meanwhile.
+ *
+ * Code only takes simulated time where it says so with vPortSimConsume(),
+ * unless vPortSimSetAccessCycles() gives every register access a cost.
+ * Interrupt entry and exit are charged portSIM_INTERRUPT_ENTRY_CYCLES and
+ * portSIM_INTERRUPT_EXIT_CYCLES, and vPortSimSetKernelCycles() can charge
+ * critical sections and context switches too.  Code
+ * that polls a peripheral or never blocks, such as the relay's vgaTask, needs
+ * one or time would never move.
+ *
+ * A task has no PC of its own to sample, so with configUSE_PROFILER the
+ * profiler is given the return address of the task's last call into the port
+ * (vPortSimConsume(), entering or leaving a critical section and so on), which
+ * is where any interrupt it takes is taken.  Built with -no-pie those resolve
+ * with nm as the board's PCs do with nios2-elf-nm.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#if( configUSE_PROFILER == 1 )
+	#include "profiler.h"
+#endif
+
+/* Altera includes (host stand-ins where needed). */
+#include "sys/alt_irq.h"
+#include "altera_avalon_timer_regs.h"
+
+#define SYS_CLK_BASE			TIMER1MS_BASE
+#define SYS_CLK_IRQ				TIMER1MS_IRQ
+
+/* Host stack given to each task.  The FreeRTOS stack only holds a pointer to
+the task's context, so the host stack has to be big enough for printf(). */
+#define portSIM_HOST_STACK_SIZE	( 256 * 1024 )
+
+#define portSIM_NO_EVENT		UINT64_MAX
+
+/* Cycles charged for taking an interrupt, assumed rather than measured: on
+entry the exception code in port_asm.S saving the context, the HAL finding the
+handler and prvInterruptEntry() saving the nesting mask and priority, and on
+exit the reverse.  An interrupt that others can nest on costs
+portSIM_NESTING_ENTRY_CYCLES more for prvInterruptEntry()'s read of status and
+writes of ienable and status before the handler, and
+portSIM_NESTING_EXIT_CYCLES for its writes of status and ienable after it.
+Interrupts are disabled throughout. */
+#ifndef portSIM_INTERRUPT_ENTRY_CYCLES
+	#define portSIM_INTERRUPT_ENTRY_CYCLES	60
+#endif
+#ifndef portSIM_INTERRUPT_EXIT_CYCLES
+	#define portSIM_INTERRUPT_EXIT_CYCLES	50
+#endif
+#ifndef portSIM_NESTING_ENTRY_CYCLES
+	#define portSIM_NESTING_ENTRY_CYCLES	16
+#endif
+#ifndef portSIM_NESTING_EXIT_CYCLES
+	#define portSIM_NESTING_EXIT_CYCLES		10
+#endif
+
+typedef struct SIM_TASK_CONTEXT
+{
+	ucontext_t xContext;
+	BaseType_t xInterruptsEnabled;	/*<< Interrupt enable state saved while the task is switched out, as estatus is on the board. */
+	TaskFunction_t pxCode;
+	void *pvParameters;
+	uintptr_t uxPC;					/*<< uxSimPC saved while the task is switched out. */
+} SimTaskContext_t;
+
+/* Model of one Avalon interval timer. */
+typedef struct SIM_TIMER
+{
+	uint32_t ulBase;
+	uint32_t ulIrq;
+	uint32_t ulPeriod;
+	uint32_t ulControl;			/*<< ITO and CONT bits. */
+	uint32_t ulSnap;
+	BaseType_t xTimedOut;		/*<< The TO status bit. */
+	BaseType_t xRunning;
+	uint32_t ulCountAtStart;	/*<< Counter value when it last started counting... */
+	uint64_t ullStartedAt;		/*<< ...and the cycle it did so. */
+} SimTimer_t;
+
+typedef struct SIM_INTERRUPT
+{
+	void ( *pxHandler )( void *, alt_u32 );
+	void *pvContext;
+	uint64_t ullPeriod;			/*<< 0 unless the line is a periodic source. */
+	uint64_t ullNextAt;
+	BaseType_t xPending;		/*<< Latched for a periodic source, cleared when its handler is called. */
+	uint32_t ulCount;
+	UBaseType_t uxPriority;
+	BaseType_t xLineRaised;		/*<< Held up by a level sensitive device, see vPortSimSetInterruptLine(). */
+	uint64_t ullPendingSince;	/*<< Cycle the line was last raised, for the latency figures. */
+	uint64_t ullLatencyMax;
+	uint64_t ullLatencyTotal;
+} SimInterrupt_t;
+
+/* The kernel's current TCB.  Its first member is pxTopOfStack, which holds
+the address of the task's SimTaskContext_t. */
+typedef void TCB_t;
+extern TCB_t * volatile pxCurrentTCB;
+
+static SimTimer_t xSimTimers[] =
+{
+	{ TIMER1MS_BASE, TIMER1MS_IRQ, 0, 0, 0, pdFALSE, pdFALSE, 0, 0 },
+	{ TIMER1US_BASE, TIMER1US_IRQ, 0, 0, 0, pdFALSE, pdFALSE, 0, 0 }
+};
+#define portSIM_TIMER_COUNT		( sizeof( xSimTimers ) / sizeof( xSimTimers[ 0 ] ) )
+
+static SimInterrupt_t xSimInterrupts[ ALT_NIRQ ] = { [ 0 ... ALT_NIRQ - 1 ] = { .uxPriority = configKERNEL_INTERRUPT_PRIORITY } };
+
+/* Device models added with vPortSimAddDevice(). */
+#define portSIM_MAX_DEVICES		16
+static SimDevice_t *pxSimDevices[ portSIM_MAX_DEVICES ];
+static uint32_t ulSimDeviceCount = 0;
+
+/* Device the last direct access went to.  Drawing hits the same one many
+times in a row. */
+static SimDevice_t *pxSimLastDevice = NULL;
+
+/* Cycles each register access takes, 0 unless vPortSimSetAccessCycles() has
+been called. */
+static uint32_t ulSimAccessCycles = 0;
+
+/* Cycles each critical section and each context switch take, 0 unless
+vPortSimSetKernelCycles() has been called. */
+static uint32_t ulSimCriticalCycles = 0;
+static uint32_t ulSimSwitchCycles = 0;
+
+/* prvNextEventTime() as last worked out, or 0 once anything may have moved it.
+Lets time pass without looking at every peripheral until then. */
+static uint64_t ullSimNextEvent = 0;
+
+static uint64_t ullSimNow = 0;
+static uint64_t ullSimSleepCycles = 0;
+static BaseType_t xSimInterruptsEnabled = pdFALSE;
+static BaseType_t xSimInISR = pdFALSE;
+static BaseType_t xSimYieldPending = pdFALSE;
+static BaseType_t xSimSchedulerRunning = pdFALSE;
+static ucontext_t xSimMainContext;
+
+/* Priority of the interrupt being handled, 0 while a task is running. */
+volatile UBaseType_t uxPortInterruptPriority = 0;
+
+/* Return address of the last call into the port, the running code's PC as
+far as the profiler is concerned. */
+static uintptr_t uxSimPC = 0;
+#define portSIM_SET_PC()		uxSimPC = ( uintptr_t ) __builtin_return_address( 0 )
+
+#if( configUSE_PROFILER == 1 )
+	/* The interrupt being handled, profilerNO_INTERRUPT while a task is
+	running, as port.c on the board. */
+	static uint32_t ulSimCurrentInterrupt = profilerNO_INTERRUPT;
+#endif
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Setup the timer to generate the tick interrupts.
+ */
+static void prvSetupTimerInterrupt( void );
+
+/*
+ * The tick interrupt handler.
+ */
+static void prvSysTickHandler( void * context, alt_u32 id );
+
+/*
+ * Brings every peripheral up to the current simulated time.
+ */
+static void prvUpdatePeripherals( void );
+
+/*
+ * Returns the cycle of the next timer timeout or periodic interrupt.
+ */
+static uint64_t prvNextEventTime( void );
+
+/*
+ * Returns pdTRUE if the interrupt line is raised.
+ */
+static BaseType_t prvInterruptRaised( uint32_t ulIrq );
+
+/*
+ * Returns the lowest numbered pending interrupt with a priority above
+ * uxAbovePriority, as the Nios II internal interrupt controller would, or -1.
+ */
+static int prvHighestPendingInterrupt( UBaseType_t uxAbovePriority );
+
+/*
+ * Calls the handler of every pending interrupt that may interrupt the current
+ * level if interrupts are enabled, then, back at task level, switches task if
+ * one of them asked to.
+ */
+static void prvServiceInterrupts( void );
+
+/*
+ * Calls one interrupt handler, with interrupts enabled if a higher priority
+ * interrupt could nest on it.
+ */
+static void prvTakeInterrupt( int iIrq );
+
+/*
+ * Marks an interrupt line raised at ullAt, if it was not already.
+ */
+static void prvRaiseInterrupt( uint32_t ulIrq, uint64_t ullAt );
+
+/*
+ * Moves simulated time on by ullCycles, taking each interrupt at the cycle it
+ * becomes pending.
+ */
+static void prvAdvance( uint64_t ullCycles );
+
+/*
+ * Charges a register access made by the running code.
+ */
+static void prvChargeAccess( void );
+
+/*
+ * Returns the device model that holds ulAddress, or NULL.
+ */
+static SimDevice_t *prvFindDevice( uint32_t ulAddress );
+
+/*
+ * Register accesses to the timer models.
+ */
+static alt_u32 prvReadTimer( SimTimer_t *pxTimer, alt_u32 ulRegister );
+static void prvWriteTimer( SimTimer_t *pxTimer, alt_u32 ulRegister, alt_u32 ulData );
+
+/*
+ * Selects the next task and swaps to it.
+ */
+static void prvSwitchContext( void );
+
+/*
+ * First function run by every task.
+ */
+static void prvTaskEntry( void );
+
+/*-----------------------------------------------------------*/
+
+static SimTaskContext_t *prvCurrentContext( void )
+{
+	return ( SimTaskContext_t * ) **( StackType_t * volatile * ) pxCurrentTCB;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationStackOverflowHook( TaskHandle_t *pxTask, signed char *pcTaskName )
+{
+	( void ) pxTask;
+	fprintf( stderr, "[free_rtos] Application stack overflow at task: %s\n", pcTaskName );
+	abort();
+}
+/*-----------------------------------------------------------*/
+
+StackType_t *pxPortInitialiseStack( StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters )
+{
+SimTaskContext_t *pxTaskContext;
+void *pvHostStack;
+
+	pxTaskContext = ( SimTaskContext_t * ) malloc( sizeof( SimTaskContext_t ) );
+	pvHostStack = malloc( portSIM_HOST_STACK_SIZE );
+	if( ( pxTaskContext == NULL ) || ( pvHostStack == NULL ) )
+	{
+		fprintf( stderr, "port: out of host memory for a task stack\n" );
+		abort();
+	}
+
+	getcontext( &( pxTaskContext->xContext ) );
+	pxTaskContext->xContext.uc_stack.ss_sp = pvHostStack;
+	pxTaskContext->xContext.uc_stack.ss_size = portSIM_HOST_STACK_SIZE;
+	pxTaskContext->xContext.uc_link = NULL;
+	makecontext( &( pxTaskContext->xContext ), prvTaskEntry, 0 );
+
+	/* Tasks start with interrupts enabled. */
+	pxTaskContext->xInterruptsEnabled = pdTRUE;
+	pxTaskContext->pxCode = pxCode;
+	pxTaskContext->pvParameters = pvParameters;
+
+	*pxTopOfStack = ( StackType_t ) pxTaskContext;
+
+	return pxTopOfStack;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTaskEntry( void )
+{
+SimTaskContext_t *pxTaskContext = prvCurrentContext();
+
+	xSimInterruptsEnabled = pxTaskContext->xInterruptsEnabled;
+	uxSimPC = ( uintptr_t ) pxTaskContext->pxCode;
+	prvServiceInterrupts();
+
+	pxTaskContext->pxCode( pxTaskContext->pvParameters );
+
+	fprintf( stderr, "port: a task returned from its implementing function\n" );
+	abort();
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortStartScheduler( void )
+{
+	/* Start the timer that generates the tick ISR.  Interrupts are disabled
+	here already. */
+	prvSetupTimerInterrupt();
+
+	xSimSchedulerRunning = pdTRUE;
+	swapcontext( &xSimMainContext, &( prvCurrentContext()->xContext ) );
+
+	/* vPortEndScheduler() comes back here. */
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEndScheduler( void )
+{
+	xSimSchedulerRunning = pdFALSE;
+	setcontext( &xSimMainContext );
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetupTimerInterrupt( void )
+{
+	alt_irq_register( SYS_CLK_IRQ, 0x0, prvSysTickHandler );
+
+	/* Configure the tick timer exactly as the Nios II port does. */
+	IOWR_ALTERA_AVALON_TIMER_CONTROL( SYS_CLK_BASE, ALTERA_AVALON_TIMER_CONTROL_STOP_MSK );
+	IOWR_ALTERA_AVALON_TIMER_PERIODL( SYS_CLK_BASE, ( ( TIMER1MS_FREQ / configTICK_RATE_HZ ) - 1 ) & 0xFFFF );
+	IOWR_ALTERA_AVALON_TIMER_PERIODH( SYS_CLK_BASE, ( ( TIMER1MS_FREQ / configTICK_RATE_HZ ) - 1 ) >> 16 );
+	IOWR_ALTERA_AVALON_TIMER_CONTROL( SYS_CLK_BASE, ALTERA_AVALON_TIMER_CONTROL_CONT_MSK | ALTERA_AVALON_TIMER_CONTROL_START_MSK | ALTERA_AVALON_TIMER_CONTROL_ITO_MSK );
+	IOWR_ALTERA_AVALON_TIMER_STATUS( SYS_CLK_BASE, ~ALTERA_AVALON_TIMER_STATUS_TO_MSK );
+}
+/*-----------------------------------------------------------*/
+
+static void prvSysTickHandler( void * context, alt_u32 id )
+{
+UBaseType_t uxSavedInterruptStatus;
+
+	( void ) context;
+	( void ) id;
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		#if( configUSE_TICKLESS_IDLE == 1 )
+		{
+			vPortTicklessTickInterrupt();
+		}
+		#endif
+
+		#if( configGENERATE_RUN_TIME_STATS == 1 )
+		{
+			vPortRunTimeTickInterrupt();
+		}
+		#endif
+
+		portEND_SWITCHING_ISR( xTaskIncrementTick() );
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	IOWR_ALTERA_AVALON_TIMER_STATUS( SYS_CLK_BASE, ~ALTERA_AVALON_TIMER_STATUS_TO_MSK );
+}
+/*-----------------------------------------------------------*/
+
+void vPortYield( void )
+{
+	if( xSimInISR != pdFALSE )
+	{
+		/* As on the board the switch happens on the way out of the ISR. */
+		xSimYieldPending = pdTRUE;
+	}
+	else
+	{
+		prvSwitchContext();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvSwitchContext( void )
+{
+SimTaskContext_t *pxFrom = prvCurrentContext(), *pxTo;
+
+	pxFrom->xInterruptsEnabled = xSimInterruptsEnabled;
+	pxFrom->uxPC = uxSimPC;
+
+	/* Interrupts are masked as they are in the trap, so one taken while the
+	kernel's own critical sections are charged cannot switch again. */
+	xSimInterruptsEnabled = pdFALSE;
+	vTaskSwitchContext();
+	pxTo = prvCurrentContext();
+
+	if( pxTo != pxFrom )
+	{
+		/* Saving one context and restoring the other. */
+		prvAdvance( ulSimSwitchCycles );
+
+		swapcontext( &( pxFrom->xContext ), &( pxTo->xContext ) );
+	}
+
+	/* Switched back in, or never left. */
+	xSimInterruptsEnabled = pxFrom->xInterruptsEnabled;
+	uxSimPC = pxFrom->uxPC;
+	prvServiceInterrupts();
+}
+/*-----------------------------------------------------------*/
+
+void vPortDisableInterrupts( void )
+{
+	xSimInterruptsEnabled = pdFALSE;
+
+	/* Charged as the critical section this nearly always starts. */
+	prvAdvance( ulSimCriticalCycles );
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnableInterrupts( void )
+{
+	portSIM_SET_PC();
+
+	if( xSimInISR == pdFALSE )
+	{
+		xSimInterruptsEnabled = pdTRUE;
+		prvServiceInterrupts();
+	}
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxPortSetInterruptMask( void )
+{
+UBaseType_t uxSaved = ( UBaseType_t ) xSimInterruptsEnabled;
+
+	xSimInterruptsEnabled = pdFALSE;
+	prvAdvance( ulSimCriticalCycles );
+
+	return uxSaved;
+}
+/*-----------------------------------------------------------*/
+
+void vPortClearInterruptMask( UBaseType_t uxSavedStatusValue )
+{
+	/* Unlike portENABLE_INTERRUPTS() this is used in handlers, which run with
+	interrupts enabled when another interrupt can nest on them. */
+	portSIM_SET_PC();
+
+	if( uxSavedStatusValue != 0 )
+	{
+		xSimInterruptsEnabled = pdTRUE;
+		prvServiceInterrupts();
+	}
+}
+/*-----------------------------------------------------------*/
+
+int alt_irq_register( alt_u32 id, void* context, void (*handler)(void*, alt_u32) )
+{
+	if( id >= ALT_NIRQ )
+	{
+		return -1;
+	}
+
+	xSimInterrupts[ id ].pxHandler = handler;
+	xSimInterrupts[ id ].pvContext = context;
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+void vPortSetInterruptPriority( uint32_t ulIrq, UBaseType_t uxPriority )
+{
+	configASSERT( ulIrq < ALT_NIRQ );
+	configASSERT( uxPriority >= configKERNEL_INTERRUPT_PRIORITY );
+
+	xSimInterrupts[ ulIrq ].uxPriority = uxPriority;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvInterruptRaised( uint32_t ulIrq )
+{
+uint32_t ul;
+
+	if( ( xSimInterrupts[ ulIrq ].xPending != pdFALSE ) || ( xSimInterrupts[ ulIrq ].xLineRaised != pdFALSE ) )
+	{
+		return pdTRUE;
+	}
+
+	for( ul = 0; ul < portSIM_TIMER_COUNT; ul++ )
+	{
+		if( ( xSimTimers[ ul ].ulIrq == ulIrq ) && ( xSimTimers[ ul ].xTimedOut != pdFALSE ) &&
+			( ( xSimTimers[ ul ].ulControl & ALTERA_AVALON_TIMER_CONTROL_ITO_MSK ) != 0 ) )
+		{
+			return pdTRUE;
+		}
+	}
+
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static int prvHighestPendingInterrupt( UBaseType_t uxAbovePriority )
+{
+int iIrq;
+
+	for( iIrq = 0; iIrq < ALT_NIRQ; iIrq++ )
+	{
+		if( ( xSimInterrupts[ iIrq ].pxHandler != NULL ) && ( xSimInterrupts[ iIrq ].uxPriority > uxAbovePriority ) &&
+			( prvInterruptRaised( ( uint32_t ) iIrq ) != pdFALSE ) )
+		{
+			return iIrq;
+		}
+	}
+
+	return -1;
+}
+/*-----------------------------------------------------------*/
+
+static void prvServiceInterrupts( void )
+{
+int iIrq;
+
+	if( ( xSimInterruptsEnabled == pdFALSE ) || ( xSimSchedulerRunning == pdFALSE ) )
+	{
+		return;
+	}
+
+	while( ( iIrq = prvHighestPendingInterrupt( uxPortInterruptPriority ) ) >= 0 )
+	{
+		prvTakeInterrupt( iIrq );
+	}
+
+	/* As on the board the switch waits for the outermost handler. */
+	if( ( xSimInISR == pdFALSE ) && ( xSimYieldPending != pdFALSE ) )
+	{
+		xSimYieldPending = pdFALSE;
+		prvSwitchContext();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvTakeInterrupt( int iIrq )
+{
+SimInterrupt_t *pxInterrupt = &( xSimInterrupts[ iIrq ] );
+BaseType_t xSavedInISR = xSimInISR;
+UBaseType_t uxSavedPriority = uxPortInterruptPriority;
+BaseType_t xNests = pdFALSE;
+uint64_t ullLatency;
+int iOther;
+
+#if( configUSE_PROFILER == 1 )
+uint32_t ulSavedInterrupt = ulSimCurrentInterrupt;
+uintptr_t uxSavedPC = uxSimPC;
+BaseType_t xTickDue;
+#endif
+
+	#if( configUSE_PROFILER == 1 )
+	{
+		/* As prvInterruptEntry() on the board. */
+		if( iIrq == SYS_CLK_IRQ )
+		{
+			if( ulSimCurrentInterrupt == profilerNO_INTERRUPT )
+			{
+				vProfilerSampleFromISR( uxSimPC );
+			}
+			else
+			{
+				vProfilerClaimSampleFromISR( ulSimCurrentInterrupt, ( uintptr_t ) xSimInterrupts[ ulSimCurrentInterrupt ].pxHandler );
+				vProfilerSampleFromISR( 0 );
+			}
+		}
+
+		/* The timer is read directly rather than through IORD() so that no
+		access cycles are charged here. */
+		prvUpdatePeripherals();
+		xTickDue = xSimTimers[ 0 ].xTimedOut;
+		ulSimCurrentInterrupt = ( uint32_t ) iIrq;
+	}
+	#endif
+
+	xSimInISR = pdTRUE;
+	xSimInterruptsEnabled = pdFALSE;
+	pxInterrupt->xPending = pdFALSE;
+	pxInterrupt->ulCount++;
+	prvAdvance( portSIM_INTERRUPT_ENTRY_CYCLES );
+	uxPortInterruptPriority = pxInterrupt->uxPriority;
+
+	for( iOther = 0; iOther < ALT_NIRQ; iOther++ )
+	{
+		if( xSimInterrupts[ iOther ].uxPriority > pxInterrupt->uxPriority )
+		{
+			xNests = pdTRUE;
+		}
+	}
+	if( xNests != pdFALSE )
+	{
+		prvAdvance( portSIM_NESTING_ENTRY_CYCLES );
+		xSimInterruptsEnabled = pdTRUE;
+	}
+
+	/* The latency runs to the handler being called, entry included. */
+	ullLatency = ullSimNow - pxInterrupt->ullPendingSince;
+	if( ullLatency > pxInterrupt->ullLatencyMax )
+	{
+		pxInterrupt->ullLatencyMax = ullLatency;
+	}
+	pxInterrupt->ullLatencyTotal += ullLatency;
+
+	traceISR_ENTER( ( uint32_t ) iIrq );
+	pxInterrupt->pxHandler( pxInterrupt->pvContext, ( alt_u32 ) iIrq );
+
+	#if( configUSE_PROFILER == 1 )
+	{
+		ulSimCurrentInterrupt = ulSavedInterrupt;
+		uxSimPC = uxSavedPC;
+
+		prvUpdatePeripherals();
+		if( ( iIrq != SYS_CLK_IRQ ) && ( xTickDue == pdFALSE ) && ( xSimTimers[ 0 ].xTimedOut != pdFALSE ) )
+		{
+			vProfilerClaimSampleFromISR( ( uint32_t ) iIrq, ( uintptr_t ) pxInterrupt->pxHandler );
+		}
+	}
+	#endif
+
+	traceISR_EXIT( ( uint32_t ) iIrq );
+
+	xSimInterruptsEnabled = pdFALSE;
+	prvAdvance( ( xNests != pdFALSE ) ? portSIM_NESTING_EXIT_CYCLES + portSIM_INTERRUPT_EXIT_CYCLES : portSIM_INTERRUPT_EXIT_CYCLES );
+
+	uxPortInterruptPriority = uxSavedPriority;
+	xSimInISR = xSavedInISR;
+	xSimInterruptsEnabled = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRaiseInterrupt( uint32_t ulIrq, uint64_t ullAt )
+{
+	if( prvInterruptRaised( ulIrq ) == pdFALSE )
+	{
+		xSimInterrupts[ ulIrq ].ullPendingSince = ullAt;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvTimerCount( const SimTimer_t *pxTimer )
+{
+	if( pxTimer->xRunning == pdFALSE )
+	{
+		return pxTimer->ulCountAtStart;
+	}
+
+	return pxTimer->ulCountAtStart - ( uint32_t ) ( ullSimNow - pxTimer->ullStartedAt );
+}
+/*-----------------------------------------------------------*/
+
+static void prvUpdatePeripherals( void )
+{
+uint32_t ul;
+uint64_t ullTimeout;
+
+	for( ul = 0; ul < portSIM_TIMER_COUNT; ul++ )
+	{
+		SimTimer_t *pxTimer = &( xSimTimers[ ul ] );
+
+		/* The counter times out one count after reaching zero, then reloads
+		from the period registers and either carries on or stops. */
+		while( pxTimer->xRunning != pdFALSE )
+		{
+			ullTimeout = pxTimer->ullStartedAt + ( uint64_t ) pxTimer->ulCountAtStart + 1ULL;
+			if( ullTimeout > ullSimNow )
+			{
+				break;
+			}
+
+			prvRaiseInterrupt( pxTimer->ulIrq, ullTimeout );
+			pxTimer->xTimedOut = pdTRUE;
+			pxTimer->ulCountAtStart = pxTimer->ulPeriod;
+			pxTimer->ullStartedAt = ullTimeout;
+
+			if( ( pxTimer->ulControl & ALTERA_AVALON_TIMER_CONTROL_CONT_MSK ) == 0 )
+			{
+				pxTimer->xRunning = pdFALSE;
+			}
+		}
+	}
+
+	for( ul = 0; ul < ALT_NIRQ; ul++ )
+	{
+		SimInterrupt_t *pxInterrupt = &( xSimInterrupts[ ul ] );
+
+		while( ( pxInterrupt->ullPeriod != 0 ) && ( pxInterrupt->ullNextAt <= ullSimNow ) )
+		{
+			prvRaiseInterrupt( ul, pxInterrupt->ullNextAt );
+			pxInterrupt->xPending = pdTRUE;
+			pxInterrupt->ullNextAt += pxInterrupt->ullPeriod;
+		}
+	}
+
+	for( ul = 0; ul < ulSimDeviceCount; ul++ )
+	{
+		if( pxSimDevices[ ul ]->pxUpdate != NULL )
+		{
+			pxSimDevices[ ul ]->pxUpdate( pxSimDevices[ ul ], ullSimNow );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNextEventTime( void )
+{
+uint64_t ullNext = portSIM_NO_EVENT, ullAt;
+uint32_t ul;
+
+	for( ul = 0; ul < portSIM_TIMER_COUNT; ul++ )
+	{
+		if( xSimTimers[ ul ].xRunning != pdFALSE )
+		{
+			ullAt = xSimTimers[ ul ].ullStartedAt + ( uint64_t ) xSimTimers[ ul ].ulCountAtStart + 1ULL;
+			if( ullAt < ullNext )
+			{
+				ullNext = ullAt;
+			}
+		}
+	}
+
+	for( ul = 0; ul < ALT_NIRQ; ul++ )
+	{
+		if( ( xSimInterrupts[ ul ].ullPeriod != 0 ) && ( xSimInterrupts[ ul ].ullNextAt < ullNext ) )
+		{
+			ullNext = xSimInterrupts[ ul ].ullNextAt;
+		}
+	}
+
+	for( ul = 0; ul < ulSimDeviceCount; ul++ )
+	{
+		if( pxSimDevices[ ul ]->pxNextEvent != NULL )
+		{
+			ullAt = pxSimDevices[ ul ]->pxNextEvent( pxSimDevices[ ul ] );
+			if( ullAt < ullNext )
+			{
+				ullNext = ullAt;
+			}
+		}
+	}
+
+	return ullNext;
+}
+/*-----------------------------------------------------------*/
+
+static void prvAdvance( uint64_t ullCycles )
+{
+uint64_t ullRemaining = ullCycles, ullNext;
+
+	/* Step from event to event so each interrupt is taken at the cycle it
+	happens.  If it switches to another task the rest of the work is done when
+	this task runs again. */
+	while( ullRemaining > 0 )
+	{
+		ullNext = prvNextEventTime();
+
+		if( ( ullNext == portSIM_NO_EVENT ) || ( ( ullNext - ullSimNow ) > ullRemaining ) )
+		{
+			ullSimNow += ullRemaining;
+			ullRemaining = 0;
+		}
+		else
+		{
+			ullRemaining -= ullNext - ullSimNow;
+			ullSimNow = ullNext;
+		}
+
+		prvUpdatePeripherals();
+		prvServiceInterrupts();
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortSimConsume( uint32_t ulCycles )
+{
+	portSIM_SET_PC();
+	prvAdvance( ulCycles );
+}
+/*-----------------------------------------------------------*/
+
+static void prvChargeAccess( void )
+{
+	/* Most accesses end before anything else happens, and then there is
+	nothing to do but count the cycles. */
+	if( ( ullSimNextEvent != 0 ) && ( ( ullSimNow + ulSimAccessCycles ) < ullSimNextEvent ) )
+	{
+		ullSimNow += ulSimAccessCycles;
+		return;
+	}
+
+	/* Otherwise the access may have raised an interrupt, or something happens
+	before it ends. */
+	prvUpdatePeripherals();
+	prvServiceInterrupts();
+	prvAdvance( ulSimAccessCycles );
+	ullSimNextEvent = prvNextEventTime();
+}
+/*-----------------------------------------------------------*/
+
+void vPortSimWaitForInterrupt( void )
+{
+uint64_t ullNext, ullFrom = ullSimNow;
+
+	portSIM_SET_PC();
+
+	while( prvHighestPendingInterrupt( 0 ) < 0 )
+	{
+		ullNext = prvNextEventTime();
+		if( ullNext == portSIM_NO_EVENT )
+		{
+			fprintf( stderr, "port: sleeping with no interrupt source running\n" );
+			abort();
+		}
+
+		ullSimNow = ullNext;
+		prvUpdatePeripherals();
+	}
+
+	ullSimSleepCycles += ullSimNow - ullFrom;
+}
+/*-----------------------------------------------------------*/
+
+void vPortSimSetPeriodicInterrupt( uint32_t ulIrq, uint64_t ullPeriod, uint64_t ullFirst )
+{
+	configASSERT( ulIrq < ALT_NIRQ );
+
+	xSimInterrupts[ ulIrq ].ullPeriod = ullPeriod;
+	xSimInterrupts[ ulIrq ].ullNextAt = ullFirst;
+	ullSimNextEvent = 0;
+}
+/*-----------------------------------------------------------*/
+
+void vPortSimAddDevice( SimDevice_t *pxDevice )
+{
+	if( ulSimDeviceCount >= portSIM_MAX_DEVICES )
+	{
+		fprintf( stderr, "port: more than %d devices\n", portSIM_MAX_DEVICES );
+		abort();
+	}
+
+	pxSimDevices[ ulSimDeviceCount++ ] = pxDevice;
+	ullSimNextEvent = 0;
+}
+/*-----------------------------------------------------------*/
+
+void vPortSimRaiseInterrupt( uint32_t ulIrq, uint64_t ullAt )
+{
+	configASSERT( ulIrq < ALT_NIRQ );
+
+	prvRaiseInterrupt( ulIrq, ullAt );
+	xSimInterrupts[ ulIrq ].xPending = pdTRUE;
+	ullSimNextEvent = 0;
+}
+/*-----------------------------------------------------------*/
+
+void vPortSimSetInterruptLine( uint32_t ulIrq, BaseType_t xRaised )
+{
+	configASSERT( ulIrq < ALT_NIRQ );
+
+	if( xRaised != pdFALSE )
+	{
+		prvRaiseInterrupt( ulIrq, ullSimNow );
+		ullSimNextEvent = 0;
+	}
+
+	xSimInterrupts[ ulIrq ].xLineRaised = xRaised;
+}
+/*-----------------------------------------------------------*/
+
+void vPortSimEventsChanged( void )
+{
+	ullSimNextEvent = 0;
+}
+/*-----------------------------------------------------------*/
+
+void vPortSimSetAccessCycles( uint32_t ulCycles )
+{
+	ulSimAccessCycles = ulCycles;
+}
+/*-----------------------------------------------------------*/
+
+void vPortSimSetKernelCycles( uint32_t ulCriticalCycles, uint32_t ulSwitchCycles )
+{
+	ulSimCriticalCycles = ulCriticalCycles;
+	ulSimSwitchCycles = ulSwitchCycles;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t ullPortSimGetCycles( void )
+{
+	return ullSimNow;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t ullPortSimGetSleepCycles( void )
+{
+	return ullSimSleepCycles;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulPortSimGetInterruptCount( uint32_t ulIrq )
+{
+	return ( ulIrq < ALT_NIRQ ) ? xSimInterrupts[ ulIrq ].ulCount : 0;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t ullPortSimGetInterruptLatencyMax( uint32_t ulIrq )
+{
+	return ( ulIrq < ALT_NIRQ ) ? xSimInterrupts[ ulIrq ].ullLatencyMax : 0;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t ullPortSimGetInterruptLatencyTotal( uint32_t ulIrq )
+{
+	return ( ulIrq < ALT_NIRQ ) ? xSimInterrupts[ ulIrq ].ullLatencyTotal : 0;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxPortGetISRStackHighWaterMark( void )
+{
+	/* Handlers run on the interrupted task's host stack, not a stack of their
+	own, so there is nothing to measure. */
+	return configISR_STACK_SIZE;
+}
+/*-----------------------------------------------------------*/
+
+static SimTimer_t *prvFindTimer( alt_u32 ulBase )
+{
+uint32_t ul;
+
+	for( ul = 0; ul < portSIM_TIMER_COUNT; ul++ )
+	{
+		if( xSimTimers[ ul ].ulBase == ulBase )
+		{
+			return &( xSimTimers[ ul ] );
+		}
+	}
+
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static SimDevice_t *prvFindDevice( uint32_t ulAddress )
+{
+uint32_t ul;
+
+	if( ( pxSimLastDevice != NULL ) && ( ( ulAddress - pxSimLastDevice->ulBase ) < pxSimLastDevice->ulSpan ) )
+	{
+		return pxSimLastDevice;
+	}
+
+	for( ul = 0; ul < ulSimDeviceCount; ul++ )
+	{
+		if( ( ulAddress - pxSimDevices[ ul ]->ulBase ) < pxSimDevices[ ul ]->ulSpan )
+		{
+			pxSimLastDevice = pxSimDevices[ ul ];
+			return pxSimLastDevice;
+		}
+	}
+
+	fprintf( stderr, "port: access to unmodelled peripheral at 0x%lx\n", ( unsigned long ) ulAddress );
+	abort();
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+alt_u32 ulPortSimIOReadDirect( alt_u32 ulAddress, alt_u32 ulBytes )
+{
+SimDevice_t *pxDevice = prvFindDevice( ulAddress );
+alt_u32 ulData;
+
+	/* A device with events of its own has to be brought up to date first.
+	Memory does not. */
+	if( pxDevice->pxNextEvent != NULL )
+	{
+		prvUpdatePeripherals();
+	}
+
+	ulData = pxDevice->pxRead( pxDevice, ulAddress - pxDevice->ulBase, ulBytes );
+
+	if( pxDevice->pxNextEvent != NULL )
+	{
+		ullSimNextEvent = 0;
+	}
+
+	if( ulSimAccessCycles != 0 )
+	{
+		portSIM_SET_PC();
+		prvChargeAccess();
+	}
+
+	return ulData;
+}
+/*-----------------------------------------------------------*/
+
+void vPortSimIOWriteDirect( alt_u32 ulAddress, alt_u32 ulData, alt_u32 ulBytes )
+{
+SimDevice_t *pxDevice = prvFindDevice( ulAddress );
+
+	if( pxDevice->pxNextEvent != NULL )
+	{
+		prvUpdatePeripherals();
+	}
+
+	pxDevice->pxWrite( pxDevice, ulAddress - pxDevice->ulBase, ulData, ulBytes );
+
+	if( pxDevice->pxNextEvent != NULL )
+	{
+		ullSimNextEvent = 0;
+	}
+
+	if( ulSimAccessCycles != 0 )
+	{
+		portSIM_SET_PC();
+		prvChargeAccess();
+	}
+}
+/*-----------------------------------------------------------*/
+
+alt_u32 ulPortSimIORead( alt_u32 ulBase, alt_u32 ulRegister )
+{
+SimTimer_t *pxTimer = prvFindTimer( ulBase );
+alt_u32 ulData;
+
+	if( pxTimer == NULL )
+	{
+		return ulPortSimIOReadDirect( ulBase + ( ulRegister * 4 ), 4 );
+	}
+
+	prvUpdatePeripherals();
+	ulData = prvReadTimer( pxTimer, ulRegister );
+
+	if( ulSimAccessCycles != 0 )
+	{
+		portSIM_SET_PC();
+		prvChargeAccess();
+	}
+
+	return ulData;
+}
+/*-----------------------------------------------------------*/
+
+static alt_u32 prvReadTimer( SimTimer_t *pxTimer, alt_u32 ulRegister )
+{
+
+	switch( ulRegister )
+	{
+		case ALTERA_AVALON_TIMER_STATUS_REG :
+			return ( pxTimer->xTimedOut ? ALTERA_AVALON_TIMER_STATUS_TO_MSK : 0 ) | ( pxTimer->xRunning ? ALTERA_AVALON_TIMER_STATUS_RUN_MSK : 0 );
+		case ALTERA_AVALON_TIMER_CONTROL_REG :
+			return pxTimer->ulControl;
+		case ALTERA_AVALON_TIMER_PERIODL_REG :
+			return pxTimer->ulPeriod & 0xFFFF;
+		case ALTERA_AVALON_TIMER_PERIODH_REG :
+			return pxTimer->ulPeriod >> 16;
+		case ALTERA_AVALON_TIMER_SNAPL_REG :
+			return pxTimer->ulSnap & 0xFFFF;
+		case ALTERA_AVALON_TIMER_SNAPH_REG :
+			return pxTimer->ulSnap >> 16;
+		default :
+			return 0;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortSimIOWrite( alt_u32 ulBase, alt_u32 ulRegister, alt_u32 ulData )
+{
+SimTimer_t *pxTimer = prvFindTimer( ulBase );
+
+	if( pxTimer == NULL )
+	{
+		vPortSimIOWriteDirect( ulBase + ( ulRegister * 4 ), ulData, 4 );
+		return;
+	}
+
+	prvUpdatePeripherals();
+	prvWriteTimer( pxTimer, ulRegister, ulData );
+
+	/* The write may have started, stopped or reloaded the timer. */
+	ullSimNextEvent = 0;
+
+	if( ulSimAccessCycles != 0 )
+	{
+		portSIM_SET_PC();
+		prvChargeAccess();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvWriteTimer( SimTimer_t *pxTimer, alt_u32 ulRegister, alt_u32 ulData )
+{
+
+	switch( ulRegister )
+	{
+		case ALTERA_AVALON_TIMER_STATUS_REG :
+			/* Any write clears TO. */
+			pxTimer->xTimedOut = pdFALSE;
+			break;
+
+		case ALTERA_AVALON_TIMER_CONTROL_REG :
+			pxTimer->ulControl = ulData & ( ALTERA_AVALON_TIMER_CONTROL_ITO_MSK | ALTERA_AVALON_TIMER_CONTROL_CONT_MSK );
+			if( ( ulData & ALTERA_AVALON_TIMER_CONTROL_STOP_MSK ) != 0 )
+			{
+				pxTimer->ulCountAtStart = prvTimerCount( pxTimer );
+				pxTimer->xRunning = pdFALSE;
+			}
+			else if( ( ( ulData & ALTERA_AVALON_TIMER_CONTROL_START_MSK ) != 0 ) && ( pxTimer->xRunning == pdFALSE ) )
+			{
+				pxTimer->ullStartedAt = ullSimNow;
+				pxTimer->xRunning = pdTRUE;
+			}
+			break;
+
+		case ALTERA_AVALON_TIMER_PERIODL_REG :
+		case ALTERA_AVALON_TIMER_PERIODH_REG :
+			/* Writing either half stops the timer and loads the counter. */
+			if( ulRegister == ALTERA_AVALON_TIMER_PERIODL_REG )
+			{
+				pxTimer->ulPeriod = ( pxTimer->ulPeriod & 0xFFFF0000UL ) | ( ulData & 0xFFFF );
+			}
+			else
+			{
+				pxTimer->ulPeriod = ( pxTimer->ulPeriod & 0x0000FFFFUL ) | ( ( ulData & 0xFFFF ) << 16 );
+			}
+			pxTimer->ulCountAtStart = pxTimer->ulPeriod;
+			pxTimer->xRunning = pdFALSE;
+			break;
+
+		case ALTERA_AVALON_TIMER_SNAPL_REG :
+		case ALTERA_AVALON_TIMER_SNAPH_REG :
+			pxTimer->ulSnap = prvTimerCount( pxTimer );
+			break;
+
+		default :
+			break;
+	}
+}
@@ -0,0 +1,170 @@
+/*
+ * Port specific definitions for building the FreeRTOS sources on a Linux host.
+ *
+ * Included from FreeRTOS/portmacro.h when portHOST_SIMULATION is defined, so
+ * the kernel sources themselves are compiled unmodified.
+ */
+
+#ifndef PORTMACRO_HOST_H
+#define PORTMACRO_HOST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* As portmacro.h does on the board, for alt_irq_register(). */
+#include "sys/alt_irq.h"
+
+/* Type definitions. */
+#define portCHAR		char
+#define portFLOAT		float
+#define portDOUBLE		double
+#define portLONG		long
+#define portSHORT		short
+#define portSTACK_TYPE	uintptr_t
+#define portBASE_TYPE	long
+
+typedef portSTACK_TYPE StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#if( configUSE_16_BIT_TICKS == 1 )
+	typedef uint16_t TickType_t;
+	#define portMAX_DELAY ( TickType_t ) 0xffff
+#else
+	typedef uint32_t TickType_t;
+	#define portMAX_DELAY ( TickType_t ) 0xffffffffUL
+	#define portTICK_TYPE_IS_ATOMIC 1
+#endif
+/*-----------------------------------------------------------*/
+
+/* Architecture specifics. */
+#define portSTACK_GROWTH				( -1 )
+#define portTICK_PERIOD_MS				( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portBYTE_ALIGNMENT				8
+#define portNOP()
+#define portCRITICAL_NESTING_IN_TCB		1
+#define portPOINTER_SIZE_TYPE			uintptr_t
+/*-----------------------------------------------------------*/
+
+extern void vTaskSwitchContext( void );
+extern void vPortYield( void );
+#define portYIELD()									vPortYield()
+#define portEND_SWITCHING_ISR( xSwitchRequired ) 	if( xSwitchRequired ) 	vPortYield()
+/*-----------------------------------------------------------*/
+
+extern void vTaskEnterCritical( void );
+extern void vTaskExitCritical( void );
+extern void vPortDisableInterrupts( void );
+extern void vPortEnableInterrupts( void );
+
+#define portDISABLE_INTERRUPTS()	vPortDisableInterrupts()
+#define portENABLE_INTERRUPTS()		vPortEnableInterrupts()
+extern UBaseType_t uxPortSetInterruptMask( void );
+extern void vPortClearInterruptMask( UBaseType_t uxSavedStatusValue );
+#define portSET_INTERRUPT_MASK_FROM_ISR()						uxPortSetInterruptMask()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedStatusValue )	vPortClearInterruptMask( uxSavedStatusValue )
+#define portENTER_CRITICAL()        vTaskEnterCritical()
+#define portEXIT_CRITICAL()         vTaskExitCritical()
+/*-----------------------------------------------------------*/
+
+/* Tickless idle, implemented in FreeRTOS/port_tickless.c. */
+#if( configUSE_TICKLESS_IDLE == 1 )
+	extern void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime );
+	extern void vPortTicklessTickInterrupt( void );
+	#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) vPortSuppressTicksAndSleep( xExpectedIdleTime )
+#endif
+
+/* Run time statistics clock, implemented in FreeRTOS/port_runtime.c. */
+#if( configGENERATE_RUN_TIME_STATS == 1 )
+	extern void vPortConfigureRunTimeCounter( void );
+	extern uint64_t ullPortGetRunTimeCounterValue( void );
+	extern void vPortRunTimeTickInterrupt( void );
+	#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()	vPortConfigureRunTimeCounter()
+	#define portGET_RUN_TIME_COUNTER_VALUE()			ullPortGetRunTimeCounterValue()
+	#define portRUN_TIME_COUNTER_HZ						TIMER1US_FREQ
+#endif
+
+/* Jumps simulated time forward to the next interrupt without taking it. */
+extern void vPortSimWaitForInterrupt( void );
+#define portWAIT_FOR_INTERRUPT()	vPortSimWaitForInterrupt()
+/*-----------------------------------------------------------*/
+
+/*
+ * Simulation control, for host programs only.
+ *
+ * Simulated time is counted in cycles of the 100MHz system clock and only
+ * moves when a task calls vPortSimConsume() to stand for the work it would do
+ * on the board, or when the processor sleeps.  Interrupts are taken at the
+ * cycle they become pending, or as soon as they are enabled again.
+ */
+extern void vPortSimConsume( uint32_t ulCycles );
+extern void vPortSimSetPeriodicInterrupt( uint32_t ulIrq, uint64_t ullPeriod, uint64_t ullFirst );
+extern uint64_t ullPortSimGetCycles( void );
+extern uint64_t ullPortSimGetSleepCycles( void );
+extern uint32_t ulPortSimGetInterruptCount( uint32_t ulIrq );
+
+/* Cycles from an interrupt being raised to its handler being called, the
+longest and the sum over every call. */
+extern uint64_t ullPortSimGetInterruptLatencyMax( uint32_t ulIrq );
+extern uint64_t ullPortSimGetInterruptLatencyTotal( uint32_t ulIrq );
+
+/* Handlers run on the task's stack on the host, so this returns the whole of
+configISR_STACK_SIZE. */
+extern UBaseType_t uxPortGetISRStackHighWaterMark( void );
+
+/*
+ * A peripheral model.  The model embeds one of these as its first member and
+ * is added with vPortSimAddDevice().  Register accesses between ulBase and
+ * ulBase + ulSpan go to pxRead and pxWrite, with the byte offset and the
+ * access width (1, 2 or 4); IORD() and IOWR() are 4 byte accesses at the
+ * register number times 4.  A span of 0 takes no accesses, for a model that
+ * only drives the others.
+ *
+ * A model with events of its own in time, such as a byte arriving, gives the
+ * cycle of the next one from pxNextEvent (UINT64_MAX for none) and has
+ * pxUpdate called at that cycle, and whenever time has moved before one of its
+ * registers is accessed.  A model whose state has changed other than through
+ * its registers or pxUpdate calls vPortSimEventsChanged().  Memory leaves both
+ * NULL, which makes its accesses cheaper.
+ *
+ * A model raises an edge triggered interrupt with vPortSimRaiseInterrupt(),
+ * latched until its handler is called, and holds a level sensitive one with
+ * vPortSimSetInterruptLine() until the handler clears the cause.
+ */
+typedef struct SIM_DEVICE
+{
+	uint32_t ulBase;
+	uint32_t ulSpan;
+	uint32_t ( *pxRead )( struct SIM_DEVICE *pxDevice, uint32_t ulOffset, uint32_t ulBytes );
+	void ( *pxWrite )( struct SIM_DEVICE *pxDevice, uint32_t ulOffset, uint32_t ulData, uint32_t ulBytes );
+	uint64_t ( *pxNextEvent )( struct SIM_DEVICE *pxDevice );
+	void ( *pxUpdate )( struct SIM_DEVICE *pxDevice, uint64_t ullNow );
+} SimDevice_t;
+
+extern void vPortSimAddDevice( SimDevice_t *pxDevice );
+extern void vPortSimRaiseInterrupt( uint32_t ulIrq, uint64_t ullAt );
+extern void vPortSimSetInterruptLine( uint32_t ulIrq, BaseType_t xRaised );
+extern void vPortSimEventsChanged( void );
+
+/* Cycles each register access takes, 0 by default.  Code that polls a
+peripheral, or never blocks, needs a cost for simulated time to move. */
+extern void vPortSimSetAccessCycles( uint32_t ulCycles );
+
+/* Cycles each critical section entered and each switch to another task take,
+with interrupts masked, 0 by default.  They stand in for the kernel code that
+would otherwise run in no simulated time. */
+extern void vPortSimSetKernelCycles( uint32_t ulCriticalCycles, uint32_t ulSwitchCycles );
+/*-----------------------------------------------------------*/
+
+/* Task function macros as described on the FreeRTOS.org WEB site. */
+#define portTASK_FUNCTION_PROTO( vFunction, pvParameters ) void vFunction( void *pvParameters )
+#define portTASK_FUNCTION( vFunction, pvParameters ) void vFunction( void *pvParameters )
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORTMACRO_HOST_H */
@@ -0,0 +1,14 @@
+/*
+ * Stand-in for the HAL priv/alt_file.h when building on a Linux host.
+ */
+
+#ifndef __ALT_FILE_H__
+#define __ALT_FILE_H__
+
+#include "sys/alt_dev.h"
+
+extern alt_llist alt_dev_list;
+
+extern alt_dev *alt_find_dev( const char *name, alt_llist *list );
+
+#endif /* __ALT_FILE_H__ */
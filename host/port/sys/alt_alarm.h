@@ -0,0 +1,31 @@
+/*
+ * Stand-in for the HAL sys/alt_alarm.h when building on a Linux host.
+ *
+ * HAL alarms are run by alt_tick(), which the FreeRTOS tick on the board does
+ * not call, so an alarm started there never fires.  alt_alarm_start() does
+ * nothing here to match.
+ */
+
+#ifndef __ALT_ALARM_H__
+#define __ALT_ALARM_H__
+
+#include "alt_types.h"
+
+typedef struct alt_alarm_s
+{
+	alt_u32 time;
+	alt_u32 ( *callback )( void *context );
+	void *context;
+} alt_alarm;
+
+extern alt_u32 _alt_tick_rate;
+
+extern int alt_alarm_start( alt_alarm *the_alarm, alt_u32 nticks, alt_u32 ( *callback )( void *context ), void *context );
+extern void alt_alarm_stop( alt_alarm *the_alarm );
+
+static inline alt_u32 alt_ticks_per_second( void )
+{
+	return _alt_tick_rate;
+}
+
+#endif /* __ALT_ALARM_H__ */
@@ -0,0 +1,50 @@
+/*
+ * Stand-in for the HAL sys/alt_dev.h when building on a Linux host.
+ *
+ * Character devices are registered with alt_dev_reg() and found by name with
+ * alt_find_dev() as on the board, so the BSP drivers' open functions work
+ * unchanged.  Opening one by name with fopen() goes to its write function, see
+ * port/hal.c.
+ */
+
+#ifndef __ALT_DEV_H__
+#define __ALT_DEV_H__
+
+#include "alt_types.h"
+
+typedef struct alt_llist_s alt_llist;
+struct alt_llist_s
+{
+	alt_llist *next;
+	alt_llist *previous;
+};
+
+#define ALT_LLIST_ENTRY	{ 0, 0 }
+
+typedef struct alt_dev_s alt_dev;
+
+struct stat;
+
+typedef struct alt_fd_s
+{
+	alt_dev *dev;
+	alt_u8 *priv;
+	int fd_flags;
+} alt_fd;
+
+struct alt_dev_s
+{
+	alt_llist llist;
+	const char *name;
+	int (*open)( alt_fd *fd, const char *name, int flags, int mode );
+	int (*close)( alt_fd *fd );
+	int (*read)( alt_fd *fd, char *ptr, int len );
+	int (*write)( alt_fd *fd, const char *ptr, int len );
+	int (*lseek)( alt_fd *fd, int ptr, int dir );
+	int (*fstat)( alt_fd *fd, struct stat *buf );
+	int (*ioctl)( alt_fd *fd, int req, void *arg );
+};
+
+extern int alt_dev_reg( alt_dev *dev );
+
+#endif /* __ALT_DEV_H__ */
@@ -0,0 +1,76 @@
+/*
+ * Stand-in for the HAL sys/alt_flash.h when building on a Linux host.
+ *
+ * The flash device has the HAL's layout and is opened by name from the list
+ * port/hal.c keeps, so a model (port/peripherals.c has the CFI flash) fills in
+ * the function pointers the board's driver would.  There is no data cache to
+ * flush after a write or an erase.
+ */
+
+#ifndef __ALT_FLASH_H__
+#define __ALT_FLASH_H__
+
+#include "alt_types.h"
+#include "sys/alt_dev.h"
+
+#define ALT_MAX_NUMBER_OF_FLASH_REGIONS		8
+
+typedef struct flash_region
+{
+	int offset;
+	int region_size;
+	int number_of_blocks;
+	int block_size;
+} flash_region;
+
+typedef struct alt_flash_dev alt_flash_dev;
+typedef alt_flash_dev alt_flash_fd;
+
+struct alt_flash_dev
+{
+	alt_llist llist;
+	const char *name;
+	alt_flash_dev *( *open )( alt_flash_dev *flash, const char *name );
+	int ( *close )( alt_flash_dev *flash );
+	int ( *write )( alt_flash_dev *flash, int offset, const void *src_addr, int length );
+	int ( *read )( alt_flash_dev *flash, int offset, void *dest_addr, int length );
+	int ( *get_info )( alt_flash_dev *flash, flash_region **info, int *number_of_regions );
+	int ( *erase_block )( alt_flash_dev *flash, int offset );
+	int ( *write_block )( alt_flash_dev *flash, int block_offset, int data_offset, const void *data, int length );
+	void *base_addr;
+	int length;
+	int number_of_regions;
+	flash_region region_info[ ALT_MAX_NUMBER_OF_FLASH_REGIONS ];
+};
+
+extern int alt_flash_device_register( alt_flash_fd *fd );
+extern alt_flash_fd *alt_flash_open_dev( const char *name );
+extern void alt_flash_close_dev( alt_flash_fd *fd );
+
+static inline int alt_write_flash( alt_flash_fd *fd, int offset, const void *src_addr, int length )
+{
+	return fd->write( fd, offset, src_addr, length );
+}
+
+static inline int alt_read_flash( alt_flash_fd *fd, int offset, void *dest_addr, int length )
+{
+	return fd->read( fd, offset, dest_addr, length );
+}
+
+static inline int alt_get_flash_info( alt_flash_fd *fd, flash_region **info, int *number_of_regions )
+{
+	return fd->get_info( fd, info, number_of_regions );
+}
+
+static inline int alt_erase_flash_block( alt_flash_fd *fd, int offset, int length )
+{
+	( void ) length;
+	return fd->erase_block( fd, offset );
+}
+
+static inline int alt_write_flash_block( alt_flash_fd *fd, int block_offset, int data_offset, const void *data, int length )
+{
+	return fd->write_block( fd, block_offset, data_offset, data, length );
+}
+
+#endif /* __ALT_FLASH_H__ */
@@ -0,0 +1,18 @@
+/*
+ * Stand-in for the HAL sys/alt_irq.h when building on a Linux host.
+ *
+ * Handlers registered here are called by the simulated interrupt controller
+ * in port.c.  As on the board, a lower interrupt number has the higher
+ * priority.
+ */
+
+#ifndef __ALT_IRQ_H__
+#define __ALT_IRQ_H__
+
+#include "alt_types.h"
+
+#define ALT_NIRQ	32
+
+extern int alt_irq_register( alt_u32 id, void* context, void (*handler)(void*, alt_u32) );
+
+#endif /* __ALT_IRQ_H__ */
@@ -0,0 +1,75 @@
+/*
+ * Stand-in for the BSP generated system.h when building on a Linux host.
+ *
+ * Only the definitions the FreeRTOS configuration and the host builds refer to
+ * are provided.  Values match freertos_assignment_bsp/system.h.
+ */
+
+#ifndef __SYSTEM_H_
+#define __SYSTEM_H_
+
+#define ALT_CPU_FREQ 100000000
+#define ALT_SYS_CLK TIMER1MS
+
+#define CHARACTER_LCD_BASE 0x430a0
+#define CHARACTER_LCD_NAME "/dev/character_lcd"
+#define CHARACTER_LCD_SPAN 16
+
+#define FLASH_CONTROLLER_BASE 0x1000000
+#define FLASH_CONTROLLER_NAME "/dev/flash_controller"
+#define FLASH_CONTROLLER_SPAN 8388608
+
+#define FREQUENCY_ANALYSER_BASE 0x43100
+#define FREQUENCY_ANALYSER_IRQ 7
+#define FREQUENCY_ANALYSER_SPAN 4
+
+#define GREEN_LEDS_BASE 0x43080
+#define GREEN_LEDS_SPAN 32
+
+#define PS2_BASE 0x430e0
+#define PS2_IRQ 2
+#define PS2_NAME "/dev/ps2"
+#define PS2_SPAN 8
+
+#define PUSH_BUTTON_BASE 0x430c0
+#define PUSH_BUTTON_IRQ 1
+#define PUSH_BUTTON_SPAN 16
+
+#define RED_LEDS_BASE 0x43060
+#define RED_LEDS_SPAN 32
+
+#define SEVEN_SEG_BASE 0x43104
+#define SEVEN_SEG_SPAN 4
+
+#define SLIDE_SWITCH_BASE 0x430b0
+#define SLIDE_SWITCH_SPAN 16
+
+#define SRAM_BASE 0x200000
+#define SRAM_SPAN 2097152
+
+#define SYSTEM_ID_BASE 0x430f0
+#define SYSTEM_ID_ID 7
+#define SYSTEM_ID_TIMESTAMP 1393900972
+
+#define TIMER1MS_BASE 0x43040
+#define TIMER1MS_FREQ 100000000
+#define TIMER1MS_IRQ 0
+#define TIMER1US_BASE 0x43020
+#define TIMER1US_FREQ 100000000
+#define TIMER1US_IRQ 6
+
+#define UART_BASE 0x43000
+#define UART_IRQ 3
+#define UART_NAME "/dev/uart"
+
+#define VIDEO_CHARACTER_BUFFER_WITH_DMA_AVALON_CHAR_BUFFER_SLAVE_BASE 0x40000
+#define VIDEO_CHARACTER_BUFFER_WITH_DMA_AVALON_CHAR_BUFFER_SLAVE_NAME "/dev/video_character_buffer_with_dma_avalon_char_buffer_slave"
+#define VIDEO_CHARACTER_BUFFER_WITH_DMA_AVALON_CHAR_BUFFER_SLAVE_SPAN 8192
+#define VIDEO_CHARACTER_BUFFER_WITH_DMA_AVALON_CHAR_CONTROL_SLAVE_BASE 0x430e8
+#define VIDEO_CHARACTER_BUFFER_WITH_DMA_AVALON_CHAR_CONTROL_SLAVE_SPAN 8
+
+#define VIDEO_PIXEL_BUFFER_DMA_BASE 0x430d0
+#define VIDEO_PIXEL_BUFFER_DMA_NAME "/dev/video_pixel_buffer_dma"
+#define VIDEO_PIXEL_BUFFER_DMA_SPAN 16
+
+#endif /* __SYSTEM_H_ */
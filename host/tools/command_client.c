@@ -0,0 +1,744 @@
+/*
+ * Sends requests on the relay command channel (FreeRTOS/command.h) and
+ * prints the responses.
+ *
+ *   command_client [-b baud] [-t timeout_ms] [-r retries] [-d] device command...
+ *
+ * Commands, run in order:
+ *   ping [count]                 round trips, with latency percentiles
+ *   get                          the frequency and RoC thresholds
+ *   set <Hz> <Hz/s>              sets both thresholds together
+ *   stats                        load manager state and reaction times
+ *   history                      every sample held, newest first
+ *   maintenance on|off|toggle    requests or releases maintenance mode
+ *   snapshot                     has the relay dump its kernel trace
+ *   profile                      has the relay dump its PC sampling profile
+ *
+ * The device is the serial UART or the pseudo terminal host/bench/command_sim
+ * listens on.  A terminal is put into raw mode, at the given baud rate if -b
+ * is passed.  Requests are COBS framed with a CRC, built here without the
+ * target's code.  Responses arrive in the telemetry stream, so every other
+ * frame is skipped.  One request is outstanding at a time, and one that gets
+ * no response within the timeout is sent again under a new id, up to the
+ * retry count.  A toggle whose response was lost may have been applied.
+ *
+ * Round trip times are wall clock, from the write of the request to the read
+ * of its response.  The exit status is 0 when every request got a response,
+ * whatever its status.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <termios.h>
+#include <time.h>
+
+#include "command.h"
+
+#define clientREAD_CHUNK		256
+#define clientMAX_PINGS			100000
+
+/* Room for a frame longer than any the relay sends, so one that lost its
+delimiter is seen as too long rather than overrunning. */
+#define clientMAX_ENCODED		( 4 * telemetryMAX_ENCODED )
+
+static const char * const pcStatusNames[] =
+{
+	"ok", "unknown command", "bad length", "bad value", "unsupported", "busy"
+};
+
+static const char * const pcStateNames[] =
+{
+	"NORMAL", "LOAD_MANAGE", "MAINTENANCE"
+};
+
+typedef struct
+{
+	int iFd;
+	int iTimeoutMs;
+	int iRetries;
+	uint16_t usNextId;
+	/* The last read, and how far into it frames have been taken. */
+	uint8_t ucChunk[ clientREAD_CHUNK ];
+	size_t xChunk, xChunkUsed;
+	/* Encoded bytes since the last delimiter. */
+	uint8_t ucEncoded[ clientMAX_ENCODED ];
+	size_t xEncoded;
+	int iTooLong;
+	/* Frames read that were not the awaited response, and those that were
+	broken. */
+	uint32_t ulSkipped, ulBad, ulTimeouts;
+} Client_t;
+
+typedef struct
+{
+	uint8_t ucStatus;
+	uint8_t ucResult[ commandMAX_RESULT ];
+	size_t xLength;
+	uint64_t ullRoundTripNs;
+} Response_t;
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNowNs( void )
+{
+struct timespec xNow;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvGetLittleEndian( const uint8_t *pucBuffer, size_t xBytes )
+{
+uint32_t ulValue = 0;
+size_t x;
+
+	for( x = 0; x < xBytes; x++ )
+	{
+		ulValue |= ( uint32_t ) pucBuffer[ x ] << ( 8U * x );
+	}
+
+	return ulValue;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPutLittleEndian( uint8_t *pucBuffer, uint32_t ulValue, size_t xBytes )
+{
+size_t x;
+
+	for( x = 0; x < xBytes; x++ )
+	{
+		pucBuffer[ x ] = ( uint8_t ) ( ulValue >> ( 8U * x ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static uint16_t prvCrc( const uint8_t *pucData, size_t xLength )
+{
+uint16_t usCrc = telemetryCRC_INITIAL;
+int iBit;
+
+	while( xLength-- > 0 )
+	{
+		usCrc ^= ( uint16_t ) ( *pucData++ << 8 );
+		for( iBit = 0; iBit < 8; iBit++ )
+		{
+			usCrc = ( uint16_t ) ( ( usCrc & 0x8000U ) ? ( ( usCrc << 1 ) ^ 0x1021U ) : ( usCrc << 1 ) );
+		}
+	}
+
+	return usCrc;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvCobsEncode( const uint8_t *pucData, size_t xLength, uint8_t *pucEncoded )
+{
+size_t xIn, xOut = 1, xCode = 0;
+uint8_t ucRun = 1;
+
+	for( xIn = 0; xIn < xLength; xIn++ )
+	{
+		if( pucData[ xIn ] == 0U )
+		{
+			pucEncoded[ xCode ] = ucRun;
+			xCode = xOut++;
+			ucRun = 1;
+		}
+		else
+		{
+			pucEncoded[ xOut++ ] = pucData[ xIn ];
+			if( ++ucRun == 0xFFU )
+			{
+				pucEncoded[ xCode ] = ucRun;
+				xCode = xOut++;
+				ucRun = 1;
+			}
+		}
+	}
+	pucEncoded[ xCode ] = ucRun;
+
+	return xOut;
+}
+/*-----------------------------------------------------------*/
+
+/* Returns the decoded length, or -1 if the encoding is broken. */
+static int prvCobsDecode( const uint8_t *pucEncoded, size_t xLength, uint8_t *pucDecoded )
+{
+size_t xIn = 0, xOut = 0, x;
+uint8_t ucCode;
+
+	while( xIn < xLength )
+	{
+		ucCode = pucEncoded[ xIn++ ];
+		if( ( ucCode == 0U ) || ( ( xIn + ucCode - 1U ) > xLength ) )
+		{
+			return -1;
+		}
+		for( x = 1; x < ucCode; x++ )
+		{
+			pucDecoded[ xOut++ ] = pucEncoded[ xIn++ ];
+		}
+		if( ( ucCode != 0xFFU ) && ( xIn < xLength ) )
+		{
+			pucDecoded[ xOut++ ] = 0U;
+		}
+	}
+
+	return ( int ) xOut;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Checks a telemetry frame and, if it is the response to usId, copies it to
+ * pxResponse and returns 1.
+ */
+static int prvFrame( Client_t *pxClient, uint16_t usId, uint8_t ucCommand, Response_t *pxResponse )
+{
+uint8_t ucFrame[ clientMAX_ENCODED ];
+int iLength;
+const uint8_t *pucPayload;
+
+	iLength = prvCobsDecode( pxClient->ucEncoded, pxClient->xEncoded, ucFrame );
+	if( ( iLength < telemetryFRAME_OVERHEAD ) || ( prvCrc( ucFrame, ( size_t ) iLength - 2U ) != ( uint16_t ) prvGetLittleEndian( &( ucFrame[ iLength - 2 ] ), 2 ) ) )
+	{
+		pxClient->ulBad++;
+		return 0;
+	}
+
+	pucPayload = &( ucFrame[ 3 ] );
+	iLength -= telemetryFRAME_OVERHEAD;
+	if( ( ucFrame[ 2 ] != telemetryFRAME_RESPONSE ) || ( iLength < commandRESPONSE_HEADER ) ||
+		( prvGetLittleEndian( pucPayload, 2 ) != usId ) || ( pucPayload[ 2 ] != ucCommand ) )
+	{
+		/* Samples, state changes, heartbeats and late responses. */
+		pxClient->ulSkipped++;
+		return 0;
+	}
+
+	pxResponse->ucStatus = pucPayload[ 3 ];
+	pxResponse->xLength = ( size_t ) iLength - commandRESPONSE_HEADER;
+	if( pxResponse->xLength > commandMAX_RESULT )
+	{
+		pxResponse->xLength = commandMAX_RESULT;
+	}
+	memcpy( pxResponse->ucResult, &( pucPayload[ commandRESPONSE_HEADER ] ), pxResponse->xLength );
+
+	return 1;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Reads frames until the response to usId arrives or the timeout passes.
+ * Returns 1 on a response, 0 on a timeout and -1 if the link failed.
+ */
+static int prvAwait( Client_t *pxClient, uint16_t usId, uint8_t ucCommand, uint64_t ullDeadline, Response_t *pxResponse )
+{
+struct pollfd xPoll;
+uint64_t ullNow;
+ssize_t xRead;
+uint8_t ucByte;
+int iReady;
+
+	xPoll.fd = pxClient->iFd;
+	xPoll.events = POLLIN;
+
+	for( ;; )
+	{
+		/* Bytes left from the last read come first, and any after the
+		response are kept for the next request. */
+		while( pxClient->xChunkUsed < pxClient->xChunk )
+		{
+			ucByte = pxClient->ucChunk[ pxClient->xChunkUsed++ ];
+			if( ucByte == 0U )
+			{
+				iReady = 0;
+				if( pxClient->iTooLong != 0 )
+				{
+					pxClient->ulBad++;
+				}
+				else if( pxClient->xEncoded > 0 )
+				{
+					iReady = prvFrame( pxClient, usId, ucCommand, pxResponse );
+				}
+				pxClient->xEncoded = 0;
+				pxClient->iTooLong = 0;
+				if( iReady != 0 )
+				{
+					return 1;
+				}
+			}
+			else if( pxClient->xEncoded < sizeof( pxClient->ucEncoded ) )
+			{
+				pxClient->ucEncoded[ pxClient->xEncoded++ ] = ucByte;
+			}
+			else
+			{
+				pxClient->iTooLong = 1;
+			}
+		}
+
+		ullNow = prvNowNs();
+		if( ullNow >= ullDeadline )
+		{
+			return 0;
+		}
+		iReady = poll( &xPoll, 1, ( int ) ( ( ullDeadline - ullNow + 999999ULL ) / 1000000ULL ) );
+		if( iReady < 0 )
+		{
+			if( errno == EINTR )
+			{
+				continue;
+			}
+			return -1;
+		}
+		if( iReady == 0 )
+		{
+			continue;
+		}
+
+		xRead = read( pxClient->iFd, pxClient->ucChunk, sizeof( pxClient->ucChunk ) );
+		if( xRead <= 0 )
+		{
+			if( ( xRead < 0 ) && ( ( errno == EINTR ) || ( errno == EAGAIN ) ) )
+			{
+				continue;
+			}
+			return -1;
+		}
+		pxClient->xChunk = ( size_t ) xRead;
+		pxClient->xChunkUsed = 0;
+	}
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Sends a request and waits for its response, retrying on a timeout.
+ * Returns 1 on a response and 0 if none came.
+ */
+static int prvRequest( Client_t *pxClient, uint8_t ucCommand, const uint8_t *pucArguments, size_t xLength, Response_t *pxResponse )
+{
+uint8_t ucFrame[ commandMAX_REQUEST ], ucEncoded[ commandMAX_ENCODED ];
+size_t xEncoded;
+uint16_t usId;
+uint64_t ullStart;
+int iAttempt, iResult;
+
+	for( iAttempt = 0; iAttempt <= pxClient->iRetries; iAttempt++ )
+	{
+		usId = pxClient->usNextId++;
+		prvPutLittleEndian( ucFrame, usId, 2 );
+		ucFrame[ 2 ] = ucCommand;
+		if( xLength > 0 )
+		{
+			memcpy( &( ucFrame[ 3 ] ), pucArguments, xLength );
+		}
+		prvPutLittleEndian( &( ucFrame[ 3 + xLength ] ), prvCrc( ucFrame, 3 + xLength ), 2 );
+		xEncoded = prvCobsEncode( ucFrame, xLength + commandREQUEST_OVERHEAD, ucEncoded );
+		ucEncoded[ xEncoded++ ] = 0U;
+
+		ullStart = prvNowNs();
+		if( write( pxClient->iFd, ucEncoded, xEncoded ) != ( ssize_t ) xEncoded )
+		{
+			perror( "command_client: write" );
+			return 0;
+		}
+
+		iResult = prvAwait( pxClient, usId, ucCommand, ullStart + ( uint64_t ) pxClient->iTimeoutMs * 1000000ULL, pxResponse );
+		if( iResult > 0 )
+		{
+			pxResponse->ullRoundTripNs = prvNowNs() - ullStart;
+			return 1;
+		}
+		if( iResult < 0 )
+		{
+			fprintf( stderr, "command_client: link closed\n" );
+			return 0;
+		}
+		pxClient->ulTimeouts++;
+	}
+
+	fprintf( stderr, "command_client: no response after %d attempts\n", pxClient->iRetries + 1 );
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+/* Prints the status unless it is OK, and returns 1 if it is. */
+static int prvStatusOk( const char *pcCommand, const Response_t *pxResponse )
+{
+	if( pxResponse->ucStatus == commandSTATUS_OK )
+	{
+		return 1;
+	}
+
+	printf( "%s: %s\n", pcCommand, ( pxResponse->ucStatus < ( sizeof( pcStatusNames ) / sizeof( pcStatusNames[ 0 ] ) ) ) ? pcStatusNames[ pxResponse->ucStatus ] : "unknown status" );
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+static int prvCompare( const void *pvA, const void *pvB )
+{
+uint64_t ullA = *( const uint64_t * ) pvA, ullB = *( const uint64_t * ) pvB;
+
+	return ( ullA > ullB ) - ( ullA < ullB );
+}
+/*-----------------------------------------------------------*/
+
+static int prvPing( Client_t *pxClient, long lCount )
+{
+static uint64_t ullTimes[ clientMAX_PINGS ];
+uint8_t ucArguments[ 8 ];
+Response_t xResponse;
+uint64_t ullTotal = 0;
+long l;
+
+	if( ( lCount < 1 ) || ( lCount > clientMAX_PINGS ) )
+	{
+		fprintf( stderr, "command_client: ping count must be 1 to %d\n", clientMAX_PINGS );
+		return 0;
+	}
+
+	for( l = 0; l < lCount; l++ )
+	{
+		prvPutLittleEndian( ucArguments, ( uint32_t ) l, 4 );
+		prvPutLittleEndian( &( ucArguments[ 4 ] ), ~( uint32_t ) l, 4 );
+		if( prvRequest( pxClient, commandCOMMAND_PING, ucArguments, sizeof( ucArguments ), &xResponse ) == 0 )
+		{
+			return 0;
+		}
+		if( ( prvStatusOk( "ping", &xResponse ) == 0 ) || ( xResponse.xLength != sizeof( ucArguments ) ) ||
+			( memcmp( xResponse.ucResult, ucArguments, sizeof( ucArguments ) ) != 0 ) )
+		{
+			fprintf( stderr, "command_client: ping %ld was not echoed\n", l );
+			return 0;
+		}
+		ullTimes[ l ] = xResponse.ullRoundTripNs;
+		ullTotal += xResponse.ullRoundTripNs;
+	}
+
+	qsort( ullTimes, ( size_t ) lCount, sizeof( ullTimes[ 0 ] ), prvCompare );
+	printf( "ping: %ld round trips, us min %.1f  avg %.1f  p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n", lCount,
+			ullTimes[ 0 ] / 1e3, ( double ) ullTotal / ( double ) lCount / 1e3, ullTimes[ ( lCount * 50 ) / 100 ] / 1e3,
+			ullTimes[ ( lCount * 90 ) / 100 ] / 1e3, ullTimes[ ( lCount * 99 ) / 100 ] / 1e3, ullTimes[ lCount - 1 ] / 1e3 );
+
+	return 1;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPrintThresholds( const char *pcCommand, const Response_t *pxResponse )
+{
+uint32_t ulFrequency, ulRoc;
+
+	if( ( prvStatusOk( pcCommand, pxResponse ) != 0 ) && ( pxResponse->xLength >= 4 ) )
+	{
+		ulFrequency = prvGetLittleEndian( pxResponse->ucResult, 2 );
+		ulRoc = prvGetLittleEndian( &( pxResponse->ucResult[ 2 ] ), 2 );
+		printf( "%s: frequency threshold %lu.%lu Hz, RoC threshold %lu.%lu Hz/s\n", pcCommand,
+				( unsigned long ) ( ulFrequency / 10U ), ( unsigned long ) ( ulFrequency % 10U ), ( unsigned long ) ( ulRoc / 10U ), ( unsigned long ) ( ulRoc % 10U ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvPrintStats( const Response_t *pxResponse )
+{
+const uint8_t *pucResult = pxResponse->ucResult;
+unsigned u, uHeld;
+
+	if( ( prvStatusOk( "stats", pxResponse ) == 0 ) || ( pxResponse->xLength < commandSTATS_SIZE ) )
+	{
+		return;
+	}
+
+	printf( "stats: state %s, loads 0x%02X, maintenance %s, uptime %lu ticks\n",
+			( pucResult[ commandSTATS_STATE ] < 3U ) ? pcStateNames[ pucResult[ commandSTATS_STATE ] ] : "?",
+			pucResult[ commandSTATS_LOADS ], ( pucResult[ commandSTATS_MAINTENANCE ] != 0U ) ? "requested" : "off",
+			( unsigned long ) prvGetLittleEndian( &( pucResult[ commandSTATS_UPTIME ] ), 4 ) );
+	printf( "  %lu loads shed on a trip, reaction ms min %lu  avg %lu  max %lu, last",
+			( unsigned long ) prvGetLittleEndian( &( pucResult[ commandSTATS_REACTION_COUNT ] ), 4 ),
+			( unsigned long ) prvGetLittleEndian( &( pucResult[ commandSTATS_REACTION_MIN ] ), 4 ),
+			( unsigned long ) prvGetLittleEndian( &( pucResult[ commandSTATS_REACTION_AVERAGE ] ), 4 ),
+			( unsigned long ) prvGetLittleEndian( &( pucResult[ commandSTATS_REACTION_MAX ] ), 4 ) );
+	uHeld = pucResult[ commandSTATS_REACTIONS_HELD ];
+	for( u = 0; ( u < uHeld ) && ( u < 5U ); u++ )
+	{
+		printf( " %lu", ( unsigned long ) prvGetLittleEndian( &( pucResult[ commandSTATS_REACTIONS + 2U * u ] ), 2 ) );
+	}
+	printf( "%s\n", ( uHeld == 0U ) ? " none" : "" );
+	printf( "  %lu telemetry frames dropped, %lu requests rejected\n",
+			( unsigned long ) prvGetLittleEndian( &( pucResult[ commandSTATS_TELEMETRY_DROPPED ] ), 4 ),
+			( unsigned long ) prvGetLittleEndian( &( pucResult[ commandSTATS_REJECTED ] ), 4 ) );
+}
+/*-----------------------------------------------------------*/
+
+/* Pages through the history, commandHISTORY_MAX_SAMPLES at a time. */
+static int prvHistory( Client_t *pxClient )
+{
+Response_t xResponse;
+uint8_t ucSkip = 0;
+unsigned u, uCount, uPrinted = 0;
+const uint8_t *pucSample;
+
+	for( ;; )
+	{
+		if( prvRequest( pxClient, commandCOMMAND_GET_HISTORY, &ucSkip, 1, &xResponse ) == 0 )
+		{
+			return 0;
+		}
+		if( ( prvStatusOk( "history", &xResponse ) == 0 ) || ( xResponse.xLength < commandHISTORY_HEADER ) )
+		{
+			return 1;
+		}
+		uCount = xResponse.ucResult[ 2 ];
+		if( xResponse.xLength < commandHISTORY_HEADER + ( uCount * commandHISTORY_SAMPLE_SIZE ) )
+		{
+			uCount = 0;
+		}
+		if( ucSkip == 0U )
+		{
+			printf( "history: %u samples held, newest first (Hz, Hz/s)\n", xResponse.ucResult[ 0 ] );
+		}
+		for( u = 0; u < uCount; u++ )
+		{
+			pucSample = &( xResponse.ucResult[ commandHISTORY_HEADER + ( u * commandHISTORY_SAMPLE_SIZE ) ] );
+			printf( "%s%7.2f %7.2f", ( ( uPrinted % 4U ) == 0U ) ? "  " : "   ",
+					prvGetLittleEndian( pucSample, 2 ) / 100.0, ( int16_t ) prvGetLittleEndian( &( pucSample[ 2 ] ), 2 ) / 100.0 );
+			if( ( ++uPrinted % 4U ) == 0U )
+			{
+				printf( "\n" );
+			}
+		}
+
+		/* The relay adds samples as this pages, so stop at the count it
+		held at the start or when it has no more. */
+		if( ( uCount == 0U ) || ( ( unsigned ) ucSkip + uCount >= xResponse.ucResult[ 0 ] ) )
+		{
+			break;
+		}
+		ucSkip = ( uint8_t ) ( ucSkip + uCount );
+	}
+	if( ( uPrinted % 4U ) != 0U )
+	{
+		printf( "\n" );
+	}
+
+	return 1;
+}
+/*-----------------------------------------------------------*/
+
+static speed_t prvSpeed( long lBaud )
+{
+	switch( lBaud )
+	{
+		case 9600 : return B9600;
+		case 19200 : return B19200;
+		case 38400 : return B38400;
+		case 57600 : return B57600;
+		case 115200 : return B115200;
+		case 230400 : return B230400;
+		case 460800 : return B460800;
+		case 921600 : return B921600;
+		default : return B0;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static int prvSetRaw( int iFd, long lBaud )
+{
+struct termios xTerm;
+
+	if( tcgetattr( iFd, &xTerm ) != 0 )
+	{
+		return -1;
+	}
+	cfmakeraw( &xTerm );
+	xTerm.c_cc[ VMIN ] = 1;
+	xTerm.c_cc[ VTIME ] = 0;
+	if( lBaud != 0 )
+	{
+		if( prvSpeed( lBaud ) == B0 )
+		{
+			fprintf( stderr, "command_client: unsupported baud rate %ld\n", lBaud );
+			return -1;
+		}
+		cfsetispeed( &xTerm, prvSpeed( lBaud ) );
+		cfsetospeed( &xTerm, prvSpeed( lBaud ) );
+	}
+
+	return tcsetattr( iFd, TCSANOW, &xTerm );
+}
+/*-----------------------------------------------------------*/
+
+static void prvUsage( void )
+{
+	fprintf( stderr, "usage: command_client [-b baud] [-t timeout_ms] [-r retries] [-d] device command...\n"
+					 "commands: ping [count], get, set <Hz> <Hz/s>, stats, history,\n"
+					 "          maintenance on|off|toggle, snapshot, profile\n" );
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc, char **argv )
+{
+const char *pcDevice = NULL, *pcCommand;
+Client_t xClient;
+Response_t xResponse;
+uint8_t ucArguments[ 4 ];
+long lBaud = 0, lCount, lFrequency, lRoc;
+int iArg, iOk = 1;
+static const uint8_t ucDelimiter = 0U;
+
+	memset( &xClient, 0, sizeof( xClient ) );
+	xClient.iTimeoutMs = 500;
+	xClient.iRetries = 2;
+	xClient.usNextId = ( uint16_t ) getpid();
+
+	for( iArg = 1; ( iArg < argc ) && ( pcDevice == NULL ); iArg++ )
+	{
+		if( ( strcmp( argv[ iArg ], "-b" ) == 0 ) && ( iArg + 1 < argc ) )
+		{
+			lBaud = strtol( argv[ ++iArg ], NULL, 10 );
+		}
+		else if( ( strcmp( argv[ iArg ], "-t" ) == 0 ) && ( iArg + 1 < argc ) )
+		{
+			xClient.iTimeoutMs = atoi( argv[ ++iArg ] );
+		}
+		else if( ( strcmp( argv[ iArg ], "-r" ) == 0 ) && ( iArg + 1 < argc ) )
+		{
+			xClient.iRetries = atoi( argv[ ++iArg ] );
+		}
+		else if( ( strcmp( argv[ iArg ], "-d" ) == 0 ) && ( iArg + 1 < argc ) )
+		{
+			pcDevice = argv[ ++iArg ];
+		}
+		else
+		{
+			pcDevice = argv[ iArg ];
+		}
+	}
+	if( ( pcDevice == NULL ) || ( iArg >= argc ) )
+	{
+		prvUsage();
+		return 1;
+	}
+
+	xClient.iFd = open( pcDevice, O_RDWR | O_NOCTTY );
+	if( xClient.iFd < 0 )
+	{
+		perror( pcDevice );
+		return 1;
+	}
+	if( ( isatty( xClient.iFd ) != 0 ) && ( prvSetRaw( xClient.iFd, lBaud ) != 0 ) )
+	{
+		fprintf( stderr, "command_client: can't set up %s\n", pcDevice );
+		return 1;
+	}
+
+	/* Ends anything left half sent on the link, so the first request is
+	parsed from its start. */
+	if( write( xClient.iFd, &ucDelimiter, 1 ) != 1 )
+	{
+		perror( "command_client: write" );
+		return 1;
+	}
+
+	while( ( iArg < argc ) && ( iOk != 0 ) )
+	{
+		pcCommand = argv[ iArg++ ];
+
+		if( strcmp( pcCommand, "ping" ) == 0 )
+		{
+			lCount = 1;
+			if( ( iArg < argc ) && ( argv[ iArg ][ 0 ] >= '0' ) && ( argv[ iArg ][ 0 ] <= '9' ) )
+			{
+				lCount = strtol( argv[ iArg++ ], NULL, 10 );
+			}
+			iOk = prvPing( &xClient, lCount );
+		}
+		else if( strcmp( pcCommand, "get" ) == 0 )
+		{
+			iOk = prvRequest( &xClient, commandCOMMAND_GET_THRESHOLDS, NULL, 0, &xResponse );
+			if( iOk != 0 )
+			{
+				prvPrintThresholds( "get", &xResponse );
+			}
+		}
+		else if( ( strcmp( pcCommand, "set" ) == 0 ) && ( iArg + 1 < argc ) )
+		{
+			/* Tenths, rounded.  Out of range values are sent as they are for
+			the relay to refuse. */
+			lFrequency = ( long ) ( ( strtod( argv[ iArg++ ], NULL ) * 10.0 ) + 0.5 );
+			lRoc = ( long ) ( ( strtod( argv[ iArg++ ], NULL ) * 10.0 ) + 0.5 );
+			prvPutLittleEndian( ucArguments, ( uint32_t ) ( ( lFrequency < 0 ) ? 0xFFFF : lFrequency ), 2 );
+			prvPutLittleEndian( &( ucArguments[ 2 ] ), ( uint32_t ) ( ( lRoc < 0 ) ? 0xFFFF : lRoc ), 2 );
+			iOk = prvRequest( &xClient, commandCOMMAND_SET_THRESHOLDS, ucArguments, 4, &xResponse );
+			if( iOk != 0 )
+			{
+				prvPrintThresholds( "set", &xResponse );
+			}
+		}
+		else if( strcmp( pcCommand, "stats" ) == 0 )
+		{
+			iOk = prvRequest( &xClient, commandCOMMAND_GET_STATS, NULL, 0, &xResponse );
+			if( iOk != 0 )
+			{
+				prvPrintStats( &xResponse );
+			}
+		}
+		else if( strcmp( pcCommand, "history" ) == 0 )
+		{
+			iOk = prvHistory( &xClient );
+		}
+		else if( ( strcmp( pcCommand, "maintenance" ) == 0 ) && ( iArg < argc ) )
+		{
+			pcCommand = argv[ iArg++ ];
+			if( strcmp( pcCommand, "on" ) == 0 )
+			{
+				ucArguments[ 0 ] = commandMAINTENANCE_ON;
+			}
+			else if( strcmp( pcCommand, "off" ) == 0 )
+			{
+				ucArguments[ 0 ] = commandMAINTENANCE_OFF;
+			}
+			else
+			{
+				ucArguments[ 0 ] = commandMAINTENANCE_TOGGLE;
+			}
+			iOk = prvRequest( &xClient, commandCOMMAND_SET_MAINTENANCE, ucArguments, 1, &xResponse );
+			if( ( iOk != 0 ) && ( prvStatusOk( "maintenance", &xResponse ) != 0 ) && ( xResponse.xLength >= 2 ) )
+			{
+				printf( "maintenance: %s, load manager in %s\n", ( xResponse.ucResult[ 0 ] != 0U ) ? "requested" : "off",
+						( xResponse.ucResult[ 1 ] < 3U ) ? pcStateNames[ xResponse.ucResult[ 1 ] ] : "?" );
+			}
+		}
+		else if( strcmp( pcCommand, "snapshot" ) == 0 )
+		{
+			iOk = prvRequest( &xClient, commandCOMMAND_SNAPSHOT, NULL, 0, &xResponse );
+			if( ( iOk != 0 ) && ( prvStatusOk( "snapshot", &xResponse ) != 0 ) )
+			{
+				printf( "snapshot: trace dump started\n" );
+			}
+		}
+		else if( strcmp( pcCommand, "profile" ) == 0 )
+		{
+			iOk = prvRequest( &xClient, commandCOMMAND_PROFILE, NULL, 0, &xResponse );
+			if( ( iOk != 0 ) && ( prvStatusOk( "profile", &xResponse ) != 0 ) )
+			{
+				printf( "profile: dump started on the JTAG UART\n" );
+			}
+		}
+		else
+		{
+			prvUsage();
+			iOk = 0;
+		}
+	}
+
+	printf( "command_client: %lu other frames skipped, %lu bad frames, %lu timeouts\n",
+			( unsigned long ) xClient.ulSkipped, ( unsigned long ) xClient.ulBad, ( unsigned long ) xClient.ulTimeouts );
+	close( xClient.iFd );
+
+	return ( iOk != 0 ) ? 0 : 1;
+}
@@ -0,0 +1,584 @@
+/*
+ * Decodes a relay event log (FreeRTOS/event_log.h) into a timeline and prints
+ * the load manager's reaction time figures.
+ *
+ *   event_decode [-q] [-c timeline.csv] [log]
+ *
+ * The log is either the raw bytes sent with EVENT_LOG_SERIAL, starting with
+ * the "RLOG" header, or the console text captured from the JTAG UART with
+ * nios2-terminal, in which only the EVENTS and E lines are read.  Each BOOT
+ * record starts a new run, so a capture across several resets can be passed
+ * in whole.  -q leaves out the timeline and prints only the summary; -c also
+ * writes one CSV row per record.
+ *
+ * The summary gives:
+ *  - reaction: the times the load manager reported, in its REACTION records,
+ *    from a sample breaking a threshold to the first load being shed;
+ *  - trip to shed: from the TRIP record to the SHED record after it, both
+ *    stamped on the board, for trips taken while in the normal state;
+ *  - maintenance: the times reported in MAINTENANCE_TIME records;
+ *  - the time spent in each state and the sheds and reconnects per load.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "event_log.h"
+
+#define decodeLINE_LENGTH	256
+#define decodeMAX_LOADS		8
+#define decodeMAX_STATES	3
+#define decodeREAD_CHUNK	4096
+
+typedef struct
+{
+	uint64_t ullTime;			/* Microseconds since the run's boot. */
+	uint32_t ulRun;
+	EventLogRecord_t xRecord;
+} DecodedEvent_t;
+
+/* Values kept so percentiles can be taken. */
+typedef struct
+{
+	uint64_t *pullValues;
+	size_t xCount;
+	size_t xSize;
+} Distribution_t;
+
+static const char * const pcEventNames[] =
+{
+	"boot", "sample", "trip", "stable", "shed", "reconnect", "manual off", "load switch",
+	"state", "stability expiry", "reaction", "maintenance time", "thresholds", "dropped"
+};
+#define decodeEVENT_NAME_COUNT	( sizeof( pcEventNames ) / sizeof( pcEventNames[ 0 ] ) )
+
+/* As Relay.c numbers them. */
+static const char * const pcStateNames[ decodeMAX_STATES ] =
+{
+	"normal", "load manage", "maintenance"
+};
+
+static DecodedEvent_t *pxEvents = NULL;
+static size_t xEvents = 0, xEventsSize = 0;
+
+/*-----------------------------------------------------------*/
+
+static const char *prvEventName( unsigned uEvent )
+{
+	return ( uEvent < decodeEVENT_NAME_COUNT ) ? pcEventNames[ uEvent ] : "unknown";
+}
+/*-----------------------------------------------------------*/
+
+static const char *prvStateName( unsigned uState )
+{
+	return ( uState < decodeMAX_STATES ) ? pcStateNames[ uState ] : "unknown";
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvGetLittleEndian( const uint8_t *pucBuffer, size_t xBytes )
+{
+uint32_t ulValue = 0;
+
+	while( xBytes-- > 0 )
+	{
+		ulValue = ( ulValue << 8 ) | pucBuffer[ xBytes ];
+	}
+
+	return ulValue;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * The inverse of vEventLogEncode().
+ */
+static void prvAddRecord( const uint8_t *pucBytes )
+{
+EventLogRecord_t *pxRecord;
+
+	if( xEvents == xEventsSize )
+	{
+		xEventsSize = ( xEventsSize == 0 ) ? 1024 : ( xEventsSize * 2 );
+		pxEvents = realloc( pxEvents, xEventsSize * sizeof( DecodedEvent_t ) );
+		if( pxEvents == NULL )
+		{
+			fprintf( stderr, "event_decode: out of memory\n" );
+			exit( 1 );
+		}
+	}
+
+	pxRecord = &( pxEvents[ xEvents++ ].xRecord );
+	pxRecord->ulTimeUs = prvGetLittleEndian( &( pucBytes[ 0 ] ), 4 );
+	pxRecord->ucEvent = pucBytes[ 4 ];
+	pxRecord->ucState = pucBytes[ 5 ];
+	pxRecord->ucLoads = pucBytes[ 6 ];
+	pxRecord->ucLoad = pucBytes[ 7 ];
+	pxRecord->usFrequency = ( uint16_t ) prvGetLittleEndian( &( pucBytes[ 8 ] ), 2 );
+	pxRecord->sRoc = ( int16_t ) prvGetLittleEndian( &( pucBytes[ 10 ] ), 2 );
+	pxRecord->ulValue = prvGetLittleEndian( &( pucBytes[ 12 ] ), 4 );
+}
+/*-----------------------------------------------------------*/
+
+static int prvCheckFormat( unsigned uVersion, unsigned uRecordSize )
+{
+	if( ( uVersion != eventlogVERSION ) || ( uRecordSize != eventlogRECORD_SIZE ) )
+	{
+		fprintf( stderr, "event_decode: unknown log version %u with %u byte records\n", uVersion, uRecordSize );
+		return 0;
+	}
+
+	return 1;
+}
+/*-----------------------------------------------------------*/
+
+static int prvReadBinary( const uint8_t *pucInput, size_t xLength )
+{
+size_t x;
+
+	if( prvCheckFormat( prvGetLittleEndian( &( pucInput[ 4 ] ), 2 ), prvGetLittleEndian( &( pucInput[ 6 ] ), 2 ) ) == 0 )
+	{
+		return 0;
+	}
+
+	for( x = eventlogHEADER_SIZE; ( x + eventlogRECORD_SIZE ) <= xLength; x += eventlogRECORD_SIZE )
+	{
+		prvAddRecord( &( pucInput[ x ] ) );
+	}
+
+	if( x != xLength )
+	{
+		fprintf( stderr, "event_decode: ignoring %lu bytes of a partial record at the end\n", ( unsigned long ) ( xLength - x ) );
+	}
+
+	return 1;
+}
+/*-----------------------------------------------------------*/
+
+static int prvReadText( char *pcInput )
+{
+char *pcLine, *pcNext;
+char cHex[ ( 2 * eventlogRECORD_SIZE ) + 1 ];
+uint8_t ucBytes[ eventlogRECORD_SIZE ];
+unsigned uVersion, uRecordSize, uByte;
+size_t x;
+
+	for( pcLine = pcInput; pcLine != NULL; pcLine = pcNext )
+	{
+		pcNext = strchr( pcLine, '\n' );
+		if( pcNext != NULL )
+		{
+			*( pcNext++ ) = '\0';
+		}
+
+		if( sscanf( pcLine, "EVENTS %u %u", &uVersion, &uRecordSize ) == 2 )
+		{
+			if( prvCheckFormat( uVersion, uRecordSize ) == 0 )
+			{
+				return 0;
+			}
+		}
+		else if( ( sscanf( pcLine, "E %32[0-9a-f]", cHex ) == 1 ) && ( strlen( cHex ) == ( 2 * eventlogRECORD_SIZE ) ) )
+		{
+			for( x = 0; x < eventlogRECORD_SIZE; x++ )
+			{
+				sscanf( &( cHex[ 2 * x ] ), "%2x", &uByte );
+				ucBytes[ x ] = ( uint8_t ) uByte;
+			}
+			prvAddRecord( ucBytes );
+		}
+	}
+
+	return 1;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Records carry the low word of the microsecond count, which wraps every 71
+ * minutes.  Each record is stamped after the one before it in the same run.
+ */
+static uint32_t prvUnwrapTimes( void )
+{
+uint64_t ullHigh = 0;
+uint32_t ulLast = 0, ulRun = 0;
+size_t x;
+
+	for( x = 0; x < xEvents; x++ )
+	{
+		if( pxEvents[ x ].xRecord.ucEvent == eventlogEVENT_BOOT )
+		{
+			ulRun++;
+			ullHigh = 0;
+		}
+		else if( pxEvents[ x ].xRecord.ulTimeUs < ulLast )
+		{
+			ullHigh += 1ULL << 32;
+		}
+
+		ulLast = pxEvents[ x ].xRecord.ulTimeUs;
+		pxEvents[ x ].ullTime = ullHigh | ulLast;
+		pxEvents[ x ].ulRun = ulRun;
+	}
+
+	return ulRun;
+}
+/*-----------------------------------------------------------*/
+
+static void prvDistributionAdd( Distribution_t *pxDistribution, uint64_t ullValue )
+{
+	if( pxDistribution->xCount == pxDistribution->xSize )
+	{
+		pxDistribution->xSize = ( pxDistribution->xSize == 0 ) ? 64 : ( pxDistribution->xSize * 2 );
+		pxDistribution->pullValues = realloc( pxDistribution->pullValues, pxDistribution->xSize * sizeof( uint64_t ) );
+		if( pxDistribution->pullValues == NULL )
+		{
+			fprintf( stderr, "event_decode: out of memory\n" );
+			exit( 1 );
+		}
+	}
+	pxDistribution->pullValues[ pxDistribution->xCount++ ] = ullValue;
+}
+/*-----------------------------------------------------------*/
+
+static int prvCompareValues( const void *pvA, const void *pvB )
+{
+uint64_t ullA = *( const uint64_t * ) pvA, ullB = *( const uint64_t * ) pvB;
+
+	return ( ullA > ullB ) - ( ullA < ullB );
+}
+/*-----------------------------------------------------------*/
+
+static void prvPrintDistribution( const char *pcLabel, Distribution_t *pxDistribution )
+{
+uint64_t ullTotal = 0;
+size_t x, xCount = pxDistribution->xCount;
+const uint64_t *pullSorted;
+
+	printf( "  %-22s", pcLabel );
+	if( xCount == 0 )
+	{
+		printf( " %6s\n", "-" );
+		return;
+	}
+
+	qsort( pxDistribution->pullValues, xCount, sizeof( uint64_t ), prvCompareValues );
+	pullSorted = pxDistribution->pullValues;
+	for( x = 0; x < xCount; x++ )
+	{
+		ullTotal += pullSorted[ x ];
+	}
+
+	/* Nearest rank percentiles. */
+	printf( " %6lu %9llu %9.1f %9llu %9llu %9llu %9llu\n", ( unsigned long ) xCount, ( unsigned long long ) pullSorted[ 0 ],
+			( double ) ullTotal / ( double ) xCount, ( unsigned long long ) pullSorted[ ( ( xCount * 50 ) + 99 ) / 100 - 1 ],
+			( unsigned long long ) pullSorted[ ( ( xCount * 90 ) + 99 ) / 100 - 1 ], ( unsigned long long ) pullSorted[ ( ( xCount * 99 ) + 99 ) / 100 - 1 ],
+			( unsigned long long ) pullSorted[ xCount - 1 ] );
+}
+/*-----------------------------------------------------------*/
+
+static void prvDescribe( const EventLogRecord_t *pxRecord, char *pcDetail, size_t xLength )
+{
+	switch( pxRecord->ucEvent )
+	{
+		case eventlogEVENT_SHED :
+		case eventlogEVENT_RECONNECT :
+			if( pxRecord->ucLoad == eventlogNO_LOAD )
+			{
+				snprintf( pcDetail, xLength, "no load to %s", ( pxRecord->ucEvent == eventlogEVENT_SHED ) ? "shed" : "reconnect" );
+			}
+			else
+			{
+				snprintf( pcDetail, xLength, "load %u", pxRecord->ucLoad );
+			}
+			break;
+
+		case eventlogEVENT_MANUAL_OFF :
+			snprintf( pcDetail, xLength, "load %u%s", pxRecord->ucLoad, pxRecord->ulValue ? "" : " (already shed)" );
+			break;
+
+		case eventlogEVENT_LOAD_SWITCH :
+			snprintf( pcDetail, xLength, "load %u %s", pxRecord->ucLoad, pxRecord->ulValue ? "on" : "off" );
+			break;
+
+		case eventlogEVENT_STATE :
+			snprintf( pcDetail, xLength, "from %s", prvStateName( pxRecord->ulValue ) );
+			break;
+
+		case eventlogEVENT_SAMPLE :
+		case eventlogEVENT_TRIP :
+		case eventlogEVENT_STABLE :
+			snprintf( pcDetail, xLength, "sample tick %lu", ( unsigned long ) pxRecord->ulValue );
+			break;
+
+		case eventlogEVENT_REACTION :
+		case eventlogEVENT_MAINTENANCE_TIME :
+			snprintf( pcDetail, xLength, "%lu ms", ( unsigned long ) pxRecord->ulValue );
+			break;
+
+		case eventlogEVENT_THRESHOLDS :
+			snprintf( pcDetail, xLength, "below %.1f Hz or beyond %.1f Hz/s", ( double ) ( pxRecord->ulValue >> 16 ) / 10.0,
+					( double ) ( pxRecord->ulValue & 0xFFFFUL ) / 10.0 );
+			break;
+
+		case eventlogEVENT_DROPPED :
+			snprintf( pcDetail, xLength, "%lu records lost", ( unsigned long ) pxRecord->ulValue );
+			break;
+
+		default :
+			pcDetail[ 0 ] = '\0';
+			break;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t *prvReadAll( FILE *pxIn, size_t *pxLength )
+{
+uint8_t *pucBuffer = NULL;
+size_t xSize = 0, xRead;
+
+	*pxLength = 0;
+	do
+	{
+		if( ( *pxLength + decodeREAD_CHUNK + 1 ) > xSize )
+		{
+			xSize = ( xSize == 0 ) ? ( decodeREAD_CHUNK * 4 ) : ( xSize * 2 );
+			pucBuffer = realloc( pucBuffer, xSize );
+			if( pucBuffer == NULL )
+			{
+				fprintf( stderr, "event_decode: out of memory\n" );
+				exit( 1 );
+			}
+		}
+		xRead = fread( &( pucBuffer[ *pxLength ] ), 1, decodeREAD_CHUNK, pxIn );
+		*pxLength += xRead;
+	} while( xRead > 0 );
+
+	/* So a text log can be walked as a string. */
+	pucBuffer[ *pxLength ] = '\0';
+
+	return pucBuffer;
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc, char **argv )
+{
+const char *pcInput = NULL, *pcCsv = NULL;
+FILE *pxIn, *pxCsv = NULL;
+uint8_t *pucInput;
+size_t xLength, x;
+int iArg, iQuiet = 0, iRead;
+uint32_t ulRuns, ulEventCounts[ decodeEVENT_NAME_COUNT ] = { 0 }, ulDropped = 0, ulShed[ decodeMAX_LOADS ] = { 0 }, ulReconnected[ decodeMAX_LOADS ] = { 0 };
+uint64_t ullStateTime[ decodeMAX_STATES ] = { 0 }, ullStateSince, ullRunStart, ullTripAt = 0, ullSpan = 0;
+unsigned uState = 0;
+int iTripPending = 0;
+Distribution_t xReaction = { NULL, 0, 0 }, xTripToShed = { NULL, 0, 0 }, xMaintenance = { NULL, 0, 0 };
+char cDetail[ decodeLINE_LENGTH ];
+
+	for( iArg = 1; iArg < argc; iArg++ )
+	{
+		if( ( strcmp( argv[ iArg ], "-c" ) == 0 ) && ( iArg + 1 < argc ) )
+		{
+			pcCsv = argv[ ++iArg ];
+		}
+		else if( strcmp( argv[ iArg ], "-q" ) == 0 )
+		{
+			iQuiet = 1;
+		}
+		else
+		{
+			pcInput = argv[ iArg ];
+		}
+	}
+
+	pxIn = ( pcInput != NULL ) ? fopen( pcInput, "rb" ) : stdin;
+	if( pxIn == NULL )
+	{
+		perror( pcInput );
+		return 1;
+	}
+	pucInput = prvReadAll( pxIn, &xLength );
+	if( pxIn != stdin )
+	{
+		fclose( pxIn );
+	}
+
+	if( ( xLength >= eventlogHEADER_SIZE ) && ( memcmp( pucInput, "RLOG", 4 ) == 0 ) )
+	{
+		iRead = prvReadBinary( pucInput, xLength );
+	}
+	else
+	{
+		iRead = prvReadText( ( char * ) pucInput );
+	}
+	free( pucInput );
+
+	if( iRead == 0 )
+	{
+		return 1;
+	}
+	if( xEvents == 0 )
+	{
+		fprintf( stderr, "event_decode: no event records found\n" );
+		return 1;
+	}
+
+	ulRuns = prvUnwrapTimes();
+	ullRunStart = pxEvents[ 0 ].ullTime;
+	ullStateSince = ullRunStart;
+
+	if( pcCsv != NULL )
+	{
+		pxCsv = fopen( pcCsv, "w" );
+		if( pxCsv == NULL )
+		{
+			perror( pcCsv );
+			return 1;
+		}
+		fprintf( pxCsv, "time_us,run,event,state,loads,load,frequency_hz,roc_hz_s,value\n" );
+	}
+
+	if( iQuiet == 0 )
+	{
+		printf( "%4s %14s  %-16s %-11s %5s %8s %9s  %s\n", "run", "time (ms)", "event", "state", "loads", "Hz", "Hz/s", "detail" );
+	}
+
+	for( x = 0; x < xEvents; x++ )
+	{
+		const DecodedEvent_t *pxEvent = &( pxEvents[ x ] );
+		const EventLogRecord_t *pxRecord = &( pxEvent->xRecord );
+		double dFrequency = ( double ) pxRecord->usFrequency / eventlogFIXED_POINT_SCALE;
+		double dRoc = ( double ) pxRecord->sRoc / eventlogFIXED_POINT_SCALE;
+
+		if( pxRecord->ucEvent < decodeEVENT_NAME_COUNT )
+		{
+			ulEventCounts[ pxRecord->ucEvent ]++;
+		}
+
+		/* Close the state the last run ended in before starting another. */
+		if( pxRecord->ucEvent == eventlogEVENT_BOOT )
+		{
+			if( x > 0 )
+			{
+				ullStateTime[ uState ] += pxEvents[ x - 1 ].ullTime - ullStateSince;
+				ullSpan += pxEvents[ x - 1 ].ullTime - ullRunStart;
+			}
+			ullRunStart = pxEvent->ullTime;
+			uState = ( pxRecord->ucState < decodeMAX_STATES ) ? pxRecord->ucState : 0;
+			ullStateSince = pxEvent->ullTime;
+			iTripPending = 0;
+		}
+
+		switch( pxRecord->ucEvent )
+		{
+			case eventlogEVENT_TRIP :
+				if( pxRecord->ucState == 0 )
+				{
+					ullTripAt = pxEvent->ullTime;
+					iTripPending = 1;
+				}
+				break;
+
+			case eventlogEVENT_SHED :
+				if( pxRecord->ucLoad < decodeMAX_LOADS )
+				{
+					ulShed[ pxRecord->ucLoad ]++;
+				}
+				if( iTripPending != 0 )
+				{
+					prvDistributionAdd( &xTripToShed, pxEvent->ullTime - ullTripAt );
+					iTripPending = 0;
+				}
+				break;
+
+			case eventlogEVENT_RECONNECT :
+				if( pxRecord->ucLoad < decodeMAX_LOADS )
+				{
+					ulReconnected[ pxRecord->ucLoad ]++;
+				}
+				break;
+
+			case eventlogEVENT_STATE :
+				ullStateTime[ uState ] += pxEvent->ullTime - ullStateSince;
+				uState = ( pxRecord->ucState < decodeMAX_STATES ) ? pxRecord->ucState : 0;
+				ullStateSince = pxEvent->ullTime;
+				break;
+
+			case eventlogEVENT_REACTION :
+				prvDistributionAdd( &xReaction, pxRecord->ulValue );
+				break;
+
+			case eventlogEVENT_MAINTENANCE_TIME :
+				prvDistributionAdd( &xMaintenance, pxRecord->ulValue );
+				break;
+
+			case eventlogEVENT_DROPPED :
+				ulDropped += pxRecord->ulValue;
+				break;
+
+			default :
+				break;
+		}
+
+		if( iQuiet == 0 )
+		{
+			prvDescribe( pxRecord, cDetail, sizeof( cDetail ) );
+			printf( "%4lu %14.3f  %-16s %-11s %02x    %8.2f %9.2f  %s\n", ( unsigned long ) pxEvent->ulRun, ( double ) pxEvent->ullTime / 1000.0,
+					prvEventName( pxRecord->ucEvent ), prvStateName( pxRecord->ucState ), pxRecord->ucLoads, dFrequency, dRoc, cDetail );
+		}
+
+		if( pxCsv != NULL )
+		{
+			fprintf( pxCsv, "%llu,%lu,%s,%s,%u,%d,%.2f,%.2f,%lu\n", ( unsigned long long ) pxEvent->ullTime, ( unsigned long ) pxEvent->ulRun,
+					prvEventName( pxRecord->ucEvent ), prvStateName( pxRecord->ucState ), pxRecord->ucLoads,
+					( pxRecord->ucLoad == eventlogNO_LOAD ) ? -1 : ( int ) pxRecord->ucLoad, dFrequency, dRoc, ( unsigned long ) pxRecord->ulValue );
+		}
+	}
+
+	ullStateTime[ uState ] += pxEvents[ xEvents - 1 ].ullTime - ullStateSince;
+	ullSpan += pxEvents[ xEvents - 1 ].ullTime - ullRunStart;
+
+	if( pxCsv != NULL )
+	{
+		fclose( pxCsv );
+	}
+
+	printf( "%lu records in %lu run%s over %.3f s, %lu records lost\n", ( unsigned long ) xEvents, ( unsigned long ) ulRuns,
+			( ulRuns == 1 ) ? "" : "s", ( double ) ullSpan / 1000000.0, ( unsigned long ) ulDropped );
+
+	printf( "  %-22s %6s\n", "event", "n" );
+	for( x = 0; x < decodeEVENT_NAME_COUNT; x++ )
+	{
+		if( ulEventCounts[ x ] != 0 )
+		{
+			printf( "  %-22s %6lu\n", pcEventNames[ x ], ( unsigned long ) ulEventCounts[ x ] );
+		}
+	}
+
+	printf( "  %-22s %6s %9s %9s %9s %9s %9s %9s\n", "", "n", "min", "avg", "p50", "p90", "p99", "max" );
+	prvPrintDistribution( "reaction (ms)", &xReaction );
+	prvPrintDistribution( "trip to shed (us)", &xTripToShed );
+	prvPrintDistribution( "maintenance (ms)", &xMaintenance );
+
+	printf( "  %-22s", "time in state (ms)" );
+	for( x = 0; x < decodeMAX_STATES; x++ )
+	{
+		printf( "  %s %.1f", pcStateNames[ x ], ( double ) ullStateTime[ x ] / 1000.0 );
+	}
+	printf( "\n" );
+
+	printf( "  %-22s", "shed / reconnected" );
+	for( x = 0; x < decodeMAX_LOADS; x++ )
+	{
+		if( ( ulShed[ x ] != 0 ) || ( ulReconnected[ x ] != 0 ) )
+		{
+			printf( "  load %lu %lu/%lu", ( unsigned long ) x, ( unsigned long ) ulShed[ x ], ( unsigned long ) ulReconnected[ x ] );
+		}
+	}
+	printf( "\n" );
+
+	free( xReaction.pullValues );
+	free( xTripToShed.pullValues );
+	free( xMaintenance.pullValues );
+	free( pxEvents );
+
+	return 0;
+}
@@ -0,0 +1,437 @@
+/*
+ * Turns a dump of the PC sampling profiler (FreeRTOS/profiler.h) into folded
+ * stacks, one line per task and function with its sample count, as read by
+ * flamegraph.pl, speedscope and the like, and prints where each task spent
+ * its samples.
+ *
+ *   profile_fold [-s symbols] [-t task] [-o dir] [dump]
+ *
+ * The dump is the console text captured from the JTAG UART with
+ * nios2-terminal, or the file host/bench/profiler_sim writes.  Only the lines
+ * from PROFILE to END are read, so a whole capture can be passed in, and the
+ * samples of every dump in it are added together; the relay clears the
+ * profiler after each dump, so each holds only the samples since the last.
+ *
+ * -s is the output of nm -n on the image that was profiled, from
+ * nios2-elf-nm for the board.  Each PC is counted against the nearest text
+ * symbol at or below it.  Without it, or for a PC below every symbol, the PC
+ * itself is used.  A sample taken inside an interrupt handler is folded as
+ * task;[irq N];handler, under the task it interrupted.
+ *
+ * The folded stacks go to standard output, or with -o to one file per task,
+ * dir/<task>.folded, with the summary on standard output.  -t keeps only the
+ * named task.  Sampling is on the tick, so a function that only ever runs
+ * between two ticks is not seen; see profiler.h.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#include "profiler.h"
+
+#define foldLINE_LENGTH		512
+#define foldNAME_LENGTH		128
+#define foldMAX_TASKS		256
+#define foldTOP_FUNCTIONS	5
+
+typedef struct
+{
+	unsigned long ulAddress;
+	char *pcName;
+} Symbol_t;
+
+/* One task, interrupt and function, with its samples. */
+typedef struct
+{
+	unsigned uTask;
+	unsigned uInterrupt;
+	char cFunction[ foldNAME_LENGTH ];
+	unsigned long ulCount;
+} Folded_t;
+
+static Symbol_t *pxSymbols = NULL;
+static size_t xSymbols = 0, xSymbolsSize = 0;
+
+static Folded_t *pxFolded = NULL;
+static size_t xFolded = 0, xFoldedSize = 0;
+
+static char cTaskNames[ foldMAX_TASKS ][ foldNAME_LENGTH ];
+static unsigned long ulTaskSamples[ foldMAX_TASKS ];
+
+/*-----------------------------------------------------------*/
+
+static void *prvGrow( void *pvArray, size_t *pxSize, size_t xElement )
+{
+	*pxSize = ( *pxSize == 0 ) ? 256 : ( *pxSize * 2 );
+	pvArray = realloc( pvArray, *pxSize * xElement );
+	if( pvArray == NULL )
+	{
+		fprintf( stderr, "profile_fold: out of memory\n" );
+		exit( 1 );
+	}
+
+	return pvArray;
+}
+/*-----------------------------------------------------------*/
+
+static int prvCompareSymbols( const void *pvA, const void *pvB )
+{
+const Symbol_t *pxA = pvA, *pxB = pvB;
+
+	return ( pxA->ulAddress > pxB->ulAddress ) - ( pxA->ulAddress < pxB->ulAddress );
+}
+/*-----------------------------------------------------------*/
+
+static int prvReadSymbols( const char *pcPath )
+{
+FILE *pxFile = fopen( pcPath, "r" );
+char cLine[ foldLINE_LENGTH ], cName[ foldLINE_LENGTH ];
+unsigned long ulAddress;
+char cType;
+
+	if( pxFile == NULL )
+	{
+		perror( pcPath );
+		return 0;
+	}
+
+	while( fgets( cLine, sizeof( cLine ), pxFile ) != NULL )
+	{
+		/* Only code: global and local text and weak symbols. */
+		if( ( sscanf( cLine, "%lx %c %511s", &ulAddress, &cType, cName ) != 3 ) || ( strchr( "TtWw", cType ) == NULL ) )
+		{
+			continue;
+		}
+
+		if( xSymbols == xSymbolsSize )
+		{
+			pxSymbols = prvGrow( pxSymbols, &xSymbolsSize, sizeof( Symbol_t ) );
+		}
+		pxSymbols[ xSymbols ].ulAddress = ulAddress;
+		pxSymbols[ xSymbols ].pcName = strdup( cName );
+		xSymbols++;
+	}
+	fclose( pxFile );
+
+	/* nm -n sorts them already, but a plain nm does not. */
+	qsort( pxSymbols, xSymbols, sizeof( Symbol_t ), prvCompareSymbols );
+
+	return 1;
+}
+/*-----------------------------------------------------------*/
+
+/* The name of the function at ulPC, or the PC if no symbol is at or below
+it. */
+static void prvFunctionName( unsigned long ulPC, char *pcName )
+{
+size_t xLow = 0, xHigh = xSymbols;
+
+	/* The first symbol above ulPC. */
+	while( xLow < xHigh )
+	{
+		size_t xMiddle = xLow + ( ( xHigh - xLow ) / 2 );
+
+		if( pxSymbols[ xMiddle ].ulAddress <= ulPC )
+		{
+			xLow = xMiddle + 1;
+		}
+		else
+		{
+			xHigh = xMiddle;
+		}
+	}
+
+	if( xLow == 0 )
+	{
+		snprintf( pcName, foldNAME_LENGTH, "0x%08lx", ulPC );
+	}
+	else
+	{
+		snprintf( pcName, foldNAME_LENGTH, "%s", pxSymbols[ xLow - 1 ].pcName );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvAddSample( unsigned uTask, unsigned uInterrupt, const char *pcFunction, unsigned long ulCount )
+{
+size_t x;
+
+	for( x = 0; x < xFolded; x++ )
+	{
+		if( ( pxFolded[ x ].uTask == uTask ) && ( pxFolded[ x ].uInterrupt == uInterrupt ) && ( strcmp( pxFolded[ x ].cFunction, pcFunction ) == 0 ) )
+		{
+			pxFolded[ x ].ulCount += ulCount;
+			return;
+		}
+	}
+
+	if( xFolded == xFoldedSize )
+	{
+		pxFolded = prvGrow( pxFolded, &xFoldedSize, sizeof( Folded_t ) );
+	}
+	pxFolded[ xFolded ].uTask = uTask;
+	pxFolded[ xFolded ].uInterrupt = uInterrupt;
+	snprintf( pxFolded[ xFolded ].cFunction, foldNAME_LENGTH, "%s", pcFunction );
+	pxFolded[ xFolded ].ulCount = ulCount;
+	xFolded++;
+}
+/*-----------------------------------------------------------*/
+
+/* Reads every PROFILE to END block in the capture.  Returns the number of
+dumps read, or -1 for a dump of another version. */
+static int prvReadDumps( FILE *pxIn )
+{
+char cLine[ foldLINE_LENGTH ], cName[ foldNAME_LENGTH ], cFunction[ foldNAME_LENGTH ];
+unsigned uTask, uInterrupt, uVersion;
+unsigned long ulPC, ulCount, ulDropped;
+int iDumps = 0, iInDump = 0;
+char *pcChar;
+
+	while( fgets( cLine, sizeof( cLine ), pxIn ) != NULL )
+	{
+		if( iInDump == 0 )
+		{
+			/* The console may have put something before the PROFILE. */
+			pcChar = strstr( cLine, "PROFILE " );
+			if( pcChar == NULL )
+			{
+				continue;
+			}
+
+			if( ( sscanf( pcChar, "PROFILE %u %*u %*u %*u %lu", &uVersion, &ulDropped ) != 2 ) || ( uVersion != profilerDUMP_VERSION ) )
+			{
+				fprintf( stderr, "profile_fold: dump is not version %d\n", profilerDUMP_VERSION );
+				return -1;
+			}
+
+			if( ulDropped != 0 )
+			{
+				fprintf( stderr, "profile_fold: %lu samples were dropped, raise configPROFILER_BUCKETS\n", ulDropped );
+			}
+
+			iInDump = 1;
+			iDumps++;
+		}
+		else if( strncmp( cLine, "END", 3 ) == 0 )
+		{
+			iInDump = 0;
+		}
+		else if( ( sscanf( cLine, "T %u %127s", &uTask, cName ) == 2 ) && ( uTask < foldMAX_TASKS ) )
+		{
+			/* Semicolons separate the frames of a folded stack. */
+			for( pcChar = cName; *pcChar != '\0'; pcChar++ )
+			{
+				if( *pcChar == ';' )
+				{
+					*pcChar = '_';
+				}
+			}
+			strcpy( cTaskNames[ uTask ], cName );
+		}
+		else if( sscanf( cLine, "S %x %x %lx %lu", &uTask, &uInterrupt, &ulPC, &ulCount ) == 4 )
+		{
+			prvFunctionName( ulPC, cFunction );
+			prvAddSample( uTask, uInterrupt, cFunction, ulCount );
+		}
+	}
+
+	return iDumps;
+}
+/*-----------------------------------------------------------*/
+
+static const char *prvTaskName( unsigned uTask )
+{
+static char cNumber[ 16 ];
+
+	if( ( uTask < foldMAX_TASKS ) && ( cTaskNames[ uTask ][ 0 ] != '\0' ) )
+	{
+		return cTaskNames[ uTask ];
+	}
+
+	/* A task deleted before the dump has no T line. */
+	snprintf( cNumber, sizeof( cNumber ), "task%u", uTask );
+	return cNumber;
+}
+/*-----------------------------------------------------------*/
+
+static void prvWriteFolded( FILE *pxOut, const Folded_t *pxEntry )
+{
+	if( pxEntry->uInterrupt == profilerNO_INTERRUPT )
+	{
+		fprintf( pxOut, "%s;%s %lu\n", prvTaskName( pxEntry->uTask ), pxEntry->cFunction, pxEntry->ulCount );
+	}
+	else
+	{
+		fprintf( pxOut, "%s;[irq %u];%s %lu\n", prvTaskName( pxEntry->uTask ), pxEntry->uInterrupt, pxEntry->cFunction, pxEntry->ulCount );
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* Most samples first, then by task. */
+static int prvCompareFolded( const void *pvA, const void *pvB )
+{
+const Folded_t *pxA = pvA, *pxB = pvB;
+
+	if( pxA->uTask != pxB->uTask )
+	{
+		return ( pxA->uTask > pxB->uTask ) - ( pxA->uTask < pxB->uTask );
+	}
+
+	return ( pxA->ulCount < pxB->ulCount ) - ( pxA->ulCount > pxB->ulCount );
+}
+/*-----------------------------------------------------------*/
+
+static void prvUsage( void )
+{
+	fprintf( stderr, "usage: profile_fold [-s symbols] [-t task] [-o dir] [dump]\n" );
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc, char **argv )
+{
+const char *pcInput = NULL, *pcSymbols = NULL, *pcTask = NULL, *pcDirectory = NULL;
+char cPath[ foldLINE_LENGTH ];
+FILE *pxIn, *pxOut = stdout, *pxSummary = stderr;
+unsigned long ulTotal = 0;
+unsigned uTask, uShown;
+size_t x, xFirst;
+int iArg, iDumps;
+
+	for( iArg = 1; iArg < argc; iArg++ )
+	{
+		if( ( strcmp( argv[ iArg ], "-s" ) == 0 ) && ( iArg + 1 < argc ) )
+		{
+			pcSymbols = argv[ ++iArg ];
+		}
+		else if( ( strcmp( argv[ iArg ], "-t" ) == 0 ) && ( iArg + 1 < argc ) )
+		{
+			pcTask = argv[ ++iArg ];
+		}
+		else if( ( strcmp( argv[ iArg ], "-o" ) == 0 ) && ( iArg + 1 < argc ) )
+		{
+			pcDirectory = argv[ ++iArg ];
+		}
+		else if( ( argv[ iArg ][ 0 ] == '-' ) || ( pcInput != NULL ) )
+		{
+			prvUsage();
+			return 2;
+		}
+		else
+		{
+			pcInput = argv[ iArg ];
+		}
+	}
+
+	if( ( pcSymbols != NULL ) && ( prvReadSymbols( pcSymbols ) == 0 ) )
+	{
+		return 1;
+	}
+
+	pxIn = ( pcInput != NULL ) ? fopen( pcInput, "r" ) : stdin;
+	if( pxIn == NULL )
+	{
+		perror( pcInput );
+		return 1;
+	}
+	iDumps = prvReadDumps( pxIn );
+	if( pxIn != stdin )
+	{
+		fclose( pxIn );
+	}
+
+	if( iDumps < 0 )
+	{
+		return 1;
+	}
+	if( iDumps == 0 )
+	{
+		fprintf( stderr, "profile_fold: no PROFILE dump found\n" );
+		return 1;
+	}
+
+	/* Drop the tasks not asked for, so the percentages are of what is left. */
+	for( x = 0; x < xFolded; x++ )
+	{
+		if( ( pcTask != NULL ) && ( strcmp( prvTaskName( pxFolded[ x ].uTask ), pcTask ) != 0 ) )
+		{
+			pxFolded[ x-- ] = pxFolded[ --xFolded ];
+			continue;
+		}
+
+		ulTaskSamples[ pxFolded[ x ].uTask & ( foldMAX_TASKS - 1 ) ] += pxFolded[ x ].ulCount;
+		ulTotal += pxFolded[ x ].ulCount;
+	}
+
+	qsort( pxFolded, xFolded, sizeof( Folded_t ), prvCompareFolded );
+
+	if( pcDirectory != NULL )
+	{
+		if( ( mkdir( pcDirectory, 0777 ) != 0 ) && ( errno != EEXIST ) )
+		{
+			perror( pcDirectory );
+			return 1;
+		}
+		pxSummary = stdout;
+		pxOut = NULL;
+	}
+
+	for( x = 0; x < xFolded; x++ )
+	{
+		if( ( pcDirectory != NULL ) && ( ( x == 0 ) || ( pxFolded[ x ].uTask != pxFolded[ x - 1 ].uTask ) ) )
+		{
+			if( pxOut != NULL )
+			{
+				fclose( pxOut );
+			}
+
+			snprintf( cPath, sizeof( cPath ), "%s/%s.folded", pcDirectory, prvTaskName( pxFolded[ x ].uTask ) );
+			pxOut = fopen( cPath, "w" );
+			if( pxOut == NULL )
+			{
+				perror( cPath );
+				return 1;
+			}
+		}
+
+		prvWriteFolded( pxOut, &( pxFolded[ x ] ) );
+	}
+
+	if( ( pcDirectory != NULL ) && ( pxOut != NULL ) )
+	{
+		fclose( pxOut );
+	}
+
+	fprintf( pxSummary, "%lu samples from %d dump%s\n", ulTotal, iDumps, ( iDumps == 1 ) ? "" : "s" );
+
+	for( xFirst = 0; xFirst < xFolded; xFirst = x )
+	{
+		uTask = pxFolded[ xFirst ].uTask;
+		fprintf( pxSummary, "  %-16s %8lu %6.2f%%\n", prvTaskName( uTask ), ulTaskSamples[ uTask & ( foldMAX_TASKS - 1 ) ],
+				 100.0 * ( double ) ulTaskSamples[ uTask & ( foldMAX_TASKS - 1 ) ] / ( double ) ulTotal );
+
+		for( x = xFirst, uShown = 0; ( x < xFolded ) && ( pxFolded[ x ].uTask == uTask ); x++, uShown++ )
+		{
+			if( uShown >= foldTOP_FUNCTIONS )
+			{
+				continue;
+			}
+
+			if( pxFolded[ x ].uInterrupt == profilerNO_INTERRUPT )
+			{
+				fprintf( pxSummary, "    %-32s %8lu %6.2f%%\n", pxFolded[ x ].cFunction, pxFolded[ x ].ulCount,
+						 100.0 * ( double ) pxFolded[ x ].ulCount / ( double ) ulTotal );
+			}
+			else
+			{
+				snprintf( cPath, sizeof( cPath ), "[irq %u] %s", pxFolded[ x ].uInterrupt, pxFolded[ x ].cFunction );
+				fprintf( pxSummary, "    %-32s %8lu %6.2f%%\n", cPath, pxFolded[ x ].ulCount,
+						 100.0 * ( double ) pxFolded[ x ].ulCount / ( double ) ulTotal );
+			}
+		}
+	}
+
+	return 0;
+}
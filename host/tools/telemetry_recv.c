@@ -0,0 +1,444 @@
+/*
+ * Receives the relay telemetry stream (FreeRTOS/telemetry.h) and reports what
+ * arrived.
+ *
+ *   telemetry_recv [-c samples.csv] [-b baud] [device|file]
+ *
+ * The input is the serial UART, a capture of it, or the pseudo terminal that
+ * host/bench/telemetry_sim sends on.  A terminal is put into raw mode, at the
+ * given baud rate if -b is passed.  Frames are split at the zero bytes, COBS
+ * decoded and checked against their CRC, which is recomputed here bit by bit
+ * rather than with telemetry.c's table.  -c writes one CSV row per sample.
+ *
+ * Reading stops at an END frame or the end of the input.  The report gives:
+ *  - the frames received by type, and those that were cut short, failed to
+ *    decode or failed their CRC;
+ *  - frames lost, from the gaps in the sequence numbers, and the drop count
+ *    the sender gave in its last heartbeat, which should account for them;
+ *  - bytes per second over the span of the frames' own timestamps, on average
+ *    and in the busiest whole second, and over the wall clock time spent
+ *    reading.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <time.h>
+
+#include "telemetry.h"
+
+#define recvREAD_CHUNK		4096
+#define recvTYPES			( telemetryFRAME_RESPONSE + 1 )
+
+/* Room for a frame longer than any the sender builds, so one that lost its
+delimiter is seen as too long rather than overrunning. */
+#define recvMAX_ENCODED		( 4 * telemetryMAX_ENCODED )
+
+static const char * const pcTypeNames[ recvTYPES ] =
+{
+	"unknown", "sample", "state", "heartbeat", "end", "response"
+};
+
+typedef struct
+{
+	uint32_t ulFrames[ recvTYPES ];
+	uint32_t ulTooLong, ulBadCobs, ulTooShort, ulBadCrc;
+	uint64_t ullLost;
+	uint64_t ullBytes;
+	int iHaveSequence;
+	uint16_t usNextSequence;
+	int iHaveHeartbeat;
+	uint32_t ulSenderDropped, ulSenderBytes;
+	/* Frame timestamps, unwrapped, and the bytes received up to the last. */
+	int iHaveTime;
+	uint32_t ulLastTime;
+	uint64_t ullFirstTime, ullTime, ullBytesAtFirst, ullBytesAtLast;
+	/* Bytes in each whole second of stream time, the current and busiest. */
+	uint64_t ullSecond, ullSecondBytes, ullBusiestBytes;
+	int iEnded;
+} Receiver_t;
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNowNs( void )
+{
+struct timespec xNow;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvGetLittleEndian( const uint8_t *pucBuffer, size_t xBytes )
+{
+uint32_t ulValue = 0;
+size_t x;
+
+	for( x = 0; x < xBytes; x++ )
+	{
+		ulValue |= ( uint32_t ) pucBuffer[ x ] << ( 8U * x );
+	}
+
+	return ulValue;
+}
+/*-----------------------------------------------------------*/
+
+static uint16_t prvCrc( const uint8_t *pucData, size_t xLength )
+{
+uint16_t usCrc = telemetryCRC_INITIAL;
+int iBit;
+
+	while( xLength-- > 0 )
+	{
+		usCrc ^= ( uint16_t ) ( *pucData++ << 8 );
+		for( iBit = 0; iBit < 8; iBit++ )
+		{
+			usCrc = ( uint16_t ) ( ( usCrc & 0x8000U ) ? ( ( usCrc << 1 ) ^ 0x1021U ) : ( usCrc << 1 ) );
+		}
+	}
+
+	return usCrc;
+}
+/*-----------------------------------------------------------*/
+
+/* Returns the decoded length, or -1 if the encoding is broken. */
+static int prvCobsDecode( const uint8_t *pucEncoded, size_t xLength, uint8_t *pucDecoded )
+{
+size_t xIn = 0, xOut = 0, x;
+uint8_t ucCode;
+
+	while( xIn < xLength )
+	{
+		ucCode = pucEncoded[ xIn++ ];
+		if( ( ucCode == 0U ) || ( ( xIn + ucCode - 1U ) > xLength ) )
+		{
+			return -1;
+		}
+		for( x = 1; x < ucCode; x++ )
+		{
+			pucDecoded[ xOut++ ] = pucEncoded[ xIn++ ];
+		}
+		/* A block shorter than 254 bytes ended at a zero, unless it is the
+		last. */
+		if( ( ucCode != 0xFFU ) && ( xIn < xLength ) )
+		{
+			pucDecoded[ xOut++ ] = 0U;
+		}
+	}
+
+	return ( int ) xOut;
+}
+/*-----------------------------------------------------------*/
+
+static void prvStamp( Receiver_t *pxReceiver, uint32_t ulTime )
+{
+	if( pxReceiver->iHaveTime == 0 )
+	{
+		pxReceiver->iHaveTime = 1;
+		pxReceiver->ullFirstTime = ulTime;
+		pxReceiver->ullTime = ulTime;
+		pxReceiver->ullBytesAtFirst = pxReceiver->ullBytes;
+	}
+	else
+	{
+		/* The 32 bit microsecond count wraps every 71 minutes. */
+		pxReceiver->ullTime += ( uint32_t ) ( ulTime - pxReceiver->ulLastTime );
+	}
+	pxReceiver->ulLastTime = ulTime;
+
+	/* The bytes since the last stamped frame are counted in this one's
+	second. */
+	if( ( ( pxReceiver->ullTime - pxReceiver->ullFirstTime ) / 1000000ULL ) != pxReceiver->ullSecond )
+	{
+		pxReceiver->ullSecond = ( pxReceiver->ullTime - pxReceiver->ullFirstTime ) / 1000000ULL;
+		pxReceiver->ullSecondBytes = 0;
+	}
+	pxReceiver->ullSecondBytes += pxReceiver->ullBytes - pxReceiver->ullBytesAtLast;
+	if( pxReceiver->ullSecondBytes > pxReceiver->ullBusiestBytes )
+	{
+		pxReceiver->ullBusiestBytes = pxReceiver->ullSecondBytes;
+	}
+	pxReceiver->ullBytesAtLast = pxReceiver->ullBytes;
+}
+/*-----------------------------------------------------------*/
+
+static void prvFrame( Receiver_t *pxReceiver, const uint8_t *pucEncoded, size_t xLength, FILE *pxCsv )
+{
+uint8_t ucFrame[ recvMAX_ENCODED ];
+int iLength;
+uint16_t usSequence;
+uint8_t ucType;
+const uint8_t *pucPayload;
+size_t xPayload;
+
+	iLength = prvCobsDecode( pucEncoded, xLength, ucFrame );
+	if( iLength < 0 )
+	{
+		pxReceiver->ulBadCobs++;
+		return;
+	}
+	if( iLength < telemetryFRAME_OVERHEAD )
+	{
+		pxReceiver->ulTooShort++;
+		return;
+	}
+	if( prvCrc( ucFrame, ( size_t ) iLength - 2U ) != ( uint16_t ) prvGetLittleEndian( &( ucFrame[ iLength - 2 ] ), 2 ) )
+	{
+		pxReceiver->ulBadCrc++;
+		return;
+	}
+
+	usSequence = ( uint16_t ) prvGetLittleEndian( ucFrame, 2 );
+	ucType = ucFrame[ 2 ];
+	pucPayload = &( ucFrame[ 3 ] );
+	xPayload = ( size_t ) iLength - telemetryFRAME_OVERHEAD;
+
+	/* Every number skipped is a frame the sender dropped or the link lost. */
+	if( pxReceiver->iHaveSequence != 0 )
+	{
+		pxReceiver->ullLost += ( uint16_t ) ( usSequence - pxReceiver->usNextSequence );
+	}
+	pxReceiver->iHaveSequence = 1;
+	pxReceiver->usNextSequence = ( uint16_t ) ( usSequence + 1U );
+
+	pxReceiver->ulFrames[ ( ucType < recvTYPES ) ? ucType : 0 ]++;
+
+	switch( ucType )
+	{
+		case telemetryFRAME_SAMPLE :
+			if( xPayload >= 8 )
+			{
+				prvStamp( pxReceiver, prvGetLittleEndian( pucPayload, 4 ) );
+				if( pxCsv != NULL )
+				{
+					fprintf( pxCsv, "%llu,%u,%.2f,%.2f\n", ( unsigned long long ) ( pxReceiver->ullTime - pxReceiver->ullFirstTime ), ( unsigned ) usSequence,
+							prvGetLittleEndian( &( pucPayload[ 4 ] ), 2 ) / 100.0, ( int16_t ) prvGetLittleEndian( &( pucPayload[ 6 ] ), 2 ) / 100.0 );
+				}
+			}
+			break;
+
+		case telemetryFRAME_STATE :
+			if( xPayload >= 7 )
+			{
+				prvStamp( pxReceiver, prvGetLittleEndian( pucPayload, 4 ) );
+			}
+			break;
+
+		case telemetryFRAME_HEARTBEAT :
+			if( xPayload >= 12 )
+			{
+				prvStamp( pxReceiver, prvGetLittleEndian( pucPayload, 4 ) );
+				pxReceiver->iHaveHeartbeat = 1;
+				pxReceiver->ulSenderDropped = prvGetLittleEndian( &( pucPayload[ 4 ] ), 4 );
+				pxReceiver->ulSenderBytes = prvGetLittleEndian( &( pucPayload[ 8 ] ), 4 );
+			}
+			break;
+
+		case telemetryFRAME_END :
+			pxReceiver->iEnded = 1;
+			break;
+
+		default :
+			break;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static speed_t prvSpeed( long lBaud )
+{
+	switch( lBaud )
+	{
+		case 9600 : return B9600;
+		case 19200 : return B19200;
+		case 38400 : return B38400;
+		case 57600 : return B57600;
+		case 115200 : return B115200;
+		case 230400 : return B230400;
+		case 460800 : return B460800;
+		case 921600 : return B921600;
+		default : return B0;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static int prvSetRaw( int iFd, long lBaud )
+{
+struct termios xTerm;
+
+	if( tcgetattr( iFd, &xTerm ) != 0 )
+	{
+		return -1;
+	}
+	cfmakeraw( &xTerm );
+	xTerm.c_cc[ VMIN ] = 1;
+	xTerm.c_cc[ VTIME ] = 0;
+	if( lBaud != 0 )
+	{
+		if( prvSpeed( lBaud ) == B0 )
+		{
+			fprintf( stderr, "telemetry_recv: unsupported baud rate %ld\n", lBaud );
+			return -1;
+		}
+		cfsetispeed( &xTerm, prvSpeed( lBaud ) );
+		cfsetospeed( &xTerm, prvSpeed( lBaud ) );
+	}
+
+	return tcsetattr( iFd, TCSANOW, &xTerm );
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc, char **argv )
+{
+const char *pcInput = NULL, *pcCsv = NULL;
+FILE *pxCsv = NULL;
+int iArg, iFd = STDIN_FILENO;
+long lBaud = 0;
+ssize_t xRead, x;
+uint8_t ucChunk[ recvREAD_CHUNK ], ucEncoded[ recvMAX_ENCODED ];
+size_t xEncoded = 0;
+int iTooLong = 0;
+uint64_t ullWallStart = 0, ullWallEnd, ullLostUnexplained;
+double dSpan;
+Receiver_t xReceiver;
+unsigned u;
+
+	memset( &xReceiver, 0, sizeof( xReceiver ) );
+
+	for( iArg = 1; iArg < argc; iArg++ )
+	{
+		if( ( strcmp( argv[ iArg ], "-c" ) == 0 ) && ( iArg + 1 < argc ) )
+		{
+			pcCsv = argv[ ++iArg ];
+		}
+		else if( ( strcmp( argv[ iArg ], "-b" ) == 0 ) && ( iArg + 1 < argc ) )
+		{
+			lBaud = strtol( argv[ ++iArg ], NULL, 10 );
+		}
+		else
+		{
+			pcInput = argv[ iArg ];
+		}
+	}
+
+	if( pcInput != NULL )
+	{
+		iFd = open( pcInput, O_RDONLY | O_NOCTTY );
+		if( iFd < 0 )
+		{
+			perror( pcInput );
+			return 1;
+		}
+	}
+	if( ( isatty( iFd ) != 0 ) && ( prvSetRaw( iFd, lBaud ) != 0 ) )
+	{
+		fprintf( stderr, "telemetry_recv: can't set up %s\n", ( pcInput != NULL ) ? pcInput : "stdin" );
+		return 1;
+	}
+
+	if( pcCsv != NULL )
+	{
+		pxCsv = fopen( pcCsv, "w" );
+		if( pxCsv == NULL )
+		{
+			perror( pcCsv );
+			return 1;
+		}
+		fprintf( pxCsv, "time_us,sequence,frequency_hz,roc_hz_s\n" );
+	}
+
+	while( xReceiver.iEnded == 0 )
+	{
+		xRead = read( iFd, ucChunk, sizeof( ucChunk ) );
+		if( ( xRead < 0 ) && ( errno == EINTR ) )
+		{
+			continue;
+		}
+		/* A pseudo terminal reports EIO once the sending side has closed. */
+		if( xRead <= 0 )
+		{
+			break;
+		}
+		if( xReceiver.ullBytes == 0 )
+		{
+			ullWallStart = prvNowNs();
+		}
+
+		for( x = 0; ( x < xRead ) && ( xReceiver.iEnded == 0 ); x++ )
+		{
+			xReceiver.ullBytes++;
+			if( ucChunk[ x ] == 0U )
+			{
+				if( iTooLong != 0 )
+				{
+					xReceiver.ulTooLong++;
+				}
+				else if( xEncoded > 0 )
+				{
+					prvFrame( &xReceiver, ucEncoded, xEncoded, pxCsv );
+				}
+				xEncoded = 0;
+				iTooLong = 0;
+			}
+			else if( xEncoded < sizeof( ucEncoded ) )
+			{
+				ucEncoded[ xEncoded++ ] = ucChunk[ x ];
+			}
+			else
+			{
+				iTooLong = 1;
+			}
+		}
+	}
+	ullWallEnd = prvNowNs();
+
+	if( pxCsv != NULL )
+	{
+		fclose( pxCsv );
+	}
+	if( iFd != STDIN_FILENO )
+	{
+		close( iFd );
+	}
+
+	printf( "Telemetry: %llu bytes", ( unsigned long long ) xReceiver.ullBytes );
+	for( u = telemetryFRAME_SAMPLE; u < recvTYPES; u++ )
+	{
+		printf( ", %lu %s", ( unsigned long ) xReceiver.ulFrames[ u ], pcTypeNames[ u ] );
+	}
+	printf( "%s\n", ( xReceiver.iEnded != 0 ) ? "" : " (no end frame)" );
+	printf( "  bad frames: %lu failed CRC, %lu bad COBS, %lu too short, %lu too long, %lu unknown type\n",
+			( unsigned long ) xReceiver.ulBadCrc, ( unsigned long ) xReceiver.ulBadCobs, ( unsigned long ) xReceiver.ulTooShort,
+			( unsigned long ) xReceiver.ulTooLong, ( unsigned long ) xReceiver.ulFrames[ 0 ] );
+
+	printf( "  frames lost: %llu from sequence gaps", ( unsigned long long ) xReceiver.ullLost );
+	if( xReceiver.iHaveHeartbeat != 0 )
+	{
+		/* The sender counts only what it dropped, so anything over that was
+		lost on the link or before the first frame read. */
+		ullLostUnexplained = ( xReceiver.ullLost > xReceiver.ulSenderDropped ) ? ( xReceiver.ullLost - xReceiver.ulSenderDropped ) : 0;
+		printf( ", sender dropped %lu by its last heartbeat (%lu bytes queued), %llu lost on the link\n",
+				( unsigned long ) xReceiver.ulSenderDropped, ( unsigned long ) xReceiver.ulSenderBytes, ( unsigned long long ) ullLostUnexplained );
+	}
+	else
+	{
+		printf( ", no heartbeat received\n" );
+	}
+
+	if( ( xReceiver.iHaveTime != 0 ) && ( xReceiver.ullTime > xReceiver.ullFirstTime ) )
+	{
+		dSpan = ( double ) ( xReceiver.ullTime - xReceiver.ullFirstTime ) / 1e6;
+		printf( "  stream time: %.3f s, %.0f bytes/s on average, %llu in the busiest second\n", dSpan,
+				( double ) ( xReceiver.ullBytesAtLast - xReceiver.ullBytesAtFirst ) / dSpan, ( unsigned long long ) xReceiver.ullBusiestBytes );
+	}
+	if( ullWallEnd > ullWallStart )
+	{
+		printf( "  wall time:   %.3f s, %.0f bytes/s received\n", ( double ) ( ullWallEnd - ullWallStart ) / 1e9,
+				( double ) xReceiver.ullBytes * 1e9 / ( double ) ( ullWallEnd - ullWallStart ) );
+	}
+
+	return ( xReceiver.ullBytes > 0 ) ? 0 : 1;
+}
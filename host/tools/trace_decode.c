@@ -0,0 +1,375 @@
+/*
+ * Decodes a kernel trace dump (FreeRTOS/trace.h) into a Chrome trace JSON
+ * timeline and prints per task latency figures.
+ *
+ *   trace_decode [-o trace.json] [dump.txt]
+ *
+ * The dump is the text vTraceDump() prints, normally captured from the JTAG
+ * UART with nios2-terminal.  Anything outside the TRACE ... END block is
+ * ignored, so the whole console log can be passed in.  The JSON file opens in
+ * chrome://tracing or https://ui.perfetto.dev, with one row per task showing
+ * when it ran and the kernel events it caused, and one row per interrupt.
+ *
+ * For each task the summary gives:
+ *  - latency: from the task being made ready (a delay expiring, a queue or
+ *    notification unblocking it) to it running;
+ *  - period: between successive times it was made ready, which for a task in
+ *    a vTaskDelay() loop shows the jitter of its wake ups.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "trace.h"
+
+#define decodeMAX_TASKS		256
+#define decodeMAX_IRQS		32
+#define decodeISR_TID_BASE	1000
+#define decodeLINE_LENGTH	256
+
+typedef struct
+{
+	uint64_t ullTime;
+	uint8_t ucEvent;
+	uint8_t ucTask;
+	uint16_t usValue;
+	uint32_t ulObject;
+} DecodedRecord_t;
+
+typedef struct
+{
+	uint32_t ulCount;
+	uint64_t ullMin;
+	uint64_t ullMax;
+	uint64_t ullTotal;
+} Spread_t;
+
+typedef struct
+{
+	char cName[ 64 ];
+	unsigned uPriority;
+	int iSeen;
+	uint32_t ulSwitchIns;
+	uint64_t ullRunTime;
+	uint64_t ullReadyAt;		/* 0 when not waiting to run. */
+	uint64_t ullLastReady;
+	Spread_t xLatency;
+	Spread_t xPeriod;
+} DecodedTask_t;
+
+typedef struct
+{
+	int iSeen;
+	uint64_t ullEnteredAt;
+	Spread_t xDuration;
+} DecodedIrq_t;
+
+static const char * const pcEventNames[] =
+{
+	"time high", "task create", "switched in", "ready", "delay", "delay until", "suspend", "resume",
+	"delete", "queue send", "queue send failed", "queue send from ISR", "queue receive",
+	"queue receive failed", "queue receive from ISR", "queue peek", "block on queue send",
+	"block on queue receive", "notify", "notify from ISR", "notify give from ISR", "block on notify take",
+	"notify take", "block on notify wait", "notify wait", "timer command send", "timer command received",
+	"timer expired", "ISR enter", "ISR exit", "low power idle begin", "low power idle end"
+};
+#define decodeEVENT_NAME_COUNT	( sizeof( pcEventNames ) / sizeof( pcEventNames[ 0 ] ) )
+
+static DecodedTask_t xTasks[ decodeMAX_TASKS ];
+static DecodedIrq_t xIrqs[ decodeMAX_IRQS ];
+
+/*-----------------------------------------------------------*/
+
+static void prvSpreadAdd( Spread_t *pxSpread, uint64_t ullValue )
+{
+	if( ( pxSpread->ulCount == 0 ) || ( ullValue < pxSpread->ullMin ) )
+	{
+		pxSpread->ullMin = ullValue;
+	}
+	if( ullValue > pxSpread->ullMax )
+	{
+		pxSpread->ullMax = ullValue;
+	}
+	pxSpread->ullTotal += ullValue;
+	pxSpread->ulCount++;
+}
+/*-----------------------------------------------------------*/
+
+static double prvMicroseconds( uint64_t ullCounts, unsigned long ulHz )
+{
+	return ( ( double ) ullCounts * 1000000.0 ) / ( double ) ulHz;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPrintSpread( const Spread_t *pxSpread, unsigned long ulHz )
+{
+	if( pxSpread->ulCount == 0 )
+	{
+		printf( " %6s %10s %10s %10s", "-", "-", "-", "-" );
+	}
+	else
+	{
+		printf( " %6lu %10.1f %10.1f %10.1f", ( unsigned long ) pxSpread->ulCount, prvMicroseconds( pxSpread->ullMin, ulHz ),
+				prvMicroseconds( pxSpread->ullTotal / pxSpread->ulCount, ulHz ), prvMicroseconds( pxSpread->ullMax, ulHz ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static const char *prvTaskName( unsigned uTask )
+{
+static char cUnnamed[ 16 ];
+
+	if( ( uTask < decodeMAX_TASKS ) && ( xTasks[ uTask ].cName[ 0 ] != '\0' ) )
+	{
+		return xTasks[ uTask ].cName;
+	}
+
+	snprintf( cUnnamed, sizeof( cUnnamed ), "task %u", uTask );
+	return cUnnamed;
+}
+/*-----------------------------------------------------------*/
+
+static void prvWriteSpan( FILE *pxOut, int *piFirst, const char *pcName, unsigned uTid, uint64_t ullStart, uint64_t ullEnd, uint64_t ullOrigin, unsigned long ulHz )
+{
+	fprintf( pxOut, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", *piFirst ? "" : ",",
+			pcName, uTid, prvMicroseconds( ullStart - ullOrigin, ulHz ), prvMicroseconds( ullEnd - ullStart, ulHz ) );
+	*piFirst = 0;
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc, char **argv )
+{
+const char *pcInput = NULL, *pcOutput = "trace.json";
+FILE *pxIn, *pxOut;
+char cLine[ decodeLINE_LENGTH ], cName[ 64 ];
+int iArg, iInBlock = 0, iFirst = 1, iIrqDepth = 0, iActiveIrq[ decodeMAX_IRQS ];
+unsigned uVersion, uTask, uPriority, uEvent, uRecordTask, uValue, uTid, uRunning;
+unsigned long ulHz = 0, ulHigh = 0, ulCount = 0, ulLost = 0, ulTimestamp, ulObject;
+DecodedRecord_t *pxRecords = NULL;
+size_t xRecords = 0, x;
+uint64_t ullHigh, ullOrigin, ullRunningSince;
+
+	for( iArg = 1; iArg < argc; iArg++ )
+	{
+		if( ( strcmp( argv[ iArg ], "-o" ) == 0 ) && ( iArg + 1 < argc ) )
+		{
+			pcOutput = argv[ ++iArg ];
+		}
+		else
+		{
+			pcInput = argv[ iArg ];
+		}
+	}
+
+	pxIn = ( pcInput != NULL ) ? fopen( pcInput, "r" ) : stdin;
+	if( pxIn == NULL )
+	{
+		perror( pcInput );
+		return 1;
+	}
+
+	/* Read the last complete dump in the input. */
+	while( fgets( cLine, sizeof( cLine ), pxIn ) != NULL )
+	{
+		if( sscanf( cLine, "TRACE %u %lu %lu %lu %lu", &uVersion, &ulHz, &ulHigh, &ulCount, &ulLost ) == 5 )
+		{
+			if( uVersion != 1 )
+			{
+				fprintf( stderr, "trace_decode: unknown dump version %u\n", uVersion );
+				return 1;
+			}
+			free( pxRecords );
+			pxRecords = calloc( ulCount ? ulCount : 1, sizeof( DecodedRecord_t ) );
+			memset( xTasks, 0, sizeof( xTasks ) );
+			xRecords = 0;
+			iInBlock = 1;
+		}
+		else if( iInBlock == 0 )
+		{
+			continue;
+		}
+		else if( strncmp( cLine, "END", 3 ) == 0 )
+		{
+			iInBlock = 0;
+		}
+		else if( sscanf( cLine, "T %u %u %63s", &uTask, &uPriority, cName ) == 3 )
+		{
+			if( uTask < decodeMAX_TASKS )
+			{
+				snprintf( xTasks[ uTask ].cName, sizeof( xTasks[ uTask ].cName ), "%s", cName );
+				xTasks[ uTask ].uPriority = uPriority;
+			}
+		}
+		else if( sscanf( cLine, "R %lx %x %x %x %lx", &ulTimestamp, &uEvent, &uRecordTask, &uValue, &ulObject ) == 5 )
+		{
+			if( xRecords < ulCount )
+			{
+				pxRecords[ xRecords ].ullTime = ulTimestamp;
+				pxRecords[ xRecords ].ucEvent = ( uint8_t ) uEvent;
+				pxRecords[ xRecords ].ucTask = ( uint8_t ) uRecordTask;
+				pxRecords[ xRecords ].usValue = ( uint16_t ) uValue;
+				pxRecords[ xRecords ].ulObject = ( uint32_t ) ulObject;
+				xRecords++;
+			}
+		}
+	}
+
+	if( ( pxRecords == NULL ) || ( xRecords == 0 ) || ( ulHz == 0 ) )
+	{
+		fprintf( stderr, "trace_decode: no trace dump found\n" );
+		return 1;
+	}
+
+	/* Records carry the low word of the timestamp.  Work back from the high
+	word of the newest record, stepping down at each time high record. */
+	ullHigh = ulHigh;
+	for( x = xRecords; x-- > 0; )
+	{
+		pxRecords[ x ].ullTime |= ullHigh << 32;
+		if( pxRecords[ x ].ucEvent == traceEVENT_TIME_HIGH )
+		{
+			ullHigh = pxRecords[ x ].ulObject - ( ( pxRecords[ x ].ulObject - pxRecords[ x ].usValue ) & 0xFFFFUL );
+		}
+	}
+
+	pxOut = fopen( pcOutput, "w" );
+	if( pxOut == NULL )
+	{
+		perror( pcOutput );
+		return 1;
+	}
+
+	fprintf( pxOut, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" );
+
+	ullOrigin = pxRecords[ 0 ].ullTime;
+	uRunning = pxRecords[ 0 ].ucTask;
+	ullRunningSince = ullOrigin;
+
+	for( x = 0; x < xRecords; x++ )
+	{
+		const DecodedRecord_t *pxRecord = &( pxRecords[ x ] );
+		uint64_t ullNow = pxRecord->ullTime;
+
+		xTasks[ pxRecord->ucTask ].iSeen = 1;
+		uTid = ( iIrqDepth > 0 ) ? ( unsigned ) ( decodeISR_TID_BASE + iActiveIrq[ iIrqDepth - 1 ] ) : pxRecord->ucTask;
+
+		switch( pxRecord->ucEvent )
+		{
+			case traceEVENT_TIME_HIGH :
+				continue;
+
+			case traceEVENT_TASK_SWITCHED_IN :
+				uTask = ( unsigned ) ( pxRecord->ulObject % decodeMAX_TASKS );
+				if( uTask == uRunning )
+				{
+					continue;
+				}
+				prvWriteSpan( pxOut, &iFirst, prvTaskName( uRunning ), uRunning, ullRunningSince, ullNow, ullOrigin, ulHz );
+				xTasks[ uRunning ].ullRunTime += ullNow - ullRunningSince;
+				uRunning = uTask;
+				ullRunningSince = ullNow;
+				xTasks[ uTask ].iSeen = 1;
+				xTasks[ uTask ].ulSwitchIns++;
+				if( xTasks[ uTask ].ullReadyAt != 0 )
+				{
+					prvSpreadAdd( &( xTasks[ uTask ].xLatency ), ullNow - xTasks[ uTask ].ullReadyAt );
+					xTasks[ uTask ].ullReadyAt = 0;
+				}
+				continue;
+
+			case traceEVENT_TASK_READY :
+				uTask = ( unsigned ) ( pxRecord->ulObject % decodeMAX_TASKS );
+				xTasks[ uTask ].iSeen = 1;
+				if( xTasks[ uTask ].ullLastReady != 0 )
+				{
+					prvSpreadAdd( &( xTasks[ uTask ].xPeriod ), ullNow - xTasks[ uTask ].ullLastReady );
+				}
+				xTasks[ uTask ].ullLastReady = ullNow;
+				if( ( uTask != uRunning ) && ( xTasks[ uTask ].ullReadyAt == 0 ) )
+				{
+					xTasks[ uTask ].ullReadyAt = ullNow;
+				}
+				break;
+
+			case traceEVENT_ISR_ENTER :
+				if( ( pxRecord->ulObject < decodeMAX_IRQS ) && ( iIrqDepth < decodeMAX_IRQS ) )
+				{
+					xIrqs[ pxRecord->ulObject ].iSeen = 1;
+					xIrqs[ pxRecord->ulObject ].ullEnteredAt = ullNow;
+					iActiveIrq[ iIrqDepth++ ] = ( int ) pxRecord->ulObject;
+				}
+				continue;
+
+			case traceEVENT_ISR_EXIT :
+				if( ( pxRecord->ulObject < decodeMAX_IRQS ) && ( iIrqDepth > 0 ) && ( iActiveIrq[ iIrqDepth - 1 ] == ( int ) pxRecord->ulObject ) )
+				{
+					iIrqDepth--;
+					snprintf( cName, sizeof( cName ), "IRQ %lu", ( unsigned long ) pxRecord->ulObject );
+					prvWriteSpan( pxOut, &iFirst, cName, decodeISR_TID_BASE + ( unsigned ) pxRecord->ulObject,
+							xIrqs[ pxRecord->ulObject ].ullEnteredAt, ullNow, ullOrigin, ulHz );
+					prvSpreadAdd( &( xIrqs[ pxRecord->ulObject ].xDuration ), ullNow - xIrqs[ pxRecord->ulObject ].ullEnteredAt );
+				}
+				continue;
+
+			default :
+				break;
+		}
+
+		fprintf( pxOut, "%s\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"object\":\"0x%08lx\",\"value\":%u}}",
+				iFirst ? "" : ",", ( pxRecord->ucEvent < decodeEVENT_NAME_COUNT ) ? pcEventNames[ pxRecord->ucEvent ] : "unknown",
+				uTid, prvMicroseconds( ullNow - ullOrigin, ulHz ), ( unsigned long ) pxRecord->ulObject, ( unsigned ) pxRecord->usValue );
+		iFirst = 0;
+	}
+
+	/* Close the span of whatever was running at the end. */
+	prvWriteSpan( pxOut, &iFirst, prvTaskName( uRunning ), uRunning, ullRunningSince, pxRecords[ xRecords - 1 ].ullTime, ullOrigin, ulHz );
+	xTasks[ uRunning ].ullRunTime += pxRecords[ xRecords - 1 ].ullTime - ullRunningSince;
+
+	/* Row names. */
+	for( uTask = 0; uTask < decodeMAX_TASKS; uTask++ )
+	{
+		if( xTasks[ uTask ].iSeen )
+		{
+			fprintf( pxOut, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", uTask, prvTaskName( uTask ) );
+		}
+	}
+	for( uTask = 0; uTask < decodeMAX_IRQS; uTask++ )
+	{
+		if( xIrqs[ uTask ].iSeen )
+		{
+			fprintf( pxOut, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"IRQ %u\"}}", decodeISR_TID_BASE + uTask, uTask );
+		}
+	}
+	fprintf( pxOut, "\n]}\n" );
+	fclose( pxOut );
+
+	printf( "%lu records over %.1f ms (%lu lost before the oldest), timeline in %s\n", ( unsigned long ) xRecords,
+			prvMicroseconds( pxRecords[ xRecords - 1 ].ullTime - ullOrigin, ulHz ) / 1000.0, ulLost, pcOutput );
+	printf( "%-10s %4s %8s %6s | %-39s | %-39s\n", "", "", "run", "", "ready to running (us)", "made ready every (us)" );
+	printf( "%-10s %4s %8s %6s | %6s %10s %10s %10s | %6s %10s %10s %10s\n", "task", "prio", "ms", "%", "n", "min", "avg", "max", "n", "min", "avg", "max" );
+	for( uTask = 0; uTask < decodeMAX_TASKS; uTask++ )
+	{
+		if( xTasks[ uTask ].iSeen )
+		{
+			printf( "%-10s %4u %8.2f %6.1f |", prvTaskName( uTask ), xTasks[ uTask ].uPriority, prvMicroseconds( xTasks[ uTask ].ullRunTime, ulHz ) / 1000.0,
+					( 100.0 * ( double ) xTasks[ uTask ].ullRunTime ) / ( double ) ( pxRecords[ xRecords - 1 ].ullTime - ullOrigin + 1 ) );
+			prvPrintSpread( &( xTasks[ uTask ].xLatency ), ulHz );
+			printf( " |" );
+			prvPrintSpread( &( xTasks[ uTask ].xPeriod ), ulHz );
+			printf( "\n" );
+		}
+	}
+	for( uTask = 0; uTask < decodeMAX_IRQS; uTask++ )
+	{
+		if( xIrqs[ uTask ].iSeen )
+		{
+			printf( "IRQ %-6u %4s %8s %6s | handler (us)", uTask, "", "", "" );
+			prvPrintSpread( &( xIrqs[ uTask ].xDuration ), ulHz );
+			printf( "\n" );
+		}
+	}
+
+	free( pxRecords );
+	return 0;
+}